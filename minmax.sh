@@ -1,26 +1,23 @@
-SF=20
+# ./minmax.sh [SF], the scale factor also comes from $SF (default 20) and the data from $MORDRED_DATA_DIR
+# or s<SF>_columnar under $MORDRED_DATA_BASE (default test/ssb/data)
+SF=${1:-${SF:-20}}
+export MORDRED_DATA_BASE=${MORDRED_DATA_BASE:-$(pwd)/test/ssb/data}
 
-# Make sure encoder is using right scale factor
 bin=bin/gpudb/minmax
 binsort=bin/gpudb/minmaxsort
 
-LO_LEN=119994746
-P_LEN=1000000
-S_LEN=40000
-C_LEN=600000
-D_LEN=2556
-
-# LO_LEN=240012412
-# P_LEN=1200000
-# S_LEN=80000
-# C_LEN=1200000
-# D_LEN=2556
-
-# LO_LEN=960017453
-# P_LEN=1600000
-# S_LEN=320000
-# C_LEN=4800000
-# D_LEN=2556
+DATA_DIR=${MORDRED_DATA_DIR:-$MORDRED_DATA_BASE/s${SF}_columnar}
+
+# Table lengths come from the catalog written by the loader
+table_len() {
+ awk -v t=$1 '$1 == "table" && $2 == t {print $3}' $DATA_DIR/catalog
+}
+
+LO_LEN=$(table_len lineorder)
+P_LEN=$(table_len part)
+S_LEN=$(table_len supplier)
+C_LEN=$(table_len customer)
+D_LEN=$(table_len ddate)
 
 # arr=("lo_custkey" "lo_partkey" "lo_suppkey" "lo_orderdate" "lo_quantity" "lo_extendedprice" "lo_discount" "lo_revenue" "lo_supplycost" "lo_orderkey" "lo_linenumber" "lo_tax" "lo_ordtotalprice" "lo_commitdate")
 # for val in ${arr[*]}; do
@@ -5,34 +5,17 @@
 /*#include <cuda.h>*/
 /*#include <cub/util_allocator.cuh>*/
 
+#include "../../gpudb/Catalog.h"
+
 using namespace std;
 
-#define SF 10
-
-#define BASE_PATH "/home/ubuntu/Implementation-GPUDB/test/ssb/data/"
-
-#if SF == 1
-#define DATA_DIR BASE_PATH "s1_columnar/"
-#define LO_LEN 6001171
-#define P_LEN 200000
-#define S_LEN 2000
-#define C_LEN 30000
-#define D_LEN 2556
-#elif SF == 10
-#define DATA_DIR BASE_PATH "s10_columnar/"
-#define LO_LEN 59986214
-#define P_LEN 800000
-#define S_LEN 20000
-#define C_LEN 300000
-#define D_LEN 2556
-#else // 20
-#define DATA_DIR BASE_PATH "s20_columnar/"
-#define LO_LEN 119994746
-#define P_LEN 1000000
-#define S_LEN 40000
-#define C_LEN 600000
-#define D_LEN 2556
-#endif
+//data directory and table lengths come from the catalog of the data directory at startup
+#define DATA_DIR (catalog().data_dir)
+#define LO_LEN (catalog().lo_len)
+#define P_LEN (catalog().p_len)
+#define S_LEN (catalog().s_len)
+#define C_LEN (catalog().c_len)
+#define D_LEN (catalog().d_len)
 
 
 #define BATCH_SIZE 128
@@ -47,6 +30,9 @@ int index_of(string* arr, int len, string val) {
 }
 
 string lookup(string col_name) {
+  string file = catalogFile(col_name, false);
+  if (!file.empty()) return file;
+
   string lineorder[] = { "lo_orderkey", "lo_linenumber", "lo_custkey", "lo_partkey", "lo_suppkey", "lo_orderdate", "lo_orderpriority", "lo_shippriority", "lo_quantity", "lo_extendedprice", "lo_ordtotalprice", "lo_discount", "lo_revenue", "lo_supplycost", "lo_tax", "lo_commitdate", "lo_shipmode"};
   string part[] = {"p_partkey", "p_name", "p_mfgr", "p_category", "p_brand1", "p_color", "p_type", "p_size", "p_container"};
   string supplier[] = {"s_suppkey", "s_name", "s_address", "s_city", "s_nation", "s_region", "s_phone"};
@@ -15,8 +15,11 @@ CPUGPUProcessing::CPUGPUProcessing(size_t _cache_size, size_t _ondemand_size, si
   if (custom) qo = new QueryOptimizer(_cache_size, _ondemand_size, _processing_size, _pinned_memsize, this);
   else qo = new QueryOptimizer(_cache_size, _ondemand_size, 0, 0, this);
   cm = qo->cm;
+  scope = cm->query_scope;
+  shared_cm = false;
   begin_time = chrono::high_resolution_clock::now();
   col_idx = new int*[cm->TOT_COLUMN]();
+  pool_view = new int*[cm->TOT_COLUMN]();
   // od_col_idx = new int*[cm->TOT_COLUMN]();
   verbose = _verbose;
   cpu_time = new double[MAX_GROUPS];
@@ -30,6 +33,29 @@ CPUGPUProcessing::CPUGPUProcessing(size_t _cache_size, size_t _ondemand_size, si
   resetTime();
 }
 
+CPUGPUProcessing::CPUGPUProcessing(CPUGPUProcessing* shared) {
+  custom = shared->custom;
+  skipping = shared->skipping;
+  qo = new QueryOptimizer(shared->cm, this);
+  cm = shared->cm;
+  scope = new ProcessingScope(cm);
+  shared_cm = true;
+  cm->sessions++;
+  begin_time = shared->begin_time;
+  col_idx = new int*[cm->TOT_COLUMN]();
+  pool_view = new int*[cm->TOT_COLUMN]();
+  verbose = shared->verbose;
+  cpu_time = new double[MAX_GROUPS];
+  gpu_time = new double[MAX_GROUPS];
+  transfer_time = new double[MAX_GROUPS];
+  malloc_time = new double[MAX_GROUPS];
+
+  cpu_to_gpu = new unsigned long long[MAX_GROUPS];
+  gpu_to_cpu = new unsigned long long[MAX_GROUPS];
+
+  resetTime();
+}
+
 void
 CPUGPUProcessing::resetTime() {
   for (int sg = 0 ; sg < MAX_GROUPS; sg++) {
@@ -56,6 +82,90 @@ CPUGPUProcessing::resetTime() {
 
 }
 
+ColumnInfo*
+CPUGPUProcessing::columnOfIndex(int* idx) {
+  if (idx == NULL) return NULL;
+  for (int i = 0; i < cm->TOT_COLUMN; i++) {
+    if (col_idx[i] == idx) return cm->allColumn[i];
+  }
+  assert(0);
+  return NULL;
+}
+
+//the column behind a segment index, read through the emulated gpu cache. the view is mapped from the index
+//once per query and shared by its segment groups
+int*
+CPUGPUProcessing::poolOfIndex(int* idx) {
+  ColumnInfo* column = columnOfIndex(idx);
+  if (column == NULL) return NULL;
+  lock_guard<mutex> lock(pool_view_lock);
+  if (pool_view[column->column_id] == NULL) pool_view[column->column_id] = cm->mapPoolView(column, idx);
+  return pool_view[column->column_id];
+}
+
+//on the emulated device the gpu operators run the cpu kernels on the pool views of their columns, which
+//hold exactly the segments the index arrays of the query point to. the pool keeps raw segments, so the
+//filters get no packs or slices
+struct filterArgsCPU
+CPUGPUProcessing::hostFilterArgs(QueryParams* params, struct filterArgsGPU fargs) {
+  ColumnInfo* filter_col1 = columnOfIndex(fargs.filter_idx1);
+  ColumnInfo* filter_col2 = columnOfIndex(fargs.filter_idx2);
+
+  struct filterArgsCPU h_fargs = {
+    poolOfIndex(fargs.filter_idx1), poolOfIndex(fargs.filter_idx2),
+    fargs.compare1, fargs.compare2, fargs.compare3, fargs.compare4,
+    fargs.mode1, fargs.mode2,
+    (filter_col1 != NULL) ? (params->map_filter_func_host[filter_col1]) : (NULL), 
+    (filter_col2 != NULL) ? (params->map_filter_func_host[filter_col2]) : (NULL),
+    NULL, NULL, NULL, NULL
+  };
+  return h_fargs;
+}
+
+struct probeArgsCPU
+CPUGPUProcessing::hostProbeArgs(struct probeArgsGPU pargs) {
+  struct probeArgsCPU h_pargs = {
+    poolOfIndex(pargs.key_idx1), poolOfIndex(pargs.key_idx2), poolOfIndex(pargs.key_idx3), poolOfIndex(pargs.key_idx4),
+    pargs.ht1, pargs.ht2, pargs.ht3, pargs.ht4,
+    pargs.dim_len1, pargs.dim_len2, pargs.dim_len3, pargs.dim_len4,
+    pargs.min_key1, pargs.min_key2, pargs.min_key3, pargs.min_key4
+  };
+  return h_pargs;
+}
+
+struct buildArgsCPU
+CPUGPUProcessing::hostBuildArgs(struct buildArgsGPU bargs) {
+  struct buildArgsCPU h_bargs = {
+    poolOfIndex(bargs.key_idx), poolOfIndex(bargs.val_idx),
+    bargs.num_slots, bargs.val_min, bargs.val_max
+  };
+  return h_bargs;
+}
+
+struct groupbyArgsCPU
+CPUGPUProcessing::hostGroupbyArgs(QueryParams* params, struct groupbyArgsGPU gargs) {
+  int* idx[6] = {gargs.aggr_idx1, gargs.aggr_idx2, gargs.group_idx1, gargs.group_idx2, gargs.group_idx3, gargs.group_idx4};
+  int* col[6] = {};
+
+  for (int i = 0; i < 6; i++) col[i] = poolOfIndex(idx[i]);
+
+  struct groupbyArgsCPU h_gargs = {
+    col[0], col[1], col[2], col[3], col[4], col[5],
+    gargs.min_val1, gargs.min_val2, gargs.min_val3, gargs.min_val4,
+    gargs.unique_val1, gargs.unique_val2, gargs.unique_val3, gargs.unique_val4,
+    gargs.total_val, gargs.mode, params->h_group_func
+  };
+  return h_gargs;
+}
+
+struct offsetCPU
+CPUGPUProcessing::hostOffset(struct offsetGPU off) {
+  struct offsetCPU h_off = {
+    off.lo_off, off.dim_off1, off.dim_off2, off.dim_off3, off.dim_off4
+  };
+  return h_off;
+}
+
 void 
 CPUGPUProcessing::switch_device_fact(int** &off_col, int** &h_off_col, int* &d_total, int* h_total, int sg, int mode, int table, cudaStream_t stream) {
   // chrono::high_resolution_clock::time_point st = chrono::high_resolution_clock::now();
@@ -69,16 +179,16 @@ CPUGPUProcessing::switch_device_fact(int** &off_col, int** &h_off_col, int* &d_t
     assert(h_off_col[0] != NULL);
     off_col = new int*[cm->TOT_TABLE]();
 
-    CubDebugExit(cudaMemcpyAsync(d_total, h_total, sizeof(int), cudaMemcpyHostToDevice, stream));
-    CubDebugExit(cudaStreamSynchronize(stream));
+    CubDebugExit(deviceMemcpyAsync(d_total, h_total, sizeof(int), cudaMemcpyHostToDevice, stream));
+    CubDebugExit(deviceStreamSynchronize(stream));
     cpu_to_gpu[sg] += (1 * sizeof(int));
 
-    cudaEventRecord(start, 0);
+    deviceEventRecord(start, 0);
 
     for (int i = 0; i < cm->TOT_TABLE; i++) {
       if (h_off_col[i] != NULL) {
-        if (!custom) CubDebugExit(cudaMalloc((void**) &off_col[i], *h_total * sizeof(int)));
-        if (custom) off_col[i] = (int*) cm->customCudaMalloc<int>(*h_total);
+        if (!custom) CubDebugExit(deviceMalloc((void**) &off_col[i], *h_total * sizeof(int)));
+        if (custom) off_col[i] = (int*) cm->customCudaMalloc<int>(*h_total, scope);
       }
     }
   } else {
@@ -87,57 +197,57 @@ CPUGPUProcessing::switch_device_fact(int** &off_col, int** &h_off_col, int* &d_t
     assert(off_col[0] != NULL);
     h_off_col = new int*[cm->TOT_TABLE]();
 
-    CubDebugExit(cudaMemcpyAsync(h_total, d_total, sizeof(int), cudaMemcpyDeviceToHost, stream));
-    CubDebugExit(cudaStreamSynchronize(stream));
+    CubDebugExit(deviceMemcpyAsync(h_total, d_total, sizeof(int), cudaMemcpyDeviceToHost, stream));
+    CubDebugExit(deviceStreamSynchronize(stream));
     gpu_to_cpu[sg] += (1 * sizeof(int));
 
-    cudaEventRecord(start, 0);
+    deviceEventRecord(start, 0);
 
     for (int i = 0; i < cm->TOT_TABLE; i++) {
       if (off_col[i] != NULL) {
-        if (!custom) CubDebugExit(cudaHostAlloc((void**) &h_off_col[i], *h_total * sizeof(int), cudaHostAllocDefault));
-        if (custom) h_off_col[i] = (int*) cm->customCudaHostAlloc<int>(*h_total);
+        if (!custom) CubDebugExit(deviceHostAlloc((void**) &h_off_col[i], *h_total * sizeof(int), cudaHostAllocDefault));
+        if (custom) h_off_col[i] = (int*) cm->customCudaHostAlloc<int>(*h_total, scope);
       }
     }
   }
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
   malloc_time[sg] += time;
   // cout << "sg: " << sg << " transfer malloc time: " << malloc_time[sg]<< endl;
   
   if (verbose) cout << "Transfer size: " << *h_total << " sg: " << sg << endl;
 
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   if (mode == 0) { //CPU to GPU
     for (int i = 0; i < cm->TOT_TABLE; i++) {
       if (h_off_col[i] != NULL) {
         // if (custom) off_col[i] = (int*) cm->customCudaMalloc<int>(*h_total);
-        CubDebugExit(cudaMemcpyAsync(off_col[i], h_off_col[i], *h_total * sizeof(int), cudaMemcpyHostToDevice, stream));
-        CubDebugExit(cudaStreamSynchronize(stream));
-        if (!custom) cudaFreeHost(h_off_col[i]);
+        CubDebugExit(deviceMemcpyAsync(off_col[i], h_off_col[i], *h_total * sizeof(int), cudaMemcpyHostToDevice, stream));
+        CubDebugExit(deviceStreamSynchronize(stream));
+        if (!custom) deviceFreeHost(h_off_col[i]);
         cpu_to_gpu[sg] += (*h_total * sizeof(int));
       }
     }
-    CubDebugExit(cudaStreamSynchronize(stream));
+    CubDebugExit(deviceStreamSynchronize(stream));
   } else { // GPU to CPU
     for (int i = 0; i < cm->TOT_TABLE; i++) {
       if (off_col[i] != NULL) {
         // if (custom) h_off_col[i] = (int*) cm->customCudaHostAlloc<int>(*h_total);
-        CubDebugExit(cudaMemcpyAsync(h_off_col[i], off_col[i], *h_total * sizeof(int), cudaMemcpyDeviceToHost, stream));
-        CubDebugExit(cudaStreamSynchronize(stream));
-        if (!custom) cudaFree(off_col[i]);
+        CubDebugExit(deviceMemcpyAsync(h_off_col[i], off_col[i], *h_total * sizeof(int), cudaMemcpyDeviceToHost, stream));
+        CubDebugExit(deviceStreamSynchronize(stream));
+        if (!custom) deviceFree(off_col[i]);
         gpu_to_cpu[sg] += (*h_total * sizeof(int));
       }
     }
-    CubDebugExit(cudaStreamSynchronize(stream));
+    CubDebugExit(deviceStreamSynchronize(stream));
   }
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
   if (verbose) cout << "Transfer Time: " << time << " sg: " << sg << endl;
   transfer_time[sg] += time;
   
@@ -148,70 +258,70 @@ CPUGPUProcessing::switch_device_dim(int* &d_off_col, int* &h_off_col, int* &d_to
 
   float time;
   SETUP_TIMING();
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   if (mode == 0) {
     if (h_off_col == NULL) return;
     assert(h_off_col != NULL);
     assert(*h_total > 0);
 
-    CubDebugExit(cudaMemcpyAsync(d_total, h_total, sizeof(int), cudaMemcpyHostToDevice, stream));
-    CubDebugExit(cudaStreamSynchronize(stream));
+    CubDebugExit(deviceMemcpyAsync(d_total, h_total, sizeof(int), cudaMemcpyHostToDevice, stream));
+    CubDebugExit(deviceStreamSynchronize(stream));
     cpu_to_gpu[sg] += (1 * sizeof(int));
 
-    if (!custom) CubDebugExit(cudaMalloc((void**) &d_off_col, *h_total * sizeof(int)));
-    if (custom) d_off_col = (int*) cm->customCudaMalloc<int>(*h_total);
+    if (!custom) CubDebugExit(deviceMalloc((void**) &d_off_col, *h_total * sizeof(int)));
+    if (custom) d_off_col = (int*) cm->customCudaMalloc<int>(*h_total, scope);
   } else {
     if (d_off_col == NULL) return;
     assert(d_off_col != NULL);
     assert(*h_total > 0);
 
-    CubDebugExit(cudaMemcpyAsync(h_total, d_total, sizeof(int), cudaMemcpyDeviceToHost, stream));
-    CubDebugExit(cudaStreamSynchronize(stream));
+    CubDebugExit(deviceMemcpyAsync(h_total, d_total, sizeof(int), cudaMemcpyDeviceToHost, stream));
+    CubDebugExit(deviceStreamSynchronize(stream));
     gpu_to_cpu[sg] += (1 * sizeof(int));
 
-    if (!custom) CubDebugExit(cudaHostAlloc((void**) &h_off_col, *h_total * sizeof(int), cudaHostAllocDefault));
-    if (custom) h_off_col = (int*) cm->customCudaHostAlloc<int>(*h_total);
+    if (!custom) CubDebugExit(deviceHostAlloc((void**) &h_off_col, *h_total * sizeof(int), cudaHostAllocDefault));
+    if (custom) h_off_col = (int*) cm->customCudaHostAlloc<int>(*h_total, scope);
   }
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
   malloc_time[sg] += time;
 
   if (verbose) cout << "Transfer size: " << *h_total << " sg: " << sg << endl;
 
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   if (mode == 0) { //CPU to GPU
     // if (custom) d_off_col = (int*) cm->customCudaMalloc<int>(*h_total);
 
     if (h_off_col != NULL) {
-      CubDebugExit(cudaMemcpyAsync(d_off_col, h_off_col, *h_total * sizeof(int), cudaMemcpyHostToDevice, stream));
-      CubDebugExit(cudaStreamSynchronize(stream));
+      CubDebugExit(deviceMemcpyAsync(d_off_col, h_off_col, *h_total * sizeof(int), cudaMemcpyHostToDevice, stream));
+      CubDebugExit(deviceStreamSynchronize(stream));
       cpu_to_gpu[sg] += (*h_total * sizeof(int));
-      // if (!custom) cudaFreeHost(h_off_col); //TODO: UNCOMMENTING THIS WILL CAUSE SEGFAULT BECAUSE THERE IS A POSSIBILITY OF
+      // if (!custom) deviceFreeHost(h_off_col); //TODO: UNCOMMENTING THIS WILL CAUSE SEGFAULT BECAUSE THERE IS A POSSIBILITY OF
       //FILTER CPU -> SWITCH -> BUILD GPU -> BUILD CPU (H_OFF_COL WILL BE USED AGAIN IN BUILD CPU)
     } else d_off_col = NULL;
 
-    CubDebugExit(cudaStreamSynchronize(stream));
+    CubDebugExit(deviceStreamSynchronize(stream));
 
   } else { // GPU to CPU
     // if (custom) h_off_col = (int*) cm->customCudaHostAlloc<int>(*h_total);
 
     if (d_off_col != NULL) {
-      CubDebugExit(cudaMemcpyAsync(h_off_col, d_off_col, *h_total * sizeof(int), cudaMemcpyDeviceToHost, stream));
-      CubDebugExit(cudaStreamSynchronize(stream));
+      CubDebugExit(deviceMemcpyAsync(h_off_col, d_off_col, *h_total * sizeof(int), cudaMemcpyDeviceToHost, stream));
+      CubDebugExit(deviceStreamSynchronize(stream));
       gpu_to_cpu[sg] += (*h_total * sizeof(int));
-      if (!custom) cudaFree(d_off_col);
+      if (!custom) deviceFree(d_off_col);
     } else h_off_col = NULL;
 
-    CubDebugExit(cudaStreamSynchronize(stream));
+    CubDebugExit(deviceStreamSynchronize(stream));
   }
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
   if (verbose) cout << "Transfer Time: " << time << " sg: " << sg << endl;
   transfer_time[sg] += time;
   
@@ -233,7 +343,7 @@ CPUGPUProcessing::call_pfilter_probe_group_by_GPU(QueryParams* params, int** &of
   for (int i = 0; i < qo->selectGPUPipelineCol[sg].size(); i++) {
     if (select_so_far == qo->select_probe[cm->lo_orderdate].size()) break;
     ColumnInfo* column = qo->selectGPUPipelineCol[sg][i];
-    cm->indexTransfer(col_idx, column, stream, custom);
+    cm->indexTransfer(col_idx, column, stream, custom, scope);
     cpu_to_gpu[sg] += (column->total_segment * sizeof(int));
     filter_idx[select_so_far + i] = col_idx[column->column_id];
     _compare1[select_so_far + i] = params->compare1[column];
@@ -245,7 +355,7 @@ CPUGPUProcessing::call_pfilter_probe_group_by_GPU(QueryParams* params, int** &of
     ColumnInfo* column = qo->joinGPUPipelineCol[sg][i];
     int table_id = qo->fkey_pkey[column]->table_id;
     ColumnInfo* pkey = qo->fkey_pkey[column];
-    cm->indexTransfer(col_idx, column, stream, custom);
+    cm->indexTransfer(col_idx, column, stream, custom, scope);
     cpu_to_gpu[sg] += (column->total_segment * sizeof(int));
     assert(col_idx[column->column_id] != NULL);
     fkey_idx[table_id - 1] = col_idx[column->column_id];
@@ -256,7 +366,7 @@ CPUGPUProcessing::call_pfilter_probe_group_by_GPU(QueryParams* params, int** &of
 
   for (int i = 0; i < qo->aggregation[cm->lo_orderdate].size(); i++) {
     ColumnInfo* column = qo->aggregation[cm->lo_orderdate][i];
-    cm->indexTransfer(col_idx, column, stream, custom);
+    cm->indexTransfer(col_idx, column, stream, custom, scope);
     cpu_to_gpu[sg] += (column->total_segment * sizeof(int));
     aggr_idx[i] = col_idx[column->column_id];
   }
@@ -266,7 +376,7 @@ CPUGPUProcessing::call_pfilter_probe_group_by_GPU(QueryParams* params, int** &of
     if (it->second.size() > 0) {
       ColumnInfo* column = it->second[0];
       ColumnInfo* column_key = it->first;
-      cm->indexTransfer(col_idx, column, stream, custom);
+      cm->indexTransfer(col_idx, column, stream, custom, scope);
       cpu_to_gpu[sg] += (column->total_segment * sizeof(int));
       group_idx[column_key->table_id - 1] = col_idx[column->column_id];
       _min_val[column_key->table_id - 1] = params->min_val[column_key];
@@ -299,7 +409,7 @@ CPUGPUProcessing::call_pfilter_probe_group_by_GPU(QueryParams* params, int** &of
 
   float time;
   SETUP_TIMING();
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   if (off_col == NULL) {
 
@@ -312,18 +422,22 @@ CPUGPUProcessing::call_pfilter_probe_group_by_GPU(QueryParams* params, int** &of
 
     short* d_segment_group;
     // d_segment_group = reinterpret_cast<short*>(cm->customCudaMalloc(cm->lo_orderdate->total_segment));
-    if (custom) d_segment_group = (short*) cm->customCudaMalloc<short>(cm->lo_orderdate->total_segment);
-    else CubDebugExit(cudaMalloc((void**) &d_segment_group, cm->lo_orderdate->total_segment * sizeof(short)));
+    if (custom) d_segment_group = (short*) cm->customCudaMalloc<short>(cm->lo_orderdate->total_segment, scope);
+    else CubDebugExit(deviceMalloc((void**) &d_segment_group, cm->lo_orderdate->total_segment * sizeof(short)));
     short* segment_group_ptr = qo->segment_group[0] + (sg * cm->lo_orderdate->total_segment);
-    CubDebugExit(cudaMemcpyAsync(d_segment_group, segment_group_ptr, qo->segment_group_count[0][sg] * sizeof(short), cudaMemcpyHostToDevice, stream));
+    CubDebugExit(deviceMemcpyAsync(d_segment_group, segment_group_ptr, qo->segment_group_count[0][sg] * sizeof(short), cudaMemcpyHostToDevice, stream));
     cpu_to_gpu[sg] += (qo->segment_group_count[0][sg] * sizeof(short));
 
-    filter_probe_group_by_GPU2<128, 4><<<(LEN + tile_items - 1)/tile_items, 128, 0, stream>>>(
+    if (deviceIsHost()) {
+      filter_probe_group_by_CPU(hostFilterArgs(params, fargs), hostProbeArgs(pargs), hostGroupbyArgs(params, gargs), LEN, params->d_res, 0, d_segment_group);
+    } else {
+      filter_probe_group_by_GPU2<128, 4><<<(LEN + tile_items - 1)/tile_items, 128, 0, stream>>>(
       cm->gpuCache, fargs, pargs, gargs, LEN, params->d_res, 0, d_segment_group);
+    }
 
     CHECK_ERROR_STREAM(stream);
 
-    if (!custom) cudaFree(d_segment_group);
+    if (!custom) deviceFree(d_segment_group);
 
   } else {
 
@@ -331,22 +445,26 @@ CPUGPUProcessing::call_pfilter_probe_group_by_GPU(QueryParams* params, int** &of
       off_col[0], off_col[1], off_col[2], off_col[3], off_col[4]
     };
 
-    filter_probe_group_by_GPU3<128, 4><<<(*h_total + tile_items - 1)/tile_items, 128, 0, stream>>>(
+    if (deviceIsHost()) {
+      filter_probe_group_by_CPU2(hostOffset(offset), hostFilterArgs(params, fargs), hostProbeArgs(pargs), hostGroupbyArgs(params, gargs), *h_total, params->d_res, 0);
+    } else {
+      filter_probe_group_by_GPU3<128, 4><<<(*h_total + tile_items - 1)/tile_items, 128, 0, stream>>>(
       cm->gpuCache, offset, fargs, pargs, gargs, *h_total, params->d_res);
+    }
 
     CHECK_ERROR_STREAM(stream);
 
     if (!custom) {
       for (int i = 0; i < cm->TOT_TABLE; i++) {
-        if (off_col[i] != NULL) cudaFree(off_col[i]);
+        if (off_col[i] != NULL) deviceFree(off_col[i]);
       }
     }
 
   }
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
 
   if (verbose) cout << "Filter Probe Group Kernel time GPU: " << time << endl;
   gpu_time[sg] += time;
@@ -403,7 +521,11 @@ CPUGPUProcessing::call_pfilter_probe_group_by_CPU(QueryParams* params, int** &h_
     _compare1[0], _compare2[0], _compare1[1], _compare2[1],
     1, 1,
     (filter_col[0] != NULL) ? (params->map_filter_func_host[filter_col[0]]) : (NULL), 
-    (filter_col[1] != NULL) ? (params->map_filter_func_host[filter_col[1]]) : (NULL)
+    (filter_col[1] != NULL) ? (params->map_filter_func_host[filter_col[1]]) : (NULL),
+    (filter_col[0] != NULL) ? (filter_col[0]->pack) : (NULL),
+    (filter_col[1] != NULL) ? (filter_col[1]->pack) : (NULL),
+    (filter_col[0] != NULL) ? (filter_col[0]->slice) : (NULL),
+    (filter_col[1] != NULL) ? (filter_col[1]->slice) : (NULL)
   };
 
   struct probeArgsCPU pargs = {
@@ -422,7 +544,7 @@ CPUGPUProcessing::call_pfilter_probe_group_by_CPU(QueryParams* params, int** &h_
 
   float time;
   SETUP_TIMING();
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   if (h_off_col == NULL) {
 
@@ -446,20 +568,170 @@ CPUGPUProcessing::call_pfilter_probe_group_by_CPU(QueryParams* params, int** &h_
 
     if (!custom) {
       for (int i = 0; i < cm->TOT_TABLE; i++) {
-        if (h_off_col[i] != NULL) cudaFreeHost(h_off_col[i]);
+        if (h_off_col[i] != NULL) deviceFreeHost(h_off_col[i]);
       }
     }
   }
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
 
   if (verbose) cout << "Filter Probe Group Kernel time CPU : " << time << endl;
   cpu_time[sg] += time;
 
 };
 
+//copies every cpu hash table of the query to each numa node once the build phase is done
+void
+CPUGPUProcessing::replicate_ht_CPU(QueryParams* params) {
+
+  if (!numaActive() || !numaPlacement().replicate_ht) return;
+
+  int nodes = numaNodes();
+  params->ht_CPU_replica.resize(nodes);
+
+  for (int i = 0; i < qo->join.size(); i++) {
+    ColumnInfo* pkey = qo->join[i].second;
+    int* ht = params->ht_CPU[pkey];
+    if (ht == NULL) continue;
+    size_t bytes = 2 * params->dim_len[pkey] * sizeof(int);
+
+    parallel_for(0, nodes, [&](int node) {
+      int* replica = (int*) numaAllocOnNode(bytes, node);
+      memcpy(replica, ht, bytes);
+      params->ht_CPU_replica[node][pkey] = replica;
+    });
+  }
+};
+
+void
+CPUGPUProcessing::free_ht_CPU_replica(QueryParams* params) {
+
+  for (int node = 0; node < params->ht_CPU_replica.size(); node++) {
+    map<ColumnInfo*, int*>::iterator it;
+    for (it = params->ht_CPU_replica[node].begin(); it != params->ht_CPU_replica[node].end(); it++) {
+      numaFree(it->second, 2 * params->dim_len[it->first] * sizeof(int));
+    }
+  }
+  params->ht_CPU_replica.clear();
+};
+
+//segment groups whose whole pipeline runs on the cpu, cut into morsels and run by one scheduler
+void
+CPUGPUProcessing::call_pipeline_morsel_CPU(QueryParams* params, vector<int>& sgs) {
+
+  assert(sgs.size() > 0);
+
+  //every segment group of the list has all of its filters and joins on the cpu, so any of them gives the pipeline
+  int sg = sgs[0];
+
+  int _min_key[4] = {0}, _dim_len[4] = {0};
+  int *ht[4] = {}, *fkey_col[4] = {};
+  ColumnInfo *filter_col[2] = {};
+  int _compare1[2] = {0}, _compare2[2] = {0};
+  int _min_val[4] = {0}, _unique_val[4] = {0};
+  int *aggr_col[2] = {}, *group_col[4] = {};
+
+  for (int i = 0; i < qo->selectCPUPipelineCol[sg].size(); i++) {
+    ColumnInfo* column = qo->selectCPUPipelineCol[sg][i];
+    filter_col[i] = column;
+    _compare1[i] = params->compare1[column];
+    _compare2[i] = params->compare2[column];
+  }
+
+  for (int i = 0; i < qo->joinCPUPipelineCol[sg].size(); i++) {
+    ColumnInfo* column = qo->joinCPUPipelineCol[sg][i];
+    int table_id = qo->fkey_pkey[column]->table_id;
+    fkey_col[table_id - 1] = column->col_ptr;
+    ColumnInfo* pkey = qo->fkey_pkey[column];
+    ht[table_id - 1] = params->ht_CPU[pkey];
+    _min_key[table_id - 1] = params->min_key[pkey];
+    _dim_len[table_id - 1] = params->dim_len[pkey];
+  }
+
+  for (int i = 0; i < qo->aggregation[cm->lo_orderdate].size(); i++) {
+    ColumnInfo* column = qo->aggregation[cm->lo_orderdate][i];
+    aggr_col[i] = column->col_ptr;
+  }
+
+  unordered_map<ColumnInfo*, vector<ColumnInfo*>>::iterator it;
+  for (it = qo->groupby_build.begin(); it != qo->groupby_build.end(); it++) {
+    if (it->second.size() > 0) {
+      ColumnInfo* column = it->second[0];
+      ColumnInfo* column_key = it->first;
+      group_col[column_key->table_id - 1] = column->col_ptr;
+      _min_val[column_key->table_id - 1] = params->min_val[column_key];
+      _unique_val[column_key->table_id - 1] = params->unique_val[column_key];
+    }
+  }
+
+  struct filterArgsCPU fargs = {
+    (filter_col[0] != NULL) ? (filter_col[0]->col_ptr) : (NULL), 
+    (filter_col[1] != NULL) ? (filter_col[1]->col_ptr) : (NULL),
+    _compare1[0], _compare2[0], _compare1[1], _compare2[1],
+    1, 1,
+    (filter_col[0] != NULL) ? (params->map_filter_func_host[filter_col[0]]) : (NULL), 
+    (filter_col[1] != NULL) ? (params->map_filter_func_host[filter_col[1]]) : (NULL),
+    (filter_col[0] != NULL) ? (filter_col[0]->pack) : (NULL),
+    (filter_col[1] != NULL) ? (filter_col[1]->pack) : (NULL),
+    (filter_col[0] != NULL) ? (filter_col[0]->slice) : (NULL),
+    (filter_col[1] != NULL) ? (filter_col[1]->slice) : (NULL)
+  };
+
+  struct probeArgsCPU pargs = {
+    fkey_col[0], fkey_col[1], fkey_col[2], fkey_col[3],
+    ht[0], ht[1], ht[2], ht[3], 
+    _dim_len[0], _dim_len[1], _dim_len[2], _dim_len[3],
+    _min_key[0], _min_key[1], _min_key[2], _min_key[3]
+  };
+
+  struct groupbyArgsCPU gargs = {
+    aggr_col[0], aggr_col[1], group_col[0], group_col[1], group_col[2], group_col[3],
+    _min_val[0], _min_val[1], _min_val[2], _min_val[3],
+    _unique_val[0], _unique_val[1], _unique_val[2], _unique_val[3],
+    params->total_val, params->mode_group, params->h_group_func
+  };
+
+  float time;
+  SETUP_TIMING();
+  deviceEventRecord(start, 0);
+
+  MorselScheduler sched;
+  for (int i = 0; i < sgs.size(); i++) {
+    short* segment_group_ptr = qo->segment_group[0] + (sgs[i] * cm->lo_orderdate->total_segment);
+    sched.addSegments(segment_group_ptr, qo->segment_group_count[0][sgs[i]], cm->lo_orderdate->total_segment, cm->lo_orderdate->LEN);
+  }
+  if (shared_scan_cpu) sched.joinScan(&fact_scan);
+
+  //workers of a node probe the hash table replicas of their node
+  vector<probeArgsCPU> node_pargs(sched.num_node, pargs);
+  for (int node = 0; node < sched.num_node && node < params->ht_CPU_replica.size(); node++) {
+    for (int i = 0; i < qo->joinCPUPipelineCol[sg].size(); i++) {
+      ColumnInfo* pkey = qo->fkey_pkey[qo->joinCPUPipelineCol[sg][i]];
+      int* replica = params->ht_CPU_replica[node][pkey];
+      if (replica == NULL) continue;
+      if (pkey->table_id == 1) node_pargs[node].ht1 = replica;
+      else if (pkey->table_id == 2) node_pargs[node].ht2 = replica;
+      else if (pkey->table_id == 3) node_pargs[node].ht3 = replica;
+      else if (pkey->table_id == 4) node_pargs[node].ht4 = replica;
+    }
+  }
+
+  if (qo->groupby_build.size() == 0) filter_probe_aggr_morsel_CPU(fargs, node_pargs.data(), gargs, sched, params->res);
+  else filter_probe_group_by_morsel_CPU(fargs, node_pargs.data(), gargs, sched, params->res);
+  sched.leaveScan();
+
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
+
+  if (verbose) cout << "Morsel Pipeline Kernel time CPU : " << time << " (" << sgs.size() << " segment groups, " << sched.num_tuples << " rows)" << endl;
+  //all segment groups of the scheduler finish together
+  for (int i = 0; i < sgs.size(); i++) cpu_time[sgs[i]] += time;
+
+};
+
 void 
 CPUGPUProcessing::call_pfilter_probe_GPU(QueryParams* params, int** &off_col, int* &d_total, int* h_total, int sg, int select_so_far, cudaStream_t stream) {
   int **off_col_out;
@@ -477,12 +749,12 @@ CPUGPUProcessing::call_pfilter_probe_GPU(QueryParams* params, int** &off_col, in
 
   off_col_out = new int*[cm->TOT_TABLE] (); //initialize it to null
 
-  CubDebugExit(cudaMemsetAsync(d_total, 0, sizeof(int), stream));
+  CubDebugExit(deviceMemsetAsync(d_total, 0, sizeof(int), stream));
 
   for (int i = 0; i < qo->selectGPUPipelineCol[sg].size(); i++) {
     if (select_so_far == qo->select_probe[cm->lo_orderdate].size()) break;
     ColumnInfo* column = qo->selectGPUPipelineCol[sg][i];
-    cm->indexTransfer(col_idx, column, stream, custom);
+    cm->indexTransfer(col_idx, column, stream, custom, scope);
     cpu_to_gpu[sg] += (column->total_segment * sizeof(int));
     filter_idx[select_so_far + i] = col_idx[column->column_id];
     _compare1[select_so_far + i] = params->compare1[column];
@@ -496,7 +768,7 @@ CPUGPUProcessing::call_pfilter_probe_GPU(QueryParams* params, int** &off_col, in
     ColumnInfo* column = qo->joinGPUPipelineCol[sg][i];
     int table_id = qo->fkey_pkey[column]->table_id;
     ColumnInfo* pkey = qo->fkey_pkey[column];
-    cm->indexTransfer(col_idx, column, stream, custom);
+    cm->indexTransfer(col_idx, column, stream, custom, scope);
     cpu_to_gpu[sg] += (column->total_segment * sizeof(int));
     assert(col_idx[column->column_id] != NULL);
     fkey_idx[table_id - 1] = col_idx[column->column_id];
@@ -524,14 +796,14 @@ CPUGPUProcessing::call_pfilter_probe_GPU(QueryParams* params, int** &off_col, in
 
   SETUP_TIMING();
   float time;
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   if (off_col == NULL) {
     output_estimate = SEGMENT_SIZE * qo->segment_group_count[0][sg] * output_selectivity;
     for (int i = 0; i < cm->TOT_TABLE; i++) {
       if (i == 0 || qo->joinGPUcheck[i]) {
-        if (!custom) CubDebugExit(cudaMalloc((void**) &off_col_out[i], output_estimate * sizeof(int)));
-        if (custom) off_col_out[i] = (int*) cm->customCudaMalloc<int>(output_estimate);
+        if (!custom) CubDebugExit(deviceMalloc((void**) &off_col_out[i], output_estimate * sizeof(int)));
+        if (custom) off_col_out[i] = (int*) cm->customCudaMalloc<int>(output_estimate, scope);
       }
     }
   } else {
@@ -539,17 +811,17 @@ CPUGPUProcessing::call_pfilter_probe_GPU(QueryParams* params, int** &off_col, in
     output_estimate = *h_total * output_selectivity;
     for (int i = 0; i < cm->TOT_TABLE; i++) {
       if (off_col[i] != NULL || i == 0 || qo->joinGPUcheck[i]) {
-        if (!custom) CubDebugExit(cudaMalloc((void**) &off_col_out[i], output_estimate * sizeof(int)));
-        if (custom) off_col_out[i] = (int*) cm->customCudaMalloc<int>(output_estimate);
+        if (!custom) CubDebugExit(deviceMalloc((void**) &off_col_out[i], output_estimate * sizeof(int)));
+        if (custom) off_col_out[i] = (int*) cm->customCudaMalloc<int>(output_estimate, scope);
       }
     }
   }
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
   malloc_time[sg] += time;
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   if (off_col == NULL) {
 
@@ -574,18 +846,22 @@ CPUGPUProcessing::call_pfilter_probe_GPU(QueryParams* params, int** &off_col, in
 
     short* d_segment_group;
     // d_segment_group = reinterpret_cast<short*>(cm->customCudaMalloc(cm->lo_orderdate->total_segment));
-    if (custom) d_segment_group = (short*) cm->customCudaMalloc<short>(cm->lo_orderdate->total_segment);
-    else CubDebugExit(cudaMalloc((void**) &d_segment_group, cm->lo_orderdate->total_segment * sizeof(short)));
+    if (custom) d_segment_group = (short*) cm->customCudaMalloc<short>(cm->lo_orderdate->total_segment, scope);
+    else CubDebugExit(deviceMalloc((void**) &d_segment_group, cm->lo_orderdate->total_segment * sizeof(short)));
     short* segment_group_ptr = qo->segment_group[0] + (sg * cm->lo_orderdate->total_segment);
-    CubDebugExit(cudaMemcpyAsync(d_segment_group, segment_group_ptr, qo->segment_group_count[0][sg] * sizeof(short), cudaMemcpyHostToDevice, stream));
+    CubDebugExit(deviceMemcpyAsync(d_segment_group, segment_group_ptr, qo->segment_group_count[0][sg] * sizeof(short), cudaMemcpyHostToDevice, stream));
     cpu_to_gpu[sg] += (qo->segment_group_count[0][sg] * sizeof(short));
 
-    filter_probe_GPU2<128,4><<<(LEN+ tile_items - 1)/tile_items, 128, 0, stream>>>(
+    if (deviceIsHost()) {
+      filter_probe_CPU(hostFilterArgs(params, fargs), hostProbeArgs(pargs), hostOffset(out_off), LEN, d_total, 0, d_segment_group);
+    } else {
+      filter_probe_GPU2<128,4><<<(LEN+ tile_items - 1)/tile_items, 128, 0, stream>>>(
       cm->gpuCache, fargs, pargs, out_off, LEN, d_total, 0, d_segment_group);
+    }
 
     CHECK_ERROR_STREAM(stream);
 
-    if (!custom) cudaFree(d_segment_group);
+    if (!custom) deviceFree(d_segment_group);
 
   } else {
 
@@ -607,14 +883,18 @@ CPUGPUProcessing::call_pfilter_probe_GPU(QueryParams* params, int** &off_col, in
       off_col_out[0], off_col_out[1], off_col_out[2], off_col_out[3], off_col_out[4]
     };
 
-    filter_probe_GPU3<128,4><<<(*h_total + tile_items - 1)/tile_items, 128, 0, stream>>>( 
+    if (deviceIsHost()) {
+      filter_probe_CPU2(hostOffset(in_off), hostFilterArgs(params, fargs), hostProbeArgs(pargs), hostOffset(out_off), *h_total, d_total, 0);
+    } else {
+      filter_probe_GPU3<128,4><<<(*h_total + tile_items - 1)/tile_items, 128, 0, stream>>>( 
       cm->gpuCache, in_off, fargs, pargs, out_off, *h_total, d_total);
+    }
 
     CHECK_ERROR_STREAM(stream);
 
     if (!custom) {
       for (int i = 0; i < cm->TOT_TABLE; i++) {
-        if (off_col[i] != NULL) cudaFree(off_col[i]);
+        if (off_col[i] != NULL) deviceFree(off_col[i]);
       }
     }
 
@@ -625,17 +905,17 @@ CPUGPUProcessing::call_pfilter_probe_GPU(QueryParams* params, int** &off_col, in
   for (int i = 0; i < cm->TOT_TABLE; i++)
     off_col[i] = off_col_out[i];
 
-  CubDebugExit(cudaMemcpyAsync(h_total, d_total, sizeof(int), cudaMemcpyDeviceToHost, stream));
-  CubDebugExit(cudaStreamSynchronize(stream));
+  CubDebugExit(deviceMemcpyAsync(h_total, d_total, sizeof(int), cudaMemcpyDeviceToHost, stream));
+  CubDebugExit(deviceStreamSynchronize(stream));
   gpu_to_cpu[sg] += (1 * sizeof(int));
 
   if (verbose) cout << "h_total: " << *h_total << " output_estimate: " << output_estimate << " sg: " << sg << endl;
   assert(*h_total <= output_estimate);
   // assert(*h_total > 0);
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
   gpu_time[sg] += time;
 
   if (verbose) cout << "Filter Probe Kernel time GPU: " << time << endl;
@@ -683,7 +963,11 @@ CPUGPUProcessing::call_pfilter_probe_CPU(QueryParams* params, int** &h_off_col,
     _compare1[0], _compare2[0], _compare1[1], _compare2[1],
     1, 1, 
     (filter_col[0] != NULL) ? (params->map_filter_func_host[filter_col[0]]) : (NULL), 
-    (filter_col[1] != NULL) ? (params->map_filter_func_host[filter_col[1]]) : (NULL)
+    (filter_col[1] != NULL) ? (params->map_filter_func_host[filter_col[1]]) : (NULL),
+    (filter_col[0] != NULL) ? (filter_col[0]->pack) : (NULL),
+    (filter_col[1] != NULL) ? (filter_col[1]->pack) : (NULL),
+    (filter_col[0] != NULL) ? (filter_col[0]->slice) : (NULL),
+    (filter_col[1] != NULL) ? (filter_col[1]->slice) : (NULL)
   };
 
   struct probeArgsCPU pargs = {
@@ -695,14 +979,14 @@ CPUGPUProcessing::call_pfilter_probe_CPU(QueryParams* params, int** &h_off_col,
 
   SETUP_TIMING();
   float time;
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   if (h_off_col == NULL) {
     output_estimate = SEGMENT_SIZE * qo->segment_group_count[0][sg] * output_selectivity;
     for (int i = 0; i < cm->TOT_TABLE; i++) {
       if (i == 0 || qo->joinCPUcheck[i]) {
-        if (!custom) CubDebugExit(cudaHostAlloc((void**) &off_col_out[i], output_estimate * sizeof(int), cudaHostAllocDefault));
-        if (custom) off_col_out[i] = (int*) cm->customCudaHostAlloc<int>(output_estimate);
+        if (!custom) CubDebugExit(deviceHostAlloc((void**) &off_col_out[i], output_estimate * sizeof(int), cudaHostAllocDefault));
+        if (custom) off_col_out[i] = (int*) cm->customCudaHostAlloc<int>(output_estimate, scope);
       }
     }
   } else {
@@ -710,17 +994,17 @@ CPUGPUProcessing::call_pfilter_probe_CPU(QueryParams* params, int** &h_off_col,
     output_estimate = *h_total * output_selectivity;
     for (int i = 0; i < cm->TOT_TABLE; i++) {
       if (h_off_col[i] != NULL || i == 0 || qo->joinCPUcheck[i]) {
-        if (!custom) CubDebugExit(cudaHostAlloc((void**) &off_col_out[i], output_estimate * sizeof(int), cudaHostAllocDefault));
-        if (custom) off_col_out[i] = (int*) cm->customCudaHostAlloc<int>(output_estimate);
+        if (!custom) CubDebugExit(deviceHostAlloc((void**) &off_col_out[i], output_estimate * sizeof(int), cudaHostAllocDefault));
+        if (custom) off_col_out[i] = (int*) cm->customCudaHostAlloc<int>(output_estimate, scope);
       }
     }
   }
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
   malloc_time[sg] += time;
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   if (h_off_col == NULL) {
 
@@ -773,7 +1057,7 @@ CPUGPUProcessing::call_pfilter_probe_CPU(QueryParams* params, int** &h_off_col,
 
     if (!custom) {
       for (int i = 0; i < cm->TOT_TABLE; i++) {
-        if (h_off_col[i] != NULL) cudaFreeHost(h_off_col[i]);
+        if (h_off_col[i] != NULL) deviceFreeHost(h_off_col[i]);
       }
     }
 
@@ -790,9 +1074,9 @@ CPUGPUProcessing::call_pfilter_probe_CPU(QueryParams* params, int** &h_off_col,
   assert(*h_total <= output_estimate);
   // assert(*h_total > 0);
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
   if (verbose) cout << "Filter Probe Kernel time CPU: " << time << endl;
   cpu_time[sg] += time;
 
@@ -812,7 +1096,7 @@ CPUGPUProcessing::call_probe_group_by_GPU(QueryParams* params, int** &off_col, i
     ColumnInfo* column = qo->joinGPUPipelineCol[sg][i];
     int table_id = qo->fkey_pkey[column]->table_id;
     ColumnInfo* pkey = qo->fkey_pkey[column];
-    cm->indexTransfer(col_idx, column, stream, custom);
+    cm->indexTransfer(col_idx, column, stream, custom, scope);
     cpu_to_gpu[sg] += (column->total_segment * sizeof(int));
     assert(col_idx[column->column_id] != NULL);
     fkey_idx[table_id - 1] = col_idx[column->column_id];
@@ -823,7 +1107,7 @@ CPUGPUProcessing::call_probe_group_by_GPU(QueryParams* params, int** &off_col, i
 
   for (int i = 0; i < qo->aggregation[cm->lo_orderdate].size(); i++) {
     ColumnInfo* column = qo->aggregation[cm->lo_orderdate][i];
-    cm->indexTransfer(col_idx, column, stream, custom);
+    cm->indexTransfer(col_idx, column, stream, custom, scope);
     cpu_to_gpu[sg] += (column->total_segment * sizeof(int));
     aggr_idx[i] = col_idx[column->column_id];
   }
@@ -833,7 +1117,7 @@ CPUGPUProcessing::call_probe_group_by_GPU(QueryParams* params, int** &off_col, i
     if (it->second.size() > 0) {
       ColumnInfo* column = it->second[0];
       ColumnInfo* column_key = it->first;
-      cm->indexTransfer(col_idx, column, stream, custom);
+      cm->indexTransfer(col_idx, column, stream, custom, scope);
       cpu_to_gpu[sg] += (column->total_segment * sizeof(int));
       group_idx[column_key->table_id - 1] = col_idx[column->column_id];
       _min_val[column_key->table_id - 1] = params->min_val[column_key];
@@ -869,20 +1153,24 @@ CPUGPUProcessing::call_probe_group_by_GPU(QueryParams* params, int** &off_col, i
 
     short* d_segment_group;
     // d_segment_group = reinterpret_cast<short*>(cm->customCudaMalloc(cm->lo_orderdate->total_segment));
-    if (custom) d_segment_group = (short*) cm->customCudaMalloc<short>(cm->lo_orderdate->total_segment);
-    else CubDebugExit(cudaMalloc((void**) &d_segment_group, cm->lo_orderdate->total_segment * sizeof(short)));
+    if (custom) d_segment_group = (short*) cm->customCudaMalloc<short>(cm->lo_orderdate->total_segment, scope);
+    else CubDebugExit(deviceMalloc((void**) &d_segment_group, cm->lo_orderdate->total_segment * sizeof(short)));
     short* segment_group_ptr = qo->segment_group[0] + (sg * cm->lo_orderdate->total_segment);
-    CubDebugExit(cudaMemcpyAsync(d_segment_group, segment_group_ptr, qo->segment_group_count[0][sg] * sizeof(short), cudaMemcpyHostToDevice, stream));
+    CubDebugExit(deviceMemcpyAsync(d_segment_group, segment_group_ptr, qo->segment_group_count[0][sg] * sizeof(short), cudaMemcpyHostToDevice, stream));
     cpu_to_gpu[sg] += (qo->segment_group_count[0][sg] * sizeof(short));
 
-    cudaEventRecord(start, 0);
+    deviceEventRecord(start, 0);
 
-    probe_group_by_GPU2<128, 4><<<(LEN + tile_items - 1)/tile_items, 128, 0, stream>>>(
+    if (deviceIsHost()) {
+      probe_group_by_CPU(hostProbeArgs(pargs), hostGroupbyArgs(params, gargs), LEN, params->d_res, 0, d_segment_group);
+    } else {
+      probe_group_by_GPU2<128, 4><<<(LEN + tile_items - 1)/tile_items, 128, 0, stream>>>(
       cm->gpuCache, pargs, gargs, LEN, params->d_res, 0, d_segment_group);
+    }
 
     CHECK_ERROR_STREAM(stream);
 
-    if (!custom) cudaFree(d_segment_group);
+    if (!custom) deviceFree(d_segment_group);
 
   } else {
 
@@ -890,25 +1178,29 @@ CPUGPUProcessing::call_probe_group_by_GPU(QueryParams* params, int** &off_col, i
       off_col[0], off_col[1], off_col[2], off_col[3], off_col[4]
     };
 
-    cudaEventRecord(start, 0);
+    deviceEventRecord(start, 0);
     
-    probe_group_by_GPU3<128, 4><<<(*h_total + tile_items - 1)/tile_items, 128, 0, stream>>>(
+    if (deviceIsHost()) {
+      probe_group_by_CPU2(hostOffset(offset), hostProbeArgs(pargs), hostGroupbyArgs(params, gargs), *h_total, params->d_res, 0);
+    } else {
+      probe_group_by_GPU3<128, 4><<<(*h_total + tile_items - 1)/tile_items, 128, 0, stream>>>(
       cm->gpuCache, offset, pargs, gargs, *h_total, params->d_res);
+    }
 
     CHECK_ERROR_STREAM(stream);
 
     if (!custom) {
       for (int i = 0; i < cm->TOT_TABLE; i++) {
-        if (off_col[i] != NULL) cudaFree(off_col[i]);
+        if (off_col[i] != NULL) deviceFree(off_col[i]);
       }
     }
 
   }
 
-  cudaEventRecord(stop, 0);                  // Stop time measuring
-  cudaEventSynchronize(stop);               // Wait until the completion of all device 
-                                            // work preceding the most recent call to cudaEventRecord()
-  cudaEventElapsedTime(&time, start, stop); // Saving the time measured
+  deviceEventRecord(stop, 0);                  // Stop time measuring
+  deviceEventSynchronize(stop);               // Wait until the completion of all device 
+                                            // work preceding the most recent call to deviceEventRecord()
+  deviceEventElapsedTime(&time, start, stop); // Saving the time measured
 
   if (verbose) cout << "Probe Group Kernel time GPU: " << time << endl;
   gpu_time[sg] += time;
@@ -965,7 +1257,7 @@ CPUGPUProcessing::call_probe_group_by_CPU(QueryParams* params, int** &h_off_col,
 
   float time;
   SETUP_TIMING();
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   if (h_off_col == NULL) {
 
@@ -989,15 +1281,15 @@ CPUGPUProcessing::call_probe_group_by_CPU(QueryParams* params, int** &h_off_col,
 
     if (!custom) {
       for (int i = 0; i < cm->TOT_TABLE; i++) {
-        if (h_off_col[i] != NULL) cudaFreeHost(h_off_col[i]);
+        if (h_off_col[i] != NULL) deviceFreeHost(h_off_col[i]);
       }
     }
   }
 
-  cudaEventRecord(stop, 0);                  // Stop time measuring
-  cudaEventSynchronize(stop);               // Wait until the completion of all device 
-                                            // work preceding the most recent call to cudaEventRecord()
-  cudaEventElapsedTime(&time, start, stop); // Saving the time measured
+  deviceEventRecord(stop, 0);                  // Stop time measuring
+  deviceEventSynchronize(stop);               // Wait until the completion of all device 
+                                            // work preceding the most recent call to deviceEventRecord()
+  deviceEventElapsedTime(&time, start, stop); // Saving the time measured
 
   if (verbose) cout << "Probe Group Kernel time CPU: " << time << endl;
   cpu_time[sg] += time;
@@ -1019,13 +1311,13 @@ CPUGPUProcessing::call_probe_GPU(QueryParams* params, int** &off_col, int* &d_to
 
   off_col_out = new int*[cm->TOT_TABLE] (); //initialize it to null
 
-  CubDebugExit(cudaMemsetAsync(d_total, 0, sizeof(int), stream));
+  CubDebugExit(deviceMemsetAsync(d_total, 0, sizeof(int), stream));
 
   for (int i = 0; i < qo->joinGPUPipelineCol[sg].size(); i++) {
     ColumnInfo* column = qo->joinGPUPipelineCol[sg][i];
     int table_id = qo->fkey_pkey[column]->table_id;
     ColumnInfo* pkey = qo->fkey_pkey[column];
-    cm->indexTransfer(col_idx, column, stream, custom);
+    cm->indexTransfer(col_idx, column, stream, custom, scope);
     cpu_to_gpu[sg] += (column->total_segment * sizeof(int));
     assert(col_idx[column->column_id] != NULL);
     fkey_idx[table_id - 1] = col_idx[column->column_id];
@@ -1045,14 +1337,14 @@ CPUGPUProcessing::call_probe_GPU(QueryParams* params, int** &off_col, int* &d_to
 
   float time;
   SETUP_TIMING();
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   if (off_col == NULL) {
     output_estimate = SEGMENT_SIZE * qo->segment_group_count[0][sg] * output_selectivity;
     for (int i = 0; i < cm->TOT_TABLE; i++) {
       if (i == 0 || qo->joinGPUcheck[i]) {
-        if (!custom) CubDebugExit(cudaMalloc((void**) &off_col_out[i], output_estimate * sizeof(int)));
-        if (custom) off_col_out[i] = (int*) cm->customCudaMalloc<int>(output_estimate);
+        if (!custom) CubDebugExit(deviceMalloc((void**) &off_col_out[i], output_estimate * sizeof(int)));
+        if (custom) off_col_out[i] = (int*) cm->customCudaMalloc<int>(output_estimate, scope);
       }
     }
   } else {
@@ -1060,17 +1352,17 @@ CPUGPUProcessing::call_probe_GPU(QueryParams* params, int** &off_col, int* &d_to
     output_estimate = *h_total * output_selectivity;
     for (int i = 0; i < cm->TOT_TABLE; i++) {
       if (off_col[i] != NULL || i == 0 || qo->joinGPUcheck[i]) {
-        if (!custom) CubDebugExit(cudaMalloc((void**) &off_col_out[i], output_estimate * sizeof(int)));
-        if (custom) off_col_out[i] = (int*) cm->customCudaMalloc<int>(output_estimate);
+        if (!custom) CubDebugExit(deviceMalloc((void**) &off_col_out[i], output_estimate * sizeof(int)));
+        if (custom) off_col_out[i] = (int*) cm->customCudaMalloc<int>(output_estimate, scope);
       }
     }
   }
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
   malloc_time[sg] += time;
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   if (off_col == NULL) {
 
@@ -1095,18 +1387,22 @@ CPUGPUProcessing::call_probe_GPU(QueryParams* params, int** &off_col, int* &d_to
 
     short* d_segment_group;
     // d_segment_group = reinterpret_cast<short*>(cm->customCudaMalloc(cm->lo_orderdate->total_segment));
-    if (custom) d_segment_group = (short*) cm->customCudaMalloc<short>(cm->lo_orderdate->total_segment);
-    else CubDebugExit(cudaMalloc((void**) &d_segment_group, cm->lo_orderdate->total_segment * sizeof(short)));
+    if (custom) d_segment_group = (short*) cm->customCudaMalloc<short>(cm->lo_orderdate->total_segment, scope);
+    else CubDebugExit(deviceMalloc((void**) &d_segment_group, cm->lo_orderdate->total_segment * sizeof(short)));
     short* segment_group_ptr = qo->segment_group[0] + (sg * cm->lo_orderdate->total_segment);
-    CubDebugExit(cudaMemcpyAsync(d_segment_group, segment_group_ptr, qo->segment_group_count[0][sg] * sizeof(short), cudaMemcpyHostToDevice, stream));
+    CubDebugExit(deviceMemcpyAsync(d_segment_group, segment_group_ptr, qo->segment_group_count[0][sg] * sizeof(short), cudaMemcpyHostToDevice, stream));
     cpu_to_gpu[sg] += (qo->segment_group_count[0][sg] * sizeof(short));
 
-    probe_GPU2<128,4><<<(LEN+ tile_items - 1)/tile_items, 128, 0, stream>>>(
+    if (deviceIsHost()) {
+      probe_CPU(hostProbeArgs(pargs), hostOffset(out_off), LEN, d_total, 0, d_segment_group);
+    } else {
+      probe_GPU2<128,4><<<(LEN+ tile_items - 1)/tile_items, 128, 0, stream>>>(
       cm->gpuCache, pargs, out_off, LEN, d_total, 0, d_segment_group);
+    }
 
     CHECK_ERROR_STREAM(stream);
 
-    if (!custom) cudaFree(d_segment_group);
+    if (!custom) deviceFree(d_segment_group);
 
   } else {
 
@@ -1130,14 +1426,18 @@ CPUGPUProcessing::call_probe_GPU(QueryParams* params, int** &off_col, int* &d_to
 
       CHECK_ERROR_STREAM(stream);
 
-      probe_GPU3<128,4><<<(*h_total + tile_items - 1)/tile_items, 128, 0, stream>>>(
+      if (deviceIsHost()) {
+        probe_CPU2(hostOffset(in_off), hostProbeArgs(pargs), hostOffset(out_off), *h_total, d_total, 0);
+      } else {
+        probe_GPU3<128,4><<<(*h_total + tile_items - 1)/tile_items, 128, 0, stream>>>(
         cm->gpuCache, in_off, pargs, out_off, *h_total, d_total);
+      }
 
       CHECK_ERROR_STREAM(stream);   
 
       if (!custom) {
         for (int i = 0; i < cm->TOT_TABLE; i++) {
-          if (off_col[i] != NULL) cudaFree(off_col[i]);
+          if (off_col[i] != NULL) deviceFree(off_col[i]);
         }
       }   
     // }
@@ -1149,13 +1449,13 @@ CPUGPUProcessing::call_probe_GPU(QueryParams* params, int** &off_col, int* &d_to
   for (int i = 0; i < cm->TOT_TABLE; i++)
     off_col[i] = off_col_out[i];
 
-  CubDebugExit(cudaMemcpyAsync(h_total, d_total, sizeof(int), cudaMemcpyDeviceToHost, stream));
-  CubDebugExit(cudaStreamSynchronize(stream));
+  CubDebugExit(deviceMemcpyAsync(h_total, d_total, sizeof(int), cudaMemcpyDeviceToHost, stream));
+  CubDebugExit(deviceStreamSynchronize(stream));
   gpu_to_cpu[sg] += (1 * sizeof(int));
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
 
   if (verbose) cout << "h_total: " << *h_total << " output_estimate: " << output_estimate << " sg: " << sg  << endl;
   assert(*h_total <= output_estimate);
@@ -1199,14 +1499,14 @@ CPUGPUProcessing::call_probe_CPU(QueryParams* params, int** &h_off_col, int* h_t
 
   float time;
   SETUP_TIMING();
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   if (h_off_col == NULL) {
     output_estimate = SEGMENT_SIZE * qo->segment_group_count[0][sg] * output_selectivity;
     for (int i = 0; i < cm->TOT_TABLE; i++) {
       if (i == 0 || qo->joinCPUcheck[i]) {
-        if (!custom) CubDebugExit(cudaHostAlloc((void**) &off_col_out[i], output_estimate * sizeof(int), cudaHostAllocDefault));
-        if (custom) off_col_out[i] = (int*) cm->customCudaHostAlloc<int>(output_estimate);
+        if (!custom) CubDebugExit(deviceHostAlloc((void**) &off_col_out[i], output_estimate * sizeof(int), cudaHostAllocDefault));
+        if (custom) off_col_out[i] = (int*) cm->customCudaHostAlloc<int>(output_estimate, scope);
       }
     }
   } else {
@@ -1214,17 +1514,17 @@ CPUGPUProcessing::call_probe_CPU(QueryParams* params, int** &h_off_col, int* h_t
     output_estimate = *h_total * output_selectivity;
     for (int i = 0; i < cm->TOT_TABLE; i++) {
       if (h_off_col[i] != NULL || i == 0 || qo->joinCPUcheck[i]) {
-        if (!custom) CubDebugExit(cudaHostAlloc((void**) &off_col_out[i], output_estimate * sizeof(int), cudaHostAllocDefault));
-        if (custom) off_col_out[i] = (int*) cm->customCudaHostAlloc<int>(output_estimate);
+        if (!custom) CubDebugExit(deviceHostAlloc((void**) &off_col_out[i], output_estimate * sizeof(int), cudaHostAllocDefault));
+        if (custom) off_col_out[i] = (int*) cm->customCudaHostAlloc<int>(output_estimate, scope);
       }
     }
   }
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
   malloc_time[sg] += time;
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   if (h_off_col == NULL) {
 
@@ -1275,7 +1575,7 @@ CPUGPUProcessing::call_probe_CPU(QueryParams* params, int** &h_off_col, int* h_t
 
     if (!custom) {
       for (int i = 0; i < cm->TOT_TABLE; i++) {
-        if (h_off_col[i] != NULL) cudaFreeHost(h_off_col[i]);
+        if (h_off_col[i] != NULL) deviceFreeHost(h_off_col[i]);
       }
     }
 
@@ -1288,9 +1588,9 @@ CPUGPUProcessing::call_probe_CPU(QueryParams* params, int** &h_off_col, int* h_t
 
   *h_total = out_total;
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
 
   if (verbose) cout << "h_total: " << *h_total << " output_estimate: " << output_estimate << " sg: " << sg  << endl;
   assert(*h_total <= output_estimate);
@@ -1315,12 +1615,12 @@ CPUGPUProcessing::call_pfilter_GPU(QueryParams* params, int** &off_col, int* &d_
 
   off_col_out = new int*[cm->TOT_TABLE] (); //initialize to NULL
 
-  CubDebugExit(cudaMemsetAsync(d_total, 0, sizeof(int), stream));
+  CubDebugExit(deviceMemsetAsync(d_total, 0, sizeof(int), stream));
 
   for (int i = 0; i < qo->selectGPUPipelineCol[sg].size(); i++) {
     if (select_so_far == qo->select_probe[cm->lo_orderdate].size()) break;
     ColumnInfo* column = qo->selectGPUPipelineCol[sg][i];
-    cm->indexTransfer(col_idx, column, stream, custom);
+    cm->indexTransfer(col_idx, column, stream, custom, scope);
     cpu_to_gpu[sg] += (column->total_segment * sizeof(int));
     filter_idx[select_so_far + i] = col_idx[column->column_id];
     _compare1[select_so_far + i] = params->compare1[column];
@@ -1341,28 +1641,28 @@ CPUGPUProcessing::call_pfilter_GPU(QueryParams* params, int** &off_col, int* &d_
 
   float time;
   SETUP_TIMING();
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   if (off_col == NULL) {
     output_estimate = SEGMENT_SIZE * qo->segment_group_count[0][sg] * output_selectivity;
-    if (!custom) CubDebugExit(cudaMalloc((void**) &off_col_out[0], output_estimate * sizeof(int)));
-    if (custom) off_col_out[0] = (int*) cm->customCudaMalloc<int>(output_estimate);
+    if (!custom) CubDebugExit(deviceMalloc((void**) &off_col_out[0], output_estimate * sizeof(int)));
+    if (custom) off_col_out[0] = (int*) cm->customCudaMalloc<int>(output_estimate, scope);
   } else {
     assert(*h_total > 0);
     output_estimate = *h_total * output_selectivity;
     for (int i = 0; i < cm->TOT_TABLE; i++) {
       if (off_col[i] != NULL || i == 0) {
-        if (!custom) CubDebugExit(cudaMalloc((void**) &off_col_out[i], output_estimate * sizeof(int)));
-        if (custom) off_col_out[i] = (int*) cm->customCudaMalloc<int>(output_estimate);
+        if (!custom) CubDebugExit(deviceMalloc((void**) &off_col_out[i], output_estimate * sizeof(int)));
+        if (custom) off_col_out[i] = (int*) cm->customCudaMalloc<int>(output_estimate, scope);
       }
     }
   }
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
   malloc_time[sg] += time;
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   if (off_col == NULL) {
 
@@ -1380,18 +1680,22 @@ CPUGPUProcessing::call_pfilter_GPU(QueryParams* params, int** &off_col, int* &d_
 
     short* d_segment_group;
     // d_segment_group = reinterpret_cast<short*>(cm->customCudaMalloc(cm->lo_orderdate->total_segment));
-    if (custom) d_segment_group = (short*) cm->customCudaMalloc<short>(cm->lo_orderdate->total_segment);
-    else CubDebugExit(cudaMalloc((void**) &d_segment_group, cm->lo_orderdate->total_segment * sizeof(short)));
+    if (custom) d_segment_group = (short*) cm->customCudaMalloc<short>(cm->lo_orderdate->total_segment, scope);
+    else CubDebugExit(deviceMalloc((void**) &d_segment_group, cm->lo_orderdate->total_segment * sizeof(short)));
     short* segment_group_ptr = qo->segment_group[0] + (sg * cm->lo_orderdate->total_segment);
-    CubDebugExit(cudaMemcpyAsync(d_segment_group, segment_group_ptr, qo->segment_group_count[0][sg] * sizeof(short), cudaMemcpyHostToDevice, stream));
+    CubDebugExit(deviceMemcpyAsync(d_segment_group, segment_group_ptr, qo->segment_group_count[0][sg] * sizeof(short), cudaMemcpyHostToDevice, stream));
     cpu_to_gpu[sg] += (qo->segment_group_count[0][sg] * sizeof(short));
 
-    filter_GPU2<128,4><<<(LEN + tile_items - 1)/tile_items, 128, 0, stream>>>(
+    if (deviceIsHost()) {
+      filter_CPU(hostFilterArgs(params, fargs), off_col_out[0], LEN, d_total, 0, d_segment_group);
+    } else {
+      filter_GPU2<128,4><<<(LEN + tile_items - 1)/tile_items, 128, 0, stream>>>(
       cm->gpuCache, fargs, off_col_out[0], LEN, d_total, 0, d_segment_group);
+    }
 
     CHECK_ERROR_STREAM(stream);
 
-    if (!custom) cudaFree(d_segment_group);
+    if (!custom) deviceFree(d_segment_group);
 
   } else {
 
@@ -1405,14 +1709,18 @@ CPUGPUProcessing::call_pfilter_GPU(QueryParams* params, int** &off_col, int* &d_
     //   }
     // }
 
-    filter_GPU3<128,4><<<(*h_total + tile_items - 1)/tile_items, 128, 0, stream>>>
+    if (deviceIsHost()) {
+      filter_CPU2(off_col[0], hostFilterArgs(params, fargs), off_col_out[0], *h_total, d_total, 0);
+    } else {
+      filter_GPU3<128,4><<<(*h_total + tile_items - 1)/tile_items, 128, 0, stream>>>
       (cm->gpuCache, off_col[0], fargs, off_col_out[0], *h_total, d_total);
+    }
 
     CHECK_ERROR_STREAM(stream);
 
     if (!custom) {
       for (int i = 0; i < cm->TOT_TABLE; i++) {
-        if (off_col[i] != NULL) cudaFree(off_col[i]);
+        if (off_col[i] != NULL) deviceFree(off_col[i]);
       }
     }
 
@@ -1423,17 +1731,17 @@ CPUGPUProcessing::call_pfilter_GPU(QueryParams* params, int** &off_col, int* &d_
   for (int i = 0; i < cm->TOT_TABLE; i++)
     off_col[i] = off_col_out[i];
 
-  CubDebugExit(cudaMemcpyAsync(h_total, d_total, sizeof(int), cudaMemcpyDeviceToHost, stream));
-  CubDebugExit(cudaStreamSynchronize(stream));
+  CubDebugExit(deviceMemcpyAsync(h_total, d_total, sizeof(int), cudaMemcpyDeviceToHost, stream));
+  CubDebugExit(deviceStreamSynchronize(stream));
   gpu_to_cpu[sg] += (1 * sizeof(int));
 
   if (verbose) cout << "h_total: " << *h_total << " output_estimate: " << output_estimate << " sg: " << sg  << endl;
   assert(*h_total <= output_estimate);
   assert(*h_total > 0);
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
 
   if (verbose) cout << "Filter Kernel time GPU: " << time << endl;
   gpu_time[sg] += time;
@@ -1471,17 +1779,21 @@ CPUGPUProcessing::call_pfilter_CPU(QueryParams* params, int** &h_off_col, int* h
     _compare1[0], _compare2[0], _compare1[1], _compare2[1],
     _mode[0], _mode[1], 
     (filter_col[0] != NULL) ? (params->map_filter_func_host[filter_col[0]]) : (NULL), 
-    (filter_col[1] != NULL) ? (params->map_filter_func_host[filter_col[1]]) : (NULL)
+    (filter_col[1] != NULL) ? (params->map_filter_func_host[filter_col[1]]) : (NULL),
+    (filter_col[0] != NULL) ? (filter_col[0]->pack) : (NULL),
+    (filter_col[1] != NULL) ? (filter_col[1]->pack) : (NULL),
+    (filter_col[0] != NULL) ? (filter_col[0]->slice) : (NULL),
+    (filter_col[1] != NULL) ? (filter_col[1]->slice) : (NULL)
   };
 
   float time;
   SETUP_TIMING();
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   if (h_off_col == NULL) {
     output_estimate = SEGMENT_SIZE * qo->segment_group_count[0][sg] * output_selectivity;
-    if (!custom) CubDebugExit(cudaHostAlloc((void**) &off_col_out[0], output_estimate * sizeof(int), cudaHostAllocDefault));
-    if (custom) off_col_out[0] = (int*) cm->customCudaHostAlloc<int>(output_estimate);
+    if (!custom) CubDebugExit(deviceHostAlloc((void**) &off_col_out[0], output_estimate * sizeof(int), cudaHostAllocDefault));
+    if (custom) off_col_out[0] = (int*) cm->customCudaHostAlloc<int>(output_estimate, scope);
   } else {
     assert(filter_col[0] == NULL);
     assert(filter_col[1] != NULL);
@@ -1489,17 +1801,17 @@ CPUGPUProcessing::call_pfilter_CPU(QueryParams* params, int** &h_off_col, int* h
     output_estimate = *h_total * output_selectivity;
     for (int i = 0; i < cm->TOT_TABLE; i++) {
       if (h_off_col[i] != NULL || i == 0) {
-        if (!custom) CubDebugExit(cudaHostAlloc((void**) &off_col_out[i], output_estimate * sizeof(int), cudaHostAllocDefault));
-        if (custom) off_col_out[i] = (int*) cm->customCudaHostAlloc<int>(output_estimate);
+        if (!custom) CubDebugExit(deviceHostAlloc((void**) &off_col_out[i], output_estimate * sizeof(int), cudaHostAllocDefault));
+        if (custom) off_col_out[i] = (int*) cm->customCudaHostAlloc<int>(output_estimate, scope);
       }
     }
   }
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
   malloc_time[sg] += time;
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   if (h_off_col == NULL) {
 
@@ -1535,7 +1847,7 @@ CPUGPUProcessing::call_pfilter_CPU(QueryParams* params, int** &h_off_col, int* h
 
     if (!custom) {
       for (int i = 0; i < cm->TOT_TABLE; i++) {
-        if (h_off_col[i] != NULL) cudaFreeHost(h_off_col[i]);
+        if (h_off_col[i] != NULL) deviceFreeHost(h_off_col[i]);
       }
     }
 
@@ -1552,9 +1864,9 @@ CPUGPUProcessing::call_pfilter_CPU(QueryParams* params, int** &h_off_col, int* h
   assert(*h_total <= output_estimate);
   assert(*h_total > 0);
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
 
   if (verbose) cout << "Filter Kernel time CPU: " << time << endl;
   cpu_time[sg] += time;
@@ -1578,7 +1890,7 @@ CPUGPUProcessing::call_bfilter_build_GPU(QueryParams* params, int* &d_off_col, i
     if (qo->groupby_build.size() > 0 && qo->groupby_build[column].size() > 0) {
       if (qo->groupGPUcheck) {
         ColumnInfo* group_col = qo->groupby_build[column][0];
-        cm->indexTransfer(col_idx, group_col, stream, custom);
+        cm->indexTransfer(col_idx, group_col, stream, custom, scope);
         cpu_to_gpu[sg] += (group_col->total_segment * sizeof(int));
         group_idx = col_idx[group_col->column_id];
       }
@@ -1586,12 +1898,12 @@ CPUGPUProcessing::call_bfilter_build_GPU(QueryParams* params, int* &d_off_col, i
 
     if (qo->select_build[column].size() > 0) {
       filter_col = qo->select_build[column][0];
-      cm->indexTransfer(col_idx, filter_col, stream, custom);
+      cm->indexTransfer(col_idx, filter_col, stream, custom, scope);
       cpu_to_gpu[sg] += (filter_col->total_segment * sizeof(int));
       filter_idx = col_idx[filter_col->column_id];
     }
 
-    cm->indexTransfer(col_idx, column, stream, custom);
+    cm->indexTransfer(col_idx, column, stream, custom, scope);
     cpu_to_gpu[sg] += (column->total_segment * sizeof(int));
 
     dimkey_idx = col_idx[column->column_id];
@@ -1610,7 +1922,7 @@ CPUGPUProcessing::call_bfilter_build_GPU(QueryParams* params, int* &d_off_col, i
 
     SETUP_TIMING();
     float time;
-    cudaEventRecord(start, 0);
+    deviceEventRecord(start, 0);
 
     if (d_off_col == NULL) {
 
@@ -1623,33 +1935,41 @@ CPUGPUProcessing::call_bfilter_build_GPU(QueryParams* params, int* &d_off_col, i
 
       short* d_segment_group;
       // d_segment_group = reinterpret_cast<short*>(cm->customCudaMalloc(column->total_segment));
-      if (custom) d_segment_group = (short*) cm->customCudaMalloc<short>(column->total_segment);
-      else CubDebugExit(cudaMalloc((void**) &d_segment_group, column->total_segment * sizeof(short)));
+      if (custom) d_segment_group = (short*) cm->customCudaMalloc<short>(column->total_segment, scope);
+      else CubDebugExit(deviceMalloc((void**) &d_segment_group, column->total_segment * sizeof(short)));
       short* segment_group_ptr = qo->segment_group[table] + (sg * column->total_segment);
-      CubDebugExit(cudaMemcpyAsync(d_segment_group, segment_group_ptr, qo->segment_group_count[table][sg] * sizeof(short), cudaMemcpyHostToDevice, stream));
+      CubDebugExit(deviceMemcpyAsync(d_segment_group, segment_group_ptr, qo->segment_group_count[table][sg] * sizeof(short), cudaMemcpyHostToDevice, stream));
       cpu_to_gpu[sg] += (qo->segment_group_count[table][sg] * sizeof(short));
 
-      build_GPU2<128,4><<<(LEN + tile_items - 1)/tile_items, 128, 0, stream>>>(
+      if (deviceIsHost()) {
+        build_CPU(hostFilterArgs(params, fargs), hostBuildArgs(bargs), LEN, params->ht_GPU[column], 0, d_segment_group);
+      } else {
+        build_GPU2<128,4><<<(LEN + tile_items - 1)/tile_items, 128, 0, stream>>>(
         cm->gpuCache, fargs, bargs, LEN, params->ht_GPU[column], 0, d_segment_group);
+      }
 
       CHECK_ERROR_STREAM(stream);
 
-      if (!custom) cudaFree(d_segment_group);
+      if (!custom) deviceFree(d_segment_group);
 
     } else {
 
-      build_GPU3<128,4><<<(*h_total + tile_items - 1)/tile_items, 128, 0, stream>>>(
+      if (deviceIsHost()) {
+        build_CPU2(d_off_col, hostFilterArgs(params, fargs), hostBuildArgs(bargs), *h_total, params->ht_GPU[column], 0);
+      } else {
+        build_GPU3<128,4><<<(*h_total + tile_items - 1)/tile_items, 128, 0, stream>>>(
         cm->gpuCache, d_off_col, fargs, bargs, *h_total, params->ht_GPU[column]);
+      }
 
       CHECK_ERROR_STREAM(stream);
 
-      if (!custom) cudaFree(d_off_col);
+      if (!custom) deviceFree(d_off_col);
         
     }
 
-    cudaEventRecord(stop, 0);
-    cudaEventSynchronize(stop);
-    cudaEventElapsedTime(&time, start, stop);
+    deviceEventRecord(stop, 0);
+    deviceEventSynchronize(stop);
+    deviceEventElapsedTime(&time, start, stop);
 
     if (verbose) cout << "Filter Build Kernel time GPU: " << time << endl;
     gpu_time[sg] += time;
@@ -1693,7 +2013,7 @@ CPUGPUProcessing::call_bfilter_build_CPU(QueryParams* params, int* &h_off_col, i
 
     SETUP_TIMING();
     float time;
-    cudaEventRecord(start, 0);
+    deviceEventRecord(start, 0);
 
     if (h_off_col == NULL) {
 
@@ -1712,13 +2032,13 @@ CPUGPUProcessing::call_bfilter_build_CPU(QueryParams* params, int* &h_off_col, i
 
       build_CPU2(h_off_col, fargs, bargs, *h_total, params->ht_CPU[column], 0);
 
-      if (!custom) cudaFreeHost(h_off_col);
+      if (!custom) deviceFreeHost(h_off_col);
 
     }
 
-    cudaEventRecord(stop, 0);
-    cudaEventSynchronize(stop);
-    cudaEventElapsedTime(&time, start, stop);
+    deviceEventRecord(stop, 0);
+    deviceEventSynchronize(stop);
+    deviceEventElapsedTime(&time, start, stop);
 
     if (verbose) cout << "Filter Build Kernel time CPU: " << time << endl;
     cpu_time[sg] += time;
@@ -1743,13 +2063,13 @@ CPUGPUProcessing::call_build_GPU(QueryParams* params, int* &d_off_col, int* h_to
     if (qo->groupby_build.size() > 0 && qo->groupby_build[column].size() > 0) {
       if (qo->groupGPUcheck) {
         ColumnInfo* group_col = qo->groupby_build[column][0];
-        cm->indexTransfer(col_idx, group_col, stream, custom);
+        cm->indexTransfer(col_idx, group_col, stream, custom, scope);
         cpu_to_gpu[sg] += (group_col->total_segment * sizeof(int));
         group_idx = col_idx[group_col->column_id];
       }
     }
 
-    cm->indexTransfer(col_idx, column, stream, custom);
+    cm->indexTransfer(col_idx, column, stream, custom, scope);
     cpu_to_gpu[sg] += (column->total_segment * sizeof(int));
 
     dimkey_idx = col_idx[column->column_id];
@@ -1763,7 +2083,7 @@ CPUGPUProcessing::call_build_GPU(QueryParams* params, int* &d_off_col, int* h_to
 
     SETUP_TIMING();
     float time;
-    cudaEventRecord(start, 0);
+    deviceEventRecord(start, 0);
 
     if (d_off_col == NULL) {
 
@@ -1776,33 +2096,41 @@ CPUGPUProcessing::call_build_GPU(QueryParams* params, int* &d_off_col, int* h_to
 
       short* d_segment_group;
       // d_segment_group = reinterpret_cast<short*>(cm->customCudaMalloc(column->total_segment));
-      if (custom) d_segment_group = (short*) cm->customCudaMalloc<short>(column->total_segment);
-      else CubDebugExit(cudaMalloc((void**) &d_segment_group, column->total_segment * sizeof(short)));
+      if (custom) d_segment_group = (short*) cm->customCudaMalloc<short>(column->total_segment, scope);
+      else CubDebugExit(deviceMalloc((void**) &d_segment_group, column->total_segment * sizeof(short)));
       short* segment_group_ptr = qo->segment_group[table] + (sg * column->total_segment);
-      CubDebugExit(cudaMemcpyAsync(d_segment_group, segment_group_ptr, qo->segment_group_count[table][sg] * sizeof(short), cudaMemcpyHostToDevice, stream));
+      CubDebugExit(deviceMemcpyAsync(d_segment_group, segment_group_ptr, qo->segment_group_count[table][sg] * sizeof(short), cudaMemcpyHostToDevice, stream));
       cpu_to_gpu[sg] += (qo->segment_group_count[table][sg] * sizeof(short));
 
-      build_GPU2<128,4><<<(LEN + tile_items - 1)/tile_items, 128, 0, stream>>>(
+      if (deviceIsHost()) {
+        build_CPU(hostFilterArgs(params, fargs), hostBuildArgs(bargs), LEN, params->ht_GPU[column], 0, d_segment_group);
+      } else {
+        build_GPU2<128,4><<<(LEN + tile_items - 1)/tile_items, 128, 0, stream>>>(
         cm->gpuCache, fargs, bargs, LEN, params->ht_GPU[column], 0, d_segment_group);
+      }
 
       CHECK_ERROR_STREAM(stream);
 
-      if (!custom) cudaFree(d_segment_group);
+      if (!custom) deviceFree(d_segment_group);
 
     } else {
 
-      build_GPU3<128,4><<<(*h_total + tile_items - 1)/tile_items, 128, 0, stream>>>(
+      if (deviceIsHost()) {
+        build_CPU2(d_off_col, hostFilterArgs(params, fargs), hostBuildArgs(bargs), *h_total, params->ht_GPU[column], 0);
+      } else {
+        build_GPU3<128,4><<<(*h_total + tile_items - 1)/tile_items, 128, 0, stream>>>(
         cm->gpuCache, d_off_col, fargs, bargs, *h_total, params->ht_GPU[column]);
+      }
 
       CHECK_ERROR_STREAM(stream);
 
-      if (!custom) cudaFree(d_off_col);
+      if (!custom) deviceFree(d_off_col);
 
     }
 
-    cudaEventRecord(stop, 0);
-    cudaEventSynchronize(stop);
-    cudaEventElapsedTime(&time, start, stop);
+    deviceEventRecord(stop, 0);
+    deviceEventSynchronize(stop);
+    deviceEventElapsedTime(&time, start, stop);
 
     if (verbose) cout << "Build Kernel time GPU: " << time << endl;
     gpu_time[sg] += time;
@@ -1836,7 +2164,7 @@ CPUGPUProcessing::call_build_CPU(QueryParams* params, int* &h_off_col, int* h_to
 
     SETUP_TIMING();
     float time;
-    cudaEventRecord(start, 0);
+    deviceEventRecord(start, 0);
 
     if (h_off_col == NULL) {
 
@@ -1855,13 +2183,13 @@ CPUGPUProcessing::call_build_CPU(QueryParams* params, int* &h_off_col, int* h_to
 
       build_CPU2(h_off_col, fargs, bargs, *h_total, params->ht_CPU[column], 0);
 
-      if (!custom) cudaFreeHost(h_off_col);
+      if (!custom) deviceFreeHost(h_off_col);
 
     }
 
-    cudaEventRecord(stop, 0);
-    cudaEventSynchronize(stop);
-    cudaEventElapsedTime(&time, start, stop);
+    deviceEventRecord(stop, 0);
+    deviceEventSynchronize(stop);
+    deviceEventElapsedTime(&time, start, stop);
 
     if (verbose) cout << "Build Kernel time CPU: " << time << endl;
     cpu_time[sg] += time;
@@ -1890,19 +2218,19 @@ CPUGPUProcessing::call_bfilter_GPU(QueryParams* params, int* &d_off_col, int* &d
 
   SETUP_TIMING();
   float time;
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
   
   // d_off_col = (int*) cm->customCudaMalloc<int>(output_estimate);
-  if (custom) d_off_col = (int*) cm->customCudaMalloc<int>(output_estimate);
-  else CubDebugExit(cudaMalloc((void**) &d_off_col, output_estimate * sizeof(int)));
+  if (custom) d_off_col = (int*) cm->customCudaMalloc<int>(output_estimate, scope);
+  else CubDebugExit(deviceMalloc((void**) &d_off_col, output_estimate * sizeof(int)));
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
   malloc_time[sg] += time;
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
-  CubDebugExit(cudaMemsetAsync(d_total, 0, sizeof(int), stream));
+  CubDebugExit(deviceMemsetAsync(d_total, 0, sizeof(int), stream));
 
   int LEN;
   if (sg == qo->last_segment[table]) {
@@ -1911,7 +2239,7 @@ CPUGPUProcessing::call_bfilter_GPU(QueryParams* params, int* &d_off_col, int* &d
     LEN = qo->segment_group_count[table][sg] * SEGMENT_SIZE;
   }
 
-  cm->indexTransfer(col_idx, column, stream, custom);
+  cm->indexTransfer(col_idx, column, stream, custom, scope);
   cpu_to_gpu[sg] += (column->total_segment * sizeof(int));
   int* filter_idx = col_idx[column->column_id];
 
@@ -1923,30 +2251,34 @@ CPUGPUProcessing::call_bfilter_GPU(QueryParams* params, int* &d_off_col, int* &d
 
   short* d_segment_group;
   // d_segment_group = reinterpret_cast<short*>(cm->customCudaMalloc(column->total_segment));
-  if (custom) d_segment_group = (short*) cm->customCudaMalloc<short>(column->total_segment);
-  else CubDebugExit(cudaMalloc((void**) &d_segment_group, column->total_segment * sizeof(short)));
+  if (custom) d_segment_group = (short*) cm->customCudaMalloc<short>(column->total_segment, scope);
+  else CubDebugExit(deviceMalloc((void**) &d_segment_group, column->total_segment * sizeof(short)));
   short* segment_group_ptr = qo->segment_group[table] + (sg * column->total_segment);
-  CubDebugExit(cudaMemcpyAsync(d_segment_group, segment_group_ptr, qo->segment_group_count[table][sg] * sizeof(short), cudaMemcpyHostToDevice, stream));
+  CubDebugExit(deviceMemcpyAsync(d_segment_group, segment_group_ptr, qo->segment_group_count[table][sg] * sizeof(short), cudaMemcpyHostToDevice, stream));
   cpu_to_gpu[sg] += (qo->segment_group_count[table][sg] * sizeof(short));
 
-  filter_GPU2<128,4> <<<(LEN + tile_items - 1)/tile_items, 128, 0, stream>>>(
+  if (deviceIsHost()) {
+    filter_CPU(hostFilterArgs(params, fargs), d_off_col, LEN, d_total, 0, d_segment_group);
+  } else {
+    filter_GPU2<128,4> <<<(LEN + tile_items - 1)/tile_items, 128, 0, stream>>>(
     cm->gpuCache, fargs, d_off_col, LEN, d_total, 0, d_segment_group);
+  }
 
   CHECK_ERROR_STREAM(stream);
 
-  CubDebugExit(cudaMemcpyAsync(h_total, d_total, sizeof(int), cudaMemcpyDeviceToHost, stream));
-  CubDebugExit(cudaStreamSynchronize(stream));
+  CubDebugExit(deviceMemcpyAsync(h_total, d_total, sizeof(int), cudaMemcpyDeviceToHost, stream));
+  CubDebugExit(deviceStreamSynchronize(stream));
   gpu_to_cpu[sg] += (1 * sizeof(int));
 
-  if (!custom) cudaFree(d_segment_group);
+  if (!custom) deviceFree(d_segment_group);
 
   if (verbose) cout << "h_total: " << *h_total << " output_estimate: " << output_estimate << " sg: " << sg  << endl;
   assert(*h_total <= output_estimate);
   assert(*h_total > 0);
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
 
   if (verbose) cout << "Filter Kernel time GPU: " << time << endl;
   gpu_time[sg] += time;
@@ -1973,16 +2305,16 @@ CPUGPUProcessing::call_bfilter_CPU(QueryParams* params, int* &h_off_col, int* h_
 
   SETUP_TIMING();
   float time;
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
-  if (custom) h_off_col = (int*) cm->customCudaHostAlloc<int>(output_estimate);
-  else CubDebugExit(cudaHostAlloc((void**) &h_off_col, output_estimate * sizeof(int), cudaHostAllocDefault));
+  if (custom) h_off_col = (int*) cm->customCudaHostAlloc<int>(output_estimate, scope);
+  else CubDebugExit(deviceHostAlloc((void**) &h_off_col, output_estimate * sizeof(int), cudaHostAllocDefault));
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
   malloc_time[sg] += time;
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   int LEN;
   if (sg == qo->last_segment[table]) {
@@ -1994,7 +2326,9 @@ CPUGPUProcessing::call_bfilter_CPU(QueryParams* params, int* &h_off_col, int* h_
   struct filterArgsCPU fargs = {
     filter_col, NULL,
     params->compare1[column], params->compare2[column], 0, 0,
-    params->mode[column], 0, params->map_filter_func_host[column], NULL
+    params->mode[column], 0, params->map_filter_func_host[column], NULL,
+    column->pack, NULL,
+    column->slice, NULL
   };
 
   short* segment_group_ptr = qo->segment_group[table] + (sg * column->total_segment);
@@ -2005,9 +2339,9 @@ CPUGPUProcessing::call_bfilter_CPU(QueryParams* params, int* &h_off_col, int* h_
   assert(*h_total <= output_estimate);
   assert(*h_total > 0);
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
 
   if (verbose) cout << "Filter Kernel time CPU: " << time << endl;
   cpu_time[sg] += time;
@@ -2024,7 +2358,7 @@ CPUGPUProcessing::call_group_by_GPU(QueryParams* params, int** &off_col, int* h_
 
   for (int i = 0; i < qo->aggregation[cm->lo_orderdate].size(); i++) {
     ColumnInfo* column = qo->aggregation[cm->lo_orderdate][i];
-    cm->indexTransfer(col_idx, column, stream, custom);
+    cm->indexTransfer(col_idx, column, stream, custom, scope);
     cpu_to_gpu[sg] += (column->total_segment * sizeof(int));
     aggr_idx[i] = col_idx[column->column_id];
   }
@@ -2034,7 +2368,7 @@ CPUGPUProcessing::call_group_by_GPU(QueryParams* params, int** &off_col, int* h_
     if (it->second.size() > 0) {
       ColumnInfo* column = it->second[0];
       ColumnInfo* column_key = it->first;
-      cm->indexTransfer(col_idx, column, stream, custom);
+      cm->indexTransfer(col_idx, column, stream, custom, scope);
       cpu_to_gpu[sg] += (column->total_segment * sizeof(int));
       group_idx[column_key->table_id - 1] = col_idx[column->column_id];
       _min_val[column_key->table_id - 1] = params->min_val[column_key];
@@ -2055,24 +2389,28 @@ CPUGPUProcessing::call_group_by_GPU(QueryParams* params, int** &off_col, int* h_
 
   SETUP_TIMING();
   float time;
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   if (*h_total > 0) {
-    groupByGPU<128,4><<<(*h_total + tile_items - 1)/tile_items, 128, 0, stream>>>(
+    if (deviceIsHost()) {
+      groupByCPU(hostOffset(offset), hostGroupbyArgs(params, gargs), *h_total, params->d_res);
+    } else {
+      groupByGPU<128,4><<<(*h_total + tile_items - 1)/tile_items, 128, 0, stream>>>(
       cm->gpuCache, offset, gargs, *h_total, params->d_res);
+    }
   }
 
   CHECK_ERROR_STREAM(stream);
 
   if (!custom) {
     for (int i = 0; i < cm->TOT_TABLE; i++) {
-      if (off_col[i] != NULL) cudaFree(off_col[i]);
+      if (off_col[i] != NULL) deviceFree(off_col[i]);
     }
   }
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
 
   if (verbose) cout << "Group Kernel time GPU: " << time << endl;
   gpu_time[sg] += time;
@@ -2114,19 +2452,19 @@ CPUGPUProcessing::call_group_by_CPU(QueryParams* params, int** &h_off_col, int*
 
   SETUP_TIMING();
   float time;
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   if (*h_total > 0) groupByCPU(offset, gargs, *h_total, params->res);
 
   if (!custom) {
     for (int i = 0; i < cm->TOT_TABLE; i++) {
-      if (h_off_col[i] != NULL) cudaFreeHost(h_off_col[i]);
+      if (h_off_col[i] != NULL) deviceFreeHost(h_off_col[i]);
     }
   }
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
 
   if (verbose) cout << "Group Kernel time CPU: " << time << endl;
   cpu_time[sg] += time;
@@ -2143,7 +2481,7 @@ CPUGPUProcessing::call_aggregation_GPU(QueryParams* params, int* &off_col, int*
 
   for (int i = 0; i < qo->aggregation[cm->lo_orderdate].size(); i++) {
     ColumnInfo* column = qo->aggregation[cm->lo_orderdate][i];
-    cm->indexTransfer(col_idx, column, stream, custom);
+    cm->indexTransfer(col_idx, column, stream, custom, scope);
     cpu_to_gpu[sg] += (column->total_segment * sizeof(int));
     aggr_idx[i] = col_idx[column->column_id];
   }
@@ -2157,20 +2495,24 @@ CPUGPUProcessing::call_aggregation_GPU(QueryParams* params, int* &off_col, int*
 
   SETUP_TIMING();
   float time;
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   if (*h_total > 0) {
-    aggregationGPU<128,4><<<(*h_total + tile_items - 1)/tile_items, 128, 0, stream>>>(
-    cm->gpuCache, off_col, gargs, *h_total, params->d_res);
+    if (deviceIsHost()) {
+      aggregationCPU(off_col, hostGroupbyArgs(params, gargs), *h_total, params->d_res);
+    } else {
+      aggregationGPU<128,4><<<(*h_total + tile_items - 1)/tile_items, 128, 0, stream>>>(
+        cm->gpuCache, off_col, gargs, *h_total, params->d_res);
+    }
   }
 
   CHECK_ERROR_STREAM(stream);
 
-  if (!custom) cudaFree(off_col);
+  if (!custom) deviceFree(off_col);
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
 
   if (verbose) cout << "Aggr Kernel time GPU: " << time << endl;
   gpu_time[sg] += time;
@@ -2196,17 +2538,17 @@ CPUGPUProcessing::call_aggregation_CPU(QueryParams* params, int* &h_off_col, int
 
   SETUP_TIMING();
   float time;
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   // assert(h_off_col != NULL);
 
   if (*h_total > 0) aggregationCPU(h_off_col, gargs, *h_total, params->res);
 
-  if (!custom) cudaFree(h_off_col);
+  if (!custom) deviceFree(h_off_col);
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
 
   if (verbose) cout << "Aggr Kernel time CPU: " << time << endl;
   cpu_time[sg] += time;
@@ -2224,7 +2566,7 @@ CPUGPUProcessing::call_probe_aggr_GPU(QueryParams* params, int** &off_col, int*
     ColumnInfo* column = qo->joinGPUPipelineCol[sg][i];
     int table_id = qo->fkey_pkey[column]->table_id;
     ColumnInfo* pkey = qo->fkey_pkey[column];
-    cm->indexTransfer(col_idx, column, stream, custom);
+    cm->indexTransfer(col_idx, column, stream, custom, scope);
     cpu_to_gpu[sg] += (column->total_segment * sizeof(int));
     assert(col_idx[column->column_id] != NULL);
     fkey_idx[table_id - 1] = col_idx[column->column_id];
@@ -2235,7 +2577,7 @@ CPUGPUProcessing::call_probe_aggr_GPU(QueryParams* params, int** &off_col, int*
 
   for (int i = 0; i < qo->aggregation[cm->lo_orderdate].size(); i++) {
     ColumnInfo* column = qo->aggregation[cm->lo_orderdate][i];
-    cm->indexTransfer(col_idx, column, stream, custom);
+    cm->indexTransfer(col_idx, column, stream, custom, scope);
     cpu_to_gpu[sg] += (column->total_segment * sizeof(int));
     aggr_idx[i] = col_idx[column->column_id];
   }
@@ -2254,11 +2596,11 @@ CPUGPUProcessing::call_probe_aggr_GPU(QueryParams* params, int** &off_col, int*
     0, params->mode_group, params->d_group_func
   };
 
-  cudaEvent_t start, stop;
+  deviceEvent_t start, stop;
   float time;
-  cudaEventCreate(&start);
-  cudaEventCreate(&stop);
-  cudaEventRecord(start, 0);
+  deviceEventCreate(&start);
+  deviceEventCreate(&stop);
+  deviceEventRecord(start, 0);
 
   if (off_col == NULL) {
 
@@ -2271,18 +2613,22 @@ CPUGPUProcessing::call_probe_aggr_GPU(QueryParams* params, int** &off_col, int*
 
     short* d_segment_group;
     // d_segment_group = reinterpret_cast<short*>(cm->customCudaMalloc(cm->lo_orderdate->total_segment));
-    if (custom) d_segment_group = (short*) cm->customCudaMalloc<short>(cm->lo_orderdate->total_segment);
-    else CubDebugExit(cudaMalloc((void**) &d_segment_group, cm->lo_orderdate->total_segment * sizeof(short)));
+    if (custom) d_segment_group = (short*) cm->customCudaMalloc<short>(cm->lo_orderdate->total_segment, scope);
+    else CubDebugExit(deviceMalloc((void**) &d_segment_group, cm->lo_orderdate->total_segment * sizeof(short)));
     short* segment_group_ptr = qo->segment_group[0] + (sg * cm->lo_orderdate->total_segment);
-    CubDebugExit(cudaMemcpyAsync(d_segment_group, segment_group_ptr, qo->segment_group_count[0][sg] * sizeof(short), cudaMemcpyHostToDevice, stream));
+    CubDebugExit(deviceMemcpyAsync(d_segment_group, segment_group_ptr, qo->segment_group_count[0][sg] * sizeof(short), cudaMemcpyHostToDevice, stream));
     cpu_to_gpu[sg] += (qo->segment_group_count[0][sg] * sizeof(short));
 
-    probe_aggr_GPU2<128, 4><<<(LEN + tile_items - 1)/tile_items, 128, 0, stream>>>(
+    if (deviceIsHost()) {
+      probe_aggr_CPU(hostProbeArgs(pargs), hostGroupbyArgs(params, gargs), LEN, params->d_res, 0, d_segment_group);
+    } else {
+      probe_aggr_GPU2<128, 4><<<(LEN + tile_items - 1)/tile_items, 128, 0, stream>>>(
       cm->gpuCache, pargs, gargs, LEN, params->d_res, 0, d_segment_group);
+    }
 
     CHECK_ERROR_STREAM(stream);
 
-    if (!custom) cudaFree(d_segment_group);
+    if (!custom) deviceFree(d_segment_group);
 
   } else {
 
@@ -2290,23 +2636,27 @@ CPUGPUProcessing::call_probe_aggr_GPU(QueryParams* params, int** &off_col, int*
       off_col[0], off_col[1], off_col[2], off_col[3], off_col[4]
     };
 
-    probe_aggr_GPU3<128, 4><<<(*h_total + tile_items - 1)/tile_items, 128, 0, stream>>>(
+    if (deviceIsHost()) {
+      probe_aggr_CPU2(hostOffset(offset), hostProbeArgs(pargs), hostGroupbyArgs(params, gargs), *h_total, params->d_res, 0);
+    } else {
+      probe_aggr_GPU3<128, 4><<<(*h_total + tile_items - 1)/tile_items, 128, 0, stream>>>(
       cm->gpuCache, offset, pargs, gargs, *h_total, params->d_res);
+    }
 
     CHECK_ERROR_STREAM(stream);
 
     if (!custom) {
       for (int i = 0; i < cm->TOT_TABLE; i++) {
-        if (off_col[i] != NULL) cudaFree(off_col[i]);
+        if (off_col[i] != NULL) deviceFree(off_col[i]);
       }
     }
 
   }
 
-  cudaEventRecord(stop, 0);                  // Stop time measuring
-  cudaEventSynchronize(stop);               // Wait until the completion of all device 
-                                            // work preceding the most recent call to cudaEventRecord()
-  cudaEventElapsedTime(&time, start, stop); // Saving the time measured
+  deviceEventRecord(stop, 0);                  // Stop time measuring
+  deviceEventSynchronize(stop);               // Wait until the completion of all device 
+                                            // work preceding the most recent call to deviceEventRecord()
+  deviceEventElapsedTime(&time, start, stop); // Saving the time measured
 
   if (verbose) cout << "Probe Aggr Kernel time GPU: " << time << endl;
   gpu_time[sg] += time;
@@ -2348,11 +2698,11 @@ CPUGPUProcessing::call_probe_aggr_CPU(QueryParams* params, int** &h_off_col, int
     0, params->mode_group, params->h_group_func
   };
 
-  cudaEvent_t start, stop;
+  deviceEvent_t start, stop;
   float time;
-  cudaEventCreate(&start);
-  cudaEventCreate(&stop);
-  cudaEventRecord(start, 0);
+  deviceEventCreate(&start);
+  deviceEventCreate(&stop);
+  deviceEventRecord(start, 0);
 
   if (h_off_col == NULL) {
 
@@ -2375,10 +2725,10 @@ CPUGPUProcessing::call_probe_aggr_CPU(QueryParams* params, int** &h_off_col, int
     probe_aggr_CPU2(offset, pargs, gargs, *h_total, params->res, 0);
   }
 
-  cudaEventRecord(stop, 0);                  // Stop time measuring
-  cudaEventSynchronize(stop);               // Wait until the completion of all device 
-                                            // work preceding the most recent call to cudaEventRecord()
-  cudaEventElapsedTime(&time, start, stop); // Saving the time measured
+  deviceEventRecord(stop, 0);                  // Stop time measuring
+  deviceEventSynchronize(stop);               // Wait until the completion of all device 
+                                            // work preceding the most recent call to deviceEventRecord()
+  deviceEventElapsedTime(&time, start, stop); // Saving the time measured
 
   if (verbose) cout << "Probe Aggr Kernel time CPU: " << time << endl;
   cpu_time[sg] += time;
@@ -2400,7 +2750,7 @@ CPUGPUProcessing::call_pfilter_probe_aggr_GPU(QueryParams* params, int** &off_co
   for (int i = 0; i < qo->selectGPUPipelineCol[sg].size(); i++) {
     if (select_so_far == qo->select_probe[cm->lo_orderdate].size()) break;
     ColumnInfo* column = qo->selectGPUPipelineCol[sg][i];
-    cm->indexTransfer(col_idx, column, stream, custom);
+    cm->indexTransfer(col_idx, column, stream, custom, scope);
     cpu_to_gpu[sg] += (column->total_segment * sizeof(int));
     filter_idx[select_so_far + i] = col_idx[column->column_id];
     _compare1[select_so_far + i] = params->compare1[column];
@@ -2412,7 +2762,7 @@ CPUGPUProcessing::call_pfilter_probe_aggr_GPU(QueryParams* params, int** &off_co
     ColumnInfo* column = qo->joinGPUPipelineCol[sg][i];
     int table_id = qo->fkey_pkey[column]->table_id;
     ColumnInfo* pkey = qo->fkey_pkey[column];
-    cm->indexTransfer(col_idx, column, stream, custom);
+    cm->indexTransfer(col_idx, column, stream, custom, scope);
     cpu_to_gpu[sg] += (column->total_segment * sizeof(int));
     assert(col_idx[column->column_id] != NULL);
     fkey_idx[table_id - 1] = col_idx[column->column_id];
@@ -2423,7 +2773,7 @@ CPUGPUProcessing::call_pfilter_probe_aggr_GPU(QueryParams* params, int** &off_co
 
   for (int i = 0; i < qo->aggregation[cm->lo_orderdate].size(); i++) {
     ColumnInfo* column = qo->aggregation[cm->lo_orderdate][i];
-    cm->indexTransfer(col_idx, column, stream, custom);
+    cm->indexTransfer(col_idx, column, stream, custom, scope);
     cpu_to_gpu[sg] += (column->total_segment * sizeof(int));
     aggr_idx[i] = col_idx[column->column_id];
   }
@@ -2450,11 +2800,11 @@ CPUGPUProcessing::call_pfilter_probe_aggr_GPU(QueryParams* params, int** &off_co
     0, params->mode_group, params->d_group_func
   };
 
-  cudaEvent_t start, stop;   // variables that holds 2 events 
+  deviceEvent_t start, stop;   // variables that holds 2 events 
   float time;                // Variable that will hold the time
-  cudaEventCreate(&start);   // creating the event 1
-  cudaEventCreate(&stop);    // creating the event 2
-  cudaEventRecord(start, 0); // start measuring  the time
+  deviceEventCreate(&start);   // creating the event 1
+  deviceEventCreate(&stop);    // creating the event 2
+  deviceEventRecord(start, 0); // start measuring  the time
 
   if (off_col == NULL) {
 
@@ -2467,18 +2817,22 @@ CPUGPUProcessing::call_pfilter_probe_aggr_GPU(QueryParams* params, int** &off_co
 
     short* d_segment_group;
     // d_segment_group = reinterpret_cast<short*>(cm->customCudaMalloc(cm->lo_orderdate->total_segment));
-    if (custom) d_segment_group = (short*) cm->customCudaMalloc<short>(cm->lo_orderdate->total_segment);
-    else CubDebugExit(cudaMalloc((void**) &d_segment_group, cm->lo_orderdate->total_segment * sizeof(short)));
+    if (custom) d_segment_group = (short*) cm->customCudaMalloc<short>(cm->lo_orderdate->total_segment, scope);
+    else CubDebugExit(deviceMalloc((void**) &d_segment_group, cm->lo_orderdate->total_segment * sizeof(short)));
     short* segment_group_ptr = qo->segment_group[0] + (sg * cm->lo_orderdate->total_segment);
-    CubDebugExit(cudaMemcpyAsync(d_segment_group, segment_group_ptr, qo->segment_group_count[0][sg] * sizeof(short), cudaMemcpyHostToDevice, stream));
+    CubDebugExit(deviceMemcpyAsync(d_segment_group, segment_group_ptr, qo->segment_group_count[0][sg] * sizeof(short), cudaMemcpyHostToDevice, stream));
     cpu_to_gpu[sg] += (qo->segment_group_count[0][sg] * sizeof(short));
 
-    filter_probe_aggr_GPU2<128, 4><<<(LEN + tile_items - 1)/tile_items, 128, 0, stream>>>(
+    if (deviceIsHost()) {
+      filter_probe_aggr_CPU(hostFilterArgs(params, fargs), hostProbeArgs(pargs), hostGroupbyArgs(params, gargs), LEN, params->d_res, 0, d_segment_group);
+    } else {
+      filter_probe_aggr_GPU2<128, 4><<<(LEN + tile_items - 1)/tile_items, 128, 0, stream>>>(
       cm->gpuCache, fargs, pargs, gargs, LEN, params->d_res, 0, d_segment_group);
+    }
 
     CHECK_ERROR_STREAM(stream);
 
-    if (!custom) cudaFree(d_segment_group);
+    if (!custom) deviceFree(d_segment_group);
 
   } else {
 
@@ -2486,22 +2840,26 @@ CPUGPUProcessing::call_pfilter_probe_aggr_GPU(QueryParams* params, int** &off_co
       off_col[0], off_col[1], off_col[2], off_col[3], off_col[4]
     };
 
-    filter_probe_aggr_GPU3<128, 4><<<(*h_total + tile_items - 1)/tile_items, 128, 0, stream>>>(
+    if (deviceIsHost()) {
+      filter_probe_aggr_CPU2(hostOffset(offset), hostFilterArgs(params, fargs), hostProbeArgs(pargs), hostGroupbyArgs(params, gargs), *h_total, params->d_res, 0);
+    } else {
+      filter_probe_aggr_GPU3<128, 4><<<(*h_total + tile_items - 1)/tile_items, 128, 0, stream>>>(
       cm->gpuCache, offset, fargs, pargs, gargs, *h_total, params->d_res);
+    }
 
     CHECK_ERROR_STREAM(stream);
 
     if (!custom) {
       for (int i = 0; i < cm->TOT_TABLE; i++) {
-        if (off_col[i] != NULL) cudaFree(off_col[i]);
+        if (off_col[i] != NULL) deviceFree(off_col[i]);
       }
     }
 
   }
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
 
   if (verbose) cout << "Filter Probe Aggr Kernel time GPU: " << time << endl;
   gpu_time[sg] += time;
@@ -2545,7 +2903,11 @@ CPUGPUProcessing::call_pfilter_probe_aggr_CPU(QueryParams* params, int** &h_off_
     _compare1[0], _compare2[0], _compare1[1], _compare2[1],
     1, 1,
     (filter_col[0] != NULL) ? (params->map_filter_func_host[filter_col[0]]) : (NULL), 
-    (filter_col[1] != NULL) ? (params->map_filter_func_host[filter_col[1]]) : (NULL)
+    (filter_col[1] != NULL) ? (params->map_filter_func_host[filter_col[1]]) : (NULL),
+    (filter_col[0] != NULL) ? (filter_col[0]->pack) : (NULL),
+    (filter_col[1] != NULL) ? (filter_col[1]->pack) : (NULL),
+    (filter_col[0] != NULL) ? (filter_col[0]->slice) : (NULL),
+    (filter_col[1] != NULL) ? (filter_col[1]->slice) : (NULL)
   };
 
   struct probeArgsCPU pargs = {
@@ -2562,11 +2924,11 @@ CPUGPUProcessing::call_pfilter_probe_aggr_CPU(QueryParams* params, int** &h_off_
     0, params->mode_group, params->h_group_func
   };
 
-  cudaEvent_t start, stop;   // variables that holds 2 events 
+  deviceEvent_t start, stop;   // variables that holds 2 events 
   float time;                // Variable that will hold the time
-  cudaEventCreate(&start);   // creating the event 1
-  cudaEventCreate(&stop);    // creating the event 2
-  cudaEventRecord(start, 0); // start measuring  the time
+  deviceEventCreate(&start);   // creating the event 1
+  deviceEventCreate(&stop);    // creating the event 2
+  deviceEventRecord(start, 0); // start measuring  the time
 
   if (h_off_col == NULL) {
 
@@ -2589,9 +2951,9 @@ CPUGPUProcessing::call_pfilter_probe_aggr_CPU(QueryParams* params, int** &h_off_
     filter_probe_aggr_CPU2(offset, fargs, pargs, gargs, *h_total, params->res, 0);
   }
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
 
   if (verbose) cout << "Filter Probe Aggr Kernel time CPU: " << time << endl;
   cpu_time[sg] += time;
@@ -2617,7 +2979,7 @@ CPUGPUProcessing::call_pfilter_probe_aggr_OD(QueryParams* params,
 
   for (int i = 0; i < qo->select_probe[cm->lo_orderdate].size(); i++) {
     od_col_idx[filter[i]->column_id] = NULL;
-    cm->indexTransferOD(od_col_idx, filter[i], stream, custom);
+    cm->indexTransferOD(od_col_idx, filter[i], stream, custom, scope);
     cpu_to_gpu[sg] += (filter[i]->total_segment * sizeof(int));
     filter_idx[i] = od_col_idx[filter[i]->column_id];
   }
@@ -2627,7 +2989,7 @@ CPUGPUProcessing::call_pfilter_probe_aggr_OD(QueryParams* params,
   for (int i = 0; i < qo->join.size(); i++) {
     int table_id = qo->join[i].second->table_id;
     od_col_idx[fkey[table_id - 1]->column_id] = NULL;
-    cm->indexTransferOD(od_col_idx, fkey[table_id - 1], stream, custom);
+    cm->indexTransferOD(od_col_idx, fkey[table_id - 1], stream, custom, scope);
     cpu_to_gpu[sg] += (fkey[table_id - 1]->total_segment * sizeof(int));
     fkey_idx[table_id - 1] = od_col_idx[fkey[table_id - 1]->column_id];
   }
@@ -2636,7 +2998,7 @@ CPUGPUProcessing::call_pfilter_probe_aggr_OD(QueryParams* params,
 
   for (int i = 0; i < qo->aggregation[cm->lo_orderdate].size(); i++) {
     od_col_idx[aggr[i]->column_id] = NULL;
-    cm->indexTransferOD(od_col_idx, aggr[i], stream, custom);
+    cm->indexTransferOD(od_col_idx, aggr[i], stream, custom, scope);
     cpu_to_gpu[sg] += (aggr[i]->total_segment * sizeof(int));
     aggr_idx[i] = od_col_idx[aggr[i]->column_id];
   }
@@ -2684,11 +3046,11 @@ CPUGPUProcessing::call_pfilter_probe_aggr_OD(QueryParams* params,
   // cout << batch << " " << batch_size << endl;
 
   short* d_segment_group;
-  if (custom) d_segment_group = (short*) cm->customCudaMalloc<short>(batch_size);
-  else CubDebugExit(cudaMalloc((void**) &d_segment_group, batch_size * sizeof(short)));
+  if (custom) d_segment_group = (short*) cm->customCudaMalloc<short>(batch_size, scope);
+  else CubDebugExit(deviceMalloc((void**) &d_segment_group, batch_size * sizeof(short)));
 
   short* segment_group_ptr = qo->segment_group[0] + (sg * cm->lo_orderdate->total_segment) + (OD_BATCH_SIZE * batch);
-  CubDebugExit(cudaMemcpyAsync(d_segment_group, segment_group_ptr, batch_size * sizeof(short), cudaMemcpyHostToDevice, stream));
+  CubDebugExit(deviceMemcpyAsync(d_segment_group, segment_group_ptr, batch_size * sizeof(short), cudaMemcpyHostToDevice, stream));
   cpu_to_gpu[sg] += (batch_size * sizeof(short));
   // cout << "5" << endl;
 
@@ -2697,7 +3059,7 @@ CPUGPUProcessing::call_pfilter_probe_aggr_OD(QueryParams* params,
 
   CHECK_ERROR_STREAM(stream);
 
-  if (!custom) cudaFree(d_segment_group);
+  if (!custom) deviceFree(d_segment_group);
 
   delete[] od_col_idx;
 
@@ -2721,14 +3083,14 @@ CPUGPUProcessing::call_probe_group_by_OD(QueryParams* params, ColumnInfo** pkey,
   for (int i = 0; i < qo->join.size(); i++) {
     int table_id = qo->join[i].second->table_id;
     od_col_idx[fkey[table_id - 1]->column_id] = NULL;
-    cm->indexTransferOD(od_col_idx, fkey[table_id - 1], stream, custom);
+    cm->indexTransferOD(od_col_idx, fkey[table_id - 1], stream, custom, scope);
     cpu_to_gpu[sg] += (fkey[table_id - 1]->total_segment * sizeof(int));
     fkey_idx[table_id - 1] = od_col_idx[fkey[table_id - 1]->column_id];
   }
 
   for (int i = 0; i < qo->aggregation[cm->lo_orderdate].size(); i++) {
     od_col_idx[aggr[i]->column_id] = NULL;
-    cm->indexTransferOD(od_col_idx, aggr[i], stream, custom);
+    cm->indexTransferOD(od_col_idx, aggr[i], stream, custom, scope);
     cpu_to_gpu[sg] += (aggr[i]->total_segment * sizeof(int));
     aggr_idx[i] = od_col_idx[aggr[i]->column_id];
   }
@@ -2758,14 +3120,14 @@ CPUGPUProcessing::call_probe_group_by_OD(QueryParams* params, ColumnInfo** pkey,
   // cout << batch << " " << batch_size << " " << LEN << endl;
 
   short* d_segment_group;
-  if (custom) d_segment_group = (short*) cm->customCudaMalloc<short>(batch_size);
-  else CubDebugExit(cudaMalloc((void**) &d_segment_group, batch_size * sizeof(short)));
+  if (custom) d_segment_group = (short*) cm->customCudaMalloc<short>(batch_size, scope);
+  else CubDebugExit(deviceMalloc((void**) &d_segment_group, batch_size * sizeof(short)));
   short* segment_group_ptr = qo->segment_group[0] + (sg * cm->lo_orderdate->total_segment) + (OD_BATCH_SIZE * batch);
 
   // for (int i = 0; i < batch_size; i++) {
   //   cout << segment_group_ptr[i] << od_segment_list[] << endl;
   // }
-  CubDebugExit(cudaMemcpyAsync(d_segment_group, segment_group_ptr, batch_size * sizeof(short), cudaMemcpyHostToDevice, stream));
+  CubDebugExit(deviceMemcpyAsync(d_segment_group, segment_group_ptr, batch_size * sizeof(short), cudaMemcpyHostToDevice, stream));
   cpu_to_gpu[sg] += (batch_size * sizeof(short));
 
   probe_group_by_GPU2<128, 4><<<(LEN + tile_items - 1)/tile_items, 128, 0, stream>>>(
@@ -2773,7 +3135,7 @@ CPUGPUProcessing::call_probe_group_by_OD(QueryParams* params, ColumnInfo** pkey,
 
   CHECK_ERROR_STREAM(stream);
 
-  if (!custom) cudaFree(d_segment_group);
+  if (!custom) deviceFree(d_segment_group);
 
   delete[] od_col_idx;
 };
@@ -2795,11 +3157,11 @@ CPUGPUProcessing::call_probe_GPUNP(QueryParams* params, int** &off_col, int* &d_
 
   // cout << "start" << endl;
 
-  CubDebugExit(cudaMemsetAsync(d_total, 0, sizeof(int), stream));
+  CubDebugExit(deviceMemsetAsync(d_total, 0, sizeof(int), stream));
 
   int table_id = qo->fkey_pkey[column]->table_id;
   ColumnInfo* pkey = qo->fkey_pkey[column];
-  cm->indexTransfer(col_idx, column, stream, custom);
+  cm->indexTransfer(col_idx, column, stream, custom, scope);
   cpu_to_gpu[sg] += (column->total_segment * sizeof(int));
   assert(col_idx[column->column_id] != NULL);
   fkey_idx[table_id - 1] = col_idx[column->column_id];
@@ -2817,14 +3179,14 @@ CPUGPUProcessing::call_probe_GPUNP(QueryParams* params, int** &off_col, int* &d_
 
   float time;
   SETUP_TIMING();
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   if (off_col == NULL) {
     output_estimate = SEGMENT_SIZE * qo->segment_group_count[0][sg] * output_selectivity;
     for (int i = 0; i < cm->TOT_TABLE; i++) {
       if (i == 0 || qo->joinGPUcheck[i]) {
-        if (!custom) CubDebugExit(cudaMalloc((void**) &off_col_out[i], output_estimate * sizeof(int)));
-        if (custom) off_col_out[i] = (int*) cm->customCudaMalloc<int>(output_estimate);
+        if (!custom) CubDebugExit(deviceMalloc((void**) &off_col_out[i], output_estimate * sizeof(int)));
+        if (custom) off_col_out[i] = (int*) cm->customCudaMalloc<int>(output_estimate, scope);
       }
     }
   } else {
@@ -2833,17 +3195,17 @@ CPUGPUProcessing::call_probe_GPUNP(QueryParams* params, int** &off_col, int* &d_
     else output_estimate = *h_total * output_selectivity;
     for (int i = 0; i < cm->TOT_TABLE; i++) {
       if (off_col[i] != NULL || i == 0 || qo->joinGPUcheck[i]) {
-        if (!custom) CubDebugExit(cudaMalloc((void**) &off_col_out[i], output_estimate * sizeof(int)));
-        if (custom) off_col_out[i] = (int*) cm->customCudaMalloc<int>(output_estimate);
+        if (!custom) CubDebugExit(deviceMalloc((void**) &off_col_out[i], output_estimate * sizeof(int)));
+        if (custom) off_col_out[i] = (int*) cm->customCudaMalloc<int>(output_estimate, scope);
       }
     }
   }
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
   malloc_time[sg] += time;
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
 
   if (off_col == NULL) {
@@ -2869,10 +3231,10 @@ CPUGPUProcessing::call_probe_GPUNP(QueryParams* params, int** &off_col, int* &d_
 
     short* d_segment_group;
     // d_segment_group = reinterpret_cast<short*>(cm->customCudaMalloc(cm->lo_orderdate->total_segment));
-    if (custom) d_segment_group = (short*) cm->customCudaMalloc<short>(cm->lo_orderdate->total_segment);
-    else CubDebugExit(cudaMalloc((void**) &d_segment_group, cm->lo_orderdate->total_segment * sizeof(short)));
+    if (custom) d_segment_group = (short*) cm->customCudaMalloc<short>(cm->lo_orderdate->total_segment, scope);
+    else CubDebugExit(deviceMalloc((void**) &d_segment_group, cm->lo_orderdate->total_segment * sizeof(short)));
     short* segment_group_ptr = qo->segment_group[0] + (sg * cm->lo_orderdate->total_segment);
-    CubDebugExit(cudaMemcpyAsync(d_segment_group, segment_group_ptr, qo->segment_group_count[0][sg] * sizeof(short), cudaMemcpyHostToDevice, stream));
+    CubDebugExit(deviceMemcpyAsync(d_segment_group, segment_group_ptr, qo->segment_group_count[0][sg] * sizeof(short), cudaMemcpyHostToDevice, stream));
     cpu_to_gpu[sg] += (qo->segment_group_count[0][sg] * sizeof(short));
 
     probe_GPU2<128,4><<<(LEN+ tile_items - 1)/tile_items, 128, 0, stream>>>(
@@ -2880,7 +3242,7 @@ CPUGPUProcessing::call_probe_GPUNP(QueryParams* params, int** &off_col, int* &d_
 
     CHECK_ERROR_STREAM(stream);
 
-    if (!custom) cudaFree(d_segment_group);
+    if (!custom) deviceFree(d_segment_group);
 
   } else {
 
@@ -2912,7 +3274,7 @@ CPUGPUProcessing::call_probe_GPUNP(QueryParams* params, int** &off_col, int* &d_
 
       if (!custom) {
         for (int i = 0; i < cm->TOT_TABLE; i++) {
-          if (off_col[i] != NULL) cudaFree(off_col[i]);
+          if (off_col[i] != NULL) deviceFree(off_col[i]);
         }
       }   
     // }
@@ -2924,13 +3286,13 @@ CPUGPUProcessing::call_probe_GPUNP(QueryParams* params, int** &off_col, int* &d_
   for (int i = 0; i < cm->TOT_TABLE; i++)
     off_col[i] = off_col_out[i];
 
-  CubDebugExit(cudaMemcpyAsync(h_total, d_total, sizeof(int), cudaMemcpyDeviceToHost, stream));
-  CubDebugExit(cudaStreamSynchronize(stream));
+  CubDebugExit(deviceMemcpyAsync(h_total, d_total, sizeof(int), cudaMemcpyDeviceToHost, stream));
+  CubDebugExit(deviceStreamSynchronize(stream));
   gpu_to_cpu[sg] += (1 * sizeof(int));
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
 
   if (verbose) cout << "h_total: " << *h_total << " output_estimate: " << output_estimate << " output_selectivity: " << output_selectivity << " sg: " << sg  << endl;
   assert(*h_total <= output_estimate);
@@ -2971,14 +3333,14 @@ CPUGPUProcessing::call_probe_CPUNP(QueryParams* params, int** &h_off_col, int* h
 
   float time;
   SETUP_TIMING();
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   if (h_off_col == NULL) {
     output_estimate = SEGMENT_SIZE * qo->segment_group_count[0][sg] * output_selectivity;
     for (int i = 0; i < cm->TOT_TABLE; i++) {
       if (i == 0 || qo->joinCPUcheck[i]) {
-        if (!custom) CubDebugExit(cudaHostAlloc((void**) &off_col_out[i], output_estimate * sizeof(int), cudaHostAllocDefault));
-        if (custom) off_col_out[i] = (int*) cm->customCudaHostAlloc<int>(output_estimate);
+        if (!custom) CubDebugExit(deviceHostAlloc((void**) &off_col_out[i], output_estimate * sizeof(int), cudaHostAllocDefault));
+        if (custom) off_col_out[i] = (int*) cm->customCudaHostAlloc<int>(output_estimate, scope);
       }
     }
   } else {
@@ -2986,17 +3348,17 @@ CPUGPUProcessing::call_probe_CPUNP(QueryParams* params, int** &h_off_col, int* h
     output_estimate = *h_total * output_selectivity;
     for (int i = 0; i < cm->TOT_TABLE; i++) {
       if (h_off_col[i] != NULL || i == 0 || qo->joinCPUcheck[i]) {
-        if (!custom) CubDebugExit(cudaHostAlloc((void**) &off_col_out[i], output_estimate * sizeof(int), cudaHostAllocDefault));
-        if (custom) off_col_out[i] = (int*) cm->customCudaHostAlloc<int>(output_estimate);
+        if (!custom) CubDebugExit(deviceHostAlloc((void**) &off_col_out[i], output_estimate * sizeof(int), cudaHostAllocDefault));
+        if (custom) off_col_out[i] = (int*) cm->customCudaHostAlloc<int>(output_estimate, scope);
       }
     }
   }
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
   malloc_time[sg] += time;
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   if (h_off_col == NULL) {
 
@@ -3047,7 +3409,7 @@ CPUGPUProcessing::call_probe_CPUNP(QueryParams* params, int** &h_off_col, int* h
 
     if (!custom) {
       for (int i = 0; i < cm->TOT_TABLE; i++) {
-        if (h_off_col[i] != NULL) cudaFreeHost(h_off_col[i]);
+        if (h_off_col[i] != NULL) deviceFreeHost(h_off_col[i]);
       }
     }
 
@@ -3060,9 +3422,9 @@ CPUGPUProcessing::call_probe_CPUNP(QueryParams* params, int** &h_off_col, int* h
 
   *h_total = out_total;
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
 
   if (verbose) cout << "h_total: " << *h_total << " output_estimate: " << output_estimate << " sg: " << sg  << endl;
   assert(*h_total <= output_estimate);
@@ -3088,9 +3450,9 @@ CPUGPUProcessing::call_pfilter_GPUNP(QueryParams* params, int** &off_col, int* &
 
   off_col_out = new int*[cm->TOT_TABLE] (); //initialize to NULL
 
-  CubDebugExit(cudaMemsetAsync(d_total, 0, sizeof(int), stream));
+  CubDebugExit(deviceMemsetAsync(d_total, 0, sizeof(int), stream));
 
-  cm->indexTransfer(col_idx, column, stream, custom);
+  cm->indexTransfer(col_idx, column, stream, custom, scope);
   cpu_to_gpu[sg] += (column->total_segment * sizeof(int));
   filter_idx[0] = col_idx[column->column_id];
   _compare1[0] = params->compare1[column];
@@ -3109,29 +3471,29 @@ CPUGPUProcessing::call_pfilter_GPUNP(QueryParams* params, int** &off_col, int* &
 
   float time;
   SETUP_TIMING();
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   if (off_col == NULL) {
     output_estimate = SEGMENT_SIZE * qo->segment_group_count[0][sg] * output_selectivity;
-    if (!custom) CubDebugExit(cudaMalloc((void**) &off_col_out[0], output_estimate * sizeof(int)));
-    if (custom) off_col_out[0] = (int*) cm->customCudaMalloc<int>(output_estimate);
+    if (!custom) CubDebugExit(deviceMalloc((void**) &off_col_out[0], output_estimate * sizeof(int)));
+    if (custom) off_col_out[0] = (int*) cm->customCudaMalloc<int>(output_estimate, scope);
   } else {
     assert(*h_total > 0);
     assert(off_col[0] != NULL);
     output_estimate = *h_total * output_selectivity;
     for (int i = 0; i < cm->TOT_TABLE; i++) {
       if (off_col[i] != NULL || i == 0) {
-        if (!custom) CubDebugExit(cudaMalloc((void**) &off_col_out[i], output_estimate * sizeof(int)));
-        if (custom) off_col_out[i] = (int*) cm->customCudaMalloc<int>(output_estimate);
+        if (!custom) CubDebugExit(deviceMalloc((void**) &off_col_out[i], output_estimate * sizeof(int)));
+        if (custom) off_col_out[i] = (int*) cm->customCudaMalloc<int>(output_estimate, scope);
       }
     }
   }
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
   malloc_time[sg] += time;
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   if (off_col == NULL) {
 
@@ -3149,10 +3511,10 @@ CPUGPUProcessing::call_pfilter_GPUNP(QueryParams* params, int** &off_col, int* &
 
     short* d_segment_group;
     // d_segment_group = reinterpret_cast<short*>(cm->customCudaMalloc(cm->lo_orderdate->total_segment));
-    if (custom) d_segment_group = (short*) cm->customCudaMalloc<short>(cm->lo_orderdate->total_segment);
-    else CubDebugExit(cudaMalloc((void**) &d_segment_group, cm->lo_orderdate->total_segment * sizeof(short)));
+    if (custom) d_segment_group = (short*) cm->customCudaMalloc<short>(cm->lo_orderdate->total_segment, scope);
+    else CubDebugExit(deviceMalloc((void**) &d_segment_group, cm->lo_orderdate->total_segment * sizeof(short)));
     short* segment_group_ptr = qo->segment_group[0] + (sg * cm->lo_orderdate->total_segment);
-    CubDebugExit(cudaMemcpyAsync(d_segment_group, segment_group_ptr, qo->segment_group_count[0][sg] * sizeof(short), cudaMemcpyHostToDevice, stream));
+    CubDebugExit(deviceMemcpyAsync(d_segment_group, segment_group_ptr, qo->segment_group_count[0][sg] * sizeof(short), cudaMemcpyHostToDevice, stream));
     cpu_to_gpu[sg] += (qo->segment_group_count[0][sg] * sizeof(short));
 
     filter_GPU2<128,4><<<(LEN + tile_items - 1)/tile_items, 128, 0, stream>>>(
@@ -3160,7 +3522,7 @@ CPUGPUProcessing::call_pfilter_GPUNP(QueryParams* params, int** &off_col, int* &
 
     CHECK_ERROR_STREAM(stream);
 
-    if (!custom) cudaFree(d_segment_group);
+    if (!custom) deviceFree(d_segment_group);
 
   } else {
 
@@ -3182,7 +3544,7 @@ CPUGPUProcessing::call_pfilter_GPUNP(QueryParams* params, int** &off_col, int* &
 
     if (!custom) {
       for (int i = 0; i < cm->TOT_TABLE; i++) {
-        if (off_col[i] != NULL) cudaFree(off_col[i]);
+        if (off_col[i] != NULL) deviceFree(off_col[i]);
       }
     }
 
@@ -3193,17 +3555,17 @@ CPUGPUProcessing::call_pfilter_GPUNP(QueryParams* params, int** &off_col, int* &
   for (int i = 0; i < cm->TOT_TABLE; i++)
     off_col[i] = off_col_out[i];
 
-  CubDebugExit(cudaMemcpyAsync(h_total, d_total, sizeof(int), cudaMemcpyDeviceToHost, stream));
-  CubDebugExit(cudaStreamSynchronize(stream));
+  CubDebugExit(deviceMemcpyAsync(h_total, d_total, sizeof(int), cudaMemcpyDeviceToHost, stream));
+  CubDebugExit(deviceStreamSynchronize(stream));
   gpu_to_cpu[sg] += (1 * sizeof(int));
 
   if (verbose) cout << "h_total: " << *h_total << " output_estimate: " << output_estimate << " sg: " << sg  << endl;
   assert(*h_total <= output_estimate);
   assert(*h_total > 0);
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
 
   if (verbose) cout << "Filter NP Kernel time GPU: " << time << endl;
   gpu_time[sg] += time;
@@ -3237,34 +3599,38 @@ CPUGPUProcessing::call_pfilter_CPUNP(QueryParams* params, int** &h_off_col, int*
     _compare1[0], _compare2[0], 0, 0,
     _mode[0], 0, 
     (filter_col[0] != NULL) ? (params->map_filter_func_host[filter_col[0]]) : (NULL), 
+    NULL,
+    (filter_col[0] != NULL) ? (filter_col[0]->pack) : (NULL),
+    NULL,
+    (filter_col[0] != NULL) ? (filter_col[0]->slice) : (NULL),
     NULL
   };
 
   float time;
   SETUP_TIMING();
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   if (h_off_col == NULL) {
     output_estimate = SEGMENT_SIZE * qo->segment_group_count[0][sg] * output_selectivity;
-    if (!custom) CubDebugExit(cudaHostAlloc((void**) &off_col_out[0], output_estimate * sizeof(int), cudaHostAllocDefault));
-    if (custom) off_col_out[0] = (int*) cm->customCudaHostAlloc<int>(output_estimate);
+    if (!custom) CubDebugExit(deviceHostAlloc((void**) &off_col_out[0], output_estimate * sizeof(int), cudaHostAllocDefault));
+    if (custom) off_col_out[0] = (int*) cm->customCudaHostAlloc<int>(output_estimate, scope);
   } else {
     assert(*h_total > 0);
     assert(h_off_col[0] != NULL);
     output_estimate = *h_total * output_selectivity;
     for (int i = 0; i < cm->TOT_TABLE; i++) {
       if (h_off_col[i] != NULL || i == 0) {
-        if (!custom) CubDebugExit(cudaHostAlloc((void**) &off_col_out[i], output_estimate * sizeof(int), cudaHostAllocDefault));
-        if (custom) off_col_out[i] = (int*) cm->customCudaHostAlloc<int>(output_estimate);
+        if (!custom) CubDebugExit(deviceHostAlloc((void**) &off_col_out[i], output_estimate * sizeof(int), cudaHostAllocDefault));
+        if (custom) off_col_out[i] = (int*) cm->customCudaHostAlloc<int>(output_estimate, scope);
       }
     }
   }
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
   malloc_time[sg] += time;
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   if (h_off_col == NULL) {
 
@@ -3299,15 +3665,15 @@ CPUGPUProcessing::call_pfilter_CPUNP(QueryParams* params, int** &h_off_col, int*
 
     if (!custom) {
       for (int i = 0; i < cm->TOT_TABLE; i++) {
-        if (h_off_col[i] != NULL) cudaFreeHost(h_off_col[i]);
+        if (h_off_col[i] != NULL) deviceFreeHost(h_off_col[i]);
       }
     }
 
   }
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
 
   h_off_col = off_col_out;
 
@@ -3343,12 +3709,12 @@ CPUGPUProcessing::call_pfilter_probe_GPUHE(QueryParams* params, int** &off_col,
 
   off_col_out = new int*[cm->TOT_TABLE] (); //initialize it to null
 
-  CubDebugExit(cudaMemsetAsync(d_total, 0, sizeof(int), stream));
+  CubDebugExit(deviceMemsetAsync(d_total, 0, sizeof(int), stream));
 
   for (int i = 0; i < qo->selectGPUPipelineCol[sg].size(); i++) {
     if (select_so_far == qo->select_probe[cm->lo_orderdate].size()) break;
     ColumnInfo* column = qo->selectGPUPipelineCol[sg][i];
-    cm->indexTransfer(col_idx, column, stream, custom);
+    cm->indexTransfer(col_idx, column, stream, custom, scope);
     cpu_to_gpu[sg] += (column->total_segment * sizeof(int));
     filter_idx[select_so_far + i] = col_idx[column->column_id];
     _compare1[select_so_far + i] = params->compare1[column];
@@ -3362,7 +3728,7 @@ CPUGPUProcessing::call_pfilter_probe_GPUHE(QueryParams* params, int** &off_col,
     ColumnInfo* column = qo->joinGPUPipelineCol[sg][i];
     int table_id = qo->fkey_pkey[column]->table_id;
     ColumnInfo* pkey = qo->fkey_pkey[column];
-    cm->indexTransfer(col_idx, column, stream, custom);
+    cm->indexTransfer(col_idx, column, stream, custom, scope);
     cpu_to_gpu[sg] += (column->total_segment * sizeof(int));
     assert(col_idx[column->column_id] != NULL);
     fkey_idx[table_id - 1] = col_idx[column->column_id];
@@ -3390,14 +3756,14 @@ CPUGPUProcessing::call_pfilter_probe_GPUHE(QueryParams* params, int** &off_col,
 
   SETUP_TIMING();
   float time;
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   if (off_col == NULL) {
     output_estimate = SEGMENT_SIZE * qo->segment_group_count[0][sg] * output_selectivity;
     for (int i = 0; i < cm->TOT_TABLE; i++) {
       if (i == 0 || qo->joinGPUcheck[i]) {
-        if (!custom) CubDebugExit(cudaMalloc((void**) &off_col_out[i], output_estimate * sizeof(int)));
-        if (custom) off_col_out[i] = (int*) cm->customCudaMalloc<int>(output_estimate);
+        if (!custom) CubDebugExit(deviceMalloc((void**) &off_col_out[i], output_estimate * sizeof(int)));
+        if (custom) off_col_out[i] = (int*) cm->customCudaMalloc<int>(output_estimate, scope);
       }
     }
   } else {
@@ -3405,17 +3771,17 @@ CPUGPUProcessing::call_pfilter_probe_GPUHE(QueryParams* params, int** &off_col,
     output_estimate = *h_total * output_selectivity;
     for (int i = 0; i < cm->TOT_TABLE; i++) {
       if (off_col[i] != NULL || i == 0 || qo->joinGPUcheck[i]) {
-        if (!custom) CubDebugExit(cudaMalloc((void**) &off_col_out[i], output_estimate * sizeof(int)));
-        if (custom) off_col_out[i] = (int*) cm->customCudaMalloc<int>(output_estimate);
+        if (!custom) CubDebugExit(deviceMalloc((void**) &off_col_out[i], output_estimate * sizeof(int)));
+        if (custom) off_col_out[i] = (int*) cm->customCudaMalloc<int>(output_estimate, scope);
       }
     }
   }
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
   malloc_time[sg] += time;
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   if (off_col == NULL) {
 
@@ -3456,7 +3822,7 @@ CPUGPUProcessing::call_pfilter_probe_GPUHE(QueryParams* params, int** &off_col,
 
     if (!custom) {
       for (int i = 0; i < cm->TOT_TABLE; i++) {
-        if (off_col[i] != NULL) cudaFree(off_col[i]);
+        if (off_col[i] != NULL) deviceFree(off_col[i]);
       }
     }
 
@@ -3467,17 +3833,17 @@ CPUGPUProcessing::call_pfilter_probe_GPUHE(QueryParams* params, int** &off_col,
   for (int i = 0; i < cm->TOT_TABLE; i++)
     off_col[i] = off_col_out[i];
 
-  CubDebugExit(cudaMemcpyAsync(h_total, d_total, sizeof(int), cudaMemcpyDeviceToHost, stream));
-  CubDebugExit(cudaStreamSynchronize(stream));
+  CubDebugExit(deviceMemcpyAsync(h_total, d_total, sizeof(int), cudaMemcpyDeviceToHost, stream));
+  CubDebugExit(deviceStreamSynchronize(stream));
   gpu_to_cpu[sg] += (1 * sizeof(int));
 
   if (verbose) cout << "h_total: " << *h_total << " output_estimate: " << output_estimate << " sg: " << sg << endl;
   assert(*h_total <= output_estimate);
   // assert(*h_total > 0);
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
   gpu_time[sg] += time;
 
   if (verbose) cout << "Filter Probe Kernel time GPU: " << time << endl;
@@ -3525,7 +3891,11 @@ CPUGPUProcessing::call_pfilter_probe_CPUHE(QueryParams* params, int** &h_off_col
     _compare1[0], _compare2[0], _compare1[1], _compare2[1],
     1, 1, 
     (filter_col[0] != NULL) ? (params->map_filter_func_host[filter_col[0]]) : (NULL), 
-    (filter_col[1] != NULL) ? (params->map_filter_func_host[filter_col[1]]) : (NULL)
+    (filter_col[1] != NULL) ? (params->map_filter_func_host[filter_col[1]]) : (NULL),
+    (filter_col[0] != NULL) ? (filter_col[0]->pack) : (NULL),
+    (filter_col[1] != NULL) ? (filter_col[1]->pack) : (NULL),
+    (filter_col[0] != NULL) ? (filter_col[0]->slice) : (NULL),
+    (filter_col[1] != NULL) ? (filter_col[1]->slice) : (NULL)
   };
 
   struct probeArgsCPU pargs = {
@@ -3537,14 +3907,14 @@ CPUGPUProcessing::call_pfilter_probe_CPUHE(QueryParams* params, int** &h_off_col
 
   SETUP_TIMING();
   float time;
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   if (h_off_col == NULL) {
     output_estimate = SEGMENT_SIZE * qo->segment_group_count[0][sg] * output_selectivity;
     for (int i = 0; i < cm->TOT_TABLE; i++) {
       if (i == 0 || qo->joinCPUcheck[i]) {
-        if (!custom) CubDebugExit(cudaHostAlloc((void**) &off_col_out[i], output_estimate * sizeof(int), cudaHostAllocDefault));
-        if (custom) off_col_out[i] = (int*) cm->customCudaHostAlloc<int>(output_estimate);
+        if (!custom) CubDebugExit(deviceHostAlloc((void**) &off_col_out[i], output_estimate * sizeof(int), cudaHostAllocDefault));
+        if (custom) off_col_out[i] = (int*) cm->customCudaHostAlloc<int>(output_estimate, scope);
       }
     }
   } else {
@@ -3552,17 +3922,17 @@ CPUGPUProcessing::call_pfilter_probe_CPUHE(QueryParams* params, int** &h_off_col
     output_estimate = *h_total * output_selectivity;
     for (int i = 0; i < cm->TOT_TABLE; i++) {
       if (h_off_col[i] != NULL || i == 0 || qo->joinCPUcheck[i]) {
-        if (!custom) CubDebugExit(cudaHostAlloc((void**) &off_col_out[i], output_estimate * sizeof(int), cudaHostAllocDefault));
-        if (custom) off_col_out[i] = (int*) cm->customCudaHostAlloc<int>(output_estimate);
+        if (!custom) CubDebugExit(deviceHostAlloc((void**) &off_col_out[i], output_estimate * sizeof(int), cudaHostAllocDefault));
+        if (custom) off_col_out[i] = (int*) cm->customCudaHostAlloc<int>(output_estimate, scope);
       }
     }
   }
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
   malloc_time[sg] += time;
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   if (h_off_col == NULL) {
 
@@ -3599,7 +3969,7 @@ CPUGPUProcessing::call_pfilter_probe_CPUHE(QueryParams* params, int** &h_off_col
 
     if (!custom) {
       for (int i = 0; i < cm->TOT_TABLE; i++) {
-        if (h_off_col[i] != NULL) cudaFreeHost(h_off_col[i]);
+        if (h_off_col[i] != NULL) deviceFreeHost(h_off_col[i]);
       }
     }
 
@@ -3616,9 +3986,9 @@ CPUGPUProcessing::call_pfilter_probe_CPUHE(QueryParams* params, int** &h_off_col
   assert(*h_total <= output_estimate);
   // assert(*h_total > 0);
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
   if (verbose) cout << "Filter Probe Kernel time CPU: " << time << endl;
   cpu_time[sg] += time;
 
@@ -3638,7 +4008,7 @@ CPUGPUProcessing::call_probe_group_by_GPUHE(QueryParams* params, int** &off_col,
     ColumnInfo* column = qo->joinGPUPipelineCol[sg][i];
     int table_id = qo->fkey_pkey[column]->table_id;
     ColumnInfo* pkey = qo->fkey_pkey[column];
-    cm->indexTransfer(col_idx, column, stream, custom);
+    cm->indexTransfer(col_idx, column, stream, custom, scope);
     cpu_to_gpu[sg] += (column->total_segment * sizeof(int));
     assert(col_idx[column->column_id] != NULL);
     fkey_idx[table_id - 1] = col_idx[column->column_id];
@@ -3649,7 +4019,7 @@ CPUGPUProcessing::call_probe_group_by_GPUHE(QueryParams* params, int** &off_col,
 
   for (int i = 0; i < qo->aggregation[cm->lo_orderdate].size(); i++) {
     ColumnInfo* column = qo->aggregation[cm->lo_orderdate][i];
-    cm->indexTransfer(col_idx, column, stream, custom);
+    cm->indexTransfer(col_idx, column, stream, custom, scope);
     cpu_to_gpu[sg] += (column->total_segment * sizeof(int));
     aggr_idx[i] = col_idx[column->column_id];
   }
@@ -3659,7 +4029,7 @@ CPUGPUProcessing::call_probe_group_by_GPUHE(QueryParams* params, int** &off_col,
     if (it->second.size() > 0) {
       ColumnInfo* column = it->second[0];
       ColumnInfo* column_key = it->first;
-      cm->indexTransfer(col_idx, column, stream, custom);
+      cm->indexTransfer(col_idx, column, stream, custom, scope);
       cpu_to_gpu[sg] += (column->total_segment * sizeof(int));
       group_idx[column_key->table_id - 1] = col_idx[column->column_id];
       _min_val[column_key->table_id - 1] = params->min_val[column_key];
@@ -3695,7 +4065,7 @@ CPUGPUProcessing::call_probe_group_by_GPUHE(QueryParams* params, int** &off_col,
 
     int start_offset = sg * SEGMENT_SIZE;
 
-    cudaEventRecord(start, 0);
+    deviceEventRecord(start, 0);
 
     probe_group_by_GPU2<128, 4><<<(LEN + tile_items - 1)/tile_items, 128, 0, stream>>>(
       cm->gpuCache, pargs, gargs, LEN, params->d_res, start_offset, NULL);
@@ -3708,7 +4078,7 @@ CPUGPUProcessing::call_probe_group_by_GPUHE(QueryParams* params, int** &off_col,
       off_col[0], off_col[1], off_col[2], off_col[3], off_col[4]
     };
 
-    cudaEventRecord(start, 0);
+    deviceEventRecord(start, 0);
     
     probe_group_by_GPU3<128, 4><<<(*h_total + tile_items - 1)/tile_items, 128, 0, stream>>>(
       cm->gpuCache, offset, pargs, gargs, *h_total, params->d_res);
@@ -3717,16 +4087,16 @@ CPUGPUProcessing::call_probe_group_by_GPUHE(QueryParams* params, int** &off_col,
 
     if (!custom) {
       for (int i = 0; i < cm->TOT_TABLE; i++) {
-        if (off_col[i] != NULL) cudaFree(off_col[i]);
+        if (off_col[i] != NULL) deviceFree(off_col[i]);
       }
     }
 
   }
 
-  cudaEventRecord(stop, 0);                  // Stop time measuring
-  cudaEventSynchronize(stop);               // Wait until the completion of all device 
-                                            // work preceding the most recent call to cudaEventRecord()
-  cudaEventElapsedTime(&time, start, stop); // Saving the time measured
+  deviceEventRecord(stop, 0);                  // Stop time measuring
+  deviceEventSynchronize(stop);               // Wait until the completion of all device 
+                                            // work preceding the most recent call to deviceEventRecord()
+  deviceEventElapsedTime(&time, start, stop); // Saving the time measured
 
   if (verbose) cout << "Probe Group Kernel time GPU: " << time << endl;
   gpu_time[sg] += time;
@@ -3783,7 +4153,7 @@ CPUGPUProcessing::call_probe_group_by_CPUHE(QueryParams* params, int** &h_off_co
 
   float time;
   SETUP_TIMING();
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   if (h_off_col == NULL) {
 
@@ -3808,15 +4178,15 @@ CPUGPUProcessing::call_probe_group_by_CPUHE(QueryParams* params, int** &h_off_co
 
     if (!custom) {
       for (int i = 0; i < cm->TOT_TABLE; i++) {
-        if (h_off_col[i] != NULL) cudaFreeHost(h_off_col[i]);
+        if (h_off_col[i] != NULL) deviceFreeHost(h_off_col[i]);
       }
     }
   }
 
-  cudaEventRecord(stop, 0);                  // Stop time measuring
-  cudaEventSynchronize(stop);               // Wait until the completion of all device 
-                                            // work preceding the most recent call to cudaEventRecord()
-  cudaEventElapsedTime(&time, start, stop); // Saving the time measured
+  deviceEventRecord(stop, 0);                  // Stop time measuring
+  deviceEventSynchronize(stop);               // Wait until the completion of all device 
+                                            // work preceding the most recent call to deviceEventRecord()
+  deviceEventElapsedTime(&time, start, stop); // Saving the time measured
 
   if (verbose) cout << "Probe Group Kernel time CPU: " << time << endl;
   cpu_time[sg] += time;
@@ -3838,13 +4208,13 @@ CPUGPUProcessing::call_probe_GPUHE(QueryParams* params, int** &off_col, int* &d_
 
   off_col_out = new int*[cm->TOT_TABLE] (); //initialize it to null
 
-  CubDebugExit(cudaMemsetAsync(d_total, 0, sizeof(int), stream));
+  CubDebugExit(deviceMemsetAsync(d_total, 0, sizeof(int), stream));
 
   for (int i = 0; i < qo->joinGPUPipelineCol[sg].size(); i++) {
     ColumnInfo* column = qo->joinGPUPipelineCol[sg][i];
     int table_id = qo->fkey_pkey[column]->table_id;
     ColumnInfo* pkey = qo->fkey_pkey[column];
-    cm->indexTransfer(col_idx, column, stream, custom);
+    cm->indexTransfer(col_idx, column, stream, custom, scope);
     cpu_to_gpu[sg] += (column->total_segment * sizeof(int));
     assert(col_idx[column->column_id] != NULL);
     fkey_idx[table_id - 1] = col_idx[column->column_id];
@@ -3864,14 +4234,14 @@ CPUGPUProcessing::call_probe_GPUHE(QueryParams* params, int** &off_col, int* &d_
 
   float time;
   SETUP_TIMING();
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   if (off_col == NULL) {
     output_estimate = SEGMENT_SIZE * qo->segment_group_count[0][sg] * output_selectivity;
     for (int i = 0; i < cm->TOT_TABLE; i++) {
       if (i == 0 || qo->joinGPUcheck[i]) {
-        if (!custom) CubDebugExit(cudaMalloc((void**) &off_col_out[i], output_estimate * sizeof(int)));
-        if (custom) off_col_out[i] = (int*) cm->customCudaMalloc<int>(output_estimate);
+        if (!custom) CubDebugExit(deviceMalloc((void**) &off_col_out[i], output_estimate * sizeof(int)));
+        if (custom) off_col_out[i] = (int*) cm->customCudaMalloc<int>(output_estimate, scope);
       }
     }
   } else {
@@ -3879,17 +4249,17 @@ CPUGPUProcessing::call_probe_GPUHE(QueryParams* params, int** &off_col, int* &d_
     output_estimate = *h_total * output_selectivity;
     for (int i = 0; i < cm->TOT_TABLE; i++) {
       if (off_col[i] != NULL || i == 0 || qo->joinGPUcheck[i]) {
-        if (!custom) CubDebugExit(cudaMalloc((void**) &off_col_out[i], output_estimate * sizeof(int)));
-        if (custom) off_col_out[i] = (int*) cm->customCudaMalloc<int>(output_estimate);
+        if (!custom) CubDebugExit(deviceMalloc((void**) &off_col_out[i], output_estimate * sizeof(int)));
+        if (custom) off_col_out[i] = (int*) cm->customCudaMalloc<int>(output_estimate, scope);
       }
     }
   }
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
   malloc_time[sg] += time;
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   if (off_col == NULL) {
 
@@ -3932,7 +4302,7 @@ CPUGPUProcessing::call_probe_GPUHE(QueryParams* params, int** &off_col, int* &d_
 
       if (!custom) {
         for (int i = 0; i < cm->TOT_TABLE; i++) {
-          if (off_col[i] != NULL) cudaFree(off_col[i]);
+          if (off_col[i] != NULL) deviceFree(off_col[i]);
         }
       }   
     // }
@@ -3944,13 +4314,13 @@ CPUGPUProcessing::call_probe_GPUHE(QueryParams* params, int** &off_col, int* &d_
   for (int i = 0; i < cm->TOT_TABLE; i++)
     off_col[i] = off_col_out[i];
 
-  CubDebugExit(cudaMemcpyAsync(h_total, d_total, sizeof(int), cudaMemcpyDeviceToHost, stream));
-  CubDebugExit(cudaStreamSynchronize(stream));
+  CubDebugExit(deviceMemcpyAsync(h_total, d_total, sizeof(int), cudaMemcpyDeviceToHost, stream));
+  CubDebugExit(deviceStreamSynchronize(stream));
   gpu_to_cpu[sg] += (1 * sizeof(int));
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
 
   if (verbose) cout << "h_total: " << *h_total << " output_estimate: " << output_estimate << " sg: " << sg  << endl;
   assert(*h_total <= output_estimate);
@@ -3994,14 +4364,14 @@ CPUGPUProcessing::call_probe_CPUHE(QueryParams* params, int** &h_off_col, int* h
 
   float time;
   SETUP_TIMING();
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   if (h_off_col == NULL) {
     output_estimate = SEGMENT_SIZE * qo->segment_group_count[0][sg] * output_selectivity;
     for (int i = 0; i < cm->TOT_TABLE; i++) {
       if (i == 0 || qo->joinCPUcheck[i]) {
-        if (!custom) CubDebugExit(cudaHostAlloc((void**) &off_col_out[i], output_estimate * sizeof(int), cudaHostAllocDefault));
-        if (custom) off_col_out[i] = (int*) cm->customCudaHostAlloc<int>(output_estimate);
+        if (!custom) CubDebugExit(deviceHostAlloc((void**) &off_col_out[i], output_estimate * sizeof(int), cudaHostAllocDefault));
+        if (custom) off_col_out[i] = (int*) cm->customCudaHostAlloc<int>(output_estimate, scope);
       }
     }
   } else {
@@ -4009,17 +4379,17 @@ CPUGPUProcessing::call_probe_CPUHE(QueryParams* params, int** &h_off_col, int* h
     output_estimate = *h_total * output_selectivity;
     for (int i = 0; i < cm->TOT_TABLE; i++) {
       if (h_off_col[i] != NULL || i == 0 || qo->joinCPUcheck[i]) {
-        if (!custom) CubDebugExit(cudaHostAlloc((void**) &off_col_out[i], output_estimate * sizeof(int), cudaHostAllocDefault));
-        if (custom) off_col_out[i] = (int*) cm->customCudaHostAlloc<int>(output_estimate);
+        if (!custom) CubDebugExit(deviceHostAlloc((void**) &off_col_out[i], output_estimate * sizeof(int), cudaHostAllocDefault));
+        if (custom) off_col_out[i] = (int*) cm->customCudaHostAlloc<int>(output_estimate, scope);
       }
     }
   }
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
   malloc_time[sg] += time;
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   if (h_off_col == NULL) {
 
@@ -4054,7 +4424,7 @@ CPUGPUProcessing::call_probe_CPUHE(QueryParams* params, int** &h_off_col, int* h
 
     if (!custom) {
       for (int i = 0; i < cm->TOT_TABLE; i++) {
-        if (h_off_col[i] != NULL) cudaFreeHost(h_off_col[i]);
+        if (h_off_col[i] != NULL) deviceFreeHost(h_off_col[i]);
       }
     }
 
@@ -4067,9 +4437,9 @@ CPUGPUProcessing::call_probe_CPUHE(QueryParams* params, int** &h_off_col, int* h
 
   *h_total = out_total;
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
 
   if (verbose) cout << "h_total: " << *h_total << " output_estimate: " << output_estimate << " sg: " << sg  << endl;
   assert(*h_total <= output_estimate);
@@ -4094,12 +4464,12 @@ CPUGPUProcessing::call_pfilter_GPUHE(QueryParams* params, int** &off_col, int* &
 
   off_col_out = new int*[cm->TOT_TABLE] (); //initialize to NULL
 
-  CubDebugExit(cudaMemsetAsync(d_total, 0, sizeof(int), stream));
+  CubDebugExit(deviceMemsetAsync(d_total, 0, sizeof(int), stream));
 
   for (int i = 0; i < qo->selectGPUPipelineCol[sg].size(); i++) {
     if (select_so_far == qo->select_probe[cm->lo_orderdate].size()) break;
     ColumnInfo* column = qo->selectGPUPipelineCol[sg][i];
-    cm->indexTransfer(col_idx, column, stream, custom);
+    cm->indexTransfer(col_idx, column, stream, custom, scope);
     cpu_to_gpu[sg] += (column->total_segment * sizeof(int));
     filter_idx[select_so_far + i] = col_idx[column->column_id];
     _compare1[select_so_far + i] = params->compare1[column];
@@ -4120,28 +4490,28 @@ CPUGPUProcessing::call_pfilter_GPUHE(QueryParams* params, int** &off_col, int* &
 
   float time;
   SETUP_TIMING();
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   if (off_col == NULL) {
     output_estimate = SEGMENT_SIZE * qo->segment_group_count[0][sg] * output_selectivity;
-    if (!custom) CubDebugExit(cudaMalloc((void**) &off_col_out[0], output_estimate * sizeof(int)));
-    if (custom) off_col_out[0] = (int*) cm->customCudaMalloc<int>(output_estimate);
+    if (!custom) CubDebugExit(deviceMalloc((void**) &off_col_out[0], output_estimate * sizeof(int)));
+    if (custom) off_col_out[0] = (int*) cm->customCudaMalloc<int>(output_estimate, scope);
   } else {
     assert(*h_total > 0);
     output_estimate = *h_total * output_selectivity;
     for (int i = 0; i < cm->TOT_TABLE; i++) {
       if (off_col[i] != NULL || i == 0) {
-        if (!custom) CubDebugExit(cudaMalloc((void**) &off_col_out[i], output_estimate * sizeof(int)));
-        if (custom) off_col_out[i] = (int*) cm->customCudaMalloc<int>(output_estimate);
+        if (!custom) CubDebugExit(deviceMalloc((void**) &off_col_out[i], output_estimate * sizeof(int)));
+        if (custom) off_col_out[i] = (int*) cm->customCudaMalloc<int>(output_estimate, scope);
       }
     }
   }
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
   malloc_time[sg] += time;
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   if (off_col == NULL) {
 
@@ -4170,7 +4540,7 @@ CPUGPUProcessing::call_pfilter_GPUHE(QueryParams* params, int** &off_col, int* &
 
     if (!custom) {
       for (int i = 0; i < cm->TOT_TABLE; i++) {
-        if (off_col[i] != NULL) cudaFree(off_col[i]);
+        if (off_col[i] != NULL) deviceFree(off_col[i]);
       }
     }
 
@@ -4181,17 +4551,17 @@ CPUGPUProcessing::call_pfilter_GPUHE(QueryParams* params, int** &off_col, int* &
   for (int i = 0; i < cm->TOT_TABLE; i++)
     off_col[i] = off_col_out[i];
 
-  CubDebugExit(cudaMemcpyAsync(h_total, d_total, sizeof(int), cudaMemcpyDeviceToHost, stream));
-  CubDebugExit(cudaStreamSynchronize(stream));
+  CubDebugExit(deviceMemcpyAsync(h_total, d_total, sizeof(int), cudaMemcpyDeviceToHost, stream));
+  CubDebugExit(deviceStreamSynchronize(stream));
   gpu_to_cpu[sg] += (1 * sizeof(int));
 
   if (verbose) cout << "h_total: " << *h_total << " output_estimate: " << output_estimate << " sg: " << sg  << endl;
   assert(*h_total <= output_estimate);
   assert(*h_total > 0);
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
 
   if (verbose) cout << "Filter Kernel time GPU: " << time << endl;
   gpu_time[sg] += time;
@@ -4229,17 +4599,21 @@ CPUGPUProcessing::call_pfilter_CPUHE(QueryParams* params, int** &h_off_col, int*
     _compare1[0], _compare2[0], _compare1[1], _compare2[1],
     _mode[0], _mode[1], 
     (filter_col[0] != NULL) ? (params->map_filter_func_host[filter_col[0]]) : (NULL), 
-    (filter_col[1] != NULL) ? (params->map_filter_func_host[filter_col[1]]) : (NULL)
+    (filter_col[1] != NULL) ? (params->map_filter_func_host[filter_col[1]]) : (NULL),
+    (filter_col[0] != NULL) ? (filter_col[0]->pack) : (NULL),
+    (filter_col[1] != NULL) ? (filter_col[1]->pack) : (NULL),
+    (filter_col[0] != NULL) ? (filter_col[0]->slice) : (NULL),
+    (filter_col[1] != NULL) ? (filter_col[1]->slice) : (NULL)
   };
 
   float time;
   SETUP_TIMING();
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   if (h_off_col == NULL) {
     output_estimate = SEGMENT_SIZE * qo->segment_group_count[0][sg] * output_selectivity;
-    if (!custom) CubDebugExit(cudaHostAlloc((void**) &off_col_out[0], output_estimate * sizeof(int), cudaHostAllocDefault));
-    if (custom) off_col_out[0] = (int*) cm->customCudaHostAlloc<int>(output_estimate);
+    if (!custom) CubDebugExit(deviceHostAlloc((void**) &off_col_out[0], output_estimate * sizeof(int), cudaHostAllocDefault));
+    if (custom) off_col_out[0] = (int*) cm->customCudaHostAlloc<int>(output_estimate, scope);
   } else {
     assert(filter_col[0] == NULL);
     assert(filter_col[1] != NULL);
@@ -4247,17 +4621,17 @@ CPUGPUProcessing::call_pfilter_CPUHE(QueryParams* params, int** &h_off_col, int*
     output_estimate = *h_total * output_selectivity;
     for (int i = 0; i < cm->TOT_TABLE; i++) {
       if (h_off_col[i] != NULL || i == 0) {
-        if (!custom) CubDebugExit(cudaHostAlloc((void**) &off_col_out[i], output_estimate * sizeof(int), cudaHostAllocDefault));
-        if (custom) off_col_out[i] = (int*) cm->customCudaHostAlloc<int>(output_estimate);
+        if (!custom) CubDebugExit(deviceHostAlloc((void**) &off_col_out[i], output_estimate * sizeof(int), cudaHostAllocDefault));
+        if (custom) off_col_out[i] = (int*) cm->customCudaHostAlloc<int>(output_estimate, scope);
       }
     }
   }
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
   malloc_time[sg] += time;
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   if (h_off_col == NULL) {
 
@@ -4281,7 +4655,7 @@ CPUGPUProcessing::call_pfilter_CPUHE(QueryParams* params, int** &h_off_col, int*
 
     if (!custom) {
       for (int i = 0; i < cm->TOT_TABLE; i++) {
-        if (h_off_col[i] != NULL) cudaFreeHost(h_off_col[i]);
+        if (h_off_col[i] != NULL) deviceFreeHost(h_off_col[i]);
       }
     }
 
@@ -4298,9 +4672,9 @@ CPUGPUProcessing::call_pfilter_CPUHE(QueryParams* params, int** &h_off_col, int*
   assert(*h_total <= output_estimate);
   assert(*h_total > 0);
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
 
   if (verbose) cout << "Filter Kernel time CPU: " << time << endl;
   cpu_time[sg] += time;
@@ -4324,7 +4698,7 @@ CPUGPUProcessing::call_bfilter_build_GPUHE(QueryParams* params, int* &d_off_col,
     if (qo->groupby_build.size() > 0 && qo->groupby_build[column].size() > 0) {
       if (qo->groupGPUcheck) {
         ColumnInfo* group_col = qo->groupby_build[column][0];
-        cm->indexTransfer(col_idx, group_col, stream, custom);
+        cm->indexTransfer(col_idx, group_col, stream, custom, scope);
         cpu_to_gpu[sg] += (group_col->total_segment * sizeof(int));
         group_idx = col_idx[group_col->column_id];
       }
@@ -4332,12 +4706,12 @@ CPUGPUProcessing::call_bfilter_build_GPUHE(QueryParams* params, int* &d_off_col,
 
     if (qo->select_build[column].size() > 0) {
       filter_col = qo->select_build[column][0];
-      cm->indexTransfer(col_idx, filter_col, stream, custom);
+      cm->indexTransfer(col_idx, filter_col, stream, custom, scope);
       cpu_to_gpu[sg] += (filter_col->total_segment * sizeof(int));
       filter_idx = col_idx[filter_col->column_id];
     }
 
-    cm->indexTransfer(col_idx, column, stream, custom);
+    cm->indexTransfer(col_idx, column, stream, custom, scope);
     cpu_to_gpu[sg] += (column->total_segment * sizeof(int));
 
     dimkey_idx = col_idx[column->column_id];
@@ -4356,7 +4730,7 @@ CPUGPUProcessing::call_bfilter_build_GPUHE(QueryParams* params, int* &d_off_col,
 
     SETUP_TIMING();
     float time;
-    cudaEventRecord(start, 0);
+    deviceEventRecord(start, 0);
 
     if (d_off_col == NULL) {
 
@@ -4381,13 +4755,13 @@ CPUGPUProcessing::call_bfilter_build_GPUHE(QueryParams* params, int* &d_off_col,
 
       CHECK_ERROR_STREAM(stream);
 
-      if (!custom) cudaFree(d_off_col);
+      if (!custom) deviceFree(d_off_col);
         
     }
 
-    cudaEventRecord(stop, 0);
-    cudaEventSynchronize(stop);
-    cudaEventElapsedTime(&time, start, stop);
+    deviceEventRecord(stop, 0);
+    deviceEventSynchronize(stop);
+    deviceEventElapsedTime(&time, start, stop);
 
     if (verbose) cout << "Filter Build Kernel time GPU: " << time << endl;
     gpu_time[sg] += time;
@@ -4431,7 +4805,7 @@ CPUGPUProcessing::call_bfilter_build_CPUHE(QueryParams* params, int* &h_off_col,
 
     SETUP_TIMING();
     float time;
-    cudaEventRecord(start, 0);
+    deviceEventRecord(start, 0);
 
     if (h_off_col == NULL) {
 
@@ -4450,13 +4824,13 @@ CPUGPUProcessing::call_bfilter_build_CPUHE(QueryParams* params, int* &h_off_col,
 
       build_CPU2HE(h_off_col, fargs, bargs, *h_total, params->ht_CPU[column], 0);
 
-      if (!custom) cudaFreeHost(h_off_col);
+      if (!custom) deviceFreeHost(h_off_col);
 
     }
 
-    cudaEventRecord(stop, 0);
-    cudaEventSynchronize(stop);
-    cudaEventElapsedTime(&time, start, stop);
+    deviceEventRecord(stop, 0);
+    deviceEventSynchronize(stop);
+    deviceEventElapsedTime(&time, start, stop);
 
     if (verbose) cout << "Filter Build Kernel time CPU: " << time << endl;
     cpu_time[sg] += time;
@@ -4481,13 +4855,13 @@ CPUGPUProcessing::call_build_GPUHE(QueryParams* params, int* &d_off_col, int* h_
     if (qo->groupby_build.size() > 0 && qo->groupby_build[column].size() > 0) {
       if (qo->groupGPUcheck) {
         ColumnInfo* group_col = qo->groupby_build[column][0];
-        cm->indexTransfer(col_idx, group_col, stream, custom);
+        cm->indexTransfer(col_idx, group_col, stream, custom, scope);
         cpu_to_gpu[sg] += (group_col->total_segment * sizeof(int));
         group_idx = col_idx[group_col->column_id];
       }
     }
 
-    cm->indexTransfer(col_idx, column, stream, custom);
+    cm->indexTransfer(col_idx, column, stream, custom, scope);
     cpu_to_gpu[sg] += (column->total_segment * sizeof(int));
 
     dimkey_idx = col_idx[column->column_id];
@@ -4501,7 +4875,7 @@ CPUGPUProcessing::call_build_GPUHE(QueryParams* params, int* &d_off_col, int* h_
 
     SETUP_TIMING();
     float time;
-    cudaEventRecord(start, 0);
+    deviceEventRecord(start, 0);
 
     if (d_off_col == NULL) {
 
@@ -4526,13 +4900,13 @@ CPUGPUProcessing::call_build_GPUHE(QueryParams* params, int* &d_off_col, int* h_
 
       CHECK_ERROR_STREAM(stream);
 
-      if (!custom) cudaFree(d_off_col);
+      if (!custom) deviceFree(d_off_col);
 
     }
 
-    cudaEventRecord(stop, 0);
-    cudaEventSynchronize(stop);
-    cudaEventElapsedTime(&time, start, stop);
+    deviceEventRecord(stop, 0);
+    deviceEventSynchronize(stop);
+    deviceEventElapsedTime(&time, start, stop);
 
     if (verbose) cout << "Build Kernel time GPU: " << time << endl;
     gpu_time[sg] += time;
@@ -4566,7 +4940,7 @@ CPUGPUProcessing::call_build_CPUHE(QueryParams* params, int* &h_off_col, int* h_
 
     SETUP_TIMING();
     float time;
-    cudaEventRecord(start, 0);
+    deviceEventRecord(start, 0);
 
     if (h_off_col == NULL) {
 
@@ -4585,13 +4959,13 @@ CPUGPUProcessing::call_build_CPUHE(QueryParams* params, int* &h_off_col, int* h_
 
       build_CPU2HE(h_off_col, fargs, bargs, *h_total, params->ht_CPU[column], 0);
 
-      if (!custom) cudaFreeHost(h_off_col);
+      if (!custom) deviceFreeHost(h_off_col);
 
     }
 
-    cudaEventRecord(stop, 0);
-    cudaEventSynchronize(stop);
-    cudaEventElapsedTime(&time, start, stop);
+    deviceEventRecord(stop, 0);
+    deviceEventSynchronize(stop);
+    deviceEventElapsedTime(&time, start, stop);
 
     if (verbose) cout << "Build Kernel time CPU: " << time << endl;
     cpu_time[sg] += time;
@@ -4620,19 +4994,19 @@ CPUGPUProcessing::call_bfilter_GPUHE(QueryParams* params, int* &d_off_col, int*
 
   SETUP_TIMING();
   float time;
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
   
   // d_off_col = (int*) cm->customCudaMalloc<int>(output_estimate);
-  if (custom) d_off_col = (int*) cm->customCudaMalloc<int>(output_estimate);
-  else CubDebugExit(cudaMalloc((void**) &d_off_col, output_estimate * sizeof(int)));
+  if (custom) d_off_col = (int*) cm->customCudaMalloc<int>(output_estimate, scope);
+  else CubDebugExit(deviceMalloc((void**) &d_off_col, output_estimate * sizeof(int)));
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
   malloc_time[sg] += time;
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
-  CubDebugExit(cudaMemsetAsync(d_total, 0, sizeof(int), stream));
+  CubDebugExit(deviceMemsetAsync(d_total, 0, sizeof(int), stream));
 
   int LEN;
   if (sg == qo->last_segment[table]) {
@@ -4641,7 +5015,7 @@ CPUGPUProcessing::call_bfilter_GPUHE(QueryParams* params, int* &d_off_col, int*
     LEN = qo->segment_group_count[table][sg] * SEGMENT_SIZE;
   }
 
-  cm->indexTransfer(col_idx, column, stream, custom);
+  cm->indexTransfer(col_idx, column, stream, custom, scope);
   cpu_to_gpu[sg] += (column->total_segment * sizeof(int));
   int* filter_idx = col_idx[column->column_id];
 
@@ -4658,17 +5032,17 @@ CPUGPUProcessing::call_bfilter_GPUHE(QueryParams* params, int* &d_off_col, int*
 
   CHECK_ERROR_STREAM(stream);
 
-  CubDebugExit(cudaMemcpyAsync(h_total, d_total, sizeof(int), cudaMemcpyDeviceToHost, stream));
-  CubDebugExit(cudaStreamSynchronize(stream));
+  CubDebugExit(deviceMemcpyAsync(h_total, d_total, sizeof(int), cudaMemcpyDeviceToHost, stream));
+  CubDebugExit(deviceStreamSynchronize(stream));
   gpu_to_cpu[sg] += (1 * sizeof(int));
 
   if (verbose) cout << "h_total: " << *h_total << " output_estimate: " << output_estimate << " sg: " << sg  << endl;
   assert(*h_total <= output_estimate);
   assert(*h_total > 0);
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
 
   if (verbose) cout << "Filter Kernel time GPU: " << time << endl;
   gpu_time[sg] += time;
@@ -4695,16 +5069,16 @@ CPUGPUProcessing::call_bfilter_CPUHE(QueryParams* params, int* &h_off_col, int*
 
   SETUP_TIMING();
   float time;
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
-  if (custom) h_off_col = (int*) cm->customCudaHostAlloc<int>(output_estimate);
-  else CubDebugExit(cudaHostAlloc((void**) &h_off_col, output_estimate * sizeof(int), cudaHostAllocDefault));
+  if (custom) h_off_col = (int*) cm->customCudaHostAlloc<int>(output_estimate, scope);
+  else CubDebugExit(deviceHostAlloc((void**) &h_off_col, output_estimate * sizeof(int), cudaHostAllocDefault));
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
   malloc_time[sg] += time;
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   int LEN;
   if (sg == qo->last_segment[table]) {
@@ -4716,7 +5090,9 @@ CPUGPUProcessing::call_bfilter_CPUHE(QueryParams* params, int* &h_off_col, int*
   struct filterArgsCPU fargs = {
     filter_col, NULL,
     params->compare1[column], params->compare2[column], 0, 0,
-    params->mode[column], 0, params->map_filter_func_host[column], NULL
+    params->mode[column], 0, params->map_filter_func_host[column], NULL,
+    column->pack, NULL,
+    column->slice, NULL
   };
 
   int start_offset = sg * SEGMENT_SIZE;
@@ -4727,9 +5103,9 @@ CPUGPUProcessing::call_bfilter_CPUHE(QueryParams* params, int* &h_off_col, int*
   assert(*h_total <= output_estimate);
   assert(*h_total > 0);
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
 
   if (verbose) cout << "Filter Kernel time CPU: " << time << endl;
   cpu_time[sg] += time;
@@ -4746,7 +5122,7 @@ CPUGPUProcessing::call_group_by_GPUHE(QueryParams* params, int** &off_col, int*
 
   for (int i = 0; i < qo->aggregation[cm->lo_orderdate].size(); i++) {
     ColumnInfo* column = qo->aggregation[cm->lo_orderdate][i];
-    cm->indexTransfer(col_idx, column, stream, custom);
+    cm->indexTransfer(col_idx, column, stream, custom, scope);
     cpu_to_gpu[sg] += (column->total_segment * sizeof(int));
     aggr_idx[i] = col_idx[column->column_id];
   }
@@ -4756,7 +5132,7 @@ CPUGPUProcessing::call_group_by_GPUHE(QueryParams* params, int** &off_col, int*
     if (it->second.size() > 0) {
       ColumnInfo* column = it->second[0];
       ColumnInfo* column_key = it->first;
-      cm->indexTransfer(col_idx, column, stream, custom);
+      cm->indexTransfer(col_idx, column, stream, custom, scope);
       cpu_to_gpu[sg] += (column->total_segment * sizeof(int));
       group_idx[column_key->table_id - 1] = col_idx[column->column_id];
       _min_val[column_key->table_id - 1] = params->min_val[column_key];
@@ -4777,7 +5153,7 @@ CPUGPUProcessing::call_group_by_GPUHE(QueryParams* params, int** &off_col, int*
 
   SETUP_TIMING();
   float time;
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   if (*h_total > 0) {
     groupByGPU<128,4><<<(*h_total + tile_items - 1)/tile_items, 128, 0, stream>>>(
@@ -4788,13 +5164,13 @@ CPUGPUProcessing::call_group_by_GPUHE(QueryParams* params, int** &off_col, int*
 
   if (!custom) {
     for (int i = 0; i < cm->TOT_TABLE; i++) {
-      if (off_col[i] != NULL) cudaFree(off_col[i]);
+      if (off_col[i] != NULL) deviceFree(off_col[i]);
     }
   }
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
 
   if (verbose) cout << "Group Kernel time GPU: " << time << endl;
   gpu_time[sg] += time;
@@ -4836,19 +5212,19 @@ CPUGPUProcessing::call_group_by_CPUHE(QueryParams* params, int** &h_off_col, int
 
   SETUP_TIMING();
   float time;
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   if (*h_total > 0) groupByCPUHE(offset, gargs, *h_total, params->res);
 
   if (!custom) {
     for (int i = 0; i < cm->TOT_TABLE; i++) {
-      if (h_off_col[i] != NULL) cudaFreeHost(h_off_col[i]);
+      if (h_off_col[i] != NULL) deviceFreeHost(h_off_col[i]);
     }
   }
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
 
   if (verbose) cout << "Group Kernel time CPU: " << time << endl;
   cpu_time[sg] += time;
@@ -4865,7 +5241,7 @@ CPUGPUProcessing::call_aggregation_GPUHE(QueryParams* params, int* &off_col, int
 
   for (int i = 0; i < qo->aggregation[cm->lo_orderdate].size(); i++) {
     ColumnInfo* column = qo->aggregation[cm->lo_orderdate][i];
-    cm->indexTransfer(col_idx, column, stream, custom);
+    cm->indexTransfer(col_idx, column, stream, custom, scope);
     cpu_to_gpu[sg] += (column->total_segment * sizeof(int));
     aggr_idx[i] = col_idx[column->column_id];
   }
@@ -4879,7 +5255,7 @@ CPUGPUProcessing::call_aggregation_GPUHE(QueryParams* params, int* &off_col, int
 
   SETUP_TIMING();
   float time;
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   if (*h_total > 0) {
     aggregationGPU<128,4><<<(*h_total + tile_items - 1)/tile_items, 128, 0, stream>>>(
@@ -4888,11 +5264,11 @@ CPUGPUProcessing::call_aggregation_GPUHE(QueryParams* params, int* &off_col, int
 
   CHECK_ERROR_STREAM(stream);
 
-  if (!custom) cudaFree(off_col);
+  if (!custom) deviceFree(off_col);
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
 
   if (verbose) cout << "Aggr Kernel time GPU: " << time << endl;
   gpu_time[sg] += time;
@@ -4918,17 +5294,17 @@ CPUGPUProcessing::call_aggregation_CPUHE(QueryParams* params, int* &h_off_col, i
 
   SETUP_TIMING();
   float time;
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   // assert(h_off_col != NULL);
 
   if (*h_total > 0) aggregationCPUHE(h_off_col, gargs, *h_total, params->res);
 
-  if (!custom) cudaFree(h_off_col);
+  if (!custom) deviceFree(h_off_col);
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
 
   if (verbose) cout << "Aggr Kernel time CPU: " << time << endl;
   cpu_time[sg] += time;
@@ -4946,7 +5322,7 @@ CPUGPUProcessing::call_probe_aggr_GPUHE(QueryParams* params, int** &off_col, int
     ColumnInfo* column = qo->joinGPUPipelineCol[sg][i];
     int table_id = qo->fkey_pkey[column]->table_id;
     ColumnInfo* pkey = qo->fkey_pkey[column];
-    cm->indexTransfer(col_idx, column, stream, custom);
+    cm->indexTransfer(col_idx, column, stream, custom, scope);
     cpu_to_gpu[sg] += (column->total_segment * sizeof(int));
     assert(col_idx[column->column_id] != NULL);
     fkey_idx[table_id - 1] = col_idx[column->column_id];
@@ -4957,7 +5333,7 @@ CPUGPUProcessing::call_probe_aggr_GPUHE(QueryParams* params, int** &off_col, int
 
   for (int i = 0; i < qo->aggregation[cm->lo_orderdate].size(); i++) {
     ColumnInfo* column = qo->aggregation[cm->lo_orderdate][i];
-    cm->indexTransfer(col_idx, column, stream, custom);
+    cm->indexTransfer(col_idx, column, stream, custom, scope);
     cpu_to_gpu[sg] += (column->total_segment * sizeof(int));
     aggr_idx[i] = col_idx[column->column_id];
   }
@@ -4976,11 +5352,11 @@ CPUGPUProcessing::call_probe_aggr_GPUHE(QueryParams* params, int** &off_col, int
     0, params->mode_group, params->d_group_func
   };
 
-  cudaEvent_t start, stop;
+  deviceEvent_t start, stop;
   float time;
-  cudaEventCreate(&start);
-  cudaEventCreate(&stop);
-  cudaEventRecord(start, 0);
+  deviceEventCreate(&start);
+  deviceEventCreate(&stop);
+  deviceEventRecord(start, 0);
 
   if (off_col == NULL) {
 
@@ -5011,16 +5387,16 @@ CPUGPUProcessing::call_probe_aggr_GPUHE(QueryParams* params, int** &off_col, int
 
     if (!custom) {
       for (int i = 0; i < cm->TOT_TABLE; i++) {
-        if (off_col[i] != NULL) cudaFree(off_col[i]);
+        if (off_col[i] != NULL) deviceFree(off_col[i]);
       }
     }
 
   }
 
-  cudaEventRecord(stop, 0);                  // Stop time measuring
-  cudaEventSynchronize(stop);               // Wait until the completion of all device 
-                                            // work preceding the most recent call to cudaEventRecord()
-  cudaEventElapsedTime(&time, start, stop); // Saving the time measured
+  deviceEventRecord(stop, 0);                  // Stop time measuring
+  deviceEventSynchronize(stop);               // Wait until the completion of all device 
+                                            // work preceding the most recent call to deviceEventRecord()
+  deviceEventElapsedTime(&time, start, stop); // Saving the time measured
 
   if (verbose) cout << "Probe Aggr Kernel time GPU: " << time << endl;
   gpu_time[sg] += time;
@@ -5062,11 +5438,11 @@ CPUGPUProcessing::call_probe_aggr_CPUHE(QueryParams* params, int** &h_off_col, i
     0, params->mode_group, params->h_group_func
   };
 
-  cudaEvent_t start, stop;
+  deviceEvent_t start, stop;
   float time;
-  cudaEventCreate(&start);
-  cudaEventCreate(&stop);
-  cudaEventRecord(start, 0);
+  deviceEventCreate(&start);
+  deviceEventCreate(&stop);
+  deviceEventRecord(start, 0);
 
   if (h_off_col == NULL) {
 
@@ -5090,10 +5466,10 @@ CPUGPUProcessing::call_probe_aggr_CPUHE(QueryParams* params, int** &h_off_col, i
     probe_aggr_CPU2HE(offset, pargs, gargs, *h_total, params->res, 0);
   }
 
-  cudaEventRecord(stop, 0);                  // Stop time measuring
-  cudaEventSynchronize(stop);               // Wait until the completion of all device 
-                                            // work preceding the most recent call to cudaEventRecord()
-  cudaEventElapsedTime(&time, start, stop); // Saving the time measured
+  deviceEventRecord(stop, 0);                  // Stop time measuring
+  deviceEventSynchronize(stop);               // Wait until the completion of all device 
+                                            // work preceding the most recent call to deviceEventRecord()
+  deviceEventElapsedTime(&time, start, stop); // Saving the time measured
 
   if (verbose) cout << "Probe Aggr Kernel time CPU: " << time << endl;
   cpu_time[sg] += time;
@@ -5115,7 +5491,7 @@ CPUGPUProcessing::call_pfilter_probe_aggr_GPUHE(QueryParams* params, int** &off_
   for (int i = 0; i < qo->selectGPUPipelineCol[sg].size(); i++) {
     if (select_so_far == qo->select_probe[cm->lo_orderdate].size()) break;
     ColumnInfo* column = qo->selectGPUPipelineCol[sg][i];
-    cm->indexTransfer(col_idx, column, stream, custom);
+    cm->indexTransfer(col_idx, column, stream, custom, scope);
     cpu_to_gpu[sg] += (column->total_segment * sizeof(int));
     filter_idx[select_so_far + i] = col_idx[column->column_id];
     _compare1[select_so_far + i] = params->compare1[column];
@@ -5127,7 +5503,7 @@ CPUGPUProcessing::call_pfilter_probe_aggr_GPUHE(QueryParams* params, int** &off_
     ColumnInfo* column = qo->joinGPUPipelineCol[sg][i];
     int table_id = qo->fkey_pkey[column]->table_id;
     ColumnInfo* pkey = qo->fkey_pkey[column];
-    cm->indexTransfer(col_idx, column, stream, custom);
+    cm->indexTransfer(col_idx, column, stream, custom, scope);
     cpu_to_gpu[sg] += (column->total_segment * sizeof(int));
     assert(col_idx[column->column_id] != NULL);
     fkey_idx[table_id - 1] = col_idx[column->column_id];
@@ -5138,7 +5514,7 @@ CPUGPUProcessing::call_pfilter_probe_aggr_GPUHE(QueryParams* params, int** &off_
 
   for (int i = 0; i < qo->aggregation[cm->lo_orderdate].size(); i++) {
     ColumnInfo* column = qo->aggregation[cm->lo_orderdate][i];
-    cm->indexTransfer(col_idx, column, stream, custom);
+    cm->indexTransfer(col_idx, column, stream, custom, scope);
     cpu_to_gpu[sg] += (column->total_segment * sizeof(int));
     aggr_idx[i] = col_idx[column->column_id];
   }
@@ -5165,11 +5541,11 @@ CPUGPUProcessing::call_pfilter_probe_aggr_GPUHE(QueryParams* params, int** &off_
     0, params->mode_group, params->d_group_func
   };
 
-  cudaEvent_t start, stop;   // variables that holds 2 events 
+  deviceEvent_t start, stop;   // variables that holds 2 events 
   float time;                // Variable that will hold the time
-  cudaEventCreate(&start);   // creating the event 1
-  cudaEventCreate(&stop);    // creating the event 2
-  cudaEventRecord(start, 0); // start measuring  the time
+  deviceEventCreate(&start);   // creating the event 1
+  deviceEventCreate(&stop);    // creating the event 2
+  deviceEventRecord(start, 0); // start measuring  the time
 
   if (off_col == NULL) {
 
@@ -5200,15 +5576,15 @@ CPUGPUProcessing::call_pfilter_probe_aggr_GPUHE(QueryParams* params, int** &off_
 
     if (!custom) {
       for (int i = 0; i < cm->TOT_TABLE; i++) {
-        if (off_col[i] != NULL) cudaFree(off_col[i]);
+        if (off_col[i] != NULL) deviceFree(off_col[i]);
       }
     }
 
   }
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
 
   if (verbose) cout << "Filter Probe Aggr Kernel time GPU: " << time << endl;
   gpu_time[sg] += time;
@@ -5252,7 +5628,11 @@ CPUGPUProcessing::call_pfilter_probe_aggr_CPUHE(QueryParams* params, int** &h_of
     _compare1[0], _compare2[0], _compare1[1], _compare2[1],
     1, 1,
     (filter_col[0] != NULL) ? (params->map_filter_func_host[filter_col[0]]) : (NULL), 
-    (filter_col[1] != NULL) ? (params->map_filter_func_host[filter_col[1]]) : (NULL)
+    (filter_col[1] != NULL) ? (params->map_filter_func_host[filter_col[1]]) : (NULL),
+    (filter_col[0] != NULL) ? (filter_col[0]->pack) : (NULL),
+    (filter_col[1] != NULL) ? (filter_col[1]->pack) : (NULL),
+    (filter_col[0] != NULL) ? (filter_col[0]->slice) : (NULL),
+    (filter_col[1] != NULL) ? (filter_col[1]->slice) : (NULL)
   };
 
   struct probeArgsCPU pargs = {
@@ -5269,11 +5649,11 @@ CPUGPUProcessing::call_pfilter_probe_aggr_CPUHE(QueryParams* params, int** &h_of
     0, params->mode_group, params->h_group_func
   };
 
-  cudaEvent_t start, stop;   // variables that holds 2 events 
+  deviceEvent_t start, stop;   // variables that holds 2 events 
   float time;                // Variable that will hold the time
-  cudaEventCreate(&start);   // creating the event 1
-  cudaEventCreate(&stop);    // creating the event 2
-  cudaEventRecord(start, 0); // start measuring  the time
+  deviceEventCreate(&start);   // creating the event 1
+  deviceEventCreate(&stop);    // creating the event 2
+  deviceEventRecord(start, 0); // start measuring  the time
 
   if (h_off_col == NULL) {
 
@@ -5296,9 +5676,9 @@ CPUGPUProcessing::call_pfilter_probe_aggr_CPUHE(QueryParams* params, int** &h_of
     filter_probe_aggr_CPU2HE(offset, fargs, pargs, gargs, *h_total, params->res, 0);
   }
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
 
   if (verbose) cout << "Filter Probe Aggr Kernel time CPU: " << time << endl;
   cpu_time[sg] += time;
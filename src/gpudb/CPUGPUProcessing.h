@@ -17,7 +17,12 @@ public:
   bool custom;
   bool skipping;
 
+  ProcessingScope* scope; //processing memory of the running query, released by QueryProcessing::endQuery
+  bool shared_cm; //query context over the cache of another CPUGPUProcessing
+
   int** col_idx;
+  int** pool_view; //emulated gpu only: the columns of col_idx as the running query reads them, see poolOfIndex
+  mutex pool_view_lock;
   // int** od_col_idx;
   chrono::high_resolution_clock::time_point begin_time;
   bool verbose;
@@ -44,8 +49,14 @@ public:
 
   CPUGPUProcessing(size_t _cache_size, size_t _ondemand_size, size_t _processing_size, size_t _pinned_memsize, bool _verbose, bool _custom = true, bool _skipping = true, double alpha = 0.1);
 
+  //one more query context sharing the cache manager (cache, columns, statistics) of shared,
+  //with its own optimizer state, column indexes and processing memory, for queries running concurrently
+  CPUGPUProcessing(CPUGPUProcessing* shared);
+
   ~CPUGPUProcessing() {
+    resetCGP();
     delete[] col_idx;
+    delete[] pool_view;
     // delete[] od_col_idx;
     delete[] transfer_time;
     delete[] cpu_time;
@@ -54,13 +65,19 @@ public:
 
     delete[] cpu_to_gpu;
     delete[] gpu_to_cpu;
+    if (shared_cm) {
+      delete scope;
+      cm->sessions--;
+    }
     delete qo;
   }
 
   void resetCGP() {
     for (int i = 0; i < cm->TOT_COLUMN; i++) {
-      if (col_idx[i] != NULL && !custom) cudaFree(col_idx);
+      if (col_idx[i] != NULL && !custom) deviceFree(col_idx[i]);
       col_idx[i] = NULL;
+      if (pool_view[i] != NULL) cm->releasePoolView(cm->allColumn[i], pool_view[i]);
+      pool_view[i] = NULL;
     }
     // for (int i = 0; i < cm->TOT_COLUMN; i++) {
     //   od_col_idx[i] = NULL;
@@ -69,12 +86,32 @@ public:
 
   void resetTime();
 
+  ColumnInfo* columnOfIndex(int* idx);
+
+  int* poolOfIndex(int* idx);
+
+  struct filterArgsCPU hostFilterArgs(QueryParams* params, struct filterArgsGPU fargs);
+
+  struct probeArgsCPU hostProbeArgs(struct probeArgsGPU pargs);
+
+  struct buildArgsCPU hostBuildArgs(struct buildArgsGPU bargs);
+
+  struct groupbyArgsCPU hostGroupbyArgs(QueryParams* params, struct groupbyArgsGPU gargs);
+
+  struct offsetCPU hostOffset(struct offsetGPU off);
+
   void switch_device_fact(int** &off_col, int** &h_off_col, int* &d_total, int* h_total, int sg, int mode, int table, cudaStream_t stream);
 
   void call_pfilter_probe_group_by_GPU(QueryParams* params, int** &off_col, int* h_total, int sg, int select_so_far, cudaStream_t stream);
 
   void call_pfilter_probe_group_by_CPU(QueryParams* params, int** &h_off_col, int* h_total, int sg, int select_so_far);
 
+  void call_pipeline_morsel_CPU(QueryParams* params, vector<int>& sgs);
+
+  void replicate_ht_CPU(QueryParams* params);
+
+  void free_ht_CPU_replica(QueryParams* params);
+
   void call_pfilter_probe_GPU(QueryParams* params, int** &off_col, int* &d_total, int* h_total, int sg, int select_so_far, cudaStream_t stream);
 
   void call_pfilter_probe_CPU(QueryParams* params, int** &h_off_col, int* h_total, int sg, int select_so_far);
@@ -0,0 +1,289 @@
+#include "CPUJit.h"
+#include "CPUPipeline.h"
+
+#include <dlfcn.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <chrono>
+#include <fstream>
+#include <future>
+#include <map>
+#include <mutex>
+#include <sstream>
+
+#define JIT_STRING2(X) #X
+#define JIT_STRING(X) JIT_STRING2(X)
+
+bool jit_cpu = false;
+
+//a directory only this user can write, other users could otherwise plant the objects we dlopen
+static string
+jitDefaultDir() {
+  if (getenv("MORDRED_JIT_DIR")) return getenv("MORDRED_JIT_DIR");
+  if (getenv("XDG_CACHE_HOME") && getenv("XDG_CACHE_HOME")[0] == '/') return string(getenv("XDG_CACHE_HOME")) + "/mordred-jit";
+  if (getenv("HOME") && getenv("HOME")[0] == '/') return string(getenv("HOME")) + "/.cache/mordred-jit";
+  return "/tmp/mordred-jit-" + to_string(geteuid());
+}
+
+static mutex jit_lock; //the state below, never held while the compiler runs
+static string jit_dir = jitDefaultDir();
+static string jit_cxx = getenv("MORDRED_JIT_CXX") ? getenv("MORDRED_JIT_CXX") : "c++";
+static map<string, shared_future<jitKernelCPU*>> jit_kernels; //by source, NULL for a shape that failed to compile
+static jitStatsCPU jit_stats = {0, 0, 0, 0, 0, 0};
+
+void
+setJitDir(string dir) {
+  lock_guard<mutex> guard(jit_lock);
+  jit_dir = dir;
+}
+
+void
+setJitCompiler(string cxx) {
+  lock_guard<mutex> guard(jit_lock);
+  jit_cxx = cxx;
+}
+
+jitStatsCPU
+jitStats() {
+  lock_guard<mutex> guard(jit_lock);
+  return jit_stats;
+}
+
+string
+jitSource(jitShapeCPU& shape) {
+  ostringstream src;
+  src << "//generated by mordred: " << shape.num_filter << " filters, " << shape.num_probe << " probes, "
+    << shape.num_group << " group by columns\n";
+  src << "typedef struct jitArgsCPU { " << JIT_STRING(JIT_ARGS_CPU_FIELDS) << " } jitArgsCPU;\n\n";
+
+  src << "template <bool ATOMIC>\n";
+  src << "static inline long long pipeline(const jitArgsCPU* a, int col_start, int num, int* table) {\n";
+  for (int j = 0; j < shape.num_filter; j++)
+    src << "  const int* f" << j << " = a->filter_col[" << j << "]; const int lo" << j << " = a->compare_lo[" << j << "], hi" << j << " = a->compare_hi[" << j << "];\n";
+  for (int j = 0; j < shape.num_probe; j++)
+    src << "  const int* k" << j << " = a->key_col[" << j << "]; const long long* ht" << j << " = a->ht[" << j << "];"
+      << " const int len" << j << " = a->dim_len[" << j << "], min" << j << " = a->min_key[" << j << "];\n";
+  for (int j = 0; j < shape.num_group; j++)
+    src << "  const int min_val" << j << " = a->min_val[" << j << "], unique_val" << j << " = a->unique_val[" << j << "];\n";
+  src << "  const int hash_base = a->hash_base, total_val = a->total_val;\n";
+  src << "  const int* aggr1 = a->aggr_col1; const int* aggr2 = a->aggr_col2;\n";
+  src << "  long long sum = 0;\n";
+  src << "  for (int i = col_start; i < col_start + num; i++) {\n";
+
+  for (int j = 0; j < shape.num_filter; j++) {
+    if (shape.filter_op[j] == SelectRange)
+      src << "    if (!(f" << j << "[i] >= lo" << j << " && f" << j << "[i] <= hi" << j << ")) continue;\n";
+    else if (shape.filter_op[j] == SelectEQ)
+      src << "    if (!(f" << j << "[i] == lo" << j << ")) continue;\n";
+    else
+      src << "    if (!(f" << j << "[i] == lo" << j << " || f" << j << "[i] == hi" << j << ")) continue;\n";
+  }
+
+  for (int j = 0; j < shape.num_probe; j++) {
+    src << "    long long s" << j << " = ht" << j << "[(k" << j << "[i] - min" << j << ") % len" << j << "];\n";
+    src << "    if (s" << j << " == 0) continue;\n";
+    src << "    int v" << j << " = (int) s" << j << ";\n";
+  }
+
+  if (shape.aggr == AggrCol) src << "    int temp = aggr1[i];\n";
+  else if (shape.aggr == AggrSub) src << "    int temp = aggr1[i] - aggr2[i];\n";
+  else src << "    int temp = aggr1[i] * aggr2[i];\n";
+
+  if (shape.num_group == 0) {
+    src << "    sum += temp;\n";
+  } else {
+    src << "    int hash = (hash_base";
+    for (int j = 0; j < shape.num_group; j++)
+      src << " + (v" << shape.group_probe[j] << " - min_val" << j << ") * unique_val" << j;
+    src << ") % total_val;\n";
+    src << "    int* out = table + hash * 6;\n";
+    for (int j = 0; j < shape.num_probe; j++)
+      src << "    if (v" << j << " != 0) out[" << shape.table[j] << "] = v" << j << ";\n";
+    src << "    if (ATOMIC) __atomic_fetch_add(reinterpret_cast<unsigned long long*>(out + 4), (long long) temp, __ATOMIC_RELAXED);\n";
+    src << "    else reinterpret_cast<long long*>(out)[2] += temp;\n";
+  }
+
+  src << "  }\n";
+  src << "  return sum;\n";
+  src << "}\n\n";
+  src << "extern \"C\" long long pipeline_atomic(const jitArgsCPU* a, int col_start, int num, int* table) { return pipeline<true>(a, col_start, num, table); }\n";
+  src << "extern \"C\" long long pipeline_local(const jitArgsCPU* a, int col_start, int num, int* table) { return pipeline<false>(a, col_start, num, table); }\n";
+  return src.str();
+}
+
+//-march=native targets the cpu the object is built on, a directory shared between machines (nfs home) must
+//not hand it to another model
+static string
+jitCpu() {
+  ifstream in("/proc/cpuinfo");
+  string line, model, flags;
+  while (getline(in, line) && (model.empty() || flags.empty())) {
+    if (model.empty() && line.compare(0, 10, "model name") == 0) model = line;
+    if (flags.empty() && (line.compare(0, 5, "flags") == 0 || line.compare(0, 8, "Features") == 0)) flags = line;
+  }
+  return model + "\n" + flags;
+}
+
+//fnv-1a of the source, the compiler and the cpu, the name of the compiled object
+static string
+jitKey(const string& source, const string& command) {
+  static const string cpu = jitCpu();
+  unsigned long long hash = 14695981039346656037ULL;
+  string text = source + command + cpu;
+  for (int i = 0; i < text.size(); i++) {
+    hash ^= (unsigned char) text[i];
+    hash *= 1099511628211ULL;
+  }
+  char key[17];
+  snprintf(key, sizeof(key), "%016llx", hash);
+  return key;
+}
+
+static double
+elapsedMs(chrono::high_resolution_clock::time_point start) {
+  chrono::duration<double, milli> diff = chrono::high_resolution_clock::now() - start;
+  return diff.count();
+}
+
+//created 0700 if missing, refused when another user owns it or can write to it
+static bool
+jitPrepareDir(const string& dir) {
+  size_t slash = dir.find_last_of('/');
+  if (slash != string::npos && slash > 0) mkdir(dir.substr(0, slash).c_str(), 0700); //~/.cache may not exist yet
+  if (mkdir(dir.c_str(), 0700) != 0 && errno != EEXIST) {
+    fprintf(stderr, "Could not create jit directory %s\n", dir.c_str());
+    return false;
+  }
+  struct stat st;
+  if (lstat(dir.c_str(), &st) != 0 || !S_ISDIR(st.st_mode) || st.st_uid != geteuid() || (st.st_mode & (S_IWGRP | S_IWOTH))) {
+    fprintf(stderr, "Refusing jit directory %s: not a directory owned by this user and writable only by it\n", dir.c_str());
+    return false;
+  }
+  return true;
+}
+
+//same check for the object, a regular file of this user nobody else can rewrite
+static bool
+jitTrusted(const string& object) {
+  struct stat st;
+  return lstat(object.c_str(), &st) == 0 && S_ISREG(st.st_mode) && st.st_uid == geteuid() && !(st.st_mode & (S_IWGRP | S_IWOTH));
+}
+
+static jitKernelCPU*
+jitLoad(const string& object) {
+  if (!jitTrusted(object)) {
+    fprintf(stderr, "Refusing to load %s: not owned by this user or writable by others\n", object.c_str());
+    return NULL;
+  }
+  void* handle = dlopen(object.c_str(), RTLD_NOW | RTLD_LOCAL);
+  if (handle == NULL) return NULL;
+  jitKernelCPU* kernel = new jitKernelCPU();
+  kernel->atomic = (jit_pipeline_t) dlsym(handle, "pipeline_atomic");
+  kernel->local = (jit_pipeline_t) dlsym(handle, "pipeline_local");
+  if (kernel->atomic == NULL || kernel->local == NULL) {
+    delete kernel;
+    dlclose(handle);
+    return NULL;
+  }
+  //the handle stays open for the lifetime of the process, like the kernels of the cache
+  return kernel;
+}
+
+//disk cache lookup or compile of one shape, called without jit_lock so other shapes (and the memory hits)
+//go on while the compiler runs; the counters are added under the lock
+static jitKernelCPU*
+jitBuild(const string& source, const string& dir, const string& cxx) {
+  string flags = "-O3 -march=native -std=c++11 -fPIC -shared";
+  string key = jitKey(source, cxx + " " + flags);
+  string object = dir + "/pipeline_" + key + ".so";
+  jitStatsCPU stats = {0, 0, 0, 0, 0, 0};
+  jitKernelCPU* kernel = NULL;
+
+  if (!jitPrepareDir(dir)) {
+    stats.failures++;
+  } else {
+    chrono::high_resolution_clock::time_point start;
+    if (access(object.c_str(), R_OK) == 0) {
+      start = chrono::high_resolution_clock::now();
+      kernel = jitLoad(object);
+      stats.load_ms += elapsedMs(start);
+      if (kernel != NULL) stats.disk_hits++;
+    }
+
+    if (kernel == NULL) {
+      //written under a private name and renamed, other processes sharing the directory never load half an object
+      string tmp = dir + "/pipeline_" + key + "." + to_string(getpid());
+      int fd = open((tmp + ".cpp").c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_NOFOLLOW, 0600);
+      FILE* fptr = fd >= 0 ? fdopen(fd, "w") : NULL;
+      if (fptr == NULL) {
+        fprintf(stderr, "Could not write %s.cpp\n", tmp.c_str());
+        if (fd >= 0) close(fd);
+        stats.failures++;
+      } else {
+        fputs(source.c_str(), fptr);
+        fclose(fptr);
+
+        string command = cxx + " " + flags + " -o " + tmp + ".so " + tmp + ".cpp";
+        start = chrono::high_resolution_clock::now();
+        int status = system(command.c_str());
+        stats.compile_ms += elapsedMs(start);
+        remove((tmp + ".cpp").c_str());
+
+        if (status != 0 || rename((tmp + ".so").c_str(), object.c_str()) != 0) {
+          fprintf(stderr, "Could not compile pipeline (%s)\n", command.c_str());
+          remove((tmp + ".so").c_str());
+          stats.failures++;
+        } else {
+          stats.compiles++;
+          start = chrono::high_resolution_clock::now();
+          kernel = jitLoad(object);
+          stats.load_ms += elapsedMs(start);
+          if (kernel == NULL) {
+            fprintf(stderr, "Could not load %s: %s\n", object.c_str(), dlerror());
+            stats.failures++;
+          }
+        }
+      }
+    }
+  }
+
+  lock_guard<mutex> guard(jit_lock);
+  jit_stats.compiles += stats.compiles;
+  jit_stats.disk_hits += stats.disk_hits;
+  jit_stats.failures += stats.failures;
+  jit_stats.compile_ms += stats.compile_ms;
+  jit_stats.load_ms += stats.load_ms;
+  return kernel;
+}
+
+jitKernelCPU*
+jitPipelineCPU(jitShapeCPU& shape) {
+  string source = jitSource(shape);
+
+  unique_lock<mutex> lock(jit_lock);
+  auto it = jit_kernels.find(source);
+  if (it != jit_kernels.end()) {
+    //a shape another thread is still compiling waits for it instead of compiling it again
+    shared_future<jitKernelCPU*> pending = it->second;
+    lock.unlock();
+    jitKernelCPU* kernel = pending.get();
+    if (kernel != NULL) {
+      lock_guard<mutex> guard(jit_lock);
+      jit_stats.memory_hits++;
+    }
+    return kernel;
+  }
+
+  promise<jitKernelCPU*> built;
+  jit_kernels[source] = built.get_future().share();
+  string dir = jit_dir, cxx = jit_cxx;
+  lock.unlock();
+
+  jitKernelCPU* kernel = jitBuild(source, dir, cxx);
+  built.set_value(kernel);
+  return kernel;
+}
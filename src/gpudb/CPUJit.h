@@ -0,0 +1,68 @@
+#ifndef _CPU_JIT_H_
+#define _CPU_JIT_H_
+
+#include <string>
+
+//code generation backend of the fused cpu pipelines. the shape of a pipeline (its filters, the hash tables it
+//probes and the res column each one fills, its group by columns and aggregate) becomes C++ with all of it as
+//constants, one loop per row with the values in registers. the source is compiled out of process by the host
+//compiler into a shared object and dlopen'ed. objects are kept in a directory keyed by the hash of the source,
+//so a pipeline shape is compiled once across runs; its columns, predicate constants and hash tables are
+//arguments (jitArgsCPU) and do not change the key
+
+//the fields the generated code reads, pasted as is into every generated source
+#define JIT_ARGS_CPU_FIELDS \
+  int* filter_col[2]; int compare_lo[2]; int compare_hi[2]; \
+  int* key_col[4]; long long* ht[4]; int dim_len[4]; int min_key[4]; \
+  int min_val[4]; int unique_val[4]; int hash_base; int total_val; \
+  int* aggr_col1; int* aggr_col2;
+
+typedef struct jitArgsCPU {
+  JIT_ARGS_CPU_FIELDS
+} jitArgsCPU;
+
+typedef struct jitShapeCPU {
+  int num_filter;
+  int filter_op[2]; //SelectOp
+  int num_probe;
+  int table[4]; //res column of the value of probe j
+  int num_group;
+  int group_probe[4]; //probe whose value is group by column j
+  int aggr; //AggrExprCPU
+} jitShapeCPU;
+
+//rows col_start .. col_start + num - 1 of the fact table. with a group by the groups are added to table
+//(6 int per group like res), the aggregate of a pipeline without group by is returned
+typedef long long (*jit_pipeline_t)(const jitArgsCPU* args, int col_start, int num, int* table);
+
+typedef struct jitKernelCPU {
+  jit_pipeline_t atomic; //table shared by all threads
+  jit_pipeline_t local; //table private to the calling thread
+} jitKernelCPU;
+
+typedef struct jitStatsCPU {
+  int compiles;
+  int disk_hits; //compiled by an earlier run
+  int memory_hits;
+  int failures;
+  double compile_ms; //compiler runs only
+  double load_ms; //dlopen of new and cached objects
+} jitStatsCPU;
+
+extern bool jit_cpu;
+
+//directory of the compiled pipelines, MORDRED_JIT_DIR or $XDG_CACHE_HOME/mordred-jit, ~/.cache/mordred-jit or
+//mordred-jit-<uid> in /tmp without a home. it must belong to the user and be writable by nobody else
+void setJitDir(std::string dir);
+
+//host compiler, MORDRED_JIT_CXX or c++
+void setJitCompiler(std::string cxx);
+
+jitStatsCPU jitStats();
+
+std::string jitSource(jitShapeCPU& shape);
+
+//compiled pipeline of shape, NULL when it can not be compiled (the caller runs the template pipeline then)
+jitKernelCPU* jitPipelineCPU(jitShapeCPU& shape);
+
+#endif
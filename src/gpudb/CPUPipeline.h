@@ -0,0 +1,252 @@
+#ifndef _CPU_PIPELINE_H_
+#define _CPU_PIPELINE_H_
+
+#include "CPUProcessing.h"
+#include "CPUJit.h"
+
+//fused probe and group by (or aggregation) loops of the cpu, one instance per number of hash tables probed,
+//group by arity and aggregate expression. the tables, group by columns and aggregate of a call are fixed by
+//the plan, so pipelineBatchCPU picks the instance once per call and the row loop has no NULL column tests,
+//mode tests or calls through filter_func_t_host / group_func_t left. the fact filters run before it batch at a
+//time through the selection vector primitives of SIMDSelect.h, which are specialized per predicate already
+
+enum AggrExprCPU {
+  AggrCol, //aggr_col1
+  AggrSub, //aggr_col1 - aggr_col2
+  AggrMul //aggr_col1 * aggr_col2
+};
+
+//probeArgsCPU and groupbyArgsCPU with the tables and columns a call does not use left out
+typedef struct pipelineArgsCPU {
+  int num_probe;
+  int* key_col[4];
+  long long* ht[4];
+  int dim_len[4];
+  int min_key[4];
+  int table[4]; //table of probe j, its value goes to res column table[j]
+
+  int num_group;
+  int group_probe[4]; //probe whose value is group by column j
+  int min_val[4];
+  int unique_val[4];
+  int hash_base; //part of the group hash of group by columns no probe gives a value for
+  int total_val;
+
+  int* aggr_col1;
+  int* aggr_col2;
+  AggrExprCPU aggr;
+
+  struct probeArgsCPU pargs; //the batched probe modes go through probeBatchCPU
+} pipelineArgsCPU;
+
+static inline AggrExprCPU
+aggrExprCPU(struct groupbyArgsCPU& gargs) {
+  if (gargs.aggr_col2 == NULL) return AggrCol;
+  if (gargs.h_group_func == &host_mul_func<int>) return AggrMul;
+  return AggrSub;
+}
+
+static inline pipelineArgsCPU
+pipelineArgs(struct probeArgsCPU& pargs, struct groupbyArgsCPU& gargs) {
+  int* key_col[4] = {pargs.key_col1, pargs.key_col2, pargs.key_col3, pargs.key_col4};
+  int* ht[4] = {pargs.ht1, pargs.ht2, pargs.ht3, pargs.ht4};
+  int dim_len[4] = {pargs.dim_len1, pargs.dim_len2, pargs.dim_len3, pargs.dim_len4};
+  int min_key[4] = {pargs.min_key1, pargs.min_key2, pargs.min_key3, pargs.min_key4};
+  int min_val[4] = {gargs.min_val1, gargs.min_val2, gargs.min_val3, gargs.min_val4};
+  int unique_val[4] = {gargs.unique_val1, gargs.unique_val2, gargs.unique_val3, gargs.unique_val4};
+
+  assert(gargs.aggr_col1 != NULL);
+
+  pipelineArgsCPU args = {};
+  int probe_of[4] = {-1, -1, -1, -1};
+  for (int k = 0; k < 4; k++) {
+    if (key_col[k] == NULL || ht[k] == NULL) continue;
+    int j = args.num_probe++;
+    args.key_col[j] = key_col[k];
+    args.ht[j] = reinterpret_cast<long long*>(ht[k]);
+    args.dim_len[j] = dim_len[k];
+    args.min_key[j] = min_key[k];
+    args.table[j] = k;
+    probe_of[k] = j;
+  }
+
+  //a table without a probe adds (0 - min_val) * unique_val to every group hash, like in the generic kernels
+  for (int k = 0; k < 4; k++) {
+    if (unique_val[k] == 0) continue;
+    if (probe_of[k] < 0) {
+      args.hash_base += (0 - min_val[k]) * unique_val[k];
+      continue;
+    }
+    int j = args.num_group++;
+    args.group_probe[j] = probe_of[k];
+    args.min_val[j] = min_val[k];
+    args.unique_val[j] = unique_val[k];
+  }
+
+  args.total_val = gargs.total_val;
+  args.aggr_col1 = gargs.aggr_col1;
+  args.aggr_col2 = gargs.aggr_col2;
+  args.aggr = aggrExprCPU(gargs);
+  args.pargs = pargs;
+  return args;
+}
+
+template <int PROBES, int GROUPS, AggrExprCPU AGGR>
+struct pipelineCPU {
+
+  static inline int aggrValue(pipelineArgsCPU& args, int lo_offset) {
+    if (AGGR == AggrCol) return args.aggr_col1[lo_offset];
+    if (AGGR == AggrSub) return args.aggr_col1[lo_offset] - args.aggr_col2[lo_offset];
+    return args.aggr_col1[lo_offset] * args.aggr_col2[lo_offset];
+  }
+
+  static inline void emit(pipelineArgsCPU& args, GroupByCPU* gb, int* table, groupbyBufferCPU* part,
+    long long& sum, int lo_offset, int (&val)[4]) {
+
+    int temp = aggrValue(args, lo_offset);
+    if (GROUPS == 0) {
+      sum += temp;
+      return;
+    }
+
+    int hash = args.hash_base;
+    for (int j = 0; j < GROUPS; j++) hash += (val[args.group_probe[j]] - args.min_val[j]) * args.unique_val[j];
+    hash = hash % args.total_val;
+
+    int key[4] = {0, 0, 0, 0};
+    for (int j = 0; j < PROBES; j++) key[args.table[j]] = val[j];
+    gb->aggregate(table, part, hash, key[0], key[1], key[2], key[3], temp);
+  }
+
+  //rows sel[0] .. sel[num - 1] of the fact table, gb is NULL for an aggregation (GROUPS == 0) which adds to sum
+  static void batch(pipelineArgsCPU& args, int* sel, int num, GroupByCPU* gb, int* table, groupbyBufferCPU* part, long long& sum) {
+    int val[4];
+
+    if (PROBES > 0 && probe_mode_cpu != ProbeDirect) {
+      long long slot[4][BATCH_SIZE];
+      int count = probeBatchCPU(probe_mode_cpu, args.pargs, sel, NULL, num, slot);
+      for (int i = 0; i < count; i++) {
+        for (int j = 0; j < PROBES; j++) val[j] = slot[args.table[j]][i];
+        emit(args, gb, table, part, sum, sel[i], val);
+      }
+      return;
+    }
+
+    for (int i = 0; i < num; i++) {
+      int lo_offset = sel[i];
+      int j = 0;
+      for (; j < PROBES; j++) {
+        long long slot = args.ht[j][HASH(args.key_col[j][lo_offset], args.dim_len[j], args.min_key[j])];
+        if (slot == 0) break;
+        val[j] = slot;
+      }
+      if (j < PROBES) continue;
+      emit(args, gb, table, part, sum, lo_offset, val);
+    }
+  }
+};
+
+typedef void (*pipeline_batch_t)(pipelineArgsCPU&, int*, int, GroupByCPU*, int*, groupbyBufferCPU*, long long&);
+
+template <int PROBES, int GROUPS>
+static inline pipeline_batch_t
+pipelineAggr(AggrExprCPU aggr) {
+  if (aggr == AggrCol) return &pipelineCPU<PROBES, GROUPS, AggrCol>::batch;
+  if (aggr == AggrSub) return &pipelineCPU<PROBES, GROUPS, AggrSub>::batch;
+  return &pipelineCPU<PROBES, GROUPS, AggrMul>::batch;
+}
+
+//a group by column always comes from one of the probes, so GROUPS <= PROBES
+template <int PROBES>
+static inline pipeline_batch_t
+pipelineGroups(pipelineArgsCPU& args) {
+  assert(args.num_group <= PROBES);
+  switch (args.num_group) {
+    case 0: return pipelineAggr<PROBES, 0>(args.aggr);
+    case 1: return pipelineAggr<PROBES, (PROBES < 1) ? PROBES : 1>(args.aggr);
+    case 2: return pipelineAggr<PROBES, (PROBES < 2) ? PROBES : 2>(args.aggr);
+    case 3: return pipelineAggr<PROBES, (PROBES < 3) ? PROBES : 3>(args.aggr);
+    default: return pipelineAggr<PROBES, PROBES>(args.aggr);
+  }
+}
+
+static inline pipeline_batch_t
+pipelineBatchCPU(pipelineArgsCPU& args) {
+  switch (args.num_probe) {
+    case 0: return pipelineGroups<0>(args);
+    case 1: return pipelineGroups<1>(args);
+    case 2: return pipelineGroups<2>(args);
+    case 3: return pipelineGroups<3>(args);
+    default: return pipelineGroups<4>(args);
+  }
+}
+
+//the pipeline of one kernel call: the generated code of its shape when jit_cpu is on and it compiled,
+//else the template instance behind the fact filters
+typedef struct pipelineCallCPU {
+  pipelineArgsCPU args;
+  pipeline_batch_t batch;
+  jitArgsCPU jargs;
+  jitKernelCPU* jit;
+} pipelineCallCPU;
+
+//gb is the group by state of the call, NULL for an aggregation. the generated code has no partitioned group by
+static inline pipelineCallCPU
+pipelineCall(struct filterArgsCPU& fargs, struct probeArgsCPU& pargs, struct groupbyArgsCPU& gargs, GroupByCPU* gb) {
+  pipelineCallCPU call;
+  call.args = pipelineArgs(pargs, gargs);
+  call.batch = pipelineBatchCPU(call.args);
+  call.jit = NULL;
+  if (!jit_cpu || (gb != NULL && gb->mode == GroupByPartitioned)) return call;
+
+  pipelineArgsCPU& args = call.args;
+  jitShapeCPU shape = {};
+  jitArgsCPU jargs = {};
+  int* filter_col[2] = {fargs.filter_col1, fargs.filter_col2};
+  int mode[2] = {fargs.mode1, fargs.mode2};
+  int lo[2] = {fargs.compare1, fargs.compare3};
+  int hi[2] = {fargs.compare2, fargs.compare4};
+  //same filters as filterDenseCPU, mode 2 with one value is compiled as two equal values
+  for (int k = 0; k < 2; k++) {
+    if (filter_col[k] == NULL || (mode[k] != 1 && mode[k] != 2)) continue;
+    int j = shape.num_filter++;
+    shape.filter_op[j] = (mode[k] == 1) ? SelectRange : SelectIN2;
+    jargs.filter_col[j] = filter_col[k];
+    jargs.compare_lo[j] = lo[k];
+    jargs.compare_hi[j] = hi[k];
+  }
+  shape.num_probe = args.num_probe;
+  for (int j = 0; j < args.num_probe; j++) {
+    shape.table[j] = args.table[j];
+    jargs.key_col[j] = args.key_col[j];
+    jargs.ht[j] = args.ht[j];
+    jargs.dim_len[j] = args.dim_len[j];
+    jargs.min_key[j] = args.min_key[j];
+  }
+  shape.num_group = args.num_group;
+  for (int j = 0; j < args.num_group; j++) {
+    shape.group_probe[j] = args.group_probe[j];
+    jargs.min_val[j] = args.min_val[j];
+    jargs.unique_val[j] = args.unique_val[j];
+  }
+  jargs.hash_base = args.hash_base;
+  jargs.total_val = args.total_val;
+  jargs.aggr_col1 = args.aggr_col1;
+  jargs.aggr_col2 = args.aggr_col2;
+  shape.aggr = args.aggr;
+
+  call.jargs = jargs;
+  call.jit = jitPipelineCPU(shape);
+  return call;
+}
+
+//filter, probe and group by (or aggregate when gargs has no group by column) of the num_tuples rows of
+//segment_group, or of the rows from start_offset when it is NULL, over all cores
+void pipelineDenseCPU(struct filterArgsCPU& fargs, struct probeArgsCPU& pargs, struct groupbyArgsCPU& gargs,
+  int num_tuples, int* res, int start_offset, short* segment_group);
+
+//same for num_tuples rows from start_offset on the calling thread, the group by adds to res atomically
+void pipelineSerialCPU(struct filterArgsCPU& fargs, struct probeArgsCPU& pargs, struct groupbyArgsCPU& gargs,
+  int num_tuples, int* res, int start_offset);
+
+#endif
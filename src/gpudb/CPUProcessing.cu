@@ -1,4 +1,521 @@
 #include "CPUProcessing.h"
+#include "CPUPipeline.h"
+
+bool packed_scan_cpu = true;
+bool sliced_scan_cpu = true;
+
+//rows col_offset .. col_offset + num - 1 of col passing mode, lo, hi. a segment the column has packed is
+//filtered on its codes, the predicate rewritten for the segment (or the segment dropped) by packPredicate
+static inline int selectColumnDense(int* col, packedColumn* pack, int mode, int lo, int hi, int col_offset, int num, int* sel) {
+  if (pack == NULL || !packed_scan_cpu) return selectDense(selectOp(mode, lo, hi), col, col_offset, num, lo, hi, sel);
+
+  int segment = col_offset / pack->seg_size;
+  int segment_end = (segment + 1) * pack->seg_size;
+  if (col_offset + num > segment_end) {
+    int count = selectColumnDense(col, pack, mode, lo, hi, col_offset, segment_end - col_offset, sel);
+    return count + selectColumnDense(col, pack, mode, lo, hi, segment_end, col_offset + num - segment_end, sel + count);
+  }
+
+  const segmentPack& seg = pack->segment[segment];
+  if (seg.encoding == PackNone) return selectDense(selectOp(mode, lo, hi), col, col_offset, num, lo, hi, sel);
+  int code_lo = lo, code_hi = hi;
+  if (!packPredicate(pack, segment, mode, code_lo, code_hi)) return 0;
+  //without a vector unpack decoding costs more than the bytes it saves
+  if (getSelectISA() < SelectAVX2) return selectDense(selectOp(mode, lo, hi), col, col_offset, num, lo, hi, sel);
+  return selectPacked(selectOp(mode, code_lo, code_hi), packBlocks(pack, segment), seg.bits, col_offset % pack->seg_size, num, col_offset, code_lo, code_hi, sel);
+}
+
+//same for the rows listed in sel_in, sel_out may be sel_in. rows picked one by one are read from the raw
+//column (a gather of the raw values is cheaper than decoding codes row by row), the packed segments only
+//drop the runs of rows of a segment packPredicate rules out
+static inline int selectColumnSparse(int* col, packedColumn* pack, int mode, int lo, int hi, int* sel_in, int num, int* sel_out) {
+  if (pack == NULL || !packed_scan_cpu) return selectSparse(selectOp(mode, lo, hi), col, sel_in, num, lo, hi, sel_out);
+
+  int count = 0;
+  for (int i = 0; i < num; ) {
+    int segment = sel_in[i] / pack->seg_size;
+    int segment_end = (segment + 1) * pack->seg_size;
+    int j = i + 1;
+    while (j < num && sel_in[j] >= segment * pack->seg_size && sel_in[j] < segment_end) j++;
+
+    int code_lo = lo, code_hi = hi;
+    if (pack->segment[segment].encoding == PackNone || packPredicate(pack, segment, mode, code_lo, code_hi))
+      count += selectSparse(selectOp(mode, lo, hi), col, sel_in + i, j - i, lo, hi, sel_out + count);
+    i = j;
+  }
+  return count;
+}
+
+//bitmap of the rows col_offset .. col_offset + num - 1 passing mode, lo, hi, from the bit planes of the column.
+//false when the rows are not in one sliced segment or do not start on a word of the planes
+static inline bool sliceColumnDense(slicedColumn* slice, int mode, int lo, int hi, int col_offset, int num, unsigned long long* bitmap) {
+  if (slice == NULL || col_offset % 64 != 0 || num > TASK_SIZE) return false;
+
+  int segment = col_offset / slice->seg_size;
+  if (col_offset + num > (segment + 1) * slice->seg_size) return false;
+  const segmentSlice& seg = slice->segment[segment];
+  if (seg.bits == 0) return false;
+
+  if (!slicePredicate(slice, segment, mode, lo, hi)) memset(bitmap, 0, (num + 63) / 64 * sizeof(unsigned long long));
+  else sliceBitmap(selectOp(mode, lo, hi), sliceBlocks(slice, segment), seg.bits, col_offset % slice->seg_size, num, lo, hi, bitmap);
+  return true;
+}
+
+//filterDenseCPU with the sliced filters and'ed as bitmaps and the others applied to the selection vector after,
+//-1 when no filter has slices for the rows
+static inline int filterSlicedCPU(struct filterArgsCPU& fargs, bool filter1, bool filter2, int col_offset, int num, int* sel) {
+  unsigned long long bitmap[TASK_SIZE / 64], other[TASK_SIZE / 64];
+  bool slice1 = filter1 && sliceColumnDense(fargs.filter_slice1, fargs.mode1, fargs.compare1, fargs.compare2, col_offset, num, bitmap);
+  bool slice2 = filter2 && sliceColumnDense(fargs.filter_slice2, fargs.mode2, fargs.compare3, fargs.compare4, col_offset, num, slice1 ? other : bitmap);
+  if (!slice1 && !slice2) return -1;
+  if (slice1 && slice2)
+    for (int w = 0; w < (num + 63) / 64; w++) bitmap[w] &= other[w];
+
+  int count = selectBitmap(bitmap, num, col_offset, sel);
+  if (filter1 && !slice1 && count > 0)
+    count = selectColumnSparse(fargs.filter_col1, fargs.filter_pack1, fargs.mode1, fargs.compare1, fargs.compare2, sel, count, sel);
+  if (filter2 && !slice2 && count > 0)
+    count = selectColumnSparse(fargs.filter_col2, fargs.filter_pack2, fargs.mode2, fargs.compare3, fargs.compare4, sel, count, sel);
+  return count;
+}
+
+//selection vector of the rows col_offset .. col_offset + num - 1 passing both filters of fargs
+static inline int filterDenseCPU(struct filterArgsCPU& fargs, int col_offset, int num, int* sel) {
+  bool filter1 = (fargs.filter_col1 != NULL && (fargs.mode1 == 1 || fargs.mode1 == 2));
+  bool filter2 = (fargs.filter_col2 != NULL && (fargs.mode2 == 1 || fargs.mode2 == 2));
+  int count;
+
+  if (sliced_scan_cpu && (fargs.filter_slice1 != NULL || fargs.filter_slice2 != NULL)) {
+    count = filterSlicedCPU(fargs, filter1, filter2, col_offset, num, sel);
+    if (count >= 0) return count;
+  }
+
+  if (filter1) {
+    count = selectColumnDense(fargs.filter_col1, fargs.filter_pack1, fargs.mode1, fargs.compare1, fargs.compare2, col_offset, num, sel);
+  } else if (filter2) {
+    return selectColumnDense(fargs.filter_col2, fargs.filter_pack2, fargs.mode2, fargs.compare3, fargs.compare4, col_offset, num, sel);
+  } else {
+    for (int i = 0; i < num; i++) sel[i] = col_offset + i;
+    return num;
+  }
+
+  if (filter2 && count > 0)
+    count = selectColumnSparse(fargs.filter_col2, fargs.filter_pack2, fargs.mode2, fargs.compare3, fargs.compare4, sel, count, sel);
+  return count;
+}
+
+//same as filterDenseCPU for the rows listed in off
+static inline int filterSparseCPU(struct filterArgsCPU& fargs, int* off, int num, int* sel) {
+  bool filter1 = (fargs.filter_col1 != NULL && (fargs.mode1 == 1 || fargs.mode1 == 2));
+  bool filter2 = (fargs.filter_col2 != NULL && (fargs.mode2 == 1 || fargs.mode2 == 2));
+  int count;
+
+  if (filter1) {
+    count = selectColumnSparse(fargs.filter_col1, fargs.filter_pack1, fargs.mode1, fargs.compare1, fargs.compare2, off, num, sel);
+  } else {
+    memcpy(sel, off, num * sizeof(int));
+    count = num;
+  }
+
+  if (filter2 && count > 0)
+    count = selectColumnSparse(fargs.filter_col2, fargs.filter_pack2, fargs.mode2, fargs.compare3, fargs.compare4, sel, count, sel);
+  return count;
+}
+
+GroupByModeCPU group_by_mode_cpu = GroupByAuto;
+
+GroupByModeCPU
+GroupByCPU::chooseMode(int total_val, int num_tuples) {
+  if (group_by_mode_cpu != GroupByAuto) return group_by_mode_cpu;
+  //too few tuples to pay for zeroing and merging the private tables
+  if (num_tuples < total_val) return GroupByAtomic;
+  if ((size_t) total_val * 6 * sizeof(int) <= GROUPBY_CACHE_SIZE) return GroupByLocal;
+  return GroupByPartitioned;
+}
+
+GroupByCPU::GroupByCPU(int* _res, int _total_val, int num_tuples)
+: res(_res), total_val(_total_val), num_part(1), part_bits(0), part_sum(NULL), part_lock(NULL), local_res(NULL), local_part(NULL) {
+  assert(res != NULL);
+  assert(total_val > 0);
+
+  mode = chooseMode(total_val, num_tuples);
+
+  if (mode == GroupByLocal) {
+    local_res = new enumerable_thread_specific<vector<long long>>(vector<long long>((size_t) total_val * 3, 0));
+  } else if (mode == GroupByPartitioned) {
+    //every partition sums into a cache resident range of part_sum
+    while (((size_t) sizeof(long long) << (part_bits + 1)) <= GROUPBY_CACHE_SIZE) part_bits++;
+    num_part = ((total_val - 1) >> part_bits) + 1;
+    part_sum = new long long[total_val]();
+    part_lock = new mutex[num_part];
+
+    groupbyBufferCPU buffer;
+    buffer.entry.resize((size_t) num_part * GROUPBY_CHUNK);
+    buffer.fill.assign(num_part, 0);
+    local_part = new enumerable_thread_specific<groupbyBufferCPU>(buffer);
+  }
+}
+
+GroupByCPU::~GroupByCPU() {
+  if (local_res != NULL) delete local_res;
+  if (local_part != NULL) delete local_part;
+  if (part_sum != NULL) delete[] part_sum;
+  if (part_lock != NULL) delete[] part_lock;
+}
+
+int*
+GroupByCPU::localTable() {
+  if (mode == GroupByAtomic) return res;
+  if (mode == GroupByLocal) return reinterpret_cast<int*>(local_res->local().data());
+  return NULL;
+}
+
+groupbyBufferCPU*
+GroupByCPU::localPartition() {
+  if (mode == GroupByPartitioned) return &(local_part->local());
+  return NULL;
+}
+
+//keys are read before written so hot groups stay shared in cache
+void
+GroupByCPU::aggregateEntries(const groupbyEntryCPU* entry, int num) {
+  for (int i = 0; i < num; i++) {
+    int* out = res + entry[i].hash * 6;
+    for (int k = 0; k < 4; k++)
+      if (entry[i].key[k] != 0 && out[k] != entry[i].key[k]) out[k] = entry[i].key[k];
+    part_sum[entry[i].hash] += entry[i].val;
+  }
+}
+
+void
+GroupByCPU::flush(groupbyBufferCPU* part, int p) {
+  lock_guard<mutex> lock(part_lock[p]);
+  aggregateEntries(part->entry.data() + (size_t) p * GROUPBY_CHUNK, part->fill[p]);
+  part->fill[p] = 0;
+}
+
+void
+GroupByCPU::combine() {
+
+  if (mode == GroupByLocal) {
+    vector<int*> tables;
+    for (auto it = local_res->begin(); it != local_res->end(); it++)
+      tables.push_back(reinterpret_cast<int*>(it->data()));
+
+    parallel_for(blocked_range<size_t>(0, total_val), [&](auto range) {
+      for (int hash = range.begin(); hash < range.end(); hash++) {
+        int* out = res + hash * 6;
+        long long sum = 0;
+        for (int t = 0; t < tables.size(); t++) {
+          int* in = tables[t] + hash * 6;
+          if (in[0] != 0 && out[0] != in[0]) out[0] = in[0];
+          if (in[1] != 0 && out[1] != in[1]) out[1] = in[1];
+          if (in[2] != 0 && out[2] != in[2]) out[2] = in[2];
+          if (in[3] != 0 && out[3] != in[3]) out[3] = in[3];
+          sum += reinterpret_cast<long long*>(in)[2];
+        }
+        //other segment groups may be merging into the same res concurrently
+        if (sum != 0) __atomic_fetch_add(reinterpret_cast<unsigned long long*>(&out[4]), (long long)(sum), __ATOMIC_RELAXED);
+      }
+    });
+
+  } else if (mode == GroupByPartitioned) {
+    vector<groupbyBufferCPU*> buffers;
+    for (auto it = local_part->begin(); it != local_part->end(); it++)
+      buffers.push_back(&(*it));
+
+    //the workers are done, every partition drains the chunks left behind and is folded into res by one task
+    parallel_for(blocked_range<size_t>(0, num_part), [&](auto range) {
+      for (int p = range.begin(); p < range.end(); p++) {
+        for (int t = 0; t < buffers.size(); t++) {
+          aggregateEntries(buffers[t]->entry.data() + (size_t) p * GROUPBY_CHUNK, buffers[t]->fill[p]);
+          buffers[t]->fill[p] = 0;
+        }
+        int end = min(total_val, (p + 1) << part_bits);
+        for (int hash = p << part_bits; hash < end; hash++) {
+          if (part_sum[hash] != 0) __atomic_fetch_add(reinterpret_cast<unsigned long long*>(&res[hash * 6 + 4]), (long long)(part_sum[hash]), __ATOMIC_RELAXED);
+        }
+      }
+    }, simple_partitioner());
+  }
+
+}
+
+bool morsel_driven_cpu = true;
+
+bool shared_scan_cpu = false;
+
+sharedScan fact_scan = {{0}, {0}};
+
+MorselScheduler::MorselScheduler(int _num_worker)
+: num_node(numaActive() ? numaNodes() : 1), num_worker(_num_worker), num_tuples(0), scan(NULL) {
+  if (num_worker <= 0) num_worker = sysconf(_SC_NPROCESSORS_ONLN);
+  if (num_worker <= 0) num_worker = NUM_THREADS;
+  queue.resize(num_node);
+  cursor = new std::atomic<int>[num_node];
+  for (int node = 0; node < num_node; node++) cursor[node] = 0;
+}
+
+MorselScheduler::~MorselScheduler() {
+  leaveScan();
+  delete[] cursor;
+}
+
+void
+MorselScheduler::joinScan(sharedScan* _scan) {
+  scan = _scan;
+  int start = (scan->active.fetch_add(1) > 0) ? scan->position.load(std::memory_order_relaxed) : 0;
+  for (int node = 0; node < num_node; node++) {
+    vector<morselCPU>& q = queue[node];
+    stable_sort(q.begin(), q.end(), [](const morselCPU& a, const morselCPU& b) { return a.segment_idx < b.segment_idx; });
+    int first = 0;
+    while (first < q.size() && q[first].segment_idx < start) first++;
+    rotate(q.begin(), q.begin() + first, q.end());
+  }
+}
+
+void
+MorselScheduler::leaveScan() {
+  if (scan != NULL) scan->active.fetch_sub(1);
+  scan = NULL;
+}
+
+void
+MorselScheduler::addSegments(short* segment_group, int count, int total_segment, int LEN) {
+  for (int i = 0; i < count; i++) {
+    int segment_idx = segment_group[i];
+    int len = (segment_idx == total_segment - 1 && LEN % SEGMENT_SIZE != 0) ? (LEN % SEGMENT_SIZE) : SEGMENT_SIZE;
+    for (int start = 0; start < len; start += MORSEL_SIZE) {
+      morselCPU morsel = {segment_idx, start, min(MORSEL_SIZE, len - start)};
+      queue[numaSegmentNode(segment_idx, total_segment) % num_node].push_back(morsel);
+    }
+    num_tuples += len;
+  }
+}
+
+bool
+MorselScheduler::next(int node, morselCPU& morsel) {
+  for (int k = 0; k < num_node; k++) {
+    int q = (node + k) % num_node;
+    if (cursor[q].load(std::memory_order_relaxed) >= (int) queue[q].size()) continue;
+    int idx = cursor[q].fetch_add(1, std::memory_order_relaxed);
+    if (idx < (int) queue[q].size()) {
+      morsel = queue[q][idx];
+      return true;
+    }
+  }
+  return false;
+}
+
+//probe every hash table of pargs for row lo_offset, false as soon as one of them has no match
+static inline bool probeRowCPU(struct probeArgsCPU& pargs, int lo_offset, int* dim_val) {
+  int* key_col[4] = {pargs.key_col1, pargs.key_col2, pargs.key_col3, pargs.key_col4};
+  int* ht[4] = {pargs.ht1, pargs.ht2, pargs.ht3, pargs.ht4};
+  int dim_len[4] = {pargs.dim_len1, pargs.dim_len2, pargs.dim_len3, pargs.dim_len4};
+  int min_key[4] = {pargs.min_key1, pargs.min_key2, pargs.min_key3, pargs.min_key4};
+
+  for (int k = 0; k < 4; k++) {
+    dim_val[k] = 0;
+    if (key_col[k] == NULL || ht[k] == NULL) continue;
+    int hash = HASH(key_col[k][lo_offset], dim_len[k], min_key[k]);
+    long long slot = reinterpret_cast<long long*>(ht[k])[hash];
+    if (slot == 0) return false;
+    dim_val[k] = slot;
+  }
+  return true;
+}
+
+ProbeModeCPU probe_mode_cpu = ProbeDirect;
+
+const char* probe_mode_name_cpu[] = {"direct", "group", "amac"};
+
+ProbeModeCPU
+probeModeCPU(string name) {
+  for (int mode = 0; mode < ProbeModeCount; mode++)
+    if (name.compare(probe_mode_name_cpu[mode]) == 0) return (ProbeModeCPU) mode;
+  return ProbeModeCount;
+}
+
+//move row r of the batch to out if slot s of table k is a match
+static inline int keepProbeCPU(long long s, int k, int r, int out, int* lo_off, int* pos, long long slot[4][BATCH_SIZE]) {
+  if (s == 0) return out;
+  lo_off[out] = lo_off[r];
+  if (pos != NULL) pos[out] = pos[r];
+  for (int j = 0; j < k; j++) slot[j][out] = slot[j][r];
+  slot[k][out] = s;
+  return out + 1;
+}
+
+int probeBatchCPU(ProbeModeCPU mode, struct probeArgsCPU& pargs, int* lo_off, int* pos, int num, long long slot[4][BATCH_SIZE]) {
+  int* key_col[4] = {pargs.key_col1, pargs.key_col2, pargs.key_col3, pargs.key_col4};
+  int* ht[4] = {pargs.ht1, pargs.ht2, pargs.ht3, pargs.ht4};
+  int dim_len[4] = {pargs.dim_len1, pargs.dim_len2, pargs.dim_len3, pargs.dim_len4};
+  int min_key[4] = {pargs.min_key1, pargs.min_key2, pargs.min_key3, pargs.min_key4};
+
+  assert(num <= BATCH_SIZE);
+  int count = num;
+
+  for (int k = 0; k < 4; k++) {
+    if (key_col[k] == NULL || ht[k] == NULL) {
+      for (int i = 0; i < count; i++) slot[k][i] = 1LL << 32;
+      continue;
+    }
+
+    long long* table = reinterpret_cast<long long*>(ht[k]);
+    int out = 0;
+
+    if (mode == ProbeGroupPrefetch) {
+      //the loads of the whole batch are issued before the first one is waited for
+      int hash[BATCH_SIZE];
+      for (int i = 0; i < count; i++) {
+        hash[i] = HASH(key_col[k][lo_off[i]], dim_len[k], min_key[k]);
+        __builtin_prefetch(&table[hash[i]]);
+      }
+      for (int i = 0; i < count; i++)
+        out = keepProbeCPU(table[hash[i]], k, i, out, lo_off, pos, slot);
+
+    } else if (mode == ProbeAMAC) {
+      //a lookup is a single load here (the tables are direct mapped), so every ring entry is done after one step:
+      //row i enters the ring prefetched and leaves PROBE_INFLIGHT rows later. out never passes a row still in the ring
+      int ring[PROBE_INFLIGHT];
+      for (int i = 0; i < count + PROBE_INFLIGHT; i++) {
+        if (i >= PROBE_INFLIGHT) {
+          int r = i - PROBE_INFLIGHT;
+          out = keepProbeCPU(table[ring[r % PROBE_INFLIGHT]], k, r, out, lo_off, pos, slot);
+        }
+        if (i < count) {
+          int hash = HASH(key_col[k][lo_off[i]], dim_len[k], min_key[k]);
+          __builtin_prefetch(&table[hash]);
+          ring[i % PROBE_INFLIGHT] = hash;
+        }
+      }
+
+    } else {
+      for (int i = 0; i < count; i++) {
+        int hash = HASH(key_col[k][lo_off[i]], dim_len[k], min_key[k]);
+        out = keepProbeCPU(table[hash], k, i, out, lo_off, pos, slot);
+      }
+    }
+
+    count = out;
+    if (count == 0) break;
+  }
+
+  return count;
+}
+
+//rows of one morsel or task through the pipeline of the call, the generated one in one go,
+//the template instance BATCH_SIZE rows at a time behind the fact filters
+static inline void pipelineRowsCPU(struct filterArgsCPU& fargs, pipelineCallCPU& call,
+  int col_start, int num, GroupByCPU* gb, int* table, groupbyBufferCPU* part, long long& sum) {
+  if (call.jit != NULL) {
+    jit_pipeline_t run = (gb != NULL && gb->mode == GroupByLocal) ? call.jit->local : call.jit->atomic;
+    sum += run(&call.jargs, col_start, num, table);
+    return;
+  }
+
+  int sel[BATCH_SIZE];
+  for (int batch_start = 0; batch_start < num; batch_start += BATCH_SIZE) {
+    int count = filterDenseCPU(fargs, col_start + batch_start, min(BATCH_SIZE, num - batch_start), sel);
+    if (count > 0) call.batch(call.args, sel, count, gb, table, part, sum);
+  }
+}
+
+void
+pipelineDenseCPU(struct filterArgsCPU& fargs, struct probeArgsCPU& pargs, struct groupbyArgsCPU& gargs,
+  int num_tuples, int* res, int start_offset, short* segment_group) {
+
+  GroupByCPU* gb = (pipelineArgs(pargs, gargs).num_group > 0) ? new GroupByCPU(res, gargs.total_val, num_tuples) : NULL;
+  pipelineCallCPU call = pipelineCall(fargs, pargs, gargs, gb);
+
+  int task_count = (num_tuples + TASK_SIZE - 1)/TASK_SIZE;
+
+  parallel_for(blocked_range<size_t>(0, task_count), [&](auto range) {
+    int* table = (gb != NULL) ? gb->localTable() : NULL;
+    groupbyBufferCPU* part = (gb != NULL) ? gb->localPartition() : NULL;
+    long long local_sum = 0;
+
+    for (int task = range.begin(); task < range.end(); task++) {
+      int start = task * TASK_SIZE;
+      int end = min(start + TASK_SIZE, num_tuples);
+      //a task never crosses a segment, TASK_SIZE is a factor of SEGMENT_SIZE
+      int col_start = (segment_group != NULL) ? (segment_group[start / SEGMENT_SIZE] * SEGMENT_SIZE + start % SEGMENT_SIZE) : (start_offset + start);
+      pipelineRowsCPU(fargs, call, col_start, end - start, gb, table, part, local_sum);
+    }
+
+    if (gb == NULL && local_sum != 0) __atomic_fetch_add(reinterpret_cast<unsigned long long*>(&res[4]), (long long)(local_sum), __ATOMIC_RELAXED);
+
+  }, simple_partitioner());
+
+  if (gb != NULL) {
+    gb->combine();
+    delete gb;
+  }
+
+}
+
+void
+pipelineSerialCPU(struct filterArgsCPU& fargs, struct probeArgsCPU& pargs, struct groupbyArgsCPU& gargs,
+  int num_tuples, int* res, int start_offset) {
+
+  //no tuples for chooseMode: atomic adds into res, other segments may be running into it concurrently
+  GroupByCPU* gb = (pipelineArgs(pargs, gargs).num_group > 0) ? new GroupByCPU(res, gargs.total_val, 0) : NULL;
+  pipelineCallCPU call = pipelineCall(fargs, pargs, gargs, gb);
+  long long sum = 0;
+
+  pipelineRowsCPU(fargs, call, start_offset, num_tuples, gb, (gb != NULL) ? gb->localTable() : NULL, (gb != NULL) ? gb->localPartition() : NULL, sum);
+
+  if (gb != NULL) {
+    gb->combine();
+    delete gb;
+  } else if (sum != 0) {
+    __atomic_fetch_add(reinterpret_cast<unsigned long long*>(&res[4]), (long long)(sum), __ATOMIC_RELAXED);
+  }
+
+}
+
+void filter_probe_group_by_morsel_CPU(
+  struct filterArgsCPU fargs, struct probeArgsCPU* pargs, struct groupbyArgsCPU gargs,
+  MorselScheduler& sched, int* res) {
+
+  GroupByCPU gb(res, gargs.total_val, sched.num_tuples);
+
+  //every node probes its own replicas with the same pipeline
+  vector<pipelineCallCPU> call;
+  for (int node = 0; node < sched.num_node; node++) call.push_back(pipelineCall(fargs, pargs[node], gargs, &gb));
+
+  sched.run([&](int worker, int node, morselCPU& morsel) {
+    long long sum = 0;
+    int base = morsel.segment_idx * SEGMENT_SIZE + morsel.start;
+    pipelineRowsCPU(fargs, call[node], base, morsel.num, &gb, gb.localTable(), gb.localPartition(), sum);
+  });
+
+  gb.combine();
+
+}
+
+void filter_probe_aggr_morsel_CPU(
+  struct filterArgsCPU fargs, struct probeArgsCPU* pargs, struct groupbyArgsCPU gargs,
+  MorselScheduler& sched, int* res) {
+
+  //one partial sum per worker, padded to a cache line
+  vector<long long> worker_sum(sched.num_worker * 8, 0);
+
+  vector<pipelineCallCPU> call;
+  for (int node = 0; node < sched.num_node; node++) call.push_back(pipelineCall(fargs, pargs[node], gargs, NULL));
+
+  sched.run([&](int worker, int node, morselCPU& morsel) {
+    long long local_sum = 0;
+    int base = morsel.segment_idx * SEGMENT_SIZE + morsel.start;
+    pipelineRowsCPU(fargs, call[node], base, morsel.num, NULL, NULL, NULL, local_sum);
+    worker_sum[worker * 8] += local_sum;
+  });
+
+  long long sum = 0;
+  for (int worker = 0; worker < sched.num_worker; worker++) sum += worker_sum[worker * 8];
+  __atomic_fetch_add(reinterpret_cast<unsigned long long*>(&res[4]), (long long)(sum), __ATOMIC_RELAXED);
+
+}
 
 void filter_probe_CPU(
   struct filterArgsCPU fargs, struct probeArgsCPU pargs, struct offsetCPU out_off, int num_tuples,
@@ -17,61 +534,28 @@ void filter_probe_CPU(
     for (int task = start_task; task < end_task; task++) {
           unsigned int start = task * TASK_SIZE;
           unsigned int end = (task == task_count - 1) ? (task * TASK_SIZE + rem_task):(task * TASK_SIZE + TASK_SIZE);
-          unsigned int end_batch = start + ((end - start)/BATCH_SIZE) * BATCH_SIZE;
 
           int segment_idx = segment_group[start / SEGMENT_SIZE];
           unsigned int count = 0;
           unsigned int temp[5][end-start];
+          int sel[BATCH_SIZE];
 
-          for (int batch_start = start; batch_start < end_batch; batch_start += BATCH_SIZE) {
-            #pragma simd
-            for (int i = batch_start; i < batch_start + BATCH_SIZE; i++) {
-              int hash;
-              long long slot;
-              int slot4 = 1;
-              int lo_offset;
-
-              lo_offset = segment_idx * SEGMENT_SIZE + (i % SEGMENT_SIZE);
-
-                if (!(fargs.filter_col1[lo_offset] >= fargs.compare1 && fargs.filter_col1[lo_offset] <= fargs.compare2)) continue; //only for Q1.x
-
-                if (!(fargs.filter_col2[lo_offset] >= fargs.compare3 && fargs.filter_col2[lo_offset] <= fargs.compare4)) continue; //only for Q1.x
-
-                hash = HASH(pargs.key_col4[lo_offset], pargs.dim_len4, pargs.min_key4);
-                slot = reinterpret_cast<long long*>(pargs.ht4)[hash];
-                if (slot == 0) continue;
-                slot4 = slot >> 32;
+          for (int batch_start = start; batch_start < end; batch_start += BATCH_SIZE) {
+            //the lineorder filters of Q1.x through filterDenseCPU, so they read the packed or sliced copies too
+            int batch_count = filterDenseCPU(fargs, segment_idx * SEGMENT_SIZE + (batch_start % SEGMENT_SIZE), min(BATCH_SIZE, (int) (end - batch_start)), sel);
 
+            for (int i = 0; i < batch_count; i++) {
+              int lo_offset = sel[i];
+              int hash = HASH(pargs.key_col4[lo_offset], pargs.dim_len4, pargs.min_key4);
+              long long slot = reinterpret_cast<long long*>(pargs.ht4)[hash];
+              if (slot == 0) continue;
 
               temp[0][count] = lo_offset;
-              temp[4][count] = slot4-1;
+              temp[4][count] = (slot >> 32) - 1;
               count++;
-
             }
           }
 
-          for (int i = end_batch ; i < end; i++) {
-              int hash;
-              long long slot;
-              int slot4 = 1;
-              int lo_offset;
-
-              lo_offset = segment_idx * SEGMENT_SIZE + (i % SEGMENT_SIZE);
-
-                if (!(fargs.filter_col1[lo_offset] >= fargs.compare1 && fargs.filter_col1[lo_offset] <= fargs.compare2)) continue; //only for Q1.x
-
-                if (!(fargs.filter_col2[lo_offset] >= fargs.compare3 && fargs.filter_col2[lo_offset] <= fargs.compare4)) continue; //only for Q1.x
-
-                hash = HASH(pargs.key_col4[lo_offset], pargs.dim_len4, pargs.min_key4);
-                slot = reinterpret_cast<long long*>(pargs.ht4)[hash];
-                if (slot == 0) continue;
-                slot4 = slot >> 32;
-
-              temp[0][count] = lo_offset;
-              temp[4][count] = slot4-1;
-              count++;
-          }
-
           int thread_off = __atomic_fetch_add(total, count, __ATOMIC_RELAXED);
 
           for (int i = 0; i < count; i++) {
@@ -190,7 +674,19 @@ void probe_CPU(
           unsigned int count = 0;
           unsigned int temp[5][end-start];
     
-          for (int batch_start = start; batch_start < end_batch; batch_start += BATCH_SIZE) {
+          if (probe_mode_cpu != ProbeDirect) {
+            int sel[BATCH_SIZE];
+            long long slot[4][BATCH_SIZE];
+            for (int batch_start = start; batch_start < end_batch; batch_start += BATCH_SIZE) {
+              for (int i = 0; i < BATCH_SIZE; i++) sel[i] = segment_idx * SEGMENT_SIZE + ((batch_start + i) % SEGMENT_SIZE);
+              int matched = probeBatchCPU(probe_mode_cpu, pargs, sel, NULL, BATCH_SIZE, slot);
+              for (int i = 0; i < matched; i++) {
+                temp[0][count] = sel[i];
+                for (int k = 0; k < 4; k++) temp[k + 1][count] = (slot[k][i] >> 32) - 1;
+                count++;
+              }
+            }
+          } else for (int batch_start = start; batch_start < end_batch; batch_start += BATCH_SIZE) {
             #pragma simd
             for (int i = batch_start; i < batch_start + BATCH_SIZE; i++) {
             int hash;
@@ -319,7 +815,29 @@ void probe_CPU2(struct offsetCPU in_off, struct probeArgsCPU pargs, struct offse
           unsigned int count = 0;
           unsigned int temp[5][end-start];
     
-          for (int batch_start = start; batch_start < end_batch; batch_start += BATCH_SIZE) {
+          if (probe_mode_cpu != ProbeDirect) {
+            int sel[BATCH_SIZE], pos[BATCH_SIZE];
+            long long slot[4][BATCH_SIZE];
+            int* in_dim_off[4] = {in_off.h_dim_off1, in_off.h_dim_off2, in_off.h_dim_off3, in_off.h_dim_off4};
+            int* ht[4] = {pargs.ht1, pargs.ht2, pargs.ht3, pargs.ht4};
+            int* key_col[4] = {pargs.key_col1, pargs.key_col2, pargs.key_col3, pargs.key_col4};
+            for (int batch_start = start; batch_start < end_batch; batch_start += BATCH_SIZE) {
+              for (int i = 0; i < BATCH_SIZE; i++) {
+                sel[i] = in_off.h_lo_off[start_offset + batch_start + i];
+                pos[i] = start_offset + batch_start + i;
+              }
+              int matched = probeBatchCPU(probe_mode_cpu, pargs, sel, pos, BATCH_SIZE, slot);
+              for (int i = 0; i < matched; i++) {
+                temp[0][count] = sel[i];
+                for (int k = 0; k < 4; k++) {
+                  //tables probed by an earlier operator pass their offset through
+                  if ((ht[k] == NULL || key_col[k] == NULL) && in_dim_off[k] != NULL) temp[k + 1][count] = in_dim_off[k][pos[i]];
+                  else temp[k + 1][count] = (slot[k][i] >> 32) - 1;
+                }
+                count++;
+              }
+            }
+          } else for (int batch_start = start; batch_start < end_batch; batch_start += BATCH_SIZE) {
             #pragma simd
             for (int i = batch_start; i < batch_start + BATCH_SIZE; i++) {
               int hash;
@@ -442,128 +960,8 @@ void probe_group_by_CPU(
 
   assert(segment_group != NULL);
 
-  int task_count = (num_tuples + TASK_SIZE - 1)/TASK_SIZE;
-  int rem_task = (num_tuples % TASK_SIZE == 0) ? (TASK_SIZE):(num_tuples % TASK_SIZE);
-
-  parallel_for(blocked_range<size_t>(0, task_count), [&](auto range) {
-    unsigned int start_task = range.begin();
-    unsigned int end_task = range.end();
-
-    for (int task = start_task; task < end_task; task++) {
-          unsigned int start = task * TASK_SIZE;
-          unsigned int end = (task == task_count - 1) ? (task * TASK_SIZE + rem_task):(task * TASK_SIZE + TASK_SIZE);
-          unsigned int end_batch = start + ((end - start)/BATCH_SIZE) * BATCH_SIZE;
-
-          int segment_idx = segment_group[start / SEGMENT_SIZE];
-
-          for (int batch_start = start; batch_start < end_batch; batch_start += BATCH_SIZE) {
-            #pragma simd
-            for (int i = batch_start; i < batch_start + BATCH_SIZE; i++) {
-              int hash;
-              long long slot;
-              int dim_val1 = 0, dim_val2 = 0, dim_val3 = 0, dim_val4 = 0;
-              int lo_offset;
-
-              lo_offset = segment_idx * SEGMENT_SIZE + (i % SEGMENT_SIZE);
-
-              if (pargs.key_col1 != NULL && pargs.ht1 != NULL) {
-                hash = HASH(pargs.key_col1[lo_offset], pargs.dim_len1, pargs.min_key1);
-                slot = reinterpret_cast<long long*>(pargs.ht1)[hash];
-                if (slot == 0) continue;
-                dim_val1 = slot;
-              }
-
-              if (pargs.key_col2 != NULL && pargs.ht2 != NULL) {
-                hash = HASH(pargs.key_col2[lo_offset], pargs.dim_len2, pargs.min_key2);
-                slot = reinterpret_cast<long long*>(pargs.ht2)[hash];
-                if (slot == 0) continue;
-                dim_val2 = slot;
-              }
-
-              if (pargs.key_col3 != NULL && pargs.ht3 != NULL) {
-                hash = HASH(pargs.key_col3[lo_offset], pargs.dim_len3, pargs.min_key3);
-                slot = reinterpret_cast<long long*>(pargs.ht3)[hash];
-                if (slot == 0) continue;
-                dim_val3 = slot;
-              }
-
-              if (pargs.key_col4 != NULL && pargs.ht4 != NULL) {
-                hash = HASH(pargs.key_col4[lo_offset], pargs.dim_len4, pargs.min_key4);
-                slot = reinterpret_cast<long long*>(pargs.ht4)[hash];
-                if (slot == 0) continue;
-                dim_val4 = slot;
-              }
-
-              hash = ((dim_val1 - gargs.min_val1) * gargs.unique_val1 + (dim_val2 - gargs.min_val2) * gargs.unique_val2 +  (dim_val3 - gargs.min_val3) * gargs.unique_val3 + (dim_val4 - gargs.min_val4) * gargs.unique_val4) % gargs.total_val;
-              if (dim_val1 != 0) res[hash * 6] = dim_val1;
-              if (dim_val2 != 0) res[hash * 6 + 1] = dim_val2;
-              if (dim_val3 != 0) res[hash * 6 + 2] = dim_val3;
-              if (dim_val4 != 0) res[hash * 6 + 3] = dim_val4;
-
-              int aggr1 = 0; int aggr2 = 0;
-              if (gargs.aggr_col1 != NULL) aggr1 = gargs.aggr_col1[lo_offset];
-              if (gargs.aggr_col2 != NULL) aggr2 = gargs.aggr_col2[lo_offset];
-              // int temp = (*(gargs.h_group_func))(aggr1, aggr2);
-              int temp = aggr1 - aggr2;
-
-              __atomic_fetch_add(reinterpret_cast<unsigned long long*>(&res[hash * 6 + 4]), (long long)(temp), __ATOMIC_RELAXED);
-            }
-          }
-
-          for (int i = end_batch ; i < end; i++) {
-
-            int hash;
-            long long slot;
-            int dim_val1 = 0, dim_val2 = 0, dim_val3 = 0, dim_val4 = 0;
-            int lo_offset;
-
-            lo_offset = segment_idx * SEGMENT_SIZE + (i % SEGMENT_SIZE);
-
-            if (pargs.key_col1 != NULL && pargs.ht1 != NULL) {
-              hash = HASH(pargs.key_col1[lo_offset], pargs.dim_len1, pargs.min_key1);
-              slot = reinterpret_cast<long long*>(pargs.ht1)[hash];
-              if (slot == 0) continue;
-              dim_val1 = slot;
-            }
-
-            if (pargs.key_col2 != NULL && pargs.ht2 != NULL) {
-              hash = HASH(pargs.key_col2[lo_offset], pargs.dim_len2, pargs.min_key2);
-              slot = reinterpret_cast<long long*>(pargs.ht2)[hash];
-              if (slot == 0) continue;
-              dim_val2 = slot;
-            }
-
-            if (pargs.key_col3 != NULL && pargs.ht3 != NULL) {
-              hash = HASH(pargs.key_col3[lo_offset], pargs.dim_len3, pargs.min_key3);
-              slot = reinterpret_cast<long long*>(pargs.ht3)[hash];
-              if (slot == 0) continue;
-              dim_val3 = slot;
-            }
-
-            if (pargs.key_col4 != NULL && pargs.ht4 != NULL) {
-              hash = HASH(pargs.key_col4[lo_offset], pargs.dim_len4, pargs.min_key4);
-              slot = reinterpret_cast<long long*>(pargs.ht4)[hash];
-              if (slot == 0) continue;
-              dim_val4 = slot;
-            }
-
-            hash = ((dim_val1 - gargs.min_val1) * gargs.unique_val1 + (dim_val2 - gargs.min_val2) * gargs.unique_val2 +  (dim_val3 - gargs.min_val3) * gargs.unique_val3 + (dim_val4 - gargs.min_val4) * gargs.unique_val4) % gargs.total_val;
-            if (dim_val1 != 0) res[hash * 6] = dim_val1;
-            if (dim_val2 != 0) res[hash * 6 + 1] = dim_val2;
-            if (dim_val3 != 0) res[hash * 6 + 2] = dim_val3;
-            if (dim_val4 != 0) res[hash * 6 + 3] = dim_val4;
-
-            int aggr1 = 0; int aggr2 = 0;
-            if (gargs.aggr_col1 != NULL) aggr1 = gargs.aggr_col1[lo_offset];
-            if (gargs.aggr_col2 != NULL) aggr2 = gargs.aggr_col2[lo_offset];
-            // int temp = (*(gargs.h_group_func))(aggr1, aggr2);
-            int temp = aggr1 - aggr2;
-
-            __atomic_fetch_add(reinterpret_cast<unsigned long long*>(&res[hash * 6 + 4]), (long long)(temp), __ATOMIC_RELAXED);
-          }
-
-    }
-  }, simple_partitioner());
+  struct filterArgsCPU fargs = {};
+  pipelineDenseCPU(fargs, pargs, gargs, num_tuples, res, start_offset, segment_group);
 
 }
 
@@ -576,9 +974,13 @@ void probe_group_by_CPU2(struct offsetCPU offset,
   int task_count = (num_tuples + TASK_SIZE - 1)/TASK_SIZE;
   int rem_task = (num_tuples % TASK_SIZE == 0) ? (TASK_SIZE):(num_tuples % TASK_SIZE);
 
+  GroupByCPU gb(res, gargs.total_val, num_tuples);
+
   parallel_for(blocked_range<size_t>(0, task_count), [&](auto range) {
     unsigned int start_task = range.begin();
     unsigned int end_task = range.end();
+    int* table = gb.localTable();
+    groupbyBufferCPU* part = gb.localPartition();
 
     for (int task = start_task; task < end_task; task++) {
           unsigned int start = task * TASK_SIZE;
@@ -636,10 +1038,6 @@ void probe_group_by_CPU2(struct offsetCPU offset,
               }
 
               hash = ((dim_val1 - gargs.min_val1) * gargs.unique_val1 + (dim_val2 - gargs.min_val2) * gargs.unique_val2 +  (dim_val3 - gargs.min_val3) * gargs.unique_val3 + (dim_val4 - gargs.min_val4) * gargs.unique_val4) % gargs.total_val;
-              if (dim_val1 != 0) res[hash * 6] = dim_val1;
-              if (dim_val2 != 0) res[hash * 6 + 1] = dim_val2;
-              if (dim_val3 != 0) res[hash * 6 + 2] = dim_val3;
-              if (dim_val4 != 0) res[hash * 6 + 3] = dim_val4;
 
               int aggr1 = 0; int aggr2 = 0;
               if (gargs.aggr_col1 != NULL) aggr1 = gargs.aggr_col1[lo_offset];
@@ -647,7 +1045,7 @@ void probe_group_by_CPU2(struct offsetCPU offset,
               // int temp = (*(gargs.h_group_func))(aggr1, aggr2);
               int temp = aggr1 - aggr2;
 
-              __atomic_fetch_add(reinterpret_cast<unsigned long long*>(&res[hash * 6 + 4]), (long long)(temp), __ATOMIC_RELAXED);
+              gb.aggregate(table, part, hash, dim_val1, dim_val2, dim_val3, dim_val4, temp);
             }
           }
 
@@ -701,10 +1099,6 @@ void probe_group_by_CPU2(struct offsetCPU offset,
               }
 
               hash = ((dim_val1 - gargs.min_val1) * gargs.unique_val1 + (dim_val2 - gargs.min_val2) * gargs.unique_val2 +  (dim_val3 - gargs.min_val3) * gargs.unique_val3 + (dim_val4 - gargs.min_val4) * gargs.unique_val4) % gargs.total_val;
-              if (dim_val1 != 0) res[hash * 6] = dim_val1;
-              if (dim_val2 != 0) res[hash * 6 + 1] = dim_val2;
-              if (dim_val3 != 0) res[hash * 6 + 2] = dim_val3;
-              if (dim_val4 != 0) res[hash * 6 + 3] = dim_val4;
 
               int aggr1 = 0; int aggr2 = 0;
               if (gargs.aggr_col1 != NULL) aggr1 = gargs.aggr_col1[lo_offset];
@@ -712,12 +1106,14 @@ void probe_group_by_CPU2(struct offsetCPU offset,
               // int temp = (*(gargs.h_group_func))(aggr1, aggr2);
               int temp = aggr1 - aggr2;
 
-              __atomic_fetch_add(reinterpret_cast<unsigned long long*>(&res[hash * 6 + 4]), (long long)(temp), __ATOMIC_RELAXED);
+              gb.aggregate(table, part, hash, dim_val1, dim_val2, dim_val3, dim_val4, temp);
           }
 
     }
   }, simple_partitioner());
 
+  gb.combine();
+
 }
 
 void filter_probe_group_by_CPU(
@@ -726,142 +1122,7 @@ void filter_probe_group_by_CPU(
 
   assert(segment_group != NULL);
 
-  int task_count = (num_tuples + TASK_SIZE - 1)/TASK_SIZE;
-  int rem_task = (num_tuples % TASK_SIZE == 0) ? (TASK_SIZE):(num_tuples % TASK_SIZE);
-
-  parallel_for(blocked_range<size_t>(0, task_count), [&](auto range) {
-    unsigned int start_task = range.begin();
-    unsigned int end_task = range.end();
-
-    for (int task = start_task; task < end_task; task++) {
-          unsigned int start = task * TASK_SIZE;
-          unsigned int end = (task == task_count - 1) ? (task * TASK_SIZE + rem_task):(task * TASK_SIZE + TASK_SIZE);
-          unsigned int end_batch = start + ((end - start)/BATCH_SIZE) * BATCH_SIZE;
-
-          int segment_idx = segment_group[start / SEGMENT_SIZE];
-
-          for (int batch_start = start; batch_start < end_batch; batch_start += BATCH_SIZE) {
-            #pragma simd
-            for (int i = batch_start; i < batch_start + BATCH_SIZE; i++) {
-              int hash;
-              long long slot;
-              int dim_val1 = 0, dim_val2 = 0, dim_val3 = 0, dim_val4 = 0;
-              int lo_offset;
-
-              lo_offset = segment_idx * SEGMENT_SIZE + (i % SEGMENT_SIZE);
-
-              if (fargs.filter_col1 != NULL) {
-                if (!(fargs.filter_col1[lo_offset] >= fargs.compare1 && fargs.filter_col1[lo_offset] <= fargs.compare2)) continue; //only for Q1.x
-              }
-
-              if (fargs.filter_col2 != NULL) {
-                if (!(fargs.filter_col2[lo_offset] >= fargs.compare3 && fargs.filter_col2[lo_offset] <= fargs.compare4)) continue; //only for Q1.x
-              }
-
-              if (pargs.key_col1 != NULL && pargs.ht1 != NULL) {
-                hash = HASH(pargs.key_col1[lo_offset], pargs.dim_len1, pargs.min_key1);
-                slot = reinterpret_cast<long long*>(pargs.ht1)[hash];
-                if (slot == 0) continue;
-                dim_val1 = slot;
-              }
-
-              if (pargs.key_col2 != NULL && pargs.ht2 != NULL) {
-                hash = HASH(pargs.key_col2[lo_offset], pargs.dim_len2, pargs.min_key2);
-                slot = reinterpret_cast<long long*>(pargs.ht2)[hash];
-                if (slot == 0) continue;
-                dim_val2 = slot;
-              }
-
-              if (pargs.key_col3 != NULL && pargs.ht3 != NULL) {
-                hash = HASH(pargs.key_col3[lo_offset], pargs.dim_len3, pargs.min_key3);
-                slot = reinterpret_cast<long long*>(pargs.ht3)[hash];
-                if (slot == 0) continue;
-                dim_val3 = slot;
-              }
-
-              if (pargs.key_col4 != NULL && pargs.ht4 != NULL) {
-                hash = HASH(pargs.key_col4[lo_offset], pargs.dim_len4, pargs.min_key4);
-                slot = reinterpret_cast<long long*>(pargs.ht4)[hash];
-                if (slot == 0) continue;
-                dim_val4 = slot;
-              }
-
-              hash = ((dim_val1 - gargs.min_val1) * gargs.unique_val1 + (dim_val2 - gargs.min_val2) * gargs.unique_val2 +  (dim_val3 - gargs.min_val3) * gargs.unique_val3 + (dim_val4 - gargs.min_val4) * gargs.unique_val4) % gargs.total_val;
-              if (dim_val1 != 0) res[hash * 6] = dim_val1;
-              if (dim_val2 != 0) res[hash * 6 + 1] = dim_val2;
-              if (dim_val3 != 0) res[hash * 6 + 2] = dim_val3;
-              if (dim_val4 != 0) res[hash * 6 + 3] = dim_val4;
-
-              int aggr1 = 0; int aggr2 = 0;
-              if (gargs.aggr_col1 != NULL) aggr1 = gargs.aggr_col1[lo_offset];
-              if (gargs.aggr_col2 != NULL) aggr2 = gargs.aggr_col2[lo_offset];
-              int temp = (aggr1 - aggr2);
-
-              __atomic_fetch_add(reinterpret_cast<unsigned long long*>(&res[hash * 6 + 4]), (long long)(temp), __ATOMIC_RELAXED);
-            }
-          }
-
-          for (int i = end_batch ; i < end; i++) {
-
-            int hash;
-            long long slot;
-            int dim_val1 = 0, dim_val2 = 0, dim_val3 = 0, dim_val4 = 0;
-            int lo_offset;
-
-            lo_offset = segment_idx * SEGMENT_SIZE + (i % SEGMENT_SIZE);
-
-            if (fargs.filter_col1 != NULL) {
-              if (!(fargs.filter_col1[lo_offset] >= fargs.compare1 && fargs.filter_col1[lo_offset] <= fargs.compare2)) continue; //only for Q1.x
-            }
-
-            if (fargs.filter_col2 != NULL) {
-              if (!(fargs.filter_col2[lo_offset] >= fargs.compare3 && fargs.filter_col2[lo_offset] <= fargs.compare4)) continue; //only for Q1.x
-            }
-
-            if (pargs.key_col1 != NULL && pargs.ht1 != NULL) {
-              hash = HASH(pargs.key_col1[lo_offset], pargs.dim_len1, pargs.min_key1);
-              slot = reinterpret_cast<long long*>(pargs.ht1)[hash];
-              if (slot == 0) continue;
-              dim_val1 = slot;
-            }
-
-            if (pargs.key_col2 != NULL && pargs.ht2 != NULL) {
-              hash = HASH(pargs.key_col2[lo_offset], pargs.dim_len2, pargs.min_key2);
-              slot = reinterpret_cast<long long*>(pargs.ht2)[hash];
-              if (slot == 0) continue;
-              dim_val2 = slot;
-            }
-
-            if (pargs.key_col3 != NULL && pargs.ht3 != NULL) {
-              hash = HASH(pargs.key_col3[lo_offset], pargs.dim_len3, pargs.min_key3);
-              slot = reinterpret_cast<long long*>(pargs.ht3)[hash];
-              if (slot == 0) continue;
-              dim_val3 = slot;
-            }
-
-            if (pargs.key_col4 != NULL && pargs.ht4 != NULL) {
-              hash = HASH(pargs.key_col4[lo_offset], pargs.dim_len4, pargs.min_key4);
-              slot = reinterpret_cast<long long*>(pargs.ht4)[hash];
-              if (slot == 0) continue;
-              dim_val4 = slot;
-            }
-
-            hash = ((dim_val1 - gargs.min_val1) * gargs.unique_val1 + (dim_val2 - gargs.min_val2) * gargs.unique_val2 +  (dim_val3 - gargs.min_val3) * gargs.unique_val3 + (dim_val4 - gargs.min_val4) * gargs.unique_val4) % gargs.total_val;
-            if (dim_val1 != 0) res[hash * 6] = dim_val1;
-            if (dim_val2 != 0) res[hash * 6 + 1] = dim_val2;
-            if (dim_val3 != 0) res[hash * 6 + 2] = dim_val3;
-            if (dim_val4 != 0) res[hash * 6 + 3] = dim_val4;
-
-            int aggr1 = 0; int aggr2 = 0;
-            if (gargs.aggr_col1 != NULL) aggr1 = gargs.aggr_col1[lo_offset];
-            if (gargs.aggr_col2 != NULL) aggr2 = gargs.aggr_col2[lo_offset];
-            int temp = (aggr1 - aggr2);
-
-            __atomic_fetch_add(reinterpret_cast<unsigned long long*>(&res[hash * 6 + 4]), (long long)(temp), __ATOMIC_RELAXED);
-
-          }
-    }
-  }, simple_partitioner());
+  pipelineDenseCPU(fargs, pargs, gargs, num_tuples, res, start_offset, segment_group);
 
 }
 
@@ -874,9 +1135,13 @@ void filter_probe_group_by_CPU2(struct offsetCPU offset,
   int task_count = (num_tuples + TASK_SIZE - 1)/TASK_SIZE;
   int rem_task = (num_tuples % TASK_SIZE == 0) ? (TASK_SIZE):(num_tuples % TASK_SIZE);
 
+  GroupByCPU gb(res, gargs.total_val, num_tuples);
+
   parallel_for(blocked_range<size_t>(0, task_count), [&](auto range) {
     unsigned int start_task = range.begin();
     unsigned int end_task = range.end();
+    int* table = gb.localTable();
+    groupbyBufferCPU* part = gb.localPartition();
 
     for (int task = start_task; task < end_task; task++) {
           unsigned int start = task * TASK_SIZE;
@@ -942,17 +1207,13 @@ void filter_probe_group_by_CPU2(struct offsetCPU offset,
               }
 
               hash = ((dim_val1 - gargs.min_val1) * gargs.unique_val1 + (dim_val2 - gargs.min_val2) * gargs.unique_val2 +  (dim_val3 - gargs.min_val3) * gargs.unique_val3 + (dim_val4 - gargs.min_val4) * gargs.unique_val4) % gargs.total_val;
-              if (dim_val1 != 0) res[hash * 6] = dim_val1;
-              if (dim_val2 != 0) res[hash * 6 + 1] = dim_val2;
-              if (dim_val3 != 0) res[hash * 6 + 2] = dim_val3;
-              if (dim_val4 != 0) res[hash * 6 + 3] = dim_val4;
 
               int aggr1 = 0; int aggr2 = 0;
               if (gargs.aggr_col1 != NULL) aggr1 = gargs.aggr_col1[lo_offset];
               if (gargs.aggr_col2 != NULL) aggr2 = gargs.aggr_col2[lo_offset];
               int temp = aggr1 - aggr2;
 
-              __atomic_fetch_add(reinterpret_cast<unsigned long long*>(&res[hash * 6 + 4]), (long long)(temp), __ATOMIC_RELAXED);
+              gb.aggregate(table, part, hash, dim_val1, dim_val2, dim_val3, dim_val4, temp);
             }
           }
 
@@ -1014,21 +1275,19 @@ void filter_probe_group_by_CPU2(struct offsetCPU offset,
               }
 
               hash = ((dim_val1 - gargs.min_val1) * gargs.unique_val1 + (dim_val2 - gargs.min_val2) * gargs.unique_val2 +  (dim_val3 - gargs.min_val3) * gargs.unique_val3 + (dim_val4 - gargs.min_val4) * gargs.unique_val4) % gargs.total_val;
-              if (dim_val1 != 0) res[hash * 6] = dim_val1;
-              if (dim_val2 != 0) res[hash * 6 + 1] = dim_val2;
-              if (dim_val3 != 0) res[hash * 6 + 2] = dim_val3;
-              if (dim_val4 != 0) res[hash * 6 + 3] = dim_val4;
 
               int aggr1 = 0; int aggr2 = 0;
               if (gargs.aggr_col1 != NULL) aggr1 = gargs.aggr_col1[lo_offset];
               if (gargs.aggr_col2 != NULL) aggr2 = gargs.aggr_col2[lo_offset];
               int temp = aggr1 - aggr2;
 
-              __atomic_fetch_add(reinterpret_cast<unsigned long long*>(&res[hash * 6 + 4]), (long long)(temp), __ATOMIC_RELAXED);
+              gb.aggregate(table, part, hash, dim_val1, dim_val2, dim_val3, dim_val4, temp);
           }
     }
   }, simple_partitioner());
 
+  gb.combine();
+
 }
 
 void build_CPU(struct filterArgsCPU fargs,
@@ -1049,54 +1308,25 @@ void build_CPU(struct filterArgsCPU fargs,
     for (int task = start_task; task < end_task; task++) {
           unsigned int start = task * TASK_SIZE;
           unsigned int end = (task == task_count - 1) ? (task * TASK_SIZE + rem_task):(task * TASK_SIZE + TASK_SIZE);
-          unsigned int end_batch = start + ((end - start)/BATCH_SIZE) * BATCH_SIZE;
 
           int segment_idx = segment_group[start / SEGMENT_SIZE];
 
-          for (int batch_start = start; batch_start < end_batch; batch_start += BATCH_SIZE) {
-            #pragma simd
-            for (int i = batch_start; i < batch_start + BATCH_SIZE; i++) {
-              int table_offset;
-              int flag = 1;
-
-              table_offset = segment_idx * SEGMENT_SIZE + (i % SEGMENT_SIZE);
-
-              if (fargs.filter_col1 != NULL) {
-                if (fargs.mode1 == 1)
-                  flag = (fargs.filter_col1[table_offset] >= fargs.compare1 && fargs.filter_col1[table_offset] <= fargs.compare2);
-                else if (fargs.mode1 == 2)
-                  flag = (fargs.filter_col1[table_offset] == fargs.compare1 || fargs.filter_col1[table_offset] == fargs.compare2);
-              }
-
-              if (flag) {
-                int key = bargs.key_col[table_offset];
-                int hash = HASH(key, bargs.num_slots, bargs.val_min);
-                hash_table[(hash << 1) + 1] = table_offset + 1;
-                if (bargs.val_col != NULL) hash_table[hash << 1] = bargs.val_col[table_offset];
-              }
-
-            }
-          }
-
-          for (int i = end_batch ; i < end; i++) {
-            int table_offset;
-            int flag = 1;
-
-            table_offset = segment_idx * SEGMENT_SIZE + (i % SEGMENT_SIZE);
+          int col_start = segment_idx * SEGMENT_SIZE + (start % SEGMENT_SIZE);
+          int count = end - start;
+          int temp[end-start];
 
-            if (fargs.filter_col1 != NULL) {
-              if (fargs.mode1 == 1)
-                flag = (fargs.filter_col1[table_offset] >= fargs.compare1 && fargs.filter_col1[table_offset] <= fargs.compare2);
-              else if (fargs.mode1 == 2)
-                flag = (fargs.filter_col1[table_offset] == fargs.compare1 || fargs.filter_col1[table_offset] == fargs.compare2);
-            }
+          if (fargs.filter_col1 != NULL && (fargs.mode1 == 1 || fargs.mode1 == 2))
+            count = selectDense(selectOp(fargs.mode1, fargs.compare1, fargs.compare2), fargs.filter_col1, col_start, end - start, fargs.compare1, fargs.compare2, temp);
+          else
+            for (int i = 0; i < count; i++) temp[i] = col_start + i;
 
-            if (flag) {
-              int key = bargs.key_col[table_offset];
-              int hash = HASH(key, bargs.num_slots, bargs.val_min);
-              hash_table[(hash << 1) + 1] = table_offset + 1;
-              if (bargs.val_col != NULL) hash_table[hash << 1] = bargs.val_col[table_offset];
-            }
+          #pragma simd
+          for (int i = 0; i < count; i++) {
+            int table_offset = temp[i];
+            int key = bargs.key_col[table_offset];
+            int hash = HASH(key, bargs.num_slots, bargs.val_min);
+            hash_table[(hash << 1) + 1] = table_offset + 1;
+            if (bargs.val_col != NULL) hash_table[hash << 1] = bargs.val_col[table_offset];
           }
     }
 
@@ -1171,67 +1401,11 @@ void filter_CPU(struct filterArgsCPU fargs,
     for (int task = start_task; task < end_task; task++) {
           unsigned int start = task * TASK_SIZE;
           unsigned int end = (task == task_count - 1) ? (task * TASK_SIZE + rem_task):(task * TASK_SIZE + TASK_SIZE);
-          unsigned int end_batch = start + ((end - start)/BATCH_SIZE) * BATCH_SIZE;
 
           int segment_idx = segment_group[start / SEGMENT_SIZE];
 
-          int count = 0;
           int temp[end-start];
-
-          for (int batch_start = start; batch_start < end_batch; batch_start += BATCH_SIZE) {
-            #pragma simd
-            for (int i = batch_start; i < batch_start + BATCH_SIZE; i++) {
-              bool selection_flag = 1;
-              int col_offset; 
-
-              col_offset = segment_idx * SEGMENT_SIZE + (i % SEGMENT_SIZE);
-
-              if (fargs.filter_col1 != NULL) {
-                if (fargs.mode1 == 1)
-                  selection_flag = (fargs.filter_col1[col_offset] >= fargs.compare1 && fargs.filter_col1[col_offset] <= fargs.compare2);
-                else if (fargs.mode1 == 2)
-                  selection_flag = (fargs.filter_col1[col_offset] == fargs.compare1 || fargs.filter_col1[col_offset] == fargs.compare2);
-              }
-
-              if (fargs.filter_col2 != NULL) {
-                if (fargs.mode2 == 1)
-                  selection_flag = selection_flag && (fargs.filter_col2[col_offset] >= fargs.compare3 && fargs.filter_col2[col_offset] <= fargs.compare4);
-                else if (fargs.mode2 == 2)
-                  selection_flag = selection_flag && (fargs.filter_col2[col_offset] == fargs.compare3 || fargs.filter_col2[col_offset] == fargs.compare4);
-              }
-
-              if (selection_flag) {
-                temp[count] = col_offset;
-                count++;        
-              }
-            }
-          }
-
-          for (int i = end_batch ; i < end; i++) {
-            bool selection_flag = 1;
-            int col_offset; 
-
-            col_offset = segment_idx * SEGMENT_SIZE + (i % SEGMENT_SIZE);
-
-              if (fargs.filter_col1 != NULL) {
-                if (fargs.mode1 == 1)
-                  selection_flag = (fargs.filter_col1[col_offset] >= fargs.compare1 && fargs.filter_col1[col_offset] <= fargs.compare2);
-                else if (fargs.mode1 == 2)
-                  selection_flag = (fargs.filter_col1[col_offset] == fargs.compare1 || fargs.filter_col1[col_offset] == fargs.compare2);
-              }
-
-              if (fargs.filter_col2 != NULL) {
-                if (fargs.mode2 == 1)
-                  selection_flag = selection_flag && (fargs.filter_col2[col_offset] >= fargs.compare3 && fargs.filter_col2[col_offset] <= fargs.compare4);
-                else if (fargs.mode2 == 2)
-                  selection_flag = selection_flag && (fargs.filter_col2[col_offset] == fargs.compare3 || fargs.filter_col2[col_offset] == fargs.compare4);
-              }
-
-            if (selection_flag) {
-              temp[count] = col_offset;
-              count++;
-            }
-          }
+          int count = filterDenseCPU(fargs, segment_idx * SEGMENT_SIZE + (start % SEGMENT_SIZE), end - start, temp);
 
           int thread_off = __atomic_fetch_add(total, count, __ATOMIC_RELAXED);
 
@@ -1261,65 +1435,9 @@ void filter_CPU2(int* off_col, struct filterArgsCPU fargs,
     for (int task = start_task; task < end_task; task++) {
           unsigned int start = task * TASK_SIZE;
           unsigned int end = (task == task_count - 1) ? (task * TASK_SIZE + rem_task):(task * TASK_SIZE + TASK_SIZE);
-          unsigned int end_batch = start + ((end - start)/BATCH_SIZE) * BATCH_SIZE;
 
-          int count = 0;
           int temp[end-start];
-
-          for (int batch_start = start; batch_start < end_batch; batch_start += BATCH_SIZE) {
-            #pragma simd
-            for (int i = batch_start; i < batch_start + BATCH_SIZE; i++) {
-              bool selection_flag = 1;
-              int col_offset;
-
-              col_offset = off_col[start_offset + i];
-
-              if (fargs.filter_col1 != NULL) {
-                if (fargs.mode1 == 1)
-                  selection_flag = (fargs.filter_col1[col_offset] >= fargs.compare1 && fargs.filter_col1[col_offset] <= fargs.compare2);
-                else if (fargs.mode1 == 2)
-                  selection_flag = (fargs.filter_col1[col_offset] == fargs.compare1 || fargs.filter_col1[col_offset] == fargs.compare2);
-              }
-
-              if (fargs.filter_col2 != NULL) {
-                if (fargs.mode2 == 1)
-                  selection_flag = selection_flag && (fargs.filter_col2[col_offset] >= fargs.compare3 && fargs.filter_col2[col_offset] <= fargs.compare4);
-                else if (fargs.mode2 == 2)
-                  selection_flag = selection_flag && (fargs.filter_col2[col_offset] == fargs.compare3 || fargs.filter_col2[col_offset] == fargs.compare4);
-              }
-
-              if (selection_flag) {
-                temp[count] = col_offset;
-                count++;        
-              }
-            }
-          }
-
-          for (int i = end_batch ; i < end; i++) {
-            bool selection_flag = 1;
-            int col_offset;
-
-            col_offset = off_col[start_offset + i];
-
-              if (fargs.filter_col1 != NULL) {
-                if (fargs.mode1 == 1)
-                  selection_flag = (fargs.filter_col1[col_offset] >= fargs.compare1 && fargs.filter_col1[col_offset] <= fargs.compare2);
-                else if (fargs.mode1 == 2)
-                  selection_flag = (fargs.filter_col1[col_offset] == fargs.compare1 || fargs.filter_col1[col_offset] == fargs.compare2);
-              }
-
-              if (fargs.filter_col2 != NULL) {
-                if (fargs.mode2 == 1)
-                  selection_flag = selection_flag && (fargs.filter_col2[col_offset] >= fargs.compare3 && fargs.filter_col2[col_offset] <= fargs.compare4);
-                else if (fargs.mode2 == 2)
-                  selection_flag = selection_flag && (fargs.filter_col2[col_offset] == fargs.compare3 || fargs.filter_col2[col_offset] == fargs.compare4);
-              }
-
-            if (selection_flag) {
-              temp[count] = col_offset;
-              count++;
-            }
-          }
+          int count = filterSparseCPU(fargs, off_col + start_offset + start, end - start, temp);
 
           int thread_off = __atomic_fetch_add(total, count, __ATOMIC_RELAXED);
 
@@ -1338,9 +1456,13 @@ void groupByCPU(struct offsetCPU offset,
   int task_count = (num_tuples + TASK_SIZE - 1)/TASK_SIZE;
   int rem_task = (num_tuples % TASK_SIZE == 0) ? (TASK_SIZE):(num_tuples % TASK_SIZE);
 
+  GroupByCPU gb(res, gargs.total_val, num_tuples);
+
   parallel_for(blocked_range<size_t>(0, task_count), [&](auto range) {
     unsigned int start_task = range.begin();
     unsigned int end_task = range.end();
+    int* table = gb.localTable();
+    groupbyBufferCPU* part = gb.localPartition();
 
     for (int task = start_task; task < end_task; task++) {
           unsigned int start = task * TASK_SIZE;
@@ -1379,16 +1501,12 @@ void groupByCPU(struct offsetCPU offset,
 
               int hash = ((groupval1 - gargs.min_val1) * gargs.unique_val1 + (groupval2 - gargs.min_val2) * gargs.unique_val2 +  (groupval3 - gargs.min_val3) * gargs.unique_val3 + (groupval4 - gargs.min_val4) * gargs.unique_val4) % gargs.total_val;
 
-              if (groupval1 != 0) res[hash * 6] = groupval1;
-              if (groupval2 != 0) res[hash * 6 + 1] = groupval2;
-              if (groupval3 != 0) res[hash * 6 + 2] = groupval3;
-              if (groupval4 != 0) res[hash * 6 + 3] = groupval4;
 
               if (gargs.aggr_col1 != NULL) aggrval1 = gargs.aggr_col1[offset.h_lo_off[i]];
               if (gargs.aggr_col2 != NULL) aggrval2 = gargs.aggr_col2[offset.h_lo_off[i]];
               int temp = aggrval1 - aggrval2;
 
-              __atomic_fetch_add(reinterpret_cast<unsigned long long*>(&res[hash * 6 + 4]), (long long)(temp), __ATOMIC_RELAXED);
+              gb.aggregate(table, part, hash, groupval1, groupval2, groupval3, groupval4, temp);
             }
           }
           for (int i = end_batch ; i < end; i++) {
@@ -1421,20 +1539,18 @@ void groupByCPU(struct offsetCPU offset,
 
               int hash = ((groupval1 - gargs.min_val1) * gargs.unique_val1 + (groupval2 - gargs.min_val2) * gargs.unique_val2 +  (groupval3 - gargs.min_val3) * gargs.unique_val3 + (groupval4 - gargs.min_val4) * gargs.unique_val4) % gargs.total_val;
 
-              if (groupval1 != 0) res[hash * 6] = groupval1;
-              if (groupval2 != 0) res[hash * 6 + 1] = groupval2;
-              if (groupval3 != 0) res[hash * 6 + 2] = groupval3;
-              if (groupval4 != 0) res[hash * 6 + 3] = groupval4;
 
               if (gargs.aggr_col1 != NULL) aggrval1 = gargs.aggr_col1[offset.h_lo_off[i]];
               if (gargs.aggr_col2 != NULL) aggrval2 = gargs.aggr_col2[offset.h_lo_off[i]];
               int temp = aggrval1 - aggrval2;
 
-              __atomic_fetch_add(reinterpret_cast<unsigned long long*>(&res[hash * 6 + 4]), (long long)(temp), __ATOMIC_RELAXED);
+              gb.aggregate(table, part, hash, groupval1, groupval2, groupval3, groupval4, temp);
           }
 
     }
   });
+
+  gb.combine();
 }
 
 void aggregationCPU(int* lo_off, 
@@ -1494,66 +1610,8 @@ void probe_aggr_CPU(
 
   assert(segment_group != NULL);
 
-  int task_count = (num_tuples + TASK_SIZE - 1)/TASK_SIZE;
-  int rem_task = (num_tuples % TASK_SIZE == 0) ? (TASK_SIZE):(num_tuples % TASK_SIZE);
-
-  parallel_for(blocked_range<size_t>(0, task_count), [&](auto range) {
-    unsigned int start_task = range.begin();
-    unsigned int end_task = range.end();
-
-    long long local_sum = 0;
-
-    for (int task = start_task; task < end_task; task++) {
-          unsigned int start = task * TASK_SIZE;
-          unsigned int end = (task == task_count - 1) ? (task * TASK_SIZE + rem_task):(task * TASK_SIZE + TASK_SIZE);
-          unsigned int end_batch = start + ((end - start)/BATCH_SIZE) * BATCH_SIZE;
-
-          int segment_idx = segment_group[start / SEGMENT_SIZE];
-
-          for (int batch_start = start; batch_start < end_batch; batch_start += BATCH_SIZE) {
-            #pragma simd
-            for (int i = batch_start; i < batch_start + BATCH_SIZE; i++) {
-              int hash;
-              long long slot;
-              int lo_offset;
-
-              lo_offset = segment_idx * SEGMENT_SIZE + (i % SEGMENT_SIZE);
-
-                hash = HASH(pargs.key_col4[lo_offset], pargs.dim_len4, pargs.min_key4);
-                slot = reinterpret_cast<long long*>(pargs.ht4)[hash];
-                if (slot == 0) continue;
-
-              int aggrval1 = 0, aggrval2 = 0;
-              if (gargs.aggr_col1 != NULL) aggrval1 = gargs.aggr_col1[lo_offset];
-              if (gargs.aggr_col2 != NULL) aggrval2 = gargs.aggr_col2[lo_offset];
-              // local_sum += (*(gargs.h_group_func))(aggrval1, aggrval2);
-              local_sum += aggrval1 * aggrval2;
-            }
-          }
-
-          for (int i = end_batch ; i < end; i++) {
-
-            int hash;
-            long long slot;
-            int lo_offset;
-
-            lo_offset = segment_idx * SEGMENT_SIZE + (i % SEGMENT_SIZE);
-
-              hash = HASH(pargs.key_col4[lo_offset], pargs.dim_len4, pargs.min_key4);
-              slot = reinterpret_cast<long long*>(pargs.ht4)[hash];
-              if (slot == 0) continue;
-
-            int aggrval1 = 0, aggrval2 = 0;
-            if (gargs.aggr_col1 != NULL) aggrval1 = gargs.aggr_col1[lo_offset];
-            if (gargs.aggr_col2 != NULL) aggrval2 = gargs.aggr_col2[lo_offset];
-            // local_sum += (*(gargs.h_group_func))(aggrval1, aggrval2);
-            local_sum += aggrval1 * aggrval2;
-          }
-    }
-
-    __atomic_fetch_add(reinterpret_cast<unsigned long long*>(&res[4]), (long long)(local_sum), __ATOMIC_RELAXED);
-
-  }, simple_partitioner());
+  struct filterArgsCPU fargs = {};
+  pipelineDenseCPU(fargs, pargs, gargs, num_tuples, res, start_offset, segment_group);
 
 }
 
@@ -1631,81 +1689,7 @@ void filter_probe_aggr_CPU(
 
   assert(segment_group != NULL);
 
-  int task_count = (num_tuples + TASK_SIZE - 1)/TASK_SIZE;
-  int rem_task = (num_tuples % TASK_SIZE == 0) ? (TASK_SIZE):(num_tuples % TASK_SIZE);
-
-  parallel_for(blocked_range<size_t>(0, task_count), [&](auto range) {
-    unsigned int start_task = range.begin();
-    unsigned int end_task = range.end();
-
-    long long local_sum = 0;
-
-    for (int task = start_task; task < end_task; task++) {
-          unsigned int start = task * TASK_SIZE;
-          unsigned int end = (task == task_count - 1) ? (task * TASK_SIZE + rem_task):(task * TASK_SIZE + TASK_SIZE);
-          unsigned int end_batch = start + ((end - start)/BATCH_SIZE) * BATCH_SIZE;
-
-          int segment_idx = segment_group[start / SEGMENT_SIZE];
-
-          for (int batch_start = start; batch_start < end_batch; batch_start += BATCH_SIZE) {
-            #pragma simd
-            for (int i = batch_start; i < batch_start + BATCH_SIZE; i++) {
-              int hash;
-              long long slot;
-              int lo_offset;
-
-              lo_offset = segment_idx * SEGMENT_SIZE + (i % SEGMENT_SIZE);
-
-                if (!(fargs.filter_col1[lo_offset] >= fargs.compare1 && fargs.filter_col1[lo_offset] <= fargs.compare2)) continue; //only for Q1.x
-                // if (!(*(fargs.h_filter_func1))(fargs.filter_col1[lo_offset], fargs.compare1, fargs.compare2)) continue;
-
-                if (!(fargs.filter_col2[lo_offset] >= fargs.compare3 && fargs.filter_col2[lo_offset] <= fargs.compare4)) continue; //only for Q1.x
-                // if (!(*(fargs.h_filter_func2))(fargs.filter_col2[lo_offset], fargs.compare3, fargs.compare4)) continue;
-
-                hash = HASH(pargs.key_col4[lo_offset], pargs.dim_len4, pargs.min_key4);
-                slot = reinterpret_cast<long long*>(pargs.ht4)[hash];
-                if (slot == 0) continue;
-
-              int aggrval1 = 0, aggrval2 = 0;
-              if (gargs.aggr_col1 != NULL) aggrval1 = gargs.aggr_col1[lo_offset];
-              if (gargs.aggr_col2 != NULL) aggrval2 = gargs.aggr_col2[lo_offset];
-              // local_sum += (*(gargs.h_group_func))(aggrval1, aggrval2);
-              local_sum += aggrval1 * aggrval2;
-
-            }
-          }
-
-          for (int i = end_batch ; i < end; i++) {
-
-            int hash;
-            long long slot;
-            int lo_offset;
-
-            lo_offset = segment_idx * SEGMENT_SIZE + (i % SEGMENT_SIZE);
-
-              if (!(fargs.filter_col1[lo_offset] >= fargs.compare1 && fargs.filter_col1[lo_offset] <= fargs.compare2)) continue; //only for Q1.x
-              // if (!(*(fargs.h_filter_func1))(fargs.filter_col1[lo_offset], fargs.compare1, fargs.compare2)) continue;
-
-              if (!(fargs.filter_col2[lo_offset] >= fargs.compare3 && fargs.filter_col2[lo_offset] <= fargs.compare4)) continue; //only for Q1.x
-              // if (!(*(fargs.h_filter_func2))(fargs.filter_col2[lo_offset], fargs.compare3, fargs.compare4)) continue;
-
-              hash = HASH(pargs.key_col4[lo_offset], pargs.dim_len4, pargs.min_key4);
-              slot = reinterpret_cast<long long*>(pargs.ht4)[hash];
-              if (slot == 0) continue;
-
-              int aggrval1 = 0, aggrval2 = 0;
-              if (gargs.aggr_col1 != NULL) aggrval1 = gargs.aggr_col1[lo_offset];
-              if (gargs.aggr_col2 != NULL) aggrval2 = gargs.aggr_col2[lo_offset];
-              // local_sum += (*(gargs.h_group_func))(aggrval1, aggrval2);
-              local_sum += aggrval1 * aggrval2;
-
-          }
-
-    }
-
-    __atomic_fetch_add(reinterpret_cast<unsigned long long*>(&res[4]), (long long)(local_sum), __ATOMIC_RELAXED);
-
-  }, simple_partitioner());
+  pipelineDenseCPU(fargs, pargs, gargs, num_tuples, res, start_offset, segment_group);
 
 }
 
@@ -3,10 +3,199 @@
 
 #include "common.h"
 #include "KernelArgs.h"
+#include "SIMDSelect.h"
+#include "SegmentPack.h"
+#include "SegmentSlice.h"
 
 #define BATCH_SIZE 256
 #define NUM_THREADS 48
 #define TASK_SIZE 1024 //! TASK_SIZE must be a factor of SEGMENT_SIZE and must be less than 20000
+#define GROUPBY_CACHE_SIZE 262144 //bytes of private group by state a worker keeps cache resident (L2)
+#define GROUPBY_CHUNK 256 //entries a worker buffers per partition in partitioned group by
+#define MORSEL_SIZE 16384 //rows of fact table per morsel, must be a factor of SEGMENT_SIZE and a multiple of BATCH_SIZE
+#define PROBE_INFLIGHT 16 //hash table lookups a worker keeps in flight in ProbeAMAC mode
+
+//how the cpu group by kernels accumulate into res
+enum GroupByModeCPU {
+  GroupByAtomic, //every tuple does an atomic add on the shared res
+  GroupByLocal, //every worker pre-aggregates into a private copy of res, merged at the end
+  GroupByPartitioned, //tuples are radix partitioned on the high bits of their group into bounded per worker chunks, a full chunk is aggregated into its cache resident partition
+  GroupByAuto //local if the private copy fits in GROUPBY_CACHE_SIZE, partitioned otherwise
+};
+
+extern GroupByModeCPU group_by_mode_cpu;
+
+//how the cpu probe kernels walk the hash tables
+enum ProbeModeCPU {
+  ProbeDirect, //every row chases its hash tables one after another
+  ProbeGroupPrefetch, //hashes of a whole batch are computed and prefetched, then the batch is probed
+  ProbeAMAC, //a ring of PROBE_INFLIGHT lookups, the oldest is read and replaced by the next row as soon as its line arrives
+  ProbeModeCount
+};
+
+extern ProbeModeCPU probe_mode_cpu;
+extern const char* probe_mode_name_cpu[];
+
+//ProbeModeCount for an unknown name
+ProbeModeCPU probeModeCPU(string name);
+
+//the fact filters evaluate their predicates on the codes of the bit packed copy of a column (filter_pack1/2)
+//instead of reading its raw values, off to compare
+extern bool packed_scan_cpu;
+
+//the dense fact filters evaluate their predicates on the bit sliced copy of a column (filter_slice1/2) into a
+//bitmap of the batch, both filters are and'ed on the bitmaps before any row offset is written. off to compare
+extern bool sliced_scan_cpu;
+
+//probe the hash tables of pargs for the num rows of lo_off, one table at a time over the whole batch.
+//rows without a match are dropped: lo_off, pos (may be NULL) and slot are compacted to the matching rows
+//and their count is returned. slot[k][i] is the slot of table k, (1 << 32) for a table pargs does not probe
+int probeBatchCPU(ProbeModeCPU mode, struct probeArgsCPU& pargs, int* lo_off, int* pos, int num, long long slot[4][BATCH_SIZE]);
+
+typedef struct groupbyEntryCPU {
+  int hash;
+  int val;
+  int key[4];
+} groupbyEntryCPU;
+
+//partitioned mode, per worker: a preallocated chunk of GROUPBY_CHUNK entries for every partition
+typedef struct groupbyBufferCPU {
+  vector<groupbyEntryCPU> entry; //chunk of partition p at p * GROUPBY_CHUNK
+  vector<int> fill; //entries in the chunk of every partition
+} groupbyBufferCPU;
+
+//aggregation state of one group by kernel call, res keeps the 6 int per group layout
+class GroupByCPU {
+public:
+  int* res;
+  int total_val;
+  GroupByModeCPU mode;
+  int num_part;
+  int part_bits; //partition of a group is hash >> part_bits
+  long long* part_sum; //partitioned mode: the sum of every group, partition by partition
+  mutex* part_lock; //per partition, held while a chunk is aggregated into part_sum
+
+  enumerable_thread_specific<vector<long long>>* local_res;
+  enumerable_thread_specific<groupbyBufferCPU>* local_part;
+
+  GroupByCPU(int* _res, int _total_val, int num_tuples);
+  ~GroupByCPU();
+
+  static GroupByModeCPU chooseMode(int total_val, int num_tuples);
+
+  //per task handles, the table is res itself in atomic mode and NULL in partitioned mode
+  int* localTable();
+  groupbyBufferCPU* localPartition();
+
+  inline void aggregate(int* table, groupbyBufferCPU* part, int hash, int val1, int val2, int val3, int val4, int temp) {
+    if (mode == GroupByPartitioned) {
+      int p = hash >> part_bits;
+      groupbyEntryCPU& entry = part->entry[p * GROUPBY_CHUNK + part->fill[p]];
+      entry.hash = hash;
+      entry.val = temp;
+      entry.key[0] = val1;
+      entry.key[1] = val2;
+      entry.key[2] = val3;
+      entry.key[3] = val4;
+      if (++part->fill[p] == GROUPBY_CHUNK) flush(part, p);
+      return;
+    }
+
+    if (val1 != 0) table[hash * 6] = val1;
+    if (val2 != 0) table[hash * 6 + 1] = val2;
+    if (val3 != 0) table[hash * 6 + 2] = val3;
+    if (val4 != 0) table[hash * 6 + 3] = val4;
+
+    if (mode == GroupByAtomic)
+      __atomic_fetch_add(reinterpret_cast<unsigned long long*>(&table[hash * 6 + 4]), (long long)(temp), __ATOMIC_RELAXED);
+    else
+      reinterpret_cast<long long*>(table)[hash * 3 + 2] += temp;
+  }
+
+  //aggregate the full chunk of partition p into part_sum and write its keys to res
+  void flush(groupbyBufferCPU* part, int p);
+
+  void aggregateEntries(const groupbyEntryCPU* entry, int num);
+
+  //fold the private tables or partitions into res
+  void combine();
+};
+
+//a slice of one fact segment, the unit of work of the morsel scheduler
+typedef struct morselCPU {
+  int segment_idx;
+  int start; //first row inside the segment
+  int num;
+} morselCPU;
+
+extern bool morsel_driven_cpu;
+
+//position of the fact scans running on the cpu. a scheduler joining it starts at the segment the running scans
+//are at and wraps around, so concurrent queries read a segment from memory at about the same time instead of
+//each streaming the whole fact table on its own
+typedef struct sharedScan {
+  std::atomic<int> active;
+  std::atomic<int> position;
+} sharedScan;
+
+extern bool shared_scan_cpu;
+extern sharedScan fact_scan;
+
+//fact work of many segment groups cut into fixed size morsels and pulled by one worker per core.
+//morsels are queued on the home node of their segment (see NumaPlacement.h), a worker drains the queue
+//of its own node first and then steals from the other nodes, so segment groups of different size do not leave stragglers
+class MorselScheduler {
+public:
+  int num_node;
+  int num_worker;
+  int num_tuples;
+  vector<vector<morselCPU>> queue; //per numa node
+  std::atomic<int>* cursor; //next unclaimed morsel of every queue
+  sharedScan* scan; //NULL unless joinScan
+
+  MorselScheduler(int _num_worker = 0);
+  ~MorselScheduler();
+
+  //pinned workers know their node, unpinned ones are spread over the queues
+  inline int workerNode(int worker) {
+    return numaPlacement().pin_workers ? numaCurrentNode() % num_node : worker % num_node;
+  }
+
+  //LEN is the length of the fact table, the last segment only has LEN % SEGMENT_SIZE rows
+  void addSegments(short* segment_group, int count, int total_segment, int LEN);
+
+  bool next(int node, morselCPU& morsel);
+
+  //after the last addSegments, reorders the queues to start at the position of scan
+  void joinScan(sharedScan* _scan);
+
+  void leaveScan();
+
+  //work(worker, node, morsel) runs every morsel once, each worker runs its morsels one after another
+  template <typename F>
+  void run(F work) {
+    parallel_for(blocked_range<int>(0, num_worker), [&](auto range) {
+      for (int worker = range.begin(); worker < range.end(); worker++) {
+        int node = workerNode(worker);
+        morselCPU morsel;
+        while (next(node, morsel)) {
+          work(worker, node, morsel);
+          if (scan != NULL) scan->position.store(morsel.segment_idx, std::memory_order_relaxed);
+        }
+      }
+    }, simple_partitioner());
+  }
+};
+
+//whole filter, probe and group by (or aggregation) pipeline of one morsel at a time.
+//pargs has one entry per node of sched, each pointing at the hash table replicas of that node
+void filter_probe_group_by_morsel_CPU(
+  struct filterArgsCPU fargs, struct probeArgsCPU* pargs, struct groupbyArgsCPU gargs,
+  MorselScheduler& sched, int* res);
+
+void filter_probe_aggr_morsel_CPU(
+  struct filterArgsCPU fargs, struct probeArgsCPU* pargs, struct groupbyArgsCPU gargs,
+  MorselScheduler& sched, int* res);
 
 void filter_probe_CPU(
   struct filterArgsCPU fargs, struct probeArgsCPU pargs, struct offsetCPU out_off, int num_tuples,
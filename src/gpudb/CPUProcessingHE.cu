@@ -1,4 +1,5 @@
 #include "CPUProcessingHE.h"
+#include "CPUPipeline.h"
 
 void filter_probe_CPUHE(
   struct filterArgsCPU fargs, struct probeArgsCPU pargs, struct offsetCPU out_off, int num_tuples,
@@ -193,58 +194,8 @@ void probe_group_by_CPUHE(
   struct probeArgsCPU pargs,  struct groupbyArgsCPU gargs, int num_tuples, 
   int* res, int start_offset = 0, short* segment_group = NULL) {
 
-    for (int i = 0; i < num_tuples; i++) {
-
-        int hash;
-        long long slot;
-        int dim_val1 = 0, dim_val2 = 0, dim_val3 = 0, dim_val4 = 0;
-        int lo_offset;
-
-        lo_offset = start_offset + i;
-
-        if (pargs.key_col1 != NULL && pargs.ht1 != NULL) {
-          hash = HASH(pargs.key_col1[lo_offset], pargs.dim_len1, pargs.min_key1);
-          slot = reinterpret_cast<long long*>(pargs.ht1)[hash];
-          if (slot == 0) continue;
-          dim_val1 = slot;
-        }
-
-        if (pargs.key_col2 != NULL && pargs.ht2 != NULL) {
-          hash = HASH(pargs.key_col2[lo_offset], pargs.dim_len2, pargs.min_key2);
-          slot = reinterpret_cast<long long*>(pargs.ht2)[hash];
-          if (slot == 0) continue;
-          dim_val2 = slot;
-        }
-
-        if (pargs.key_col3 != NULL && pargs.ht3 != NULL) {
-          hash = HASH(pargs.key_col3[lo_offset], pargs.dim_len3, pargs.min_key3);
-          slot = reinterpret_cast<long long*>(pargs.ht3)[hash];
-          if (slot == 0) continue;
-          dim_val3 = slot;
-        }
-
-        if (pargs.key_col4 != NULL && pargs.ht4 != NULL) {
-          hash = HASH(pargs.key_col4[lo_offset], pargs.dim_len4, pargs.min_key4);
-          slot = reinterpret_cast<long long*>(pargs.ht4)[hash];
-          if (slot == 0) continue;
-          dim_val4 = slot;
-        }
-
-        hash = ((dim_val1 - gargs.min_val1) * gargs.unique_val1 + (dim_val2 - gargs.min_val2) * gargs.unique_val2 +  (dim_val3 - gargs.min_val3) * gargs.unique_val3 + (dim_val4 - gargs.min_val4) * gargs.unique_val4) % gargs.total_val;
-        if (dim_val1 != 0) res[hash * 6] = dim_val1;
-        if (dim_val2 != 0) res[hash * 6 + 1] = dim_val2;
-        if (dim_val3 != 0) res[hash * 6 + 2] = dim_val3;
-        if (dim_val4 != 0) res[hash * 6 + 3] = dim_val4;
-
-        int aggr1 = 0; int aggr2 = 0;
-        if (gargs.aggr_col1 != NULL) aggr1 = gargs.aggr_col1[lo_offset];
-        if (gargs.aggr_col2 != NULL) aggr2 = gargs.aggr_col2[lo_offset];
-        // int temp = (*(gargs.h_group_func))(aggr1, aggr2);
-        int temp = aggr1 - aggr2;
-
-        __atomic_fetch_add(reinterpret_cast<unsigned long long*>(&res[hash * 6 + 4]), (long long)(temp), __ATOMIC_RELAXED);
-
-    }
+  struct filterArgsCPU fargs = {};
+  pipelineSerialCPU(fargs, pargs, gargs, num_tuples, res, start_offset);
 
 }
 
@@ -450,30 +401,8 @@ void probe_aggr_CPUHE(
   struct probeArgsCPU pargs, struct groupbyArgsCPU gargs, int num_tuples,
   int* res, int start_offset = 0, short* segment_group = NULL) {
 
-  assert(segment_group != NULL);
-
-    long long local_sum = 0;
-
-          for (int i = 0; i < num_tuples; i++) {
-            int hash;
-            long long slot;
-            int lo_offset;
-
-            lo_offset = start_offset + i;
-
-              hash = HASH(pargs.key_col4[lo_offset], pargs.dim_len4, pargs.min_key4);
-              slot = reinterpret_cast<long long*>(pargs.ht4)[hash];
-              if (slot == 0) continue;
-
-            int aggrval1 = 0, aggrval2 = 0;
-            if (gargs.aggr_col1 != NULL) aggrval1 = gargs.aggr_col1[lo_offset];
-            if (gargs.aggr_col2 != NULL) aggrval2 = gargs.aggr_col2[lo_offset];
-            // local_sum += (*(gargs.h_group_func))(aggrval1, aggrval2);
-            local_sum += aggrval1 * aggrval2;
-          }
-
-    __atomic_fetch_add(reinterpret_cast<unsigned long long*>(&res[4]), (long long)(local_sum), __ATOMIC_RELAXED);
-
+  struct filterArgsCPU fargs = {};
+  pipelineSerialCPU(fargs, pargs, gargs, num_tuples, res, start_offset);
 
 }
 
@@ -512,33 +441,7 @@ void filter_probe_aggr_CPUHE(
   struct filterArgsCPU fargs, struct probeArgsCPU pargs, struct groupbyArgsCPU gargs,
   int num_tuples, int* res, int start_offset = 0, short* segment_group = NULL) {
 
-  // assert(segment_group != NULL);
-
-    long long local_sum = 0;
-
-              for (int i = 0; i < num_tuples; i++) {
-                int hash;
-                long long slot;
-                int lo_offset;
-
-                lo_offset = start_offset + i;
-
-                  if (!(fargs.filter_col1[lo_offset] >= fargs.compare1 && fargs.filter_col1[lo_offset] <= fargs.compare2)) continue; //only for Q1.x
-
-                  if (!(fargs.filter_col2[lo_offset] >= fargs.compare3 && fargs.filter_col2[lo_offset] <= fargs.compare4)) continue; //only for Q1.x
-
-                  hash = HASH(pargs.key_col4[lo_offset], pargs.dim_len4, pargs.min_key4);
-                  slot = reinterpret_cast<long long*>(pargs.ht4)[hash];
-                  if (slot == 0) continue;
-
-                int aggrval1 = 0, aggrval2 = 0;
-                if (gargs.aggr_col1 != NULL) aggrval1 = gargs.aggr_col1[lo_offset];
-                if (gargs.aggr_col2 != NULL) aggrval2 = gargs.aggr_col2[lo_offset];
-                local_sum += aggrval1 * aggrval2;
-
-              }
-
-    __atomic_fetch_add(reinterpret_cast<unsigned long long*>(&res[4]), (long long)(local_sum), __ATOMIC_RELAXED);
+  pipelineSerialCPU(fargs, pargs, gargs, num_tuples, res, start_offset);
 
 }
 
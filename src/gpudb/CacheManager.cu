@@ -1,4 +1,8 @@
 #include "CacheManager.h"
+#include "CPUProcessing.h"
+#include "HashTableCache.h"
+#include "JoinSummary.h"
+#include "ResultCache.h"
 
 Segment::Segment(ColumnInfo* _column, int* _seg_ptr, int _priority)
 : column(_column), seg_ptr(_seg_ptr), priority(_priority), seg_size(SEGMENT_SIZE) {
@@ -23,6 +27,8 @@ ColumnInfo::ColumnInfo(string _column_name, string _table_name, int _LEN, int _c
 	weight = 0;
 	seg_ptr = col_ptr;
 	total_segment = (LEN+SEGMENT_SIZE-1)/SEGMENT_SIZE;
+	pack = NULL;
+	slice = NULL;
 }
 
 Segment*
@@ -31,6 +37,24 @@ ColumnInfo::getSegment(int index) {
 	return seg;
 }
 
+//fallback of the processing arenas when a region is full
+static void* spillHost(size_t bytes) { return numaAllocInterleaved(bytes); }
+static void spillHostFree(void* ptr, size_t bytes) { numaFree(ptr, bytes); }
+
+static void* spillDevice(size_t bytes) {
+	void* ptr = NULL;
+	if (deviceMalloc(&ptr, bytes) != cudaSuccess) return NULL;
+	return ptr;
+}
+static void spillDeviceFree(void* ptr, size_t bytes) { CubDebugExit(deviceFree(ptr)); }
+
+static void* spillPinned(size_t bytes) {
+	void* ptr = NULL;
+	if (deviceHostAlloc(&ptr, bytes, cudaHostAllocDefault) != cudaSuccess) return NULL;
+	return ptr;
+}
+static void spillPinnedFree(void* ptr, size_t bytes) { CubDebugExit(deviceFreeHost(ptr)); }
+
 CacheManager::CacheManager(size_t _cache_size, size_t _ondemand_size, size_t _processing_size, size_t _pinned_memsize) {
 	cache_size = _cache_size;
 	ondemand_size = _ondemand_size;
@@ -41,20 +65,39 @@ CacheManager::CacheManager(size_t _cache_size, size_t _ondemand_size, size_t _pr
 	TOT_COLUMN = 25;
 	TOT_TABLE = 5;
 
-	CubDebugExit(cudaMalloc((void**) &gpuCache, (cache_size + ondemand_size) * sizeof(int)));
-	CubDebugExit(cudaMemset(gpuCache, 0, (cache_size + ondemand_size) * sizeof(int)));
-	CubDebugExit(cudaMalloc((void**) &gpuProcessing, _processing_size * sizeof(uint64_t)));
+	CubDebugExit(deviceMallocPool((void**) &gpuCache, (cache_size + ondemand_size) * sizeof(int)));
+	CubDebugExit(deviceMemset(gpuCache, 0, (cache_size + ondemand_size) * sizeof(int)));
+	CubDebugExit(deviceMalloc((void**) &gpuProcessing, _processing_size * sizeof(uint64_t)));
 
-	cpuProcessing = (uint64_t*) malloc(_processing_size * sizeof(uint64_t));
-	CubDebugExit(cudaHostAlloc((void**) &pinnedMemory, _pinned_memsize * sizeof(uint64_t), cudaHostAllocDefault));
-	gpuPointer = 0;
-	cpuPointer = 0;
-	pinnedPointer = 0;
+	cpuProcessing = (uint64_t*) numaAllocInterleaved(_processing_size * sizeof(uint64_t));
+	CubDebugExit(deviceHostAlloc((void**) &pinnedMemory, (_pinned_memsize + ADMISSION_STAGING) * sizeof(uint64_t), cudaHostAllocDefault));
+	for (int i = 0; i < ADMISSION_BUFFERS; i++) admission_buffer[i] = (int*) (pinnedMemory + _pinned_memsize) + i * SEGMENT_SIZE;
 	onDemandPointer = cache_size;
+	sessions = 0;
+
+	cpu_arena = new ProcessingArena("cpu", spillHost, spillHostFree);
+	gpu_arena = new ProcessingArena("gpu", spillDevice, spillDeviceFree);
+	pinned_arena = new ProcessingArena("pinned", spillPinned, spillPinnedFree);
+	assignArenas();
+	query_scope = new ProcessingScope(this);
 
 	cached_seg_in_GPU.resize(TOT_COLUMN);
 	allColumn.resize(TOT_COLUMN);
 
+	for (int i = 0; i <= LRU2Segmented; i++) segment_ranking[i] = NULL;
+	replacement_evicted = 0;
+	replacement_admitted = 0;
+	trace = NULL;
+	ht_cache = NULL;
+	result_cache = NULL;
+	join_summary = new JoinSummaryCache();
+
+	async_admission = false;
+	admission_bandwidth = 0;
+	admission_published = 0;
+	admission_cancel = false;
+	for (int i = 0; i < ADMISSION_BUFFERS; i++) CubDebugExit(deviceStreamCreate(&admission_stream[i]));
+
 	index_to_segment.resize(TOT_COLUMN);
 
 	for(int i = 0; i < cache_total_seg; i++) {
@@ -68,21 +111,26 @@ CacheManager::CacheManager(size_t _cache_size, size_t _ondemand_size, size_t _pr
 	od_segment_list = (int**) malloc (TOT_COLUMN * sizeof(int*));
 	segment_min = (int**) malloc (TOT_COLUMN * sizeof(int*));
 	segment_max = (int**) malloc (TOT_COLUMN * sizeof(int*));
+	segment_stats = (segmentStats**) malloc (TOT_COLUMN * sizeof(segmentStats*));
 
 	for (int i = 0; i < TOT_COLUMN; i++) {
 		int n = allColumn[i]->total_segment;
 		segment_bitmap[i] = (char*) malloc(n * sizeof(char));
-		CubDebugExit(cudaHostAlloc((void**) &(segment_list[i]), n * sizeof(int), cudaHostAllocDefault));
-		CubDebugExit(cudaHostAlloc((void**) &(od_segment_list[i]), n * sizeof(int), cudaHostAllocDefault));
+		CubDebugExit(deviceHostAlloc((void**) &(segment_list[i]), n * sizeof(int), cudaHostAllocDefault));
+		CubDebugExit(deviceHostAlloc((void**) &(od_segment_list[i]), n * sizeof(int), cudaHostAllocDefault));
 
 		segment_min[i] = (int*) malloc(n * sizeof(int));
 		segment_max[i] = (int*) malloc(n * sizeof(int));
+		segment_stats[i] = (segmentStats*) malloc(n * sizeof(segmentStats));
 
 		memset(segment_bitmap[i], 0, n * sizeof(char));
 		memset(segment_list[i], -1, n * sizeof(int));
 	}
 
 	readSegmentMinMax();
+	if (packed_scan_cpu) readSegmentPacks(); //--nopack leaves them on disk
+	readSegmentSlices();
+	readSegmentAggregates();
 
 	for (int i = 0; i < TOT_COLUMN; i++) {
 		index_to_segment[i].resize(allColumn[i]->total_segment);
@@ -98,18 +146,24 @@ CacheManager::CacheManager(size_t _cache_size, size_t _ondemand_size, size_t _pr
 void
 CacheManager::resetCache(size_t _cache_size, size_t _ondemand_size, size_t _processing_size, size_t _pinned_memsize) {
 
-	CubDebugExit(cudaFree(gpuCache));
-	CubDebugExit(cudaFree(gpuProcessing));
-	delete[] cpuProcessing;
-	CubDebugExit(cudaFreeHost(pinnedMemory));
+	finishAdmission(true);
+	if (ht_cache != NULL) ht_cache->clear();
+	query_scope->release();
+
+	CubDebugExit(deviceFree(gpuCache));
+	CubDebugExit(deviceFree(gpuProcessing));
+	numaFree(cpuProcessing, processing_size * sizeof(uint64_t));
+	CubDebugExit(deviceFreeHost(pinnedMemory));
 
 	for (int i = 0; i < TOT_COLUMN; i++) {
-		CubDebugExit(cudaFreeHost(segment_list[i]));
+		CubDebugExit(deviceFreeHost(segment_list[i]));
 		free(segment_bitmap[i]);
 	}
 	free(segment_list);
 	free(segment_bitmap);
 
+	dropSegmentRanking();
+
 	cache_size = _cache_size;
 	ondemand_size = _ondemand_size;
 	cache_total_seg = _cache_size/SEGMENT_SIZE;
@@ -119,16 +173,15 @@ CacheManager::resetCache(size_t _cache_size, size_t _ondemand_size, size_t _proc
 
 	cout << cache_size << " " << ondemand_size << endl;
 
-	CubDebugExit(cudaMalloc((void**) &gpuCache, (cache_size + ondemand_size) * sizeof(int)));
-	CubDebugExit(cudaMemset(gpuCache, 0, (cache_size + ondemand_size) * sizeof(int)));
-	CubDebugExit(cudaMalloc((void**) &gpuProcessing, _processing_size * sizeof(uint64_t)));
+	CubDebugExit(deviceMallocPool((void**) &gpuCache, (cache_size + ondemand_size) * sizeof(int)));
+	CubDebugExit(deviceMemset(gpuCache, 0, (cache_size + ondemand_size) * sizeof(int)));
+	CubDebugExit(deviceMalloc((void**) &gpuProcessing, _processing_size * sizeof(uint64_t)));
 
-	cpuProcessing = (uint64_t*) malloc(_processing_size * sizeof(uint64_t));
-	CubDebugExit(cudaHostAlloc((void**) &pinnedMemory, _pinned_memsize * sizeof(uint64_t), cudaHostAllocDefault));
-	gpuPointer = 0;
-	cpuPointer = 0;
-	pinnedPointer = 0;
+	cpuProcessing = (uint64_t*) numaAllocInterleaved(_processing_size * sizeof(uint64_t));
+	CubDebugExit(deviceHostAlloc((void**) &pinnedMemory, (_pinned_memsize + ADMISSION_STAGING) * sizeof(uint64_t), cudaHostAllocDefault));
+	for (int i = 0; i < ADMISSION_BUFFERS; i++) admission_buffer[i] = (int*) (pinnedMemory + _pinned_memsize) + i * SEGMENT_SIZE;
 	onDemandPointer = cache_size;
+	assignArenas();
 
 	while (!empty_gpu_segment.empty()) {
 		empty_gpu_segment.pop();
@@ -144,8 +197,8 @@ CacheManager::resetCache(size_t _cache_size, size_t _ondemand_size, size_t _proc
 	for (int i = 0; i < TOT_COLUMN; i++) {
 		int n = allColumn[i]->total_segment;
 		segment_bitmap[i] = (char*) malloc(n * sizeof(char));
-		CubDebugExit(cudaHostAlloc((void**) &(segment_list[i]), n * sizeof(int), cudaHostAllocDefault));
-		CubDebugExit(cudaHostAlloc((void**) &(od_segment_list[i]), n * sizeof(int), cudaHostAllocDefault));
+		CubDebugExit(deviceHostAlloc((void**) &(segment_list[i]), n * sizeof(int), cudaHostAllocDefault));
+		CubDebugExit(deviceHostAlloc((void**) &(od_segment_list[i]), n * sizeof(int), cudaHostAllocDefault));
 		memset(segment_bitmap[i], 0, n * sizeof(char));
 		memset(segment_list[i], -1, n * sizeof(int));
 	}
@@ -155,6 +208,18 @@ void
 CacheManager::readSegmentMinMax() {
 
 	for (int i = 0; i < TOT_COLUMN; i++) {
+		if (readSegmentStats(DATA_DIR + catalogStats(allColumn[i]->column_name), segment_stats[i], allColumn[i]->LEN, SEGMENT_SIZE)) {
+			for (int j = 0; j < allColumn[i]->total_segment; j++) {
+				segment_min[i][j] = segment_stats[i][j].min;
+				segment_max[i][j] = segment_stats[i][j].max;
+			}
+			continue;
+		}
+
+		//no binary stats, fall back to the text min max file
+		free(segment_stats[i]);
+		segment_stats[i] = NULL;
+
 		string line;
 		ifstream myfile (DATA_DIR + allColumn[i]->column_name + "minmax");
 		if (myfile.is_open()) {
@@ -183,31 +248,80 @@ CacheManager::readSegmentMinMax() {
 	}
 }
 
+//bit packed copies of the fact columns, a scan format of the cpu filters only: they are held next to the raw
+//columns, the gpu cache keeps and counts raw segments
+void
+CacheManager::readSegmentPacks() {
+
+	for (int i = 0; i < TOT_COLUMN; i++) {
+		if (allColumn[i]->table_id != 0) continue;
+		string file = catalogPack(allColumn[i]->column_name);
+		if (file.empty()) continue;
+		allColumn[i]->pack = readPackedColumn(DATA_DIR + file, allColumn[i]->LEN, SEGMENT_SIZE);
+	}
+}
+
+//bit sliced copies of the low cardinality fact columns, only the cpu filters read them
+void
+CacheManager::readSegmentSlices() {
+
+	for (int i = 0; i < TOT_COLUMN; i++) {
+		if (allColumn[i]->table_id != 0) continue;
+		string file = catalogSlice(allColumn[i]->column_name);
+		if (file.empty()) continue;
+		allColumn[i]->slice = readSlicedColumn(DATA_DIR + file, allColumn[i]->LEN, SEGMENT_SIZE);
+	}
+}
+
+//lineorder segment aggregates, kept when every column they name is one of allColumn
+void
+CacheManager::readSegmentAggregates() {
+
+	vector<string> files = catalogAggregates("lineorder");
+	for (int i = 0; i < files.size(); i++) {
+		segmentAggregates* aggr = readSegmentAggregates(DATA_DIR + files[i], lo_orderdate->LEN, SEGMENT_SIZE);
+		if (aggr == NULL) continue;
+		aggrHeader& h = aggr->header;
+		bool known = findColumn(h.measure_col[0]) != NULL && findColumn(h.key_col[0]) != NULL;
+		if (h.measure != AggrMeasureCol && findColumn(h.measure_col[1]) == NULL) known = false;
+		if (h.key_col[1][0] != 0 && findColumn(h.key_col[1]) == NULL) known = false;
+		if (!known) {
+			freeSegmentAggregates(aggr);
+			continue;
+		}
+		segment_aggr.push_back(aggr);
+	}
+}
+
+ColumnInfo*
+CacheManager::findColumn(string column_name) {
+	for (int i = 0; i < TOT_COLUMN; i++)
+		if (allColumn[i]->column_name == column_name) return allColumn[i];
+	return NULL;
+}
+
 template <typename T>
 T*
-CacheManager::customMalloc(int size) {
-	int alloc = ((size * sizeof(T)) + sizeof(uint64_t) - 1)/ sizeof(uint64_t);
-	int start = __atomic_fetch_add(&cpuPointer, alloc, __ATOMIC_RELAXED);
-	assert((start + alloc) < processing_size);
-	return reinterpret_cast<T*>(cpuProcessing + start);
+CacheManager::customMalloc(int size, ProcessingScope* scope) {
+	size_t alloc = (((size_t) size * sizeof(T)) + sizeof(uint64_t) - 1)/ sizeof(uint64_t);
+	if (scope == NULL) scope = query_scope;
+	return reinterpret_cast<T*>(scope->cpu.allocate(alloc));
 };
 
 template <typename T>
 T*
-CacheManager::customCudaMalloc(int size) {
-	int alloc = ((size * sizeof(T)) + sizeof(uint64_t) - 1)/ sizeof(uint64_t);
-	int start = __atomic_fetch_add(&gpuPointer, alloc, __ATOMIC_RELAXED);
-	assert((start + alloc) < processing_size);
-	return reinterpret_cast<T*>(gpuProcessing + start);
+CacheManager::customCudaMalloc(int size, ProcessingScope* scope) {
+	size_t alloc = (((size_t) size * sizeof(T)) + sizeof(uint64_t) - 1)/ sizeof(uint64_t);
+	if (scope == NULL) scope = query_scope;
+	return reinterpret_cast<T*>(scope->gpu.allocate(alloc));
 };
 
 template <typename T>
 T*
-CacheManager::customCudaHostAlloc(int size) {
-	int alloc = ((size * sizeof(T)) + sizeof(uint64_t) - 1)/ sizeof(uint64_t);
-	int start = __atomic_fetch_add(&pinnedPointer, alloc, __ATOMIC_RELAXED);
-	assert((start + alloc) < processing_size);
-	return reinterpret_cast<T*>(pinnedMemory + start);
+CacheManager::customCudaHostAlloc(int size, ProcessingScope* scope) {
+	size_t alloc = (((size_t) size * sizeof(T)) + sizeof(uint64_t) - 1)/ sizeof(uint64_t);
+	if (scope == NULL) scope = query_scope;
+	return reinterpret_cast<T*>(scope->pinned.allocate(alloc));
 };
 
 
@@ -223,8 +337,8 @@ CacheManager::onDemandTransfer(int* data_ptr, int size, cudaStream_t stream) {
 	assert(data_ptr != NULL);
 	if (data_ptr != NULL) {
 		int start = __atomic_fetch_add(&onDemandPointer, SEGMENT_SIZE, __ATOMIC_RELAXED);
-		CubDebugExit(cudaMemcpyAsync(gpuCache + start, data_ptr, size * sizeof(int), cudaMemcpyHostToDevice, stream));
-		CubDebugExit(cudaStreamSynchronize(stream));
+		CubDebugExit(deviceMemcpyAsync(gpuCache + start, data_ptr, size * sizeof(int), cudaMemcpyHostToDevice, stream));
+		CubDebugExit(deviceStreamSynchronize(stream));
 		return gpuCache + start;
 	} else {
 		return NULL;
@@ -236,36 +350,60 @@ CacheManager::onDemandTransfer2(ColumnInfo* column, int segment_idx, int size, c
 	if (segment_bitmap[column->column_id][segment_idx] == 0) {
 		int* data_ptr = column->col_ptr + segment_idx * SEGMENT_SIZE;
 		int start = __atomic_fetch_add(&onDemandPointer, SEGMENT_SIZE, __ATOMIC_RELAXED);
-		// CubDebugExit(cudaStreamSynchronize(stream));
-		CubDebugExit(cudaMemcpyAsync(gpuCache + start, data_ptr, size * sizeof(int), cudaMemcpyHostToDevice, stream));
-		CubDebugExit(cudaStreamSynchronize(stream));
+		// CubDebugExit(deviceStreamSynchronize(stream));
+		CubDebugExit(deviceMemcpyAsync(gpuCache + start, data_ptr, size * sizeof(int), cudaMemcpyHostToDevice, stream));
+		CubDebugExit(deviceStreamSynchronize(stream));
 		od_segment_list[column->column_id][segment_idx] = start / SEGMENT_SIZE;
 	}
 };
 
 void
-CacheManager::indexTransfer(int** col_idx, ColumnInfo* column, cudaStream_t stream, bool custom) {
+CacheManager::indexTransfer(int** col_idx, ColumnInfo* column, cudaStream_t stream, bool custom, ProcessingScope* scope) {
     if (col_idx[column->column_id] == NULL) {
       int* desired;
-      if (custom) desired = (int*) customCudaMalloc<int>(column->total_segment); 
-      else CubDebugExit(cudaMalloc((void**) &desired, column->total_segment * sizeof(int)));
+      if (custom) desired = (int*) customCudaMalloc<int>(column->total_segment, scope); 
+      else CubDebugExit(deviceMalloc((void**) &desired, column->total_segment * sizeof(int)));
       int* expected = NULL;
-      CubDebugExit(cudaMemcpyAsync(desired, segment_list[column->column_id], column->total_segment * sizeof(int), cudaMemcpyHostToDevice, stream));
-      CubDebugExit(cudaStreamSynchronize(stream));
+      CubDebugExit(deviceMemcpyAsync(desired, segment_list[column->column_id], column->total_segment * sizeof(int), cudaMemcpyHostToDevice, stream));
+      CubDebugExit(deviceStreamSynchronize(stream));
       __atomic_compare_exchange_n(&(col_idx[column->column_id]), &expected, desired, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
     }
 };
 
+//the column as the emulated gpu reads it through the segment index idx of a query (its copy of segment_list):
+//segment s of the view is slot idx[s] of gpuCache, a segment outside the cache stays unmapped and faults. the
+//view belongs to the query and is never remapped, releasePoolView drops it when the query ends
+int*
+CacheManager::mapPoolView(ColumnInfo* column, int* idx) {
+	assert(deviceIsHost());
+	HostDevice* device = (HostDevice*) g_device;
+	size_t segment_bytes = SEGMENT_SIZE * sizeof(int);
+
+	int* view = (int*) device->reserveView((size_t) column->total_segment * segment_bytes);
+	assert(view != NULL);
+	for (int s = 0; s < column->total_segment; s++) {
+		if (idx[s] < 0) continue;
+		bool mapped = device->mapView(view + (size_t) s * SEGMENT_SIZE, gpuCache + (size_t) idx[s] * SEGMENT_SIZE, segment_bytes);
+		assert(mapped);
+	}
+	return view;
+}
+
+void
+CacheManager::releasePoolView(ColumnInfo* column, int* view) {
+	((HostDevice*) g_device)->releaseView(view, (size_t) column->total_segment * SEGMENT_SIZE * sizeof(int));
+}
+
 void
-CacheManager::indexTransferOD(int** od_col_idx, ColumnInfo* column, cudaStream_t stream, bool custom) {
+CacheManager::indexTransferOD(int** od_col_idx, ColumnInfo* column, cudaStream_t stream, bool custom, ProcessingScope* scope) {
     if (od_col_idx[column->column_id] == NULL) {
     	// cout << "doing index transfer " << column->column_name << endl;
       int* desired;
-      if (custom) desired = (int*) customCudaMalloc<int>(column->total_segment); 
-      else CubDebugExit(cudaMalloc((void**) &desired, column->total_segment * sizeof(int)));
+      if (custom) desired = (int*) customCudaMalloc<int>(column->total_segment, scope); 
+      else CubDebugExit(deviceMalloc((void**) &desired, column->total_segment * sizeof(int)));
       int* expected = NULL;
-      CubDebugExit(cudaMemcpyAsync(desired, od_segment_list[column->column_id], column->total_segment * sizeof(int), cudaMemcpyHostToDevice, stream));
-      CubDebugExit(cudaStreamSynchronize(stream));
+      CubDebugExit(deviceMemcpyAsync(desired, od_segment_list[column->column_id], column->total_segment * sizeof(int), cudaMemcpyHostToDevice, stream));
+      CubDebugExit(deviceStreamSynchronize(stream));
       __atomic_compare_exchange_n(&(od_col_idx[column->column_id]), &expected, desired, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
     }
 };
@@ -273,12 +411,25 @@ CacheManager::indexTransferOD(int** od_col_idx, ColumnInfo* column, cudaStream_t
 
 void
 CacheManager::resetPointer() {
-	gpuPointer = 0;
-	cpuPointer = 0;
-	pinnedPointer = 0;
+	query_scope->release();
 	onDemandPointer = cache_size;
 };
 
+//the pinned arena ends at pinned_memsize, the admission staging buffers lie behind it
+void
+CacheManager::assignArenas() {
+	cpu_arena->assign(cpuProcessing, processing_size);
+	gpu_arena->assign(gpuProcessing, processing_size);
+	pinned_arena->assign(pinnedMemory, pinned_memsize);
+}
+
+void
+CacheManager::resetArenaStats() {
+	cpu_arena->resetStats();
+	gpu_arena->resetStats();
+	pinned_arena->resetStats();
+}
+
 void
 CacheManager::resetOnDemand() {
 	onDemandPointer = cache_size;
@@ -313,7 +464,8 @@ CacheManager::cacheSegmentInGPU(Segment* seg) {
 	segment_bitmap[seg->column->column_id][seg->segment_id] = 0x01;
 	assert(segment_list[seg->column->column_id][seg->segment_id] == -1);
 	segment_list[seg->column->column_id][seg->segment_id] = idx;
-	CubDebugExit(cudaMemcpy(&gpuCache[idx * SEGMENT_SIZE], seg->seg_ptr, SEGMENT_SIZE * sizeof(int), cudaMemcpyHostToDevice));
+	rankCached(seg, true);
+	CubDebugExit(deviceMemcpy(&gpuCache[idx * SEGMENT_SIZE], seg->seg_ptr, SEGMENT_SIZE * sizeof(int), cudaMemcpyHostToDevice));
 	allColumn[seg->column->column_id]->tot_seg_in_GPU++;
 	assert(allColumn[seg->column->column_id]->tot_seg_in_GPU <= allColumn[seg->column->column_id]->total_segment);
 }
@@ -355,6 +507,7 @@ CacheManager::deleteSegmentInGPU(Segment* seg) {
 	segment_bitmap[seg->column->column_id][seg->segment_id] = 0x00;
 	assert(segment_list[seg->column->column_id][seg->segment_id] != -1);
 	segment_list[seg->column->column_id][seg->segment_id] = -1;
+	rankCached(seg, false);
 	empty_gpu_segment.push(idx);
 	seg->column->tot_seg_in_GPU--;
 	assert(seg->column->tot_seg_in_GPU >= 0);
@@ -369,11 +522,13 @@ CacheManager::deleteListSegmentInGPU(vector<Segment*> v_seg) {
 
 void
 CacheManager::updateColumnFrequency(ColumnInfo* column) {
+	lock_guard<mutex> guard(stats_lock);
 	column->stats->col_freq+=(1.0 / column->total_segment);
 }
 
 void
 CacheManager::updateColumnWeightDirect(ColumnInfo* column, double speedup) {
+	lock_guard<mutex> guard(stats_lock);
 	if (column->table_id == 0) {
 		column->stats->speedup += speedup/column->total_segment;
 		column->weight += speedup/column->total_segment;		
@@ -386,7 +541,9 @@ CacheManager::updateColumnWeightDirect(ColumnInfo* column, double speedup) {
 
 void
 CacheManager::updateSegmentWeightDirect(ColumnInfo* column, Segment* segment, double speedup) {
+	lock_guard<mutex> guard(stats_lock);
 	if (speedup > 0) {
+		double weight = segment->weight;
 		if (column->table_id == 0) {
 			segment->stats->speedup += speedup/column->total_segment;
 			segment->weight += speedup/column->total_segment;
@@ -394,12 +551,16 @@ CacheManager::updateSegmentWeightDirect(ColumnInfo* column, Segment* segment, do
 			segment->stats->speedup += speedup*3/column->total_segment;
 			segment->weight += speedup*3/column->total_segment;
 		}
+		if (trace != NULL) trace->addWeight(column->column_id, segment->segment_id, segment->weight - weight);
+		rankSegment(segment);
 	}
 }
 
 void
 CacheManager::updateSegmentWeightCostDirect(ColumnInfo* column, Segment* segment, double speedup) {
+	lock_guard<mutex> guard(stats_lock);
 	if (speedup > 0) {
+		double weight = segment->weight;
 		if (column->table_id == 0) {
 			segment->stats->speedup += (speedup/column->total_segment);
 			segment->weight += (speedup/column->total_segment);
@@ -407,22 +568,29 @@ CacheManager::updateSegmentWeightCostDirect(ColumnInfo* column, Segment* segment
 			segment->stats->speedup += (speedup/column->total_segment);
 			segment->weight += (speedup/column->total_segment);
 		}
+		if (trace != NULL) trace->addWeight(column->column_id, segment->segment_id, segment->weight - weight);
+		rankSegment(segment);
 	}
 }
 
 void
 CacheManager::updateSegmentFreqDirect(ColumnInfo* column, Segment* segment) {
+	lock_guard<mutex> guard(stats_lock);
 	segment->stats->col_freq += (1.0 / column->total_segment);
+	rankSegment(segment);
 }
 
 void
 CacheManager::updateSegmentTimeDirect(ColumnInfo* column, Segment* segment, double timestamp) {
+	lock_guard<mutex> guard(stats_lock);
 	segment->stats->backward_t = timestamp - (segment->stats->timestamp * column->total_segment);
 	segment->stats->timestamp = (timestamp/ column->total_segment);
+	rankSegment(segment);
 }
 
 void
 CacheManager::updateColumnTimestamp(ColumnInfo* column, double timestamp) {
+	lock_guard<mutex> guard(stats_lock);
 	column->stats->backward_t = timestamp - (column->stats->timestamp * column->total_segment);
 	column->stats->timestamp = (timestamp/ column->total_segment);
 }
@@ -497,14 +665,20 @@ CacheManager::weightAdjustment() {
 float
 CacheManager::runReplacement(ReplacementPolicy strategy, unsigned long long* traffic) {
 
-  cudaEvent_t start, stop; cudaEventCreate(&start); cudaEventCreate(&stop);
+  deviceEvent_t start, stop; deviceEventCreate(&start); deviceEventCreate(&stop);
   float time;
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   unsigned long long traf = 0;
 
   if (traffic != NULL) traf = (*traffic);
 
+	//admissions the last replacement has not copied yet are dropped, the new placement decides again
+	finishAdmission(true);
+
+	replacement_evicted = 0;
+	replacement_admitted = 0;
+
 	if (strategy == LFU) { //LEAST FREQUENTLY USED
 		traf += LFUReplacement();
 	} else if (strategy == LRU) { //LEAST RECENTLY USED
@@ -523,67 +697,177 @@ CacheManager::runReplacement(ReplacementPolicy strategy, unsigned long long* tra
 
   if (traffic != NULL) (*traffic) = traf;
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
 
   return time;
 };
 
 unsigned long long
 CacheManager::SegmentReplacement() {
-	multimap<double, Segment*> access_weight_map;
-	unsigned long long traffic = 0;
+	return segmentedReplacement(Segmented);
+}
 
-	for (int i = TOT_COLUMN-1; i >= 0; i--) {
-		for (int j = 0; j < allColumn[i]->total_segment; j++) {
-			Segment* segment = index_to_segment[i][j];
-			access_weight_map.insert({segment->weight, segment});
-			cout << allColumn[i]->column_name << " " << j << " " << segment->weight << endl;
+//key of a segment in the ranking of a segmented policy, higher is placed first. the policies only place
+//segments whose statistic is positive, LRU2Segmented prefers the shortest backward distance
+double
+CacheManager::segmentRankKey(ReplacementPolicy strategy, Segment* segment) {
+	if (strategy == Segmented) {
+		return (segment->weight > 0) ? segment->weight : RANK_NONE;
+	} else if (strategy == LRUSegmented) {
+		return (segment->stats->timestamp > 0) ? segment->stats->timestamp : RANK_NONE;
+	} else if (strategy == LFUSegmented) {
+		return (segment->stats->col_freq > 0) ? segment->stats->col_freq : RANK_NONE;
+	} else if (strategy == LRU2Segmented) {
+		return (segment->stats->backward_t > 0) ? -segment->stats->backward_t : RANK_NONE;
+	}
+	assert(0);
+	return RANK_NONE;
+}
+
+void
+CacheManager::rankSegment(Segment* segment) {
+	for (int i = 0; i <= LRU2Segmented; i++) {
+		if (segment_ranking[i] == NULL) continue;
+		int idx = segment_ranking[i]->index(segment->column->column_id, segment->segment_id);
+		segment_ranking[i]->update(idx, segmentRankKey((ReplacementPolicy) i, segment));
+	}
+}
+
+void
+CacheManager::rankCached(Segment* seg, bool in_gpu) {
+	for (int i = 0; i <= LRU2Segmented; i++)
+		if (segment_ranking[i] != NULL) segment_ranking[i]->setCached(segment_ranking[i]->index(seg->column->column_id, seg->segment_id), in_gpu);
+}
+
+//reserves a cache slot for every admitted segment and copies them in the background. the queries keep
+//the old placement until a copy has completed, see publishAdmission. evictions are not deferred, the
+//caller runs replacement between queries so no query reads an evicted slot
+void
+CacheManager::admitAsync(vector<Segment*>& admit) {
+	finishAdmission(true);
+	if (admit.empty()) return;
+
+	for (int i = 0; i < admit.size(); i++) {
+		Segment* seg = admit[i];
+		int idx = empty_gpu_segment.front();
+		empty_gpu_segment.pop();
+		assert(cache_mapper.find(seg) == cache_mapper.end());
+		cache_mapper[seg] = idx;
+		rankCached(seg, true);
+		admission.push_back({seg, idx});
+	}
+
+	admission_published = 0;
+	admission_cancel = false;
+	admission_thread = thread(&CacheManager::admissionTask, this);
+}
+
+//segment k goes through staging buffer k % ADMISSION_BUFFERS, so the copy of one segment into pinned memory
+//overlaps the transfer of the previous one. throttled to admission_bandwidth
+void
+CacheManager::admissionTask() {
+	chrono::high_resolution_clock::time_point st = chrono::high_resolution_clock::now();
+	double bytes = 0;
+	int in_flight[ADMISSION_BUFFERS];
+	for (int b = 0; b < ADMISSION_BUFFERS; b++) in_flight[b] = -1;
+
+	for (int k = 0; k < admission.size() && !admission_cancel; k++) {
+		int b = k % ADMISSION_BUFFERS;
+		if (in_flight[b] >= 0) {
+			CubDebugExit(deviceStreamSynchronize(admission_stream[b]));
+			publishAdmission(in_flight[b]);
+		}
+
+		Segment* seg = admission[k].first;
+		int idx = admission[k].second;
+		memcpy(admission_buffer[b], seg->seg_ptr, SEGMENT_SIZE * sizeof(int));
+		CubDebugExit(deviceMemcpyAsync(&gpuCache[idx * SEGMENT_SIZE], admission_buffer[b], SEGMENT_SIZE * sizeof(int), cudaMemcpyHostToDevice, admission_stream[b]));
+		in_flight[b] = k;
+
+		bytes += SEGMENT_SIZE * sizeof(int);
+		if (admission_bandwidth > 0) {
+			chrono::duration<double, milli> elapsed = chrono::high_resolution_clock::now() - st;
+			double ahead = bytes / admission_bandwidth - elapsed.count();
+			if (ahead > 0) this_thread::sleep_for(chrono::microseconds((long long) (ahead * 1000)));
 		}
 	}
 
-	int temp_buffer_size = 0; // in segment
-	set<Segment*> segments_to_place;
-	multimap<double, Segment*>::reverse_iterator cit;
+	//the remaining copies complete in the order they were issued
+	int last = admission_published + ADMISSION_BUFFERS;
+	for (int k = admission_published; k < last; k++) {
+		int b = k % ADMISSION_BUFFERS;
+		if (in_flight[b] != k) continue;
+		CubDebugExit(deviceStreamSynchronize(admission_stream[b]));
+		publishAdmission(k);
+	}
+}
 
-    for(cit = access_weight_map.rbegin();cit != access_weight_map.rend(); ++cit){
-        if(temp_buffer_size + 1 < cache_total_seg && cit->first > 0){
-            temp_buffer_size+=1;
-            segments_to_place.insert(cit->second);
-            cout << "Should place ";
-            cout << cit->second->column->column_name << " segment " << cit->second->segment_id << endl;
-        }
-    }
+//segment_list before segment_bitmap: a query that sees the segment in the bitmap also finds its slot
+void
+CacheManager::publishAdmission(int k) {
+	Segment* seg = admission[k].first;
+	int idx = admission[k].second;
+	int column_id = seg->column->column_id;
+	assert(segment_list[column_id][seg->segment_id] == -1);
+	segment_list[column_id][seg->segment_id] = idx;
+	__atomic_store_n(&segment_bitmap[column_id][seg->segment_id], 0x01, __ATOMIC_RELEASE);
+	__atomic_fetch_add(&allColumn[column_id]->tot_seg_in_GPU, 1, __ATOMIC_RELAXED);
+	admission_published = k + 1;
+}
 
-    cout << "Cached segment: " << temp_buffer_size << " Cache total: " << cache_total_seg << endl;
-    assert(temp_buffer_size <= cache_total_seg);
+//waits for the background admission, with cancel the segments not copied yet give their slot back
+void
+CacheManager::finishAdmission(bool cancel) {
+	if (!admission_thread.joinable()) return;
+	if (cancel) admission_cancel = true;
+	admission_thread.join();
+
+	for (int k = admission_published; k < admission.size(); k++) {
+		Segment* seg = admission[k].first;
+		cache_mapper.erase(seg);
+		empty_gpu_segment.push(admission[k].second);
+		rankCached(seg, false);
+	}
+	admission.clear();
+	admission_published = 0;
+	admission_cancel = false;
+}
 
-    for (int i = 0; i < TOT_COLUMN; i++) {
-    	for (int j = 0; j < allColumn[i]->total_segment; j++) {
-    		Segment* segment = index_to_segment[i][j];
-				if (segments_to_place.find(segment) == segments_to_place.end()) {
-					if (segment_bitmap[i][j]) {
-						cout << "Deleting segment ";
-						cout << segment->column->column_name << " segment " << segment->segment_id << endl;
-						deleteSegmentInGPU(segment);
-					}
-				}
-			}
-    }
+void
+CacheManager::dropSegmentRanking() {
+	for (int i = 0; i <= LRU2Segmented; i++) {
+		if (segment_ranking[i] != NULL) delete segment_ranking[i];
+		segment_ranking[i] = NULL;
+	}
+}
 
-    set<Segment*>::const_iterator cit2;
-    for(cit2 = segments_to_place.cbegin();cit2 != segments_to_place.cend(); ++cit2){
-    	if (segment_bitmap[(*cit2)->column->column_id][(*cit2)->segment_id] == 0) {
-				cout << "Caching segment ";
-				cout << (*cit2)->column->column_name << " " << (*cit2)->segment_id << endl;
-				cacheSegmentInGPU(*cit2);
-				traffic += SEGMENT_SIZE * sizeof(int);
-    	}
-    }
-    cout << "Successfully cached" << endl;
+//places the cache_total_seg - 1 segments with the highest key of the policy. the ranking is built on the
+//first call and kept up to date by the update*Direct functions afterwards, so a call only moves the
+//segments whose rank crossed the cache boundary since the last one
+unsigned long long
+CacheManager::segmentedReplacement(ReplacementPolicy strategy) {
+	SegmentRanking<Segment>*& ranking = segment_ranking[strategy];
+
+	if (ranking == NULL) {
+		ranking = new SegmentRanking<Segment>();
+		ranking->build(index_to_segment,
+			[&](Segment* seg) { return segmentRankKey(strategy, seg); },
+			[&](Segment* seg) { return segment_bitmap[seg->column->column_id][seg->segment_id] == 0x01; });
+	}
 
-    return traffic;
+	vector<Segment*> evict, admit;
+	ranking->replace(cache_total_seg - 1, evict, admit);
+
+	for (int i = 0; i < evict.size(); i++) deleteSegmentInGPU(evict[i]);
+	if (async_admission) admitAsync(admit);
+	else for (int i = 0; i < admit.size(); i++) cacheSegmentInGPU(admit[i]);
+
+	replacement_evicted += evict.size();
+	replacement_admitted += admit.size();
+
+	return (unsigned long long) admit.size() * SEGMENT_SIZE * sizeof(int);
 }
 
 unsigned long long
@@ -627,49 +911,7 @@ CacheManager::LRUReplacement() {
 
 unsigned long long
 CacheManager::LRUSegmentedReplacement() {
-	multimap<double, Segment*> access_timestamp_map;
-	unsigned long long traffic = 0;
-
-	for (int i = TOT_COLUMN-1; i >= 0; i--) {
-		for (int j = 0; j < allColumn[i]->total_segment; j++) {
-			Segment* segment = index_to_segment[i][j];
-			access_timestamp_map.insert({segment->stats->timestamp, segment});
-		}
-	}
-
-	int temp_buffer_size = 0; // in segment
-	set<Segment*> segments_to_place;
-	multimap<double, Segment*>::reverse_iterator cit;
-
-    for(cit = access_timestamp_map.rbegin();cit != access_timestamp_map.rend(); ++cit){
-        if(temp_buffer_size + 1 < cache_total_seg && cit->first > 0){
-            temp_buffer_size+=1;
-            segments_to_place.insert(cit->second);
-        }
-    }
-
-    assert(temp_buffer_size <= cache_total_seg);
-
-    for (int i = 0; i < TOT_COLUMN; i++) {
-    	for (int j = 0; j < allColumn[i]->total_segment; j++) {
-    		Segment* segment = index_to_segment[i][j];
-				if (segments_to_place.find(segment) == segments_to_place.end()) {
-					if (segment_bitmap[i][j]) {
-						deleteSegmentInGPU(segment);
-					}
-				}
-			}
-    }
-
-    set<Segment*>::const_iterator cit2;
-    for(cit2 = segments_to_place.cbegin();cit2 != segments_to_place.cend(); ++cit2){
-    	if (segment_bitmap[(*cit2)->column->column_id][(*cit2)->segment_id] == 0) {
-				cacheSegmentInGPU(*cit2);
-				traffic += SEGMENT_SIZE * sizeof(int);
-    	}
-    }
-
-    return traffic;
+	return segmentedReplacement(LRUSegmented);
 }
 
 unsigned long long
@@ -713,96 +955,12 @@ CacheManager::LRU_2Replacement() {
 
 unsigned long long
 CacheManager::LRU_2SegmentedReplacement() {
-	multimap<double, Segment*> access_backward_map;
-	unsigned long long traffic = 0;
-
-	for (int i = TOT_COLUMN-1; i >= 0; i--) {
-		for (int j = 0; j < allColumn[i]->total_segment; j++) {
-			Segment* segment = index_to_segment[i][j];
-			access_backward_map.insert({segment->stats->backward_t, segment});
-		}
-	}
-
-	int temp_buffer_size = 0; // in segment
-	set<Segment*> segments_to_place;
-	multimap<double, Segment*>::iterator cit;
-
-    for(cit = access_backward_map.begin();cit != access_backward_map.end(); ++cit){
-        if(temp_buffer_size + 1 < cache_total_seg && cit->first > 0){
-            temp_buffer_size+=1;
-            segments_to_place.insert(cit->second);
-        }
-    }
-
-    assert(temp_buffer_size <= cache_total_seg);
-
-    for (int i = 0; i < TOT_COLUMN; i++) {
-    	for (int j = 0; j < allColumn[i]->total_segment; j++) {
-    		Segment* segment = index_to_segment[i][j];
-				if (segments_to_place.find(segment) == segments_to_place.end()) {
-					if (segment_bitmap[i][j]) {
-						deleteSegmentInGPU(segment);
-					}
-				}
-			}
-    }
-
-    set<Segment*>::const_iterator cit2;
-    for(cit2 = segments_to_place.cbegin();cit2 != segments_to_place.cend(); ++cit2){
-    	if (segment_bitmap[(*cit2)->column->column_id][(*cit2)->segment_id] == 0) {
-				cacheSegmentInGPU(*cit2);
-				traffic += SEGMENT_SIZE * sizeof(int);
-    	}
-    }
-
-    return traffic;
+	return segmentedReplacement(LRU2Segmented);
 }
 
 unsigned long long
 CacheManager::LFUSegmentedReplacement() {
-	multimap<double, Segment*> access_frequency_map;
-	unsigned long long traffic = 0;
-
-	for (int i = TOT_COLUMN-1; i >= 0; i--) {
-		for (int j = 0; j < allColumn[i]->total_segment; j++) {
-			Segment* segment = index_to_segment[i][j];
-			access_frequency_map.insert({segment->stats->col_freq, segment});
-		}
-	}
-
-	int temp_buffer_size = 0; // in segment
-	set<Segment*> segments_to_place;
-	multimap<double, Segment*>::reverse_iterator cit;
-
-    for(cit = access_frequency_map.rbegin();cit != access_frequency_map.rend(); ++cit){
-        if(temp_buffer_size + 1 < cache_total_seg && cit->first > 0){
-            temp_buffer_size+=1;
-            segments_to_place.insert(cit->second);
-        }
-    }
-
-    assert(temp_buffer_size <= cache_total_seg);
-
-    for (int i = 0; i < TOT_COLUMN; i++) {
-    	for (int j = 0; j < allColumn[i]->total_segment; j++) {
-    		Segment* segment = index_to_segment[i][j];
-				if (segments_to_place.find(segment) == segments_to_place.end()) {
-					if (segment_bitmap[i][j]) {
-						deleteSegmentInGPU(segment);
-					}
-				}
-			}
-    }
-
-    set<Segment*>::const_iterator cit2;
-    for(cit2 = segments_to_place.cbegin();cit2 != segments_to_place.cend(); ++cit2){
-    	if (segment_bitmap[(*cit2)->column->column_id][(*cit2)->segment_id] == 0) {
-				cacheSegmentInGPU(*cit2);
-				traffic += SEGMENT_SIZE * sizeof(int);
-    	}
-    }
-
-    return traffic;
+	return segmentedReplacement(LFUSegmented);
 }
 
 unsigned long long
@@ -1144,10 +1302,24 @@ CacheManager::newEpoch(double param) {
 		}
 	}
 
+	//every weight, frequency and backward distance got the same factor, the rankings only scale their keys.
+	//timestamps are not decayed, so the LRUSegmented ranking stays as it is
+	ReplacementPolicy decayed[3] = {Segmented, LFUSegmented, LRU2Segmented};
+	for (int i = 0; i < 3; i++) {
+		SegmentRanking<Segment>*& ranking = segment_ranking[decayed[i]];
+		if (ranking == NULL) continue;
+		ranking->rescale(param);
+		if (!(ranking->scale > 1e-100 && ranking->scale < 1e100)) {
+			delete ranking;
+			ranking = NULL;
+		}
+	}
+
 };
 
 int
 CacheManager::cacheSpecificColumn(string column_name) {
+	finishAdmission(false);
 	ColumnInfo* column;
 	bool found = false;
 	for (int i = 0; i < TOT_COLUMN; i++) {
@@ -1167,6 +1339,7 @@ CacheManager::cacheSpecificColumn(string column_name) {
 
 void
 CacheManager::deleteColumnsFromGPU() {
+	finishAdmission(false);
 	for (int i = 0; i < TOT_COLUMN; i++) {
 		if (allColumn[i]->tot_seg_in_GPU == allColumn[i]->total_segment) {
 			deleteColumnSegmentInGPU(allColumn[i], allColumn[i]->tot_seg_in_GPU);
@@ -1176,6 +1349,7 @@ CacheManager::deleteColumnsFromGPU() {
 
 int
 CacheManager::deleteSpecificColumnFromGPU(string column_name) {
+	finishAdmission(false);
 	ColumnInfo* column;
 	bool found = false;
 	for (int i = 0; i < TOT_COLUMN; i++) {
@@ -1195,6 +1369,7 @@ CacheManager::deleteSpecificColumnFromGPU(string column_name) {
 
 void
 CacheManager::deleteAll() {
+	finishAdmission(false);
 	for (int i = 0; i < TOT_COLUMN; i++) {
 		ColumnInfo* column = allColumn[i];
 		for (int j = 0; j < column->total_segment; j++) {
@@ -1210,6 +1385,8 @@ CacheManager::deleteAll() {
 void
 CacheManager::loadColumnToCPU() {
 
+	//with columnMap().mmap the columns are only mapped here, their pages are read in when first touched
+
 	h_lo_orderkey = loadColumnPinnedSort<int>("lo_orderkey", LO_LEN);
 	h_lo_suppkey = loadColumnPinnedSort<int>("lo_suppkey", LO_LEN);
 	h_lo_custkey = loadColumnPinnedSort<int>("lo_custkey", LO_LEN);
@@ -1307,40 +1484,56 @@ CacheManager::loadColumnToCPU() {
 }
 
 CacheManager::~CacheManager() {
-	CubDebugExit(cudaFree(gpuCache));
-	CubDebugExit(cudaFree(gpuProcessing));
-	delete[] cpuProcessing;
-	CubDebugExit(cudaFreeHost(pinnedMemory));
-
-	CubDebugExit(cudaFreeHost(h_lo_orderkey));
-	CubDebugExit(cudaFreeHost(h_lo_suppkey));
-	CubDebugExit(cudaFreeHost(h_lo_custkey));
-	CubDebugExit(cudaFreeHost(h_lo_partkey));
-	CubDebugExit(cudaFreeHost(h_lo_orderdate));
-	CubDebugExit(cudaFreeHost(h_lo_revenue));
-	CubDebugExit(cudaFreeHost(h_lo_discount)); 
-	CubDebugExit(cudaFreeHost(h_lo_quantity));
-	CubDebugExit(cudaFreeHost(h_lo_extendedprice));
-	CubDebugExit(cudaFreeHost(h_lo_supplycost));
-
-	CubDebugExit(cudaFreeHost(h_c_custkey));
-	CubDebugExit(cudaFreeHost(h_c_nation));
-	CubDebugExit(cudaFreeHost(h_c_region));
-	CubDebugExit(cudaFreeHost(h_c_city));
-
-	CubDebugExit(cudaFreeHost(h_s_suppkey));
-	CubDebugExit(cudaFreeHost(h_s_nation));
-	CubDebugExit(cudaFreeHost(h_s_region));
-	CubDebugExit(cudaFreeHost(h_s_city));
-
-	CubDebugExit(cudaFreeHost(h_p_partkey));
-	CubDebugExit(cudaFreeHost(h_p_brand1));
-	CubDebugExit(cudaFreeHost(h_p_category));
-	CubDebugExit(cudaFreeHost(h_p_mfgr));
-
-	CubDebugExit(cudaFreeHost(h_d_datekey));
-	CubDebugExit(cudaFreeHost(h_d_year));
-	CubDebugExit(cudaFreeHost(h_d_yearmonthnum));
+	finishAdmission(true);
+	for (int i = 0; i < ADMISSION_BUFFERS; i++) CubDebugExit(deviceStreamDestroy(admission_stream[i]));
+	delete ht_cache;
+	delete result_cache;
+	delete join_summary;
+	delete query_scope;
+	delete cpu_arena;
+	delete gpu_arena;
+	delete pinned_arena;
+
+	CubDebugExit(deviceFree(gpuCache));
+	CubDebugExit(deviceFree(gpuProcessing));
+	numaFree(cpuProcessing, processing_size * sizeof(uint64_t));
+	CubDebugExit(deviceFreeHost(pinnedMemory));
+
+	releaseColumn(h_lo_orderkey, true);
+	releaseColumn(h_lo_suppkey, true);
+	releaseColumn(h_lo_custkey, true);
+	releaseColumn(h_lo_partkey, true);
+	releaseColumn(h_lo_orderdate, true);
+	releaseColumn(h_lo_revenue, true);
+	releaseColumn(h_lo_discount, true); 
+	releaseColumn(h_lo_quantity, true);
+	releaseColumn(h_lo_extendedprice, true);
+	releaseColumn(h_lo_supplycost, true);
+
+	releaseColumn(h_c_custkey, true);
+	releaseColumn(h_c_nation, true);
+	releaseColumn(h_c_region, true);
+	releaseColumn(h_c_city, true);
+
+	releaseColumn(h_s_suppkey, true);
+	releaseColumn(h_s_nation, true);
+	releaseColumn(h_s_region, true);
+	releaseColumn(h_s_city, true);
+
+	releaseColumn(h_p_partkey, true);
+	releaseColumn(h_p_brand1, true);
+	releaseColumn(h_p_category, true);
+	releaseColumn(h_p_mfgr, true);
+
+	releaseColumn(h_d_datekey, true);
+	releaseColumn(h_d_year, true);
+	releaseColumn(h_d_yearmonthnum, true);
+
+	for (int i = 0; i < TOT_COLUMN; i++) {
+		freePackedColumn(allColumn[i]->pack);
+		freeSlicedColumn(allColumn[i]->slice);
+	}
+	for (int i = 0; i < segment_aggr.size(); i++) freeSegmentAggregates(segment_aggr[i]);
 
 	delete lo_orderkey;
 	delete lo_orderdate;
@@ -1373,29 +1566,33 @@ CacheManager::~CacheManager() {
 	delete d_yearmonthnum;
 
 	for (int i = 0; i < TOT_COLUMN; i++) {
-		CubDebugExit(cudaFreeHost(segment_list[i]));
+		CubDebugExit(deviceFreeHost(segment_list[i]));
 		//free(segment_list[i]);
 		free(segment_bitmap[i]);
+		if (segment_stats[i] != NULL) free(segment_stats[i]);
 	}
 	free(segment_list);
 	free(segment_bitmap);
+	free(segment_stats);
+
+	dropSegmentRanking();
 }
 
 
 template int*
-CacheManager::customMalloc<int>(int size);
+CacheManager::customMalloc<int>(int size, ProcessingScope* scope);
 
 template int*
-CacheManager::customCudaMalloc<int>(int size);
+CacheManager::customCudaMalloc<int>(int size, ProcessingScope* scope);
 
 template int*
-CacheManager::customCudaHostAlloc<int>(int size);
+CacheManager::customCudaHostAlloc<int>(int size, ProcessingScope* scope);
 
 template short*
-CacheManager::customMalloc<short>(int size);
+CacheManager::customMalloc<short>(int size, ProcessingScope* scope);
 
 template short*
-CacheManager::customCudaMalloc<short>(int size);
+CacheManager::customCudaMalloc<short>(int size, ProcessingScope* scope);
 
 template short*
-CacheManager::customCudaHostAlloc<short>(int size);
\ No newline at end of file
+CacheManager::customCudaHostAlloc<short>(int size, ProcessingScope* scope);
\ No newline at end of file
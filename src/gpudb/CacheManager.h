@@ -2,15 +2,31 @@
 #define _CACHE_MANAGER_H_
 
 #include "common.h"
+#include "SegmentStats.h"
+#include "SegmentPack.h"
+#include "SegmentSlice.h"
+#include "SegmentAggr.h"
+#include "SegmentRanking.h"
+#include "QueryTrace.h"
+#include "ProcessingArena.h"
+#include <new>
+#include <thread>
 
 #define CUB_STDERR
 
+#define ADMISSION_BUFFERS 2 //segments staged in pinned memory by the background admission
+#define ADMISSION_STAGING (ADMISSION_BUFFERS * SEGMENT_SIZE * sizeof(int) / sizeof(uint64_t)) //in uint64_t, behind pinned_memsize
+
 class Statistics;
 class CacheManager;
 class Segment;
 class ColumnInfo;
 class priority_stack;
 class custom_priority_queue;
+class ProcessingScope;
+class HashTableCache;
+class ResultCache;
+class JoinSummaryCache;
 
 enum ReplacementPolicy {
     LRU, LFU, LFUSegmented, LRUSegmented, Segmented, LRU2, LRU2Segmented
@@ -61,54 +77,101 @@ public:
 	int tot_seg_in_GPU; //total segments in GPU (based on current weight)
 	double weight;
 	int total_segment;
+	packedColumn* pack; //bit packed copy the cpu filters scan, NULL when the loader did not pack the column
+	slicedColumn* slice; //bit sliced copy of a low cardinality column for the cpu filters, NULL when there is none
 
 	Segment* getSegment(int index);
 };
 
+//binary heap on the segment priority, the top is the segment with the lowest priority and among equal
+//priorities the one pushed last, so segments of the same priority come back in stack order
 class priority_stack {
 public:
 	vector<Segment*> stack;
+	vector<unsigned long long> seq;
+	unsigned long long next_seq = 0;
     bool empty() { return stack.size()==0; } 
-    void push(Segment* x) { //const so that it can't be modified, passed by reference so that large object not get copied 
+    bool above(int a, int b) {
+        if (stack[a]->priority != stack[b]->priority) return stack[a]->priority < stack[b]->priority;
+        return seq[a] > seq[b];
+    }
+    void exchange(int a, int b) {
+        swap(stack[a], stack[b]);
+        swap(seq[a], seq[b]);
+    }
+    void push(Segment* x) {
         stack.push_back(x);
-        percolateDown();
+        seq.push_back(next_seq++);
+        percolateUp(stack.size()-1);
     } 
     void pop() {
-        if (!empty())
-            stack.resize(stack.size()-1);
+        if (empty()) return;
+        exchange(0, stack.size()-1);
+        stack.pop_back();
+        seq.pop_back();
+        percolateDown(0);
     }
     Segment* top() { 
         if (!empty()) 
-        	return stack[stack.size()-1]; 
+        	return stack[0]; 
         else
         	return NULL;
     }
-    void percolateDown() {
-        for (int i=stack.size()-1; i>0; i--)
-            if (stack[i]->priority > stack[i-1]->priority)
-                swap(stack[i-1], stack[i]);
+    void percolateUp(int i) {
+        while (i > 0 && above(i, (i-1)/2)) {
+            exchange(i, (i-1)/2);
+            i = (i-1)/2;
+        }
     }
-    void percolateUp() {
-    	for (int i=0; i<stack.size()-1; i++)
-    		if (stack[i]->priority < stack[i+1]->priority)
-    			swap(stack[i], stack[i+1]);
+    void percolateDown(int i) {
+        int n = stack.size();
+        while (2*i+1 < n) {
+            int child = 2*i+1;
+            if (child+1 < n && above(child+1, child)) child++;
+            if (!above(child, i)) break;
+            exchange(i, child);
+            i = child;
+        }
     }
+    //segments from the highest priority down to the top
     vector<Segment*> return_stack() {
-    	return stack;
+        priority_stack copy = *this;
+        vector<Segment*> ret(stack.size());
+        for (int i = ret.size()-1; i >= 0; i--) {
+            ret[i] = copy.top();
+            copy.pop();
+        }
+        return ret;
     }
 };
 
+//binary heap on the segment priority, the front is the segment with the highest priority and among equal
+//priorities the one pushed first
 class custom_priority_queue {
 public:
 	vector<Segment*> queue;
+	vector<unsigned long long> seq;
+	unsigned long long next_seq = 0;
     bool empty() { return queue.size()==0; } 
+    bool above(int a, int b) {
+        if (queue[a]->priority != queue[b]->priority) return queue[a]->priority > queue[b]->priority;
+        return seq[a] < seq[b];
+    }
+    void exchange(int a, int b) {
+        swap(queue[a], queue[b]);
+        swap(seq[a], seq[b]);
+    }
     void push(Segment* x) {
         queue.push_back(x);
-        percolateDown();
+        seq.push_back(next_seq++);
+        percolateUp(queue.size()-1);
     } 
     void pop() {
-        if (!empty())
-            queue.erase(queue.begin());
+        if (empty()) return;
+        exchange(0, queue.size()-1);
+        queue.pop_back();
+        seq.pop_back();
+        percolateDown(0);
     }
     Segment* front() { 
         if (!empty()) 
@@ -116,18 +179,31 @@ public:
         else
         	return NULL;
     }
-    void percolateDown() {
-        for (int i=queue.size()-1; i>0; i--)
-            if (queue[i]->priority > queue[i-1]->priority)
-                swap(queue[i-1], queue[i]);
+    void percolateUp(int i) {
+        while (i > 0 && above(i, (i-1)/2)) {
+            exchange(i, (i-1)/2);
+            i = (i-1)/2;
+        }
     }
-    void percolateUp() {
-    	for (int i=0; i<queue.size()-1; i++)
-    		if (queue[i]->priority < queue[i+1]->priority)
-    			swap(queue[i], queue[i+1]);
+    void percolateDown(int i) {
+        int n = queue.size();
+        while (2*i+1 < n) {
+            int child = 2*i+1;
+            if (child+1 < n && above(child+1, child)) child++;
+            if (!above(child, i)) break;
+            exchange(i, child);
+            i = child;
+        }
     }
+    //segments in the order front() returns them
     vector<Segment*> return_queue() {
-    	return queue;
+        custom_priority_queue copy = *this;
+        vector<Segment*> ret;
+        while (!copy.empty()) {
+            ret.push_back(copy.front());
+            copy.pop();
+        }
+        return ret;
     }
 };
 
@@ -135,7 +211,10 @@ class CacheManager {
 public:
 	int* gpuCache;
 	uint64_t* gpuProcessing, *cpuProcessing, *pinnedMemory;
-	unsigned int gpuPointer, cpuPointer, pinnedPointer, onDemandPointer;
+	unsigned int onDemandPointer; //bump pointer of the on-demand area behind the cache, one per cache manager
+	atomic<int> sessions; //query contexts sharing this cache manager, see CPUGPUProcessing(shared)
+	ProcessingArena* cpu_arena, *gpu_arena, *pinned_arena; //over cpuProcessing, gpuProcessing and pinnedMemory
+	ProcessingScope* query_scope; //allocations of the running query, released by resetPointer
 	int cache_total_seg, ondemand_segment;
 	size_t cache_size, processing_size, pinned_memsize, ondemand_size;
 	int TOT_COLUMN;
@@ -155,6 +234,27 @@ public:
 	vector<vector<int>> columns_in_table;
 	int** segment_min;
 	int** segment_max;
+	segmentStats** segment_stats; //NULL for a column without a stats file
+	vector<segmentAggregates*> segment_aggr; //lineorder segment aggregates the loader wrote, see SegmentAggr.h
+
+	SegmentRanking<Segment>* segment_ranking[LRU2Segmented + 1]; //per segmented policy, NULL until the policy first runs
+	int replacement_evicted, replacement_admitted; //segments moved by the last runReplacement
+
+	QueryTrace* trace; //segment accesses and weight updates are recorded here when set, see cachesim
+
+	mutex stats_lock; //statistics updates of concurrent queries
+	HashTableCache* ht_cache; //dimension hash tables shared by the queries, NULL when off
+	ResultCache* result_cache; //per segment partial aggregates shared by the queries, NULL when off
+	JoinSummaryCache* join_summary; //qualifying dimension keys of the join skipping, shared by the queries
+
+	bool async_admission; //segmented replacement copies admitted segments in the background, see admitAsync
+	double admission_bandwidth; //bytes per ms the background admission may use, 0 for no limit
+	int* admission_buffer[ADMISSION_BUFFERS];
+	cudaStream_t admission_stream[ADMISSION_BUFFERS];
+	vector<pair<Segment*, int>> admission; //segments of the running admission and their reserved slot
+	atomic<int> admission_published; //admission[0, published) are visible to the queries
+	atomic<bool> admission_cancel;
+	thread admission_thread;
 
 	int *h_lo_orderkey, *h_lo_orderdate, *h_lo_custkey, *h_lo_suppkey, *h_lo_partkey, *h_lo_revenue, *h_lo_discount, *h_lo_quantity, *h_lo_extendedprice, *h_lo_supplycost;
 	int *h_c_custkey, *h_c_nation, *h_c_region, *h_c_city;
@@ -240,34 +340,69 @@ public:
 
 	unsigned long long SegmentReplacement();
 
+	double segmentRankKey(ReplacementPolicy strategy, Segment* segment);
+
+	void rankSegment(Segment* segment);
+
+	void dropSegmentRanking();
+
+	unsigned long long segmentedReplacement(ReplacementPolicy strategy);
+
+	void rankCached(Segment* seg, bool in_gpu);
+
+	void admitAsync(vector<Segment*>& admit);
+
+	void admissionTask();
+
+	void publishAdmission(int k);
+
+	void finishAdmission(bool cancel);
+
 	void loadColumnToCPU();
 
 	void newEpoch(double param = 0.75);
 
+	//scope NULL allocates for the running query (query_scope)
 	template <typename T>
-	T* customMalloc(int size);
+	T* customMalloc(int size, ProcessingScope* scope = NULL);
 
 	template <typename T>
-	T* customCudaMalloc(int size);
+	T* customCudaMalloc(int size, ProcessingScope* scope = NULL);
 
 	template <typename T>
-	T* customCudaHostAlloc(int size);
+	T* customCudaHostAlloc(int size, ProcessingScope* scope = NULL);
 
 	int* onDemandTransfer(int* data_ptr, int size, cudaStream_t stream);
 
-	void indexTransfer(int** col_idx, ColumnInfo* column, cudaStream_t stream, bool custom = true);
+	void indexTransfer(int** col_idx, ColumnInfo* column, cudaStream_t stream, bool custom = true, ProcessingScope* scope = NULL);
+
+	int* mapPoolView(ColumnInfo* column, int* idx);
+
+	void releasePoolView(ColumnInfo* column, int* view);
 
 	void resetPointer();
 
+	void assignArenas();
+
+	void resetArenaStats();
+
 	void resetOnDemand();
 
 	void readSegmentMinMax();
 
+	void readSegmentPacks();
+
+	void readSegmentSlices();
+
+	void readSegmentAggregates();
+
+	ColumnInfo* findColumn(string column_name);
+
 	void copySegmentList();
 
 	void onDemandTransfer2(ColumnInfo* column, int segment_idx, int size, cudaStream_t stream);
 
-	void indexTransferOD(int** od_col_idx, ColumnInfo* column, cudaStream_t stream, bool custom = true);
+	void indexTransferOD(int** od_col_idx, ColumnInfo* column, cudaStream_t stream, bool custom = true, ProcessingScope* scope = NULL);
 
 	int cacheSpecificColumn(string column_name);
 
@@ -278,4 +413,29 @@ public:
 	void deleteAll();
 };
 
+//processing memory of a query or a pipeline in the three regions, freed together by release
+class ProcessingScope {
+public:
+	ArenaContext cpu, gpu, pinned;
+
+	ProcessingScope(CacheManager* cm) : cpu(cm->cpu_arena), gpu(cm->gpu_arena), pinned(cm->pinned_arena) {}
+
+	//the arena slots are alignas(64), which new only honours from C++17 on
+	static void* operator new(size_t size) {
+		void* ptr;
+		if (posix_memalign(&ptr, 64, size) != 0) throw std::bad_alloc();
+		return ptr;
+	}
+
+	static void operator delete(void* ptr) {
+		free(ptr);
+	}
+
+	void release() {
+		cpu.release();
+		gpu.release();
+		pinned.release();
+	}
+};
+
 #endif
\ No newline at end of file
@@ -0,0 +1,234 @@
+#ifndef _CATALOG_H_
+#define _CATALOG_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <map>
+#include <vector>
+
+//what a ssb data directory holds, written by the loader as <data dir>/catalog:
+//  sf <scale factor>
+//  segment <rows per segment the stats were built with>
+//  table <table> <rows>
+//  column <table> <column> <file> <sorted file or -> <stats file or -> [<pack file or -> [<slice file or ->]]
+//  aggregate <table> <file> (per segment aggregates, see SegmentAggr.h)
+//read once at startup, replaces the compile time SF / DATA_DIR / *_LEN settings.
+//MORDRED_DATA_DIR (and MORDRED_SF for a directory without a catalog) pick the directory, otherwise it is
+//s<SF>_columnar/ under MORDRED_DATA_BASE
+
+#define CATALOG_FILE "catalog"
+#define CATALOG_BASE_PATH "/home/ubuntu/Implementation-GPUDB/test/ssb/data/" //without MORDRED_DATA_BASE
+#define CATALOG_DEFAULT_SF 40
+
+#define SEGMENT_SIZE 1048576 //rows per segment of the engine, the tools and the loader
+
+typedef struct catalogColumn {
+  std::string table;
+  std::string file;
+  std::string sorted_file;
+  std::string stats_file;
+  std::string pack_file; //bit packed copy of the (sorted) column, see SegmentPack.h
+  std::string slice_file; //bit sliced copy, see SegmentSlice.h
+} catalogColumn;
+
+typedef struct ssbCatalog {
+  int sf;
+  int segment_size;
+  std::string data_dir;
+  std::map<std::string, int> table_len;
+  std::map<std::string, catalogColumn> column;
+  std::map<std::string, std::string> aggregate; //file to table
+  int lo_len, p_len, s_len, c_len, d_len; //table_len of the ssb tables, read on every query
+} ssbCatalog;
+
+//table lengths of the scale factors generated so far, for directories from the old loader
+inline bool ssbDefaultLengths(int sf, ssbCatalog& cat) {
+  int known[][6] = {
+    {1, 6001171, 200000, 2000, 30000, 2556},
+    {10, 59986214, 800000, 20000, 300000, 2556},
+    {20, 119994746, 1000000, 40000, 600000, 2556},
+    {40, 240012412, 1200000, 80000, 1200000, 2556},
+    {160, 960017453, 1600000, 320000, 4800000, 2556}
+  };
+  for (int i = 0; i < 5; i++) {
+    if (known[i][0] != sf) continue;
+    cat.table_len["lineorder"] = known[i][1];
+    cat.table_len["part"] = known[i][2];
+    cat.table_len["supplier"] = known[i][3];
+    cat.table_len["customer"] = known[i][4];
+    cat.table_len["ddate"] = known[i][5];
+    return true;
+  }
+  return false;
+}
+
+inline void catalogLengths(ssbCatalog& cat) {
+  cat.lo_len = cat.table_len["lineorder"];
+  cat.p_len = cat.table_len["part"];
+  cat.s_len = cat.table_len["supplier"];
+  cat.c_len = cat.table_len["customer"];
+  cat.d_len = cat.table_len["ddate"];
+}
+
+inline bool readCatalog(std::string data_dir, ssbCatalog& cat) {
+  std::ifstream in((data_dir + CATALOG_FILE).c_str());
+  if (!in) return false;
+
+  std::string line;
+  while (getline(in, line)) {
+    std::istringstream fields(line);
+    std::string kind;
+    fields >> kind;
+    if (kind == "sf") fields >> cat.sf;
+    else if (kind == "segment") fields >> cat.segment_size;
+    else if (kind == "table") {
+      std::string name;
+      int len;
+      fields >> name >> len;
+      cat.table_len[name] = len;
+    } else if (kind == "column") {
+      std::string name;
+      catalogColumn col;
+      fields >> col.table >> name >> col.file >> col.sorted_file >> col.stats_file >> col.pack_file >> col.slice_file;
+      if (col.sorted_file == "-") col.sorted_file = "";
+      if (col.stats_file == "-") col.stats_file = "";
+      if (col.pack_file == "-") col.pack_file = "";
+      if (col.slice_file == "-") col.slice_file = "";
+      cat.column[name] = col;
+    } else if (kind == "aggregate") {
+      std::string table, file;
+      fields >> table >> file;
+      cat.aggregate[file] = table;
+    }
+  }
+  return true;
+}
+
+inline bool writeCatalog(const ssbCatalog& cat) {
+  std::ofstream out((cat.data_dir + CATALOG_FILE).c_str());
+  if (!out) return false;
+
+  out << "sf " << cat.sf << '\n';
+  out << "segment " << cat.segment_size << '\n';
+  for (auto it = cat.table_len.begin(); it != cat.table_len.end(); it++)
+    out << "table " << it->first << " " << it->second << '\n';
+  for (auto it = cat.column.begin(); it != cat.column.end(); it++) {
+    const catalogColumn& col = it->second;
+    out << "column " << col.table << " " << it->first << " " << col.file << " "
+      << (col.sorted_file.empty() ? "-" : col.sorted_file) << " "
+      << (col.stats_file.empty() ? "-" : col.stats_file) << " "
+      << (col.pack_file.empty() ? "-" : col.pack_file) << " "
+      << (col.slice_file.empty() ? "-" : col.slice_file) << '\n';
+  }
+  for (auto it = cat.aggregate.begin(); it != cat.aggregate.end(); it++)
+    out << "aggregate " << it->second << " " << it->first << '\n';
+  return out.good();
+}
+
+//scale factor from a s<sf>_columnar directory name, 0 for any other name
+inline int catalogDirSF(std::string data_dir) {
+  size_t end = data_dir.find_last_not_of('/');
+  if (end == std::string::npos) return 0;
+  size_t start = data_dir.rfind('/', end);
+  start = (start == std::string::npos) ? 0 : start + 1;
+  if (data_dir[start] != 's' || start + 1 > end || !isdigit(data_dir[start + 1])) return 0;
+  return atoi(data_dir.c_str() + start + 1);
+}
+
+//without a catalog file the lengths come from sf, or from the directory name
+inline bool loadCatalog(std::string data_dir, int sf, ssbCatalog& cat) {
+  if (!data_dir.empty() && data_dir[data_dir.size() - 1] != '/') data_dir += "/";
+  cat = ssbCatalog();
+  cat.data_dir = data_dir;
+  cat.sf = sf;
+  cat.segment_size = 0;
+
+  bool found = readCatalog(data_dir, cat);
+  if (!found) {
+    if (cat.sf == 0) cat.sf = catalogDirSF(data_dir);
+    found = ssbDefaultLengths(cat.sf, cat);
+  }
+  catalogLengths(cat);
+  return found;
+}
+
+//data directory of a scale factor under MORDRED_DATA_BASE or CATALOG_BASE_PATH
+inline std::string catalogSFDir(int sf) {
+  const char* env_base = getenv("MORDRED_DATA_BASE");
+  std::string base = (env_base != NULL && env_base[0] != 0) ? env_base : CATALOG_BASE_PATH;
+  if (base[base.size() - 1] != '/') base += "/";
+  return base + "s" + std::to_string(sf) + "_columnar/";
+}
+
+inline ssbCatalog defaultCatalog() {
+  const char* env_dir = getenv("MORDRED_DATA_DIR");
+  const char* env_sf = getenv("MORDRED_SF");
+  int sf = (env_sf != NULL) ? atoi(env_sf) : 0;
+
+  std::string data_dir;
+  if (env_dir != NULL) data_dir = env_dir;
+  else {
+    if (sf == 0) sf = CATALOG_DEFAULT_SF;
+    data_dir = catalogSFDir(sf);
+  }
+
+  ssbCatalog cat;
+  if (!loadCatalog(data_dir, sf, cat))
+    fprintf(stderr, "No catalog in %s and unknown scale factor, set MORDRED_SF\n", data_dir.c_str());
+  return cat;
+}
+
+inline ssbCatalog& catalog() {
+  static ssbCatalog cat = defaultCatalog();
+  return cat;
+}
+
+//switch to another data directory, before any column is loaded
+inline void openCatalog(std::string data_dir, int sf) {
+  if (!loadCatalog(data_dir, sf, catalog())) {
+    fprintf(stderr, "No catalog in %s and unknown scale factor %d\n", data_dir.c_str(), sf);
+    exit(1);
+  }
+}
+
+//file of a column under the data directory, empty when the catalog does not list it
+inline std::string catalogFile(std::string col_name, bool sorted) {
+  auto it = catalog().column.find(col_name);
+  if (it == catalog().column.end()) return "";
+  if (sorted && !it->second.sorted_file.empty()) return it->second.sorted_file;
+  return it->second.file;
+}
+
+inline std::string catalogStats(std::string col_name) {
+  auto it = catalog().column.find(col_name);
+  if (it == catalog().column.end() || it->second.stats_file.empty()) return col_name + "stats";
+  return it->second.stats_file;
+}
+
+//empty when the loader did not pack the column
+inline std::string catalogPack(std::string col_name) {
+  auto it = catalog().column.find(col_name);
+  if (it == catalog().column.end()) return col_name + "pack";
+  return it->second.pack_file;
+}
+
+//empty when the loader did not slice the column
+inline std::string catalogSlice(std::string col_name) {
+  auto it = catalog().column.find(col_name);
+  if (it == catalog().column.end()) return col_name + "slice";
+  return it->second.slice_file;
+}
+
+//aggregate files the loader wrote for the table
+inline std::vector<std::string> catalogAggregates(std::string table) {
+  std::vector<std::string> files;
+  for (auto it = catalog().aggregate.begin(); it != catalog().aggregate.end(); it++)
+    if (it->second == table) files.push_back(it->first);
+  return files;
+}
+
+#endif
@@ -280,6 +280,54 @@ CostModel::permute_costHE() {
 
 }
 
+//fraction of rows of the listed segments passing the predicate on col, -1 without stats or predicate
+double
+CostModel::statsSelectivity(ColumnInfo* col, short* segment, int count) {
+	segmentStats* stats = qo->cm->segment_stats[col->column_id];
+	if (stats == NULL || count == 0) return -1;
+	if (qo->params->compare1.find(col) == qo->params->compare1.end()) return -1;
+
+	int compare1 = qo->params->compare1[col];
+	int compare2 = qo->params->compare2[col];
+	int mode = (qo->params->mode.find(col) != qo->params->mode.end()) ? qo->params->mode[col] : 1;
+
+	double rows = 0, selected = 0;
+	for (int i = 0; i < count; i++) {
+		segmentStats& seg = stats[segment[i]];
+		rows += seg.count;
+		selected += seg.count * segmentSelectivity(seg, mode, compare1, compare2);
+	}
+	return (rows > 0) ? selected / rows : -1;
+}
+
+//per segment group estimate from the segment stats, the hard coded real_selectivity is the fallback
+double
+CostModel::selectivity(ColumnInfo* col) {
+	if (est_selectivity.find(col) != est_selectivity.end()) return est_selectivity[col];
+
+	double sel = -1;
+	if (qo->params->compare1.find(col) != qo->params->compare1.end()) {
+		//predicate on the column itself (filters, and the date range of lo_orderdate)
+		short* segment = qo->segment_group[table_id] + sg * total_segment;
+		sel = statsSelectivity(col, segment, qo->segment_group_count[table_id][sg]);
+	} else if (qo->fkey_pkey.find(col) != qo->fkey_pkey.end()) {
+		//probe: share of the dimension surviving its filters, over the whole dimension table
+		ColumnInfo* pkey = qo->fkey_pkey[col];
+		vector<ColumnInfo*>& filters = qo->select_build[pkey];
+		sel = 1;
+		for (int i = 0; i < filters.size() && sel >= 0; i++) {
+			vector<short> segment(filters[i]->total_segment);
+			for (int j = 0; j < filters[i]->total_segment; j++) segment[j] = j;
+			double filter_sel = statsSelectivity(filters[i], segment.data(), filters[i]->total_segment);
+			sel = (filter_sel < 0) ? -1 : sel * filter_sel;
+		}
+	}
+
+	if (sel < 0) sel = qo->params->real_selectivity[col];
+	est_selectivity[col] = sel;
+	return sel;
+}
+
 double 
 CostModel::calculate_cost() {
 	double cost = 0;
@@ -289,11 +337,11 @@ CostModel::calculate_cost() {
 	if (selectGPU.size() > 0 || joinGPU.size() > 0) {
 		for (int i = 0; i < selectGPU.size(); ++i) {
 			ColumnInfo* col = selectGPU[i];
-			L *= qo->params->real_selectivity[col];
+			L *= selectivity(col);
 		}
 		for (int i = 0; i < joinGPU.size(); ++i) {	
 			ColumnInfo* col = joinGPU[i];
-			L *= qo->params->real_selectivity[col];
+			L *= selectivity(col);
 		}
 		if (selectCPU.size() > 0 || joinCPU.size() > 0 || groupCPU.size() > 0 || buildCPU.size() > 0) {
 			// if (selectGPU.size() == 0) cost += transfer_cost(joinGPU.size() + 1);
@@ -308,9 +356,9 @@ CostModel::calculate_cost() {
 	for (int i = 0; i < selectCPU.size(); i++) {
 		ColumnInfo* col = selectCPU[i];
 		if (fromGPU) {
-			cost += filter_cost(qo->params->real_selectivity[col], 1, 0);
+			cost += filter_cost(selectivity(col), 1, 0);
 			fromGPU = false;
-		} else cost += filter_cost(qo->params->real_selectivity[col], 0, 0);
+		} else cost += filter_cost(selectivity(col), 0, 0);
 	}
 
 	// cout << "2 " << cost << endl;
@@ -318,9 +366,9 @@ CostModel::calculate_cost() {
 	for (int i = 0; i < joinCPU.size(); i++) {
 		ColumnInfo* col = joinCPU[i];
 		if (fromGPU) {
-			cost += probe_cost(qo->params->real_selectivity[col], 1, 0);
+			cost += probe_cost(selectivity(col), hashTableBytes(qo->fkey_pkey[col]), 1, 0);
 			fromGPU = false;
-		} else cost += probe_cost(qo->params->real_selectivity[col], 0, 0);
+		} else cost += probe_cost(selectivity(col), hashTableBytes(qo->fkey_pkey[col]), 0, 0);
 	}
 
 	// cout << "3 " << cost << endl;
@@ -353,27 +401,37 @@ CostModel::calculate_cost() {
 
 	if (buildCPU.size() > 0) {
 		if (fromGPU) {
-			cost += build_cost(1);
+			cost += build_cost(hashTableBytes(buildCPU[0]), 1);
 			fromGPU = false;
-		} else cost += build_cost(0);
+		} else cost += build_cost(hashTableBytes(buildCPU[0]), 0);
 	}
 
 	return cost;
 
 }
 
+//bytes of the hash table of a dimension, 2 ints per key
+double
+CostModel::hashTableBytes(ColumnInfo* pkey) {
+	QueryParams* params = qo->params;
+	if (pkey == NULL || params->dim_len.find(pkey) == params->dim_len.end()) return 0;
+	return 2.0 * params->dim_len[pkey] * sizeof(int);
+}
+
+//the probes cost what the machine profile measured for a hash table of that size, one line from memory without a profile
 double 
-CostModel::probe_cost(double selectivity, bool mat_start, bool mat_end) {
+CostModel::probe_cost(double selectivity, double ht_bytes, bool mat_start, bool mat_end) {
 
+	machineProfile& m = machine();
 	double cost = 0;
 	double scan_time = 0, probe_time = 0, write_time = 0;
 
-	if (mat_start) scan_time = L * 4/BW_CPU + L * CACHE_LINE/BW_CPU;
-	else scan_time = L * 4/BW_CPU;
+	if (mat_start) scan_time = L * 4/m.bw_cpu + L * m.cache_line/m.bw_cpu;
+	else scan_time = L * 4/m.bw_cpu;
 
-	probe_time = L * CACHE_LINE/BW_CPU;
+	probe_time = L * probeTime(ht_bytes);
 
-	if (mat_end) write_time = L * 4 * selectivity * 2/BW_CPU;
+	if (mat_end) write_time = L * 4 * selectivity * 2/m.bw_write;
 	else write_time = 0;
 
 	L *= selectivity;
@@ -385,20 +443,21 @@ CostModel::probe_cost(double selectivity, bool mat_start, bool mat_end) {
 
 double 
 CostModel::transfer_cost(int M) {
-	double transfer_time = L * 4 * M/BW_PCI;
+	double transfer_time = L * 4 * M/machine().bw_pci;
 	return transfer_time;
 }
 
 double 
 CostModel::filter_cost(double selectivity, bool mat_start, bool mat_end) {
 
+	machineProfile& m = machine();
 	double cost = 0;
 	double scan_time = 0, write_time = 0;
 
-	if (mat_start) scan_time = L * 4/BW_CPU + L * CACHE_LINE/BW_CPU;
-	else scan_time = L * 4/BW_CPU;
+	if (mat_start) scan_time = L * 4/m.bw_cpu + L * m.cache_line/m.bw_cpu;
+	else scan_time = L * 4/m.bw_cpu;
 
-	if (mat_end) write_time = L * 4 * selectivity/BW_CPU;
+	if (mat_end) write_time = L * 4 * selectivity/m.bw_write;
 	else write_time = 0;
 
 	L *= selectivity;
@@ -411,13 +470,15 @@ CostModel::filter_cost(double selectivity, bool mat_start, bool mat_end) {
 double 
 CostModel::group_cost(bool mat_start) {
 
+	machineProfile& m = machine();
 	double cost = 0;
 	double scan_time = 0, group_time = 0;
 
-	if (mat_start) scan_time = L * 4 /BW_CPU + L * CACHE_LINE * (n_aggr_key)/BW_CPU; //the cost to random read group key has not been included
-	else scan_time = L * CACHE_LINE * n_aggr_key/BW_CPU;
+	if (mat_start) scan_time = L * 4 /m.bw_cpu + L * m.cache_line * (n_aggr_key)/m.bw_cpu; //the cost to random read group key has not been included
+	else scan_time = L * m.cache_line * n_aggr_key/m.bw_cpu;
 
-	group_time = L * CACHE_LINE/BW_CPU;
+	//the group by updates land in the result array, 6 ints per group
+	group_time = L * probeTime(qo->params->total_val * 6.0 * sizeof(int));
 
 	cost = scan_time + group_time;
 
@@ -425,17 +486,18 @@ CostModel::group_cost(bool mat_start) {
 }
 
 double 
-CostModel::build_cost(bool mat_start) {
+CostModel::build_cost(double ht_bytes, bool mat_start) {
 
+	machineProfile& m = machine();
 	double cost = 0;
 	double scan_time = 0, build_time = 0;
 
-	if (mat_start) scan_time = L * 4/BW_CPU + L * CACHE_LINE/BW_CPU;
-	else scan_time = L * 4/BW_CPU;
+	if (mat_start) scan_time = L * 4/m.bw_cpu + L * m.cache_line/m.bw_cpu;
+	else scan_time = L * 4/m.bw_cpu;
 
-	build_time = L * CACHE_LINE/BW_CPU;
+	build_time = L * probeTime(ht_bytes);
 
 	cost = scan_time + build_time;
 
 	return cost;
-}
\ No newline at end of file
+}
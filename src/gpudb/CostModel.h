@@ -1,11 +1,8 @@
 #ifndef _COST_MODEL_H
 #define _COST_MODEL_H
 
-#define CACHE_LINE 64
-#define BW_CPU 42000000
-#define BW_PCI 12000000
-
 #include "QueryOptimizer.h"
+#include "MachineProfile.h"
 
 class CostModel {
 public:
@@ -32,16 +29,21 @@ public:
 
 	QueryOptimizer* qo;
 
+	map<ColumnInfo*, double> est_selectivity;
+
 	CostModel(int _L, int _total_segment, int _n_group_key, int _n_aggr_key, int _sg, int _table_id, QueryOptimizer* _qo);
 	void clear();
 	void permute_cost();
 	void permute_costHE();
 	double calculate_cost();
-	double probe_cost(double selectivity, bool mat_start, bool mat_end);
+	double probe_cost(double selectivity, double ht_bytes, bool mat_start, bool mat_end);
 	double transfer_cost(int M = 2);
 	double filter_cost(double selectivity, bool mat_start, bool mat_end);
 	double group_cost(bool mat_start);
-	double build_cost(bool mat_start);
+	double build_cost(double ht_bytes, bool mat_start);
+	double hashTableBytes(ColumnInfo* pkey);
+	double selectivity(ColumnInfo* col);
+	double statsSelectivity(ColumnInfo* col, short* segment, int count);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,357 @@
+#include "DeviceBackend.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <thread>
+#include <unistd.h>
+#include <sys/mman.h>
+
+DeviceBackend* g_device = new CUDADevice();
+
+void
+setDeviceBackend(DeviceBackend* device) {
+	assert(device != NULL);
+	if (g_device != device) delete g_device;
+	g_device = device;
+}
+
+cudaError_t
+CUDADevice::malloc(void** ptr, size_t size) {
+	return cudaMalloc(ptr, size);
+}
+
+cudaError_t
+CUDADevice::mallocPool(void** ptr, size_t size) {
+	return cudaMalloc(ptr, size);
+}
+
+cudaError_t
+CUDADevice::free(void* ptr) {
+	return cudaFree(ptr);
+}
+
+cudaError_t
+CUDADevice::hostAlloc(void** ptr, size_t size, unsigned int flags) {
+	return cudaHostAlloc(ptr, size, flags);
+}
+
+cudaError_t
+CUDADevice::freeHost(void* ptr) {
+	return cudaFreeHost(ptr);
+}
+
+cudaError_t
+CUDADevice::hostRegister(void* ptr, size_t size, unsigned int flags) {
+	return cudaHostRegister(ptr, size, flags);
+}
+
+cudaError_t
+CUDADevice::hostUnregister(void* ptr) {
+	return cudaHostUnregister(ptr);
+}
+
+cudaError_t
+CUDADevice::memset(void* ptr, int value, size_t size) {
+	return cudaMemset(ptr, value, size);
+}
+
+cudaError_t
+CUDADevice::memsetAsync(void* ptr, int value, size_t size, cudaStream_t stream) {
+	return cudaMemsetAsync(ptr, value, size, stream);
+}
+
+cudaError_t
+CUDADevice::memcpy(void* dst, const void* src, size_t size, cudaMemcpyKind kind) {
+	return cudaMemcpy(dst, src, size, kind);
+}
+
+cudaError_t
+CUDADevice::memcpyAsync(void* dst, const void* src, size_t size, cudaMemcpyKind kind, cudaStream_t stream) {
+	return cudaMemcpyAsync(dst, src, size, kind, stream);
+}
+
+cudaError_t
+CUDADevice::streamCreate(cudaStream_t* stream) {
+	return cudaStreamCreate(stream);
+}
+
+cudaError_t
+CUDADevice::streamSynchronize(cudaStream_t stream) {
+	return cudaStreamSynchronize(stream);
+}
+
+cudaError_t
+CUDADevice::streamDestroy(cudaStream_t stream) {
+	return cudaStreamDestroy(stream);
+}
+
+cudaError_t
+CUDADevice::synchronize() {
+	return cudaDeviceSynchronize();
+}
+
+cudaError_t
+CUDADevice::getLastError() {
+	return cudaGetLastError();
+}
+
+void
+CUDADevice::eventCreate(deviceEvent_t* ev) {
+	cudaEventCreate(&(ev->event));
+}
+
+void
+CUDADevice::eventRecord(deviceEvent_t& ev, cudaStream_t stream) {
+	cudaEventRecord(ev.event, stream);
+}
+
+void
+CUDADevice::eventSynchronize(deviceEvent_t& ev) {
+	cudaEventSynchronize(ev.event);
+}
+
+void
+CUDADevice::eventElapsedTime(float* ms, deviceEvent_t& start, deviceEvent_t& stop) {
+	cudaEventElapsedTime(ms, start.event, stop.event);
+}
+
+CUresult
+CUDADevice::ctxPushCurrent(CUcontext ctx) {
+	return cuCtxPushCurrent(ctx);
+}
+
+CUresult
+CUDADevice::ctxPopCurrent(CUcontext* ctx) {
+	return cuCtxPopCurrent(ctx);
+}
+
+HostDevice::HostDevice(size_t _capacity, double _bandwidth, double _latency)
+: capacity(_capacity), used(0), peak(0), bandwidth(_bandwidth), latency(_latency), h2d_bytes(0), d2h_bytes(0) {
+	assert(bandwidth > 0);
+}
+
+HostDevice::~HostDevice() {
+	for (auto it = allocation.begin(); it != allocation.end(); it++) {
+		auto shared = pool.find(it->first);
+		if (shared == pool.end()) {
+			::free(it->first);
+			continue;
+		}
+		munmap(it->first, shared->second.second);
+		close(shared->second.first);
+	}
+}
+
+cudaError_t
+HostDevice::malloc(void** ptr, size_t size) {
+	std::lock_guard<std::mutex> lock(alloc_lock);
+	if (used + size > capacity) {
+		*ptr = NULL;
+		return cudaErrorMemoryAllocation;
+	}
+	*ptr = ::malloc(size > 0 ? size : 1);
+	if (*ptr == NULL) return cudaErrorMemoryAllocation;
+	allocation[*ptr] = size;
+	used += size;
+	if (used > peak) peak = used;
+	return cudaSuccess;
+}
+
+//backed by a memfd so the pages can be mapped a second time into the column views
+cudaError_t
+HostDevice::mallocPool(void** ptr, size_t size) {
+	std::lock_guard<std::mutex> lock(alloc_lock);
+	*ptr = NULL;
+	if (used + size > capacity) return cudaErrorMemoryAllocation;
+
+	size_t bytes = (size > 0) ? size : 1;
+	int fd = memfd_create("mordred-gpu-cache", 0);
+	if (fd < 0) return cudaErrorMemoryAllocation;
+	if (ftruncate(fd, bytes) != 0) {
+		close(fd);
+		return cudaErrorMemoryAllocation;
+	}
+	void* base = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (base == MAP_FAILED) {
+		close(fd);
+		return cudaErrorMemoryAllocation;
+	}
+
+	*ptr = base;
+	allocation[base] = size;
+	pool[base] = std::make_pair(fd, bytes);
+	used += size;
+	if (used > peak) peak = used;
+	return cudaSuccess;
+}
+
+cudaError_t
+HostDevice::free(void* ptr) {
+	if (ptr == NULL) return cudaSuccess;
+	std::lock_guard<std::mutex> lock(alloc_lock);
+	auto it = allocation.find(ptr);
+	if (it == allocation.end()) return cudaErrorInvalidDevicePointer;
+	used -= it->second;
+	allocation.erase(it);
+
+	auto shared = pool.find(ptr);
+	if (shared == pool.end()) {
+		::free(ptr);
+		return cudaSuccess;
+	}
+	munmap(ptr, shared->second.second);
+	close(shared->second.first);
+	pool.erase(shared);
+	return cudaSuccess;
+}
+
+void*
+HostDevice::reserveView(size_t size) {
+	void* view = mmap(NULL, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	return (view == MAP_FAILED) ? NULL : view;
+}
+
+//pool_ptr and size must be page aligned, an earlier mapping of the range is replaced in place
+bool
+HostDevice::mapView(void* view, const void* pool_ptr, size_t size) {
+	std::lock_guard<std::mutex> lock(alloc_lock);
+	for (auto it = pool.begin(); it != pool.end(); it++) {
+		const char* base = (const char*) it->first;
+		if ((const char*) pool_ptr < base || (const char*) pool_ptr + size > base + it->second.second) continue;
+		void* mapped = mmap(view, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, it->second.first, (const char*) pool_ptr - base);
+		return mapped == view;
+	}
+	return false;
+}
+
+void
+HostDevice::releaseView(void* view, size_t size) {
+	if (view != NULL) munmap(view, size);
+}
+
+cudaError_t
+HostDevice::hostAlloc(void** ptr, size_t size, unsigned int flags) {
+	*ptr = ::malloc(size > 0 ? size : 1);
+	if (*ptr == NULL) return cudaErrorMemoryAllocation;
+	return cudaSuccess;
+}
+
+cudaError_t
+HostDevice::freeHost(void* ptr) {
+	::free(ptr);
+	return cudaSuccess;
+}
+
+//host memory is already where the emulated device reads it
+cudaError_t
+HostDevice::hostRegister(void* ptr, size_t size, unsigned int flags) {
+	return cudaSuccess;
+}
+
+cudaError_t
+HostDevice::hostUnregister(void* ptr) {
+	return cudaSuccess;
+}
+
+cudaError_t
+HostDevice::memset(void* ptr, int value, size_t size) {
+	std::memset(ptr, value, size);
+	return cudaSuccess;
+}
+
+cudaError_t
+HostDevice::memsetAsync(void* ptr, int value, size_t size, cudaStream_t stream) {
+	std::memset(ptr, value, size);
+	return cudaSuccess;
+}
+
+//copy now, then hold the link until the simulated PCIe transfer would have finished
+void
+HostDevice::transfer(void* dst, const void* src, size_t size, cudaMemcpyKind kind) {
+	if (kind != cudaMemcpyHostToDevice && kind != cudaMemcpyDeviceToHost) {
+		std::memcpy(dst, src, size);
+		return;
+	}
+
+	std::mutex& link = (kind == cudaMemcpyHostToDevice) ? h2d_link : d2h_link;
+	std::lock_guard<std::mutex> lock(link);
+
+	std::chrono::high_resolution_clock::time_point st = std::chrono::high_resolution_clock::now();
+	std::memcpy(dst, src, size);
+	if (kind == cudaMemcpyHostToDevice) h2d_bytes += size;
+	else d2h_bytes += size;
+
+	std::chrono::duration<double, std::milli> wire(latency + size / bandwidth);
+	std::this_thread::sleep_until(st + std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(wire));
+}
+
+cudaError_t
+HostDevice::memcpy(void* dst, const void* src, size_t size, cudaMemcpyKind kind) {
+	transfer(dst, src, size, kind);
+	return cudaSuccess;
+}
+
+cudaError_t
+HostDevice::memcpyAsync(void* dst, const void* src, size_t size, cudaMemcpyKind kind, cudaStream_t stream) {
+	transfer(dst, src, size, kind);
+	return cudaSuccess;
+}
+
+//work on the emulated device is synchronous, so streams are only placeholders
+cudaError_t
+HostDevice::streamCreate(cudaStream_t* stream) {
+	*stream = 0;
+	return cudaSuccess;
+}
+
+cudaError_t
+HostDevice::streamSynchronize(cudaStream_t stream) {
+	return cudaSuccess;
+}
+
+cudaError_t
+HostDevice::streamDestroy(cudaStream_t stream) {
+	return cudaSuccess;
+}
+
+cudaError_t
+HostDevice::synchronize() {
+	return cudaSuccess;
+}
+
+cudaError_t
+HostDevice::getLastError() {
+	return cudaSuccess;
+}
+
+void
+HostDevice::eventCreate(deviceEvent_t* ev) {
+	ev->event = NULL;
+	ev->time = std::chrono::high_resolution_clock::now();
+}
+
+void
+HostDevice::eventRecord(deviceEvent_t& ev, cudaStream_t stream) {
+	ev.time = std::chrono::high_resolution_clock::now();
+}
+
+void
+HostDevice::eventSynchronize(deviceEvent_t& ev) {
+}
+
+void
+HostDevice::eventElapsedTime(float* ms, deviceEvent_t& start, deviceEvent_t& stop) {
+	std::chrono::duration<float, std::milli> elapsed = stop.time - start.time;
+	*ms = elapsed.count();
+}
+
+CUresult
+HostDevice::ctxPushCurrent(CUcontext ctx) {
+	return CUDA_SUCCESS;
+}
+
+CUresult
+HostDevice::ctxPopCurrent(CUcontext* ctx) {
+	if (ctx != NULL) *ctx = NULL;
+	return CUDA_SUCCESS;
+}
@@ -0,0 +1,193 @@
+#ifndef _DEVICE_BACKEND_H_
+#define _DEVICE_BACKEND_H_
+
+#include <cuda.h>
+#include <cuda_runtime.h>
+#include <cstring>
+#include <chrono>
+#include <mutex>
+#include <unordered_map>
+
+#define HOST_DEVICE_BW_PCI 12000000 //bytes per ms, same as BW_PCI in MachineProfile.h
+#define HOST_DEVICE_LATENCY 0.01 //ms per transfer
+#define HOST_DEVICE_CAPACITY (16UL * 1024 * 1024 * 1024) //bytes
+
+class DeviceBackend;
+class CUDADevice;
+class HostDevice;
+
+//timing event usable on both backends (cuda event or host timestamp)
+typedef struct deviceEvent_t {
+	cudaEvent_t event;
+	std::chrono::high_resolution_clock::time_point time;
+} deviceEvent_t;
+
+//everything the engine needs from a device: memory, copies, streams, events and contexts
+class DeviceBackend {
+public:
+	virtual ~DeviceBackend() {};
+
+	virtual bool isHost() = 0;
+
+	virtual cudaError_t malloc(void** ptr, size_t size) = 0;
+	virtual cudaError_t mallocPool(void** ptr, size_t size) = 0; //the segment cache, see HostDevice::mapView
+	virtual cudaError_t free(void* ptr) = 0;
+	virtual cudaError_t hostAlloc(void** ptr, size_t size, unsigned int flags) = 0;
+	virtual cudaError_t freeHost(void* ptr) = 0;
+	virtual cudaError_t hostRegister(void* ptr, size_t size, unsigned int flags) = 0;
+	virtual cudaError_t hostUnregister(void* ptr) = 0;
+	virtual cudaError_t memset(void* ptr, int value, size_t size) = 0;
+	virtual cudaError_t memsetAsync(void* ptr, int value, size_t size, cudaStream_t stream) = 0;
+	virtual cudaError_t memcpy(void* dst, const void* src, size_t size, cudaMemcpyKind kind) = 0;
+	virtual cudaError_t memcpyAsync(void* dst, const void* src, size_t size, cudaMemcpyKind kind, cudaStream_t stream) = 0;
+
+	virtual cudaError_t streamCreate(cudaStream_t* stream) = 0;
+	virtual cudaError_t streamSynchronize(cudaStream_t stream) = 0;
+	virtual cudaError_t streamDestroy(cudaStream_t stream) = 0;
+	virtual cudaError_t synchronize() = 0;
+	virtual cudaError_t getLastError() = 0;
+
+	virtual void eventCreate(deviceEvent_t* ev) = 0;
+	virtual void eventRecord(deviceEvent_t& ev, cudaStream_t stream) = 0;
+	virtual void eventSynchronize(deviceEvent_t& ev) = 0;
+	virtual void eventElapsedTime(float* ms, deviceEvent_t& start, deviceEvent_t& stop) = 0;
+
+	virtual CUresult ctxPushCurrent(CUcontext ctx) = 0;
+	virtual CUresult ctxPopCurrent(CUcontext* ctx) = 0;
+};
+
+class CUDADevice : public DeviceBackend {
+public:
+	bool isHost() { return false; };
+
+	cudaError_t malloc(void** ptr, size_t size);
+	cudaError_t mallocPool(void** ptr, size_t size);
+	cudaError_t free(void* ptr);
+	cudaError_t hostAlloc(void** ptr, size_t size, unsigned int flags);
+	cudaError_t freeHost(void* ptr);
+	cudaError_t hostRegister(void* ptr, size_t size, unsigned int flags);
+	cudaError_t hostUnregister(void* ptr);
+	cudaError_t memset(void* ptr, int value, size_t size);
+	cudaError_t memsetAsync(void* ptr, int value, size_t size, cudaStream_t stream);
+	cudaError_t memcpy(void* dst, const void* src, size_t size, cudaMemcpyKind kind);
+	cudaError_t memcpyAsync(void* dst, const void* src, size_t size, cudaMemcpyKind kind, cudaStream_t stream);
+
+	cudaError_t streamCreate(cudaStream_t* stream);
+	cudaError_t streamSynchronize(cudaStream_t stream);
+	cudaError_t streamDestroy(cudaStream_t stream);
+	cudaError_t synchronize();
+	cudaError_t getLastError();
+
+	void eventCreate(deviceEvent_t* ev);
+	void eventRecord(deviceEvent_t& ev, cudaStream_t stream);
+	void eventSynchronize(deviceEvent_t& ev);
+	void eventElapsedTime(float* ms, deviceEvent_t& start, deviceEvent_t& stop);
+
+	CUresult ctxPushCurrent(CUcontext ctx);
+	CUresult ctxPopCurrent(CUcontext* ctx);
+};
+
+//emulated GPU living in host memory: device allocations come from a separate capacity-limited pool
+//and host<->device copies are throttled to a simulated PCIe bandwidth (one link per direction)
+class HostDevice : public DeviceBackend {
+public:
+	size_t capacity;
+	size_t used;
+	size_t peak;
+	double bandwidth; //bytes per ms
+	double latency; //ms
+
+	unsigned long long h2d_bytes;
+	unsigned long long d2h_bytes;
+
+	HostDevice(size_t _capacity = HOST_DEVICE_CAPACITY, double _bandwidth = HOST_DEVICE_BW_PCI, double _latency = HOST_DEVICE_LATENCY);
+	~HostDevice();
+
+	bool isHost() { return true; };
+
+	cudaError_t malloc(void** ptr, size_t size);
+	cudaError_t mallocPool(void** ptr, size_t size);
+	cudaError_t free(void* ptr);
+	cudaError_t hostAlloc(void** ptr, size_t size, unsigned int flags);
+	cudaError_t freeHost(void* ptr);
+	cudaError_t hostRegister(void* ptr, size_t size, unsigned int flags);
+	cudaError_t hostUnregister(void* ptr);
+	cudaError_t memset(void* ptr, int value, size_t size);
+	cudaError_t memsetAsync(void* ptr, int value, size_t size, cudaStream_t stream);
+	cudaError_t memcpy(void* dst, const void* src, size_t size, cudaMemcpyKind kind);
+	cudaError_t memcpyAsync(void* dst, const void* src, size_t size, cudaMemcpyKind kind, cudaStream_t stream);
+
+	cudaError_t streamCreate(cudaStream_t* stream);
+	cudaError_t streamSynchronize(cudaStream_t stream);
+	cudaError_t streamDestroy(cudaStream_t stream);
+	cudaError_t synchronize();
+	cudaError_t getLastError();
+
+	void eventCreate(deviceEvent_t* ev);
+	void eventRecord(deviceEvent_t& ev, cudaStream_t stream);
+	void eventSynchronize(deviceEvent_t& ev);
+	void eventElapsedTime(float* ms, deviceEvent_t& start, deviceEvent_t& stop);
+
+	CUresult ctxPushCurrent(CUcontext ctx);
+	CUresult ctxPopCurrent(CUcontext* ctx);
+
+	//a column as the emulated gpu sees it: an address range reserved without access, whose segments are
+	//mapped one by one onto the pool slots holding them, so reading an uncached segment faults
+	void* reserveView(size_t size);
+	bool mapView(void* view, const void* pool_ptr, size_t size);
+	void releaseView(void* view, size_t size);
+
+private:
+	std::mutex alloc_lock;
+	std::mutex h2d_link;
+	std::mutex d2h_link;
+	std::unordered_map<void*, size_t> allocation;
+	std::unordered_map<void*, std::pair<int, size_t>> pool; //mallocPool allocations: memfd and mapped size
+
+	void transfer(void* dst, const void* src, size_t size, cudaMemcpyKind kind);
+};
+
+//the backend used by the whole process, CUDADevice unless another one is installed before CacheManager is created
+extern DeviceBackend* g_device;
+
+void setDeviceBackend(DeviceBackend* device);
+
+inline bool deviceIsHost() { return g_device->isHost(); }
+
+inline cudaError_t deviceMalloc(void** ptr, size_t size) { return g_device->malloc(ptr, size); }
+inline cudaError_t deviceMallocPool(void** ptr, size_t size) { return g_device->mallocPool(ptr, size); }
+inline cudaError_t deviceFree(void* ptr) { return g_device->free(ptr); }
+inline cudaError_t deviceHostAlloc(void** ptr, size_t size, unsigned int flags) { return g_device->hostAlloc(ptr, size, flags); }
+inline cudaError_t deviceFreeHost(void* ptr) { return g_device->freeHost(ptr); }
+inline cudaError_t deviceHostRegister(void* ptr, size_t size, unsigned int flags) { return g_device->hostRegister(ptr, size, flags); }
+inline cudaError_t deviceHostUnregister(void* ptr) { return g_device->hostUnregister(ptr); }
+inline cudaError_t deviceMemset(void* ptr, int value, size_t size) { return g_device->memset(ptr, value, size); }
+inline cudaError_t deviceMemsetAsync(void* ptr, int value, size_t size, cudaStream_t stream = 0) { return g_device->memsetAsync(ptr, value, size, stream); }
+inline cudaError_t deviceMemcpy(void* dst, const void* src, size_t size, cudaMemcpyKind kind) { return g_device->memcpy(dst, src, size, kind); }
+inline cudaError_t deviceMemcpyAsync(void* dst, const void* src, size_t size, cudaMemcpyKind kind, cudaStream_t stream = 0) { return g_device->memcpyAsync(dst, src, size, kind, stream); }
+
+inline cudaError_t deviceStreamCreate(cudaStream_t* stream) { return g_device->streamCreate(stream); }
+inline cudaError_t deviceStreamSynchronize(cudaStream_t stream) { return g_device->streamSynchronize(stream); }
+inline cudaError_t deviceStreamDestroy(cudaStream_t stream) { return g_device->streamDestroy(stream); }
+inline cudaError_t deviceSynchronize() { return g_device->synchronize(); }
+inline cudaError_t deviceGetLastError() { return g_device->getLastError(); }
+
+inline void deviceEventCreate(deviceEvent_t* ev) { g_device->eventCreate(ev); }
+inline void deviceEventRecord(deviceEvent_t& ev, cudaStream_t stream = 0) { g_device->eventRecord(ev, stream); }
+inline void deviceEventSynchronize(deviceEvent_t& ev) { g_device->eventSynchronize(ev); }
+inline void deviceEventElapsedTime(float* ms, deviceEvent_t& start, deviceEvent_t& stop) { g_device->eventElapsedTime(ms, start, stop); }
+
+inline CUresult deviceCtxPushCurrent(CUcontext ctx) { return g_device->ctxPushCurrent(ctx); }
+inline CUresult deviceCtxPopCurrent(CUcontext* ctx) { return g_device->ctxPopCurrent(ctx); }
+
+//device function pointers only exist on a real GPU, the emulated device gets NULL
+template <typename T>
+cudaError_t deviceMemcpyFromSymbol(void* dst, const T& symbol, size_t size) {
+	if (g_device->isHost()) {
+		std::memset(dst, 0, size);
+		return cudaSuccess;
+	}
+	return cudaMemcpyFromSymbol(dst, symbol, size);
+}
+
+#endif
@@ -0,0 +1,131 @@
+#ifndef _HASH_TABLE_CACHE_H_
+#define _HASH_TABLE_CACHE_H_
+
+#include "CacheManager.h"
+
+#define HT_CACHE_MB 1024 //default budget of the cached hash tables, cpu and gpu copies together
+
+//dimension hash tables shared by the queries of a CacheManager. a query that builds the hash table of a dimension
+//publishes a copy under (dimension, value column, predicates), a later or concurrent query with the same key probes
+//the copy instead of running the dimension pipelines again. dimensions are read only, so entries never go stale;
+//the least recently used unpinned entries are dropped when the budget is exceeded
+typedef struct htEntry {
+  int* ht_CPU; //NULL when the publishing query had no cpu probes
+  int* ht_GPU;
+  size_t bytes; //of one copy
+  ProcessingScope* scope; //holds both copies
+  int pins; //queries probing the entry right now
+  unsigned long long last_use;
+} htEntry;
+
+class HashTableCache {
+public:
+  CacheManager* cm;
+  map<string, htEntry*> entries;
+  mutex lock;
+  size_t budget, used; //bytes
+  unsigned long long clock;
+  unsigned long long hits, misses, inserts, evictions;
+
+  HashTableCache(CacheManager* _cm, size_t _budget = (size_t) HT_CACHE_MB * 1048576)
+    : cm(_cm), budget(_budget), used(0), clock(0), hits(0), misses(0), inserts(0), evictions(0) {}
+
+  ~HashTableCache() {
+    clear();
+  }
+
+  //pinned entry holding every side the query probes, NULL on a miss. release it when the query ends
+  htEntry* acquire(string key, bool need_CPU, bool need_GPU) {
+    lock_guard<mutex> guard(lock);
+    auto it = entries.find(key);
+    if (it == entries.end() || (need_CPU && it->second->ht_CPU == NULL) || (need_GPU && it->second->ht_GPU == NULL)) {
+      misses++;
+      return NULL;
+    }
+    htEntry* entry = it->second;
+    entry->pins++;
+    entry->last_use = ++clock;
+    hits++;
+    return entry;
+  }
+
+  void release(htEntry* entry) {
+    lock_guard<mutex> guard(lock);
+    entry->pins--;
+    evict();
+  }
+
+  //copies the hash tables a query has just built, the query keeps probing its own copies
+  void publish(string key, int* ht_CPU, int* ht_GPU, int ints) {
+    {
+      lock_guard<mutex> guard(lock);
+      auto it = entries.find(key);
+      if (it != entries.end() && (ht_CPU == NULL || it->second->ht_CPU != NULL) && (ht_GPU == NULL || it->second->ht_GPU != NULL)) return;
+    }
+
+    htEntry* entry = new htEntry();
+    entry->bytes = (size_t) ints * sizeof(int);
+    entry->scope = new ProcessingScope(cm);
+    entry->ht_CPU = NULL;
+    entry->ht_GPU = NULL;
+    entry->pins = 0;
+    if (ht_CPU != NULL) {
+      entry->ht_CPU = cm->customMalloc<int>(ints, entry->scope);
+      memcpy(entry->ht_CPU, ht_CPU, entry->bytes);
+    }
+    if (ht_GPU != NULL) {
+      entry->ht_GPU = cm->customCudaMalloc<int>(ints, entry->scope);
+      CubDebugExit(deviceMemcpy(entry->ht_GPU, ht_GPU, entry->bytes, cudaMemcpyDeviceToDevice));
+    }
+
+    lock_guard<mutex> guard(lock);
+    auto it = entries.find(key);
+    if (it != entries.end()) {
+      //a concurrent query published first, keep the entry that covers more sides
+      if (it->second->pins > 0 || (it->second->ht_CPU != NULL) + (it->second->ht_GPU != NULL) >= (entry->ht_CPU != NULL) + (entry->ht_GPU != NULL)) {
+        drop(entry);
+        return;
+      }
+      used -= size(it->second);
+      drop(it->second);
+    }
+    entry->last_use = ++clock;
+    entries[key] = entry;
+    used += size(entry);
+    inserts++;
+    evict();
+  }
+
+  size_t size(htEntry* entry) {
+    return entry->bytes * ((entry->ht_CPU != NULL) + (entry->ht_GPU != NULL));
+  }
+
+  void drop(htEntry* entry) {
+    delete entry->scope;
+    delete entry;
+  }
+
+  //lock held
+  void evict() {
+    while (used > budget) {
+      auto victim = entries.end();
+      for (auto it = entries.begin(); it != entries.end(); it++)
+        if (it->second->pins == 0 && (victim == entries.end() || it->second->last_use < victim->second->last_use)) victim = it;
+      if (victim == entries.end()) return;
+      used -= size(victim->second);
+      drop(victim->second);
+      entries.erase(victim);
+      evictions++;
+    }
+  }
+
+  //no query may hold an entry
+  void clear() {
+    lock_guard<mutex> guard(lock);
+    for (auto it = entries.begin(); it != entries.end(); it++) drop(it->second);
+    entries.clear();
+    used = 0;
+  }
+};
+
+#endif
@@ -0,0 +1,158 @@
+#ifndef _JOIN_SUMMARY_H_
+#define _JOIN_SUMMARY_H_
+
+#include <vector>
+#include <algorithm>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_reduce.h>
+#include "SegmentStats.h"
+
+//keys of the dimension rows passing the dimension predicates of a query, for skipping the fact segments whose
+//foreign keys reach none of them: the min and max qualifying key and a bitmap of JOIN_SUMMARY_BITS equal key
+//ranges over [min, max] with a bit set when some key of its range qualifies. a fact segment is tested with its
+//min max and, when it has a stats file, the occupied histogram bins or the value bitmap of the foreign key
+
+#define JOIN_SUMMARY_BITS 4096
+#define JOIN_SUMMARY_CACHE 1024 //summaries a CacheManager keeps for later queries
+#define JOIN_SUMMARY_GRAIN 65536 //dimension rows per task of buildJoinSummary
+
+typedef struct joinSummary {
+  int count; //qualifying keys, 0 when no row passes
+  int min;
+  int max;
+  long long width; //keys per bit
+  std::vector<unsigned long long> bitmap;
+} joinSummary;
+
+//summary of the keys key[i] of the rows i < len for which pass(i) holds. two parallel scans of the dimension,
+//one for the min and max key and one for the bitmap, each task filling a private bitmap of at most 65 words
+template <typename F>
+inline joinSummary buildJoinSummary(const int* key, int len, F pass) {
+  joinSummary summary;
+  summary.count = 0;
+  summary.min = 0;
+  summary.max = -1;
+  summary.width = 1;
+
+  summary = tbb::parallel_reduce(tbb::blocked_range<int>(0, len, JOIN_SUMMARY_GRAIN), summary,
+    [&](const tbb::blocked_range<int>& range, joinSummary part) {
+      for (int i = range.begin(); i < range.end(); i++) {
+        if (!pass(i)) continue;
+        if (part.count == 0 || key[i] < part.min) part.min = key[i];
+        if (part.count == 0 || key[i] > part.max) part.max = key[i];
+        part.count++;
+      }
+      return part;
+    },
+    [](joinSummary a, const joinSummary& b) {
+      if (b.count == 0) return a;
+      if (a.count == 0) return b;
+      a.min = std::min(a.min, b.min);
+      a.max = std::max(a.max, b.max);
+      a.count += b.count;
+      return a;
+    });
+  if (summary.count == 0) return summary;
+
+  long long range = (long long) summary.max - summary.min + 1;
+  summary.width = (range + JOIN_SUMMARY_BITS - 1) / JOIN_SUMMARY_BITS;
+  std::vector<unsigned long long> empty((range / summary.width + 64) / 64, 0);
+  summary.bitmap = tbb::parallel_reduce(tbb::blocked_range<int>(0, len, JOIN_SUMMARY_GRAIN), empty,
+    [&](const tbb::blocked_range<int>& rows, std::vector<unsigned long long> bitmap) {
+      for (int i = rows.begin(); i < rows.end(); i++) {
+        if (!pass(i)) continue;
+        long long bit = ((long long) key[i] - summary.min) / summary.width;
+        bitmap[bit / 64] |= 1ULL << (bit % 64);
+      }
+      return bitmap;
+    },
+    [](std::vector<unsigned long long> a, const std::vector<unsigned long long>& b) {
+      for (int w = 0; w < a.size(); w++) a[w] |= b[w];
+      return a;
+    });
+  return summary;
+}
+
+//can a key of lo .. hi qualify
+inline bool joinSummaryMayMatch(const joinSummary& summary, long long lo, long long hi) {
+  if (summary.count == 0 || hi < summary.min || lo > summary.max) return false;
+  long long from = (std::max(lo, (long long) summary.min) - summary.min) / summary.width;
+  long long to = (std::min(hi, (long long) summary.max) - summary.min) / summary.width;
+  for (long long w = from / 64; w <= to / 64; w++) {
+    unsigned long long bits = summary.bitmap[w];
+    if (w == from / 64) bits &= ~0ULL << (from % 64);
+    if (w == to / 64 && to % 64 != 63) bits &= (1ULL << (to % 64 + 1)) - 1;
+    if (bits != 0) return true;
+  }
+  return false;
+}
+
+//can a foreign key of the segment qualify
+inline bool joinSegmentMayMatch(const joinSummary& summary, const segmentStats& stats) {
+  if (!joinSummaryMayMatch(summary, stats.min, stats.max)) return false;
+
+  if (stats.flags & STATS_HAS_BITMAP) {
+    for (int v = 0; v < 64; v++)
+      if (((stats.bitmap >> v) & 1) && joinSummaryMayMatch(summary, (long long) stats.min + v, (long long) stats.min + v)) return true;
+    return false;
+  }
+
+  if (stats.flags & STATS_HAS_HIST) {
+    for (int b = 0; b < statsBins(stats.min, stats.max); b++) {
+      if (stats.hist[b] == 0) continue;
+      int lo, hi;
+      statsBinRange(b, stats.min, stats.max, lo, hi);
+      if (joinSummaryMayMatch(summary, lo, hi)) return true;
+    }
+    return false;
+  }
+
+  return true;
+}
+
+//summaries shared by the queries of a CacheManager, keyed by QueryOptimizer::joinSummaryKey. dimensions are read
+//only, so entries never go stale; past JOIN_SUMMARY_CACHE entries the least recently used one is dropped. a
+//lookup copies the summary out (at most 65 words of bitmap), so an eviction never frees one a query still reads
+class JoinSummaryCache {
+public:
+  std::map<std::string, std::pair<joinSummary, std::list<std::string>::iterator>> entries;
+  std::list<std::string> lru; //most recently used first
+  std::mutex lock;
+  size_t capacity; //entries
+  unsigned long long hits, misses, evictions;
+
+  JoinSummaryCache(size_t _capacity = JOIN_SUMMARY_CACHE)
+    : capacity(_capacity), hits(0), misses(0), evictions(0) {}
+
+  bool lookup(const std::string& key, joinSummary& summary) {
+    std::lock_guard<std::mutex> guard(lock);
+    auto it = entries.find(key);
+    if (it == entries.end()) {
+      misses++;
+      return false;
+    }
+    lru.splice(lru.begin(), lru, it->second.second);
+    summary = it->second.first;
+    hits++;
+    return true;
+  }
+
+  //a concurrent query may have built the same summary, the first one stays
+  void insert(const std::string& key, const joinSummary& summary) {
+    std::lock_guard<std::mutex> guard(lock);
+    if (entries.find(key) != entries.end()) return;
+    lru.push_front(key);
+    entries[key] = std::make_pair(summary, lru.begin());
+    while (entries.size() > capacity) {
+      entries.erase(lru.back());
+      lru.pop_back();
+      evictions++;
+    }
+  }
+};
+
+#endif
@@ -7,6 +7,8 @@
 // #define ITEMS_PER_T 4
 
 class ColumnInfo;
+struct packedColumn;
+struct slicedColumn;
 
 template<typename T>
 using group_func_t = T (*) (T, T);
@@ -113,6 +115,7 @@ public:
 
   map<ColumnInfo*, int*> ht_CPU;
   map<ColumnInfo*, int*> ht_GPU;
+  vector<map<ColumnInfo*, int*>> ht_CPU_replica; //ht_CPU copied to every numa node, empty without numa placement
 
   map<ColumnInfo*, int> compare1;
   map<ColumnInfo*, int> compare2;
@@ -298,6 +301,11 @@ typedef struct filterArgsCPU {
 	filter_func_t_host<int> h_filter_func1;
 	filter_func_t_host<int> h_filter_func2;
 
+	struct packedColumn* filter_pack1; //bit packed filter_col1 (SegmentPack.h), NULL to scan the raw column
+	struct packedColumn* filter_pack2;
+	struct slicedColumn* filter_slice1; //bit sliced filter_col1 (SegmentSlice.h), NULL when the column has none
+	struct slicedColumn* filter_slice2;
+
 	// filterArgsCPU()
 	// : filter_col1(NULL), filter_col2(NULL), compare1(0), compare2(0), compare3(0), compare4(0),
 	// mode1(0), mode2(0) {}
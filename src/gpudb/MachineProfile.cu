@@ -0,0 +1,231 @@
+#include "MachineProfile.h"
+#include "DeviceBackend.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <immintrin.h>
+#include "tbb/tbb.h"
+
+using namespace std;
+using namespace tbb;
+
+machineProfile&
+machine() {
+	static machineProfile profile = {BW_CPU, BW_CPU, BW_PCI, CACHE_LINE, 32 << 10, 1 << 20, 32 << 20, {}, false};
+	return profile;
+}
+
+double
+probeTime(double ht_bytes) {
+	machineProfile& profile = machine();
+	vector<pair<double, double>>& probe = profile.probe;
+	if (probe.empty()) return profile.cache_line / profile.bw_cpu;
+	if (ht_bytes <= probe.front().first) return probe.front().second;
+	if (ht_bytes >= probe.back().first) return probe.back().second;
+
+	//linear in the log of the size between the two measured sizes around it
+	int i = 1;
+	while (probe[i].first < ht_bytes) i++;
+	double w = (log(ht_bytes) - log(probe[i - 1].first)) / (log(probe[i].first) - log(probe[i - 1].first));
+	return probe[i - 1].second + w * (probe[i].second - probe[i - 1].second);
+}
+
+bool
+loadMachineProfile(string filename) {
+	ifstream in(filename.c_str());
+	if (!in) return false;
+
+	machineProfile profile = machine();
+	profile.probe.clear();
+	string line;
+	while (getline(in, line)) {
+		size_t comment = line.find('#');
+		if (comment != string::npos) line = line.substr(0, comment);
+		istringstream fields(line);
+		string key;
+		if (!(fields >> key)) continue;
+		if (key == "bw_cpu") fields >> profile.bw_cpu;
+		else if (key == "bw_write") fields >> profile.bw_write;
+		else if (key == "bw_pci") fields >> profile.bw_pci;
+		else if (key == "cache_line") fields >> profile.cache_line;
+		else if (key == "l1") fields >> profile.l1;
+		else if (key == "l2") fields >> profile.l2;
+		else if (key == "llc") fields >> profile.llc;
+		else if (key == "probe") {
+			pair<double, double> point;
+			if (fields >> point.first >> point.second) profile.probe.push_back(point);
+		}
+	}
+	if (profile.bw_cpu <= 0 || profile.bw_write <= 0 || profile.bw_pci <= 0 || profile.cache_line <= 0) {
+		fprintf(stderr, "Machine profile %s has no usable bandwidths\n", filename.c_str());
+		return false;
+	}
+	sort(profile.probe.begin(), profile.probe.end());
+	profile.calibrated = true;
+	machine() = profile;
+	return true;
+}
+
+bool
+saveMachineProfile(string filename) {
+	FILE* fptr = fopen(filename.c_str(), "w");
+	if (fptr == NULL) return false;
+	machineProfile& profile = machine();
+	fprintf(fptr, "# machine profile of the cost model, bandwidths in bytes per ms\n");
+	fprintf(fptr, "bw_cpu %.0f\nbw_write %.0f\nbw_pci %.0f\n", profile.bw_cpu, profile.bw_write, profile.bw_pci);
+	fprintf(fptr, "cache_line %d\nl1 %ld\nl2 %ld\nllc %ld\n", profile.cache_line, profile.l1, profile.l2, profile.llc);
+	fprintf(fptr, "# probe <hash table bytes> <ms per probe over all cores>\n");
+	for (int i = 0; i < profile.probe.size(); i++) fprintf(fptr, "probe %.0f %.9g\n", profile.probe[i].first, profile.probe[i].second);
+	fclose(fptr);
+	return true;
+}
+
+//the microbenchmarks follow src/cpu/bandwidth.cpp: every core works on blocks of the input, the best of the trials counts
+
+static volatile long long sink; //keeps the reductions from being optimized away
+
+static double
+elapsedMs(chrono::high_resolution_clock::time_point start) {
+	chrono::duration<double, milli> diff = chrono::high_resolution_clock::now() - start;
+	return diff.count();
+}
+
+static double
+readBandwidth(int* buf, size_t num_items, int num_trials) {
+	double best = 0;
+	for (int t = 0; t < num_trials; t++) {
+		chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+		long long sum = parallel_reduce(blocked_range<size_t>(0, num_items, 1 << 20), 0LL,
+			[&](const blocked_range<size_t>& r, long long init) {
+				for (size_t i = r.begin(); i < r.end(); i++) init += buf[i];
+				return init;
+			},
+			[](long long x, long long y) { return x + y; });
+		double ms = elapsedMs(start);
+		sink = sum;
+		best = max(best, num_items * sizeof(int) / ms);
+	}
+	return best;
+}
+
+static double
+writeBandwidth(int* buf, size_t num_items, int num_trials) {
+	double best = 0;
+	for (int t = 0; t < num_trials; t++) {
+		chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+		parallel_for(blocked_range<size_t>(0, num_items / 4, 1 << 18), [&](const blocked_range<size_t>& r) {
+			__m128i value = _mm_set1_epi32(t);
+			for (size_t i = r.begin(); i < r.end(); i++) _mm_stream_si128((__m128i*) &buf[i * 4], value);
+		});
+		_mm_sfence();
+		best = max(best, num_items * sizeof(int) / elapsedMs(start));
+	}
+	return best;
+}
+
+//hash table of ht_bytes laid out like the engine's (key, value) slots, probed at random slots
+static double
+probeLatency(double ht_bytes, int* slot, size_t num_probes, int num_trials) {
+	size_t num_slots = max((size_t) 1, (size_t) (ht_bytes / (2 * sizeof(int))));
+	int* ht = (int*) aligned_alloc(64, ((num_slots * 2 * sizeof(int) + 63) / 64) * 64);
+	for (size_t i = 0; i < num_slots; i++) {
+		ht[i * 2] = (i & 1) ? (int) i + 1 : 0;
+		ht[i * 2 + 1] = (int) i;
+	}
+
+	double best = 0;
+	for (int t = 0; t < num_trials; t++) {
+		chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+		long long sum = parallel_reduce(blocked_range<size_t>(0, num_probes, 1 << 16), 0LL,
+			[&](const blocked_range<size_t>& r, long long init) {
+				for (size_t i = r.begin(); i < r.end(); i++) {
+					size_t s = (unsigned int) slot[i] % num_slots;
+					if (ht[s * 2] != 0) init += ht[s * 2 + 1];
+				}
+				return init;
+			},
+			[](long long x, long long y) { return x + y; });
+		double ms = elapsedMs(start);
+		sink = sum;
+		best = (t == 0) ? ms : min(best, ms);
+	}
+	free(ht);
+	return best / num_probes;
+}
+
+static double
+transferBandwidth(size_t bytes, int num_trials) {
+	void *h_buf, *d_buf;
+	if (deviceHostAlloc(&h_buf, bytes, cudaHostAllocDefault) != cudaSuccess) return 0;
+	if (deviceMalloc(&d_buf, bytes) != cudaSuccess) {
+		deviceFreeHost(h_buf);
+		return 0;
+	}
+	memset(h_buf, 1, bytes);
+
+	double best = 0;
+	for (int t = 0; t < num_trials; t++) {
+		deviceSynchronize();
+		chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+		deviceMemcpy(d_buf, h_buf, bytes, cudaMemcpyHostToDevice);
+		deviceSynchronize();
+		best = max(best, bytes / elapsedMs(start));
+	}
+	deviceFree(d_buf);
+	deviceFreeHost(h_buf);
+	return best;
+}
+
+void
+calibrateMachine(bool quick, bool verbose) {
+	machineProfile profile = machine();
+	int num_trials = 3;
+	size_t num_items = quick ? (1 << 25) : (1 << 28);
+	size_t num_probes = quick ? (1 << 22) : (1 << 25);
+
+	long l1 = sysconf(_SC_LEVEL1_DCACHE_SIZE), l2 = sysconf(_SC_LEVEL2_CACHE_SIZE), llc = sysconf(_SC_LEVEL3_CACHE_SIZE);
+	long line = sysconf(_SC_LEVEL1_DCACHE_LINESIZE);
+	if (l1 > 0) profile.l1 = l1;
+	if (l2 > 0) profile.l2 = l2;
+	if (llc > 0) profile.llc = llc;
+	if (line > 0) profile.cache_line = line;
+
+	int* buf = (int*) aligned_alloc(64, num_items * sizeof(int));
+	parallel_for(blocked_range<size_t>(0, num_items, 1 << 20), [&](const blocked_range<size_t>& r) {
+		for (size_t i = r.begin(); i < r.end(); i++) buf[i] = i & 15;
+	});
+	profile.bw_cpu = readBandwidth(buf, num_items, num_trials);
+	profile.bw_write = writeBandwidth(buf, num_items, num_trials);
+	free(buf);
+	if (verbose) printf("read %.2f GB/s, streaming write %.2f GB/s\n", profile.bw_cpu / 1e6, profile.bw_write / 1e6);
+
+	//probe sizes around every cache level, up to 32x the last level cache
+	int* slot = new int[num_probes];
+	mt19937 gen(7);
+	for (size_t i = 0; i < num_probes; i++) slot[i] = gen();
+	double sizes[] = {profile.l1 / 2.0, profile.l2 / 2.0, profile.l2 * 2.0, profile.llc / 2.0, profile.llc * 2.0, profile.llc * 8.0, profile.llc * 32.0};
+	profile.probe.clear();
+	for (double bytes : sizes) {
+		if (quick && bytes > profile.llc * 8.0) break;
+		if (!profile.probe.empty() && bytes <= profile.probe.back().first) continue;
+		double ms = probeLatency(bytes, slot, num_probes, num_trials);
+		profile.probe.push_back(make_pair(bytes, ms));
+		if (verbose) printf("probe %.1f MB: %.3f ns per probe\n", bytes / 1048576, ms * 1e6);
+	}
+	delete[] slot;
+
+	double pci = transferBandwidth(quick ? (16 << 20) : (256 << 20), num_trials);
+	if (pci > 0) profile.bw_pci = pci;
+	if (verbose) printf("host to device %.2f GB/s\n", profile.bw_pci / 1e6);
+
+	profile.calibrated = true;
+	machine() = profile;
+}
@@ -0,0 +1,37 @@
+#ifndef _MACHINE_PROFILE_H_
+#define _MACHINE_PROFILE_H_
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#define CACHE_LINE 64
+#define BW_CPU 42000000 //bytes per ms
+#define BW_PCI 12000000 //bytes per ms
+
+//the bandwidths CostModel prices the operators with. the defaults are the constants above; calibrateMachine
+//measures them on the running machine (bin/gpudb/calibrate offline, --calibrate in main at startup) and
+//saveMachineProfile keeps them in a profile that later runs load with --profile or MORDRED_PROFILE
+typedef struct machineProfile {
+	double bw_cpu; //sequential read over all cores, bytes per ms
+	double bw_write; //streaming write over all cores
+	double bw_pci; //host to device copies of the device backend
+	int cache_line;
+	long l1, l2, llc; //data cache sizes in bytes
+	std::vector<std::pair<double, double>> probe; //hash table bytes and ms per random probe over all cores, by bytes
+	bool calibrated;
+} machineProfile;
+
+machineProfile& machine();
+
+//ms per random probe (or group by update) into a table of ht_bytes, one cache line from memory without a profile
+double probeTime(double ht_bytes);
+
+bool loadMachineProfile(std::string filename);
+
+bool saveMachineProfile(std::string filename);
+
+//runs the microbenchmarks and replaces machine(), quick uses smaller inputs for a startup calibration
+void calibrateMachine(bool quick = false, bool verbose = false);
+
+#endif
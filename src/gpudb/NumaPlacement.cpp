@@ -0,0 +1,128 @@
+#include "NumaPlacement.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <pthread.h>
+#include <atomic>
+#include "tbb/task_scheduler_observer.h"
+#include "../cpu/joins/cpu_mapping.h"
+
+static bool numa_inited = false;
+static thread_local int worker_node = -1;
+
+numaOptions&
+numaPlacement() {
+  static numaOptions options = {false, false, true, true};
+  return options;
+}
+
+int
+numaNodes() {
+  return get_num_numa_regions();
+}
+
+bool
+numaActive() {
+  return numaPlacement().enable && numaNodes() > 1;
+}
+
+int
+numaNodeCPUs(int node) {
+  return thrpernuma;
+}
+
+void
+numaPinThread(int node, int k) {
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(numa[node][k % thrpernuma], &set);
+  pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &set);
+  worker_node = node;
+}
+
+int
+numaCurrentNode() {
+  if (worker_node >= 0) return worker_node;
+  if (!numa_inited) return 0;
+  int cpu = sched_getcpu();
+  for (int node = 0; node < numnodes; node++) {
+    for (int k = 0; k < thrpernuma; k++) {
+      if (numa[node][k] == cpu) return node;
+    }
+  }
+  return 0;
+}
+
+//k-th thread entering the scheduler goes to node k % nodes, so any number of workers is balanced over the sockets
+class numaWorkerPinning : public tbb::task_scheduler_observer {
+public:
+  std::atomic<int> entered;
+
+  numaWorkerPinning() : entered(0) {}
+
+  void on_scheduler_entry(bool is_worker) {
+    int k = entered.fetch_add(1);
+    int node = k % numnodes;
+    numaPinThread(node, k / numnodes);
+  }
+};
+
+void
+numaInit() {
+  if (numa_inited) return;
+  numa_inited = true;
+
+  cpu_mapping_init();
+  if (!numaActive()) return;
+
+  if (numaPlacement().pin_workers) {
+    static numaWorkerPinning pinning;
+    pinning.observe(true);
+  }
+}
+
+int
+numaSegmentNode(int segment_idx, int total_segment) {
+  int nodes = numaNodes();
+  if (nodes <= 1 || total_segment <= 0) return 0;
+  if (numaPlacement().partition) return (int) ((long long) segment_idx * nodes / total_segment);
+  return segment_idx % nodes;
+}
+
+void*
+numaAllocInterleaved(size_t bytes) {
+#ifdef HAVE_NUMA
+  if (numaActive()) return numa_alloc_interleaved(bytes);
+#endif
+  return malloc(bytes);
+}
+
+void*
+numaAllocOnNode(size_t bytes, int node) {
+#ifdef HAVE_NUMA
+  if (numaActive()) return numa_alloc_onnode(bytes, node);
+#endif
+  return malloc(bytes);
+}
+
+void
+numaFree(void* ptr, size_t bytes) {
+  if (ptr == NULL) return;
+#ifdef HAVE_NUMA
+  if (numaActive()) {
+    numa_free(ptr, bytes);
+    return;
+  }
+#endif
+  free(ptr);
+}
+
+void
+numaPlaceSegments(void* base, size_t segment_bytes, int total_segment) {
+#ifdef HAVE_NUMA
+  if (!numaActive()) return;
+  for (int s = 0; s < total_segment; s++)
+    numa_tonode_memory((char*) base + s * segment_bytes, segment_bytes, numaSegmentNode(s, total_segment));
+#endif
+}
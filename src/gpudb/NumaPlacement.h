@@ -0,0 +1,45 @@
+#ifndef _NUMA_PLACEMENT_H_
+#define _NUMA_PLACEMENT_H_
+
+#include <stddef.h>
+
+//host memory placement on multi socket machines, built with HAVE_NUMA (make NUMA=1, needs libnuma).
+//lineorder segments get a home node from their segment id, cpu hash tables get one replica per node
+//and tbb workers are pinned to the cpus of one node, so a segment is scanned by the node holding it.
+//without HAVE_NUMA or on a single node every call falls back to plain allocation
+
+typedef struct numaOptions {
+  bool enable;
+  bool partition; //segment s of a fact column on node s * nodes / total_segment, interleaved (s % nodes) otherwise
+  bool replicate_ht; //one copy of every cpu hash table per node
+  bool pin_workers; //every tbb worker pinned to one cpu, workers spread round robin over the nodes
+} numaOptions;
+
+numaOptions& numaPlacement();
+
+//reads the topology and installs the worker pinning, after the options are set and before any column is loaded
+void numaInit();
+
+int numaNodes();
+
+//placement is on and there is more than one node
+bool numaActive();
+
+//node of the calling thread, the pinned node for tbb workers
+int numaCurrentNode();
+
+int numaSegmentNode(int segment_idx, int total_segment);
+
+int numaNodeCPUs(int node);
+
+//pin the calling thread to the k-th cpu of node
+void numaPinThread(int node, int k);
+
+void* numaAllocInterleaved(size_t bytes);
+void* numaAllocOnNode(size_t bytes, int node);
+void numaFree(void* ptr, size_t bytes);
+
+//bind every segment of [base, base + total_segment * segment_bytes) to its home node, before the pages are touched
+void numaPlaceSegments(void* base, size_t segment_bytes, int total_segment);
+
+#endif
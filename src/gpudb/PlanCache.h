@@ -0,0 +1,139 @@
+#ifndef _PLAN_CACHE_H_
+#define _PLAN_CACHE_H_
+
+#include "common.h"
+
+#define PLAN_EXPLORE_EVERY 16 //every n-th decision on a key runs its least tried variant instead of the best one
+#define PLAN_DECAY 0.3 //weight of the newest runtime in the moving average of a variant
+#define PLAN_MAX_KEYS 65536 //the cache starts over when it holds more keys than this
+
+//execution strategies a query can run with, one per processQuery* of QueryProcessing
+enum PlanVariant {
+  PlanRunQuery, //processQuery
+  PlanRunQuery2, //processQuery2
+  PlanEMat, //processQueryEMat
+  PlanNP, //processQueryNP
+  PlanHE, //processQueryHE
+  PlanVariantCount
+};
+
+inline const char* planVariantName(PlanVariant variant) {
+  static const char* name[] = {"runQuery", "runQuery2", "EMat", "NP", "HE"};
+  return name[variant];
+}
+
+//EMat, NP and HE run the non pipelined and segment level paths, which only exist as CUDA kernels
+inline bool planVariantNeedsDevice(PlanVariant variant) {
+  return variant == PlanEMat || variant == PlanNP || variant == PlanHE;
+}
+
+typedef struct planStats {
+  int runs[PlanVariantCount];
+  double time[PlanVariantCount]; //moving average of the observed runtime in ms
+  int decisions;
+} planStats;
+
+//picks the strategy of a query before it runs from the runtimes observed so far, instead of running every
+//strategy and keeping the fastest. keys are (query, gpu residency of its columns, predicate ranges), see
+//QueryProcessing::planKey. a key where not every variant has run yet falls back to the averages of its query
+class PlanCache {
+public:
+  bool enabled[PlanVariantCount];
+  map<string, planStats> stats;
+  map<int, planStats> query_stats;
+
+  int decisions, explored;
+
+  PlanCache() : decisions(0), explored(0) {
+    for (int v = 0; v < PlanVariantCount; v++) enabled[v] = (v == PlanRunQuery || v == PlanRunQuery2);
+  }
+
+  //enables exactly the variants named in the comma separated list. false with error set for an unknown
+  //name, or a variant that needs a CUDA device on the emulated one, the other names are still enabled.
+  //a list without a usable name keeps the current variants
+  bool
+  enableVariants(string list, string& error) {
+    bool ok = true;
+    bool wanted[PlanVariantCount] = {};
+    int count = 0;
+    stringstream names(list);
+    string name;
+    while (getline(names, name, ',')) {
+      if (name.empty()) continue;
+      int v = 0;
+      while (v < PlanVariantCount && name.compare(planVariantName((PlanVariant) v)) != 0) v++;
+      if (v == PlanVariantCount) {
+        error = "Unknown plan variant " + name;
+        ok = false;
+      } else if (deviceIsHost() && planVariantNeedsDevice((PlanVariant) v)) {
+        error = "Plan variant " + name + " needs a CUDA device";
+        ok = false;
+      } else if (!wanted[v]) {
+        wanted[v] = true;
+        count++;
+      }
+    }
+    if (count == 0) return false;
+    for (int v = 0; v < PlanVariantCount; v++) enabled[v] = wanted[v];
+    return ok;
+  }
+
+  void clear() {
+    stats.clear();
+    query_stats.clear();
+    decisions = 0;
+    explored = 0;
+  }
+
+  bool complete(planStats& entry) {
+    for (int v = 0; v < PlanVariantCount; v++)
+      if (enabled[v] && entry.runs[v] == 0) return false;
+    return true;
+  }
+
+  PlanVariant
+  choose(int query, string key) {
+    if (stats.size() >= PLAN_MAX_KEYS) stats.clear();
+
+    planStats& entry = stats[key];
+    planStats& tmpl = query_stats[query];
+    entry.decisions++;
+    decisions++;
+
+    //every variant runs once per query before any of them is trusted
+    for (int v = 0; v < PlanVariantCount; v++)
+      if (enabled[v] && tmpl.runs[v] == 0) return (PlanVariant) v;
+
+    //periodic exploration keeps the averages of the losing variants fresh as the cache content changes
+    if (entry.decisions % PLAN_EXPLORE_EVERY == 0) {
+      int least = -1;
+      for (int v = 0; v < PlanVariantCount; v++) {
+        if (!enabled[v]) continue;
+        if (least < 0 || entry.runs[v] < entry.runs[least] || (entry.runs[v] == entry.runs[least] && tmpl.runs[v] < tmpl.runs[least])) least = v;
+      }
+      explored++;
+      return (PlanVariant) least;
+    }
+
+    planStats& use = complete(entry) ? entry : tmpl;
+    int best = -1;
+    for (int v = 0; v < PlanVariantCount; v++) {
+      if (!enabled[v] || use.runs[v] == 0) continue;
+      if (best < 0 || use.time[v] < use.time[best]) best = v;
+    }
+    return (PlanVariant) best;
+  }
+
+  void
+  record(int query, string key, PlanVariant variant, double time) {
+    planStats* entries[2] = {&stats[key], &query_stats[query]};
+    for (int i = 0; i < 2; i++) {
+      planStats& entry = *entries[i];
+      if (entry.runs[variant] == 0) entry.time[variant] = time;
+      else entry.time[variant] = (1 - PLAN_DECAY) * entry.time[variant] + PLAN_DECAY * time;
+      entry.runs[variant]++;
+    }
+  }
+};
+
+#endif
@@ -0,0 +1,248 @@
+#ifndef _PROCESSING_ARENA_H_
+#define _PROCESSING_ARENA_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+//allocator for the per query intermediates (offsets, hash tables, results) in one of the processing regions of
+//CacheManager. the region is cut into chunks that are handed to an ArenaContext (a query or a pipeline) and come
+//back when the context is released, so contexts can be released in any order and several of them can allocate
+//at the same time. small allocations come from a chunk owned by the calling thread's slot in the context and take
+//no shared atomic, large ones take a run of whole chunks. when the region has no free run left the allocation
+//spills to the fallback allocator of the arena and is freed with the context
+
+#define ARENA_CHUNK (1 << 17) //words (uint64_t) per chunk, 1 MB
+#define ARENA_THREAD_SLOTS 64 //chunk slots per context, threads share a slot beyond this
+#define ARENA_SMALL_DIV 8 //allocations up to chunk / ARENA_SMALL_DIV words come from the slot chunk
+
+typedef void* (*arenaSpillAlloc)(size_t bytes);
+typedef void (*arenaSpillFree)(void* ptr, size_t bytes);
+
+//slot of the calling thread, fixed for the lifetime of the thread
+inline int arenaThreadSlot() {
+	static std::atomic<int> next(0);
+	static thread_local int slot = next.fetch_add(1, std::memory_order_relaxed) % ARENA_THREAD_SLOTS;
+	return slot;
+}
+
+typedef struct arenaStats {
+	size_t capacity; //words
+	size_t in_use, peak; //words held by contexts in chunks, peak since the last resetStats
+	size_t context_peak; //most words a single context asked for
+	size_t spills, spill_words;
+} arenaStats;
+
+class ArenaContext;
+
+class ProcessingArena {
+public:
+	uint64_t* base;
+	size_t capacity; //words
+	size_t chunk_words;
+	int num_chunk;
+	std::vector<char> used;
+	int hint; //first chunk a single chunk search starts from
+	int free_chunk;
+	std::mutex lock;
+
+	arenaSpillAlloc spill_alloc;
+	arenaSpillFree spill_free;
+	const char* name;
+
+	arenaStats stats;
+
+	ProcessingArena(const char* _name, arenaSpillAlloc _spill_alloc, arenaSpillFree _spill_free)
+		: base(NULL), capacity(0), chunk_words(ARENA_CHUNK), num_chunk(0), hint(0), free_chunk(0),
+		spill_alloc(_spill_alloc), spill_free(_spill_free), name(_name) {
+		resetStats();
+	}
+
+	//the arena does not own the region, every context has to be released before it changes
+	void assign(uint64_t* _base, size_t _capacity) {
+		std::lock_guard<std::mutex> guard(lock);
+		base = _base;
+		capacity = _capacity;
+		chunk_words = ARENA_CHUNK;
+		//small regions still get a chunk for every slot
+		while (chunk_words > 64 && chunk_words * ARENA_THREAD_SLOTS > capacity) chunk_words /= 2;
+		num_chunk = capacity / chunk_words;
+		used.assign(num_chunk, 0);
+		hint = 0;
+		free_chunk = num_chunk;
+		stats.capacity = capacity;
+		stats.in_use = 0;
+	}
+
+	void resetStats() {
+		stats.capacity = capacity;
+		stats.in_use = (size_t) (num_chunk - free_chunk) * chunk_words;
+		stats.peak = stats.in_use;
+		stats.context_peak = 0;
+		stats.spills = 0;
+		stats.spill_words = 0;
+	}
+
+	//first chunk of a free run of count chunks, -1 when there is none
+	int takeChunks(int count) {
+		std::lock_guard<std::mutex> guard(lock);
+		if (count > free_chunk) return -1;
+		int start = -1;
+		for (int probe = 0, run = 0; probe < num_chunk; probe++) {
+			//a single chunk is searched from the hint around the region, a run from the front
+			int i = (count == 1) ? (hint + probe) % num_chunk : probe;
+			if (count > 1 && i + count - run > num_chunk) break;
+			run = used[i] ? 0 : run + 1;
+			if (run == count) {
+				start = i - count + 1;
+				break;
+			}
+		}
+		if (start < 0) return -1;
+		for (int i = start; i < start + count; i++) used[i] = 1;
+		free_chunk -= count;
+		if (count == 1) hint = (start + 1) % num_chunk;
+		stats.in_use = (size_t) (num_chunk - free_chunk) * chunk_words;
+		if (stats.in_use > stats.peak) stats.peak = stats.in_use;
+		return start;
+	}
+
+	void giveChunks(int start, int count) {
+		std::lock_guard<std::mutex> guard(lock);
+		for (int i = start; i < start + count; i++) used[i] = 0;
+		free_chunk += count;
+		stats.in_use = (size_t) (num_chunk - free_chunk) * chunk_words;
+	}
+
+	uint64_t* chunkPtr(int chunk) { return base + (size_t) chunk * chunk_words; }
+
+	void recordSpill(size_t words) {
+		std::lock_guard<std::mutex> guard(lock);
+		stats.spills++;
+		stats.spill_words += words;
+	}
+
+	void recordContext(size_t words) {
+		std::lock_guard<std::mutex> guard(lock);
+		if (words > stats.context_peak) stats.context_peak = words;
+	}
+
+	arenaStats snapshot() {
+		std::lock_guard<std::mutex> guard(lock);
+		return stats;
+	}
+};
+
+//one cache line per slot, so threads on neighbouring slots do not share a line
+typedef struct alignas(64) arenaSlot {
+	std::atomic_flag busy;
+	uint64_t* cur;
+	uint64_t* end;
+	size_t requested; //words handed out through this slot
+} arenaSlot;
+
+//allocations of one query or pipeline, all given back by release
+class ArenaContext {
+public:
+	ProcessingArena* arena;
+	arenaSlot slot[ARENA_THREAD_SLOTS];
+	std::mutex lock;
+	std::vector<std::pair<int, int>> chunks; //first chunk and length of every run taken from the arena
+	std::vector<std::pair<void*, size_t>> spilled; //fallback allocations and their size in bytes
+	size_t large_requested;
+
+	ArenaContext(ProcessingArena* _arena) : arena(_arena), large_requested(0) {
+		for (int i = 0; i < ARENA_THREAD_SLOTS; i++) {
+			slot[i].busy.clear();
+			slot[i].cur = NULL;
+			slot[i].end = NULL;
+			slot[i].requested = 0;
+		}
+	}
+
+	~ArenaContext() {
+		release();
+	}
+
+	//words taken from the region or the fallback, aborts when neither has room
+	uint64_t* allocate(size_t words) {
+		if (words == 0) words = 1;
+		if (words > arena->chunk_words / ARENA_SMALL_DIV) return allocateLarge(words);
+
+		arenaSlot& s = slot[arenaThreadSlot()];
+		while (s.busy.test_and_set(std::memory_order_acquire));
+		uint64_t* ptr = s.cur;
+		if (ptr == NULL || ptr + words > s.end) {
+			//a full region hands the slot a fallback chunk, small allocations keep going without a spill each
+			int chunk = arena->takeChunks(1);
+			if (chunk >= 0) {
+				addChunks(chunk, 1);
+				ptr = arena->chunkPtr(chunk);
+			} else {
+				ptr = spill(arena->chunk_words);
+			}
+			s.end = ptr + arena->chunk_words;
+		}
+		s.cur = ptr + words;
+		s.requested += words;
+		s.busy.clear(std::memory_order_release);
+		return ptr;
+	}
+
+	uint64_t* allocateLarge(size_t words) {
+		int count = (words + arena->chunk_words - 1) / arena->chunk_words;
+		int chunk = arena->takeChunks(count);
+		uint64_t* ptr = (chunk >= 0) ? arena->chunkPtr(chunk) : spill(words);
+		std::lock_guard<std::mutex> guard(lock);
+		if (chunk >= 0) chunks.push_back(std::make_pair(chunk, count));
+		large_requested += words;
+		return ptr;
+	}
+
+	void addChunks(int chunk, int count) {
+		std::lock_guard<std::mutex> guard(lock);
+		chunks.push_back(std::make_pair(chunk, count));
+	}
+
+	uint64_t* spill(size_t words) {
+		void* ptr = (arena->spill_alloc != NULL) ? arena->spill_alloc(words * sizeof(uint64_t)) : NULL;
+		if (ptr == NULL) {
+			fprintf(stderr, "%s processing memory exhausted (%zu words requested, %zu words in use)\n", arena->name, words, arena->snapshot().in_use);
+			exit(1);
+		}
+		arena->recordSpill(words);
+		std::lock_guard<std::mutex> guard(lock);
+		spilled.push_back(std::make_pair(ptr, words * sizeof(uint64_t)));
+		return (uint64_t*) ptr;
+	}
+
+	//words handed out since the last release
+	size_t requested() {
+		std::lock_guard<std::mutex> guard(lock);
+		size_t total = large_requested;
+		for (int i = 0; i < ARENA_THREAD_SLOTS; i++) total += slot[i].requested;
+		return total;
+	}
+
+	//gives every chunk and fallback allocation back, no allocation of the context may be running
+	void release() {
+		arena->recordContext(requested());
+		std::lock_guard<std::mutex> guard(lock);
+		for (int i = 0; i < chunks.size(); i++) arena->giveChunks(chunks[i].first, chunks[i].second);
+		for (int i = 0; i < spilled.size(); i++) arena->spill_free(spilled[i].first, spilled[i].second);
+		chunks.clear();
+		spilled.clear();
+		large_requested = 0;
+		for (int i = 0; i < ARENA_THREAD_SLOTS; i++) {
+			slot[i].cur = NULL;
+			slot[i].end = NULL;
+			slot[i].requested = 0;
+		}
+	}
+};
+
+#endif
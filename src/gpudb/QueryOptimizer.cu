@@ -3,11 +3,23 @@
 #include "CacheManager.h"
 #include "CPUGPUProcessing.h"
 
-QueryOptimizer::QueryOptimizer(size_t _cache_size, size_t _ondemand_size, size_t _processing_size, size_t _pinned_memsize, CPUGPUProcessing* _cgp) {
-	cm = new CacheManager(_cache_size, _ondemand_size, _processing_size, _pinned_memsize);
+bool join_skipping = true;
+
+QueryOptimizer::QueryOptimizer(size_t _cache_size, size_t _ondemand_size, size_t _processing_size, size_t _pinned_memsize, CPUGPUProcessing* _cgp)
+: QueryOptimizer(new CacheManager(_cache_size, _ondemand_size, _processing_size, _pinned_memsize), _cgp) {
+	owns_cm = true;
+}
+
+QueryOptimizer::QueryOptimizer(CacheManager* _cm, CPUGPUProcessing* _cgp) {
+	cm = _cm;
+	owns_cm = false;
 	cgp = _cgp;
 	custom = cgp->custom;
 	skipping = cgp->skipping;
+	cached_segment = 0;
+	aggregated_segment = 0;
+	join_skipped_segment = 0;
+	segment_cached = NULL;
 	fkey_pkey[cm->lo_orderdate] = cm->d_datekey;
 	fkey_pkey[cm->lo_partkey] = cm->p_partkey;
 	fkey_pkey[cm->lo_custkey] = cm->c_custkey;
@@ -62,7 +74,7 @@ QueryOptimizer::QueryOptimizer(size_t _cache_size, size_t _ondemand_size, size_t
 QueryOptimizer::~QueryOptimizer() {
 	fkey_pkey.clear();
 	pkey_fkey.clear();
-	delete cm;
+	if (owns_cm) delete cm;
 	delete params;
 }
 
@@ -124,7 +136,7 @@ void
 QueryOptimizer::clearPlacement() {
 
 	for (int i = 0; i < cm->TOT_TABLE; i++) {
-		CubDebugExit(cudaFreeHost(segment_group[i]));
+		CubDebugExit(deviceFreeHost(segment_group[i]));
 		free(segment_group_count[i]);
 		free(par_segment[i]);
 		free(joinGPU[i]);
@@ -1383,7 +1395,7 @@ QueryOptimizer::prepareOperatorPlacement() {
 	// segment_group_temp_count = (short**) malloc (cm->TOT_TABLE * sizeof(short*));
 	par_segment = (short**) malloc (cm->TOT_TABLE * sizeof(short*));
 	for (int i = 0; i < cm->TOT_TABLE; i++) {
-		CubDebugExit(cudaHostAlloc((void**) &(segment_group[i]), MAX_GROUPS * cm->lo_orderdate->total_segment * sizeof(short), cudaHostAllocDefault));
+		CubDebugExit(deviceHostAlloc((void**) &(segment_group[i]), MAX_GROUPS * cm->lo_orderdate->total_segment * sizeof(short), cudaHostAllocDefault));
 		segment_group_count[i] = (short*) malloc (MAX_GROUPS * sizeof(short));
 		par_segment[i] = (short*) malloc (MAX_GROUPS * sizeof(short));
 		joinGPU[i] = (bool*) malloc(MAX_GROUPS * sizeof(bool));
@@ -1393,7 +1405,7 @@ QueryOptimizer::prepareOperatorPlacement() {
 		memset(segment_group_count[i], 0, MAX_GROUPS * sizeof(short));
 		memset(par_segment[i], 0, MAX_GROUPS * sizeof(short));
 
-		// CubDebugExit(cudaHostAlloc((void**) &(segment_group_temp[i]), MAX_GROUPS * cm->lo_orderdate->total_segment * sizeof(short), cudaHostAllocDefault));
+		// CubDebugExit(deviceHostAlloc((void**) &(segment_group_temp[i]), MAX_GROUPS * cm->lo_orderdate->total_segment * sizeof(short), cudaHostAllocDefault));
 		// segment_group_temp_count[i] = (short*) malloc (MAX_GROUPS * sizeof(short));
 		// memset(segment_group_temp_count[i], 0, MAX_GROUPS * sizeof(short));
 	}
@@ -1482,7 +1494,7 @@ QueryOptimizer::prepareOperatorPlacementEMat() {
 	// segment_group_temp_count = (short**) malloc (cm->TOT_TABLE * sizeof(short*));
 	par_segment = (short**) malloc (cm->TOT_TABLE * sizeof(short*));
 	for (int i = 0; i < cm->TOT_TABLE; i++) {
-		CubDebugExit(cudaHostAlloc((void**) &(segment_group[i]), MAX_GROUPS * cm->lo_orderdate->total_segment * sizeof(short), cudaHostAllocDefault));
+		CubDebugExit(deviceHostAlloc((void**) &(segment_group[i]), MAX_GROUPS * cm->lo_orderdate->total_segment * sizeof(short), cudaHostAllocDefault));
 		segment_group_count[i] = (short*) malloc (MAX_GROUPS * sizeof(short));
 		par_segment[i] = (short*) malloc (MAX_GROUPS * sizeof(short));
 		joinGPU[i] = (bool*) malloc(MAX_GROUPS * sizeof(bool));
@@ -1584,7 +1596,7 @@ QueryOptimizer::prepareOperatorPlacementHE() {
 		memset(segment_group_count[i], 0, total_segment * sizeof(short));
 
 
-		CubDebugExit(cudaHostAlloc((void**) &(segment_group[i]), 2 * sizeof(short), cudaHostAllocDefault));
+		CubDebugExit(deviceHostAlloc((void**) &(segment_group[i]), 2 * sizeof(short), cudaHostAllocDefault));
 		par_segment[i] = (short*) malloc (2 * sizeof(short));
 		memset(par_segment[i], 0, 2 * sizeof(short));
 	}
@@ -1640,6 +1652,7 @@ QueryOptimizer::prepareOperatorPlacementHE() {
 bool
 QueryOptimizer::checkPredicate(int table_id, int segment_idx) {
 	assert(table_id <= cm->TOT_TABLE);
+	if (table_id == 0 && !join_skip.empty() && join_skip[segment_idx]) return false;
 	for (int i = 0; i < queryColumn[table_id].size(); i++) {
 		int column = queryColumn[table_id][i]->column_id;
 
@@ -1653,7 +1666,10 @@ QueryOptimizer::checkPredicate(int table_id, int segment_idx) {
 			// cout << cm->segment_min[column][segment_idx] << " " << cm->segment_max[column][segment_idx] << endl;
 			assert(cm->segment_min[column][segment_idx] <= cm->segment_max[column][segment_idx]);
 
-			if (compare2 < cm->segment_min[column][segment_idx] || compare1 > cm->segment_max[column][segment_idx]) {
+			if (cm->segment_stats[column] != NULL) {
+				int mode = (params->mode.find(cm->allColumn[column]) != params->mode.end()) ? params->mode[cm->allColumn[column]] : 1;
+				if (!segmentMayMatch(cm->segment_stats[column][segment_idx], mode, compare1, compare2)) return false;
+			} else if (compare2 < cm->segment_min[column][segment_idx] || compare1 > cm->segment_max[column][segment_idx]) {
 				return false;
 			}
 		}
@@ -1661,12 +1677,66 @@ QueryOptimizer::checkPredicate(int table_id, int segment_idx) {
 	return true;
 }
 
+//the dimension and its predicate, a summary is built once per key. the builds filter a dimension on its first
+//predicate only (see CPUGPUProcessing::call_bfilter_build_CPU), so the summary does the same: it then holds every
+//key the hash table will, and a segment it rules out finds no match in the probe either
+string
+QueryOptimizer::joinSummaryKey(ColumnInfo* pkey) {
+	ColumnInfo* filter = select_build[pkey][0];
+	return to_string(pkey->column_id) + "|" + to_string(filter->column_id) + ":" + to_string(params->mode[filter]) + "=" + to_string(params->compare1[filter]) + "-" + to_string(params->compare2[filter]);
+}
+
+//fills join_skip from the keys of the filtered dimensions. the fact segments are grouped before the dimensions
+//are built, so the qualifying keys come from a parallel scan of the host columns of the dimension instead of its
+//hash table. the summaries are kept in cm->join_summary for the later queries of every session
+void
+QueryOptimizer::checkJoinSummaries() {
+	join_skip.clear();
+	if (!join_skipping || !skipping) return;
+
+	vector<pair<ColumnInfo*, joinSummary>> summaries;
+	for (int i = 0; i < join.size(); i++) {
+		ColumnInfo* fkey = join[i].first;
+		ColumnInfo* pkey = join[i].second;
+		//only the predicate modes the builds evaluate, 1 and 2
+		if (select_build[pkey].empty() || params->compare1.find(select_build[pkey][0]) == params->compare1.end()) continue;
+		if (params->mode.find(select_build[pkey][0]) == params->mode.end()) continue;
+		int mode = params->mode[select_build[pkey][0]];
+		if (mode != 1 && mode != 2) continue;
+
+		string key = joinSummaryKey(pkey);
+		joinSummary summary;
+		if (!cm->join_summary->lookup(key, summary)) {
+			ColumnInfo* filter = select_build[pkey][0];
+			int* col = filter->col_ptr;
+			int lo = params->compare1[filter], hi = params->compare2[filter];
+			if (mode == 2) summary = buildJoinSummary(pkey->col_ptr, pkey->LEN, [&](int row) { return col[row] == lo || col[row] == hi; });
+			else summary = buildJoinSummary(pkey->col_ptr, pkey->LEN, [&](int row) { return col[row] >= lo && col[row] <= hi; });
+			cm->join_summary->insert(key, summary);
+		}
+		summaries.push_back(make_pair(fkey, summary));
+	}
+	if (summaries.empty()) return;
+
+	int total_segment = cm->lo_orderdate->total_segment;
+	join_skip.assign(total_segment, 0);
+	for (int i = 0; i < total_segment; i++) {
+		for (int k = 0; k < summaries.size() && !join_skip[i]; k++) {
+			int column = summaries[k].first->column_id;
+			if (cm->segment_stats[column] != NULL) join_skip[i] = !joinSegmentMayMatch(summaries[k].second, cm->segment_stats[column][i]);
+			else join_skip[i] = !joinSummaryMayMatch(summaries[k].second, cm->segment_min[column][i], cm->segment_max[column][i]);
+		}
+		if (join_skip[i]) join_skipped_segment += queryColumn[0].size();
+	}
+}
+
 void
 QueryOptimizer::updateSegmentStats(int table_id, int segment_idx, int query) {
  	for (int i = 0; i < queryColumn[table_id].size(); i++) {
 	    int column = queryColumn[table_id][i]->column_id;
 	    Segment* segment = cm->index_to_segment[column][segment_idx];
 	    cm->updateSegmentWeightDirect(cm->allColumn[column], segment, speedup[query][cm->allColumn[column]]);
+	    if (cm->trace != NULL) cm->trace->touch(column, segment_idx, speedup[query][cm->allColumn[column]], cm->segment_bitmap[column][segment_idx]);
 	}
 }
 
@@ -1692,7 +1762,9 @@ QueryOptimizer::groupBitmapSegmentTable(int table_id, int query, bool isprofile)
 
 		int count = segment_group_count[table_id][temp];
 
-		if (skipping) {
+		if (table_id == 0 && segment_cached != NULL && segment_cached[i]) {
+			cached_segment += queryColumn[table_id].size();
+		} else if (skipping) {
 			if (checkPredicate(table_id, i)) { //DISABLE SEGMENT SKIPPING
 				segment_group[table_id][temp * total_segment + count] = i;
 				segment_group_count[table_id][temp]++;
@@ -1700,6 +1772,7 @@ QueryOptimizer::groupBitmapSegmentTable(int table_id, int query, bool isprofile)
 				processed_segment += queryColumn[table_id].size();
 			} else {
 				skipped_segment += queryColumn[table_id].size();
+				if (!isprofile && cm->trace != NULL) cm->trace->skip(queryColumn[table_id].size());
 			}
 		} else {
 			segment_group[table_id][temp * total_segment + count] = i;
@@ -1934,6 +2007,7 @@ QueryOptimizer::groupBitmapSegmentTableEMat(int table_id, int query, bool isprof
 				processed_segment += queryColumn[table_id].size();
 			} else {
 				skipped_segment += queryColumn[table_id].size();
+				if (!isprofile && cm->trace != NULL) cm->trace->skip(queryColumn[table_id].size());
 			}
 		} else {
 			segment_group[table_id][temp * total_segment + count] = i;
@@ -2131,6 +2205,7 @@ QueryOptimizer::groupBitmapSegmentTableOD(int table_id, int query, bool isprofil
 				processed_segment += queryColumn[table_id].size();
 			} else {
 				skipped_segment += queryColumn[table_id].size();
+				if (!isprofile && cm->trace != NULL) cm->trace->skip(queryColumn[table_id].size());
 			}			
 		} else {
 			segment_group[table_id][temp * total_segment + count] = i;
@@ -2372,6 +2447,7 @@ QueryOptimizer::groupBitmapSegmentTableHE(int table_id, int query, bool isprofil
 				processed_segment += queryColumn[table_id].size();
 			} else {
 				skipped_segment += queryColumn[table_id].size();
+				if (!isprofile && cm->trace != NULL) cm->trace->skip(queryColumn[table_id].size());
 			}
 		} else {
 			// segment_group[table_id][i * total_segment + count] = i;
@@ -2596,9 +2672,9 @@ QueryOptimizer::prepareQuery(int query, Distribution dist) {
 				params->compare2[cm->lo_orderdate] = 19931231;
 			}
 
-			CubDebugExit(cudaMemcpyFromSymbol(&(params->map_filter_func_dev[cm->d_year]), p_pred_eq<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
-			CubDebugExit(cudaMemcpyFromSymbol(&(params->map_filter_func_dev[cm->lo_discount]), p_pred_between<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
-			CubDebugExit(cudaMemcpyFromSymbol(&(params->map_filter_func_dev[cm->lo_quantity]), p_pred_between<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
+			CubDebugExit(deviceMemcpyFromSymbol(&(params->map_filter_func_dev[cm->d_year]), p_pred_eq<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
+			CubDebugExit(deviceMemcpyFromSymbol(&(params->map_filter_func_dev[cm->lo_discount]), p_pred_between<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
+			CubDebugExit(deviceMemcpyFromSymbol(&(params->map_filter_func_dev[cm->lo_quantity]), p_pred_between<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
 
 			params->map_filter_func_host[cm->d_year] = &host_pred_eq;
 			params->map_filter_func_host[cm->lo_discount] = &host_pred_between;
@@ -2646,9 +2722,9 @@ QueryOptimizer::prepareQuery(int query, Distribution dist) {
 				params->compare2[cm->lo_orderdate] = 19940131;
 			}
 
-			CubDebugExit(cudaMemcpyFromSymbol(&(params->map_filter_func_dev[cm->d_yearmonthnum]), p_pred_eq<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
-			CubDebugExit(cudaMemcpyFromSymbol(&(params->map_filter_func_dev[cm->lo_discount]), p_pred_between<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
-			CubDebugExit(cudaMemcpyFromSymbol(&(params->map_filter_func_dev[cm->lo_quantity]), p_pred_between<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
+			CubDebugExit(deviceMemcpyFromSymbol(&(params->map_filter_func_dev[cm->d_yearmonthnum]), p_pred_eq<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
+			CubDebugExit(deviceMemcpyFromSymbol(&(params->map_filter_func_dev[cm->lo_discount]), p_pred_between<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
+			CubDebugExit(deviceMemcpyFromSymbol(&(params->map_filter_func_dev[cm->lo_quantity]), p_pred_between<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
 
 			params->map_filter_func_host[cm->d_yearmonthnum] = &host_pred_eq;
 			params->map_filter_func_host[cm->lo_discount] = &host_pred_between;
@@ -2696,16 +2772,16 @@ QueryOptimizer::prepareQuery(int query, Distribution dist) {
 				params->compare2[cm->lo_orderdate] = 19940210;
 			}
 
-			CubDebugExit(cudaMemcpyFromSymbol(&(params->map_filter_func_dev[cm->d_datekey]), p_pred_between<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
-			CubDebugExit(cudaMemcpyFromSymbol(&(params->map_filter_func_dev[cm->lo_discount]), p_pred_between<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
-			CubDebugExit(cudaMemcpyFromSymbol(&(params->map_filter_func_dev[cm->lo_quantity]), p_pred_between<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
+			CubDebugExit(deviceMemcpyFromSymbol(&(params->map_filter_func_dev[cm->d_datekey]), p_pred_between<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
+			CubDebugExit(deviceMemcpyFromSymbol(&(params->map_filter_func_dev[cm->lo_discount]), p_pred_between<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
+			CubDebugExit(deviceMemcpyFromSymbol(&(params->map_filter_func_dev[cm->lo_quantity]), p_pred_between<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
 
 			params->map_filter_func_host[cm->d_datekey] = &host_pred_between;
 			params->map_filter_func_host[cm->lo_discount] = &host_pred_between;
 			params->map_filter_func_host[cm->lo_quantity] = &host_pred_between;
 		}
 
-		CubDebugExit(cudaMemcpyFromSymbol(&(params->d_group_func), p_mul_func<int>, sizeof(group_func_t<int>)));
+		CubDebugExit(deviceMemcpyFromSymbol(&(params->d_group_func), p_mul_func<int>, sizeof(group_func_t<int>)));
 		params->h_group_func = &host_mul_func;
 
 		params->unique_val[cm->p_partkey] = 0;
@@ -2722,32 +2798,32 @@ QueryOptimizer::prepareQuery(int query, Distribution dist) {
 
 		float time;
 		SETUP_TIMING();
-		cudaEventRecord(start, 0);
+		deviceEventRecord(start, 0);
 
 		if (custom) {
 			params->ht_CPU[cm->p_partkey] = NULL;
 			params->ht_CPU[cm->c_custkey] = NULL;
 			params->ht_CPU[cm->s_suppkey] = NULL;
-			params->ht_CPU[cm->d_datekey] = (int*) cm->customMalloc<int>(2 * params->dim_len[cm->d_datekey]);	
+			params->ht_CPU[cm->d_datekey] = (int*) cm->customMalloc<int>(2 * params->dim_len[cm->d_datekey], cgp->scope);	
 		} else {
-			CubDebugExit(cudaHostAlloc((void**) &params->ht_CPU[cm->d_datekey], 2 * params->dim_len[cm->d_datekey] * sizeof(int), cudaHostAllocDefault));
+			CubDebugExit(deviceHostAlloc((void**) &params->ht_CPU[cm->d_datekey], 2 * params->dim_len[cm->d_datekey] * sizeof(int), cudaHostAllocDefault));
 		}
 
 		if (custom) {
 			params->ht_GPU[cm->p_partkey] = NULL;
 			params->ht_GPU[cm->s_suppkey] = NULL;
-			params->ht_GPU[cm->d_datekey] = (int*) cm->customCudaMalloc<int>(2 * params->dim_len[cm->d_datekey]);
+			params->ht_GPU[cm->d_datekey] = (int*) cm->customCudaMalloc<int>(2 * params->dim_len[cm->d_datekey], cgp->scope);
 			params->ht_GPU[cm->c_custkey] = NULL;
 		} else {
-			CubDebugExit(cudaMalloc((void**) &params->ht_GPU[cm->d_datekey], 2 * params->dim_len[cm->d_datekey] * sizeof(int)));			
+			CubDebugExit(deviceMalloc((void**) &params->ht_GPU[cm->d_datekey], 2 * params->dim_len[cm->d_datekey] * sizeof(int)));			
 		}
-		cudaEventRecord(stop, 0);
-	  cudaEventSynchronize(stop);
-	  cudaEventElapsedTime(&time, start, stop);
+		deviceEventRecord(stop, 0);
+	  deviceEventSynchronize(stop);
+	  deviceEventElapsedTime(&time, start, stop);
 	  cgp->malloc_time_total += time;		
 
 	  memset(params->ht_CPU[cm->d_datekey], 0, 2 * params->dim_len[cm->d_datekey] * sizeof(int));
-		CubDebugExit(cudaMemset(params->ht_GPU[cm->d_datekey], 0, 2 * params->dim_len[cm->d_datekey] * sizeof(int)));
+		CubDebugExit(deviceMemset(params->ht_GPU[cm->d_datekey], 0, 2 * params->dim_len[cm->d_datekey] * sizeof(int)));
 
 
 	} else if (query == 21 || query == 22 || query == 23) {
@@ -2796,8 +2872,8 @@ QueryOptimizer::prepareQuery(int query, Distribution dist) {
 				params->compare2[cm->lo_orderdate] = 19981231;
 			}
 
-			CubDebugExit(cudaMemcpyFromSymbol(&(params->map_filter_func_dev[cm->s_region]), p_pred_eq<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
-			CubDebugExit(cudaMemcpyFromSymbol(&(params->map_filter_func_dev[cm->p_category]), p_pred_eq<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
+			CubDebugExit(deviceMemcpyFromSymbol(&(params->map_filter_func_dev[cm->s_region]), p_pred_eq<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
+			CubDebugExit(deviceMemcpyFromSymbol(&(params->map_filter_func_dev[cm->p_category]), p_pred_eq<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
 
 			params->map_filter_func_host[cm->s_region] = &host_pred_eq;
 			params->map_filter_func_host[cm->p_category] = &host_pred_eq;
@@ -2846,8 +2922,8 @@ QueryOptimizer::prepareQuery(int query, Distribution dist) {
 				params->compare2[cm->lo_orderdate] = 19981231;
 			}
 
-			CubDebugExit(cudaMemcpyFromSymbol(&(params->map_filter_func_dev[cm->s_region]), p_pred_eq<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
-			CubDebugExit(cudaMemcpyFromSymbol(&(params->map_filter_func_dev[cm->p_brand1]), p_pred_between<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
+			CubDebugExit(deviceMemcpyFromSymbol(&(params->map_filter_func_dev[cm->s_region]), p_pred_eq<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
+			CubDebugExit(deviceMemcpyFromSymbol(&(params->map_filter_func_dev[cm->p_brand1]), p_pred_between<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
 
 			params->map_filter_func_host[cm->s_region] = &host_pred_eq;
 			params->map_filter_func_host[cm->p_brand1] = &host_pred_between;
@@ -2896,14 +2972,14 @@ QueryOptimizer::prepareQuery(int query, Distribution dist) {
 				params->compare2[cm->lo_orderdate] = 19981231;
 			}
 
-			CubDebugExit(cudaMemcpyFromSymbol(&(params->map_filter_func_dev[cm->s_region]), p_pred_eq<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
-			CubDebugExit(cudaMemcpyFromSymbol(&(params->map_filter_func_dev[cm->p_brand1]), p_pred_eq<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
+			CubDebugExit(deviceMemcpyFromSymbol(&(params->map_filter_func_dev[cm->s_region]), p_pred_eq<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
+			CubDebugExit(deviceMemcpyFromSymbol(&(params->map_filter_func_dev[cm->p_brand1]), p_pred_eq<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
 
 			params->map_filter_func_host[cm->s_region] = &host_pred_eq;
 			params->map_filter_func_host[cm->p_brand1] = &host_pred_eq;
 		}
 
-		CubDebugExit(cudaMemcpyFromSymbol(&(params->d_group_func), p_sub_func<int>, sizeof(group_func_t<int>)));
+		CubDebugExit(deviceMemcpyFromSymbol(&(params->d_group_func), p_sub_func<int>, sizeof(group_func_t<int>)));
 		params->h_group_func = &host_sub_func;
 
 		params->unique_val[cm->p_partkey] = 7;
@@ -2920,33 +2996,33 @@ QueryOptimizer::prepareQuery(int query, Distribution dist) {
 
 		float time;
 		SETUP_TIMING();
-		cudaEventRecord(start, 0);
+		deviceEventRecord(start, 0);
 
 		if (custom) {
-			params->ht_CPU[cm->p_partkey] = (int*) cm->customMalloc<int>(2 * params->dim_len[cm->p_partkey]);
+			params->ht_CPU[cm->p_partkey] = (int*) cm->customMalloc<int>(2 * params->dim_len[cm->p_partkey], cgp->scope);
 			params->ht_CPU[cm->c_custkey] = NULL;
-			params->ht_CPU[cm->s_suppkey] = (int*) cm->customMalloc<int>(2 * params->dim_len[cm->s_suppkey]);
-			params->ht_CPU[cm->d_datekey] = (int*) cm->customMalloc<int>(2 * params->dim_len[cm->d_datekey]);			
+			params->ht_CPU[cm->s_suppkey] = (int*) cm->customMalloc<int>(2 * params->dim_len[cm->s_suppkey], cgp->scope);
+			params->ht_CPU[cm->d_datekey] = (int*) cm->customMalloc<int>(2 * params->dim_len[cm->d_datekey], cgp->scope);			
 		} else {
-			CubDebugExit(cudaHostAlloc((void**) &params->ht_CPU[cm->p_partkey], 2 * params->dim_len[cm->p_partkey] * sizeof(int), cudaHostAllocDefault));
-			CubDebugExit(cudaHostAlloc((void**) &params->ht_CPU[cm->s_suppkey], 2 * params->dim_len[cm->s_suppkey] * sizeof(int), cudaHostAllocDefault));
-			CubDebugExit(cudaHostAlloc((void**) &params->ht_CPU[cm->d_datekey], 2 * params->dim_len[cm->d_datekey] * sizeof(int), cudaHostAllocDefault));	
+			CubDebugExit(deviceHostAlloc((void**) &params->ht_CPU[cm->p_partkey], 2 * params->dim_len[cm->p_partkey] * sizeof(int), cudaHostAllocDefault));
+			CubDebugExit(deviceHostAlloc((void**) &params->ht_CPU[cm->s_suppkey], 2 * params->dim_len[cm->s_suppkey] * sizeof(int), cudaHostAllocDefault));
+			CubDebugExit(deviceHostAlloc((void**) &params->ht_CPU[cm->d_datekey], 2 * params->dim_len[cm->d_datekey] * sizeof(int), cudaHostAllocDefault));	
 		}
 
 		if (custom) {
-			params->ht_GPU[cm->p_partkey] = (int*) cm->customCudaMalloc<int>(2 * params->dim_len[cm->p_partkey]);
-			params->ht_GPU[cm->s_suppkey] = (int*) cm->customCudaMalloc<int>(2 * params->dim_len[cm->s_suppkey]);
-			params->ht_GPU[cm->d_datekey] = (int*) cm->customCudaMalloc<int>(2 * params->dim_len[cm->d_datekey]);
+			params->ht_GPU[cm->p_partkey] = (int*) cm->customCudaMalloc<int>(2 * params->dim_len[cm->p_partkey], cgp->scope);
+			params->ht_GPU[cm->s_suppkey] = (int*) cm->customCudaMalloc<int>(2 * params->dim_len[cm->s_suppkey], cgp->scope);
+			params->ht_GPU[cm->d_datekey] = (int*) cm->customCudaMalloc<int>(2 * params->dim_len[cm->d_datekey], cgp->scope);
 			params->ht_GPU[cm->c_custkey] = NULL;			
 		} else {
-			CubDebugExit(cudaMalloc((void**) &params->ht_GPU[cm->p_partkey], 2 * params->dim_len[cm->p_partkey] * sizeof(int)));
-			CubDebugExit(cudaMalloc((void**) &params->ht_GPU[cm->s_suppkey], 2 * params->dim_len[cm->s_suppkey] * sizeof(int)));
-			CubDebugExit(cudaMalloc((void**) &params->ht_GPU[cm->d_datekey], 2 * params->dim_len[cm->d_datekey] * sizeof(int)));				
+			CubDebugExit(deviceMalloc((void**) &params->ht_GPU[cm->p_partkey], 2 * params->dim_len[cm->p_partkey] * sizeof(int)));
+			CubDebugExit(deviceMalloc((void**) &params->ht_GPU[cm->s_suppkey], 2 * params->dim_len[cm->s_suppkey] * sizeof(int)));
+			CubDebugExit(deviceMalloc((void**) &params->ht_GPU[cm->d_datekey], 2 * params->dim_len[cm->d_datekey] * sizeof(int)));				
 		}
 
-		cudaEventRecord(stop, 0);
-	  cudaEventSynchronize(stop);
-	  cudaEventElapsedTime(&time, start, stop);
+		deviceEventRecord(stop, 0);
+	  deviceEventSynchronize(stop);
+	  deviceEventElapsedTime(&time, start, stop);
 	  cgp->malloc_time_total += time;
 	  // cout << "malloc time: " << cgp->malloc_time_total << endl;
 
@@ -2954,9 +3030,9 @@ QueryOptimizer::prepareQuery(int query, Distribution dist) {
 		memset(params->ht_CPU[cm->p_partkey], 0, 2 * params->dim_len[cm->p_partkey] * sizeof(int));
 		memset(params->ht_CPU[cm->s_suppkey], 0, 2 * params->dim_len[cm->s_suppkey] * sizeof(int));	
 
-		CubDebugExit(cudaMemset(params->ht_GPU[cm->p_partkey], 0, 2 * params->dim_len[cm->p_partkey] * sizeof(int)));
-		CubDebugExit(cudaMemset(params->ht_GPU[cm->s_suppkey], 0, 2 * params->dim_len[cm->s_suppkey] * sizeof(int)));
-		CubDebugExit(cudaMemset(params->ht_GPU[cm->d_datekey], 0, 2 * params->dim_len[cm->d_datekey] * sizeof(int)));
+		CubDebugExit(deviceMemset(params->ht_GPU[cm->p_partkey], 0, 2 * params->dim_len[cm->p_partkey] * sizeof(int)));
+		CubDebugExit(deviceMemset(params->ht_GPU[cm->s_suppkey], 0, 2 * params->dim_len[cm->s_suppkey] * sizeof(int)));
+		CubDebugExit(deviceMemset(params->ht_GPU[cm->d_datekey], 0, 2 * params->dim_len[cm->d_datekey] * sizeof(int)));
 
 	} else if (query == 31 || query == 32 || query == 33 || query == 34) {
 
@@ -3013,9 +3089,9 @@ QueryOptimizer::prepareQuery(int query, Distribution dist) {
 
 			params->total_val = ((1998-1992+1) * 25 * 25);
 
-			CubDebugExit(cudaMemcpyFromSymbol(&(params->map_filter_func_dev[cm->c_region]), p_pred_eq<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
-			CubDebugExit(cudaMemcpyFromSymbol(&(params->map_filter_func_dev[cm->s_region]), p_pred_eq<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
-			CubDebugExit(cudaMemcpyFromSymbol(&(params->map_filter_func_dev[cm->d_year]), p_pred_between<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
+			CubDebugExit(deviceMemcpyFromSymbol(&(params->map_filter_func_dev[cm->c_region]), p_pred_eq<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
+			CubDebugExit(deviceMemcpyFromSymbol(&(params->map_filter_func_dev[cm->s_region]), p_pred_eq<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
+			CubDebugExit(deviceMemcpyFromSymbol(&(params->map_filter_func_dev[cm->d_year]), p_pred_between<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
 
 			params->map_filter_func_host[cm->c_region] = &host_pred_eq;
 			params->map_filter_func_host[cm->s_region] = &host_pred_eq;
@@ -3077,9 +3153,9 @@ QueryOptimizer::prepareQuery(int query, Distribution dist) {
 
 			params->total_val = ((1998-1992+1) * 250 * 250);
 
-			CubDebugExit(cudaMemcpyFromSymbol(&(params->map_filter_func_dev[cm->c_nation]), p_pred_eq<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
-			CubDebugExit(cudaMemcpyFromSymbol(&(params->map_filter_func_dev[cm->s_nation]), p_pred_eq<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
-			CubDebugExit(cudaMemcpyFromSymbol(&(params->map_filter_func_dev[cm->d_year]), p_pred_between<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
+			CubDebugExit(deviceMemcpyFromSymbol(&(params->map_filter_func_dev[cm->c_nation]), p_pred_eq<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
+			CubDebugExit(deviceMemcpyFromSymbol(&(params->map_filter_func_dev[cm->s_nation]), p_pred_eq<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
+			CubDebugExit(deviceMemcpyFromSymbol(&(params->map_filter_func_dev[cm->d_year]), p_pred_between<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
 
 			params->map_filter_func_host[cm->c_nation] = &host_pred_eq;
 			params->map_filter_func_host[cm->s_nation] = &host_pred_eq;
@@ -3141,9 +3217,9 @@ QueryOptimizer::prepareQuery(int query, Distribution dist) {
 
 			params->total_val = ((1998-1992+1) * 250 * 250);
 
-			CubDebugExit(cudaMemcpyFromSymbol(&(params->map_filter_func_dev[cm->c_city]), p_pred_eq_or_eq<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
-			CubDebugExit(cudaMemcpyFromSymbol(&(params->map_filter_func_dev[cm->s_city]), p_pred_eq_or_eq<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
-			CubDebugExit(cudaMemcpyFromSymbol(&(params->map_filter_func_dev[cm->d_year]), p_pred_between<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
+			CubDebugExit(deviceMemcpyFromSymbol(&(params->map_filter_func_dev[cm->c_city]), p_pred_eq_or_eq<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
+			CubDebugExit(deviceMemcpyFromSymbol(&(params->map_filter_func_dev[cm->s_city]), p_pred_eq_or_eq<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
+			CubDebugExit(deviceMemcpyFromSymbol(&(params->map_filter_func_dev[cm->d_year]), p_pred_between<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
 
 			params->map_filter_func_host[cm->c_city] = &host_pred_eq_or_eq;
 			params->map_filter_func_host[cm->s_city] = &host_pred_eq_or_eq;
@@ -3210,16 +3286,16 @@ QueryOptimizer::prepareQuery(int query, Distribution dist) {
 
 			params->total_val = ((1998-1992+1) * 250 * 250);
 
-			CubDebugExit(cudaMemcpyFromSymbol(&(params->map_filter_func_dev[cm->c_city]), p_pred_eq_or_eq<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
-			CubDebugExit(cudaMemcpyFromSymbol(&(params->map_filter_func_dev[cm->s_city]), p_pred_eq_or_eq<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
-			CubDebugExit(cudaMemcpyFromSymbol(&(params->map_filter_func_dev[cm->d_yearmonthnum]), p_pred_eq<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
+			CubDebugExit(deviceMemcpyFromSymbol(&(params->map_filter_func_dev[cm->c_city]), p_pred_eq_or_eq<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
+			CubDebugExit(deviceMemcpyFromSymbol(&(params->map_filter_func_dev[cm->s_city]), p_pred_eq_or_eq<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
+			CubDebugExit(deviceMemcpyFromSymbol(&(params->map_filter_func_dev[cm->d_yearmonthnum]), p_pred_eq<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
 
 			params->map_filter_func_host[cm->c_city] = &host_pred_eq_or_eq;
 			params->map_filter_func_host[cm->s_city] = &host_pred_eq_or_eq;
 			params->map_filter_func_host[cm->d_yearmonthnum] = &host_pred_eq;
 		}
 
-		CubDebugExit(cudaMemcpyFromSymbol(&(params->d_group_func), p_sub_func<int>, sizeof(group_func_t<int>)));
+		CubDebugExit(deviceMemcpyFromSymbol(&(params->d_group_func), p_sub_func<int>, sizeof(group_func_t<int>)));
 		params->h_group_func = &host_sub_func;
 
 		params->dim_len[cm->p_partkey] = 0;
@@ -3229,41 +3305,41 @@ QueryOptimizer::prepareQuery(int query, Distribution dist) {
 
 		float time;
 		SETUP_TIMING();
-		cudaEventRecord(start, 0);
+		deviceEventRecord(start, 0);
 
 		if (custom) {
 			params->ht_CPU[cm->p_partkey] = NULL;
-			params->ht_CPU[cm->c_custkey] = (int*) cm->customMalloc<int>(2 * params->dim_len[cm->c_custkey]);
-			params->ht_CPU[cm->s_suppkey] = (int*) cm->customMalloc<int>(2 * params->dim_len[cm->s_suppkey]);
-			params->ht_CPU[cm->d_datekey] = (int*) cm->customMalloc<int>(2 * params->dim_len[cm->d_datekey]);			
+			params->ht_CPU[cm->c_custkey] = (int*) cm->customMalloc<int>(2 * params->dim_len[cm->c_custkey], cgp->scope);
+			params->ht_CPU[cm->s_suppkey] = (int*) cm->customMalloc<int>(2 * params->dim_len[cm->s_suppkey], cgp->scope);
+			params->ht_CPU[cm->d_datekey] = (int*) cm->customMalloc<int>(2 * params->dim_len[cm->d_datekey], cgp->scope);			
 		} else {
-			CubDebugExit(cudaHostAlloc((void**) &params->ht_CPU[cm->c_custkey], 2 * params->dim_len[cm->c_custkey] * sizeof(int), cudaHostAllocDefault));
-			CubDebugExit(cudaHostAlloc((void**) &params->ht_CPU[cm->s_suppkey], 2 * params->dim_len[cm->s_suppkey] * sizeof(int), cudaHostAllocDefault));
-			CubDebugExit(cudaHostAlloc((void**) &params->ht_CPU[cm->d_datekey], 2 * params->dim_len[cm->d_datekey] * sizeof(int), cudaHostAllocDefault));			
+			CubDebugExit(deviceHostAlloc((void**) &params->ht_CPU[cm->c_custkey], 2 * params->dim_len[cm->c_custkey] * sizeof(int), cudaHostAllocDefault));
+			CubDebugExit(deviceHostAlloc((void**) &params->ht_CPU[cm->s_suppkey], 2 * params->dim_len[cm->s_suppkey] * sizeof(int), cudaHostAllocDefault));
+			CubDebugExit(deviceHostAlloc((void**) &params->ht_CPU[cm->d_datekey], 2 * params->dim_len[cm->d_datekey] * sizeof(int), cudaHostAllocDefault));			
 		}
 
 		if (custom) {
 			params->ht_GPU[cm->p_partkey] = NULL;
-			params->ht_GPU[cm->s_suppkey] = (int*) cm->customCudaMalloc<int>(2 * params->dim_len[cm->s_suppkey]);
-			params->ht_GPU[cm->d_datekey] = (int*) cm->customCudaMalloc<int>(2 * params->dim_len[cm->d_datekey]);
-			params->ht_GPU[cm->c_custkey] = (int*) cm->customCudaMalloc<int>(2 * params->dim_len[cm->c_custkey]);			
+			params->ht_GPU[cm->s_suppkey] = (int*) cm->customCudaMalloc<int>(2 * params->dim_len[cm->s_suppkey], cgp->scope);
+			params->ht_GPU[cm->d_datekey] = (int*) cm->customCudaMalloc<int>(2 * params->dim_len[cm->d_datekey], cgp->scope);
+			params->ht_GPU[cm->c_custkey] = (int*) cm->customCudaMalloc<int>(2 * params->dim_len[cm->c_custkey], cgp->scope);			
 		} else {
-			CubDebugExit(cudaMalloc((void**) &params->ht_GPU[cm->c_custkey], 2 * params->dim_len[cm->c_custkey] * sizeof(int)));
-			CubDebugExit(cudaMalloc((void**) &params->ht_GPU[cm->s_suppkey], 2 * params->dim_len[cm->s_suppkey] * sizeof(int)));
-			CubDebugExit(cudaMalloc((void**) &params->ht_GPU[cm->d_datekey], 2 * params->dim_len[cm->d_datekey] * sizeof(int)));					
+			CubDebugExit(deviceMalloc((void**) &params->ht_GPU[cm->c_custkey], 2 * params->dim_len[cm->c_custkey] * sizeof(int)));
+			CubDebugExit(deviceMalloc((void**) &params->ht_GPU[cm->s_suppkey], 2 * params->dim_len[cm->s_suppkey] * sizeof(int)));
+			CubDebugExit(deviceMalloc((void**) &params->ht_GPU[cm->d_datekey], 2 * params->dim_len[cm->d_datekey] * sizeof(int)));					
 		}
-		cudaEventRecord(stop, 0);
-	  cudaEventSynchronize(stop);
-	  cudaEventElapsedTime(&time, start, stop);
+		deviceEventRecord(stop, 0);
+	  deviceEventSynchronize(stop);
+	  deviceEventElapsedTime(&time, start, stop);
 	  cgp->malloc_time_total += time;		
 
 		memset(params->ht_CPU[cm->d_datekey], 0, 2 * params->dim_len[cm->d_datekey] * sizeof(int));
 		memset(params->ht_CPU[cm->s_suppkey], 0, 2 * params->dim_len[cm->s_suppkey] * sizeof(int));
 		memset(params->ht_CPU[cm->c_custkey], 0, 2 * params->dim_len[cm->c_custkey] * sizeof(int));
 
-		CubDebugExit(cudaMemset(params->ht_GPU[cm->s_suppkey], 0, 2 * params->dim_len[cm->s_suppkey] * sizeof(int)));
-		CubDebugExit(cudaMemset(params->ht_GPU[cm->d_datekey], 0, 2 * params->dim_len[cm->d_datekey] * sizeof(int)));
-		CubDebugExit(cudaMemset(params->ht_GPU[cm->c_custkey], 0, 2 * params->dim_len[cm->c_custkey] * sizeof(int)));
+		CubDebugExit(deviceMemset(params->ht_GPU[cm->s_suppkey], 0, 2 * params->dim_len[cm->s_suppkey] * sizeof(int)));
+		CubDebugExit(deviceMemset(params->ht_GPU[cm->d_datekey], 0, 2 * params->dim_len[cm->d_datekey] * sizeof(int)));
+		CubDebugExit(deviceMemset(params->ht_GPU[cm->c_custkey], 0, 2 * params->dim_len[cm->c_custkey] * sizeof(int)));
 
 	} else if (query == 41 || query == 42 || query == 43) {
 
@@ -3325,9 +3401,9 @@ QueryOptimizer::prepareQuery(int query, Distribution dist) {
 
 			params->total_val = ((1998-1992+1) * 25);
 
-			CubDebugExit(cudaMemcpyFromSymbol(&(params->map_filter_func_dev[cm->c_region]), p_pred_eq<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
-			CubDebugExit(cudaMemcpyFromSymbol(&(params->map_filter_func_dev[cm->s_region]), p_pred_eq<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
-			CubDebugExit(cudaMemcpyFromSymbol(&(params->map_filter_func_dev[cm->p_mfgr]), p_pred_between<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
+			CubDebugExit(deviceMemcpyFromSymbol(&(params->map_filter_func_dev[cm->c_region]), p_pred_eq<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
+			CubDebugExit(deviceMemcpyFromSymbol(&(params->map_filter_func_dev[cm->s_region]), p_pred_eq<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
+			CubDebugExit(deviceMemcpyFromSymbol(&(params->map_filter_func_dev[cm->p_mfgr]), p_pred_between<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
 
 			params->map_filter_func_host[cm->c_region] = &host_pred_eq;
 			params->map_filter_func_host[cm->s_region] = &host_pred_eq;
@@ -3399,10 +3475,10 @@ QueryOptimizer::prepareQuery(int query, Distribution dist) {
 
 			params->total_val = (1998-1992+1) * 25 * 25;
 
-			CubDebugExit(cudaMemcpyFromSymbol(&(params->map_filter_func_dev[cm->c_region]), p_pred_eq<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
-			CubDebugExit(cudaMemcpyFromSymbol(&(params->map_filter_func_dev[cm->s_region]), p_pred_eq<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
-			CubDebugExit(cudaMemcpyFromSymbol(&(params->map_filter_func_dev[cm->p_mfgr]), p_pred_between<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
-			CubDebugExit(cudaMemcpyFromSymbol(&(params->map_filter_func_dev[cm->d_year]), p_pred_between<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
+			CubDebugExit(deviceMemcpyFromSymbol(&(params->map_filter_func_dev[cm->c_region]), p_pred_eq<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
+			CubDebugExit(deviceMemcpyFromSymbol(&(params->map_filter_func_dev[cm->s_region]), p_pred_eq<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
+			CubDebugExit(deviceMemcpyFromSymbol(&(params->map_filter_func_dev[cm->p_mfgr]), p_pred_between<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
+			CubDebugExit(deviceMemcpyFromSymbol(&(params->map_filter_func_dev[cm->d_year]), p_pred_between<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
 
 			params->map_filter_func_host[cm->c_region] = &host_pred_eq;
 			params->map_filter_func_host[cm->s_region] = &host_pred_eq;
@@ -3468,10 +3544,10 @@ QueryOptimizer::prepareQuery(int query, Distribution dist) {
 
 			params->total_val = (1998-1992+1) * 250 * 1000;
 
-			CubDebugExit(cudaMemcpyFromSymbol(&(params->map_filter_func_dev[cm->c_region]), p_pred_eq<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
-			CubDebugExit(cudaMemcpyFromSymbol(&(params->map_filter_func_dev[cm->s_nation]), p_pred_eq<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
-			CubDebugExit(cudaMemcpyFromSymbol(&(params->map_filter_func_dev[cm->p_category]), p_pred_eq<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
-			CubDebugExit(cudaMemcpyFromSymbol(&(params->map_filter_func_dev[cm->d_year]), p_pred_between<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
+			CubDebugExit(deviceMemcpyFromSymbol(&(params->map_filter_func_dev[cm->c_region]), p_pred_eq<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
+			CubDebugExit(deviceMemcpyFromSymbol(&(params->map_filter_func_dev[cm->s_nation]), p_pred_eq<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
+			CubDebugExit(deviceMemcpyFromSymbol(&(params->map_filter_func_dev[cm->p_category]), p_pred_eq<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
+			CubDebugExit(deviceMemcpyFromSymbol(&(params->map_filter_func_dev[cm->d_year]), p_pred_between<int, 128, 4>, sizeof(filter_func_t_dev<int, 128, 4>)));
 
 			params->map_filter_func_host[cm->c_region] = &host_pred_eq;
 			params->map_filter_func_host[cm->s_nation] = &host_pred_eq;
@@ -3479,7 +3555,7 @@ QueryOptimizer::prepareQuery(int query, Distribution dist) {
 			params->map_filter_func_host[cm->d_year] = &host_pred_between;
 		}
 
-		CubDebugExit(cudaMemcpyFromSymbol(&(params->d_group_func), p_sub_func<int>, sizeof(group_func_t<int>)));
+		CubDebugExit(deviceMemcpyFromSymbol(&(params->d_group_func), p_sub_func<int>, sizeof(group_func_t<int>)));
 		params->h_group_func = &host_sub_func;
 
 		params->dim_len[cm->p_partkey] = P_LEN;
@@ -3489,33 +3565,33 @@ QueryOptimizer::prepareQuery(int query, Distribution dist) {
 
 		float time;
 		SETUP_TIMING();
-		cudaEventRecord(start, 0);
+		deviceEventRecord(start, 0);
 		if (custom) {
-			params->ht_CPU[cm->p_partkey] = (int*) cm->customMalloc<int>(2 * params->dim_len[cm->p_partkey]);
-			params->ht_CPU[cm->c_custkey] = (int*) cm->customMalloc<int>(2 * params->dim_len[cm->c_custkey]);
-			params->ht_CPU[cm->s_suppkey] = (int*) cm->customMalloc<int>(2 * params->dim_len[cm->s_suppkey]);
-			params->ht_CPU[cm->d_datekey] = (int*) cm->customMalloc<int>(2 * params->dim_len[cm->d_datekey]);			
+			params->ht_CPU[cm->p_partkey] = (int*) cm->customMalloc<int>(2 * params->dim_len[cm->p_partkey], cgp->scope);
+			params->ht_CPU[cm->c_custkey] = (int*) cm->customMalloc<int>(2 * params->dim_len[cm->c_custkey], cgp->scope);
+			params->ht_CPU[cm->s_suppkey] = (int*) cm->customMalloc<int>(2 * params->dim_len[cm->s_suppkey], cgp->scope);
+			params->ht_CPU[cm->d_datekey] = (int*) cm->customMalloc<int>(2 * params->dim_len[cm->d_datekey], cgp->scope);			
 		} else {
-			CubDebugExit(cudaHostAlloc((void**) &params->ht_CPU[cm->p_partkey], 2 * params->dim_len[cm->p_partkey] * sizeof(int), cudaHostAllocDefault));
-			CubDebugExit(cudaHostAlloc((void**) &params->ht_CPU[cm->c_custkey], 2 * params->dim_len[cm->c_custkey] * sizeof(int), cudaHostAllocDefault));
-			CubDebugExit(cudaHostAlloc((void**) &params->ht_CPU[cm->s_suppkey], 2 * params->dim_len[cm->s_suppkey] * sizeof(int), cudaHostAllocDefault));
-			CubDebugExit(cudaHostAlloc((void**) &params->ht_CPU[cm->d_datekey], 2 * params->dim_len[cm->d_datekey] * sizeof(int), cudaHostAllocDefault));				
+			CubDebugExit(deviceHostAlloc((void**) &params->ht_CPU[cm->p_partkey], 2 * params->dim_len[cm->p_partkey] * sizeof(int), cudaHostAllocDefault));
+			CubDebugExit(deviceHostAlloc((void**) &params->ht_CPU[cm->c_custkey], 2 * params->dim_len[cm->c_custkey] * sizeof(int), cudaHostAllocDefault));
+			CubDebugExit(deviceHostAlloc((void**) &params->ht_CPU[cm->s_suppkey], 2 * params->dim_len[cm->s_suppkey] * sizeof(int), cudaHostAllocDefault));
+			CubDebugExit(deviceHostAlloc((void**) &params->ht_CPU[cm->d_datekey], 2 * params->dim_len[cm->d_datekey] * sizeof(int), cudaHostAllocDefault));				
 		}
 
 		if (custom) {
-			params->ht_GPU[cm->p_partkey] = (int*) cm->customCudaMalloc<int>(2 * params->dim_len[cm->p_partkey]);
-			params->ht_GPU[cm->s_suppkey] = (int*) cm->customCudaMalloc<int>(2 * params->dim_len[cm->s_suppkey]);
-			params->ht_GPU[cm->d_datekey] = (int*) cm->customCudaMalloc<int>(2 * params->dim_len[cm->d_datekey]);
-			params->ht_GPU[cm->c_custkey] = (int*) cm->customCudaMalloc<int>(2 * params->dim_len[cm->c_custkey]);			
+			params->ht_GPU[cm->p_partkey] = (int*) cm->customCudaMalloc<int>(2 * params->dim_len[cm->p_partkey], cgp->scope);
+			params->ht_GPU[cm->s_suppkey] = (int*) cm->customCudaMalloc<int>(2 * params->dim_len[cm->s_suppkey], cgp->scope);
+			params->ht_GPU[cm->d_datekey] = (int*) cm->customCudaMalloc<int>(2 * params->dim_len[cm->d_datekey], cgp->scope);
+			params->ht_GPU[cm->c_custkey] = (int*) cm->customCudaMalloc<int>(2 * params->dim_len[cm->c_custkey], cgp->scope);			
 		} else {
-			CubDebugExit(cudaMalloc((void**) &params->ht_GPU[cm->p_partkey], 2 * params->dim_len[cm->p_partkey] * sizeof(int)));
-			CubDebugExit(cudaMalloc((void**) &params->ht_GPU[cm->c_custkey], 2 * params->dim_len[cm->c_custkey] * sizeof(int)));
-			CubDebugExit(cudaMalloc((void**) &params->ht_GPU[cm->s_suppkey], 2 * params->dim_len[cm->s_suppkey] * sizeof(int)));
-			CubDebugExit(cudaMalloc((void**) &params->ht_GPU[cm->d_datekey], 2 * params->dim_len[cm->d_datekey] * sizeof(int)));					
+			CubDebugExit(deviceMalloc((void**) &params->ht_GPU[cm->p_partkey], 2 * params->dim_len[cm->p_partkey] * sizeof(int)));
+			CubDebugExit(deviceMalloc((void**) &params->ht_GPU[cm->c_custkey], 2 * params->dim_len[cm->c_custkey] * sizeof(int)));
+			CubDebugExit(deviceMalloc((void**) &params->ht_GPU[cm->s_suppkey], 2 * params->dim_len[cm->s_suppkey] * sizeof(int)));
+			CubDebugExit(deviceMalloc((void**) &params->ht_GPU[cm->d_datekey], 2 * params->dim_len[cm->d_datekey] * sizeof(int)));					
 		}
-		cudaEventRecord(stop, 0);
-	  cudaEventSynchronize(stop);
-	  cudaEventElapsedTime(&time, start, stop);
+		deviceEventRecord(stop, 0);
+	  deviceEventSynchronize(stop);
+	  deviceEventElapsedTime(&time, start, stop);
 	  cgp->malloc_time_total += time;	
 
 		memset(params->ht_CPU[cm->d_datekey], 0, 2 * params->dim_len[cm->d_datekey] * sizeof(int));
@@ -3523,10 +3599,10 @@ QueryOptimizer::prepareQuery(int query, Distribution dist) {
 		memset(params->ht_CPU[cm->s_suppkey], 0, 2 * params->dim_len[cm->s_suppkey] * sizeof(int));
 		memset(params->ht_CPU[cm->c_custkey], 0, 2 * params->dim_len[cm->c_custkey] * sizeof(int));
 
-		CubDebugExit(cudaMemset(params->ht_GPU[cm->p_partkey], 0, 2 * params->dim_len[cm->p_partkey] * sizeof(int)));
-		CubDebugExit(cudaMemset(params->ht_GPU[cm->s_suppkey], 0, 2 * params->dim_len[cm->s_suppkey] * sizeof(int)));
-		CubDebugExit(cudaMemset(params->ht_GPU[cm->d_datekey], 0, 2 * params->dim_len[cm->d_datekey] * sizeof(int)));
-		CubDebugExit(cudaMemset(params->ht_GPU[cm->c_custkey], 0, 2 * params->dim_len[cm->c_custkey] * sizeof(int)));
+		CubDebugExit(deviceMemset(params->ht_GPU[cm->p_partkey], 0, 2 * params->dim_len[cm->p_partkey] * sizeof(int)));
+		CubDebugExit(deviceMemset(params->ht_GPU[cm->s_suppkey], 0, 2 * params->dim_len[cm->s_suppkey] * sizeof(int)));
+		CubDebugExit(deviceMemset(params->ht_GPU[cm->d_datekey], 0, 2 * params->dim_len[cm->d_datekey] * sizeof(int)));
+		CubDebugExit(deviceMemset(params->ht_GPU[cm->c_custkey], 0, 2 * params->dim_len[cm->c_custkey] * sizeof(int)));
 
 
 	} else {
@@ -3555,19 +3631,21 @@ QueryOptimizer::prepareQuery(int query, Distribution dist) {
 
 	float time;
 	SETUP_TIMING();
-	cudaEventRecord(start, 0);
-	if (custom) params->res = (int*) cm->customCudaHostAlloc<int>(res_array_size);
-	else CubDebugExit(cudaHostAlloc((void**) &params->res, res_array_size * sizeof(int), cudaHostAllocDefault));
-	if (custom) params->d_res = (int*) cm->customCudaMalloc<int>(res_array_size);
-	else CubDebugExit(cudaMalloc((void**) &params->d_res, res_array_size * sizeof(int)));
-	cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+	deviceEventRecord(start, 0);
+	if (custom) params->res = (int*) cm->customCudaHostAlloc<int>(res_array_size, cgp->scope);
+	else CubDebugExit(deviceHostAlloc((void**) &params->res, res_array_size * sizeof(int), cudaHostAllocDefault));
+	if (custom) params->d_res = (int*) cm->customCudaMalloc<int>(res_array_size, cgp->scope);
+	else CubDebugExit(deviceMalloc((void**) &params->d_res, res_array_size * sizeof(int)));
+	deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
   cgp->malloc_time_total += time;
   // cout << "malloc time: " << cgp->malloc_time_total << endl;
 
   memset(params->res, 0, res_array_size * sizeof(int));
-	CubDebugExit(cudaMemset(params->d_res, 0, res_array_size * sizeof(int)));
+	CubDebugExit(deviceMemset(params->d_res, 0, res_array_size * sizeof(int)));
+
+	checkJoinSummaries();
 
 };
 
@@ -3575,17 +3653,17 @@ void
 QueryOptimizer::clearPrepare() {
 
   if (!custom) {
-  	cudaFree(params->d_res);
-  	cudaFreeHost(params->res);
- 		if (params->ht_GPU[cm->p_partkey] != NULL) cudaFree(params->ht_GPU[cm->p_partkey]);
- 		if (params->ht_GPU[cm->s_suppkey] != NULL) cudaFree(params->ht_GPU[cm->s_suppkey]);
- 		if (params->ht_GPU[cm->c_custkey] != NULL) cudaFree(params->ht_GPU[cm->c_custkey]);
- 		if (params->ht_GPU[cm->d_datekey] != NULL) cudaFree(params->ht_GPU[cm->d_datekey]);
-
- 		if (params->ht_CPU[cm->p_partkey] != NULL) cudaFreeHost(params->ht_CPU[cm->p_partkey]);
- 		if (params->ht_CPU[cm->s_suppkey] != NULL) cudaFreeHost(params->ht_CPU[cm->s_suppkey]);
- 		if (params->ht_CPU[cm->c_custkey] != NULL) cudaFreeHost(params->ht_CPU[cm->c_custkey]);
- 		if (params->ht_CPU[cm->d_datekey] != NULL) cudaFreeHost(params->ht_CPU[cm->d_datekey]);
+  	deviceFree(params->d_res);
+  	deviceFreeHost(params->res);
+ 		if (params->ht_GPU[cm->p_partkey] != NULL) deviceFree(params->ht_GPU[cm->p_partkey]);
+ 		if (params->ht_GPU[cm->s_suppkey] != NULL) deviceFree(params->ht_GPU[cm->s_suppkey]);
+ 		if (params->ht_GPU[cm->c_custkey] != NULL) deviceFree(params->ht_GPU[cm->c_custkey]);
+ 		if (params->ht_GPU[cm->d_datekey] != NULL) deviceFree(params->ht_GPU[cm->d_datekey]);
+
+ 		if (params->ht_CPU[cm->p_partkey] != NULL) deviceFreeHost(params->ht_CPU[cm->p_partkey]);
+ 		if (params->ht_CPU[cm->s_suppkey] != NULL) deviceFreeHost(params->ht_CPU[cm->s_suppkey]);
+ 		if (params->ht_CPU[cm->c_custkey] != NULL) deviceFreeHost(params->ht_CPU[cm->c_custkey]);
+ 		if (params->ht_CPU[cm->d_datekey] != NULL) deviceFreeHost(params->ht_CPU[cm->d_datekey]);
   }
 
   params->min_key.clear();
@@ -3605,6 +3683,7 @@ QueryOptimizer::clearPrepare() {
   params->compare1.clear();
   params->compare2.clear();
   params->mode.clear();
+  join_skip.clear();
 
 
 }
\ No newline at end of file
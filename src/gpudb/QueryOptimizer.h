@@ -3,6 +3,7 @@
 
 #include "CacheManager.h"
 #include "KernelArgs.h"
+#include "JoinSummary.h"
 #include "common.h"
 
 #define NUM_QUERIES 13
@@ -11,6 +12,8 @@
 
 class CPUGPUProcessing;
 
+extern bool join_skipping;
+
 enum OperatorType {
     Filter, Probe, Build, GroupBy, Aggr, CPUtoGPU, GPUtoCPU, Materialize, Merge
 };
@@ -394,8 +397,17 @@ public:
 
 	int processed_segment;
 	int skipped_segment;
+	int cached_segment; //answered from the result cache or the segment aggregates
+	int aggregated_segment; //lineorder segments answered from the segment aggregates
+	char* segment_cached; //lineorder segments groupBitmapSegmentTable leaves out, NULL for none
+
+	vector<char> join_skip; //lineorder segments checkPredicate rules out with the join summaries, empty for none
+	int join_skipped_segment; //counted like skipped_segment
+
+	bool owns_cm;
 
 	QueryOptimizer(size_t _cache_size, size_t _ondemand_size, size_t _processing_size, size_t _pinned_memsize, CPUGPUProcessing* _cgp);
+	QueryOptimizer(CacheManager* _cm, CPUGPUProcessing* _cgp); //over the cache manager of another optimizer
 	~QueryOptimizer();
 
 	void setDistributionZipfian(double alpha);
@@ -435,6 +447,8 @@ public:
 
 
 	bool checkPredicate(int table_id, int segment_idx);
+	string joinSummaryKey(ColumnInfo* pkey);
+	void checkJoinSummaries();
 	void updateSegmentStats(int table_id, int segment_idx, int query);
 
 };
@@ -5,6 +5,7 @@
 // #include "common.h"
 
 int queries[13] = {11, 12, 13, 21, 22, 23, 31, 32, 33, 34, 41, 42, 43};
+bool segment_aggregates = true;
 
 void
 QueryProcessing::executeTableDimNP(int table_id, int sg) {
@@ -12,11 +13,11 @@ QueryProcessing::executeTableDimNP(int table_id, int sg) {
     int* d_total = NULL;
     int* h_total = NULL;
 
-    if (custom) h_total = (int*) cm->customCudaHostAlloc<int>(1);
-    else CubDebugExit(cudaHostAlloc((void**) &h_total, 1 * sizeof(int), cudaHostAllocDefault));
+    if (custom) h_total = (int*) cm->customCudaHostAlloc<int>(1, cgp->scope);
+    else CubDebugExit(deviceHostAlloc((void**) &h_total, 1 * sizeof(int), cudaHostAllocDefault));
     memset(h_total, 0, sizeof(int));
-    if (custom) d_total = (int*) cm->customCudaMalloc<int>(1);
-    else CubDebugExit(cudaMalloc((void**) &d_total, 1 * sizeof(int)));
+    if (custom) d_total = (int*) cm->customCudaMalloc<int>(1, cgp->scope);
+    else CubDebugExit(deviceMalloc((void**) &d_total, 1 * sizeof(int)));
 
     if (sg == 0 || sg == 1) {
 
@@ -57,11 +58,11 @@ QueryProcessing::executeTableFactNP(int sg) {
     int* d_total = NULL;
     int* h_total = NULL;
 
-    if (custom) h_total = (int*) cm->customCudaHostAlloc<int>(1);
-    else CubDebugExit(cudaHostAlloc((void**) &h_total, 1 * sizeof(int), cudaHostAllocDefault));
+    if (custom) h_total = (int*) cm->customCudaHostAlloc<int>(1, cgp->scope);
+    else CubDebugExit(deviceHostAlloc((void**) &h_total, 1 * sizeof(int), cudaHostAllocDefault));
     memset(h_total, 0, sizeof(int));
-    if (custom) d_total = (int*) cm->customCudaMalloc<int>(1);
-    else CubDebugExit(cudaMalloc((void**) &d_total, 1 * sizeof(int)));
+    if (custom) d_total = (int*) cm->customCudaMalloc<int>(1, cgp->scope);
+    else CubDebugExit(deviceMalloc((void**) &d_total, 1 * sizeof(int)));
 
     for (int i = 0; i < qo->selectCPUPipelineCol[sg].size(); i++) {
       cgp->call_pfilter_CPUNP(params, h_off_col, h_total, sg, qo->selectCPUPipelineCol[sg][i]);
@@ -89,18 +90,18 @@ QueryProcessing::executeTableFactNP(int sg) {
       if (qo->joinCPUPipelineCol[sg].size() > 0) {
         if (qo->groupby_build.size() == 0) {
           cgp->call_aggregation_CPU(params, h_off_col[0], h_total, sg);
-          if (!custom) cudaFreeHost(h_off_col[4]);
+          if (!custom) deviceFreeHost(h_off_col[4]);
         } else cgp->call_group_by_CPU(params, h_off_col, h_total, sg);
       } else {
         if (qo->groupby_build.size() == 0) {
           cgp->call_aggregation_GPU(params, off_col[0], h_total, sg, streams[sg]);
-          if (!custom) cudaFree(off_col[4]);
+          if (!custom) deviceFree(off_col[4]);
         } else cgp->call_group_by_GPU(params, off_col, h_total, sg, streams[sg]);
       }
     } else {
       if (qo->groupby_build.size() == 0) {
         cgp->call_aggregation_CPU(params, h_off_col[0], h_total, sg);
-        if (!custom) cudaFreeHost(h_off_col[4]);
+        if (!custom) deviceFreeHost(h_off_col[4]);
       } else cgp->call_group_by_CPU(params, h_off_col, h_total, sg);
     }
 }
@@ -111,11 +112,11 @@ QueryProcessing::executeTableDim(int table_id, int sg) {
     int* d_total = NULL;
     int* h_total = NULL;
 
-    if (custom) h_total = (int*) cm->customCudaHostAlloc<int>(1);
-    else CubDebugExit(cudaHostAlloc((void**) &h_total, 1 * sizeof(int), cudaHostAllocDefault));
+    if (custom) h_total = (int*) cm->customCudaHostAlloc<int>(1, cgp->scope);
+    else CubDebugExit(deviceHostAlloc((void**) &h_total, 1 * sizeof(int), cudaHostAllocDefault));
     memset(h_total, 0, sizeof(int));
-    if (custom) d_total = (int*) cm->customCudaMalloc<int>(1);
-    else CubDebugExit(cudaMalloc((void**) &d_total, 1 * sizeof(int)));
+    if (custom) d_total = (int*) cm->customCudaMalloc<int>(1, cgp->scope);
+    else CubDebugExit(deviceMalloc((void**) &d_total, 1 * sizeof(int)));
 
     // cout << "dim " << sg << endl;
 
@@ -156,11 +157,11 @@ QueryProcessing::executeTableDim_HE(int table_id, int segment_idx) {
     int* d_total = NULL;
     int* h_total = NULL;
 
-    if (custom) h_total = (int*) cm->customCudaHostAlloc<int>(1);
-    else CubDebugExit(cudaHostAlloc((void**) &h_total, 1 * sizeof(int), cudaHostAllocDefault));
+    if (custom) h_total = (int*) cm->customCudaHostAlloc<int>(1, cgp->scope);
+    else CubDebugExit(deviceHostAlloc((void**) &h_total, 1 * sizeof(int), cudaHostAllocDefault));
     memset(h_total, 0, sizeof(int));
-    if (custom) d_total = (int*) cm->customCudaMalloc<int>(1);
-    else CubDebugExit(cudaMalloc((void**) &d_total, 1 * sizeof(int)));
+    if (custom) d_total = (int*) cm->customCudaMalloc<int>(1, cgp->scope);
+    else CubDebugExit(deviceMalloc((void**) &d_total, 1 * sizeof(int)));
 
     // cout << "dim " << segment_idx << endl;
 
@@ -203,11 +204,11 @@ QueryProcessing::executeTableFact_v1(int sg) {
     int* d_total = NULL;
     int* h_total = NULL;
 
-    if (custom) h_total = (int*) cm->customCudaHostAlloc<int>(1);
-    else CubDebugExit(cudaHostAlloc((void**) &h_total, 1 * sizeof(int), cudaHostAllocDefault));
+    if (custom) h_total = (int*) cm->customCudaHostAlloc<int>(1, cgp->scope);
+    else CubDebugExit(deviceHostAlloc((void**) &h_total, 1 * sizeof(int), cudaHostAllocDefault));
     memset(h_total, 0, sizeof(int));
-    if (custom) d_total = (int*) cm->customCudaMalloc<int>(1);
-    else CubDebugExit(cudaMalloc((void**) &d_total, 1 * sizeof(int)));
+    if (custom) d_total = (int*) cm->customCudaMalloc<int>(1, cgp->scope);
+    else CubDebugExit(deviceMalloc((void**) &d_total, 1 * sizeof(int)));
 
     // printf("fact sg = %d\n", sg);
 
@@ -442,11 +443,11 @@ QueryProcessing::executeTableFact_HE(int segment_idx) {
     int* d_total = NULL;
     int* h_total = NULL;
 
-    if (custom) h_total = (int*) cm->customCudaHostAlloc<int>(1);
-    else CubDebugExit(cudaHostAlloc((void**) &h_total, 1 * sizeof(int), cudaHostAllocDefault));
+    if (custom) h_total = (int*) cm->customCudaHostAlloc<int>(1, cgp->scope);
+    else CubDebugExit(deviceHostAlloc((void**) &h_total, 1 * sizeof(int), cudaHostAllocDefault));
     memset(h_total, 0, sizeof(int));
-    if (custom) d_total = (int*) cm->customCudaMalloc<int>(1);
-    else CubDebugExit(cudaMalloc((void**) &d_total, 1 * sizeof(int)));
+    if (custom) d_total = (int*) cm->customCudaMalloc<int>(1, cgp->scope);
+    else CubDebugExit(deviceMalloc((void**) &d_total, 1 * sizeof(int)));
 
     // printf("fact segment_idx = %d\n", segment_idx);
 
@@ -678,11 +679,11 @@ QueryProcessing::executeTableFact_v2(int sg) {
     int* d_total = NULL;
     int* h_total = NULL;
 
-    if (custom) h_total = (int*) cm->customCudaHostAlloc<int>(1);
-    else CubDebugExit(cudaHostAlloc((void**) &h_total, 1 * sizeof(int), cudaHostAllocDefault));
+    if (custom) h_total = (int*) cm->customCudaHostAlloc<int>(1, cgp->scope);
+    else CubDebugExit(deviceHostAlloc((void**) &h_total, 1 * sizeof(int), cudaHostAllocDefault));
     memset(h_total, 0, sizeof(int));
-    if (custom) d_total = (int*) cm->customCudaMalloc<int>(1);
-    else CubDebugExit(cudaMalloc((void**) &d_total, 1 * sizeof(int)));
+    if (custom) d_total = (int*) cm->customCudaMalloc<int>(1, cgp->scope);
+    else CubDebugExit(deviceMalloc((void**) &d_total, 1 * sizeof(int)));
 
     if (verbose) printf("sg = %d\n", sg);
 
@@ -948,7 +949,7 @@ QueryProcessing::executeTableDimOD(int table_id, int sg) {
       else batch_size = OD_BATCH_SIZE;
 
       parallel_for(int(0), batch_size, [=](int batch){
-          CubDebugExit(cudaStreamCreate(&streams[batch]));
+          CubDebugExit(deviceStreamCreate(&streams[batch]));
 
           int segment_number = (j * OD_BATCH_SIZE + batch);
           assert(segment_number < qo->segment_group_count[table_id][sg]);
@@ -991,8 +992,8 @@ QueryProcessing::executeTableDimOD(int table_id, int sg) {
 
           CHECK_ERROR_STREAM(streams[batch]);
 
-          CubDebugExit(cudaStreamSynchronize(streams[batch]));
-          CubDebugExit(cudaStreamDestroy(streams[batch]));
+          CubDebugExit(deviceStreamSynchronize(streams[batch]));
+          CubDebugExit(deviceStreamDestroy(streams[batch]));
       });
 
     }
@@ -1038,7 +1039,7 @@ QueryProcessing::executeTableFactOD(int sg) {
 
         parallel_for(int(0), batch_size, [=](int batch){
 
-            CubDebugExit(cudaStreamCreate(&streams[batch]));
+            CubDebugExit(deviceStreamCreate(&streams[batch]));
             int segment_number = (j * OD_BATCH_SIZE + batch);
             assert(segment_number < qo->segment_group_count[0][sg]);
             int segment_idx = segment_group_ptr[segment_number];
@@ -1092,8 +1093,8 @@ QueryProcessing::executeTableFactOD(int sg) {
 
             CHECK_ERROR_STREAM(streams[batch]);
 
-            CubDebugExit(cudaStreamSynchronize(streams[batch]));
-            CubDebugExit(cudaStreamDestroy(streams[batch]));
+            CubDebugExit(deviceStreamSynchronize(streams[batch]));
+            CubDebugExit(deviceStreamDestroy(streams[batch]));
 
         });
 
@@ -1124,7 +1125,7 @@ QueryProcessing::executeTableFactOD(int sg) {
         // for (int batch = 0; batch < batch_size; batch++) {
         parallel_for(int(0), batch_size, [=](int batch){
 
-            CubDebugExit(cudaStreamCreate(&streams[batch]));
+            CubDebugExit(deviceStreamCreate(&streams[batch]));
             int segment_number = (j * OD_BATCH_SIZE + batch);
             assert(segment_number < qo->segment_group_count[0][sg]);
             int segment_idx = segment_group_ptr[segment_number];
@@ -1171,8 +1172,8 @@ QueryProcessing::executeTableFactOD(int sg) {
 
             CHECK_ERROR_STREAM(streams[batch]);
 
-            CubDebugExit(cudaStreamSynchronize(streams[batch]));
-            CubDebugExit(cudaStreamDestroy(streams[batch]));
+            CubDebugExit(deviceStreamSynchronize(streams[batch]));
+            CubDebugExit(deviceStreamDestroy(streams[batch]));
 
         });
         // }
@@ -1181,7 +1182,7 @@ QueryProcessing::executeTableFactOD(int sg) {
       }
     }
 
-    CubDebugExit(cudaMemcpy(params->res, params->d_res, params->total_val * 6 * sizeof(int), cudaMemcpyDeviceToHost));
+    CubDebugExit(deviceMemcpy(params->res, params->d_res, params->total_val * 6 * sizeof(int), cudaMemcpyDeviceToHost));
     cgp->gpu_to_cpu_total += (params->total_val * 6 * sizeof(int));
 
 }
@@ -1229,7 +1230,7 @@ QueryProcessing::executeTableFactOD2(int sg) {
 
             // cudaStream_t stream;
 
-            // CubDebugExit(cudaStreamCreate(&stream));
+            // CubDebugExit(deviceStreamCreate(&stream));
             int segment_number = (j * OD_BATCH_SIZE + batch);
             assert(segment_number < qo->segment_group_count[0][sg]);
             int segment_idx = segment_group_ptr[segment_number];
@@ -1262,13 +1263,13 @@ QueryProcessing::executeTableFactOD2(int sg) {
               }
             }
 
-            // CubDebugExit(cudaStreamSynchronize(streams[sg]));
-            // CubDebugExit(cudaStreamDestroy(stream));
+            // CubDebugExit(deviceStreamSynchronize(streams[sg]));
+            // CubDebugExit(deviceStreamDestroy(stream));
 
         // });
         }
 
-        // CubDebugExit(cudaStreamSynchronize(streams[sg]));
+        // CubDebugExit(deviceStreamSynchronize(streams[sg]));
         cgp->call_pfilter_probe_aggr_OD(params, filter, pkey, fkey, aggr, sg, j, batch_size, total_batch, streams[sg]);
       }
 
@@ -1301,7 +1302,7 @@ QueryProcessing::executeTableFactOD2(int sg) {
 
             // cudaStream_t stream;
 
-            // CubDebugExit(cudaStreamCreate(&stream));
+            // CubDebugExit(deviceStreamCreate(&stream));
             int segment_number = (j * OD_BATCH_SIZE + batch);
             assert(segment_number < qo->segment_group_count[0][sg]);
             int segment_idx = segment_group_ptr[segment_number];
@@ -1329,13 +1330,13 @@ QueryProcessing::executeTableFactOD2(int sg) {
               }
             }
 
-            // CubDebugExit(cudaStreamSynchronize(streams[sg]));
-            // CubDebugExit(cudaStreamDestroy(stream));
+            // CubDebugExit(deviceStreamSynchronize(streams[sg]));
+            // CubDebugExit(deviceStreamDestroy(stream));
 
         // });
         }
 
-        // CubDebugExit(cudaStreamSynchronize(streams[sg]));
+        // CubDebugExit(deviceStreamSynchronize(streams[sg]));
         cgp->call_probe_group_by_OD(params, pkey, fkey, aggr, sg, j, batch_size, total_batch, streams[sg]);
       }
 
@@ -1343,22 +1344,27 @@ QueryProcessing::executeTableFactOD2(int sg) {
 
 }
 
-void
-QueryProcessing::runQuery(CUcontext ctx) {
+//filter, join and group by of the segment group all run on the cpu (executeTableFact_v1 calls one fused cpu operator)
+bool
+QueryProcessing::isPipelineCPU(int sg) {
+  return qo->selectGPUPipelineCol[sg].size() == 0 && qo->joinGPUPipelineCol[sg].size() == 0 &&
+    qo->joinCPUPipelineCol[sg].size() > 0 && qo->groupbyGPUPipelineCol[sg].size() == 0;
+}
 
-  SETUP_TIMING();
-  float time;
-  cudaEventRecord(start, 0);
+//hash tables of every dimension the query joins
+void
+QueryProcessing::buildDims(CUcontext ctx) {
 
   for (int i = 0; i < qo->join.size(); i++) {
     int table_id = qo->join[i].second->table_id;
+    if (sharedBuild(qo->join[i].second)) continue;
 
     // for (short j = 0; j < qo->par_segment_count[table_id]; j++) {
 
     parallel_for(short(0), qo->par_segment_count[table_id], [=](short j){
 
       CUcontext poppedCtx;
-      cuCtxPushCurrent(ctx);
+      deviceCtxPushCurrent(ctx);
 
       // cuCtxSetCurrent(ctx);
 
@@ -1369,41 +1375,64 @@ QueryProcessing::runQuery(CUcontext ctx) {
         printf("sg = %d\n", sg);
       }
 
-      CubDebugExit(cudaStreamCreate(&streams[sg]));
+      CubDebugExit(deviceStreamCreate(&streams[sg]));
 
       if (qo->segment_group_count[table_id][sg] > 0) {
         executeTableDim(table_id, sg);
       }
 
-      CubDebugExit(cudaStreamSynchronize(streams[sg]));
-      CubDebugExit(cudaStreamDestroy(streams[sg]));
+      CubDebugExit(deviceStreamSynchronize(streams[sg]));
+      CubDebugExit(deviceStreamDestroy(streams[sg]));
 
       // cuCtxSetCurrent(NULL);
 
-      cuCtxPopCurrent(&poppedCtx);
-      // CHECK_CU_ERROR(cuCtxPopCurrent(&poppedCtx), "cuCtxPopCurrent");
+      deviceCtxPopCurrent(&poppedCtx);
+      // CHECK_CU_ERROR(deviceCtxPopCurrent(&poppedCtx), "cuCtxPopCurrent");
 
     });
 
     // }
 
-    CubDebugExit(cudaDeviceSynchronize());
+    CubDebugExit(deviceSynchronize());
+    publishBuild(qo->join[i].second);
   }
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
-  if (verbose) cout << "Build time " << time << endl;
-  cgp->execution_total += time;
+}
 
-  cudaEventRecord(start, 0);
+//filter, probe and group by of every lineorder segment group
+void
+QueryProcessing::probeFact(CUcontext ctx) {
 
-  parallel_for(short(0), qo->par_segment_count[0], [=](short i){
+  //segment groups running entirely on the cpu share one morsel scheduler instead of one parallel_for each
+  vector<int> morsel_sg;
+  bool* morsel_run = new bool[MAX_GROUPS]();
+  if (morsel_driven_cpu) {
+    for (int i = 0; i < qo->par_segment_count[0]; i++) {
+      int sg = qo->par_segment[0][i];
+      if (qo->segment_group_count[0][sg] > 0 && isPipelineCPU(sg)) {
+        morsel_sg.push_back(sg);
+        morsel_run[sg] = true;
+      }
+    }
+  }
+
+  //the last iteration runs the morsel scheduler, next to the segment groups with gpu work
+  parallel_for(short(0), short(qo->par_segment_count[0] + 1), [=](short i){
+
+    if (i == qo->par_segment_count[0]) {
+      if (morsel_sg.size() == 0) return;
+      CUcontext poppedCtx;
+      deviceCtxPushCurrent(ctx);
+      vector<int> sgs = morsel_sg;
+      cgp->call_pipeline_morsel_CPU(params, sgs);
+      deviceCtxPopCurrent(&poppedCtx);
+      return;
+    }
 
     // cout << i << " of " << qo->par_segment_count[0] << endl;
 
     CUcontext poppedCtx;
-    cuCtxPushCurrent(ctx);
+    deviceCtxPushCurrent(ctx);
 
     // cout << i << " of " << qo->par_segment_count[0] << endl;
 
@@ -1412,80 +1441,232 @@ QueryProcessing::runQuery(CUcontext ctx) {
   //for (int i = 0; i < qo->par_segment_count[0]; i++) {
     int sg = qo->par_segment[0][i];
 
-    CubDebugExit(cudaStreamCreate(&streams[sg]));
+    CubDebugExit(deviceStreamCreate(&streams[sg]));
 
     float time_;
-    cudaEvent_t start_, stop_; 
-    cudaEventCreate(&start_); cudaEventCreate(&stop_);
-    cudaEventRecord(start_, 0);
+    deviceEvent_t start_, stop_; 
+    deviceEventCreate(&start_); deviceEventCreate(&stop_);
+    deviceEventRecord(start_, 0);
 
-    if (qo->segment_group_count[0][sg] > 0) {
+    if (qo->segment_group_count[0][sg] > 0 && !morsel_run[sg]) {
       executeTableFact_v1(sg);
     }
 
-    cudaEventRecord(stop_, 0);
-    cudaEventSynchronize(stop_);
-    cudaEventElapsedTime(&time_, start_, stop_);
+    deviceEventRecord(stop_, 0);
+    deviceEventSynchronize(stop_);
+    deviceEventElapsedTime(&time_, start_, stop_);
 
     if (verbose) cout << "sg = " << sg << " non demand time = " << time_ << endl;
 
-    CubDebugExit(cudaStreamSynchronize(streams[sg]));
-    CubDebugExit(cudaStreamDestroy(streams[sg]));
+    CubDebugExit(deviceStreamSynchronize(streams[sg]));
+    CubDebugExit(deviceStreamDestroy(streams[sg]));
 
-    cuCtxPopCurrent(&poppedCtx);
+    deviceCtxPopCurrent(&poppedCtx);
 
   });
 
-  CubDebugExit(cudaDeviceSynchronize());
+  CubDebugExit(deviceSynchronize());
+
+  delete[] morsel_run;
+
+}
+
+void
+QueryProcessing::runQuery(CUcontext ctx) {
+
+  SETUP_TIMING();
+  float time;
+  deviceEventRecord(start, 0);
+
+  buildDims(ctx);
+
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
+  if (verbose) cout << "Build time " << time << endl;
+  cgp->execution_total += time;
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(start, 0);
+
+  cgp->replicate_ht_CPU(params);
+
+  probeFact(ctx);
+
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
   if (verbose) cout << "Probe time " << time << endl;
   cgp->execution_total += time;
 
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   int* resGPU;
-  if (custom) resGPU = (int*) cm->customCudaHostAlloc<int>(params->total_val * 6);
-  else CubDebugExit(cudaHostAlloc((void**) &resGPU, params->total_val * 6 * sizeof(int), cudaHostAllocDefault));
-  CubDebugExit(cudaMemcpy(resGPU, params->d_res, params->total_val * 6 * sizeof(int), cudaMemcpyDeviceToHost));
+  if (custom) resGPU = (int*) cm->customCudaHostAlloc<int>(params->total_val * 6, cgp->scope);
+  else CubDebugExit(deviceHostAlloc((void**) &resGPU, params->total_val * 6 * sizeof(int), cudaHostAllocDefault));
+  CubDebugExit(deviceMemcpy(resGPU, params->d_res, params->total_val * 6 * sizeof(int), cudaMemcpyDeviceToHost));
   cgp->gpu_to_cpu_total += (params->total_val * 6 * sizeof(int));
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
   cgp->execution_total += time;
 
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   merge(params->res, resGPU, params->total_val);
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
   if (verbose) cout << "Merge time " << time << endl;
   cgp->merging_total += time;
 }
 
+//runQuery for the lineorder segments the result cache missed. the first missed block the date range covers runs
+//in a pass of its own and leaves its partial aggregate in the cache (partials of the blocks the range cuts are
+//only reused by the same range and are not worth a pass), the other misses run together in one probeFact pass.
+//the partials of the hits found by lookupResults are added last
+void
+QueryProcessing::runQueryCached(CUcontext ctx) {
+
+  SETUP_TIMING();
+  float time;
+
+  int total_segment = cm->lo_orderdate->total_segment;
+  int res_array_size = params->total_val * 6;
+  bool date_range = params->compare1.find(cm->lo_orderdate) != params->compare1.end();
+  int column = cm->lo_orderdate->column_id;
+
+  vector<short> group_of(total_segment, -1); //segment group of every miss
+  for (int j = 0; j < qo->par_segment_count[0]; j++) {
+    short sg = qo->par_segment[0][j];
+    for (int k = 0; k < qo->segment_group_count[0][sg]; k++)
+      group_of[qo->segment_group[0][sg * total_segment + k]] = sg;
+  }
+
+  //a block is admitted when the range covers it and every segment is a miss or ruled out by checkPredicate,
+  //a segment answered by the aggregates would be missing from its partial
+  int admit = -1;
+  for (int first = 0; first < total_segment && admit < 0; first += RESULT_CACHE_BLOCK) {
+    bool missed = false, whole = true;
+    for (int i = first; i < min(first + RESULT_CACHE_BLOCK, total_segment) && whole; i++) {
+      if (date_range && (cm->segment_min[column][i] < params->compare1[cm->lo_orderdate] ||
+        cm->segment_max[column][i] > params->compare2[cm->lo_orderdate])) whole = false;
+      else if (group_of[i] >= 0) missed = true;
+      else if (!aggr_hit.empty() && aggr_hit[i] && !result_hit[i]) whole = false;
+    }
+    if (missed && whole) admit = first / RESULT_CACHE_BLOCK;
+  }
+
+  //run 0 is the grouped pass over the misses outside the admitted block, run 1 the admitted block
+  vector<vector<short>> run[2] = {vector<vector<short>>(MAX_GROUPS), vector<vector<short>>(MAX_GROUPS)};
+  int run_count[2] = {0, 0};
+  for (int i = 0; i < total_segment; i++) {
+    if (group_of[i] < 0) continue;
+    int r = (i / RESULT_CACHE_BLOCK == admit) ? 1 : 0;
+    run[r][group_of[i]].push_back(i);
+    run_count[r]++;
+  }
+
+  if (run_count[0] + run_count[1] > 0) {
+    deviceEventRecord(start, 0);
+
+    buildDims(ctx);
+
+    deviceEventRecord(stop, 0);
+    deviceEventSynchronize(stop);
+    deviceEventElapsedTime(&time, start, stop);
+    if (verbose) cout << "Build time " << time << endl;
+    cgp->execution_total += time;
+
+    deviceEventRecord(start, 0);
+
+    cgp->replicate_ht_CPU(params);
+
+    //segment groups are narrowed to the segments of a run and restored afterwards
+    vector<short> group_count(qo->segment_group_count[0], qo->segment_group_count[0] + MAX_GROUPS);
+    vector<short> group((size_t) MAX_GROUPS * total_segment);
+    for (int sg = 0; sg < MAX_GROUPS; sg++)
+      copy(qo->segment_group[0] + sg * total_segment, qo->segment_group[0] + sg * total_segment + group_count[sg], group.begin() + sg * total_segment);
+    vector<short> par_segment(qo->par_segment[0], qo->par_segment[0] + qo->par_segment_count[0]);
+    short par_segment_count = qo->par_segment_count[0];
+    int last_segment = qo->last_segment[0];
+
+    int* resGPU;
+    if (custom) resGPU = (int*) cm->customCudaHostAlloc<int>(res_array_size, cgp->scope);
+    else CubDebugExit(deviceHostAlloc((void**) &resGPU, res_array_size * sizeof(int), cudaHostAllocDefault));
+
+    for (int r = 0; r < 2; r++) {
+      if (run_count[r] == 0) continue;
+      memset(qo->segment_group_count[0], 0, MAX_GROUPS * sizeof(short));
+      qo->par_segment_count[0] = 0;
+      qo->last_segment[0] = -1;
+      for (int j = 0; j < par_segment_count; j++) {
+        short sg = par_segment[j];
+        if (run[r][sg].empty()) continue;
+        copy(run[r][sg].begin(), run[r][sg].end(), qo->segment_group[0] + sg * total_segment);
+        qo->segment_group_count[0][sg] = run[r][sg].size();
+        qo->par_segment[0][qo->par_segment_count[0]++] = sg;
+        if (run[r][sg].back() == total_segment - 1) qo->last_segment[0] = last_segment;
+      }
+
+      memset(params->res, 0, res_array_size * sizeof(int));
+      CubDebugExit(deviceMemset(params->d_res, 0, res_array_size * sizeof(int)));
+
+      probeFact(ctx);
+
+      CubDebugExit(deviceMemcpy(resGPU, params->d_res, res_array_size * sizeof(int), cudaMemcpyDeviceToHost));
+      cgp->gpu_to_cpu_total += (res_array_size * sizeof(int));
+      merge(params->res, resGPU, params->total_val);
+
+      if (r == 1) cm->result_cache->insert(blockKey(admit), params->res, params->total_val);
+      merge(result_sum.data(), params->res, params->total_val);
+    }
 
+    memcpy(qo->segment_group_count[0], group_count.data(), MAX_GROUPS * sizeof(short));
+    for (int sg = 0; sg < MAX_GROUPS; sg++)
+      copy(group.begin() + sg * total_segment, group.begin() + sg * total_segment + group_count[sg], qo->segment_group[0] + sg * total_segment);
+    memcpy(qo->par_segment[0], par_segment.data(), par_segment_count * sizeof(short));
+    qo->par_segment_count[0] = par_segment_count;
+    qo->last_segment[0] = last_segment;
+
+    if (!custom) CubDebugExit(deviceFreeHost(resGPU));
+
+    deviceEventRecord(stop, 0);
+    deviceEventSynchronize(stop);
+    deviceEventElapsedTime(&time, start, stop);
+    if (verbose) cout << "Probe time " << time << " (" << run_count[0] + run_count[1] << " segments missed the result cache, " << run_count[1] << " cached)" << endl;
+    cgp->execution_total += time;
+  }
+
+  deviceEventRecord(start, 0);
+
+  memcpy(params->res, result_sum.data(), res_array_size * sizeof(int));
+
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
+  if (verbose) cout << "Merge time " << time << endl;
+  cgp->merging_total += time;
+}
 
 void
 QueryProcessing::runQuery2(CUcontext ctx) {
 
   SETUP_TIMING();
   float time;
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
   
   for (int i = 0; i < qo->join.size(); i++) {
     int table_id = qo->join[i].second->table_id;
+    if (sharedBuild(qo->join[i].second)) continue;
 
     // for (short j = 0; j < qo->par_segment_count[table_id]; j++) {
 
     parallel_for(short(0), qo->par_segment_count[table_id], [=](short j){
 
       CUcontext poppedCtx;
-      cuCtxPushCurrent(ctx);
+      deviceCtxPushCurrent(ctx);
 
       int sg = qo->par_segment[table_id][j];
 
@@ -1494,92 +1675,93 @@ QueryProcessing::runQuery2(CUcontext ctx) {
         printf("sg = %d\n", sg);
       }
 
-      CubDebugExit(cudaStreamCreate(&streams[sg]));
+      CubDebugExit(deviceStreamCreate(&streams[sg]));
 
       if (qo->segment_group_count[table_id][sg] > 0) {
         executeTableDim(table_id, sg);
       }
 
-      CubDebugExit(cudaStreamSynchronize(streams[sg]));
-      CubDebugExit(cudaStreamDestroy(streams[sg]));
+      CubDebugExit(deviceStreamSynchronize(streams[sg]));
+      CubDebugExit(deviceStreamDestroy(streams[sg]));
 
-      cuCtxPopCurrent(&poppedCtx);
+      deviceCtxPopCurrent(&poppedCtx);
 
     });
     
     // }
 
-    CubDebugExit(cudaDeviceSynchronize());
+    CubDebugExit(deviceSynchronize());
+    publishBuild(qo->join[i].second);
   }
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
   if (verbose) cout << "Build time " << time << endl;
   cgp->execution_total += time;
 
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   parallel_for(short(0), qo->par_segment_count[0], [=](short i){
 
     CUcontext poppedCtx;
-    cuCtxPushCurrent(ctx);
+    deviceCtxPushCurrent(ctx);
 
   //for (int i = 0; i < qo->par_segment_count[0]; i++) {
     int sg = qo->par_segment[0][i];
 
-    CubDebugExit(cudaStreamCreate(&streams[sg]));
+    CubDebugExit(deviceStreamCreate(&streams[sg]));
 
     float time_;
-    cudaEvent_t start_, stop_; 
-    cudaEventCreate(&start_); cudaEventCreate(&stop_);
-    cudaEventRecord(start_, 0);
+    deviceEvent_t start_, stop_; 
+    deviceEventCreate(&start_); deviceEventCreate(&stop_);
+    deviceEventRecord(start_, 0);
 
     if (qo->segment_group_count[0][sg] > 0) {
       executeTableFact_v2(sg);
     }
 
-    cudaEventRecord(stop_, 0);
-    cudaEventSynchronize(stop_);
-    cudaEventElapsedTime(&time_, start_, stop_);
+    deviceEventRecord(stop_, 0);
+    deviceEventSynchronize(stop_);
+    deviceEventElapsedTime(&time_, start_, stop_);
 
     if (verbose) cout << "sg = " << sg << " non demand time = " << time_ << endl;
 
-    CubDebugExit(cudaStreamSynchronize(streams[sg]));
-    CubDebugExit(cudaStreamDestroy(streams[sg]));
+    CubDebugExit(deviceStreamSynchronize(streams[sg]));
+    CubDebugExit(deviceStreamDestroy(streams[sg]));
 
-    cuCtxPopCurrent(&poppedCtx);
+    deviceCtxPopCurrent(&poppedCtx);
 
   });
 
-  CubDebugExit(cudaDeviceSynchronize());
+  CubDebugExit(deviceSynchronize());
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
   if (verbose) cout << "Probe time " << time << endl;
   cgp->execution_total += time;
   
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   int* resGPU;
-  if (custom) resGPU = (int*) cm->customCudaHostAlloc<int>(params->total_val * 6);
-  else CubDebugExit(cudaHostAlloc((void**) &resGPU, params->total_val * 6 * sizeof(int), cudaHostAllocDefault));
-  CubDebugExit(cudaMemcpy(resGPU, params->d_res, params->total_val * 6 * sizeof(int), cudaMemcpyDeviceToHost));
+  if (custom) resGPU = (int*) cm->customCudaHostAlloc<int>(params->total_val * 6, cgp->scope);
+  else CubDebugExit(deviceHostAlloc((void**) &resGPU, params->total_val * 6 * sizeof(int), cudaHostAllocDefault));
+  CubDebugExit(deviceMemcpy(resGPU, params->d_res, params->total_val * 6 * sizeof(int), cudaMemcpyDeviceToHost));
   cgp->gpu_to_cpu_total += (params->total_val * 6 * sizeof(int));
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
   cgp->execution_total += time;
 
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   merge(params->res, resGPU, params->total_val);
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
   if (verbose) cout << "Merge time " << time << endl;
   cgp->merging_total += time;
 }
@@ -1589,7 +1771,7 @@ QueryProcessing::runQueryNP(CUcontext ctx) {
 
   SETUP_TIMING();
   float time;
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   for (int i = 0; i < qo->join.size(); i++) {
     int table_id = qo->join[i].second->table_id;
@@ -1599,7 +1781,7 @@ QueryProcessing::runQueryNP(CUcontext ctx) {
     parallel_for(short(0), qo->par_segment_count[table_id], [=](short j){
 
       CUcontext poppedCtx;
-      cuCtxPushCurrent(ctx);
+      deviceCtxPushCurrent(ctx);
 
       int sg = qo->par_segment[table_id][j];
 
@@ -1608,96 +1790,101 @@ QueryProcessing::runQueryNP(CUcontext ctx) {
         printf("sg = %d\n", sg);
       }
 
-      CubDebugExit(cudaStreamCreate(&streams[sg]));
+      CubDebugExit(deviceStreamCreate(&streams[sg]));
 
       if (qo->segment_group_count[table_id][sg] > 0) {
         executeTableDimNP(table_id, sg);
       }
 
-      CubDebugExit(cudaStreamSynchronize(streams[sg]));
-      CubDebugExit(cudaStreamDestroy(streams[sg]));
+      CubDebugExit(deviceStreamSynchronize(streams[sg]));
+      CubDebugExit(deviceStreamDestroy(streams[sg]));
 
-      cuCtxPopCurrent(&poppedCtx);
+      deviceCtxPopCurrent(&poppedCtx);
 
     });
 
-    CubDebugExit(cudaDeviceSynchronize());
+    CubDebugExit(deviceSynchronize());
   }
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
   if (verbose) cout << "Build time " << time << endl;
   cgp->execution_total += time;
 
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   parallel_for(short(0), qo->par_segment_count[0], [=](short i){
 
     CUcontext poppedCtx;
-    cuCtxPushCurrent(ctx);
+    deviceCtxPushCurrent(ctx);
 
   //for (int i = 0; i < qo->par_segment_count[0]; i++) {
     int sg = qo->par_segment[0][i];
 
-    CubDebugExit(cudaStreamCreate(&streams[sg]));
+    CubDebugExit(deviceStreamCreate(&streams[sg]));
 
     float time_;
-    cudaEvent_t start_, stop_; 
-    cudaEventCreate(&start_); cudaEventCreate(&stop_);
-    cudaEventRecord(start_, 0);
+    deviceEvent_t start_, stop_; 
+    deviceEventCreate(&start_); deviceEventCreate(&stop_);
+    deviceEventRecord(start_, 0);
 
     if (qo->segment_group_count[0][sg] > 0) {
       executeTableFactNP(sg);
     }
 
-    cudaEventRecord(stop_, 0);
-    cudaEventSynchronize(stop_);
-    cudaEventElapsedTime(&time_, start_, stop_);
+    deviceEventRecord(stop_, 0);
+    deviceEventSynchronize(stop_);
+    deviceEventElapsedTime(&time_, start_, stop_);
 
     if (verbose) cout << "sg = " << sg << " non demand time = " << time_ << endl;
 
-    CubDebugExit(cudaStreamSynchronize(streams[sg]));
-    CubDebugExit(cudaStreamDestroy(streams[sg]));
+    CubDebugExit(deviceStreamSynchronize(streams[sg]));
+    CubDebugExit(deviceStreamDestroy(streams[sg]));
 
-    cuCtxPopCurrent(&poppedCtx);
+    deviceCtxPopCurrent(&poppedCtx);
 
   });
 
-  CubDebugExit(cudaDeviceSynchronize());
+  CubDebugExit(deviceSynchronize());
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
   if (verbose) cout << "Probe time " << time << endl;
   cgp->execution_total += time;
   
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   int* resGPU;
-  if (custom) resGPU = (int*) cm->customCudaHostAlloc<int>(params->total_val * 6);
-  else CubDebugExit(cudaHostAlloc((void**) &resGPU, params->total_val * 6 * sizeof(int), cudaHostAllocDefault));
-  CubDebugExit(cudaMemcpy(resGPU, params->d_res, params->total_val * 6 * sizeof(int), cudaMemcpyDeviceToHost));
+  if (custom) resGPU = (int*) cm->customCudaHostAlloc<int>(params->total_val * 6, cgp->scope);
+  else CubDebugExit(deviceHostAlloc((void**) &resGPU, params->total_val * 6 * sizeof(int), cudaHostAllocDefault));
+  CubDebugExit(deviceMemcpy(resGPU, params->d_res, params->total_val * 6 * sizeof(int), cudaMemcpyDeviceToHost));
   cgp->gpu_to_cpu_total += (params->total_val * 6 * sizeof(int));
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
   cgp->execution_total += time;
 
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   merge(params->res, resGPU, params->total_val);
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
   if (verbose) cout << "Merge time " << time << endl;
   cgp->merging_total += time;
 }
 
 void
 QueryProcessing::runOnDemand() {
+  if (deviceIsHost()) {
+    cout << "On-demand execution needs a CUDA device" << endl;
+    assert(0);
+  }
+
   int sg = 0;
 
   for (int i = 0; i < qo->join.size(); i++) {
@@ -1707,7 +1894,7 @@ QueryProcessing::runOnDemand() {
     }
   }
 
-  CubDebugExit(cudaDeviceSynchronize());
+  CubDebugExit(deviceSynchronize());
 
   if (qo->segment_group_count[0][sg] > 0) {
     executeTableFactOD(sg);
@@ -1715,11 +1902,15 @@ QueryProcessing::runOnDemand() {
 
   cm->resetOnDemand();
 
-  CubDebugExit(cudaDeviceSynchronize());
+  CubDebugExit(deviceSynchronize());
 };
 
 void
 QueryProcessing::runHybridOnDemand(int options) {
+  if (deviceIsHost()) {
+    cout << "On-demand execution needs a CUDA device" << endl;
+    assert(0);
+  }
 
   assert(options == 1 || options == 2);
 
@@ -1732,23 +1923,23 @@ QueryProcessing::runHybridOnDemand(int options) {
 
       int sg = qo->par_segment[table_id][j];
 
-      CubDebugExit(cudaStreamCreate(&streams[sg]));
+      CubDebugExit(deviceStreamCreate(&streams[sg]));
 
       if (qo->segment_group_count[table_id][sg] > 0) {
         executeTableDim(table_id, sg);
       }
 
-      CubDebugExit(cudaStreamSynchronize(streams[sg]));
-      CubDebugExit(cudaStreamDestroy(streams[sg]));
+      CubDebugExit(deviceStreamSynchronize(streams[sg]));
+      CubDebugExit(deviceStreamDestroy(streams[sg]));
 
     });
 
-    CubDebugExit(cudaDeviceSynchronize());
+    CubDebugExit(deviceSynchronize());
   }
 
   SETUP_TIMING();
   float time;
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   parallel_for(short(0), qo->par_segment_count[0], [=](short i){
 
@@ -1757,67 +1948,67 @@ QueryProcessing::runHybridOnDemand(int options) {
 
     // cout << sg << endl;
 
-    CubDebugExit(cudaStreamCreate(&streams[sg]));
+    CubDebugExit(deviceStreamCreate(&streams[sg]));
 
     if (qo->segment_group_count[0][sg] > 0) {
       if ((sg & 0x40) == 0x40) {
         // cout << "sg1 " << sg << endl;
         float time;
         SETUP_TIMING();
-        cudaEventRecord(start, 0);
+        deviceEventRecord(start, 0);
 
         executeTableFactOD2(sg);
 
-        cudaEventRecord(stop, 0);
-        cudaEventSynchronize(stop);
-        cudaEventElapsedTime(&time, start, stop);
+        deviceEventRecord(stop, 0);
+        deviceEventSynchronize(stop);
+        deviceEventElapsedTime(&time, start, stop);
 
         if (verbose) cout << "sg = " << sg << " on demand time = " << time << endl;
       } else {
         // cout << "sg2 " << sg << endl;
         float time;
         SETUP_TIMING();
-        cudaEventRecord(start, 0);
+        deviceEventRecord(start, 0);
         if (options == 1) {
           executeTableFact_v1(sg);
         } else if (options == 2) {
           executeTableFact_v2(sg);
         }
-        cudaEventRecord(stop, 0);
-        cudaEventSynchronize(stop);
-        cudaEventElapsedTime(&time, start, stop);
+        deviceEventRecord(stop, 0);
+        deviceEventSynchronize(stop);
+        deviceEventElapsedTime(&time, start, stop);
 
         if (verbose) cout << "sg = " << sg << " non demand time = " << time << endl;
       }
     }
 
-    CubDebugExit(cudaStreamSynchronize(streams[sg]));
-    CubDebugExit(cudaStreamDestroy(streams[sg]));
+    CubDebugExit(deviceStreamSynchronize(streams[sg]));
+    CubDebugExit(deviceStreamDestroy(streams[sg]));
   // }
 
   });
 
   cm->resetOnDemand();
 
-  CubDebugExit(cudaDeviceSynchronize());
+  CubDebugExit(deviceSynchronize());
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
   if (verbose) cout << "Probe time " << time << endl;
 
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   int* resGPU;
-  if (custom) resGPU = (int*) cm->customCudaHostAlloc<int>(params->total_val * 6);
-  else CubDebugExit(cudaHostAlloc((void**) &resGPU, params->total_val * 6 * sizeof(int), cudaHostAllocDefault));
-  CubDebugExit(cudaMemcpy(resGPU, params->d_res, params->total_val * 6 * sizeof(int), cudaMemcpyDeviceToHost));
+  if (custom) resGPU = (int*) cm->customCudaHostAlloc<int>(params->total_val * 6, cgp->scope);
+  else CubDebugExit(deviceHostAlloc((void**) &resGPU, params->total_val * 6 * sizeof(int), cudaHostAllocDefault));
+  CubDebugExit(deviceMemcpy(resGPU, params->d_res, params->total_val * 6 * sizeof(int), cudaMemcpyDeviceToHost));
   cgp->gpu_to_cpu_total += (params->total_val * 6 * sizeof(int));
   merge(params->res, resGPU, params->total_val);
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
   if (verbose) cout << "Merge time " << time << endl;
 };
 
@@ -1826,7 +2017,7 @@ QueryProcessing::runQueryHE(CUcontext ctx) {
 
   SETUP_TIMING();
   float time;
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   for (int i = 0; i < qo->join.size(); i++) {
     int table_id = qo->join[i].second->table_id;
@@ -1836,7 +2027,7 @@ QueryProcessing::runQueryHE(CUcontext ctx) {
     parallel_for(int(0), qo->join[i].second->total_segment, [=](int j){
 
       CUcontext poppedCtx;
-      cuCtxPushCurrent(ctx);
+      deviceCtxPushCurrent(ctx);
 
       // cuCtxSetCurrent(ctx);
 
@@ -1847,94 +2038,94 @@ QueryProcessing::runQueryHE(CUcontext ctx) {
         printf("sg = %d\n", sg);
       }
 
-      CubDebugExit(cudaStreamCreate(&streams[sg]));
+      CubDebugExit(deviceStreamCreate(&streams[sg]));
 
       if (qo->segment_group_count[table_id][sg] > 0) {
         executeTableDim_HE(table_id, sg);
       }
 
-      CubDebugExit(cudaStreamSynchronize(streams[sg]));
-      CubDebugExit(cudaStreamDestroy(streams[sg]));
+      CubDebugExit(deviceStreamSynchronize(streams[sg]));
+      CubDebugExit(deviceStreamDestroy(streams[sg]));
 
       // cuCtxSetCurrent(NULL);
 
-      cuCtxPopCurrent(&poppedCtx);
-      // CHECK_CU_ERROR(cuCtxPopCurrent(&poppedCtx), "cuCtxPopCurrent");
+      deviceCtxPopCurrent(&poppedCtx);
+      // CHECK_CU_ERROR(deviceCtxPopCurrent(&poppedCtx), "cuCtxPopCurrent");
 
     });
 
     // }
 
-    CubDebugExit(cudaDeviceSynchronize());
+    CubDebugExit(deviceSynchronize());
   }
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
   if (verbose) cout << "Build time " << time << endl;
   cgp->execution_total += time;
 
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   parallel_for(int(0), cm->lo_orderdate->total_segment, [=](int i){
 
     CUcontext poppedCtx;
-    cuCtxPushCurrent(ctx);
+    deviceCtxPushCurrent(ctx);
 
     int sg = i;
 
-    CubDebugExit(cudaStreamCreate(&streams[sg]));
+    CubDebugExit(deviceStreamCreate(&streams[sg]));
 
     float time_;
-    cudaEvent_t start_, stop_; 
-    cudaEventCreate(&start_); cudaEventCreate(&stop_);
-    cudaEventRecord(start_, 0);
+    deviceEvent_t start_, stop_; 
+    deviceEventCreate(&start_); deviceEventCreate(&stop_);
+    deviceEventRecord(start_, 0);
 
     if (qo->segment_group_count[0][sg] > 0) {
       executeTableFact_HE(sg);
     }
 
-    cudaEventRecord(stop_, 0);
-    cudaEventSynchronize(stop_);
-    cudaEventElapsedTime(&time_, start_, stop_);
+    deviceEventRecord(stop_, 0);
+    deviceEventSynchronize(stop_);
+    deviceEventElapsedTime(&time_, start_, stop_);
 
     if (verbose) cout << "sg = " << sg << " non demand time = " << time_ << endl;
 
-    CubDebugExit(cudaStreamSynchronize(streams[sg]));
-    CubDebugExit(cudaStreamDestroy(streams[sg]));
+    CubDebugExit(deviceStreamSynchronize(streams[sg]));
+    CubDebugExit(deviceStreamDestroy(streams[sg]));
 
-    cuCtxPopCurrent(&poppedCtx);
+    deviceCtxPopCurrent(&poppedCtx);
 
   });
 
-  CubDebugExit(cudaDeviceSynchronize());
+  CubDebugExit(deviceSynchronize());
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
   if (verbose) cout << "Probe time " << time << endl;
   cgp->execution_total += time;
 
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   int* resGPU;
-  if (custom) resGPU = (int*) cm->customCudaHostAlloc<int>(params->total_val * 6);
-  else CubDebugExit(cudaHostAlloc((void**) &resGPU, params->total_val * 6 * sizeof(int), cudaHostAllocDefault));
-  CubDebugExit(cudaMemcpy(resGPU, params->d_res, params->total_val * 6 * sizeof(int), cudaMemcpyDeviceToHost));
+  if (custom) resGPU = (int*) cm->customCudaHostAlloc<int>(params->total_val * 6, cgp->scope);
+  else CubDebugExit(deviceHostAlloc((void**) &resGPU, params->total_val * 6 * sizeof(int), cudaHostAllocDefault));
+  CubDebugExit(deviceMemcpy(resGPU, params->d_res, params->total_val * 6 * sizeof(int), cudaMemcpyDeviceToHost));
   cgp->gpu_to_cpu_total += (params->total_val * 6 * sizeof(int));
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
   cgp->execution_total += time;
 
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   merge(params->res, resGPU, params->total_val);
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
   if (verbose) cout << "Merge time " << time << endl;
   cgp->merging_total += time;
 }
@@ -1943,7 +2134,7 @@ void
 QueryProcessing::profile() {
   for (int i = 0; i < NUM_QUERIES; i++) {
 
-    // cudaEvent_t start, stop;
+    // deviceEvent_t start, stop;
     SETUP_TIMING();
 
     float default_time = 0, time1 = 0, time2 = 0;
@@ -2093,8 +2284,19 @@ QueryProcessing::profile() {
   }
 }
 
+//the on-demand area behind the cache is one bump pointer of the cache manager, rewound by every on-demand
+//query, so on-demand queries need the cache to themselves
+static bool
+onDemandShared(CPUGPUProcessing* cgp) {
+  if (!cgp->shared_cm && cgp->cm->sessions == 0) return false;
+  cerr << "On-demand execution is off while other query contexts share the cache" << endl;
+  return true;
+}
+
 double
 QueryProcessing::processOnDemand() {
+  if (onDemandShared(cgp)) return 0;
+
   qo->parseQuery(query);
   qo->prepareQuery(query, dist);
   qo->prepareOperatorPlacement();
@@ -2104,7 +2306,7 @@ QueryProcessing::processOnDemand() {
   }
   params = qo->params;
 
-  // cudaEvent_t start, stop;
+  // deviceEvent_t start, stop;
   SETUP_TIMING();
   float time;
 
@@ -2155,6 +2357,7 @@ QueryProcessing::processOnDemand() {
 double
 QueryProcessing::processHybridOnDemand(int options) {
   assert(options == 1 || options == 2);
+  if (onDemandShared(cgp)) return 0;
 
   qo->parseQuery(query);
   qo->prepareQuery(query, dist);
@@ -2165,7 +2368,7 @@ QueryProcessing::processHybridOnDemand(int options) {
   }
   params = qo->params;
 
-  // cudaEvent_t start, stop;
+  // deviceEvent_t start, stop;
   SETUP_TIMING();
   float time;
 
@@ -2212,21 +2415,298 @@ QueryProcessing::processHybridOnDemand(int options) {
   return time;
 };
 
+//parse and draw the predicates of the query, unless processQueryPlanned already did for this run
+void
+QueryProcessing::prepareQueryParams() {
+  if (query_prepared) {
+    query_prepared = false;
+    return;
+  }
+  qo->parseQuery(query);
+  qo->prepareQuery(query, dist);
+}
+
+//plan cache key of the prepared query: the query, the eighths of every query column held in gpu
+//and the predicate ranges, so the same query over a different cache content or selectivity gets its own entry
+string
+QueryProcessing::planKey() {
+  string key = to_string(query);
+  for (int table_id = 0; table_id < qo->queryColumn.size(); table_id++) {
+    for (int i = 0; i < qo->queryColumn[table_id].size(); i++) {
+      ColumnInfo* column = qo->queryColumn[table_id][i];
+      key += "|" + to_string(column->column_id) + ":" + to_string(column->tot_seg_in_GPU * 8 / column->total_segment);
+    }
+  }
+  for (auto it = qo->params->compare1.begin(); it != qo->params->compare1.end(); it++) {
+    key += "|" + to_string(it->first->column_id) + "=" + to_string(it->second) + "-" + to_string(qo->params->compare2[it->first]);
+  }
+  return key;
+}
+
+//everything the hash table of a dimension depends on: key range, payload column and the dimension predicates
+string
+QueryProcessing::buildKey(ColumnInfo* pkey) {
+  string key = to_string(pkey->column_id) + ":" + to_string(params->dim_len[pkey]) + ":" + to_string(params->min_key[pkey]);
+  auto group = qo->groupby_build.find(pkey);
+  if (group != qo->groupby_build.end() && group->second.size() > 0) key += "|v" + to_string(group->second[0]->column_id);
+  auto select = qo->select_build.find(pkey);
+  if (select != qo->select_build.end()) {
+    for (int i = 0; i < select->second.size(); i++) {
+      ColumnInfo* column = select->second[i];
+      int mode = (params->mode.find(column) != params->mode.end()) ? params->mode[column] : 1;
+      key += "|" + to_string(column->column_id) + ":" + to_string(mode) + "=" + to_string(params->compare1[column]) + "-" + to_string(params->compare2[column]);
+      key += "@" + to_string((unsigned long long) params->map_filter_func_host[column]);
+    }
+  }
+  return key;
+}
+
+//probes the cached hash tables of the dimension instead of building them, false on a miss
+bool
+QueryProcessing::sharedBuild(ColumnInfo* pkey) {
+  //without custom the hash tables are freed one by one by clearPrepare
+  if (cm->ht_cache == NULL || !custom) return false;
+  int table_id = pkey->table_id;
+  bool need_CPU = qo->joinCPUcheck[table_id] && params->ht_CPU[pkey] != NULL;
+  bool need_GPU = qo->joinGPUcheck[table_id] && params->ht_GPU[pkey] != NULL;
+  htEntry* entry = cm->ht_cache->acquire(buildKey(pkey), need_CPU, need_GPU);
+  if (entry == NULL) return false;
+  ht_pins.push_back(entry);
+  if (need_CPU) params->ht_CPU[pkey] = entry->ht_CPU;
+  if (need_GPU) params->ht_GPU[pkey] = entry->ht_GPU;
+  return true;
+}
+
+void
+QueryProcessing::publishBuild(ColumnInfo* pkey) {
+  if (cm->ht_cache == NULL || !custom) return;
+  int table_id = pkey->table_id;
+  int* ht_CPU = qo->joinCPUcheck[table_id] ? params->ht_CPU[pkey] : NULL;
+  int* ht_GPU = qo->joinGPUcheck[table_id] ? params->ht_GPU[pkey] : NULL;
+  if (ht_CPU == NULL && ht_GPU == NULL) return;
+  cm->ht_cache->publish(buildKey(pkey), ht_CPU, ht_GPU, 2 * params->dim_len[pkey]);
+}
+
+//divisor taking a d_datekey (yyyymmdd) to the value of a date dimension column, 0 for the columns that are
+//not a function of the date key alone
+static int
+dateDivisor(CacheManager* cm, ColumnInfo* column) {
+  if (column == cm->d_datekey) return 1;
+  if (column == cm->d_yearmonthnum) return 100;
+  if (column == cm->d_year) return 10000;
+  return 0;
+}
+
+//do the date dimension predicates hold for every lo_orderdate of min .. max. the columns are monotone in the
+//date key, so checking both ends is enough. lo_orderdate is a foreign key, every row finds its date
+static bool
+dateCovers(CacheManager* cm, QueryParams* params, vector<ColumnInfo*>& select, int min, int max) {
+  for (int j = 0; j < select.size(); j++) {
+    ColumnInfo* column = select[j];
+    int divisor = dateDivisor(cm, column);
+    if (divisor == 0) return false;
+    int lo = params->compare1[column], hi = params->compare2[column];
+    int mode = (params->mode.find(column) != params->mode.end()) ? params->mode[column] : 1;
+    int first = min / divisor, last = max / divisor;
+    if (mode == 2) {
+      if (first != last || (first != lo && first != hi)) return false;
+    } else if (first < lo || last > hi) return false;
+  }
+  return true;
+}
+
+//result cache key of the prepared query: the query and its predicates except the lo_orderdate range and the date
+//dimension predicates, which blockKey adds per block
+string
+QueryProcessing::resultKey() {
+  string key = to_string(query);
+  for (auto it = params->compare1.begin(); it != params->compare1.end(); it++) {
+    ColumnInfo* column = it->first;
+    if (column == cm->lo_orderdate || column->table_id == cm->d_datekey->table_id) continue;
+    int mode = (params->mode.find(column) != params->mode.end()) ? params->mode[column] : 1;
+    key += "|" + to_string(column->column_id) + ":" + to_string(mode) + "=" + to_string(it->second) + "-" + to_string(params->compare2[column]);
+  }
+  return key;
+}
+
+//result_key, the part of the date range inside the segments of the block and the date dimension predicates
+//unless they hold on every date left (dateCovers). a block the range and the predicates cover has the same
+//entry for every query covering it
+string
+QueryProcessing::blockKey(int block) {
+  int total_segment = cm->lo_orderdate->total_segment;
+  int column = cm->lo_orderdate->column_id;
+  int first = block * RESULT_CACHE_BLOCK, last = min(first + RESULT_CACHE_BLOCK, total_segment);
+  int lo = cm->segment_min[column][first], hi = cm->segment_max[column][first];
+  for (int i = first + 1; i < last; i++) {
+    lo = min(lo, cm->segment_min[column][i]);
+    hi = max(hi, cm->segment_max[column][i]);
+  }
+  if (params->compare1.find(cm->lo_orderdate) != params->compare1.end()) {
+    lo = max(lo, params->compare1[cm->lo_orderdate]);
+    hi = min(hi, params->compare2[cm->lo_orderdate]);
+  }
+  string key = result_key + "#" + to_string(block) + ":" + to_string(lo) + "-" + to_string(hi);
+  if (lo > hi) return key; //no row passes the range
+
+  vector<ColumnInfo*> date_select;
+  string date_key;
+  for (auto it = params->compare1.begin(); it != params->compare1.end(); it++) {
+    ColumnInfo* column = it->first;
+    if (column->table_id != cm->d_datekey->table_id) continue;
+    int mode = (params->mode.find(column) != params->mode.end()) ? params->mode[column] : 1;
+    date_select.push_back(column);
+    date_key += "|" + to_string(column->column_id) + ":" + to_string(mode) + "=" + to_string(it->second) + "-" + to_string(params->compare2[column]);
+  }
+  if (!dateCovers(cm, params, date_select, lo, hi)) key += date_key;
+  return key;
+}
+
+//adds the cached partials of the blocks of lineorder segments to result_sum and hides their segments from
+//groupBitmapSegmentTable. blocks checkPredicate rules out entirely add nothing and are skipped as usual
+void
+QueryProcessing::lookupResults() {
+  int total_segment = cm->lo_orderdate->total_segment;
+  result_key = resultKey();
+  result_hit.assign(total_segment, 0);
+  result_sum.assign(params->total_val * 6, 0);
+  aggr_hit.clear(); //lookupAggregates refills it when the aggregates apply, runQueryCached reads it
+  for (int first = 0; first < total_segment; first += RESULT_CACHE_BLOCK) {
+    int last = min(first + RESULT_CACHE_BLOCK, total_segment);
+    bool live = false;
+    for (int i = first; i < last && !live; i++) live = qo->checkPredicate(0, i);
+    if (!live || !cm->result_cache->lookup(blockKey(first / RESULT_CACHE_BLOCK), result_sum.data())) continue;
+    fill(result_hit.begin() + first, result_hit.begin() + last, 1);
+  }
+  qo->segment_cached = result_hit.data();
+}
+
+//the segment aggregate the prepared query sums, NULL when it groups, joins anything but the date dimension or
+//filters the date dimension on a column that is not a function of the date key. lookupAggregates then checks
+//per segment that the date predicates keep every row (dateCovers)
+segmentAggregates*
+QueryProcessing::matchAggregates() {
+  if (!qo->groupby_build.empty() || params->total_val != 1) return NULL;
+  for (int i = 0; i < qo->join.size(); i++)
+    if (qo->join[i].second != cm->d_datekey) return NULL;
+  vector<ColumnInfo*>& select = qo->select_build[cm->d_datekey];
+  for (int j = 0; j < select.size(); j++)
+    if (dateDivisor(cm, select[j]) == 0 || params->compare1.find(select[j]) == params->compare1.end()) return NULL;
+
+  int measure = AggrMeasureCol;
+  if (qo->queryAggrColumn.size() == 2) measure = (params->h_group_func == &host_mul_func<int>) ? AggrMeasureMul : AggrMeasureSub;
+  else if (qo->queryAggrColumn.size() != 1) return NULL;
+
+  for (int i = 0; i < cm->segment_aggr.size(); i++) {
+    aggrHeader& h = cm->segment_aggr[i]->header;
+    if (h.measure != measure || qo->queryAggrColumn[0]->column_name != h.measure_col[0]) continue;
+    if (measure != AggrMeasureCol && qo->queryAggrColumn[1]->column_name != h.measure_col[1]) continue;
+    return cm->segment_aggr[i];
+  }
+  return NULL;
+}
+
+//answers the lineorder segments whose predicates are all either on a key of the segment aggregate or hold on
+//every row of the segment from the aggregate, their sum goes to aggr_sum and the segments are hidden from
+//groupBitmapSegmentTable together with the result cache hits
+void
+QueryProcessing::lookupAggregates() {
+  segmentAggregates* aggr = matchAggregates();
+  if (aggr == NULL) return;
+
+  int total_segment = cm->lo_orderdate->total_segment;
+  int key_mode[2] = {0, 0}, key_lo[2] = {0, 0}, key_hi[2] = {0, 0};
+  vector<ColumnInfo*> covering; //the other lineorder predicates
+  for (auto it = params->compare1.begin(); it != params->compare1.end(); it++) {
+    ColumnInfo* column = it->first;
+    if (column->table_id != 0) continue;
+    int mode = (params->mode.find(column) != params->mode.end()) ? params->mode[column] : 1;
+    int k = (column->column_name == aggr->header.key_col[0]) ? 0 : (column->column_name == aggr->header.key_col[1]) ? 1 : -1;
+    if (k < 0) {
+      covering.push_back(column);
+      continue;
+    }
+    key_mode[k] = (mode == 2) ? 2 : 1;
+    key_lo[k] = it->second;
+    key_hi[k] = params->compare2[column];
+  }
+
+  if (qo->segment_cached != NULL) aggr_hit.assign(qo->segment_cached, qo->segment_cached + total_segment);
+  else aggr_hit.assign(total_segment, 0);
+
+  vector<ColumnInfo*> date_select;
+  if (!qo->join.empty()) date_select = qo->select_build[cm->d_datekey];
+  int date_column = cm->lo_orderdate->column_id;
+
+  for (int i = 0; i < total_segment; i++) {
+    if (aggr_hit[i] || !qo->checkPredicate(0, i)) continue;
+    if (!dateCovers(cm, params, date_select, cm->segment_min[date_column][i], cm->segment_max[date_column][i])) continue;
+    bool covered = true;
+    for (int j = 0; j < covering.size() && covered; j++) {
+      ColumnInfo* column = covering[j];
+      int mode = (params->mode.find(column) != params->mode.end()) ? params->mode[column] : 1;
+      int lo = params->compare1[column], hi = params->compare2[column];
+      int min = cm->segment_min[column->column_id][i], max = cm->segment_max[column->column_id][i];
+      if (mode == 2) covered = (min == max) && (min == lo || min == hi);
+      else covered = (lo <= min && max <= hi);
+    }
+    if (!covered) continue;
+    aggr_hit[i] = 1;
+    aggr_sum += aggrSegmentSum(aggr, i, key_mode, key_lo, key_hi);
+    qo->aggregated_segment += qo->queryColumn[0].size();
+  }
+  qo->segment_cached = aggr_hit.data();
+}
+
+//the non pipelined and segment level paths only exist as CUDA kernels, the emulated device reports them
+static bool
+needsDevice(const char* execution) {
+  if (!deviceIsHost()) return false;
+  cerr << execution << " needs a CUDA device" << endl;
+  return true;
+}
+
+//runs the query once with the variant the plan cache picks, and teaches the cache its runtime
+double
+QueryProcessing::processQueryPlanned(CUcontext ctx) {
+  qo->parseQuery(query);
+  qo->prepareQuery(query, dist);
+  query_prepared = true;
+
+  string key = planKey();
+  PlanVariant variant = plan_cache->choose(query, key);
+  if (deviceIsHost() && planVariantNeedsDevice(variant)) variant = PlanRunQuery;
+  if (verbose) cout << "Plan: " << planVariantName(variant) << endl;
+
+  double time;
+  if (variant == PlanRunQuery2) {
+    //processQuery2 leaves the statistics to processQuery, which does not run here
+    updateStatsQuery();
+    time = processQuery2(ctx);
+  } else if (variant == PlanEMat) time = processQueryEMat(ctx);
+  else if (variant == PlanNP) time = processQueryNP(ctx);
+  else if (variant == PlanHE) time = processQueryHE(ctx);
+  else time = processQuery(ctx);
+
+  plan_cache->record(query, key, variant, time);
+  last_plan = variant;
+  return time;
+}
+
 double
 QueryProcessing::processQuery(CUcontext ctx) {
 
   SETUP_TIMING();
   float time;
 
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
-  qo->parseQuery(query);
-  qo->prepareQuery(query, dist);
+  prepareQueryParams();
   params = qo->params;
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
   cgp->execution_total += time;
 
   if (verbose) {
@@ -2234,17 +2714,22 @@ QueryProcessing::processQuery(CUcontext ctx) {
     cout << endl;
   }
 
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   qo->prepareOperatorPlacement();
+  bool result_cached = (cm->result_cache != NULL);
+  if (result_cached) lookupResults();
+  aggr_sum = 0;
+  if (segment_aggregates) lookupAggregates();
   qo->groupBitmapSegmentTable(0, query);
+  qo->segment_cached = NULL;
     for (int tbl = 0; tbl < qo->join.size(); tbl++) {
       qo->groupBitmapSegmentTable(qo->join[tbl].second->table_id, query);
   }
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
   cgp->optimization_total += time;
 
   if (verbose) {
@@ -2252,7 +2737,12 @@ QueryProcessing::processQuery(CUcontext ctx) {
     cout << endl;    
   }
 
-  TIME_FUNC(runQuery(ctx), time);
+  if (result_cached) {
+    TIME_FUNC(runQueryCached(ctx), time);
+  } else {
+    TIME_FUNC(runQuery(ctx), time);
+  }
+  if (aggr_sum != 0) reinterpret_cast<unsigned long long*>(&params->res[4])[0] += aggr_sum;
 
   for (int sg = 0 ; sg < MAX_GROUPS; sg++) {
     // cgp->cpu_time_total += cgp->cpu_time[sg];
@@ -2299,19 +2789,18 @@ QueryProcessing::processQuery(CUcontext ctx) {
 double
 QueryProcessing::processQuery2(CUcontext ctx) {
 
-  // cudaEvent_t start, stop;   // variables that holds 2 events 
+  // deviceEvent_t start, stop;   // variables that holds 2 events 
   SETUP_TIMING();
   float time;
 
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
-  qo->parseQuery(query);
-  qo->prepareQuery(query, dist);
+  prepareQueryParams();
   params = qo->params;
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
   cgp->execution_total += time;
 
   if (verbose) {
@@ -2319,17 +2808,24 @@ QueryProcessing::processQuery2(CUcontext ctx) {
     cout << endl;
   }
 
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
+  //the hits of the result cache and the segments the aggregates answer are added after runQuery2,
+  //the misses are not cached here (see runQueryCached)
   qo->prepareOperatorPlacement();
+  bool result_cached = (cm->result_cache != NULL);
+  if (result_cached) lookupResults();
+  aggr_sum = 0;
+  if (segment_aggregates) lookupAggregates();
   qo->groupBitmapSegmentTable(0, query);
+  qo->segment_cached = NULL;
     for (int tbl = 0; tbl < qo->join.size(); tbl++) {
       qo->groupBitmapSegmentTable(qo->join[tbl].second->table_id, query);
   }
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
   cgp->optimization_total += time;
 
   if (verbose) {
@@ -2338,6 +2834,8 @@ QueryProcessing::processQuery2(CUcontext ctx) {
   }
 
   TIME_FUNC(runQuery2(ctx), time);
+  if (result_cached) merge(params->res, result_sum.data(), params->total_val);
+  if (aggr_sum != 0) reinterpret_cast<unsigned long long*>(&params->res[4])[0] += aggr_sum;
 
   for (int sg = 0 ; sg < MAX_GROUPS; sg++) {
     // cgp->cpu_time_total += cgp->cpu_time[sg];
@@ -2384,19 +2882,20 @@ QueryProcessing::processQuery2(CUcontext ctx) {
 double
 QueryProcessing::processQueryNP(CUcontext ctx) {
 
-  // cudaEvent_t start, stop;   // variables that holds 2 events 
+  if (needsDevice("Non-pipelined execution")) return 0;
+
+  // deviceEvent_t start, stop;   // variables that holds 2 events 
   SETUP_TIMING();
   float time;
 
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
-  qo->parseQuery(query);
-  qo->prepareQuery(query, dist);
+  prepareQueryParams();
   params = qo->params;
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
   cgp->execution_total += time;
 
   if (verbose) {
@@ -2404,7 +2903,7 @@ QueryProcessing::processQueryNP(CUcontext ctx) {
     cout << endl;
   }
 
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   qo->prepareOperatorPlacement();
   qo->groupBitmapSegmentTable(0, query);
@@ -2412,9 +2911,9 @@ QueryProcessing::processQueryNP(CUcontext ctx) {
       qo->groupBitmapSegmentTable(qo->join[tbl].second->table_id, query);
   }
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
   cgp->optimization_total += time;
 
   if (verbose) {
@@ -2471,19 +2970,20 @@ QueryProcessing::processQueryNP(CUcontext ctx) {
 double
 QueryProcessing::processQueryEMat(CUcontext ctx) {
 
-  // cudaEvent_t start, stop;   // variables that holds 2 events 
+  if (needsDevice("Early materialization")) return 0;
+
+  // deviceEvent_t start, stop;   // variables that holds 2 events 
   SETUP_TIMING();
   float time;
 
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
-  qo->parseQuery(query);
-  qo->prepareQuery(query, dist);
+  prepareQueryParams();
   params = qo->params;
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
   cgp->execution_total += time;
 
   if (verbose) {
@@ -2491,7 +2991,7 @@ QueryProcessing::processQueryEMat(CUcontext ctx) {
     cout << endl;
   }
 
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   qo->prepareOperatorPlacementEMat();
   qo->groupBitmapSegmentTableEMat(0, query);
@@ -2499,9 +2999,9 @@ QueryProcessing::processQueryEMat(CUcontext ctx) {
       qo->groupBitmapSegmentTableEMat(qo->join[tbl].second->table_id, query);
   }
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
   cgp->optimization_total += time;
 
   if (verbose) {
@@ -2547,18 +3047,19 @@ QueryProcessing::processQueryEMat(CUcontext ctx) {
 double
 QueryProcessing::processQueryHE(CUcontext ctx) {
 
+  if (needsDevice("Segment-level execution")) return 0;
+
   SETUP_TIMING();
   float time;
 
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
-  qo->parseQuery(query);
-  qo->prepareQuery(query, dist);
+  prepareQueryParams();
   params = qo->params;
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
   cgp->execution_total += time;
 
   if (verbose) {
@@ -2566,7 +3067,7 @@ QueryProcessing::processQueryHE(CUcontext ctx) {
     cout << endl;
   }
 
-  cudaEventRecord(start, 0);
+  deviceEventRecord(start, 0);
 
   qo->prepareOperatorPlacementHE();
   qo->groupBitmapSegmentTableHE(0, query);
@@ -2574,9 +3075,9 @@ QueryProcessing::processQueryHE(CUcontext ctx) {
       qo->groupBitmapSegmentTableHE(qo->join[tbl].second->table_id, query);
   }
 
-  cudaEventRecord(stop, 0);
-  cudaEventSynchronize(stop);
-  cudaEventElapsedTime(&time, start, stop);
+  deviceEventRecord(stop, 0);
+  deviceEventSynchronize(stop);
+  deviceEventElapsedTime(&time, start, stop);
   cgp->optimization_total += time;
 
   if (verbose) {
@@ -2685,11 +3186,16 @@ QueryProcessing::percentageData() {
 void
 QueryProcessing::endQuery() {
 
+  cgp->free_ht_CPU_replica(params);
+
   qo->clearPrepare();
 
   // qo->clearVector();
 
-  cm->resetPointer();
+  for (int i = 0; i < ht_pins.size(); i++) cm->ht_cache->release(ht_pins[i]);
+  ht_pins.clear();
+
+  cgp->scope->release();
 
   cgp->resetCGP();
 
@@ -2704,8 +3210,12 @@ QueryProcessing::updateStatsQuery() {
   // query_freq[query]++;
 
   // double time_count = timestamp.count();
-  double time_count = logical_time;
-  logical_time += 20;
+  double time_count;
+  {
+    lock_guard<mutex> guard(cm->stats_lock);
+    time_count = *clock;
+    *clock += 20;
+  }
   // logical_time += qo->queryJoinColumn.size();
   // logical_time += qo->queryAggrColumn.size();
   // logical_time += qo->queryGroupByColumn.size();
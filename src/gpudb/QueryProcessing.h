@@ -2,9 +2,13 @@
 #define _QUERY_PROCESSING_H_
 
 #include "CPUGPUProcessing.h"
+#include "PlanCache.h"
+#include "HashTableCache.h"
+#include "ResultCache.h"
 #include "common.h"
 
 extern int queries[13];
+extern bool segment_aggregates;
 
 class QueryProcessing {
 public:
@@ -22,9 +26,23 @@ public:
   bool skipping;
 
   double logical_time;
+  double* clock; //&logical_time, or the clock of the QueryProcessing whose cache manager this one shares
 
   Distribution dist;
 
+  PlanCache* plan_cache;
+  PlanVariant last_plan; //variant processQueryPlanned ran last
+  bool query_prepared; //query parsed and its predicates drawn by processQueryPlanned
+
+  vector<htEntry*> ht_pins; //entries of cm->ht_cache the running query probes, released by endQuery
+
+  string result_key; //resultKey of the running query
+  vector<char> result_hit; //lineorder segments answered by cm->result_cache, whole blocks
+  vector<int> result_sum; //their partial aggregates added up, in the layout of params->res
+
+  vector<char> aggr_hit; //lineorder segments answered by cm->segment_aggr, and the result cache hits
+  long long aggr_sum; //sum of the segments answered by cm->segment_aggr
+
   QueryProcessing(CPUGPUProcessing* _cgp, bool _verbose, Distribution _dist = None) {
     cgp = _cgp;
     qo = cgp->qo;
@@ -35,10 +53,16 @@ public:
     custom = cgp->custom;
     skipping = cgp->skipping;
     logical_time = 0;
+    clock = &logical_time;
+    plan_cache = new PlanCache();
+    last_plan = PlanRunQuery;
+    query_prepared = false;
+    aggr_sum = 0;
   }
 
   ~QueryProcessing() {
     // query_freq.clear();
+    delete plan_cache;
   }
 
   void generate_rand_query() {
@@ -51,8 +75,16 @@ public:
     query = _query;
   }
 
+  bool isPipelineCPU(int sg);
+
+  void buildDims(CUcontext ctx = NULL);
+
+  void probeFact(CUcontext ctx = NULL);
+
   void runQuery(CUcontext ctx = NULL);
 
+  void runQueryCached(CUcontext ctx = NULL);
+
   void runQuery2(CUcontext ctx = NULL);
 
   void runQueryNP(CUcontext ctx = NULL);
@@ -69,6 +101,28 @@ public:
 
   void updateStatsQuery();
 
+  void prepareQueryParams();
+
+  string planKey();
+
+  string buildKey(ColumnInfo* pkey);
+
+  bool sharedBuild(ColumnInfo* pkey);
+
+  void publishBuild(ColumnInfo* pkey);
+
+  string resultKey();
+
+  string blockKey(int block);
+
+  void lookupResults();
+
+  segmentAggregates* matchAggregates();
+
+  void lookupAggregates();
+
+  double processQueryPlanned(CUcontext ctx = NULL);
+
   double processQuery(CUcontext ctx = NULL);
 
   double processQuery2(CUcontext ctx = NULL);
@@ -0,0 +1,173 @@
+#ifndef _QUERY_TRACE_H_
+#define _QUERY_TRACE_H_
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <map>
+
+//per query record of the segments a workload touches, written by a run with CacheManager::trace set and
+//replayed by cachesim against the replacement policies without a gpu. text format:
+//  column <column id> <name> <table id> <total segments>         once per column in id order, before the queries
+//  query <query> <time ms> <skipped segments> <accesses> <weights>
+//  t <column id> <segment id> <speedup> <in gpu>                 a segment the query read (updateSegmentStats),
+//                                                                speedup of its column, residency during the run
+//  w <column id> <segment id> <weight>                           weight the query added to a segment
+//  replace                                                       the run called runReplacement here
+
+#define TRACE_VERSION 1
+
+typedef struct traceColumn {
+  int column_id;
+  std::string name;
+  int table_id;
+  int total_segment;
+} traceColumn;
+
+typedef struct traceAccess {
+  int column_id;
+  int segment_id;
+  double speedup;
+  bool in_gpu;
+} traceAccess;
+
+typedef struct traceWeight {
+  int column_id;
+  int segment_id;
+  double weight;
+} traceWeight;
+
+typedef struct traceQuery {
+  int query;
+  double time;
+  int skipped;
+  std::vector<traceAccess> access;
+  std::vector<traceWeight> weight;
+  bool replace; //runReplacement ran after this query
+} traceQuery;
+
+class QueryTrace {
+public:
+  std::vector<traceColumn> column;
+  std::vector<traceQuery> queries;
+  traceQuery pending; //accesses of the running query, closed by endQuery
+  std::map<std::pair<int, int>, double> pending_weight; //the cost model adds to a segment many times per query
+
+  QueryTrace() {
+    pending.skipped = 0;
+    pending.replace = false;
+  }
+
+  void addColumn(int column_id, std::string name, int table_id, int total_segment) {
+    traceColumn col = {column_id, name, table_id, total_segment};
+    column.push_back(col);
+  }
+
+  void touch(int column_id, int segment_id, double speedup, bool in_gpu) {
+    traceAccess access = {column_id, segment_id, speedup, in_gpu};
+    pending.access.push_back(access);
+  }
+
+  void addWeight(int column_id, int segment_id, double weight) {
+    pending_weight[std::make_pair(column_id, segment_id)] += weight;
+  }
+
+  void skip(int segments) {
+    pending.skipped += segments;
+  }
+
+  void endQuery(int query, double time) {
+    pending.query = query;
+    pending.time = time;
+    for (auto it = pending_weight.begin(); it != pending_weight.end(); it++) {
+      traceWeight weight = {it->first.first, it->first.second, it->second};
+      pending.weight.push_back(weight);
+    }
+    queries.push_back(pending);
+    pending.access.clear();
+    pending.weight.clear();
+    pending_weight.clear();
+    pending.skipped = 0;
+    pending.replace = false;
+  }
+
+  void replacement() {
+    if (!queries.empty()) queries.back().replace = true;
+  }
+
+  bool validSegment(int column_id, int segment_id) {
+    return column_id >= 0 && column_id < column.size() && segment_id >= 0 && segment_id < column[column_id].total_segment;
+  }
+
+  bool write(std::string filename) {
+    std::ofstream out(filename.c_str());
+    if (!out) return false;
+
+    out << "# mordred segment trace " << TRACE_VERSION << "\n";
+    for (int i = 0; i < column.size(); i++)
+      out << "column " << column[i].column_id << " " << column[i].name << " " << column[i].table_id << " " << column[i].total_segment << "\n";
+    for (int i = 0; i < queries.size(); i++) {
+      traceQuery& q = queries[i];
+      out << "query " << q.query << " " << q.time << " " << q.skipped << " " << q.access.size() << " " << q.weight.size() << "\n";
+      for (int j = 0; j < q.access.size(); j++) {
+        traceAccess& a = q.access[j];
+        out << "t " << a.column_id << " " << a.segment_id << " " << a.speedup << " " << a.in_gpu << "\n";
+      }
+      for (int j = 0; j < q.weight.size(); j++) {
+        traceWeight& w = q.weight[j];
+        out << "w " << w.column_id << " " << w.segment_id << " " << w.weight << "\n";
+      }
+      if (q.replace) out << "replace\n";
+    }
+    return out.good();
+  }
+
+  bool read(std::string filename) {
+    std::ifstream in(filename.c_str());
+    if (!in) return false;
+
+    column.clear();
+    queries.clear();
+
+    std::string line;
+    while (std::getline(in, line)) {
+      if (line.empty() || line[0] == '#') continue;
+      std::istringstream fields(line);
+      std::string kind;
+      fields >> kind;
+      if (kind == "column") {
+        traceColumn col;
+        if (!(fields >> col.column_id >> col.name >> col.table_id >> col.total_segment)) return false;
+        column.push_back(col);
+      } else if (kind == "query") {
+        traceQuery q;
+        int num_access, num_weight;
+        std::string tag;
+        if (!(fields >> q.query >> q.time >> q.skipped >> num_access >> num_weight)) return false;
+        q.replace = false;
+        q.access.resize(num_access);
+        q.weight.resize(num_weight);
+        for (int j = 0; j < num_access; j++) {
+          traceAccess& a = q.access[j];
+          if (!(in >> tag >> a.column_id >> a.segment_id >> a.speedup >> a.in_gpu) || tag != "t") return false;
+          if (!validSegment(a.column_id, a.segment_id)) return false;
+        }
+        for (int j = 0; j < num_weight; j++) {
+          traceWeight& w = q.weight[j];
+          if (!(in >> tag >> w.column_id >> w.segment_id >> w.weight) || tag != "w") return false;
+          if (!validSegment(w.column_id, w.segment_id)) return false;
+        }
+        in >> std::ws;
+        queries.push_back(q);
+      } else if (kind == "replace") {
+        if (!queries.empty()) queries.back().replace = true;
+      } else {
+        return false;
+      }
+    }
+    return true;
+  }
+};
+
+#endif
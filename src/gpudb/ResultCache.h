@@ -0,0 +1,110 @@
+#ifndef _RESULT_CACHE_H_
+#define _RESULT_CACHE_H_
+
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+#define RESULT_CACHE_MB 256 //default budget of the cached partial aggregates
+#define RESULT_CACHE_BLOCK 8 //consecutive lineorder segments sharing an entry
+
+//partial aggregates of blocks of lineorder segments, shared by the queries of a CacheManager. an entry is the
+//result array (QueryParams::res) one block contributes to a query, keyed by the query, its predicates outside
+//the date, the part of the date range that overlaps the block and the date dimension predicates unless they
+//hold on all of that part (see QueryProcessing::blockKey). a block the date range covers has the same entry
+//for every range that covers it, so a query only scans the blocks its range cuts differently than the ones
+//before. only the groups with a nonzero aggregate are kept
+typedef struct resultPartial {
+  vector<int> slot; //group index in res
+  vector<int> row; //the 6 ints of every slot: 4 group by values and the 64 bit aggregate
+  list<string>::iterator lru;
+} resultPartial;
+
+class ResultCache {
+public:
+  map<string, resultPartial*> entries;
+  list<string> lru; //most recently used first
+  mutex lock;
+  size_t budget, used; //bytes
+  unsigned long long hits, misses, inserts, evictions;
+
+  ResultCache(size_t _budget = (size_t) RESULT_CACHE_MB * 1048576)
+    : budget(_budget), used(0), hits(0), misses(0), inserts(0), evictions(0) {}
+
+  ~ResultCache() {
+    clear();
+  }
+
+  //adds the partial of key to res, false on a miss
+  bool lookup(string key, int* res) {
+    lock_guard<mutex> guard(lock);
+    auto it = entries.find(key);
+    if (it == entries.end()) {
+      misses++;
+      return false;
+    }
+    resultPartial* partial = it->second;
+    lru.splice(lru.begin(), lru, partial->lru);
+    add(res, partial);
+    hits++;
+    return true;
+  }
+
+  //keeps the groups of res, the result of one segment
+  void insert(string key, int* res, int total_val) {
+    resultPartial* partial = new resultPartial();
+    for (int i = 0; i < total_val; i++) {
+      if (reinterpret_cast<unsigned long long*>(res)[i * 3 + 2] == 0) continue;
+      partial->slot.push_back(i);
+      partial->row.insert(partial->row.end(), res + i * 6, res + i * 6 + 6);
+    }
+
+    lock_guard<mutex> guard(lock);
+    if (entries.find(key) != entries.end()) {
+      delete partial;
+      return;
+    }
+    lru.push_front(key);
+    partial->lru = lru.begin();
+    entries[key] = partial;
+    used += size(key, partial);
+    inserts++;
+
+    while (used > budget && !lru.empty()) {
+      auto victim = entries.find(lru.back());
+      used -= size(victim->first, victim->second);
+      delete victim->second;
+      entries.erase(victim);
+      lru.pop_back();
+      evictions++;
+    }
+  }
+
+  //the group by values are the same in every partial of a slot, the aggregates add up
+  static void add(int* res, resultPartial* partial) {
+    for (int i = 0; i < partial->slot.size(); i++) {
+      int* dst = res + partial->slot[i] * 6;
+      const int* src = partial->row.data() + i * 6;
+      dst[0] = src[0]; dst[1] = src[1]; dst[2] = src[2]; dst[3] = src[3];
+      reinterpret_cast<unsigned long long*>(dst)[2] += reinterpret_cast<const unsigned long long*>(src)[2];
+    }
+  }
+
+  size_t size(const string& key, resultPartial* partial) {
+    return key.size() + sizeof(resultPartial) + (partial->slot.size() + partial->row.size()) * sizeof(int);
+  }
+
+  void clear() {
+    lock_guard<mutex> guard(lock);
+    for (auto it = entries.begin(); it != entries.end(); it++) delete it->second;
+    entries.clear();
+    lru.clear();
+    used = 0;
+  }
+};
+
+#endif
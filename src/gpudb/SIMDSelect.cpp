@@ -0,0 +1,427 @@
+#include "SIMDSelect.h"
+#include "SegmentPack.h"
+#include "SegmentSlice.h"
+
+#include <stdint.h>
+#include <immintrin.h>
+
+//byte j of select_perm[mask] is the lane of the j-th set bit of mask,
+//same compaction trick as the probe in src/cpu/join.cpp but moving the selected lanes to the front
+static uint64_t select_perm[256];
+
+static SelectISA detectSelectISA() {
+  for (int mask = 0; mask < 256; mask++) {
+    uint64_t perm = 0;
+    int j = 0;
+    for (int lane = 0; lane < 8; lane++) {
+      if (mask & (1 << lane)) {
+        perm |= ((uint64_t) lane) << (j * 8);
+        j++;
+      }
+    }
+    select_perm[mask] = perm;
+  }
+
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) return SelectAVX512;
+  if (__builtin_cpu_supports("avx2")) return SelectAVX2;
+  return SelectScalar;
+}
+
+//resolved once at load time, before any operator runs
+static SelectISA select_supported = detectSelectISA();
+static SelectISA select_isa = select_supported;
+
+SelectISA getSelectISA() {
+  return select_isa;
+}
+
+void setSelectISA(SelectISA isa) {
+  select_isa = (isa < select_supported) ? isa : select_supported;
+}
+
+template <int OP>
+inline bool selectPred(int x, int lo, int hi) {
+  if (OP == SelectRange) return (x >= lo && x <= hi);
+  else if (OP == SelectEQ) return (x == lo);
+  else return (x == lo || x == hi);
+}
+
+//branch free so the compiler can keep the loop tight
+template <int OP>
+static int selectDenseScalar(int* col, int offset, int num, int lo, int hi, int* sel) {
+  int count = 0;
+  for (int i = 0; i < num; i++) {
+    sel[count] = offset + i;
+    count += selectPred<OP>(col[offset + i], lo, hi);
+  }
+  return count;
+}
+
+template <int OP>
+static int selectSparseScalar(int* col, int* sel_in, int num, int lo, int hi, int* sel_out) {
+  int count = 0;
+  for (int i = 0; i < num; i++) {
+    int off = sel_in[i];
+    sel_out[count] = off;
+    count += selectPred<OP>(col[off], lo, hi);
+  }
+  return count;
+}
+
+template <int OP>
+__attribute__((target("avx2"))) inline __m256i selectMask8(__m256i x, __m256i vlo, __m256i vhi) {
+  if (OP == SelectRange) return _mm256_andnot_si256(_mm256_or_si256(_mm256_cmpgt_epi32(vlo, x), _mm256_cmpgt_epi32(x, vhi)), _mm256_set1_epi32(-1));
+  else if (OP == SelectEQ) return _mm256_cmpeq_epi32(x, vlo);
+  else return _mm256_or_si256(_mm256_cmpeq_epi32(x, vlo), _mm256_cmpeq_epi32(x, vhi));
+}
+
+//stores 8 lanes at sel + count, never past the current row since count <= i
+template <int OP>
+__attribute__((target("avx2,popcnt"))) static int selectDenseAVX2(int* col, int offset, int num, int lo, int hi, int* sel) {
+  __m256i vlo = _mm256_set1_epi32(lo);
+  __m256i vhi = _mm256_set1_epi32(hi);
+  __m256i idx = _mm256_setr_epi32(offset, offset + 1, offset + 2, offset + 3, offset + 4, offset + 5, offset + 6, offset + 7);
+  __m256i step = _mm256_set1_epi32(8);
+
+  int count = 0;
+  int i = 0;
+  for (; i + 8 <= num; i += 8) {
+    __m256i x = _mm256_loadu_si256((__m256i*) &col[offset + i]);
+    int mask = _mm256_movemask_ps(_mm256_castsi256_ps(selectMask8<OP>(x, vlo, vhi)));
+    __m256i perm = _mm256_cvtepu8_epi32(_mm_loadl_epi64((__m128i*) &select_perm[mask]));
+    _mm256_storeu_si256((__m256i*) &sel[count], _mm256_permutevar8x32_epi32(idx, perm));
+    count += _mm_popcnt_u32(mask);
+    idx = _mm256_add_epi32(idx, step);
+  }
+  return count + selectDenseScalar<OP>(col, offset + i, num - i, lo, hi, sel + count);
+}
+
+template <int OP>
+__attribute__((target("avx2,popcnt"))) static int selectSparseAVX2(int* col, int* sel_in, int num, int lo, int hi, int* sel_out) {
+  __m256i vlo = _mm256_set1_epi32(lo);
+  __m256i vhi = _mm256_set1_epi32(hi);
+
+  int count = 0;
+  int i = 0;
+  for (; i + 8 <= num; i += 8) {
+    __m256i idx = _mm256_loadu_si256((__m256i*) &sel_in[i]);
+    __m256i x = _mm256_i32gather_epi32(col, idx, 4);
+    int mask = _mm256_movemask_ps(_mm256_castsi256_ps(selectMask8<OP>(x, vlo, vhi)));
+    __m256i perm = _mm256_cvtepu8_epi32(_mm_loadl_epi64((__m128i*) &select_perm[mask]));
+    _mm256_storeu_si256((__m256i*) &sel_out[count], _mm256_permutevar8x32_epi32(idx, perm));
+    count += _mm_popcnt_u32(mask);
+  }
+  return count + selectSparseScalar<OP>(col, sel_in + i, num - i, lo, hi, sel_out + count);
+}
+
+template <int OP>
+__attribute__((target("avx512f"))) inline __mmask16 selectMask16(__m512i x, __m512i vlo, __m512i vhi) {
+  if (OP == SelectRange) return _mm512_cmpge_epi32_mask(x, vlo) & _mm512_cmple_epi32_mask(x, vhi);
+  else if (OP == SelectEQ) return _mm512_cmpeq_epi32_mask(x, vlo);
+  else return _mm512_cmpeq_epi32_mask(x, vlo) | _mm512_cmpeq_epi32_mask(x, vhi);
+}
+
+template <int OP>
+__attribute__((target("avx512f,popcnt"))) static int selectDenseAVX512(int* col, int offset, int num, int lo, int hi, int* sel) {
+  __m512i vlo = _mm512_set1_epi32(lo);
+  __m512i vhi = _mm512_set1_epi32(hi);
+  __m512i idx = _mm512_add_epi32(_mm512_set1_epi32(offset), _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+  __m512i step = _mm512_set1_epi32(16);
+
+  int count = 0;
+  int i = 0;
+  for (; i + 16 <= num; i += 16) {
+    __m512i x = _mm512_loadu_si512((void*) &col[offset + i]);
+    __mmask16 mask = selectMask16<OP>(x, vlo, vhi);
+    _mm512_mask_compressstoreu_epi32(&sel[count], mask, idx);
+    count += _mm_popcnt_u32(mask);
+    idx = _mm512_add_epi32(idx, step);
+  }
+  return count + selectDenseScalar<OP>(col, offset + i, num - i, lo, hi, sel + count);
+}
+
+template <int OP>
+__attribute__((target("avx512f,popcnt"))) static int selectSparseAVX512(int* col, int* sel_in, int num, int lo, int hi, int* sel_out) {
+  __m512i vlo = _mm512_set1_epi32(lo);
+  __m512i vhi = _mm512_set1_epi32(hi);
+
+  int count = 0;
+  int i = 0;
+  for (; i + 16 <= num; i += 16) {
+    __m512i idx = _mm512_loadu_si512((void*) &sel_in[i]);
+    __m512i x = _mm512_i32gather_epi32(idx, col, 4);
+    __mmask16 mask = selectMask16<OP>(x, vlo, vhi);
+    _mm512_mask_compressstoreu_epi32(&sel_out[count], mask, idx);
+    count += _mm_popcnt_u32(mask);
+  }
+  return count + selectSparseScalar<OP>(col, sel_in + i, num - i, lo, hi, sel_out + count);
+}
+
+template <int OP>
+static int selectPackedScalar(const unsigned int* blocks, int bits, int first, int num, int offset, int lo, int hi, int* sel) {
+  int count = 0;
+  for (int i = 0; i < num; i++) {
+    sel[count] = offset + i;
+    count += selectPred<OP>(packCode(blocks, bits, first + i), lo, hi);
+  }
+  return count;
+}
+
+//PACK_LANES rows at a time once the rows reach a lane group: code k of the 8 lanes is one shift of a word of
+//every lane, or'ed with the next word for a code straddling two. the next word is read even when not needed,
+//it is inside the block or the padding readPackedColumn leaves after the last one
+//a whole block with the width known at compile time, every load and shift of the unrolled loop is a constant
+template <int OP, int BITS>
+__attribute__((target("avx2,popcnt"))) static int selectPackedBlockAVX2(const unsigned int* block, int offset, int lo, int hi, int* sel) {
+  __m256i vlo = _mm256_set1_epi32(lo);
+  __m256i vhi = _mm256_set1_epi32(hi);
+  __m256i vmask = _mm256_set1_epi32((1 << BITS) - 1);
+  __m256i idx = _mm256_add_epi32(_mm256_set1_epi32(offset), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+  __m256i step = _mm256_set1_epi32(PACK_LANES);
+
+  int count = 0;
+  #pragma GCC unroll 32
+  for (int k = 0; k < 32; k++) {
+    const int word = k * BITS / 32, shift = k * BITS % 32;
+    __m256i x = _mm256_srli_epi32(_mm256_loadu_si256((__m256i*) &block[word * PACK_LANES]), shift);
+    if (shift + BITS > 32)
+      x = _mm256_or_si256(x, _mm256_slli_epi32(_mm256_loadu_si256((__m256i*) &block[(word + 1) * PACK_LANES]), 32 - shift));
+    x = _mm256_and_si256(x, vmask);
+    int mask = _mm256_movemask_ps(_mm256_castsi256_ps(selectMask8<OP>(x, vlo, vhi)));
+    __m256i perm = _mm256_cvtepu8_epi32(_mm_loadl_epi64((__m128i*) &select_perm[mask]));
+    _mm256_storeu_si256((__m256i*) &sel[count], _mm256_permutevar8x32_epi32(idx, perm));
+    count += _mm_popcnt_u32(mask);
+    idx = _mm256_add_epi32(idx, step);
+  }
+  return count;
+}
+
+typedef int (*select_packed_block_t)(const unsigned int*, int, int, int, int*);
+
+template <int OP, int BITS>
+struct selectPackedBlocks {
+  static void fill(select_packed_block_t* table) {
+    table[BITS] = &selectPackedBlockAVX2<OP, BITS>;
+    selectPackedBlocks<OP, BITS - 1>::fill(table);
+  }
+};
+
+template <int OP>
+struct selectPackedBlocks<OP, 0> {
+  static void fill(select_packed_block_t* table) { table[0] = NULL; }
+};
+
+template <int OP>
+static select_packed_block_t selectPackedBlock(int bits) {
+  static select_packed_block_t table[PACK_MAX_BITS + 1];
+  static bool filled = (selectPackedBlocks<OP, PACK_MAX_BITS>::fill(table), true);
+  (void) filled;
+  return (bits <= PACK_MAX_BITS) ? table[bits] : NULL;
+}
+
+template <int OP>
+__attribute__((target("avx2,popcnt"))) static int selectPackedLanesAVX2(const unsigned int* blocks, int bits, int first, int num, int offset, int lo, int hi, int* sel) {
+  __m256i vlo = _mm256_set1_epi32(lo);
+  __m256i vhi = _mm256_set1_epi32(hi);
+  __m256i vmask = _mm256_set1_epi32((1 << bits) - 1);
+  __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  __m256i step = _mm256_set1_epi32(PACK_LANES);
+
+  int head = (PACK_LANES - first % PACK_LANES) % PACK_LANES;
+  if (head > num) head = num;
+  int count = selectPackedScalar<OP>(blocks, bits, first, head, offset, lo, hi, sel);
+
+  int row = first + head;
+  const unsigned int* block = blocks + (long long) (row / PACK_BLOCK) * bits * PACK_LANES;
+  int bit = (row % PACK_BLOCK) / PACK_LANES * bits;
+  __m256i idx = _mm256_add_epi32(_mm256_set1_epi32(offset + head), lane);
+
+  int i = head;
+  for (; i + PACK_LANES <= num; i += PACK_LANES) {
+    int word = bit / 32, shift = bit % 32;
+    __m256i x = _mm256_srl_epi32(_mm256_loadu_si256((__m256i*) &block[word * PACK_LANES]), _mm_cvtsi32_si128(shift));
+    __m256i y = _mm256_sll_epi32(_mm256_loadu_si256((__m256i*) &block[(word + 1) * PACK_LANES]), _mm_cvtsi32_si128(32 - shift));
+    x = _mm256_and_si256(_mm256_or_si256(x, y), vmask);
+    int mask = _mm256_movemask_ps(_mm256_castsi256_ps(selectMask8<OP>(x, vlo, vhi)));
+    __m256i perm = _mm256_cvtepu8_epi32(_mm_loadl_epi64((__m128i*) &select_perm[mask]));
+    _mm256_storeu_si256((__m256i*) &sel[count], _mm256_permutevar8x32_epi32(idx, perm));
+    count += _mm_popcnt_u32(mask);
+    idx = _mm256_add_epi32(idx, step);
+    bit += bits;
+    if (bit == bits * 32) {
+      bit = 0;
+      block += bits * PACK_LANES;
+    }
+  }
+  return count + selectPackedScalar<OP>(blocks, bits, first + i, num - i, offset + i, lo, hi, sel + count);
+}
+
+//whole blocks (the common case, a batch of BATCH_SIZE rows) through the instance of their width
+template <int OP>
+static int selectPackedAVX2(const unsigned int* blocks, int bits, int first, int num, int offset, int lo, int hi, int* sel) {
+  select_packed_block_t block_func = selectPackedBlock<OP>(bits);
+  int count = 0;
+  int i = 0;
+  if (first % PACK_BLOCK == 0 && block_func != NULL) {
+    for (; i + PACK_BLOCK <= num; i += PACK_BLOCK)
+      count += block_func(blocks + (long long) ((first + i) / PACK_BLOCK) * bits * PACK_LANES, offset + i, lo, hi, sel + count);
+  }
+  if (i == num) return count;
+  return count + selectPackedLanesAVX2<OP>(blocks, bits, first + i, num - i, offset + i, lo, hi, sel + count);
+}
+
+//one word (64 rows) of a bit sliced block, plane is word w of the first plane. the bits of lo and hi become all
+//zero or all one masks, so every plane is the same few and / or with no branch on the predicate. the planes
+//stop once no row is both still passing and still equal to a bound
+template <int OP>
+static inline unsigned long long sliceWord(const unsigned long long* plane, int bits, int lo, int hi) {
+  if (OP == SelectRange) {
+    bool check_lo = (lo > 0), check_hi = (hi < (1 << bits) - 1);
+    unsigned long long gt = check_lo ? 0 : ~0ULL, eq_lo = check_lo ? ~0ULL : 0;
+    unsigned long long lt = check_hi ? 0 : ~0ULL, eq_hi = check_hi ? ~0ULL : 0;
+    for (int p = 0; p < bits; p++) {
+      unsigned long long x = plane[p * SLICE_WORDS];
+      unsigned long long c_lo = 0ULL - ((lo >> (bits - 1 - p)) & 1), c_hi = 0ULL - ((hi >> (bits - 1 - p)) & 1);
+      gt |= eq_lo & x & ~c_lo;
+      eq_lo &= ~(x ^ c_lo);
+      lt |= eq_hi & ~x & c_hi;
+      eq_hi &= ~(x ^ c_hi);
+      if (((gt | eq_lo) & (lt | eq_hi) & (eq_lo | eq_hi)) == 0) break;
+    }
+    return (gt | eq_lo) & (lt | eq_hi);
+  }
+
+  unsigned long long eq1 = ~0ULL, eq2 = (OP == SelectIN2) ? ~0ULL : 0;
+  for (int p = 0; p < bits; p++) {
+    unsigned long long x = plane[p * SLICE_WORDS];
+    eq1 &= ~(x ^ (0ULL - ((lo >> (bits - 1 - p)) & 1)));
+    if (OP == SelectIN2) eq2 &= ~(x ^ (0ULL - ((hi >> (bits - 1 - p)) & 1)));
+    if ((eq1 | eq2) == 0) break;
+  }
+  return eq1 | eq2;
+}
+
+template <int OP>
+static void sliceBitmapScalar(const unsigned long long* blocks, int bits, int first, int num, int lo, int hi, unsigned long long* bitmap) {
+  for (int w = 0; w < (num + 63) / 64; w++) {
+    int row = first + w * 64;
+    const unsigned long long* block = blocks + (long long) (row / SLICE_BLOCK) * bits * SLICE_WORDS;
+    bitmap[w] = sliceWord<OP>(block + (row % SLICE_BLOCK) / 64, bits, lo, hi);
+  }
+}
+
+//a whole block of SLICE_BLOCK rows per register, same planes as sliceWord
+template <int OP>
+__attribute__((target("avx2"))) static inline __m256i sliceBlockAVX2(const unsigned long long* block, int bits, int lo, int hi) {
+  __m256i ones = _mm256_set1_epi32(-1);
+  if (OP == SelectRange) {
+    bool check_lo = (lo > 0), check_hi = (hi < (1 << bits) - 1);
+    __m256i gt = check_lo ? _mm256_setzero_si256() : ones, eq_lo = check_lo ? ones : _mm256_setzero_si256();
+    __m256i lt = check_hi ? _mm256_setzero_si256() : ones, eq_hi = check_hi ? ones : _mm256_setzero_si256();
+    for (int p = 0; p < bits; p++) {
+      __m256i x = _mm256_loadu_si256((__m256i*) &block[p * SLICE_WORDS]);
+      __m256i c_lo = _mm256_set1_epi64x(0LL - ((lo >> (bits - 1 - p)) & 1));
+      __m256i c_hi = _mm256_set1_epi64x(0LL - ((hi >> (bits - 1 - p)) & 1));
+      gt = _mm256_or_si256(gt, _mm256_andnot_si256(c_lo, _mm256_and_si256(eq_lo, x)));
+      eq_lo = _mm256_andnot_si256(_mm256_xor_si256(x, c_lo), eq_lo);
+      lt = _mm256_or_si256(lt, _mm256_and_si256(c_hi, _mm256_andnot_si256(x, eq_hi)));
+      eq_hi = _mm256_andnot_si256(_mm256_xor_si256(x, c_hi), eq_hi);
+      __m256i live = _mm256_and_si256(_mm256_or_si256(gt, eq_lo), _mm256_or_si256(lt, eq_hi));
+      if (_mm256_testz_si256(live, _mm256_or_si256(eq_lo, eq_hi))) break;
+    }
+    return _mm256_and_si256(_mm256_or_si256(gt, eq_lo), _mm256_or_si256(lt, eq_hi));
+  }
+
+  __m256i eq1 = ones, eq2 = (OP == SelectIN2) ? ones : _mm256_setzero_si256();
+  for (int p = 0; p < bits; p++) {
+    __m256i x = _mm256_loadu_si256((__m256i*) &block[p * SLICE_WORDS]);
+    eq1 = _mm256_andnot_si256(_mm256_xor_si256(x, _mm256_set1_epi64x(0LL - ((lo >> (bits - 1 - p)) & 1))), eq1);
+    if (OP == SelectIN2) eq2 = _mm256_andnot_si256(_mm256_xor_si256(x, _mm256_set1_epi64x(0LL - ((hi >> (bits - 1 - p)) & 1))), eq2);
+    __m256i eq = _mm256_or_si256(eq1, eq2);
+    if (_mm256_testz_si256(eq, eq)) break;
+  }
+  return _mm256_or_si256(eq1, eq2);
+}
+
+template <int OP>
+__attribute__((target("avx2"))) static void sliceBitmapAVX2(const unsigned long long* blocks, int bits, int first, int num, int lo, int hi, unsigned long long* bitmap) {
+  int w = 0;
+  if (first % SLICE_BLOCK == 0) {
+    for (; (w + SLICE_WORDS) * 64 <= num; w += SLICE_WORDS) {
+      const unsigned long long* block = blocks + (long long) ((first + w * 64) / SLICE_BLOCK) * bits * SLICE_WORDS;
+      _mm256_storeu_si256((__m256i*) &bitmap[w], sliceBlockAVX2<OP>(block, bits, lo, hi));
+    }
+  }
+  sliceBitmapScalar<OP>(blocks, bits, first + w * 64, num - w * 64, lo, hi, bitmap + w);
+}
+
+template <int OP>
+static int selectDenseOp(int* col, int offset, int num, int lo, int hi, int* sel) {
+  switch (getSelectISA()) {
+    case SelectAVX512: return selectDenseAVX512<OP>(col, offset, num, lo, hi, sel);
+    case SelectAVX2: return selectDenseAVX2<OP>(col, offset, num, lo, hi, sel);
+    default: return selectDenseScalar<OP>(col, offset, num, lo, hi, sel);
+  }
+}
+
+template <int OP>
+static int selectSparseOp(int* col, int* sel_in, int num, int lo, int hi, int* sel_out) {
+  switch (getSelectISA()) {
+    case SelectAVX512: return selectSparseAVX512<OP>(col, sel_in, num, lo, hi, sel_out);
+    case SelectAVX2: return selectSparseAVX2<OP>(col, sel_in, num, lo, hi, sel_out);
+    default: return selectSparseScalar<OP>(col, sel_in, num, lo, hi, sel_out);
+  }
+}
+
+template <int OP>
+static int selectPackedOp(const unsigned int* blocks, int bits, int first, int num, int offset, int lo, int hi, int* sel) {
+  //lane groups of 8 rows, the avx2 unpack serves avx512 as well
+  if (getSelectISA() >= SelectAVX2) return selectPackedAVX2<OP>(blocks, bits, first, num, offset, lo, hi, sel);
+  return selectPackedScalar<OP>(blocks, bits, first, num, offset, lo, hi, sel);
+}
+
+template <int OP>
+static void sliceBitmapOp(const unsigned long long* blocks, int bits, int first, int num, int lo, int hi, unsigned long long* bitmap) {
+  //blocks of SLICE_BLOCK rows, the avx2 planes serve avx512 as well
+  if (getSelectISA() >= SelectAVX2) sliceBitmapAVX2<OP>(blocks, bits, first, num, lo, hi, bitmap);
+  else sliceBitmapScalar<OP>(blocks, bits, first, num, lo, hi, bitmap);
+  //rows past num (the rest of the block, or the zero padding after the segment) never pass
+  if (num % 64 != 0) bitmap[num / 64] &= (1ULL << (num % 64)) - 1;
+}
+
+int selectDense(SelectOp op, int* col, int offset, int num, int lo, int hi, int* sel) {
+  if (op == SelectRange) return selectDenseOp<SelectRange>(col, offset, num, lo, hi, sel);
+  else if (op == SelectEQ) return selectDenseOp<SelectEQ>(col, offset, num, lo, hi, sel);
+  else return selectDenseOp<SelectIN2>(col, offset, num, lo, hi, sel);
+}
+
+int selectSparse(SelectOp op, int* col, int* sel_in, int num, int lo, int hi, int* sel_out) {
+  if (op == SelectRange) return selectSparseOp<SelectRange>(col, sel_in, num, lo, hi, sel_out);
+  else if (op == SelectEQ) return selectSparseOp<SelectEQ>(col, sel_in, num, lo, hi, sel_out);
+  else return selectSparseOp<SelectIN2>(col, sel_in, num, lo, hi, sel_out);
+}
+
+int selectPacked(SelectOp op, const unsigned int* blocks, int bits, int first, int num, int offset, int lo, int hi, int* sel) {
+  if (op == SelectRange) return selectPackedOp<SelectRange>(blocks, bits, first, num, offset, lo, hi, sel);
+  else if (op == SelectEQ) return selectPackedOp<SelectEQ>(blocks, bits, first, num, offset, lo, hi, sel);
+  else return selectPackedOp<SelectIN2>(blocks, bits, first, num, offset, lo, hi, sel);
+}
+
+void sliceBitmap(SelectOp op, const unsigned long long* blocks, int bits, int first, int num, int lo, int hi, unsigned long long* bitmap) {
+  if (op == SelectRange) sliceBitmapOp<SelectRange>(blocks, bits, first, num, lo, hi, bitmap);
+  else if (op == SelectEQ) sliceBitmapOp<SelectEQ>(blocks, bits, first, num, lo, hi, bitmap);
+  else sliceBitmapOp<SelectIN2>(blocks, bits, first, num, lo, hi, bitmap);
+}
+
+int selectBitmap(const unsigned long long* bitmap, int num, int offset, int* sel) {
+  int count = 0;
+  for (int w = 0; w < (num + 63) / 64; w++) {
+    unsigned long long mask = bitmap[w];
+    while (mask != 0) {
+      sel[count++] = offset + w * 64 + __builtin_ctzll(mask);
+      mask &= mask - 1;
+    }
+  }
+  return count;
+}
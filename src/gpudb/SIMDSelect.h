@@ -0,0 +1,46 @@
+#ifndef _SIMD_SELECT_H_
+#define _SIMD_SELECT_H_
+
+//selection vector primitives for the cpu operators
+//every primitive writes the column offsets of the qualifying rows into sel and returns how many qualified
+
+enum SelectOp {
+  SelectRange, //lo <= x <= hi
+  SelectEQ, //x == lo
+  SelectIN2 //x == lo || x == hi
+};
+
+enum SelectISA {
+  SelectScalar,
+  SelectAVX2,
+  SelectAVX512
+};
+
+//filter mode of filterArgsCPU (1 between, 2 equal to one of two values) to a select op
+inline SelectOp selectOp(int mode, int lo, int hi) {
+  if (mode == 1) return SelectRange;
+  return (lo == hi) ? SelectEQ : SelectIN2;
+}
+
+//rows col[offset] .. col[offset + num - 1]
+int selectDense(SelectOp op, int* col, int offset, int num, int lo, int hi, int* sel);
+
+//rows col[sel_in[0]] .. col[sel_in[num - 1]], sel_out may be sel_in
+int selectSparse(SelectOp op, int* col, int* sel_in, int num, int lo, int hi, int* sel_out);
+
+//rows first .. first + num - 1 of a bit packed segment (SegmentPack.h) with bits bit codes, lo and hi are codes.
+//row first + i is written to sel as offset + i
+int selectPacked(SelectOp op, const unsigned int* blocks, int bits, int first, int num, int offset, int lo, int hi, int* sel);
+
+//bitmap of the rows first .. first + num - 1 of a bit sliced segment (SegmentSlice.h) with bits bit planes,
+//first a multiple of 64 and lo, hi codes. bit i of bitmap (word i / 64) is set when row first + i passes
+void sliceBitmap(SelectOp op, const unsigned long long* blocks, int bits, int first, int num, int lo, int hi, unsigned long long* bitmap);
+
+//rows of the set bits of the first num bits of bitmap, bit i is written to sel as offset + i
+int selectBitmap(const unsigned long long* bitmap, int num, int offset, int* sel);
+
+//picked from cpuid at load time, can be lowered for benchmarking
+SelectISA getSelectISA();
+void setSelectISA(SelectISA isa);
+
+#endif
@@ -0,0 +1,156 @@
+#ifndef _SEGMENT_AGGR_H_
+#define _SEGMENT_AGGR_H_
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstring>
+#include <cstdlib>
+
+//small materialized aggregates of the fact table, written by the loader next to the columns and listed in the
+//catalog: an aggrHeader and, per segment, the sum of a measure (a column, or two columns subtracted or
+//multiplied) for every combination of the values of one or two narrow key columns. a query without group by
+//that sums the same measure answers a segment from the sums when its predicates either hold on every row of
+//the segment (the segment min max) or are predicates on the keys, only the other segments are scanned
+
+#define AGGR_MAGIC 0x52474741 //"AGGR"
+#define AGGR_VERSION 1
+#define AGGR_NAME 32
+#define AGGR_MAX_BUCKETS 4096 //per segment, product of the key ranges
+
+//same order as AggrExprCPU
+enum AggrMeasure {
+  AggrMeasureCol, //measure_col[0]
+  AggrMeasureSub, //measure_col[0] - measure_col[1]
+  AggrMeasureMul //measure_col[0] * measure_col[1]
+};
+
+typedef struct aggrHeader {
+  unsigned int magic;
+  unsigned int version;
+  int len;
+  int seg_size;
+  int total_segment;
+  int measure;
+  char measure_col[2][AGGR_NAME]; //column names, the second one empty for AggrMeasureCol
+  char key_col[2][AGGR_NAME]; //the second one empty for a single key
+  int key_min[2];
+  int key_range[2]; //values key_min .. key_min + key_range - 1 of the whole column, 1 for a missing key
+} aggrHeader;
+
+typedef struct segmentAggregates {
+  aggrHeader header;
+  long long* sum; //aggrBuckets per segment, bucket (v1 - key_min[0]) * key_range[1] + v2 - key_min[1]
+  size_t bytes;
+} segmentAggregates;
+
+inline int aggrBuckets(const aggrHeader& header) {
+  return header.key_range[0] * header.key_range[1];
+}
+
+//computed in int like the aggregation of the pipelines
+inline int aggrMeasure(int measure, int a, int b) {
+  if (measure == AggrMeasureMul) return a * b;
+  if (measure == AggrMeasureSub) return a - b;
+  return a;
+}
+
+//key predicate of filterArgsCPU, mode 0 for a key without predicate
+inline bool aggrKeyMatch(int mode, int lo, int hi, int v) {
+  if (mode == 0) return true;
+  if (mode == 2) return v == lo || v == hi;
+  return lo <= v && v <= hi;
+}
+
+//sum of the measure over the rows of the segment whose keys pass the key predicates
+inline long long aggrSegmentSum(const segmentAggregates* aggr, int segment, const int* mode, const int* lo, const int* hi) {
+  const aggrHeader& h = aggr->header;
+  const long long* sum = aggr->sum + (size_t) segment * aggrBuckets(h);
+  long long total = 0;
+  for (int i = 0; i < h.key_range[0]; i++) {
+    if (!aggrKeyMatch(mode[0], lo[0], hi[0], h.key_min[0] + i)) continue;
+    for (int j = 0; j < h.key_range[1]; j++)
+      if (aggrKeyMatch(mode[1], lo[1], hi[1], h.key_min[1] + j)) total += sum[i * h.key_range[1] + j];
+  }
+  return total;
+}
+
+//measure and key columns by name, measure[1] and key[1] may be NULL. false when the keys are too wide
+inline bool writeSegmentAggregates(std::string filename, int measure, const char* measure_name[2], const int* measure_col[2],
+    const char* key_name[2], const int* key_col[2], int len, int seg_size, size_t* bytes = NULL) {
+  aggrHeader header;
+  memset(&header, 0, sizeof(aggrHeader));
+  header.magic = AGGR_MAGIC;
+  header.version = AGGR_VERSION;
+  header.len = len;
+  header.seg_size = seg_size;
+  header.total_segment = (len + seg_size - 1) / seg_size;
+  header.measure = measure;
+
+  for (int k = 0; k < 2; k++) {
+    if (measure_name[k] != NULL) strncpy(header.measure_col[k], measure_name[k], AGGR_NAME - 1);
+    header.key_range[k] = 1;
+    if (key_col[k] == NULL || len == 0) continue;
+    strncpy(header.key_col[k], key_name[k], AGGR_NAME - 1);
+    int min = key_col[k][0], max = key_col[k][0];
+    for (int i = 0; i < len; i++) {
+      if (key_col[k][i] < min) min = key_col[k][i];
+      if (key_col[k][i] > max) max = key_col[k][i];
+    }
+    if ((long long) max - min >= AGGR_MAX_BUCKETS) return false;
+    header.key_min[k] = min;
+    header.key_range[k] = max - min + 1;
+  }
+  if ((long long) header.key_range[0] * header.key_range[1] > AGGR_MAX_BUCKETS) return false;
+
+  int buckets = aggrBuckets(header);
+  std::vector<long long> sum((size_t) header.total_segment * buckets, 0);
+  for (int i = 0; i < len; i++) {
+    int b1 = (key_col[0] != NULL) ? key_col[0][i] - header.key_min[0] : 0;
+    int b2 = (key_col[1] != NULL) ? key_col[1][i] - header.key_min[1] : 0;
+    int b = measure_col[1] != NULL ? measure_col[1][i] : 0;
+    sum[(size_t) (i / seg_size) * buckets + b1 * header.key_range[1] + b2] += aggrMeasure(measure, measure_col[0][i], b);
+  }
+
+  if (bytes != NULL) *bytes = sum.size() * sizeof(long long);
+
+  std::ofstream out(filename.c_str(), std::ios::out | std::ios::binary);
+  if (!out) return false;
+  out.write((char*) &header, sizeof(aggrHeader));
+  out.write((char*) sum.data(), sum.size() * sizeof(long long));
+  return out.good();
+}
+
+//NULL when the file is missing or was written for another layout
+inline segmentAggregates* readSegmentAggregates(std::string filename, int len, int seg_size) {
+  std::ifstream in(filename.c_str(), std::ios::in | std::ios::binary);
+  if (!in) return NULL;
+
+  aggrHeader header;
+  in.read((char*) &header, sizeof(aggrHeader));
+  if (!in || header.magic != AGGR_MAGIC || header.version != AGGR_VERSION) return NULL;
+  if (header.len != len || header.seg_size != seg_size) return NULL;
+  if (header.key_range[0] < 1 || header.key_range[1] < 1 || (long long) header.key_range[0] * header.key_range[1] > AGGR_MAX_BUCKETS) return NULL;
+  header.measure_col[0][AGGR_NAME - 1] = header.measure_col[1][AGGR_NAME - 1] = 0;
+  header.key_col[0][AGGR_NAME - 1] = header.key_col[1][AGGR_NAME - 1] = 0;
+
+  segmentAggregates* aggr = new segmentAggregates();
+  aggr->header = header;
+  aggr->bytes = (size_t) header.total_segment * aggrBuckets(header) * sizeof(long long);
+  aggr->sum = (long long*) malloc(aggr->bytes + sizeof(long long));
+  in.read((char*) aggr->sum, aggr->bytes);
+  if (!in) {
+    free(aggr->sum);
+    delete aggr;
+    return NULL;
+  }
+  return aggr;
+}
+
+inline void freeSegmentAggregates(segmentAggregates* aggr) {
+  if (aggr == NULL) return;
+  free(aggr->sum);
+  delete aggr;
+}
+
+#endif
@@ -0,0 +1,266 @@
+#ifndef _SEGMENT_PACK_H_
+#define _SEGMENT_PACK_H_
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+//lightweight compression of the fact columns, written by the loader next to the column as <column>pack:
+//a packHeader, one segmentPack record per segment and the packed words of all segments.
+//every segment picks its own encoding: frame of reference (code = value - reference) or an order preserving
+//dictionary (code = rank of the value among the distinct values of the segment), whichever needs fewer bits.
+//codes are bit packed in blocks of PACK_BLOCK rows over PACK_LANES interleaved words, row k * PACK_LANES + l
+//of a block is code k of lane l, so PACK_LANES consecutive rows unpack with one vector shift and mask.
+//predicates are rewritten into code ranges (packPredicate) and evaluated without decoding the values
+
+#define PACK_MAGIC 0x4b434150 //"PACK"
+#define PACK_VERSION 1
+#define PACK_LANES 8
+#define PACK_BLOCK (PACK_LANES * 32) //a block of b bit codes is b * PACK_LANES words
+#define PACK_MAX_BITS 24 //wider segments are left unpacked
+#define PACK_MAX_DICT 65536
+
+enum PackEncoding {
+  PackNone, //read the raw column
+  PackFOR,
+  PackDict
+};
+
+typedef struct packHeader {
+  unsigned int magic;
+  unsigned int version;
+  int len;
+  int seg_size;
+  int total_segment;
+} packHeader;
+
+typedef struct segmentPack {
+  int encoding;
+  int bits;
+  int reference; //PackFOR
+  int dict_size; //PackDict, the sorted dictionary is stored in front of the blocks
+  long long offset; //first word of the segment in the packed words
+} segmentPack;
+
+typedef struct packedColumn {
+  int len;
+  int seg_size;
+  int total_segment;
+  segmentPack* segment;
+  unsigned int* words;
+  size_t packed_bytes; //of the segments that are packed
+  size_t raw_bytes; //the same segments unpacked
+} packedColumn;
+
+inline int packBits(unsigned int max_code) {
+  int bits = 1;
+  while (bits < 32 && (max_code >> bits) != 0) bits++;
+  return bits;
+}
+
+inline long long packWords(int num, int bits) {
+  return (long long) (num + PACK_BLOCK - 1) / PACK_BLOCK * bits * PACK_LANES;
+}
+
+inline const int* packDict(const packedColumn* pack, int segment) {
+  return (const int*) (pack->words + pack->segment[segment].offset);
+}
+
+inline const unsigned int* packBlocks(const packedColumn* pack, int segment) {
+  const segmentPack& seg = pack->segment[segment];
+  return pack->words + seg.offset + (seg.encoding == PackDict ? seg.dict_size : 0);
+}
+
+//code of row i of the segment
+inline int packCode(const unsigned int* blocks, int bits, int i) {
+  const unsigned int* block = blocks + (long long) (i / PACK_BLOCK) * bits * PACK_LANES;
+  int lane = i % PACK_LANES;
+  int bit = (i % PACK_BLOCK) / PACK_LANES * bits;
+  int word = bit / 32, shift = bit % 32;
+  unsigned long long pair = block[word * PACK_LANES + lane];
+  if (shift + bits > 32) pair |= (unsigned long long) block[(word + 1) * PACK_LANES + lane] << 32;
+  return (int) ((pair >> shift) & ((1ULL << bits) - 1));
+}
+
+inline int packValue(const packedColumn* pack, int segment, int code) {
+  const segmentPack& seg = pack->segment[segment];
+  if (seg.encoding == PackDict) return packDict(pack, segment)[code];
+  return seg.reference + code;
+}
+
+//predicate of filterArgsCPU (mode 2 is x == lo || x == hi, anything else lo <= x <= hi) on the codes of the
+//segment, same mode. false when no row of the segment can pass, a value missing from the segment becomes -1
+inline bool packPredicate(const packedColumn* pack, int segment, int mode, int& lo, int& hi) {
+  const segmentPack& seg = pack->segment[segment];
+  long long max_code = (seg.encoding == PackDict) ? seg.dict_size - 1 : (1LL << seg.bits) - 1;
+  const int* dict = (seg.encoding == PackDict) ? packDict(pack, segment) : NULL;
+
+  if (mode == 2) {
+    int val[2] = {lo, hi};
+    int code[2];
+    for (int k = 0; k < 2; k++) {
+      if (dict != NULL) {
+        const int* it = std::lower_bound(dict, dict + seg.dict_size, val[k]);
+        code[k] = (it != dict + seg.dict_size && *it == val[k]) ? (int) (it - dict) : -1;
+      } else {
+        long long c = (long long) val[k] - seg.reference;
+        code[k] = (c >= 0 && c <= max_code) ? (int) c : -1;
+      }
+    }
+    if (code[0] < 0 && code[1] < 0) return false;
+    lo = code[0];
+    hi = code[1];
+    return true;
+  }
+
+  long long from, to;
+  if (dict != NULL) {
+    from = std::lower_bound(dict, dict + seg.dict_size, lo) - dict;
+    to = (std::upper_bound(dict, dict + seg.dict_size, hi) - dict) - 1;
+  } else {
+    from = std::max((long long) lo - seg.reference, 0LL);
+    to = std::min((long long) hi - seg.reference, max_code);
+  }
+  if (from > to) return false;
+  lo = (int) from;
+  hi = (int) to;
+  return true;
+}
+
+//encoding of one segment, the dictionary is returned in dict when it wins
+inline void choosePack(const int* col, int num, segmentPack* seg, std::vector<int>& dict) {
+  memset(seg, 0, sizeof(segmentPack));
+  dict.clear();
+  if (num <= 0) return;
+
+  int min = col[0], max = col[0];
+  for (int i = 0; i < num; i++) {
+    if (col[i] < min) min = col[i];
+    if (col[i] > max) max = col[i];
+  }
+  unsigned long long range = (unsigned long long) ((long long) max - min);
+  int for_bits = (range >> 32) ? 32 : packBits((unsigned int) range);
+
+  //a dictionary only pays when the distinct values are a sparse part of the range
+  if (for_bits > 8) {
+    std::vector<int> values(col, col + num);
+    std::sort(values.begin(), values.end());
+    values.erase(std::unique(values.begin(), values.end()), values.end());
+    if (values.size() <= PACK_MAX_DICT) {
+      int dict_bits = packBits((unsigned int) values.size() - 1);
+      long long dict_words = packWords(num, dict_bits) + values.size();
+      if (dict_bits <= PACK_MAX_BITS && dict_words < packWords(num, for_bits)) {
+        seg->encoding = PackDict;
+        seg->bits = dict_bits;
+        seg->dict_size = values.size();
+        dict.swap(values);
+        return;
+      }
+    }
+  }
+
+  if (for_bits > PACK_MAX_BITS) return;
+  seg->encoding = PackFOR;
+  seg->bits = for_bits;
+  seg->reference = min;
+}
+
+//appends the blocks of the num codes of one segment to words
+inline void packSegment(const int* col, int num, const segmentPack& seg, const std::vector<int>& dict, std::vector<unsigned int>& words) {
+  size_t base = words.size();
+  words.resize(base + packWords(num, seg.bits), 0);
+  for (int i = 0; i < num; i++) {
+    unsigned int code = (seg.encoding == PackDict) ?
+      (unsigned int) (std::lower_bound(dict.begin(), dict.end(), col[i]) - dict.begin()) : (unsigned int) (col[i] - seg.reference);
+    unsigned int* block = &words[base + (size_t) (i / PACK_BLOCK) * seg.bits * PACK_LANES];
+    int lane = i % PACK_LANES;
+    int bit = (i % PACK_BLOCK) / PACK_LANES * seg.bits;
+    int word = bit / 32, shift = bit % 32;
+    block[word * PACK_LANES + lane] |= code << shift;
+    if (shift + seg.bits > 32) block[(word + 1) * PACK_LANES + lane] |= code >> (32 - shift);
+  }
+}
+
+//packs every segment of the column, returns the packed bytes and the raw bytes of the segments it could pack
+inline bool writePackedColumn(std::string filename, const int* col, int len, int seg_size, size_t* packed_bytes = NULL, size_t* raw_bytes = NULL) {
+  packHeader header = {PACK_MAGIC, PACK_VERSION, len, seg_size, (len + seg_size - 1) / seg_size};
+  std::vector<segmentPack> seg(header.total_segment);
+  std::vector<unsigned int> words;
+  std::vector<int> dict;
+  size_t packed = 0, raw = 0;
+
+  for (int i = 0; i < header.total_segment; i++) {
+    int num = (i == header.total_segment - 1) ? (len - seg_size * i) : seg_size;
+    const int* seg_col = col + (size_t) i * seg_size;
+    choosePack(seg_col, num, &seg[i], dict);
+    seg[i].offset = words.size();
+    if (seg[i].encoding == PackNone) continue;
+    words.insert(words.end(), (unsigned int*) dict.data(), (unsigned int*) dict.data() + dict.size());
+    packSegment(seg_col, num, seg[i], dict, words);
+    packed += (words.size() - seg[i].offset) * sizeof(unsigned int);
+    raw += (size_t) num * sizeof(int);
+  }
+
+  if (packed_bytes != NULL) *packed_bytes = packed;
+  if (raw_bytes != NULL) *raw_bytes = raw;
+
+  std::ofstream out(filename.c_str(), std::ios::out | std::ios::binary);
+  if (!out) return false;
+  out.write((char*) &header, sizeof(packHeader));
+  out.write((char*) seg.data(), seg.size() * sizeof(segmentPack));
+  out.write((char*) words.data(), words.size() * sizeof(unsigned int));
+  return out.good();
+}
+
+//NULL when the file is missing or was written for another layout
+inline packedColumn* readPackedColumn(std::string filename, int len, int seg_size) {
+  std::ifstream in(filename.c_str(), std::ios::in | std::ios::binary | std::ios::ate);
+  if (!in) return NULL;
+  long long file_size = in.tellg();
+  in.seekg(0);
+
+  packHeader header;
+  in.read((char*) &header, sizeof(packHeader));
+  if (!in || header.magic != PACK_MAGIC || header.version != PACK_VERSION) return NULL;
+  if (header.len != len || header.seg_size != seg_size) return NULL;
+
+  long long num_words = (file_size - (long long) sizeof(packHeader) - (long long) header.total_segment * sizeof(segmentPack)) / sizeof(unsigned int);
+  if (num_words < 0) return NULL;
+
+  packedColumn* pack = new packedColumn();
+  pack->len = len;
+  pack->seg_size = seg_size;
+  pack->total_segment = header.total_segment;
+  pack->segment = new segmentPack[header.total_segment];
+  //padded by one block so a vector unpack of the last block never reads past the end
+  pack->words = (unsigned int*) calloc(num_words + PACK_BLOCK, sizeof(unsigned int));
+  in.read((char*) pack->segment, (size_t) header.total_segment * sizeof(segmentPack));
+  in.read((char*) pack->words, (size_t) num_words * sizeof(unsigned int));
+  if (!in) {
+    delete[] pack->segment;
+    free(pack->words);
+    delete pack;
+    return NULL;
+  }
+
+  for (int i = 0; i < pack->total_segment; i++) {
+    const segmentPack& seg = pack->segment[i];
+    if (seg.encoding == PackNone) continue;
+    int num = (i == pack->total_segment - 1) ? (len - seg_size * i) : seg_size;
+    pack->packed_bytes += (packWords(num, seg.bits) + seg.dict_size) * sizeof(unsigned int);
+    pack->raw_bytes += (size_t) num * sizeof(int);
+  }
+  return pack;
+}
+
+inline void freePackedColumn(packedColumn* pack) {
+  if (pack == NULL) return;
+  delete[] pack->segment;
+  free(pack->words);
+  delete pack;
+}
+
+#endif
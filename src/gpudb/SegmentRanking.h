@@ -0,0 +1,155 @@
+#ifndef _SEGMENT_RANKING_H_
+#define _SEGMENT_RANKING_H_
+
+#include <math.h>
+#include <vector>
+
+//segment-level replacement state kept up to date as statistics change, instead of sorting every segment on each
+//replacement. cached segments sit in a min heap and uncached ones in a max heap, both on the policy key, so a
+//replacement only moves the heap tops that cross over and costs O(changes * log n).
+//keys are stored divided by scale: newEpoch multiplies every weight, frequency and backward distance by the same
+//factor, which only has to be applied to scale
+
+#define RANK_NONE (-HUGE_VAL) //key of a segment the policy never places (its statistic is not positive)
+
+template <typename SEG>
+class SegmentRanking {
+public:
+	int num_segment;
+	std::vector<int> column_offset; //first index of every column in key / pos / cached
+	std::vector<SEG*> segment;
+	std::vector<double> key;
+	std::vector<int> pos; //position in the heap holding the segment
+	std::vector<char> cached;
+	std::vector<int> in_heap; //cached segments, worst on top
+	std::vector<int> out_heap; //uncached segments, best on top
+	double scale;
+
+	SegmentRanking() : num_segment(0), scale(1) {}
+
+	int index(int column_id, int segment_id) { return column_offset[column_id] + segment_id; }
+
+	//heap of the segment prefers a over b at the top
+	bool above(int a, int b, bool in) {
+		return in ? (key[a] < key[b]) : (key[a] > key[b]);
+	}
+
+	std::vector<int>& heapOf(int idx) { return cached[idx] ? in_heap : out_heap; }
+
+	void siftUp(std::vector<int>& heap, int p, bool in) {
+		int idx = heap[p];
+		while (p > 0) {
+			int parent = (p - 1) / 2;
+			if (!above(idx, heap[parent], in)) break;
+			heap[p] = heap[parent];
+			pos[heap[p]] = p;
+			p = parent;
+		}
+		heap[p] = idx;
+		pos[idx] = p;
+	}
+
+	void siftDown(std::vector<int>& heap, int p, bool in) {
+		int idx = heap[p];
+		int n = heap.size();
+		while (true) {
+			int child = 2 * p + 1;
+			if (child >= n) break;
+			if (child + 1 < n && above(heap[child + 1], heap[child], in)) child++;
+			if (!above(heap[child], idx, in)) break;
+			heap[p] = heap[child];
+			pos[heap[p]] = p;
+			p = child;
+		}
+		heap[p] = idx;
+		pos[idx] = p;
+	}
+
+	void push(int idx) {
+		std::vector<int>& heap = heapOf(idx);
+		heap.push_back(idx);
+		siftUp(heap, heap.size() - 1, cached[idx]);
+	}
+
+	void remove(int idx) {
+		std::vector<int>& heap = heapOf(idx);
+		bool in = cached[idx];
+		int p = pos[idx];
+		int last = heap.back();
+		heap.pop_back();
+		if (last == idx) return;
+		heap[p] = last;
+		pos[last] = p;
+		siftDown(heap, p, in);
+		siftUp(heap, pos[last], in);
+	}
+
+	//columns[i] lists the segments of column i by segment id, raw gives the policy statistic of a segment
+	//and in_gpu whether it is cached right now
+	template <typename RAW, typename CACHED>
+	void build(std::vector<std::vector<SEG*>>& columns, RAW raw, CACHED in_gpu) {
+		column_offset.clear();
+		segment.clear();
+		num_segment = 0;
+		for (int i = 0; i < columns.size(); i++) {
+			column_offset.push_back(num_segment);
+			for (int j = 0; j < columns[i].size(); j++) segment.push_back(columns[i][j]);
+			num_segment += columns[i].size();
+		}
+		key.assign(num_segment, RANK_NONE);
+		pos.assign(num_segment, -1);
+		cached.assign(num_segment, 0);
+		in_heap.clear();
+		out_heap.clear();
+		scale = 1;
+		for (int idx = 0; idx < num_segment; idx++) {
+			key[idx] = raw(segment[idx]);
+			cached[idx] = in_gpu(segment[idx]);
+			push(idx);
+		}
+	}
+
+	//new statistic of a segment, already in the unscaled form of raw
+	void update(int idx, double value) {
+		double new_key = (value == RANK_NONE) ? RANK_NONE : value / scale;
+		if (new_key == key[idx]) return;
+		remove(idx);
+		key[idx] = new_key;
+		push(idx);
+	}
+
+	void setCached(int idx, bool in_gpu) {
+		if (cached[idx] == in_gpu) return;
+		remove(idx);
+		cached[idx] = in_gpu;
+		push(idx);
+	}
+
+	void rescale(double param) {
+		scale *= param;
+	}
+
+	//move heap tops until the capacity best placeable segments are the cached ones. the moves are returned
+	//in evict and admit, the caller applies them to the gpu cache (setCached is then a no-op)
+	void replace(int capacity, std::vector<SEG*>& evict, std::vector<SEG*>& admit) {
+		while (!in_heap.empty() && (key[in_heap[0]] == RANK_NONE || in_heap.size() > capacity)) {
+			int idx = in_heap[0];
+			setCached(idx, false);
+			evict.push_back(segment[idx]);
+		}
+		while (in_heap.size() < capacity && !out_heap.empty() && key[out_heap[0]] != RANK_NONE) {
+			int idx = out_heap[0];
+			setCached(idx, true);
+			admit.push_back(segment[idx]);
+		}
+		while (!in_heap.empty() && !out_heap.empty() && key[out_heap[0]] != RANK_NONE && key[out_heap[0]] > key[in_heap[0]]) {
+			int worst = in_heap[0], best = out_heap[0];
+			setCached(worst, false);
+			setCached(best, true);
+			evict.push_back(segment[worst]);
+			admit.push_back(segment[best]);
+		}
+	}
+};
+
+#endif
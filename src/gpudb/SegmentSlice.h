@@ -0,0 +1,170 @@
+#ifndef _SEGMENT_SLICE_H_
+#define _SEGMENT_SLICE_H_
+
+#include "SegmentPack.h"
+
+//vertical bit sliced copy of the low cardinality fact columns (lo_discount, lo_quantity, ...), written by the
+//loader next to the column as <column>slice: a sliceHeader, one segmentSlice record per segment and the words
+//of all segments. a segment stores the frame of reference codes (value - reference) of its rows in blocks of
+//SLICE_BLOCK rows, one bit plane after the other from the most significant bit down, each plane SLICE_WORDS
+//64 bit words with bit j of word w the bit of row w * 64 + j of the block. a range predicate on the codes is
+//evaluated plane by plane on 64 rows per word (256 per AVX2 register) and stops as soon as every row of the
+//block is decided, the result is a bitmap of the qualifying rows (sliceBitmap in SIMDSelect.h)
+
+#define SLICE_MAGIC 0x45434c53 //"SLCE"
+#define SLICE_VERSION 1
+#define SLICE_BLOCK 256
+#define SLICE_WORDS (SLICE_BLOCK / 64)
+#define SLICE_MAX_BITS 8 //wider segments are left unsliced
+
+typedef struct sliceHeader {
+  unsigned int magic;
+  unsigned int version;
+  int len;
+  int seg_size;
+  int total_segment;
+} sliceHeader;
+
+typedef struct segmentSlice {
+  int bits; //0 when the segment is not sliced
+  int reference;
+  long long offset; //first word of the segment
+} segmentSlice;
+
+typedef struct slicedColumn {
+  int len;
+  int seg_size;
+  int total_segment;
+  segmentSlice* segment;
+  unsigned long long* words;
+  size_t slice_bytes;
+} slicedColumn;
+
+inline long long sliceWords(int num, int bits) {
+  return (long long) (num + SLICE_BLOCK - 1) / SLICE_BLOCK * bits * SLICE_WORDS;
+}
+
+inline const unsigned long long* sliceBlocks(const slicedColumn* slice, int segment) {
+  return slice->words + slice->segment[segment].offset;
+}
+
+//predicate of filterArgsCPU (mode 2 is x == lo || x == hi, anything else lo <= x <= hi) on the codes of the
+//segment, same mode. false when no row of the segment can pass. a mode 2 value missing from the segment is
+//replaced by the other one
+inline bool slicePredicate(const slicedColumn* slice, int segment, int mode, int& lo, int& hi) {
+  const segmentSlice& seg = slice->segment[segment];
+  long long max_code = (1LL << seg.bits) - 1;
+
+  if (mode == 2) {
+    long long code_lo = (long long) lo - seg.reference, code_hi = (long long) hi - seg.reference;
+    bool has_lo = (code_lo >= 0 && code_lo <= max_code), has_hi = (code_hi >= 0 && code_hi <= max_code);
+    if (!has_lo && !has_hi) return false;
+    lo = (int) (has_lo ? code_lo : code_hi);
+    hi = (int) (has_hi ? code_hi : code_lo);
+    return true;
+  }
+
+  long long from = std::max((long long) lo - seg.reference, 0LL);
+  long long to = std::min((long long) hi - seg.reference, max_code);
+  if (from > to) return false;
+  lo = (int) from;
+  hi = (int) to;
+  return true;
+}
+
+//appends the blocks of the num rows of one segment to words
+inline void sliceSegment(const int* col, int num, const segmentSlice& seg, std::vector<unsigned long long>& words) {
+  size_t base = words.size();
+  words.resize(base + sliceWords(num, seg.bits), 0);
+  for (int i = 0; i < num; i++) {
+    unsigned int code = (unsigned int) (col[i] - seg.reference);
+    unsigned long long* block = &words[base + (size_t) (i / SLICE_BLOCK) * seg.bits * SLICE_WORDS];
+    int word = (i % SLICE_BLOCK) / 64;
+    unsigned long long bit = 1ULL << (i % 64);
+    for (int p = 0; p < seg.bits; p++)
+      if ((code >> (seg.bits - 1 - p)) & 1) block[p * SLICE_WORDS + word] |= bit;
+  }
+}
+
+//slices every segment of the column that fits SLICE_MAX_BITS, returns the bytes of the slices and the raw
+//bytes of the segments it sliced
+inline bool writeSlicedColumn(std::string filename, const int* col, int len, int seg_size, size_t* slice_bytes = NULL, size_t* raw_bytes = NULL) {
+  sliceHeader header = {SLICE_MAGIC, SLICE_VERSION, len, seg_size, (len + seg_size - 1) / seg_size};
+  std::vector<segmentSlice> seg(header.total_segment);
+  std::vector<unsigned long long> words;
+  size_t raw = 0;
+
+  for (int i = 0; i < header.total_segment; i++) {
+    int num = (i == header.total_segment - 1) ? (len - seg_size * i) : seg_size;
+    const int* seg_col = col + (size_t) i * seg_size;
+    memset(&seg[i], 0, sizeof(segmentSlice));
+    seg[i].offset = words.size();
+    if (num <= 0) continue;
+
+    int min = seg_col[0], max = seg_col[0];
+    for (int k = 0; k < num; k++) {
+      if (seg_col[k] < min) min = seg_col[k];
+      if (seg_col[k] > max) max = seg_col[k];
+    }
+    unsigned long long range = (unsigned long long) ((long long) max - min);
+    int bits = (range >> 32) ? 32 : packBits((unsigned int) range);
+    if (bits > SLICE_MAX_BITS) continue;
+
+    seg[i].bits = bits;
+    seg[i].reference = min;
+    sliceSegment(seg_col, num, seg[i], words);
+    raw += (size_t) num * sizeof(int);
+  }
+
+  if (slice_bytes != NULL) *slice_bytes = words.size() * sizeof(unsigned long long);
+  if (raw_bytes != NULL) *raw_bytes = raw;
+
+  std::ofstream out(filename.c_str(), std::ios::out | std::ios::binary);
+  if (!out) return false;
+  out.write((char*) &header, sizeof(sliceHeader));
+  out.write((char*) seg.data(), seg.size() * sizeof(segmentSlice));
+  out.write((char*) words.data(), words.size() * sizeof(unsigned long long));
+  return out.good();
+}
+
+//NULL when the file is missing or was written for another layout
+inline slicedColumn* readSlicedColumn(std::string filename, int len, int seg_size) {
+  std::ifstream in(filename.c_str(), std::ios::in | std::ios::binary | std::ios::ate);
+  if (!in) return NULL;
+  long long file_size = in.tellg();
+  in.seekg(0);
+
+  sliceHeader header;
+  in.read((char*) &header, sizeof(sliceHeader));
+  if (!in || header.magic != SLICE_MAGIC || header.version != SLICE_VERSION) return NULL;
+  if (header.len != len || header.seg_size != seg_size) return NULL;
+
+  long long num_words = (file_size - (long long) sizeof(sliceHeader) - (long long) header.total_segment * sizeof(segmentSlice)) / sizeof(unsigned long long);
+  if (num_words < 0) return NULL;
+
+  slicedColumn* slice = new slicedColumn();
+  slice->len = len;
+  slice->seg_size = seg_size;
+  slice->total_segment = header.total_segment;
+  slice->segment = new segmentSlice[header.total_segment];
+  slice->words = (unsigned long long*) calloc(num_words + 1, sizeof(unsigned long long));
+  slice->slice_bytes = num_words * sizeof(unsigned long long);
+  in.read((char*) slice->segment, (size_t) header.total_segment * sizeof(segmentSlice));
+  in.read((char*) slice->words, (size_t) num_words * sizeof(unsigned long long));
+  if (!in) {
+    delete[] slice->segment;
+    free(slice->words);
+    delete slice;
+    return NULL;
+  }
+  return slice;
+}
+
+inline void freeSlicedColumn(slicedColumn* slice) {
+  if (slice == NULL) return;
+  delete[] slice->segment;
+  free(slice->words);
+  delete slice;
+}
+
+#endif
@@ -0,0 +1,200 @@
+#ifndef _SEGMENT_STATS_H_
+#define _SEGMENT_STATS_H_
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cmath>
+#include <cstring>
+
+//binary per segment statistics, written next to the column as <column>stats:
+//a statsHeader followed by one segmentStats record per segment
+
+#define STATS_MAGIC 0x53545453 //"STTS"
+#define STATS_VERSION 1
+#define STATS_HIST_BINS 16 //equi-width over [min, max]
+#define STATS_BITMAP_RANGE 64 //value bitmap kept when max - min < STATS_BITMAP_RANGE
+#define STATS_SKETCH_BITS 4096 //linear counting sketch for the distinct estimate
+
+#define STATS_HAS_HIST 1
+#define STATS_HAS_BITMAP 2
+
+typedef struct statsHeader {
+  unsigned int magic;
+  unsigned int version;
+  int len;
+  int seg_size;
+  int total_segment;
+} statsHeader;
+
+typedef struct segmentStats {
+  int min;
+  int max;
+  int nulls; //columns are not nullable yet, kept for the format
+  int distinct; //exact with a bitmap, linear counting estimate otherwise
+  int count;
+  int flags;
+  unsigned long long bitmap; //bit (v - min) set when v occurs
+  unsigned int hist[STATS_HIST_BINS];
+} segmentStats;
+
+//narrow domains get one bin per value so the histogram is exact
+inline int statsBins(int min, int max) {
+  long long range = (long long) max - min + 1;
+  return (range < STATS_HIST_BINS) ? (int) range : STATS_HIST_BINS;
+}
+
+inline int statsBin(int val, int min, int max) {
+  long long range = (long long) max - min + 1;
+  return (int) (((long long) val - min) * statsBins(min, max) / range);
+}
+
+//values of bin, the inverse of statsBin
+inline void statsBinRange(int bin, int min, int max, int& lo, int& hi) {
+  long long range = (long long) max - min + 1;
+  int bins = statsBins(min, max);
+  lo = (int) (min + (bin * range + bins - 1) / bins);
+  hi = (int) (min + ((bin + 1) * range + bins - 1) / bins - 1);
+}
+
+inline void computeSegmentStats(const int* col, int num, segmentStats* stats) {
+  memset(stats, 0, sizeof(segmentStats));
+  if (num <= 0) return;
+
+  int min = col[0], max = col[0];
+  for (int i = 0; i < num; i++) {
+    if (col[i] < min) min = col[i];
+    if (col[i] > max) max = col[i];
+  }
+  stats->min = min;
+  stats->max = max;
+  stats->count = num;
+
+  long long range = (long long) max - min + 1;
+
+  stats->flags |= STATS_HAS_HIST;
+  for (int i = 0; i < num; i++) stats->hist[statsBin(col[i], min, max)]++;
+
+  if (range <= STATS_BITMAP_RANGE) {
+    stats->flags |= STATS_HAS_BITMAP;
+    for (int i = 0; i < num; i++) stats->bitmap |= 1ULL << (col[i] - min);
+    stats->distinct = __builtin_popcountll(stats->bitmap);
+  } else {
+    std::vector<unsigned long long> sketch(STATS_SKETCH_BITS / 64, 0);
+    for (int i = 0; i < num; i++) {
+      unsigned int h = (unsigned int) col[i] * 2654435761u;
+      h = (h >> 16) % STATS_SKETCH_BITS;
+      sketch[h / 64] |= 1ULL << (h % 64);
+    }
+    int set = 0;
+    for (int i = 0; i < sketch.size(); i++) set += __builtin_popcountll(sketch[i]);
+    int zero = STATS_SKETCH_BITS - set;
+    double estimate = (zero == 0) ? range : -STATS_SKETCH_BITS * log((double) zero / STATS_SKETCH_BITS);
+    if (estimate > range) estimate = range;
+    if (estimate > num) estimate = num;
+    stats->distinct = (int) (estimate + 0.5);
+    if (stats->distinct < 1) stats->distinct = 1;
+  }
+}
+
+inline bool writeSegmentStats(std::string filename, const int* col, int len, int seg_size) {
+  std::ofstream out(filename.c_str(), std::ios::out | std::ios::binary);
+  if (!out) return false;
+
+  statsHeader header = {STATS_MAGIC, STATS_VERSION, len, seg_size, (len + seg_size - 1) / seg_size};
+  out.write((char*) &header, sizeof(statsHeader));
+
+  for (int i = 0; i < header.total_segment; i++) {
+    int num = (i == header.total_segment - 1) ? (len - seg_size * i) : seg_size;
+    segmentStats stats;
+    computeSegmentStats(col + (size_t) i * seg_size, num, &stats);
+    out.write((char*) &stats, sizeof(segmentStats));
+  }
+
+  return out.good();
+}
+
+//returns false when the file is missing or was written for another layout
+inline bool readSegmentStats(std::string filename, segmentStats* stats, int len, int seg_size) {
+  std::ifstream in(filename.c_str(), std::ios::in | std::ios::binary);
+  if (!in) return false;
+
+  statsHeader header;
+  in.read((char*) &header, sizeof(statsHeader));
+  if (!in || header.magic != STATS_MAGIC || header.version != STATS_VERSION) return false;
+  if (header.len != len || header.seg_size != seg_size) return false;
+
+  in.read((char*) stats, (size_t) header.total_segment * sizeof(segmentStats));
+  return in.good();
+}
+
+//can any row of the segment pass the predicate, mode 2 is x == lo || x == hi and anything else is lo <= x <= hi
+inline bool segmentMayMatch(const segmentStats& stats, int mode, int lo, int hi) {
+  if (mode == 2) {
+    bool match = false;
+    int val[2] = {lo, hi};
+    for (int k = 0; k < 2; k++) {
+      if (val[k] < stats.min || val[k] > stats.max) continue;
+      if (stats.flags & STATS_HAS_BITMAP) match |= (stats.bitmap >> (val[k] - stats.min)) & 1;
+      else match = true;
+    }
+    return match;
+  }
+
+  if (hi < stats.min || lo > stats.max) return false;
+  if (stats.flags & STATS_HAS_BITMAP) {
+    int from = (lo < stats.min) ? 0 : lo - stats.min;
+    int to = (hi > stats.max) ? stats.max - stats.min : hi - stats.min;
+    unsigned long long bits = stats.bitmap >> from;
+    if (to - from + 1 < 64) bits &= (1ULL << (to - from + 1)) - 1;
+    return bits != 0;
+  }
+  return true;
+}
+
+//fraction of the rows of the segment passing the predicate, same modes as segmentMayMatch
+inline double segmentSelectivity(const segmentStats& stats, int mode, int lo, int hi) {
+  if (stats.count == 0 || !segmentMayMatch(stats, mode, lo, hi)) return 0;
+
+  double range = (double) stats.max - stats.min + 1;
+
+  if (mode == 2) {
+    //uniform over the distinct values, scaled by the density of their histogram bins
+    double sel = 0;
+    int val[2] = {lo, hi};
+    for (int k = 0; k < ((lo == hi) ? 1 : 2); k++) {
+      if (!segmentMayMatch(stats, 2, val[k], val[k])) continue;
+      if (stats.flags & STATS_HAS_HIST) {
+        int bin = statsBin(val[k], stats.min, stats.max);
+        double values_in_bin = (range / statsBins(stats.min, stats.max)) * stats.distinct / range;
+        if (values_in_bin < 1) values_in_bin = 1;
+        sel += (double) stats.hist[bin] / stats.count / values_in_bin;
+      } else {
+        sel += 1.0 / stats.distinct;
+      }
+    }
+    return (sel > 1) ? 1 : sel;
+  }
+
+  double from = (lo < stats.min) ? stats.min : lo;
+  double to = (hi > stats.max) ? stats.max : hi;
+
+  if (stats.flags & STATS_HAS_HIST) {
+    //each bin covers [min + b * width, min + (b + 1) * width), count the overlapping fraction of every bin
+    int bins = statsBins(stats.min, stats.max);
+    double width = range / bins;
+    double sel = 0;
+    for (int b = 0; b < bins; b++) {
+      double bin_lo = stats.min + b * width;
+      double bin_hi = bin_lo + width;
+      double overlap = fmin(bin_hi, to + 1) - fmax(bin_lo, from);
+      if (overlap > 0) sel += stats.hist[b] * (overlap / width);
+    }
+    sel /= stats.count;
+    return (sel > 1) ? 1 : sel;
+  }
+
+  return (to - from + 1) / range;
+}
+
+#endif
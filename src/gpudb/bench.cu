@@ -0,0 +1,563 @@
+#include "QueryProcessing.h"
+#include "QueryOptimizer.h"
+#include "CPUGPUProcessing.h"
+#include "CacheManager.h"
+#include "CPUProcessing.h"
+#include "CostModel.h"
+#include "MachineProfile.h"
+#include "HashTableCache.h"
+#include "ResultCache.h"
+#include "CPUJit.h"
+#include <thread>
+
+//non interactive experiment runner, the scriptable counterpart of option 3 of main.
+//a workload spec is a file of "key value" lines ('#' starts a comment), every key can be overridden on the
+//command line as --key=value. results go to out as json lines, one "query" record per query of the mix,
+//one "iter" record per iteration and one "run" record per cache size of the sweep:
+//
+//  queries 11:1,21:2,31:1    query mix, query:weight (or "all", every ssb query with the same weight)
+//  dist zipf                 zipf, norm or none, the distribution of the query predicates
+//  alpha 1.0                 zipf skew
+//  mean 1,4,2,5              norm means, the next one is used every shift iterations
+//  shift 5
+//  warmup 100                queries before the first replacement (skipped for norm, like main)
+//  iterations 20             replacement runs after every iteration
+//  queries_per_iter 100
+//  policy SemanticAware      LRU, LFU, LRUSegmented, LFUSegmented, LRU2, LRU2Segmented, SemanticAware
+//  cache_mb 400,800,1600     gpu cache sizes to sweep
+//  exec plan                 plan (the plan cache picks one variant per query, see PlanCache.h), both (runs
+//                            processQuery and processQuery2 and keeps the faster), emat, nopipe or HE
+//  plan_variants runQuery,runQuery2   variants the plan cache chooses from
+//  skipping 1
+//  custom 1
+//  morsel 1
+//  probe direct
+//  host 0                    run on the emulated gpu in host memory (also picked without a cuda device)
+//  pcie 12                   GB/s of the emulated gpu
+//  data <dir>, sf <sf>       data directory, see Catalog.h
+//  seed 123
+//  label <name>              copied to every record
+//  out bench.json            - for stdout
+//  async 0                   copy admitted segments in the background (segmented policies), see admitAsync
+//  admission_gbps 0          bandwidth the background admission may use, 0 for no limit
+//  trace <file>              record the segment trace of the run for cachesim (<file>.<cache_mb> when sweeping)
+//  ht_cache 0                share dimension hash tables between queries (HashTableCache.h), budget in MB, 0 for off
+//  clients 1,4,16,64         after the run, queries_per_iter queries per client from that many concurrent clients
+//                            over the cache the run left, one "clients" record per count
+//  shared_scan 1             concurrent cpu fact scans start where the running ones are (see sharedScan)
+//  profile <file>            machine profile of the cost model (MachineProfile.h), default MORDRED_PROFILE
+//  calibrate 0               measure the machine profile before the run (and write it to profile when given)
+//  result_cache 0            keep per segment partial aggregates of processQuery (ResultCache.h), budget in MB, 0 for off
+//  pack 1                    cpu filters scan the bit packed fact columns the loader wrote (SegmentPack.h)
+//  slice 1                   cpu filters scan the bit sliced low cardinality fact columns (SegmentSlice.h)
+//  join_skip 1               skip fact segments whose foreign keys reach no key the dimension predicates keep (JoinSummary.h)
+//  aggr 1                    processQuery answers the segments its predicates cover from the segment aggregates (SegmentAggr.h)
+//  jit 0                     compile the fused cpu pipelines at runtime (CPUJit.h), compile time is reported apart
+//  jit_dir <dir>             directory of the compiled pipelines, default MORDRED_JIT_DIR or ~/.cache/mordred-jit
+
+typedef struct benchSpec {
+	map<string, string> value;
+
+	string get(string key, string def) {
+		auto it = value.find(key);
+		return (it == value.end()) ? def : it->second;
+	}
+	int getInt(string key, int def) { return stoi(get(key, to_string(def))); }
+	double getDouble(string key, double def) { return stod(get(key, to_string(def))); }
+} benchSpec;
+
+bool readSpec(string filename, benchSpec& spec) {
+	ifstream in(filename.c_str());
+	if (!in) return false;
+
+	string line;
+	while (getline(in, line)) {
+		size_t comment = line.find('#');
+		if (comment != string::npos) line = line.substr(0, comment);
+		istringstream fields(line);
+		string key, val;
+		if (!(fields >> key >> val)) continue;
+		spec.value[key] = val;
+	}
+	return true;
+}
+
+vector<string> splitList(string list) {
+	vector<string> items;
+	istringstream in(list);
+	string item;
+	while (getline(in, item, ',')) if (!item.empty()) items.push_back(item);
+	return items;
+}
+
+bool parsePolicy(string policy, ReplacementPolicy& repl_policy) {
+	if (policy == "LRU") repl_policy = LRU;
+	else if (policy == "LFU") repl_policy = LFU;
+	else if (policy == "LRUSegmented") repl_policy = LRUSegmented;
+	else if (policy == "LFUSegmented") repl_policy = LFUSegmented;
+	else if (policy == "LRU2") repl_policy = LRU2;
+	else if (policy == "LRU2Segmented") repl_policy = LRU2Segmented;
+	else if (policy == "SemanticAware") repl_policy = Segmented;
+	else return false;
+	return true;
+}
+
+//latency of every query of a run, with the percentile the records report
+typedef struct latencyStats {
+	vector<double> ms;
+
+	double percentile(double p) {
+		if (ms.empty()) return 0;
+		vector<double> sorted(ms);
+		sort(sorted.begin(), sorted.end());
+		int idx = (int) ceil(p / 100 * sorted.size()) - 1;
+		return sorted[max(0, min(idx, (int) sorted.size() - 1))];
+	}
+
+	double mean() {
+		double sum = 0;
+		for (int i = 0; i < ms.size(); i++) sum += ms[i];
+		return ms.empty() ? 0 : sum / ms.size();
+	}
+
+	void print(FILE* fptr) {
+		fprintf(fptr, "\"count\":%d,\"mean_ms\":%.3f,\"p50_ms\":%.3f,\"p90_ms\":%.3f,\"p99_ms\":%.3f,\"max_ms\":%.3f",
+			(int) ms.size(), mean(), percentile(50), percentile(90), percentile(99), percentile(100));
+	}
+} latencyStats;
+
+//high water marks of a processing arena in MB, to size the processing regions from a workload
+void printArena(FILE* fptr, const char* name, ProcessingArena* arena) {
+	arenaStats stats = arena->snapshot();
+	double mb = sizeof(uint64_t) / 1048576.0;
+	fprintf(fptr, ",\"%s_arena_mb\":%.1f,\"%s_peak_mb\":%.1f,\"%s_query_peak_mb\":%.1f,\"%s_spills\":%llu,\"%s_spill_mb\":%.1f",
+		name, stats.capacity * mb, name, stats.peak * mb, name, stats.context_peak * mb,
+		name, (unsigned long long) stats.spills, name, stats.spill_words * mb);
+}
+
+void printHashTableCache(FILE* fptr, HashTableCache* ht_cache) {
+	if (ht_cache == NULL) return;
+	fprintf(fptr, ",\"ht_hits\":%llu,\"ht_misses\":%llu,\"ht_entries\":%d,\"ht_mb\":%.1f",
+		ht_cache->hits, ht_cache->misses, (int) ht_cache->entries.size(), ht_cache->used / 1048576.0);
+}
+
+void printResultCache(FILE* fptr, ResultCache* result_cache) {
+	if (result_cache == NULL) return;
+	fprintf(fptr, ",\"result_hits\":%llu,\"result_misses\":%llu,\"result_entries\":%d,\"result_mb\":%.1f",
+		result_cache->hits, result_cache->misses, (int) result_cache->entries.size(), result_cache->used / 1048576.0);
+}
+
+//footprint of the packed fact columns against the same segments unpacked
+void printPack(FILE* fptr, CacheManager* cm) {
+	size_t packed_bytes = 0, raw_bytes = 0;
+	int columns = 0;
+	for (int i = 0; i < cm->TOT_COLUMN; i++) {
+		packedColumn* pack = cm->allColumn[i]->pack;
+		if (pack == NULL) continue;
+		columns++;
+		packed_bytes += pack->packed_bytes;
+		raw_bytes += pack->raw_bytes;
+	}
+	fprintf(fptr, ",\"packed_scan\":%d,\"packed_columns\":%d,\"packed_mb\":%.1f,\"packed_raw_mb\":%.1f",
+		packed_scan_cpu, columns, packed_bytes / 1048576.0, raw_bytes / 1048576.0);
+}
+
+//the bit sliced fact columns, kept next to the raw (and packed) ones
+void printSlice(FILE* fptr, CacheManager* cm) {
+	size_t slice_bytes = 0;
+	int columns = 0;
+	for (int i = 0; i < cm->TOT_COLUMN; i++) {
+		slicedColumn* slice = cm->allColumn[i]->slice;
+		if (slice == NULL) continue;
+		columns++;
+		slice_bytes += slice->slice_bytes;
+	}
+	fprintf(fptr, ",\"sliced_scan\":%d,\"sliced_columns\":%d,\"sliced_mb\":%.1f", sliced_scan_cpu, columns, slice_bytes / 1048576.0);
+}
+
+//the segment aggregates the loader wrote, and the segments of the run answered from them
+void printAggregates(FILE* fptr, CacheManager* cm, int aggregated_segment) {
+	size_t bytes = 0;
+	for (int i = 0; i < cm->segment_aggr.size(); i++) bytes += cm->segment_aggr[i]->bytes;
+	fprintf(fptr, ",\"segment_aggr\":%d,\"aggr_tables\":%d,\"aggr_kb\":%.1f,\"aggregated_segments\":%d",
+		segment_aggregates, (int) cm->segment_aggr.size(), bytes / 1024.0, aggregated_segment);
+}
+
+//compiles of the warmup and of the measured queries, and the measured time without the compiler runs
+void printJit(FILE* fptr, jitStatsCPU& warmup, jitStatsCPU& start, jitStatsCPU& end, double total_ms) {
+	if (!jit_cpu) return;
+	double compile_ms = end.compile_ms - start.compile_ms;
+	fprintf(fptr, ",\"jit_compiles\":%d,\"jit_disk_hits\":%d,\"jit_failures\":%d,\"jit_compile_ms\":%.3f,\"jit_load_ms\":%.3f,"
+		"\"jit_warmup_compiles\":%d,\"jit_warmup_compile_ms\":%.3f,\"total_ms_no_jit\":%.3f",
+		end.compiles - start.compiles, end.disk_hits - start.disk_hits, end.failures - start.failures, compile_ms, end.load_ms - start.load_ms,
+		start.compiles - warmup.compiles, start.compile_ms - warmup.compile_ms, total_ms - compile_ms);
+}
+
+//counters of one query or of a whole iteration, as reported by cgp
+typedef struct benchCounters {
+	double time, execution_time, optimization_time, merging_time, malloc_time;
+	unsigned long long cpu_to_gpu, gpu_to_cpu;
+
+	void add(const benchCounters& other) {
+		time += other.time; execution_time += other.execution_time; optimization_time += other.optimization_time;
+		merging_time += other.merging_time; malloc_time += other.malloc_time;
+		cpu_to_gpu += other.cpu_to_gpu; gpu_to_cpu += other.gpu_to_cpu;
+	}
+} benchCounters;
+
+benchCounters takeCounters(CPUGPUProcessing* cgp, double time) {
+	benchCounters counters = {time, cgp->execution_total, cgp->optimization_total, cgp->merging_total, cgp->malloc_time_total,
+		cgp->cpu_to_gpu_total, cgp->gpu_to_cpu_total};
+	cgp->resetTime();
+	return counters;
+}
+
+//one query with the execution mode of the spec, "both" runs both plans and keeps the faster one like main did
+benchCounters runOne(QueryProcessing* qp, CPUGPUProcessing* cgp, string exec, CUcontext ctx) {
+	if (exec == "plan") return takeCounters(cgp, qp->processQueryPlanned(ctx));
+	if (exec == "emat") return takeCounters(cgp, qp->processQueryEMat(ctx));
+	if (exec == "nopipe") return takeCounters(cgp, qp->processQueryNP(ctx));
+	if (exec == "HE") return takeCounters(cgp, qp->processQueryHE(ctx));
+
+	benchCounters first = takeCounters(cgp, qp->processQuery(ctx));
+	benchCounters second = takeCounters(cgp, qp->processQuery2(ctx));
+	return (first.time <= second.time) ? first : second;
+}
+
+int main(int argc, char** argv) {
+
+	benchSpec spec;
+
+	for (int i = 1; i < argc; i++) {
+		string arg = argv[i];
+		if (arg.compare("--help") == 0) {
+			printf("%s [--spec=<workload spec file>] [--<key>=<value> ...], see the top of bench.cu for the keys\n", argv[0]);
+			return 0;
+		}
+		if (arg.compare(0, 7, "--spec=") == 0 && !readSpec(arg.substr(7), spec)) {
+			fprintf(stderr, "Could not read spec %s\n", arg.substr(7).c_str());
+			return 1;
+		}
+	}
+	for (int i = 1; i < argc; i++) {
+		string arg = argv[i];
+		size_t eq = arg.find('=');
+		if (arg.compare(0, 2, "--") != 0 || eq == string::npos || arg.compare(0, 7, "--spec=") == 0) continue;
+		spec.value[arg.substr(2, eq - 2)] = arg.substr(eq + 1);
+	}
+
+	string data_dir = spec.get("data", "");
+	int sf = spec.getInt("sf", 0);
+	if (!data_dir.empty()) openCatalog(data_dir, sf);
+	else if (sf != 0) openCatalog(catalogSFDir(sf), sf);
+
+	numaInit();
+
+	bool host_device = spec.getInt("host", 0);
+	int device_count = 0;
+	if (cudaGetDeviceCount(&device_count) != cudaSuccess || device_count == 0) host_device = true;
+
+	CUdevice device;
+	if (host_device) {
+		setDeviceBackend(new HostDevice(HOST_DEVICE_CAPACITY, spec.getDouble("pcie", HOST_DEVICE_BW_PCI / 1000000.0) * 1000000));
+	} else {
+		cudaSetDevice(0);
+		cuDeviceGet(&device, 0);
+	}
+
+	string profile = spec.get("profile", getenv("MORDRED_PROFILE") ? getenv("MORDRED_PROFILE") : "");
+	if (spec.getInt("calibrate", 0)) {
+		calibrateMachine(true);
+		if (!profile.empty() && !saveMachineProfile(profile)) fprintf(stderr, "Could not write machine profile %s\n", profile.c_str());
+	} else if (!profile.empty() && !loadMachineProfile(profile)) {
+		fprintf(stderr, "Could not read machine profile %s\n", profile.c_str());
+		return 1;
+	}
+
+	morsel_driven_cpu = spec.getInt("morsel", 1);
+	ProbeModeCPU probe_mode = probeModeCPU(spec.get("probe", "direct"));
+	if (probe_mode != ProbeModeCount) probe_mode_cpu = probe_mode;
+	packed_scan_cpu = spec.getInt("pack", 1);
+	sliced_scan_cpu = spec.getInt("slice", 1);
+	segment_aggregates = spec.getInt("aggr", 1);
+	join_skipping = spec.getInt("join_skip", 1);
+	jit_cpu = spec.getInt("jit", 0);
+	if (!spec.get("jit_dir", "").empty()) setJitDir(spec.get("jit_dir", ""));
+
+	//query mix
+	vector<int> mix_query;
+	vector<double> mix_weight;
+	string mix = spec.get("queries", "all");
+	if (mix == "all") {
+		for (int i = 0; i < NUM_QUERIES; i++) {
+			mix_query.push_back(queries[i]);
+			mix_weight.push_back(1);
+		}
+	} else {
+		for (string item : splitList(mix)) {
+			size_t colon = item.find(':');
+			mix_query.push_back(stoi(item.substr(0, colon)));
+			mix_weight.push_back(colon == string::npos ? 1 : stod(item.substr(colon + 1)));
+		}
+	}
+
+	Distribution dist = Zipf;
+	string dist_string = spec.get("dist", "zipf");
+	if (dist_string == "norm") dist = Norm;
+	else if (dist_string == "none") dist = None;
+	double alpha = spec.getDouble("alpha", 1.0);
+	vector<string> means = splitList(spec.get("mean", "1"));
+	int shift = max(1, spec.getInt("shift", 5));
+
+	int warmup = spec.getInt("warmup", 100);
+	int iterations = spec.getInt("iterations", 20);
+	int queries_per_iter = spec.getInt("queries_per_iter", 100);
+	string exec = spec.get("exec", "plan");
+	string plan_variants = spec.get("plan_variants", "");
+	bool async_admission = spec.getInt("async", 0);
+	double admission_gbps = spec.getDouble("admission_gbps", 0);
+	bool custom = spec.getInt("custom", 1);
+	bool skipping = spec.getInt("skipping", 1);
+	string label = spec.get("label", "");
+	int seed = spec.getInt("seed", 123);
+
+	if (host_device && (exec == "emat" || exec == "nopipe" || exec == "HE")) {
+		fprintf(stderr, "exec %s needs a CUDA device\n", exec.c_str());
+		return 1;
+	}
+
+	string policy = spec.get("policy", "SemanticAware");
+	ReplacementPolicy repl_policy;
+	if (!parsePolicy(policy, repl_policy)) {
+		fprintf(stderr, "Unknown replacement policy %s\n", policy.c_str());
+		return 1;
+	}
+
+	string trace_file = spec.get("trace", "");
+	int ht_cache_mb = spec.getInt("ht_cache", 0);
+	int result_cache_mb = spec.getInt("result_cache", 0);
+	vector<string> client_counts = splitList(spec.get("clients", ""));
+	shared_scan_cpu = spec.getInt("shared_scan", 1);
+	vector<string> cache_sizes = splitList(spec.get("cache_mb", "400"));
+
+	string out = spec.get("out", "bench.json");
+	FILE* fptr = (out == "-") ? stdout : fopen(out.c_str(), "w");
+	if (fptr == NULL) {
+		fprintf(stderr, "Could not open %s\n", out.c_str());
+		return 1;
+	}
+
+	CUcontext sessionCtx = NULL;
+	CUcontext poppedCtx;
+	if (!host_device) {
+		CHECK_CU_ERROR( cuCtxCreate(&sessionCtx, 0, device), "cuCtxCreate");
+		CHECK_CU_ERROR( cuCtxPopCurrent(&poppedCtx), "cuCtxPopCurrent" );
+	}
+
+	for (string cache_mb : cache_sizes) {
+		unsigned int size = (unsigned int) (stod(cache_mb) * 1048576 / sizeof(int));
+
+		srand(seed);
+		mt19937 gen(seed);
+		discrete_distribution<int> pick(mix_weight.begin(), mix_weight.end());
+
+		CPUGPUProcessing* cgp = new CPUGPUProcessing(size, 0, 52428800 * 15, 52428800 * 20, false, custom, skipping);
+		cgp->cm->async_admission = async_admission;
+		cgp->cm->admission_bandwidth = admission_gbps * 1000000;
+		if (ht_cache_mb > 0) cgp->cm->ht_cache = new HashTableCache(cgp->cm, (size_t) ht_cache_mb * 1048576);
+		if (result_cache_mb > 0) cgp->cm->result_cache = new ResultCache((size_t) result_cache_mb * 1048576);
+		QueryProcessing* qp = new QueryProcessing(cgp, false, dist);
+		string plan_error;
+		if (!plan_variants.empty() && !qp->plan_cache->enableVariants(plan_variants, plan_error)) {
+			fprintf(stderr, "%s\n", plan_error.c_str());
+			return 1;
+		}
+		if (dist == Zipf) qp->qo->setDistributionZipfian(alpha);
+		else if (dist == Norm) qp->qo->setDistributionNormal(stod(means[0]), 0.5);
+
+		QueryTrace* trace = NULL;
+		if (!trace_file.empty()) {
+			trace = new QueryTrace();
+			for (int i = 0; i < cgp->cm->TOT_COLUMN; i++) {
+				ColumnInfo* column = cgp->cm->allColumn[i];
+				trace->addColumn(column->column_id, column->column_name, column->table_id, column->total_segment);
+			}
+			cgp->cm->trace = trace;
+		}
+
+		jitStatsCPU jit_warmup = jitStats();
+		if (dist != Norm) {
+			for (int i = 0; i < warmup; i++) {
+				int query = mix_query[pick(gen)];
+				qp->setQuery(query);
+				double time = qp->processQuery(sessionCtx);
+				if (trace != NULL) trace->endQuery(query, time);
+				cgp->resetTime();
+			}
+			cgp->cm->runReplacement(repl_policy);
+			if (trace != NULL) trace->replacement();
+		}
+
+		cgp->qo->processed_segment = 0;
+		cgp->qo->skipped_segment = 0;
+		cgp->qo->cached_segment = 0;
+		cgp->qo->aggregated_segment = 0;
+		cgp->qo->join_skipped_segment = 0;
+		cgp->cm->resetArenaStats();
+		jitStatsCPU jit_start = jitStats();
+
+		map<int, latencyStats> query_latency;
+		latencyStats run_latency;
+		benchCounters run_total = {0, 0, 0, 0, 0, 0, 0};
+		unsigned long long repl_traffic = 0;
+		double repl_ms = 0;
+
+		for (int iter = 0; iter < iterations; iter++) {
+			benchCounters iter_total = {0, 0, 0, 0, 0, 0, 0};
+			unsigned long long iter_repl = repl_traffic;
+
+			for (int i = 0; i < queries_per_iter; i++) {
+				int query = mix_query[pick(gen)];
+				qp->setQuery(query);
+				benchCounters counters = runOne(qp, cgp, exec, sessionCtx);
+				if (trace != NULL) trace->endQuery(query, counters.time);
+				iter_total.add(counters);
+				query_latency[query].ms.push_back(counters.time);
+				run_latency.ms.push_back(counters.time);
+			}
+
+			float iter_repl_ms = cgp->cm->runReplacement(repl_policy, &repl_traffic);
+			repl_ms += iter_repl_ms;
+			if (trace != NULL) trace->replacement();
+			if (repl_policy == Segmented || repl_policy == LFUSegmented) cgp->cm->newEpoch(0.5);
+			if (repl_policy == LRU2Segmented) cgp->cm->newEpoch(2.0);
+
+			fprintf(fptr, "{\"type\":\"iter\",\"label\":\"%s\",\"cache_mb\":%s,\"policy\":\"%s\",\"iter\":%d,\"time_ms\":%.3f,"
+				"\"cpu_to_gpu_bytes\":%llu,\"gpu_to_cpu_bytes\":%llu,\"repl_traffic_bytes\":%llu,"
+				"\"replacement_ms\":%.3f,\"evicted_segments\":%d,\"admitted_segments\":%d}\n",
+				label.c_str(), cache_mb.c_str(), policy.c_str(), iter, iter_total.time,
+				iter_total.cpu_to_gpu, iter_total.gpu_to_cpu, repl_traffic - iter_repl,
+				iter_repl_ms, cgp->cm->replacement_evicted, cgp->cm->replacement_admitted);
+			run_total.add(iter_total);
+
+			//norm workloads drift to the next mean every shift iterations
+			if (dist == Norm && (iter + 1) % shift == 0)
+				qp->qo->setDistributionNormal(stod(means[((iter + 1) / shift) % means.size()]), 0.5);
+		}
+
+		for (auto it = query_latency.begin(); it != query_latency.end(); it++) {
+			fprintf(fptr, "{\"type\":\"query\",\"label\":\"%s\",\"cache_mb\":%s,\"policy\":\"%s\",\"query\":%d,",
+				label.c_str(), cache_mb.c_str(), policy.c_str(), it->first);
+			it->second.print(fptr);
+			fprintf(fptr, "}\n");
+		}
+
+		int processed_segment = cgp->qo->processed_segment;
+		int skipped_segment = cgp->qo->skipped_segment;
+		int cached_segment = cgp->qo->cached_segment;
+		int join_skipped_segment = cgp->qo->join_skipped_segment;
+		fprintf(fptr, "{\"type\":\"run\",\"label\":\"%s\",\"cache_mb\":%s,\"policy\":\"%s\",\"dist\":\"%s\",\"alpha\":%.2f,\"exec\":\"%s\",\"host_device\":%d,\"calibrated\":%d,\"jit\":%d,",
+			label.c_str(), cache_mb.c_str(), policy.c_str(), dist_string.c_str(), alpha, exec.c_str(), host_device, machine().calibrated, jit_cpu);
+		run_latency.print(fptr);
+		fprintf(fptr, ",\"total_ms\":%.3f,\"throughput_qps\":%.3f,\"execution_ms\":%.3f,\"optimization_ms\":%.3f,\"merging_ms\":%.3f,\"malloc_ms\":%.3f,"
+			"\"cpu_to_gpu_bytes\":%llu,\"gpu_to_cpu_bytes\":%llu,\"repl_traffic_bytes\":%llu,\"replacement_ms\":%.3f,"
+			"\"processed_segments\":%d,\"skipped_segments\":%d,\"skipped_fraction\":%.4f,\"cached_segments\":%d,\"join_skipped_segments\":%d",
+			run_total.time, run_total.time > 0 ? run_latency.ms.size() * 1000.0 / run_total.time : 0,
+			run_total.execution_time, run_total.optimization_time, run_total.merging_time, run_total.malloc_time,
+			run_total.cpu_to_gpu, run_total.gpu_to_cpu, repl_traffic, repl_ms,
+			processed_segment, skipped_segment, (processed_segment + skipped_segment) > 0 ? skipped_segment * 1.0 / (processed_segment + skipped_segment) : 0,
+			cached_segment, join_skipped_segment);
+		printArena(fptr, "cpu", cgp->cm->cpu_arena);
+		printArena(fptr, "gpu", cgp->cm->gpu_arena);
+		printArena(fptr, "pinned", cgp->cm->pinned_arena);
+		printHashTableCache(fptr, cgp->cm->ht_cache);
+		printResultCache(fptr, cgp->cm->result_cache);
+		printPack(fptr, cgp->cm);
+		printSlice(fptr, cgp->cm);
+		printAggregates(fptr, cgp->cm, cgp->qo->aggregated_segment);
+		jitStatsCPU jit_end = jitStats();
+		printJit(fptr, jit_warmup, jit_start, jit_end, run_total.time);
+		fprintf(fptr, "}\n");
+		fflush(fptr);
+
+		if (trace != NULL) {
+			string trace_out = (cache_sizes.size() > 1) ? trace_file + "." + cache_mb : trace_file;
+			if (!trace->write(trace_out)) fprintf(stderr, "Could not write trace %s\n", trace_out.c_str());
+			cgp->cm->trace = NULL;
+			delete trace;
+		}
+
+		//concurrent clients, each with its own query context over the cache of cgp. no replacement runs while
+		//they are active, the cache content stays as the run left it
+		for (string count : client_counts) {
+			int clients = stoi(count);
+			vector<CPUGPUProcessing*> client_cgp(clients);
+			vector<QueryProcessing*> client_qp(clients);
+			for (int k = 0; k < clients; k++) {
+				client_cgp[k] = new CPUGPUProcessing(cgp);
+				client_qp[k] = new QueryProcessing(client_cgp[k], false, dist);
+				client_qp[k]->clock = &qp->logical_time;
+				for (int v = 0; v < PlanVariantCount; v++) client_qp[k]->plan_cache->enabled[v] = qp->plan_cache->enabled[v];
+				if (dist == Zipf) client_qp[k]->qo->setDistributionZipfian(alpha);
+				else if (dist == Norm) client_qp[k]->qo->setDistributionNormal(stod(means[0]), 0.5);
+			}
+
+			vector<latencyStats> client_latency(clients);
+			unsigned long long ht_hits = (cgp->cm->ht_cache != NULL) ? cgp->cm->ht_cache->hits : 0;
+			unsigned long long ht_misses = (cgp->cm->ht_cache != NULL) ? cgp->cm->ht_cache->misses : 0;
+			cgp->cm->resetArenaStats();
+
+			chrono::high_resolution_clock::time_point begin = chrono::high_resolution_clock::now();
+			vector<thread> threads;
+			for (int k = 0; k < clients; k++) {
+				threads.push_back(thread([&, k]() {
+					mt19937 client_gen(seed + 1000 * clients + k);
+					discrete_distribution<int> client_pick(mix_weight.begin(), mix_weight.end());
+					for (int i = 0; i < queries_per_iter; i++) {
+						client_qp[k]->setQuery(mix_query[client_pick(client_gen)]);
+						client_latency[k].ms.push_back(runOne(client_qp[k], client_cgp[k], exec, sessionCtx).time);
+					}
+				}));
+			}
+			for (int k = 0; k < clients; k++) threads[k].join();
+			chrono::duration<double, milli> wall = chrono::high_resolution_clock::now() - begin;
+
+			latencyStats latency;
+			int processed = 0, skipped = 0;
+			for (int k = 0; k < clients; k++) {
+				latency.ms.insert(latency.ms.end(), client_latency[k].ms.begin(), client_latency[k].ms.end());
+				processed += client_qp[k]->qo->processed_segment;
+				skipped += client_qp[k]->qo->skipped_segment;
+			}
+
+			fprintf(fptr, "{\"type\":\"clients\",\"label\":\"%s\",\"cache_mb\":%s,\"policy\":\"%s\",\"exec\":\"%s\",\"clients\":%d,\"shared_scan\":%d,",
+				label.c_str(), cache_mb.c_str(), policy.c_str(), exec.c_str(), clients, shared_scan_cpu);
+			latency.print(fptr);
+			fprintf(fptr, ",\"wall_ms\":%.3f,\"throughput_qps\":%.3f,\"processed_segments\":%d,\"skipped_segments\":%d",
+				wall.count(), wall.count() > 0 ? latency.ms.size() * 1000.0 / wall.count() : 0, processed, skipped);
+			printArena(fptr, "cpu", cgp->cm->cpu_arena);
+			printArena(fptr, "gpu", cgp->cm->gpu_arena);
+			printArena(fptr, "pinned", cgp->cm->pinned_arena);
+			if (cgp->cm->ht_cache != NULL)
+				fprintf(fptr, ",\"ht_hits\":%llu,\"ht_misses\":%llu", cgp->cm->ht_cache->hits - ht_hits, cgp->cm->ht_cache->misses - ht_misses);
+			fprintf(fptr, "}\n");
+			fflush(fptr);
+
+			for (int k = 0; k < clients; k++) {
+				delete client_qp[k];
+				delete client_cgp[k];
+			}
+		}
+
+		delete qp;
+		delete cgp;
+	}
+
+	if (fptr != stdout) fclose(fptr);
+
+	if (sessionCtx != NULL) {
+		cuCtxDestroy(sessionCtx);
+	}
+
+	return 0;
+}
@@ -0,0 +1,329 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <iostream>
+#include <algorithm>
+#include "Catalog.h"
+#include "QueryTrace.h"
+#include "SegmentRanking.h"
+#include "utils/cpu_utils.h"
+#include "tbb/tbb.h"
+
+using namespace std;
+using namespace tbb;
+
+#define SEGMENT_BYTES ((unsigned long long) SEGMENT_SIZE * sizeof(int))
+
+//replays a segment trace recorded by bench (trace <file>) against the replacement policies of CacheManager
+//and a sweep of cache sizes, on the cpu and without the data. every (policy, cache size) pair is one
+//independent simulation, they run in parallel. the statistics the policies rank on are rebuilt from the
+//trace the way updateStatsQuery and updateSegmentStats maintain them, and the query time is estimated
+//from the recorded one: a segment the simulated cache holds but the run did not saves the speedup share
+//of its column, which is what the optimizer ranks segments by, and the other way round
+
+enum SimPolicy {
+  SimLRU, SimLFU, SimLRU2, SimLRUSegmented, SimLFUSegmented, SimLRU2Segmented, SimSemanticAware, SimPolicyCount
+};
+
+const char* sim_policy_name[] = {"LRU", "LFU", "LRU2", "LRUSegmented", "LFUSegmented", "LRU2Segmented", "SemanticAware"};
+
+typedef struct simStats {
+  double col_freq;
+  double timestamp;
+  double backward_t;
+} simStats;
+
+typedef struct simSegment {
+  int column_id;
+  int segment_id;
+  double weight;
+  simStats stats;
+  bool in_gpu;
+} simSegment;
+
+typedef struct simResult {
+  long long accesses, hits, skipped;
+  long long admitted, evicted;
+  int replacements;
+  double recorded_ms, estimated_ms, replacement_ms;
+} simResult;
+
+class CacheSim {
+public:
+  QueryTrace& trace;
+  SimPolicy policy;
+  int cache_total_seg;
+  int every; //replace every n queries instead of where the run did, 0 to follow the trace
+
+  vector<vector<simSegment>> segment;
+  vector<vector<simSegment*>> segment_ptr;
+  vector<simStats> column_stats;
+  vector<int> tot_seg_in_GPU;
+  SegmentRanking<simSegment>* ranking;
+  double logical_time;
+  simResult result;
+
+  CacheSim(QueryTrace& _trace, SimPolicy _policy, int _cache_total_seg, int _every)
+  : trace(_trace), policy(_policy), cache_total_seg(_cache_total_seg), every(_every), ranking(NULL), logical_time(0) {
+    int num_column = trace.column.size();
+    segment.resize(num_column);
+    segment_ptr.resize(num_column);
+    column_stats.assign(num_column, simStats{0, 0, 0});
+    tot_seg_in_GPU.assign(num_column, 0);
+    for (int i = 0; i < num_column; i++) {
+      segment[i].resize(trace.column[i].total_segment);
+      for (int j = 0; j < segment[i].size(); j++) {
+        segment[i][j] = simSegment{i, j, 0, {0, 0, 0}, false};
+        segment_ptr[i].push_back(&segment[i][j]);
+      }
+    }
+    result = simResult{0, 0, 0, 0, 0, 0, 0, 0, 0};
+  }
+
+  ~CacheSim() {
+    if (ranking != NULL) delete ranking;
+  }
+
+  bool segmented() {
+    return policy == SimLRUSegmented || policy == SimLFUSegmented || policy == SimLRU2Segmented || policy == SimSemanticAware;
+  }
+
+  //same keys as CacheManager::segmentRankKey
+  double rankKey(simSegment* seg) {
+    if (policy == SimSemanticAware) return (seg->weight > 0) ? seg->weight : RANK_NONE;
+    else if (policy == SimLRUSegmented) return (seg->stats.timestamp > 0) ? seg->stats.timestamp : RANK_NONE;
+    else if (policy == SimLFUSegmented) return (seg->stats.col_freq > 0) ? seg->stats.col_freq : RANK_NONE;
+    else return (seg->stats.backward_t > 0) ? -seg->stats.backward_t : RANK_NONE;
+  }
+
+  void rank(simSegment* seg) {
+    if (ranking != NULL) ranking->update(ranking->index(seg->column_id, seg->segment_id), rankKey(seg));
+  }
+
+  void cache(simSegment* seg, bool in_gpu) {
+    if (seg->in_gpu == in_gpu) return;
+    seg->in_gpu = in_gpu;
+    tot_seg_in_GPU[seg->column_id] += in_gpu ? 1 : -1;
+    if (ranking != NULL) ranking->setCached(ranking->index(seg->column_id, seg->segment_id), in_gpu);
+    if (in_gpu) result.admitted++;
+    else result.evicted++;
+  }
+
+  //CacheManager::updateSegmentTimeDirect and updateColumnTimestamp
+  void touchStats(simStats& stats, int total_segment, double timestamp) {
+    stats.backward_t = timestamp - (stats.timestamp * total_segment);
+    stats.timestamp = timestamp / total_segment;
+    stats.col_freq += 1.0 / total_segment;
+  }
+
+  void replay(traceQuery& q) {
+    //the residency before the query decides its hits
+    double time = q.time;
+    for (int i = 0; i < q.access.size(); i++) {
+      traceAccess& a = q.access[i];
+      bool hit = segment[a.column_id][a.segment_id].in_gpu;
+      result.accesses++;
+      if (hit) result.hits++;
+      time += ((int) a.in_gpu - (int) hit) * a.speedup / trace.column[a.column_id].total_segment;
+    }
+    result.recorded_ms += q.time;
+    result.estimated_ms += max(0.0, time);
+    result.skipped += q.skipped;
+
+    //every column of the query gets the next logical time, like updateStatsQuery
+    double time_count = logical_time;
+    logical_time += 20;
+    vector<double> column_time(trace.column.size(), -1);
+    for (int i = 0; i < q.access.size(); i++) {
+      traceAccess& a = q.access[i];
+      if (column_time[a.column_id] < 0) {
+        column_time[a.column_id] = ++time_count;
+        touchStats(column_stats[a.column_id], trace.column[a.column_id].total_segment, time_count);
+      }
+      simSegment* seg = &segment[a.column_id][a.segment_id];
+      touchStats(seg->stats, trace.column[a.column_id].total_segment, column_time[a.column_id]);
+      rank(seg);
+    }
+    for (int i = 0; i < q.weight.size(); i++) {
+      simSegment* seg = &segment[q.weight[i].column_id][q.weight[i].segment_id];
+      seg->weight += q.weight[i].weight;
+      rank(seg);
+    }
+  }
+
+  void segmentReplacement() {
+    if (ranking == NULL) {
+      ranking = new SegmentRanking<simSegment>();
+      ranking->build(segment_ptr, [&](simSegment* seg) { return rankKey(seg); }, [&](simSegment* seg) { return seg->in_gpu; });
+    }
+    vector<simSegment*> evict, admit;
+    ranking->replace(cache_total_seg - 1, evict, admit);
+    for (int i = 0; i < evict.size(); i++) cache(evict[i], false);
+    for (int i = 0; i < admit.size(); i++) cache(admit[i], true);
+  }
+
+  //CacheManager::LRUReplacement, LFUReplacement and LRU_2Replacement: whole columns by their column statistic
+  void columnReplacement() {
+    int num_column = trace.column.size();
+    vector<int> order;
+    for (int i = 0; i < num_column; i++) order.push_back(i);
+    stable_sort(order.begin(), order.end(), [&](int a, int b) {
+      simStats& x = column_stats[a];
+      simStats& y = column_stats[b];
+      if (policy == SimLRU) return x.timestamp > y.timestamp;
+      if (policy == SimLRU2) return x.backward_t < y.backward_t;
+      if (x.col_freq != y.col_freq) return x.col_freq > y.col_freq;
+      return x.timestamp < y.timestamp; //equal frequency, the LFU of CacheManager takes the older column first
+    });
+
+    int temp_buffer_size = 0;
+    vector<bool> place(num_column, false);
+    for (int k = 0; k < num_column; k++) {
+      int i = order[k];
+      double key = (policy == SimLRU) ? column_stats[i].timestamp : (policy == SimLRU2) ? column_stats[i].backward_t : column_stats[i].col_freq;
+      if (key > 0 && temp_buffer_size + trace.column[i].total_segment < cache_total_seg) {
+        temp_buffer_size += trace.column[i].total_segment;
+        place[i] = true;
+      }
+    }
+
+    for (int i = 0; i < num_column; i++)
+      if (!place[i] && tot_seg_in_GPU[i] > 0)
+        for (int j = 0; j < segment[i].size(); j++) cache(&segment[i][j], false);
+    for (int i = 0; i < num_column; i++)
+      if (place[i] && tot_seg_in_GPU[i] == 0)
+        for (int j = 0; j < segment[i].size(); j++) cache(&segment[i][j], true);
+  }
+
+  //CacheManager::newEpoch with the factor bench uses after a replacement of the policy
+  void newEpoch() {
+    double param;
+    if (policy == SimSemanticAware || policy == SimLFUSegmented) param = 0.5;
+    else if (policy == SimLRU2Segmented) param = 2.0;
+    else return;
+
+    for (int i = 0; i < segment.size(); i++) {
+      for (int j = 0; j < segment[i].size(); j++) {
+        segment[i][j].weight *= param;
+        segment[i][j].stats.col_freq *= param;
+        segment[i][j].stats.backward_t *= param;
+      }
+    }
+    if (ranking != NULL) {
+      ranking->rescale(param);
+      if (!(ranking->scale > 1e-100 && ranking->scale < 1e100)) {
+        delete ranking;
+        ranking = NULL;
+      }
+    }
+  }
+
+  void replacement() {
+    chrono::high_resolution_clock::time_point st = chrono::high_resolution_clock::now();
+    if (segmented()) segmentReplacement();
+    else columnReplacement();
+    newEpoch();
+    chrono::high_resolution_clock::time_point finish = chrono::high_resolution_clock::now();
+    result.replacement_ms += (chrono::duration_cast<chrono::microseconds>(finish - st)).count() / 1000.0;
+    result.replacements++;
+  }
+
+  simResult run() {
+    for (int i = 0; i < trace.queries.size(); i++) {
+      replay(trace.queries[i]);
+      if ((every > 0) ? ((i + 1) % every == 0) : trace.queries[i].replace) replacement();
+    }
+    return result;
+  }
+};
+
+int main(int argc, char** argv) {
+  string trace_file;
+  string out = "-";
+  vector<double> cache_mb;
+  vector<string> policies;
+  int every = 0;
+  double pcie = 12; //GB/s, BW_PCI of the cost model
+
+  CommandLineArgs args(argc, argv);
+  args.GetCmdLineArgument("trace", trace_file);
+  args.GetCmdLineArgument("out", out);
+  args.GetCmdLineArguments("cache_mb", cache_mb);
+  args.GetCmdLineArguments("policy", policies);
+  args.GetCmdLineArgument("every", every);
+  args.GetCmdLineArgument("pcie", pcie);
+
+  if (args.CheckCmdLineFlag("help") || trace_file.empty()) {
+    printf("%s "
+      "--trace=<trace recorded by bench> "
+      "[--cache_mb=<gpu cache sizes, default 100 to 6400 doubling>] "
+      "[--policy=<policies, default all>] "
+      "[--every=<replace every n queries instead of where the run did>] "
+      "[--pcie=<GB/s>] "
+      "[--out=<json lines, - for stdout>] "
+      "\n", argv[0]);
+    exit(0);
+  }
+
+  QueryTrace trace;
+  if (!trace.read(trace_file)) {
+    fprintf(stderr, "Could not read trace %s\n", trace_file.c_str());
+    return 1;
+  }
+
+  if (cache_mb.empty())
+    for (double mb = 100; mb <= 6400; mb *= 2) cache_mb.push_back(mb);
+
+  vector<SimPolicy> sim_policy;
+  for (int p = 0; p < SimPolicyCount; p++) {
+    bool selected = policies.empty() || find(policies.begin(), policies.end(), string("all")) != policies.end()
+      || find(policies.begin(), policies.end(), string(sim_policy_name[p])) != policies.end();
+    if (selected) sim_policy.push_back((SimPolicy) p);
+  }
+  if (sim_policy.empty()) {
+    fprintf(stderr, "No known policy selected\n");
+    return 1;
+  }
+
+  FILE* fptr = (out == "-") ? stdout : fopen(out.c_str(), "w");
+  if (fptr == NULL) {
+    fprintf(stderr, "Could not open %s\n", out.c_str());
+    return 1;
+  }
+
+  int num_run = sim_policy.size() * cache_mb.size();
+  vector<simResult> results(num_run);
+
+  chrono::high_resolution_clock::time_point st = chrono::high_resolution_clock::now();
+
+  parallel_for(0, num_run, [&](int r) {
+    int cache_total_seg = (int) (cache_mb[r % cache_mb.size()] * 1048576 / sizeof(int) / SEGMENT_SIZE);
+    CacheSim sim(trace, sim_policy[r / cache_mb.size()], cache_total_seg, every);
+    results[r] = sim.run();
+  });
+
+  chrono::high_resolution_clock::time_point finish = chrono::high_resolution_clock::now();
+  double sim_ms = (chrono::duration_cast<chrono::microseconds>(finish - st)).count() / 1000.0;
+
+  for (int r = 0; r < num_run; r++) {
+    simResult& res = results[r];
+    double bytes = (double) res.admitted * SEGMENT_BYTES;
+    double transfer_ms = bytes / (pcie * 1000000);
+    fprintf(fptr, "{\"type\":\"sim\",\"policy\":\"%s\",\"cache_mb\":%g,\"queries\":%d,\"replacements\":%d,"
+      "\"accesses\":%lld,\"hits\":%lld,\"hit_ratio\":%.4f,\"skipped_segments\":%lld,"
+      "\"admitted_segments\":%lld,\"evicted_segments\":%lld,\"transfer_bytes\":%.0f,\"transfer_ms\":%.3f,"
+      "\"recorded_ms\":%.3f,\"estimated_ms\":%.3f,\"estimated_total_ms\":%.3f,\"replacement_ms\":%.3f}\n",
+      sim_policy_name[sim_policy[r / cache_mb.size()]], cache_mb[r % cache_mb.size()], (int) trace.queries.size(), res.replacements,
+      res.accesses, res.hits, res.accesses > 0 ? res.hits * 1.0 / res.accesses : 0, res.skipped,
+      res.admitted, res.evicted, bytes, transfer_ms,
+      res.recorded_ms, res.estimated_ms, res.estimated_ms + transfer_ms, res.replacement_ms);
+  }
+
+  if (fptr != stdout) fclose(fptr);
+
+  cerr << num_run << " simulations of " << trace.queries.size() << " queries in " << sim_ms << " ms" << endl;
+
+  return 0;
+}
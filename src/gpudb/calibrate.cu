@@ -0,0 +1,40 @@
+#include "MachineProfile.h"
+#include "DeviceBackend.h"
+#include "utils/cpu_utils.h"
+
+//offline calibration of the cost model: measures sequential read, streaming write, random probes by hash table
+//size and host to device transfers, and writes the machine profile main and bench load with --profile
+int main(int argc, char** argv) {
+  std::string out = "machine.profile";
+  bool quick = false;
+  bool host = false;
+
+  CommandLineArgs args(argc, argv);
+  args.GetCmdLineArgument("out", out);
+  quick = args.CheckCmdLineFlag("quick");
+  host = args.CheckCmdLineFlag("host");
+
+  if (args.CheckCmdLineFlag("help")) {
+    printf("%s "
+      "[--out=<profile file>] "
+      "[--quick] "
+      "[--host (transfers of the emulated gpu)] "
+      "\n", argv[0]);
+    exit(0);
+  }
+
+  int device_count = 0;
+  if (cudaGetDeviceCount(&device_count) != cudaSuccess || device_count == 0) host = true;
+  if (host) setDeviceBackend(new HostDevice());
+  else cudaSetDevice(0);
+
+  calibrateMachine(quick, true);
+
+  if (!saveMachineProfile(out)) {
+    fprintf(stderr, "Could not write machine profile %s\n", out.c_str());
+    return 1;
+  }
+  printf("Wrote %s\n", out.c_str());
+
+  return 0;
+}
@@ -14,11 +14,17 @@
 #include <chrono>
 #include <atomic>
 #include <random>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include <curand.h>
 #include <cuda.h>
 #include <cub/util_allocator.cuh>
 #include "crystal/crystal.cuh"
+#include "DeviceBackend.h"
+#include "Catalog.h"
+#include "NumaPlacement.h"
 
 #include "tbb/tbb.h"
 #include "PerfEvent.hpp"
@@ -27,50 +33,15 @@ using namespace cub;
 using namespace std;
 using namespace tbb;
 
-#define SF 40
 #define NUM_EVENTS 2
 
-#define BASE_PATH "/home/ubuntu/Implementation-GPUDB/test/ssb/data/"
-
-#if SF == 1
-#define DATA_DIR BASE_PATH "s1_columnar/"
-#define LO_LEN 6001171
-//#define LO_LEN 1000
-#define P_LEN 200000
-#define S_LEN 2000
-#define C_LEN 30000
-#define D_LEN 2556
-#elif SF == 10
-#define DATA_DIR BASE_PATH "s10_columnar/"
-#define LO_LEN 59986214
-#define P_LEN 800000
-#define S_LEN 20000
-#define C_LEN 300000
-#define D_LEN 2556
-#elif SF == 20
-#define DATA_DIR BASE_PATH "s20_columnar/"
-#define LO_LEN 119994746
-#define P_LEN 1000000
-#define S_LEN 40000
-#define C_LEN 600000
-#define D_LEN 2556
-#elif SF == 40
-#define DATA_DIR BASE_PATH "s40_columnar/"
-#define LO_LEN 240012412
-#define P_LEN 1200000
-#define S_LEN 80000
-#define C_LEN 1200000
-#define D_LEN 2556
-#elif SF == 160
-#define DATA_DIR BASE_PATH "s160_columnar/"
-#define LO_LEN 960017453
-#define P_LEN 1600000
-#define S_LEN 320000
-#define C_LEN 4800000
-#define D_LEN 2556
-#endif
-
-#define SEGMENT_SIZE 1048576
+//data directory and table lengths come from the catalog of the data directory at startup
+#define DATA_DIR (catalog().data_dir)
+#define LO_LEN (catalog().lo_len)
+#define P_LEN (catalog().p_len)
+#define S_LEN (catalog().s_len)
+#define C_LEN (catalog().c_len)
+#define D_LEN (catalog().d_len)
 
 inline int index_of(string* arr, int len, string val) {
   for (int i=0; i<len; i++)
@@ -81,6 +52,9 @@ inline int index_of(string* arr, int len, string val) {
 }
 
 inline string lookup(string col_name) {
+  string file = catalogFile(col_name, false);
+  if (!file.empty()) return file;
+
   string lineorder[] = { "lo_orderkey", "lo_linenumber", "lo_custkey", "lo_partkey", "lo_suppkey", "lo_orderdate", "lo_orderpriority", "lo_shippriority", "lo_quantity", "lo_extendedprice", "lo_ordtotalprice", "lo_discount", "lo_revenue", "lo_supplycost", "lo_tax", "lo_commitdate", "lo_shipmode"};
   string part[] = {"p_partkey", "p_name", "p_mfgr", "p_category", "p_brand1", "p_color", "p_type", "p_size", "p_container"};
   string supplier[] = {"s_suppkey", "s_name", "s_address", "s_city", "s_nation", "s_region", "s_phone"};
@@ -108,6 +82,9 @@ inline string lookup(string col_name) {
 }
 
 inline string lookupSort(string col_name) {
+  string file = catalogFile(col_name, true);
+  if (!file.empty()) return file;
+
   string lineorder[] = { "lo_orderkey", "lo_linenumber", "lo_custkey", "lo_partkey", "lo_suppkey", "lo_orderdate", "lo_orderpriority", "lo_shippriority", "lo_quantity", "lo_extendedprice", "lo_ordtotalprice", "lo_discount", "lo_revenue", "lo_supplycost", "lo_tax", "lo_commitdate", "lo_shipmode"};
   string part[] = {"p_partkey", "p_name", "p_mfgr", "p_category", "p_brand1", "p_color", "p_type", "p_size", "p_container"};
   string supplier[] = {"s_suppkey", "s_name", "s_address", "s_city", "s_nation", "s_region", "s_phone"};
@@ -134,8 +111,133 @@ inline string lookupSort(string col_name) {
   return "";
 }
 
+//how the loaders below bring a column file into host memory
+typedef struct columnMapOptions {
+  bool mmap; //map the file instead of reading it into a new buffer
+  bool populate; //MAP_POPULATE, fault the whole column in when it is mapped
+  int advice; //madvise advice for the column (MADV_NORMAL, MADV_SEQUENTIAL, MADV_RANDOM, MADV_WILLNEED)
+  //MADV_HUGEPAGE on the columns read into anonymous memory (numa placement). transparent huge pages do not
+  //back MAP_PRIVATE file mappings, so the mapped columns ignore it
+  bool huge_pages;
+  //the Pinned loaders register their mapping with the device so copies run at pinned bandwidth, as their
+  //cudaHostAlloc buffers did before. touches every page. the other loaders never pin
+  bool pin;
+} columnMapOptions;
+
+inline columnMapOptions& columnMap() {
+  static columnMapOptions options = {true, false, MADV_NORMAL, false, true};
+  return options;
+}
+
+//padded size and pin state of every mapped column, keyed by its address
+inline unordered_map<void*, pair<size_t, bool>>& mappedColumns() {
+  static unordered_map<void*, pair<size_t, bool>> mapped;
+  return mapped;
+}
+
+//the padded range is reserved as anonymous memory and the file is mapped over its head,
+//so the padding up to the segment boundary is zero pages and nothing is copied.
+//pages are only read from disk when a query first touches them (unless populate is set)
+inline void* mapColumnFile(string filename, size_t file_bytes, size_t padded_bytes, bool pin) {
+  columnMapOptions& options = columnMap();
+
+  void* base = mmap(NULL, padded_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (base == MAP_FAILED) return NULL;
+
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    munmap(base, padded_bytes);
+    return NULL;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    munmap(base, padded_bytes);
+    return NULL;
+  }
+  size_t map_bytes = min(file_bytes, (size_t) st.st_size);
+  if (map_bytes > 0) {
+    int flags = MAP_PRIVATE | MAP_FIXED | (options.populate ? MAP_POPULATE : 0);
+    if (mmap(base, map_bytes, PROT_READ | PROT_WRITE, flags, fd, 0) == MAP_FAILED) {
+      close(fd);
+      munmap(base, padded_bytes);
+      return NULL;
+    }
+  }
+  close(fd);
+
+  if (options.advice != MADV_NORMAL) madvise(base, padded_bytes, options.advice);
+  if (pin) CubDebugExit(deviceHostRegister(base, padded_bytes, cudaHostRegisterDefault));
+
+  mappedColumns()[base] = make_pair(padded_bytes, pin);
+  return base;
+}
+
+template<typename T>
+T* loadColumnMapped(string filename, int num_entries, bool pin) {
+  size_t padded_bytes = ((size_t) (num_entries + SEGMENT_SIZE - 1)/SEGMENT_SIZE) * SEGMENT_SIZE * sizeof(T);
+  return (T*) mapColumnFile(filename, (size_t) num_entries * sizeof(T), padded_bytes, pin);
+}
+
+//frees a column returned by any of the loaders
+template<typename T>
+void releaseColumn(T* h_col, bool pinned) {
+  if (h_col == NULL) return;
+
+  auto it = mappedColumns().find((void*) h_col);
+  if (it != mappedColumns().end()) {
+    if (it->second.second) CubDebugExit(deviceHostUnregister(h_col));
+    munmap(h_col, it->second.first);
+    mappedColumns().erase(it);
+  } else if (pinned) {
+    CubDebugExit(deviceFreeHost(h_col));
+  } else {
+    delete[] h_col;
+  }
+}
+
+//under numa placement the segments of a fact column are bound to their home node and read in,
+//pages of a file mapping would stay on whichever node the page cache put them
+template<typename T>
+T* loadColumnPlaced(string filename, int num_entries) {
+  int total_segment = (num_entries + SEGMENT_SIZE - 1)/SEGMENT_SIZE;
+  size_t segment_bytes = (size_t) SEGMENT_SIZE * sizeof(T);
+  size_t padded_bytes = total_segment * segment_bytes;
+  size_t file_bytes = (size_t) num_entries * sizeof(T);
+
+  void* base = mmap(NULL, padded_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (base == MAP_FAILED) return NULL;
+  if (columnMap().huge_pages) madvise(base, padded_bytes, MADV_HUGEPAGE);
+  numaPlaceSegments(base, segment_bytes, total_segment);
+
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    munmap(base, padded_bytes);
+    return NULL;
+  }
+
+  parallel_for(0, total_segment, [&](int s) {
+    size_t done = (size_t) s * segment_bytes;
+    size_t end = min(done + segment_bytes, file_bytes);
+    while (done < end) {
+      ssize_t n = pread(fd, (char*) base + done, end - done, done);
+      if (n <= 0) break;
+      done += n;
+    }
+  });
+  close(fd);
+
+  if (columnMap().pin) CubDebugExit(deviceHostRegister(base, padded_bytes, cudaHostRegisterDefault));
+
+  mappedColumns()[base] = make_pair(padded_bytes, columnMap().pin);
+  return (T*) base;
+}
+
 template<typename T>
 T* loadColumn(string col_name, int num_entries) {
+  if (columnMap().mmap) return loadColumnMapped<T>(DATA_DIR + lookup(col_name), num_entries, false);
+
   T* h_col = new T[((num_entries + SEGMENT_SIZE - 1)/SEGMENT_SIZE) * SEGMENT_SIZE];
   string filename = DATA_DIR + lookup(col_name);
   ifstream colData (filename.c_str(), ios::in | ios::binary);
@@ -149,8 +251,10 @@ T* loadColumn(string col_name, int num_entries) {
 
 template<typename T>
 T* loadColumnPinned(string col_name, int num_entries) {
+  if (columnMap().mmap) return loadColumnMapped<T>(DATA_DIR + lookup(col_name), num_entries, columnMap().pin);
+
   T* h_col;
-  CubDebugExit(cudaHostAlloc((void**) &h_col, ((num_entries + SEGMENT_SIZE - 1)/SEGMENT_SIZE) * SEGMENT_SIZE * sizeof(T), cudaHostAllocDefault));
+  CubDebugExit(deviceHostAlloc((void**) &h_col, ((num_entries + SEGMENT_SIZE - 1)/SEGMENT_SIZE) * SEGMENT_SIZE * sizeof(T), cudaHostAllocDefault));
   string filename = DATA_DIR + lookup(col_name);
   ifstream colData (filename.c_str(), ios::in | ios::binary);
   if (!colData) {
@@ -163,6 +267,8 @@ T* loadColumnPinned(string col_name, int num_entries) {
 
 template<typename T>
 T* loadColumnSort(string col_name, int num_entries) {
+  if (columnMap().mmap) return loadColumnMapped<T>(DATA_DIR + lookupSort(col_name), num_entries, false);
+
   T* h_col = new T[((num_entries + SEGMENT_SIZE - 1)/SEGMENT_SIZE) * SEGMENT_SIZE];
   string filename = DATA_DIR + lookupSort(col_name);
   ifstream colData (filename.c_str(), ios::in | ios::binary);
@@ -176,8 +282,11 @@ T* loadColumnSort(string col_name, int num_entries) {
 
 template<typename T>
 T* loadColumnPinnedSort(string col_name, int num_entries) {
+  if (numaActive()) return loadColumnPlaced<T>(DATA_DIR + lookupSort(col_name), num_entries);
+  if (columnMap().mmap) return loadColumnMapped<T>(DATA_DIR + lookupSort(col_name), num_entries, columnMap().pin);
+
   T* h_col;
-  CubDebugExit(cudaHostAlloc((void**) &h_col, ((num_entries + SEGMENT_SIZE - 1)/SEGMENT_SIZE) * SEGMENT_SIZE * sizeof(T), cudaHostAllocDefault));
+  CubDebugExit(deviceHostAlloc((void**) &h_col, ((num_entries + SEGMENT_SIZE - 1)/SEGMENT_SIZE) * SEGMENT_SIZE * sizeof(T), cudaHostAllocDefault));
   string filename = DATA_DIR + lookupSort(col_name);
   ifstream colData (filename.c_str(), ios::in | ios::binary);
   if (!colData) {
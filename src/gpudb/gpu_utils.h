@@ -3,8 +3,8 @@
 #define CUB_STDERR
 
 #define CHECK_ERROR() { \
-  cudaDeviceSynchronize(); \
-  cudaError_t error = cudaGetLastError(); \
+  deviceSynchronize(); \
+  cudaError_t error = deviceGetLastError(); \
   if(error != cudaSuccess) \
   { \
     gpuErrchk(error); \
@@ -13,8 +13,8 @@
 }
 
 #define CHECK_ERROR_STREAM(stream) { \
-  cudaStreamSynchronize(stream); \
-  cudaError_t error = cudaGetLastError(); \
+  deviceStreamSynchronize(stream); \
+  cudaError_t error = deviceGetLastError(); \
   if(error != cudaSuccess) \
   { \
     gpuErrchk(error); \
@@ -35,14 +35,14 @@ inline void gpuAssert(cudaError_t code, const char *file, int line, bool abort=t
    }
 }
 
-#define SETUP_TIMING() cudaEvent_t start, stop; cudaEventCreate(&start); cudaEventCreate(&stop);
+#define SETUP_TIMING() deviceEvent_t start, stop; deviceEventCreate(&start); deviceEventCreate(&stop);
 
 #define TIME_FUNC(f,t) { \
-    cudaEventRecord(start, 0); \
+    deviceEventRecord(start, 0); \
     f; \
-    cudaEventRecord(stop, 0); \
-    cudaEventSynchronize(stop); \
-    cudaEventElapsedTime(&t, start,stop); \
+    deviceEventRecord(stop, 0); \
+    deviceEventSynchronize(stop); \
+    deviceEventElapsedTime(&t, start,stop); \
 }
 
 #define CLEANUP(vec) if(vec)CubDebugExit(g_allocator.DeviceFree(vec))
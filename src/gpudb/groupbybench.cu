@@ -0,0 +1,108 @@
+#include "CPUProcessing.h"
+#include "utils/cpu_utils.h"
+
+//group ids in [0, num_groups) following a zipf distribution, sampled through the inverse cdf
+void generateZipfGroups(int* group, int num_items, int num_groups, double alpha, int seed) {
+  vector<double> cdf(num_groups);
+  double sum = 0;
+  for (int i = 0; i < num_groups; i++) {
+    sum += 1.0 / pow((double) (i + 1), alpha);
+    cdf[i] = sum;
+  }
+
+  //scatter the ranks so hot groups do not share cache lines
+  vector<int> perm(num_groups);
+  for (int i = 0; i < num_groups; i++) perm[i] = i;
+  mt19937 gen(seed);
+  shuffle(perm.begin(), perm.end(), gen);
+
+  uniform_real_distribution<double> dist(0, sum);
+  for (int i = 0; i < num_items; i++) {
+    int rank = lower_bound(cdf.begin(), cdf.end(), dist(gen)) - cdf.begin();
+    if (rank >= num_groups) rank = num_groups - 1;
+    group[i] = perm[rank];
+  }
+}
+
+float runGroupBy(GroupByModeCPU mode, struct offsetCPU offset, struct groupbyArgsCPU gargs, int num_items, int* res) {
+  memset(res, 0, gargs.total_val * 6 * sizeof(int));
+  group_by_mode_cpu = mode;
+
+  chrono::high_resolution_clock::time_point st = chrono::high_resolution_clock::now();
+  groupByCPU(offset, gargs, num_items, res);
+  chrono::high_resolution_clock::time_point finish = chrono::high_resolution_clock::now();
+
+  return (chrono::duration_cast<chrono::microseconds>(finish - st)).count() / 1000.0;
+}
+
+int main(int argc, char** argv) {
+  int num_items = 1 << 24;
+  int num_groups = 4096;
+  int num_trials = 3;
+
+  CommandLineArgs args(argc, argv);
+  args.GetCmdLineArgument("n", num_items);
+  args.GetCmdLineArgument("g", num_groups);
+  args.GetCmdLineArgument("t", num_trials);
+
+  if (args.CheckCmdLineFlag("help")) {
+    printf("%s "
+      "[--n=<input items>] "
+      "[--g=<num groups>] "
+      "[--t=<num trials>] "
+      "\n", argv[0]);
+    exit(0);
+  }
+
+  int* lo_off = new int[num_items];
+  int* dim_off = new int[num_items];
+  int* aggr = new int[num_items];
+  int* group_col = new int[num_groups];
+  int* res = new int[num_groups * 6];
+  int* res_atomic = new int[num_groups * 6];
+
+  for (int i = 0; i < num_items; i++) {
+    lo_off[i] = i;
+    aggr[i] = i % 100 + 1;
+  }
+  for (int i = 0; i < num_groups; i++) group_col[i] = i + 1;
+
+  struct offsetCPU offset = {lo_off, dim_off, NULL, NULL, NULL};
+  struct groupbyArgsCPU gargs = {
+    aggr, NULL, group_col, NULL, NULL, NULL,
+    1, 0, 0, 0, 1, 0, 0, 0,
+    num_groups, 0, NULL
+  };
+
+  const char* mode_name[] = {"atomic", "local", "partitioned", "auto"};
+  double alpha[] = {0, 0.5, 1.0, 1.5, 2.0};
+
+  cout << "items " << num_items << " groups " << num_groups << " auto picks " << mode_name[GroupByCPU::chooseMode(num_groups, num_items)] << endl;
+
+  for (int a = 0; a < 5; a++) {
+    generateZipfGroups(dim_off, num_items, num_groups, alpha[a], 123);
+
+    runGroupBy(GroupByAtomic, offset, gargs, num_items, res_atomic);
+
+    for (int mode = GroupByAtomic; mode <= GroupByPartitioned; mode++) {
+      float best = 0;
+      for (int trial = 0; trial < num_trials; trial++) {
+        float time = runGroupBy((GroupByModeCPU) mode, offset, gargs, num_items, res);
+        if (trial == 0 || time < best) best = time;
+      }
+      bool correct = (memcmp(res, res_atomic, num_groups * 6 * sizeof(int)) == 0);
+      cout << "alpha " << alpha[a] << " " << mode_name[mode] << " " << best << " ms" << (correct ? "" : " WRONG RESULT") << endl;
+    }
+  }
+
+  group_by_mode_cpu = GroupByAuto;
+
+  delete[] lo_off;
+  delete[] dim_off;
+  delete[] aggr;
+  delete[] group_col;
+  delete[] res;
+  delete[] res_atomic;
+
+  return 0;
+}
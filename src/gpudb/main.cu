@@ -2,14 +2,101 @@
 #include "QueryOptimizer.h"
 #include "CPUGPUProcessing.h"
 #include "CacheManager.h"
+#include "HashTableCache.h"
+#include "ResultCache.h"
 #include "CPUProcessing.h"
 #include "CostModel.h"
+#include "MachineProfile.h"
+#include "CPUJit.h"
+
+int main(int argc, char** argv) {
+
+	bool host_device = false;
+	double pcie_bandwidth = HOST_DEVICE_BW_PCI;
+	string data_dir;
+	int sf = 0;
+	bool plan = true;
+	string plan_variants;
+	bool async_admission = false;
+	double admission_bandwidth = 0;
+	int ht_cache_mb = 0;
+	int result_cache_mb = 0;
+	string profile = getenv("MORDRED_PROFILE") ? getenv("MORDRED_PROFILE") : "";
+	bool calibrate = false;
+
+	for (int i = 1; i < argc; i++) {
+		string arg = argv[i];
+		if (arg.compare("--host") == 0) host_device = true;
+		else if (arg.compare("--pcie") == 0 && i + 1 < argc) pcie_bandwidth = stod(argv[++i]) * 1000000; //GB/s to bytes per ms
+		else if (arg.compare("--data") == 0 && i + 1 < argc) data_dir = argv[++i];
+		else if (arg.compare("--sf") == 0 && i + 1 < argc) sf = stoi(argv[++i]);
+		else if (arg.compare("--read") == 0) columnMap().mmap = false;
+		else if (arg.compare("--populate") == 0) columnMap().populate = true;
+		else if (arg.compare("--hugepages") == 0) columnMap().huge_pages = true;
+		else if (arg.compare("--pin") == 0) columnMap().pin = true;
+		else if (arg.compare("--nopin") == 0) columnMap().pin = false;
+		else if (arg.compare("--nomorsel") == 0) morsel_driven_cpu = false;
+		else if (arg.compare("--noplan") == 0) plan = false;
+		else if (arg.compare("--plan-variants") == 0 && i + 1 < argc) plan_variants = argv[++i];
+		else if (arg.compare("--async-admission") == 0) async_admission = true;
+		else if (arg.compare("--admission-bw") == 0 && i + 1 < argc) admission_bandwidth = stod(argv[++i]) * 1000000; //GB/s to bytes per ms
+		else if (arg.compare("--ht-cache") == 0) ht_cache_mb = (i + 1 < argc && isdigit(argv[i + 1][0])) ? stoi(argv[++i]) : HT_CACHE_MB;
+		else if (arg.compare("--shared-scan") == 0) shared_scan_cpu = true;
+		else if (arg.compare("--profile") == 0 && i + 1 < argc) profile = argv[++i];
+		else if (arg.compare("--calibrate") == 0) calibrate = true;
+		else if (arg.compare("--result-cache") == 0) result_cache_mb = (i + 1 < argc && isdigit(argv[i + 1][0])) ? stoi(argv[++i]) : RESULT_CACHE_MB;
+		else if (arg.compare("--nopack") == 0) packed_scan_cpu = false;
+		else if (arg.compare("--noslice") == 0) sliced_scan_cpu = false;
+		else if (arg.compare("--noaggr") == 0) segment_aggregates = false;
+		else if (arg.compare("--nojoinskip") == 0) join_skipping = false;
+		else if (arg.compare("--jit") == 0) jit_cpu = true;
+		else if (arg.compare("--jit-dir") == 0 && i + 1 < argc) setJitDir(argv[++i]);
+		else if (arg.compare("--jit-cxx") == 0 && i + 1 < argc) setJitCompiler(argv[++i]);
+		else if (arg.compare("--probe") == 0 && i + 1 < argc) {
+			ProbeModeCPU mode = probeModeCPU(argv[++i]);
+			if (mode != ProbeModeCount) probe_mode_cpu = mode;
+		}
+		else if (arg.compare("--numa") == 0) numaPlacement().enable = true;
+		else if (arg.compare("--numa-partition") == 0) numaPlacement().enable = numaPlacement().partition = true;
+		else if (arg.compare("--numa-nopin") == 0) numaPlacement().pin_workers = false;
+		else if (arg.compare("--numa-noreplicate") == 0) numaPlacement().replicate_ht = false;
+		else if (arg.compare("--madvise") == 0 && i + 1 < argc) {
+			string advice = argv[++i];
+			if (advice.compare("sequential") == 0) columnMap().advice = MADV_SEQUENTIAL;
+			else if (advice.compare("random") == 0) columnMap().advice = MADV_RANDOM;
+			else if (advice.compare("willneed") == 0) columnMap().advice = MADV_WILLNEED;
+			else columnMap().advice = MADV_NORMAL;
+		}
+	}
+
+	if (!data_dir.empty()) openCatalog(data_dir, sf);
+	else if (sf != 0) openCatalog(catalogSFDir(sf), sf);
+	cout << "Data " << DATA_DIR << " lineorder " << LO_LEN << " rows" << endl;
+
+	numaInit();
+	if (numaActive()) cout << "Placing lineorder over " << numaNodes() << " numa nodes" << (numaPlacement().partition ? " (partitioned)" : " (interleaved)") << endl;
 
-int main() {
+	int device_count = 0;
+	if (cudaGetDeviceCount(&device_count) != cudaSuccess || device_count == 0) host_device = true;
 
-	cudaSetDevice(0);
 	CUdevice device;
-	cuDeviceGet(&device, 0);
+	if (host_device) {
+		cout << "Running on emulated GPU in host memory, PCIe bandwidth " << pcie_bandwidth / 1000000 << " GB/s" << endl;
+		setDeviceBackend(new HostDevice(HOST_DEVICE_CAPACITY, pcie_bandwidth));
+	} else {
+		cudaSetDevice(0);
+		cuDeviceGet(&device, 0);
+	}
+
+	//the cost model prices operators with the measured bandwidths, --calibrate refreshes the profile at startup
+	if (calibrate) {
+		cout << "Calibrating the cost model" << endl;
+		calibrateMachine(true, true);
+		if (!profile.empty() && !saveMachineProfile(profile)) fprintf(stderr, "Could not write machine profile %s\n", profile.c_str());
+	} else if (!profile.empty()) {
+		if (loadMachineProfile(profile)) cout << "Machine profile " << profile << endl;
+		else fprintf(stderr, "Could not read machine profile %s, using the default bandwidths\n", profile.c_str());
+	}
 
 	bool verbose = 0;
 
@@ -29,6 +116,10 @@ int main() {
 	cout << endl;
 
 	CacheManager* cm = cgp->cm;
+	cm->async_admission = async_admission;
+	cm->admission_bandwidth = admission_bandwidth;
+	if (ht_cache_mb > 0) cm->ht_cache = new HashTableCache(cm, (size_t) ht_cache_mb * 1048576);
+	if (result_cache_mb > 0) cm->result_cache = new ResultCache((size_t) result_cache_mb * 1048576);
 
 	bool exit = 0;
 	string input, query, many, policy;
@@ -56,6 +147,9 @@ int main() {
 
 	qp = new QueryProcessing(cgp, verbose, dist);
 
+	string plan_error;
+	if (!plan_variants.empty() && !qp->plan_cache->enableVariants(plan_variants, plan_error)) cerr << plan_error << endl;
+
 	if (dist == Zipf) {
 		qp->qo->setDistributionZipfian(alpha);
 	} else if (dist == Norm) {
@@ -64,10 +158,12 @@ int main() {
 
 	CUcontext sessionCtx = NULL;
 	CUcontext poppedCtx, curCtx;
-	CHECK_CU_ERROR( cuCtxCreate(&sessionCtx, 0, device), "cuCtxCreate");
-	cuCtxGetCurrent(&curCtx); cout << curCtx << endl;
-	CHECK_CU_ERROR( cuCtxPopCurrent(&poppedCtx), "cuCtxPopCurrent" );
-	cuCtxGetCurrent(&curCtx); cout << curCtx << endl;
+	if (!host_device) {
+		CHECK_CU_ERROR( cuCtxCreate(&sessionCtx, 0, device), "cuCtxCreate");
+		cuCtxGetCurrent(&curCtx); cout << curCtx << endl;
+		CHECK_CU_ERROR( cuCtxPopCurrent(&poppedCtx), "cuCtxPopCurrent" );
+		cuCtxGetCurrent(&curCtx); cout << curCtx << endl;
+	}
 
 	while (!exit) {
 		cout << "Select Options:" << endl;
@@ -81,9 +177,16 @@ int main() {
 		cout << "clear. Delete Columns from GPU" << endl;
 		cout << "custom. Toggle custom malloc" << endl;
 		cout << "skipping. Toggle segment skipping" << endl;
+		cout << "joinskip. Toggle segment skipping on the dimension predicates" << endl;
 		cout << "nopipe. Toggle operator pipelining" << endl;
 		cout << "emat. Toggle late materialization" << endl;
 		cout << "HE. Toggle segment-level query execution" << endl;
+		cout << "probe. Set CPU hash probe mode (direct, group, amac)" << endl;
+		cout << "pack. Toggle CPU filters on the bit packed columns" << endl;
+		cout << "slice. Toggle CPU filters on the bit sliced columns" << endl;
+		cout << "aggr. Toggle answering covered segments from the segment aggregates" << endl;
+		cout << "jit. Toggle runtime compilation of the CPU pipelines" << endl;
+		cout << "plan. Toggle plan cache (off runs both plans and keeps the faster one)" << endl;
 		cout << "Your Input: ";
 		cin >> input;
 
@@ -133,6 +236,19 @@ int main() {
 				time += time1; cpu_to_gpu += cpu_to_gpu1; gpu_to_cpu += gpu_to_cpu1; malloc_time_total += malloc_time_total1;
 				execution_time += execution_time1; optimization_time += optimization_time1; merging_time += merging_time1;
 
+			} else if (plan) {
+				time1 = qp->processQueryPlanned(sessionCtx);
+				malloc_time_total1 = cgp->malloc_time_total;
+				cpu_to_gpu1 = cgp->cpu_to_gpu_total;
+				gpu_to_cpu1 = cgp->gpu_to_cpu_total;
+				execution_time1 = cgp->execution_total;
+				optimization_time1 = cgp->optimization_total;
+				merging_time1 = cgp->merging_total;
+				cgp->resetTime();
+
+				time += time1; cpu_to_gpu += cpu_to_gpu1; gpu_to_cpu += gpu_to_cpu1; malloc_time_total += malloc_time_total1;
+				execution_time += execution_time1; optimization_time += optimization_time1; merging_time += merging_time1;
+
 			} else {
 				time1 = qp->processQuery(sessionCtx);
 				malloc_time_total1 = cgp->malloc_time_total;
@@ -173,6 +289,21 @@ int main() {
 			for (int i = 0; i < many_query; i++) {
 				qp->generate_rand_query();
 
+				if (plan) {
+					time1 = qp->processQueryPlanned(sessionCtx);
+					malloc_time_total1 = cgp->malloc_time_total;
+					cpu_to_gpu1 = cgp->cpu_to_gpu_total;
+					gpu_to_cpu1 = cgp->gpu_to_cpu_total;
+					execution_time1 = cgp->execution_total;
+					optimization_time1 = cgp->optimization_total;
+					merging_time1 = cgp->merging_total;
+					cgp->resetTime();
+
+					time += time1; cpu_to_gpu += cpu_to_gpu1; gpu_to_cpu += gpu_to_cpu1; malloc_time_total += malloc_time_total1;
+					execution_time += execution_time1; optimization_time += optimization_time1; merging_time += merging_time1;
+					continue;
+				}
+
 				time1 = qp->processQuery(sessionCtx);
 				malloc_time_total1 = cgp->malloc_time_total;
 				cpu_to_gpu1 = cgp->cpu_to_gpu_total;
@@ -231,7 +362,9 @@ int main() {
 				repl_policy = Segmented;
 			}
 
-			cuCtxGetCurrent(&curCtx); cout << curCtx << endl; cout <<sessionCtx << endl;
+			if (!host_device) {
+				cuCtxGetCurrent(&curCtx); cout << curCtx << endl; cout <<sessionCtx << endl;
+			}
 
 			cgp->resetTime();
 			cgp->qo->processed_segment = 0;
@@ -294,6 +427,19 @@ int main() {
 
 						time += time1; cpu_to_gpu += cpu_to_gpu1; gpu_to_cpu += gpu_to_cpu1; malloc_time_total += malloc_time_total1;
 						execution_time += execution_time1; optimization_time += optimization_time1; merging_time += merging_time1;
+					} else if (plan) {
+						time1 = qp->processQueryPlanned(sessionCtx);
+						malloc_time_total1 = cgp->malloc_time_total;
+						cpu_to_gpu1 = cgp->cpu_to_gpu_total;
+						gpu_to_cpu1 = cgp->gpu_to_cpu_total;
+						execution_time1 = cgp->execution_total;
+						optimization_time1 = cgp->optimization_total;
+						merging_time1 = cgp->merging_total;
+						cgp->resetTime();
+
+						time += time1; cpu_to_gpu += cpu_to_gpu1; gpu_to_cpu += gpu_to_cpu1; malloc_time_total += malloc_time_total1;
+						execution_time += execution_time1; optimization_time += optimization_time1; merging_time += merging_time1;
+
 					} else {
 						time1 = qp->processQuery(sessionCtx);
 						malloc_time_total1 = cgp->malloc_time_total;
@@ -449,6 +595,42 @@ int main() {
 			qp->skipping = skipping;
 			if (skipping) cout << "Segment skipping is enabled" << endl;
 			else cout << "Segment skipping is disabled" << endl;
+		} else if (input.compare("joinskip") == 0) {
+			join_skipping = !join_skipping;
+			if (join_skipping) cout << "Segments are skipped on the dimension predicates" << endl;
+			else cout << "Segments are not skipped on the dimension predicates" << endl;
+		} else if (input.compare("probe") == 0) {
+			cout << "Probe Mode: ";
+			cin >> input;
+			ProbeModeCPU mode = probeModeCPU(input);
+			if (mode != ProbeModeCount) probe_mode_cpu = mode;
+			cout << "CPU probe mode is " << probe_mode_name_cpu[probe_mode_cpu] << endl;
+		} else if (input.compare("pack") == 0) {
+			packed_scan_cpu = !packed_scan_cpu;
+			bool packed = false;
+			for (int i = 0; i < cm->TOT_COLUMN; i++) packed |= (cm->allColumn[i]->pack != NULL);
+			if (packed_scan_cpu && !packed) cout << "No packed columns loaded (started with --nopack or none in the catalog)" << endl;
+			else if (packed_scan_cpu) cout << "CPU filters scan the packed columns" << endl;
+			else cout << "CPU filters scan the raw columns" << endl;
+		} else if (input.compare("slice") == 0) {
+			sliced_scan_cpu = !sliced_scan_cpu;
+			if (sliced_scan_cpu) cout << "CPU filters scan the sliced columns" << endl;
+			else cout << "CPU filters do not scan the sliced columns" << endl;
+		} else if (input.compare("aggr") == 0) {
+			segment_aggregates = !segment_aggregates;
+			if (segment_aggregates) cout << "Covered segments are answered from the segment aggregates" << endl;
+			else cout << "Covered segments are scanned" << endl;
+		} else if (input.compare("jit") == 0) {
+			jit_cpu = !jit_cpu;
+			if (jit_cpu) cout << "CPU pipelines are compiled at runtime" << endl;
+			else {
+				jitStatsCPU stats = jitStats();
+				cout << "CPU pipelines use the compiled templates, " << stats.compiles << " pipelines were compiled in " << stats.compile_ms << " ms" << endl;
+			}
+		} else if (input.compare("plan") == 0) {
+			plan = !plan;
+			if (plan) cout << "Plan cache is enabled" << endl;
+			else cout << "Plan cache is disabled, running both plans" << endl;
 		} else if (input.compare("custom") == 0) {
 			custom = !custom;
 			cgp->custom = custom;
@@ -457,15 +639,18 @@ int main() {
 			if (custom) cout << "Custom malloc is enabled" << endl;
 			else cout << "Custom malloc is disabled" << endl;		
 		} else if (input.compare("emat") == 0) {
-			emat = !emat;
+			if (deviceIsHost()) cout << "Early materialization needs a CUDA device" << endl;
+			else emat = !emat;
 			if (emat) cout << "Early Materialization" << endl;
 			else cout << "Late Materialization" << endl;		
 		} else if (input.compare("nopipe") == 0) {
-			nopipe = !nopipe;
+			if (deviceIsHost()) cout << "Non-pipelined execution needs a CUDA device" << endl;
+			else nopipe = !nopipe;
 			if (nopipe) cout << "Pipelining is disabled" << endl;
 			else cout << "Pipelining is enabled" << endl;		
 		} else if (input.compare("HE") == 0) {
-			HE = !HE;
+			if (deviceIsHost()) cout << "Segment-level execution needs a CUDA device" << endl;
+			else HE = !HE;
 			if (HE) cout << "Non Segment-grouping execution" << endl;
 			else cout << "Segment level query execution" << endl;		
 		} else {
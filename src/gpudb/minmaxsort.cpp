@@ -1,4 +1,5 @@
 #include "ssb_utils.h"
+#include "SegmentStats.h"
 #include <iostream>
 #include <string>
 #include <fstream>
@@ -16,6 +17,9 @@ int main(int argc, char** argv) {
   int len = atoi(argv[2]);
   string sf = argv[3];
 
+  //read the column from and write the stats into the directory of this scale factor
+  openCatalog(getenv("MORDRED_DATA_DIR") ? getenv("MORDRED_DATA_DIR") : catalogSFDir(atoi(argv[3])), atoi(argv[3]));
+
   cout << atoi(argv[2]) << endl;
 
   uint *raw = loadColumnSort<uint>(col_name, len);
@@ -23,7 +27,7 @@ int main(int argc, char** argv) {
   cout << "Loaded Column " << col_name << endl;
 
   ofstream myfile;
-  myfile.open ("/home/ubuntu/Implementation-GPUDB/test/ssb/data/s" + sf + "_columnar/" + col_name + "minmax");
+  myfile.open (DATA_DIR + col_name + "minmax");
 
   int total_segment = ((len + SEGMENT_SIZE - 1)/SEGMENT_SIZE);
 
@@ -46,5 +50,8 @@ int main(int argc, char** argv) {
 
   myfile.close();
 
+  //binary stats with histogram and value bitmap, preferred by CacheManager::readSegmentMinMax
+  writeSegmentStats(DATA_DIR + col_name + "stats", (int*) raw, len, SEGMENT_SIZE);
+
   return 0;
 }
\ No newline at end of file
@@ -0,0 +1,132 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <iostream>
+#include "Catalog.h"
+#include "NumaPlacement.h"
+#include "utils/cpu_utils.h"
+
+using namespace std;
+
+//every thread of a node sums its share of the segments homed on that node
+long long scanNode(int* col, int total_segment, int node, int num_threads, float& ms) {
+  int nodes = numaNodes();
+  vector<thread> threads;
+  vector<long long> sum(num_threads * 8, 0);
+
+  chrono::high_resolution_clock::time_point st = chrono::high_resolution_clock::now();
+
+  for (int t = 0; t < num_threads; t++) {
+    threads.push_back(thread([=, &sum]() {
+      numaPinThread(node, t);
+      long long local_sum = 0;
+      int k = 0;
+      for (int s = 0; s < total_segment; s++) {
+        if (numaSegmentNode(s, total_segment) != node % nodes) continue;
+        if (k++ % num_threads != t) continue;
+        int* seg = col + (size_t) s * SEGMENT_SIZE;
+        for (int i = 0; i < SEGMENT_SIZE; i++) local_sum += seg[i];
+      }
+      sum[t * 8] = local_sum;
+    }));
+  }
+  for (int t = 0; t < num_threads; t++) threads[t].join();
+
+  chrono::high_resolution_clock::time_point finish = chrono::high_resolution_clock::now();
+  ms = (chrono::duration_cast<chrono::microseconds>(finish - st)).count() / 1000.0;
+
+  long long total = 0;
+  for (int t = 0; t < num_threads; t++) total += sum[t * 8];
+  return total;
+}
+
+//placed: segments bound to their home node. unplaced: one thread reads the column in, so every page
+//lands on the node of that thread, which is what loading without numa placement does
+int* makeColumn(int total_segment, bool placed) {
+  size_t bytes = (size_t) total_segment * SEGMENT_SIZE * sizeof(int);
+  int* col = (int*) mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (col == MAP_FAILED) return NULL;
+  if (placed) numaPlaceSegments(col, (size_t) SEGMENT_SIZE * sizeof(int), total_segment);
+  else numaPinThread(0, 0);
+  for (size_t i = 0; i < (size_t) total_segment * SEGMENT_SIZE; i++) col[i] = i % 100;
+  return col;
+}
+
+int main(int argc, char** argv) {
+  int segments_per_node = 64;
+  int num_trials = 3;
+  int num_threads = 0;
+
+  CommandLineArgs args(argc, argv);
+  args.GetCmdLineArgument("n", segments_per_node);
+  args.GetCmdLineArgument("t", num_trials);
+  args.GetCmdLineArgument("threads", num_threads);
+
+  if (args.CheckCmdLineFlag("help")) {
+    printf("%s "
+      "[--n=<segments per node>] "
+      "[--t=<num trials>] "
+      "[--threads=<threads per node>] "
+      "[--partition] "
+      "\n", argv[0]);
+    exit(0);
+  }
+
+  numaPlacement().enable = true;
+  numaPlacement().partition = args.CheckCmdLineFlag("partition");
+  numaPlacement().pin_workers = false;
+  numaInit();
+
+  int nodes = numaNodes();
+  int total_segment = segments_per_node * nodes;
+  if (num_threads <= 0) num_threads = numaNodeCPUs(0);
+  double node_bytes = (double) segments_per_node * SEGMENT_SIZE * sizeof(int);
+
+  cout << "nodes " << nodes << " threads per node " << num_threads << " segments " << total_segment
+    << (numaActive() ? "" : " (single node or built without NUMA=1, placement has no effect)") << endl;
+
+  const char* mode_name[] = {"unplaced", "placed"};
+
+  for (int placed = 0; placed < 2; placed++) {
+    int* col = makeColumn(total_segment, placed);
+    if (col == NULL) {
+      cout << "allocation failed" << endl;
+      return 1;
+    }
+
+    //one node at a time for the per socket bandwidth, then all of them together
+    for (int node = 0; node <= nodes; node++) {
+      float best = 0;
+      long long sum = 0;
+      for (int trial = 0; trial < num_trials; trial++) {
+        float ms = 0;
+        if (node < nodes) {
+          sum = scanNode(col, total_segment, node, num_threads, ms);
+        } else {
+          vector<thread> runs;
+          vector<float> node_ms(nodes);
+          for (int n = 0; n < nodes; n++)
+            runs.push_back(thread([&, n]() { scanNode(col, total_segment, n, num_threads, node_ms[n]); }));
+          for (int n = 0; n < nodes; n++) runs[n].join();
+          for (int n = 0; n < nodes; n++) if (node_ms[n] > ms) ms = node_ms[n];
+        }
+        if (trial == 0 || ms < best) best = ms;
+      }
+
+      double bytes = (node < nodes) ? node_bytes : node_bytes * nodes;
+      if (node < nodes) cout << mode_name[placed] << " node " << node;
+      else cout << mode_name[placed] << " all nodes";
+      cout << " " << best << " ms " << bytes / best / 1000000 << " GB/s";
+      if (node < nodes) cout << " (sum " << sum << ")";
+      cout << endl;
+    }
+
+    munmap(col, (size_t) total_segment * SEGMENT_SIZE * sizeof(int));
+  }
+
+  return 0;
+}
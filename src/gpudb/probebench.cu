@@ -0,0 +1,134 @@
+#include <unistd.h>
+#include "CPUProcessing.h"
+#include "utils/cpu_utils.h"
+
+//dimension table of dim_len keys, a key has a slot (offset + 1 << 32 | value) with probability fill
+long long* buildTable(int dim_len, double fill, int seed) {
+  long long* ht = new long long[dim_len];
+  mt19937 gen(seed);
+  uniform_real_distribution<double> dist(0, 1);
+  for (int i = 0; i < dim_len; i++) {
+    if (dist(gen) < fill) ht[i] = ((long long) (i + 1) << 32) | (i % 1000);
+    else ht[i] = 0;
+  }
+  return ht;
+}
+
+float runProbe(ProbeModeCPU mode, struct probeArgsCPU pargs, struct offsetCPU out_off, int num_items, short* segment_group, int& total) {
+  total = 0;
+  probe_mode_cpu = mode;
+
+  chrono::high_resolution_clock::time_point st = chrono::high_resolution_clock::now();
+  probe_CPU(pargs, out_off, num_items, &total, 0, segment_group);
+  chrono::high_resolution_clock::time_point finish = chrono::high_resolution_clock::now();
+
+  return (chrono::duration_cast<chrono::microseconds>(finish - st)).count() / 1000.0;
+}
+
+int main(int argc, char** argv) {
+  int num_items = 1 << 24;
+  int num_tables = 2;
+  int num_trials = 3;
+  int fill = 50;
+
+  CommandLineArgs args(argc, argv);
+  args.GetCmdLineArgument("n", num_items);
+  args.GetCmdLineArgument("tables", num_tables);
+  args.GetCmdLineArgument("t", num_trials);
+  args.GetCmdLineArgument("fill", fill);
+
+  if (args.CheckCmdLineFlag("help")) {
+    printf("%s "
+      "[--n=<fact rows>] "
+      "[--tables=<hash tables probed per row, 1 to 4>] "
+      "[--t=<num trials>] "
+      "[--fill=<percent of dimension keys with a match>] "
+      "\n", argv[0]);
+    exit(0);
+  }
+
+  num_items = ((num_items + SEGMENT_SIZE - 1) / SEGMENT_SIZE) * SEGMENT_SIZE;
+  num_tables = max(1, min(4, num_tables));
+
+  long l2 = sysconf(_SC_LEVEL2_CACHE_SIZE);
+  long llc = sysconf(_SC_LEVEL3_CACHE_SIZE);
+  if (l2 <= 0) l2 = 1 << 20;
+  if (llc <= 0) llc = 32 << 20;
+
+  int total_segment = num_items / SEGMENT_SIZE;
+  short* segment_group = new short[total_segment];
+  for (int i = 0; i < total_segment; i++) segment_group[i] = i;
+
+  int* key_col[4];
+  int* dim_off[4];
+  int* lo_off = new int[num_items];
+  for (int k = 0; k < 4; k++) {
+    key_col[k] = new int[num_items];
+    dim_off[k] = new int[num_items];
+  }
+  struct offsetCPU out_off = {lo_off, dim_off[0], dim_off[1], dim_off[2], dim_off[3]};
+
+  cout << "rows " << num_items << " tables " << num_tables << " fill " << fill << "% L2 " << (l2 >> 10) << " KB LLC " << (llc >> 10) << " KB" << endl;
+
+  //every table of the sweep is l2 / 2, l2, ... up to 10x the llc
+  for (long bytes = l2 / 2; bytes <= llc * 10; bytes *= 2) {
+    int dim_len = bytes / sizeof(long long);
+    long long* ht[4] = {NULL, NULL, NULL, NULL};
+    int* ht_col[4] = {NULL, NULL, NULL, NULL};
+
+    for (int k = 0; k < num_tables; k++) {
+      ht[k] = buildTable(dim_len, fill / 100.0, 123 + k);
+      ht_col[k] = key_col[k];
+      mt19937 gen(7 + k);
+      uniform_int_distribution<int> dist(0, dim_len - 1);
+      for (int i = 0; i < num_items; i++) key_col[k][i] = dist(gen);
+    }
+
+    struct probeArgsCPU pargs = {
+      ht_col[0], ht_col[1], ht_col[2], ht_col[3],
+      (int*) ht[0], (int*) ht[1], (int*) ht[2], (int*) ht[3],
+      dim_len, dim_len, dim_len, dim_len,
+      0, 0, 0, 0
+    };
+
+    int expected = 0;
+    long long expected_sum = 0;
+
+    for (int mode = ProbeDirect; mode < ProbeModeCount; mode++) {
+      float best = 0;
+      int total = 0;
+      for (int trial = 0; trial < num_trials; trial++) {
+        float time = runProbe((ProbeModeCPU) mode, pargs, out_off, num_items, segment_group, total);
+        if (trial == 0 || time < best) best = time;
+      }
+
+      //output order depends on the task schedule, so compare an order independent checksum
+      long long sum = 0;
+      for (int i = 0; i < total; i++) {
+        sum += lo_off[i];
+        for (int k = 0; k < num_tables; k++) sum += dim_off[k][i];
+      }
+      if (mode == ProbeDirect) {
+        expected = total;
+        expected_sum = sum;
+      }
+      bool correct = (total == expected && sum == expected_sum);
+
+      cout << "ht " << (bytes >> 10) << " KB " << probe_mode_name_cpu[mode] << " " << best << " ms "
+        << (double) num_items / best / 1000 << " Mrows/s" << (correct ? "" : " WRONG RESULT") << endl;
+    }
+
+    for (int k = 0; k < num_tables; k++) delete[] ht[k];
+  }
+
+  probe_mode_cpu = ProbeDirect;
+
+  for (int k = 0; k < 4; k++) {
+    delete[] key_col[k];
+    delete[] dim_off[k];
+  }
+  delete[] lo_off;
+  delete[] segment_group;
+
+  return 0;
+}
@@ -10,51 +10,17 @@
 #include <curand.h>
 #include <cub/util_allocator.cuh>
 
+#include "Catalog.h"
+
 using namespace std;
 
-#define SF 20
-
-#define BASE_PATH "/home/ubuntu/Implementation-GPUDB/test/ssb/data/"
-
-#if SF == 1
-#define DATA_DIR BASE_PATH "s1_columnar/"
-#define LO_LEN 6001171
-//#define LO_LEN 1000
-#define P_LEN 200000
-#define S_LEN 2000
-#define C_LEN 30000
-#define D_LEN 2556
-#elif SF == 10
-#define DATA_DIR BASE_PATH "s10_columnar/"
-#define LO_LEN 59986214
-#define P_LEN 800000
-#define S_LEN 20000
-#define C_LEN 300000
-#define D_LEN 2556
-#elif SF == 20
-#define DATA_DIR BASE_PATH "s20_columnar/"
-#define LO_LEN 119994746
-#define P_LEN 1000000
-#define S_LEN 40000
-#define C_LEN 600000
-#define D_LEN 2556
-#elif SF == 40
-#define DATA_DIR BASE_PATH "s40_columnar/"
-#define LO_LEN 240012412
-#define P_LEN 1200000
-#define S_LEN 80000
-#define C_LEN 1200000
-#define D_LEN 2556
-#elif SF == 160
-#define DATA_DIR BASE_PATH "s160_columnar/"
-#define LO_LEN 960017453
-#define P_LEN 1600000
-#define S_LEN 320000
-#define C_LEN 4800000
-#define D_LEN 2556
-#endif
-
-#define SEGMENT_SIZE 1048576
+//data directory and table lengths come from the catalog of the data directory at startup
+#define DATA_DIR (catalog().data_dir)
+#define LO_LEN (catalog().lo_len)
+#define P_LEN (catalog().p_len)
+#define S_LEN (catalog().s_len)
+#define C_LEN (catalog().c_len)
+#define D_LEN (catalog().d_len)
 
 inline int index_of(string* arr, int len, string val) {
   for (int i=0; i<len; i++)
@@ -65,6 +31,9 @@ inline int index_of(string* arr, int len, string val) {
 }
 
 inline string lookup(string col_name) {
+  string file = catalogFile(col_name, false);
+  if (!file.empty()) return file;
+
   string lineorder[] = { "lo_orderkey", "lo_linenumber", "lo_custkey", "lo_partkey", "lo_suppkey", "lo_orderdate", "lo_orderpriority", "lo_shippriority", "lo_quantity", "lo_extendedprice", "lo_ordtotalprice", "lo_discount", "lo_revenue", "lo_supplycost", "lo_tax", "lo_commitdate", "lo_shipmode"};
   string part[] = {"p_partkey", "p_name", "p_mfgr", "p_category", "p_brand1", "p_color", "p_type", "p_size", "p_container"};
   string supplier[] = {"s_suppkey", "s_name", "s_address", "s_city", "s_nation", "s_region", "s_phone"};
@@ -92,6 +61,9 @@ inline string lookup(string col_name) {
 }
 
 inline string lookupSort(string col_name) {
+  string file = catalogFile(col_name, true);
+  if (!file.empty()) return file;
+
   string lineorder[] = { "lo_orderkey", "lo_linenumber", "lo_custkey", "lo_partkey", "lo_suppkey", "lo_orderdate", "lo_orderpriority", "lo_shippriority", "lo_quantity", "lo_extendedprice", "lo_ordtotalprice", "lo_discount", "lo_revenue", "lo_supplycost", "lo_tax", "lo_commitdate", "lo_shipmode"};
   string part[] = {"p_partkey", "p_name", "p_mfgr", "p_category", "p_brand1", "p_color", "p_type", "p_size", "p_container"};
   string supplier[] = {"s_suppkey", "s_name", "s_address", "s_city", "s_nation", "s_region", "s_phone"};
@@ -0,0 +1,684 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <future>
+#include <algorithm>
+#include <chrono>
+#include "../../../src/gpudb/SegmentStats.h"
+#include "../../../src/gpudb/SegmentPack.h"
+#include "../../../src/gpudb/SegmentSlice.h"
+#include "../../../src/gpudb/SegmentAggr.h"
+#include "../../../src/gpudb/Catalog.h"
+
+/*
+ * @file parallel_load.cpp
+ * Multi-threaded replacement for convert.py + loader. Reads the raw dbgen .tbl files
+ * (or dbgen output through a fifo / stdin), applies the convert.py encodings, writes
+ * every column file, the LINEORDERSORT columns, the segment statistics, the bit packed
+ * and bit sliced lineorder columns, the lineorder segment aggregates and the catalog
+ * the engine reads the table lengths and file names from.
+ *
+ * Regular files are mapped and split at line boundaries. Anything else is read as a
+ * stream, the next window is read while the current one is parsed.
+ */
+
+#define CHUNK_SIZE (16 * 1024 * 1024)
+#define MAX_FIELD 17
+#define SORT_INDEX 5 //lo_orderdate
+
+#define CHECK_POINTER(p) do {\
+  if(p == NULL){   \
+    perror("Failed to allocate host memory");    \
+    exit(-1);  \
+  }} while(0)
+
+enum FieldKind {
+  FieldInt,
+  FieldChar, //fixed width, zero padded
+  FieldNation, //convert.py dictionaries, numeric input is taken as already converted
+  FieldRegion,
+  FieldCity, //nation * 10 + last digit of the city
+  FieldMfgr, //MFGR#m -> m - 1
+  FieldCategory, //MFGR#mc -> mfgr * 5 + c - 1
+  FieldBrand //MFGR#mcbb -> category * 40 + bb - 1
+};
+
+struct fieldDesc {
+  const char* name;
+  FieldKind kind;
+  int width;
+  int ref; //field the encoding is derived from, -1 if none
+};
+
+struct tableDesc {
+  const char* option;
+  const char* prefix;
+  int num_field;
+  fieldDesc field[MAX_FIELD];
+};
+
+static tableDesc tables[] = {
+  {"supplier", "SUPPLIER", 7, {
+    {"s_suppkey", FieldInt, 4, -1}, {"s_name", FieldChar, 25, -1}, {"s_address", FieldChar, 25, -1},
+    {"s_city", FieldCity, 4, 4}, {"s_nation", FieldNation, 4, -1}, {"s_region", FieldRegion, 4, -1},
+    {"s_phone", FieldChar, 15, -1}}},
+  {"customer", "CUSTOMER", 8, {
+    {"c_custkey", FieldInt, 4, -1}, {"c_name", FieldChar, 25, -1}, {"c_address", FieldChar, 25, -1},
+    {"c_city", FieldCity, 4, 4}, {"c_nation", FieldNation, 4, -1}, {"c_region", FieldRegion, 4, -1},
+    {"c_phone", FieldChar, 15, -1}, {"c_mktsegment", FieldChar, 10, -1}}},
+  {"part", "PART", 9, {
+    {"p_partkey", FieldInt, 4, -1}, {"p_name", FieldChar, 22, -1}, {"p_mfgr", FieldMfgr, 4, -1},
+    {"p_category", FieldCategory, 4, 2}, {"p_brand1", FieldBrand, 4, 3}, {"p_color", FieldChar, 11, -1},
+    {"p_type", FieldChar, 25, -1}, {"p_size", FieldInt, 4, -1}, {"p_container", FieldChar, 10, -1}}},
+  {"ddate", "DDATE", 17, {
+    {"d_datekey", FieldInt, 4, -1}, {"d_date", FieldChar, 18, -1}, {"d_dayofweek", FieldChar, 8, -1},
+    {"d_month", FieldChar, 9, -1}, {"d_year", FieldInt, 4, -1}, {"d_yearmonthnum", FieldInt, 4, -1},
+    {"d_yearmonth", FieldChar, 7, -1}, {"d_daynuminweek", FieldInt, 4, -1}, {"d_daynuminmonth", FieldInt, 4, -1},
+    {"d_daynuminyear", FieldInt, 4, -1}, {"d_monthnuminyear", FieldInt, 4, -1}, {"d_weeknuminyear", FieldInt, 4, -1},
+    {"d_sellingseason", FieldChar, 12, -1}, {"d_lastdayinweekfl", FieldChar, 1, -1}, {"d_lastdayinmonthfl", FieldChar, 1, -1},
+    {"d_holidayfl", FieldChar, 1, -1}, {"d_weekdayfl", FieldChar, 1, -1}}},
+  {"lineorder", "LINEORDER", 17, {
+    {"lo_orderkey", FieldInt, 4, -1}, {"lo_linenumber", FieldInt, 4, -1}, {"lo_custkey", FieldInt, 4, -1},
+    {"lo_partkey", FieldInt, 4, -1}, {"lo_suppkey", FieldInt, 4, -1}, {"lo_orderdate", FieldInt, 4, -1},
+    {"lo_orderpriority", FieldChar, 16, -1}, {"lo_shippriority", FieldChar, 1, -1}, {"lo_quantity", FieldInt, 4, -1},
+    {"lo_extendedprice", FieldInt, 4, -1}, {"lo_ordtotalprice", FieldInt, 4, -1}, {"lo_discount", FieldInt, 4, -1},
+    {"lo_revenue", FieldInt, 4, -1}, {"lo_supplycost", FieldInt, 4, -1}, {"lo_tax", FieldInt, 4, -1},
+    {"lo_commitdate", FieldInt, 4, -1}, {"lo_shipmode", FieldChar, 10, -1}}}
+};
+
+#define NUM_TABLE (sizeof(tables) / sizeof(tableDesc))
+
+static const char* nations[] = {"ALGERIA", "ARGENTINA", "BRAZIL", "CANADA", "EGYPT", "ETHIOPIA", "FRANCE", "GERMANY",
+  "INDIA", "INDONESIA", "IRAN", "IRAQ", "JAPAN", "JORDAN", "KENYA", "MOROCCO", "MOZAMBIQUE", "PERU", "CHINA",
+  "ROMANIA", "SAUDI ARABIA", "VIETNAM", "RUSSIA", "UNITED KINGDOM", "UNITED STATES"};
+static const char* regions[] = {"AFRICA", "AMERICA", "ASIA", "EUROPE", "MIDDLE EAST"};
+
+static char delimiter = '|';
+static int num_threads = 0;
+static int seg_size = SEGMENT_SIZE;
+static bool sort_lineorder = true;
+static bool pack_lineorder = true;
+static bool slice_lineorder = true;
+static bool aggr_lineorder = true;
+static ssbCatalog cat;
+
+struct token {
+  const char* begin;
+  int len;
+};
+
+//a run of whole lines, either inside the mapping or owned when streaming
+struct chunk {
+  const char* begin;
+  const char* end;
+  std::vector<char> own;
+  long rows;
+  std::vector<char> col[MAX_FIELD];
+};
+
+template <typename F>
+static void parallelFor(int n, F f) {
+  std::atomic<int> next(0);
+  std::vector<std::thread> workers;
+  for (int t = 0; t < num_threads; t++) {
+    workers.push_back(std::thread([&]() {
+      for (int i = next++; i < n; i = next++) f(i);
+    }));
+  }
+  for (int t = 0; t < num_threads; t++) workers[t].join();
+}
+
+static inline bool isNumber(const token& tok) {
+  if (tok.len == 0) return false;
+  for (int i = (tok.begin[0] == '-'); i < tok.len; i++)
+    if (tok.begin[i] < '0' || tok.begin[i] > '9') return false;
+  return true;
+}
+
+static inline int parseInt(const char* p, int len) {
+  int val = 0, i = 0;
+  bool neg = (len > 0 && p[0] == '-');
+  for (i = neg; i < len; i++) val = val * 10 + (p[i] - '0');
+  return neg ? -val : val;
+}
+
+static inline int lookupDict(const token& tok, const char** dict, int num) {
+  for (int i = 0; i < num; i++)
+    if (strlen(dict[i]) == tok.len && strncmp(dict[i], tok.begin, tok.len) == 0) return i;
+  fprintf(stderr, "Unknown value %.*s\n", tok.len, tok.begin);
+  exit(-1);
+}
+
+//digits after the '#' of the dbgen MFGR#... strings
+static inline int mfgrDigits(const token& tok, int skip) {
+  const char* hash = (const char*) memchr(tok.begin, '#', tok.len);
+  if (hash == NULL) {
+    fprintf(stderr, "Unexpected value %.*s\n", tok.len, tok.begin);
+    exit(-1);
+  }
+  hash += 1 + skip;
+  return parseInt(hash, tok.begin + tok.len - hash);
+}
+
+static int fieldValue(const tableDesc& table, int f, const token* tok) {
+  const fieldDesc& field = table.field[f];
+  if (field.kind != FieldInt && isNumber(tok[f])) return parseInt(tok[f].begin, tok[f].len);
+
+  switch (field.kind) {
+    case FieldInt:
+      return parseInt(tok[f].begin, tok[f].len);
+    case FieldNation:
+      return lookupDict(tok[f], nations, 25);
+    case FieldRegion:
+      return lookupDict(tok[f], regions, 5);
+    case FieldCity:
+      return fieldValue(table, field.ref, tok) * 10 + (tok[f].begin[tok[f].len - 1] - '0');
+    case FieldMfgr:
+      return mfgrDigits(tok[f], 0) - 1;
+    case FieldCategory:
+      return fieldValue(table, field.ref, tok) * 5 + (mfgrDigits(tok[f], 0) % 10) - 1;
+    case FieldBrand:
+      return fieldValue(table, field.ref, tok) * 40 + mfgrDigits(tok[f], 2) - 1;
+    default:
+      return 0;
+  }
+}
+
+static void parseChunk(const tableDesc& table, chunk* c) {
+  c->rows = 0;
+  for (const char* p = c->begin; p < c->end; p++) c->rows += (*p == '\n');
+  if (c->end > c->begin && c->end[-1] != '\n') c->rows++;
+
+  for (int f = 0; f < table.num_field; f++) c->col[f].assign(c->rows * table.field[f].width, 0);
+
+  token tok[MAX_FIELD];
+  const char* p = c->begin;
+  for (long row = 0; row < c->rows; row++) {
+    const char* eol = (const char*) memchr(p, '\n', c->end - p);
+    if (eol == NULL) eol = c->end;
+
+    int count = 0;
+    const char* start = p;
+    for (; p < eol && count < table.num_field; p++) {
+      if (*p == delimiter) {
+        tok[count].begin = start;
+        tok[count].len = p - start;
+        count++;
+        start = p + 1;
+      }
+    }
+    //the trailing delimiter is optional
+    if (count < table.num_field && start < eol) {
+      tok[count].begin = start;
+      tok[count].len = eol - start;
+      count++;
+    }
+    if (count != table.num_field) {
+      fprintf(stderr, "Malformed %s row: %.*s\n", table.option, (int) (eol - c->begin < 256 ? eol - c->begin : 256), c->begin);
+      exit(-1);
+    }
+
+    for (int f = 0; f < table.num_field; f++) {
+      char* out = c->col[f].data() + row * table.field[f].width;
+      if (table.field[f].kind == FieldChar) {
+        memcpy(out, tok[f].begin, std::min(tok[f].len, table.field[f].width));
+      } else {
+        int val = fieldValue(table, f, tok);
+        memcpy(out, &val, sizeof(int));
+      }
+    }
+    p = eol + 1;
+  }
+}
+
+//splits its input into chunks ending at a line boundary
+class tblReader {
+public:
+  int fd;
+  bool mapped;
+  const char* data;
+  size_t size;
+  size_t pos;
+  std::vector<char> carry; //partial last line of the previous stream read
+
+  tblReader(const char* path) : fd(-1), mapped(false), data(NULL), size(0), pos(0) {
+    fd = (strcmp(path, "-") == 0) ? 0 : open(path, O_RDONLY);
+    if (fd == -1) {
+      printf("Failed to open %s\n", path);
+      exit(-1);
+    }
+    struct stat st;
+    fstat(fd, &st);
+    if (S_ISREG(st.st_mode) && st.st_size > 0) {
+      size = st.st_size;
+      data = (const char*) mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (data == MAP_FAILED) {
+        perror("mmap");
+        exit(-1);
+      }
+      madvise((void*) data, size, MADV_SEQUENTIAL);
+      mapped = true;
+    }
+  }
+
+  ~tblReader() {
+    if (mapped) munmap((void*) data, size);
+    if (fd > 0) close(fd);
+  }
+
+  //false once the input is exhausted
+  bool next(chunk* c) {
+    if (mapped) {
+      if (pos >= size) return false;
+      size_t end = std::min(pos + CHUNK_SIZE, size);
+      const char* eol = (end < size) ? (const char*) memchr(data + end, '\n', size - end) : NULL;
+      end = (eol == NULL) ? size : (eol - data) + 1;
+      c->begin = data + pos;
+      c->end = data + end;
+      pos = end;
+      return true;
+    }
+
+    c->own.swap(carry);
+    carry.clear();
+    size_t len = c->own.size();
+    c->own.resize(len + CHUNK_SIZE);
+    bool eof = false;
+    while (len < c->own.size()) {
+      ssize_t n = read(fd, c->own.data() + len, c->own.size() - len);
+      if (n < 0) {
+        perror("read");
+        exit(-1);
+      }
+      if (n == 0) {
+        eof = true;
+        break;
+      }
+      len += n;
+    }
+    c->own.resize(len);
+    if (len == 0) return false;
+
+    //hand the unfinished line to the next chunk, at the end of the stream it is the last row
+    if (!eof) {
+      size_t last = len;
+      while (last > 0 && c->own[last - 1] != '\n') last--;
+      carry.assign(c->own.begin() + last, c->own.end());
+      c->own.resize(last);
+    }
+    c->begin = c->own.data();
+    c->end = c->own.data() + c->own.size();
+    return true;
+  }
+};
+
+static int openColumn(std::string path) {
+  int fd = open(path.c_str(), O_CREAT | O_TRUNC | O_RDWR, 0644);
+  if (fd == -1) {
+    printf("Failed to open %s\n", path.c_str());
+    exit(-1);
+  }
+  return fd;
+}
+
+static void writeFully(int fd, const char* buf, size_t size, off_t offset) {
+  while (size > 0) {
+    ssize_t n = pwrite(fd, buf, size, offset);
+    if (n <= 0) {
+      perror("pwrite");
+      exit(-1);
+    }
+    buf += n;
+    size -= n;
+    offset += n;
+  }
+}
+
+//maps an int column file that was just written
+static int* mapColumn(std::string path, long rows, int* fd) {
+  *fd = open(path.c_str(), O_RDONLY);
+  if (*fd == -1) {
+    printf("Failed to open %s\n", path.c_str());
+    exit(-1);
+  }
+  if (rows == 0) return NULL;
+  int* col = (int*) mmap(NULL, rows * sizeof(int), PROT_READ, MAP_SHARED, *fd, 0);
+  if (col == MAP_FAILED) {
+    perror("mmap");
+    exit(-1);
+  }
+  return col;
+}
+
+//a packed copy is only kept when it is at most half the column
+static bool writePack(std::string name, const int* col, long rows) {
+  size_t packed_bytes = 0, raw_bytes = 0;
+  bool ok = writePackedColumn(name + "pack", col, rows, seg_size, &packed_bytes, &raw_bytes);
+  if (ok && raw_bytes > 0 && packed_bytes * 2 <= (size_t) rows * sizeof(int)) {
+    printf("%s: packed to %.1f%%\n", name.c_str(), packed_bytes * 100.0 / (rows * sizeof(int)));
+    return true;
+  }
+  unlink((name + "pack").c_str());
+  return false;
+}
+
+//a sliced copy is only kept for a low cardinality column, one every segment of fits SLICE_MAX_BITS
+static bool writeSlice(std::string name, const int* col, long rows) {
+  size_t slice_bytes = 0, raw_bytes = 0;
+  bool ok = writeSlicedColumn(name + "slice", col, rows, seg_size, &slice_bytes, &raw_bytes);
+  if (ok && rows > 0 && raw_bytes == (size_t) rows * sizeof(int)) {
+    printf("%s: sliced to %.1f%%\n", name.c_str(), slice_bytes * 100.0 / (rows * sizeof(int)));
+    return true;
+  }
+  unlink((name + "slice").c_str());
+  return false;
+}
+
+static void writeStats(const tableDesc& table, std::string datadir, std::string prefix, long rows) {
+  std::vector<int> cols;
+  for (int f = 0; f < table.num_field; f++)
+    if (table.field[f].kind != FieldChar) cols.push_back(f);
+  bool pack = pack_lineorder && strcmp(table.option, "lineorder") == 0;
+  bool slice = slice_lineorder && strcmp(table.option, "lineorder") == 0;
+
+  parallelFor(cols.size(), [&](int i) {
+    const fieldDesc& field = table.field[cols[i]];
+    int fd;
+    int* col = mapColumn(datadir + prefix + std::to_string(cols[i]), rows, &fd);
+    std::string name = datadir + field.name;
+    writeSegmentStats(name + "stats", col, rows, seg_size);
+    if (pack) writePack(name, col, rows);
+    else unlink((name + "pack").c_str());
+    if (slice) writeSlice(name, col, rows);
+    else unlink((name + "slice").c_str());
+
+    //text min max kept for binaries without stats support
+    FILE* out = fopen((name + "minmax").c_str(), "w");
+    CHECK_POINTER(out);
+    int total_segment = (rows + seg_size - 1) / seg_size;
+    for (int s = 0; s < total_segment; s++) {
+      long num = (s == total_segment - 1) ? rows - (long) s * seg_size : seg_size;
+      int min = col[(long) s * seg_size], max = min;
+      for (long j = 0; j < num; j++) {
+        int v = col[(long) s * seg_size + j];
+        if (v < min) min = v;
+        if (v > max) max = v;
+      }
+      fprintf(out, "%d %d\n", min, max);
+    }
+    fclose(out);
+
+    if (col != NULL) munmap(col, rows * sizeof(int));
+    close(fd);
+  });
+}
+
+static int fieldIndex(const tableDesc& table, const char* name) {
+  for (int f = 0; f < table.num_field; f++)
+    if (strcmp(table.field[f].name, name) == 0) return f;
+  return -1;
+}
+
+//sum(lo_extendedprice * lo_discount) per segment by lo_discount and lo_quantity, what the q1 flight sums
+static bool writeAggregates(const tableDesc& table, std::string datadir, std::string prefix, long rows) {
+  const char* measure_name[2] = {"lo_extendedprice", "lo_discount"};
+  const char* key_name[2] = {"lo_discount", "lo_quantity"};
+  const char* names[4] = {measure_name[0], measure_name[1], key_name[0], key_name[1]};
+  int fd[4];
+  const int* col[4];
+  for (int i = 0; i < 4; i++) col[i] = mapColumn(datadir + prefix + std::to_string(fieldIndex(table, names[i])), rows, &fd[i]);
+
+  size_t bytes = 0;
+  std::string file = std::string(table.option) + "aggr";
+  const int* measure_col[2] = {col[0], col[1]};
+  const int* key_col[2] = {col[2], col[3]};
+  bool ok = writeSegmentAggregates(datadir + file, AggrMeasureMul, measure_name, measure_col, key_name, key_col, rows, seg_size, &bytes);
+  if (ok) printf("%s: %.1f KB of segment aggregates\n", file.c_str(), bytes / 1024.0);
+  else unlink((datadir + file).c_str());
+
+  for (int i = 0; i < 4; i++) {
+    if (col[i] != NULL) munmap((void*) col[i], rows * sizeof(int));
+    close(fd[i]);
+  }
+  return ok;
+}
+
+//stable counting sort on lo_orderdate, the int columns are gathered into LINEORDERSORT
+static void sortLineorder(const tableDesc& table, std::string datadir, long rows) {
+  int key_fd;
+  int* key = mapColumn(datadir + table.prefix + std::to_string(SORT_INDEX), rows, &key_fd);
+
+  int parts = num_threads * 4;
+  long part_size = (rows + parts - 1) / parts;
+  std::vector<int> part_min(parts, INT32_MAX), part_max(parts, INT32_MIN);
+  parallelFor(parts, [&](int t) {
+    for (long i = t * part_size; i < std::min(rows, (t + 1) * part_size); i++) {
+      part_min[t] = std::min(part_min[t], key[i]);
+      part_max[t] = std::max(part_max[t], key[i]);
+    }
+  });
+  int min = *std::min_element(part_min.begin(), part_min.end());
+  int max = *std::max_element(part_max.begin(), part_max.end());
+
+  std::vector<unsigned int> perm(rows);
+  long range = (long) max - min + 1;
+  if (rows > 0 && range <= (1 << 24)) {
+    std::vector<std::vector<long>> hist(parts, std::vector<long>(range, 0));
+    parallelFor(parts, [&](int t) {
+      for (long i = t * part_size; i < std::min(rows, (t + 1) * part_size); i++) hist[t][key[i] - min]++;
+    });
+    long offset = 0;
+    for (long v = 0; v < range; v++) {
+      for (int t = 0; t < parts; t++) {
+        long count = hist[t][v];
+        hist[t][v] = offset;
+        offset += count;
+      }
+    }
+    parallelFor(parts, [&](int t) {
+      for (long i = t * part_size; i < std::min(rows, (t + 1) * part_size); i++) perm[hist[t][key[i] - min]++] = i;
+    });
+  } else {
+    for (long i = 0; i < rows; i++) perm[i] = i;
+    std::stable_sort(perm.begin(), perm.end(), [&](unsigned int a, unsigned int b) { return key[a] < key[b]; });
+  }
+  if (key != NULL) munmap(key, rows * sizeof(int));
+  close(key_fd);
+
+  std::vector<int> sorted(rows);
+  for (int f = 0; f < table.num_field; f++) {
+    if (table.field[f].kind == FieldChar) continue;
+    int fd;
+    int* col = mapColumn(datadir + table.prefix + std::to_string(f), rows, &fd);
+    parallelFor(parts, [&](int t) {
+      for (long i = t * part_size; i < std::min(rows, (t + 1) * part_size); i++) sorted[i] = col[perm[i]];
+    });
+    int out = openColumn(datadir + table.prefix + "SORT" + std::to_string(f));
+    writeFully(out, (char*) sorted.data(), rows * sizeof(int), 0);
+    close(out);
+    if (col != NULL) munmap(col, rows * sizeof(int));
+    close(fd);
+  }
+}
+
+static void loadTable(const tableDesc& table, const char* path, std::string datadir) {
+  std::chrono::high_resolution_clock::time_point st = std::chrono::high_resolution_clock::now();
+
+  int out[MAX_FIELD];
+  for (int f = 0; f < table.num_field; f++) out[f] = openColumn(datadir + table.prefix + std::to_string(f));
+
+  tblReader reader(path);
+  int window = num_threads * 2;
+  std::vector<chunk> current(window), upcoming(window);
+
+  auto fill = [&](std::vector<chunk>& w) {
+    int n = 0;
+    while (n < window && reader.next(&w[n])) n++;
+    return n;
+  };
+
+  //a stream is read one window ahead of the parser, the mapping needs no prefetch
+  int n = fill(current);
+  long rows = 0;
+  while (n > 0) {
+    std::future<int> next;
+    if (!reader.mapped) next = std::async(std::launch::async, fill, std::ref(upcoming));
+
+    parallelFor(n, [&](int i) { parseChunk(table, &current[i]); });
+
+    std::vector<long> start(n);
+    for (int i = 0; i < n; i++) {
+      start[i] = rows;
+      rows += current[i].rows;
+    }
+    parallelFor(n * table.num_field, [&](int k) {
+      int i = k / table.num_field, f = k % table.num_field;
+      int width = table.field[f].width;
+      writeFully(out[f], current[i].col[f].data(), current[i].rows * width, start[i] * width);
+      std::vector<char>().swap(current[i].col[f]);
+    });
+
+    if (reader.mapped) n = fill(current);
+    else {
+      n = next.get();
+      current.swap(upcoming);
+    }
+  }
+
+  for (int f = 0; f < table.num_field; f++) close(out[f]);
+
+  std::string prefix = table.prefix;
+  if (sort_lineorder && strcmp(table.option, "lineorder") == 0) {
+    sortLineorder(table, datadir, rows);
+    prefix += "SORT";
+  }
+  writeStats(table, datadir, prefix, rows);
+
+  std::string aggr_file = std::string(table.option) + "aggr";
+  if (aggr_lineorder && strcmp(table.option, "lineorder") == 0 && writeAggregates(table, datadir, prefix, rows))
+    cat.aggregate[aggr_file] = table.option;
+  else {
+    unlink((datadir + aggr_file).c_str());
+    cat.aggregate.erase(aggr_file);
+  }
+
+  //rewritten after every table so loading one table at a time keeps the others
+  cat.table_len[table.option] = rows;
+  for (int f = 0; f < table.num_field; f++) {
+    catalogColumn& col = cat.column[table.field[f].name];
+    bool is_int = (table.field[f].kind != FieldChar);
+    col.table = table.option;
+    col.file = table.prefix + std::to_string(f);
+    col.sorted_file = (is_int && prefix != table.prefix) ? prefix + std::to_string(f) : "";
+    col.stats_file = is_int ? std::string(table.field[f].name) + "stats" : "";
+    std::string pack_file = std::string(table.field[f].name) + "pack";
+    col.pack_file = (is_int && access((datadir + pack_file).c_str(), R_OK) == 0) ? pack_file : "";
+    std::string slice_file = std::string(table.field[f].name) + "slice";
+    col.slice_file = (is_int && access((datadir + slice_file).c_str(), R_OK) == 0) ? slice_file : "";
+  }
+  if (!writeCatalog(cat)) {
+    printf("Failed to write %s%s\n", datadir.c_str(), CATALOG_FILE);
+    exit(-1);
+  }
+
+  std::chrono::high_resolution_clock::time_point finish = std::chrono::high_resolution_clock::now();
+  printf("%s: %ld rows in %.3f s\n", table.option, rows, std::chrono::duration<double>(finish - st).count());
+}
+
+static void usage(const char* prog) {
+  printf("%s [--supplier <tbl>] [--customer <tbl>] [--part <tbl>] [--ddate <tbl>] [--lineorder <tbl>] "
+    "[--datadir <dir>] [--sf <scale factor>] [--delimiter <c>] [--threads <n>] [--segment <rows>] [--nosort] [--nopack] [--noslice] [--noaggr]\n"
+    "A table file may be a fifo or - for stdin, e.g. dbgen writing into a fifo.\n", prog);
+}
+
+int main(int argc, char** argv) {
+  std::string datadir = "./";
+  int sf = 0;
+  std::vector<std::pair<int, const char*>> inputs;
+
+  struct option long_options[] = {
+    {"supplier", required_argument, 0, '0'},
+    {"customer", required_argument, 0, '1'},
+    {"part", required_argument, 0, '2'},
+    {"ddate", required_argument, 0, '3'},
+    {"lineorder", required_argument, 0, '4'},
+    {"delimiter", required_argument, 0, '5'},
+    {"datadir", required_argument, 0, '6'},
+    {"threads", required_argument, 0, '7'},
+    {"segment", required_argument, 0, '8'},
+    {"nosort", no_argument, 0, '9'},
+    {"nopack", no_argument, 0, 'p'},
+    {"noslice", no_argument, 0, 'l'},
+    {"noaggr", no_argument, 0, 'a'},
+    {"sf", required_argument, 0, 's'},
+    {"help", no_argument, 0, 'h'},
+    {0, 0, 0, 0}
+  };
+
+  int opt, long_index;
+  while ((opt = getopt_long(argc, argv, "", long_options, &long_index)) != -1) {
+    switch (opt) {
+      case '0': case '1': case '2': case '3': case '4':
+        inputs.push_back(std::make_pair(opt - '0', optarg));
+        break;
+      case '5':
+        delimiter = optarg[0];
+        break;
+      case '6':
+        datadir = optarg;
+        if (datadir.back() != '/') datadir += "/";
+        break;
+      case '7':
+        num_threads = atoi(optarg);
+        break;
+      case '8':
+        seg_size = atoi(optarg);
+        break;
+      case '9':
+        sort_lineorder = false;
+        break;
+      case 'p':
+        pack_lineorder = false;
+        break;
+      case 'l':
+        slice_lineorder = false;
+        break;
+      case 'a':
+        aggr_lineorder = false;
+        break;
+      case 's':
+        sf = atoi(optarg);
+        break;
+      default:
+        usage(argv[0]);
+        return (opt == 'h') ? 0 : -1;
+    }
+  }
+
+  if (inputs.empty()) {
+    usage(argv[0]);
+    return -1;
+  }
+  if (num_threads <= 0) num_threads = std::max(1u, std::thread::hardware_concurrency());
+
+  //keep what an earlier run recorded, the scale factor defaults to the s<sf>_columnar name
+  readCatalog(datadir, cat);
+  cat.data_dir = datadir;
+  cat.segment_size = seg_size;
+  if (sf != 0) cat.sf = sf;
+  else if (cat.sf == 0) cat.sf = catalogDirSF(datadir);
+
+  //tables are loaded in the order given, which matters when dbgen feeds them through fifos
+  for (int i = 0; i < inputs.size(); i++) loadTable(tables[inputs[i].first], inputs[i].second, datadir);
+
+  return 0;
+}
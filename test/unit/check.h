@@ -0,0 +1,34 @@
+#ifndef _CHECK_H_
+#define _CHECK_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+
+//host only regression tests (make check), each a main() comparing against a scalar reference
+
+static int check_failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+      if (check_failures < 20) { \
+        fprintf(stderr, "%s:%d: %s: ", __FILE__, __LINE__, #cond); \
+        fprintf(stderr, __VA_ARGS__); \
+        fprintf(stderr, "\n"); \
+      } \
+      check_failures++; \
+    } \
+  } while (0)
+
+inline int checkDone(const char* name) {
+  if (check_failures != 0) printf("%s: %d failures\n", name, check_failures);
+  else printf("%s: ok\n", name);
+  return check_failures != 0;
+}
+
+//deterministic values in [lo, hi]
+inline int checkRand(unsigned long long& state, int lo, int hi) {
+  state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+  return (int) (lo + (long long) ((state >> 32) % (unsigned long long) ((long long) hi - lo + 1)));
+}
+
+#endif
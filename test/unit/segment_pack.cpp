@@ -0,0 +1,129 @@
+#include "check.h"
+#include "SegmentPack.h"
+#include "SIMDSelect.h"
+
+#include <unistd.h>
+
+//packed columns written and read back: every code decodes to the raw value, and packPredicate + selectPacked
+//of every supported isa select the same rows as a scalar filter on the raw values, over frame of reference
+//widths up to PACK_MAX_BITS, dictionaries, unaligned windows and the tail segment
+
+static const char* isa_name[] = {"scalar", "avx2", "avx512"};
+
+static bool pass(int mode, int x, int lo, int hi) {
+  if (mode == 2) return (x == lo || x == hi);
+  return (x >= lo && x <= hi);
+}
+
+static void checkWindow(packedColumn* pack, int segment, const int* col, int first, int num, int mode, int lo, int hi) {
+  int seg_offset = segment * pack->seg_size;
+  std::vector<int> expect;
+  for (int i = first; i < first + num; i++)
+    if (pass(mode, col[seg_offset + i], lo, hi)) expect.push_back(seg_offset + i);
+
+  const segmentPack& seg = pack->segment[segment];
+  int code_lo = lo, code_hi = hi;
+  if (!packPredicate(pack, segment, mode, code_lo, code_hi)) {
+    CHECK(expect.empty(), "segment %d mode %d [%d, %d] ruled out with %d rows", segment, mode, lo, hi, (int) expect.size());
+    return;
+  }
+
+  //the vector stores write a full register past the last selected row
+  std::vector<int> sel(num + 16, -1);
+  int count = selectPacked(selectOp(mode, lo, hi), packBlocks(pack, segment), seg.bits, first, num, seg_offset + first, code_lo, code_hi, sel.data());
+  CHECK(count == (int) expect.size(), "%s segment %d bits %d rows %d+%d mode %d [%d, %d]: %d rows, expected %d",
+    isa_name[getSelectISA()], segment, seg.bits, first, num, mode, lo, hi, count, (int) expect.size());
+  for (int i = 0; i < count && i < (int) expect.size(); i++)
+    CHECK(sel[i] == expect[i], "%s segment %d bits %d rows %d+%d: sel[%d] = %d, expected %d",
+      isa_name[getSelectISA()], segment, seg.bits, first, num, i, sel[i], expect[i]);
+}
+
+static void checkSegment(unsigned long long& state, packedColumn* pack, int segment, const int* col, int num, int min, int max) {
+  const segmentPack& seg = pack->segment[segment];
+  const int* seg_col = col + segment * pack->seg_size;
+  for (int i = 0; i < num; i++) {
+    int val = packValue(pack, segment, packCode(packBlocks(pack, segment), seg.bits, i));
+    CHECK(val == seg_col[i], "segment %d bits %d row %d decodes to %d, expected %d", segment, seg.bits, i, val, seg_col[i]);
+  }
+
+  //whole segment, whole blocks, unaligned starts, single lane groups and the last rows
+  int windows[][2] = {{0, num}, {0, num / PACK_BLOCK * PACK_BLOCK}, {3, num - 3}, {PACK_BLOCK, PACK_BLOCK},
+    {5, 8}, {PACK_BLOCK - 4, 20}, {num - 13, 13}, {num, 0}};
+
+  SelectISA supported = getSelectISA();
+  for (int isa = SelectScalar; isa <= supported; isa++) {
+    setSelectISA((SelectISA) isa);
+    for (int p = 0; p < 12; p++) {
+      int mode = (p % 2) ? 2 : 1;
+      int lo, hi;
+      if (p < 2) { lo = min; hi = max; } //all match
+      else if (p < 4) { lo = max + 1; hi = max + 2; } //no match
+      else if (p < 6) { lo = seg_col[checkRand(state, 0, num - 1)]; hi = seg_col[checkRand(state, 0, num - 1)]; }
+      else if (p < 8) { lo = seg_col[0]; hi = max + 1; } //a mode 2 value missing from the segment
+      else { lo = checkRand(state, min - 2, max + 2); hi = checkRand(state, min - 2, max + 2); }
+      if (mode == 1 && lo > hi) std::swap(lo, hi);
+
+      for (int w = 0; w < (int) (sizeof(windows) / sizeof(windows[0])); w++)
+        if (windows[w][0] >= 0 && windows[w][1] >= 0 && windows[w][0] + windows[w][1] <= num)
+          checkWindow(pack, segment, col, windows[w][0], windows[w][1], mode, lo, hi);
+    }
+  }
+  setSelectISA(supported);
+}
+
+int main() {
+  unsigned long long state = 11;
+  char filename[] = "/tmp/segment_packXXXXXX";
+  int fd = mkstemp(filename);
+  if (fd < 0) {
+    perror("mkstemp");
+    return 1;
+  }
+  close(fd);
+
+  int seg_size = 4 * PACK_BLOCK;
+  int len = 3 * seg_size + 301;
+  int total_segment = (len + seg_size - 1) / seg_size;
+
+  //every frame of reference width, a few values spread over a wide range (dictionary) and random 32 bit values
+  for (int bits = 0; bits <= PACK_MAX_BITS + 2; bits++) {
+    std::vector<int> col(len);
+    std::vector<int> values;
+    for (int k = 0; k < 20; k++) values.push_back(checkRand(state, -100000000, 100000000));
+    for (int i = 0; i < len; i++) {
+      if (bits == 0) col[i] = values[checkRand(state, 0, 19)];
+      else if (bits > PACK_MAX_BITS) col[i] = checkRand(state, -1000000000, 1000000000);
+      else col[i] = -50 + checkRand(state, 0, (1 << bits) - 1);
+    }
+
+    size_t packed_bytes, raw_bytes;
+    CHECK(writePackedColumn(filename, col.data(), len, seg_size, &packed_bytes, &raw_bytes), "write %s", filename);
+    CHECK(readPackedColumn(filename, len + 1, seg_size) == NULL, "read %s with another length", filename);
+    packedColumn* pack = readPackedColumn(filename, len, seg_size);
+    CHECK(pack != NULL, "read %s", filename);
+    if (pack == NULL) continue;
+    CHECK(pack->packed_bytes == packed_bytes && pack->raw_bytes == raw_bytes, "bytes %zu %zu, written %zu %zu",
+      pack->packed_bytes, pack->raw_bytes, packed_bytes, raw_bytes);
+
+    for (int s = 0; s < total_segment; s++) {
+      int num = (s == total_segment - 1) ? (len - seg_size * s) : seg_size;
+      const segmentPack& seg = pack->segment[s];
+      int min = col[s * seg_size], max = min;
+      for (int i = 0; i < num; i++) {
+        min = std::min(min, col[s * seg_size + i]);
+        max = std::max(max, col[s * seg_size + i]);
+      }
+
+      if (bits == 0) CHECK(seg.encoding == PackDict, "segment %d of a dictionary column encoded %d", s, seg.encoding);
+      //a short tail of distinct values still pays for a dictionary
+      else if (bits > PACK_MAX_BITS) CHECK(seg.encoding == (num < seg_size ? PackDict : PackNone), "segment %d of a random 32 bit column encoded %d", s, seg.encoding);
+      else CHECK(seg.encoding == PackFOR && seg.bits <= bits, "segment %d of a %d bit column encoded %d with %d bits", s, bits, seg.encoding, seg.bits);
+      if (seg.encoding == PackNone) continue;
+      checkSegment(state, pack, s, col.data(), num, min, max);
+    }
+    freePackedColumn(pack);
+  }
+
+  unlink(filename);
+  return checkDone("segment_pack");
+}
@@ -0,0 +1,111 @@
+#include "check.h"
+#include "SegmentSlice.h"
+#include "SIMDSelect.h"
+
+#include <unistd.h>
+
+//sliced columns written and read back: slicePredicate + sliceBitmap of every supported isa set the bits of
+//the rows a scalar filter on the raw values selects, over every width up to SLICE_MAX_BITS, windows of whole
+//and partial blocks and the tail segment
+
+static const char* isa_name[] = {"scalar", "avx2", "avx512"};
+
+static bool pass(int mode, int x, int lo, int hi) {
+  if (mode == 2) return (x == lo || x == hi);
+  return (x >= lo && x <= hi);
+}
+
+static void checkWindow(slicedColumn* slice, int segment, const int* col, int first, int num, int mode, int lo, int hi) {
+  const int* seg_col = col + segment * slice->seg_size;
+  const segmentSlice& seg = slice->segment[segment];
+  int words = (num + 63) / 64;
+  std::vector<unsigned long long> bitmap(words + SLICE_WORDS, ~0ULL);
+
+  int code_lo = lo, code_hi = hi;
+  if (slicePredicate(slice, segment, mode, code_lo, code_hi))
+    sliceBitmap(selectOp(mode, code_lo, code_hi), sliceBlocks(slice, segment), seg.bits, first, num, code_lo, code_hi, bitmap.data());
+  else
+    std::fill(bitmap.begin(), bitmap.begin() + words, 0ULL);
+
+  for (int i = 0; i < words * 64; i++) {
+    bool expect = (i < num) && pass(mode, seg_col[first + i], lo, hi);
+    bool bit = (bitmap[i / 64] >> (i % 64)) & 1;
+    CHECK(bit == expect, "%s segment %d bits %d rows %d+%d mode %d [%d, %d]: row %d is %d, expected %d",
+      isa_name[getSelectISA()], segment, seg.bits, first, num, mode, lo, hi, first + i, bit, expect);
+  }
+}
+
+static void checkSegment(unsigned long long& state, slicedColumn* slice, int segment, const int* col, int num, int min, int max) {
+  const int* seg_col = col + segment * slice->seg_size;
+  //whole segment, whole blocks, a block started mid way, a single word and the last rows
+  int windows[][2] = {{0, num}, {0, num / SLICE_BLOCK * SLICE_BLOCK}, {64, num - 64}, {SLICE_BLOCK, SLICE_BLOCK},
+    {SLICE_BLOCK + 128, 64}, {0, 37}, {num / 64 * 64, num % 64}, {num, 0}};
+
+  SelectISA supported = getSelectISA();
+  for (int isa = SelectScalar; isa <= supported; isa++) {
+    setSelectISA((SelectISA) isa);
+    for (int p = 0; p < 12; p++) {
+      int mode = (p % 2) ? 2 : 1;
+      int lo, hi;
+      if (p < 2) { lo = min; hi = max; } //all match
+      else if (p < 4) { lo = max + 1; hi = max + 2; } //no match
+      else if (p < 6) { lo = seg_col[checkRand(state, 0, num - 1)]; hi = seg_col[checkRand(state, 0, num - 1)]; }
+      else if (p < 8) { lo = min - 1; hi = seg_col[0]; } //a mode 2 value missing from the segment
+      else { lo = checkRand(state, min - 2, max + 2); hi = checkRand(state, min - 2, max + 2); }
+      if (mode == 1 && lo > hi) std::swap(lo, hi);
+
+      for (int w = 0; w < (int) (sizeof(windows) / sizeof(windows[0])); w++)
+        if (windows[w][0] >= 0 && windows[w][1] >= 0 && windows[w][0] + windows[w][1] <= num)
+          checkWindow(slice, segment, col, windows[w][0], windows[w][1], mode, lo, hi);
+    }
+  }
+  setSelectISA(supported);
+}
+
+int main() {
+  unsigned long long state = 17;
+  char filename[] = "/tmp/segment_sliceXXXXXX";
+  int fd = mkstemp(filename);
+  if (fd < 0) {
+    perror("mkstemp");
+    return 1;
+  }
+  close(fd);
+
+  int seg_size = 4 * SLICE_BLOCK;
+  int len = 3 * seg_size + 301;
+  int total_segment = (len + seg_size - 1) / seg_size;
+
+  //a constant column, every width and one too wide to slice
+  for (int bits = 0; bits <= SLICE_MAX_BITS + 1; bits++) {
+    std::vector<int> col(len);
+    for (int i = 0; i < len; i++) col[i] = 1000 + checkRand(state, 0, (1 << bits) - 1);
+
+    size_t slice_bytes, raw_bytes;
+    CHECK(writeSlicedColumn(filename, col.data(), len, seg_size, &slice_bytes, &raw_bytes), "write %s", filename);
+    CHECK(readSlicedColumn(filename, len, seg_size + 1) == NULL, "read %s with another segment size", filename);
+    slicedColumn* slice = readSlicedColumn(filename, len, seg_size);
+    CHECK(slice != NULL, "read %s", filename);
+    if (slice == NULL) continue;
+    CHECK(slice->slice_bytes == slice_bytes, "slice bytes %zu, written %zu", slice->slice_bytes, slice_bytes);
+
+    for (int s = 0; s < total_segment; s++) {
+      int num = (s == total_segment - 1) ? (len - seg_size * s) : seg_size;
+      const segmentSlice& seg = slice->segment[s];
+      int min = col[s * seg_size], max = min;
+      for (int i = 0; i < num; i++) {
+        min = std::min(min, col[s * seg_size + i]);
+        max = std::max(max, col[s * seg_size + i]);
+      }
+
+      if (bits > SLICE_MAX_BITS) CHECK(seg.bits == 0, "segment %d of a %d bit column sliced", s, bits);
+      else CHECK(seg.bits >= 1 && seg.bits <= std::max(bits, 1) && seg.reference == min, "segment %d of a %d bit column sliced with %d bits from %d", s, bits, seg.bits, seg.reference);
+      if (seg.bits == 0) continue;
+      checkSegment(state, slice, s, col.data(), num, min, max);
+    }
+    freeSlicedColumn(slice);
+  }
+
+  unlink(filename);
+  return checkDone("segment_slice");
+}
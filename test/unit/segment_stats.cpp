@@ -0,0 +1,112 @@
+#include "check.h"
+#include "SegmentStats.h"
+
+#include <unistd.h>
+
+//segment statistics of random columns against a scalar scan of the segment: min, max, histogram and bitmap,
+//segmentMayMatch never skipping a segment with a qualifying row and the stats file round trip
+
+static bool pass(int mode, int x, int lo, int hi) {
+  if (mode == 2) return (x == lo || x == hi);
+  return (x >= lo && x <= hi);
+}
+
+static void checkSegment(const int* col, int num, const segmentStats& stats) {
+  int min = col[0], max = col[0];
+  for (int i = 0; i < num; i++) {
+    if (col[i] < min) min = col[i];
+    if (col[i] > max) max = col[i];
+  }
+  CHECK(stats.min == min && stats.max == max && stats.count == num, "min %d max %d count %d, expected %d %d %d", stats.min, stats.max, stats.count, min, max, num);
+
+  std::vector<unsigned int> hist(STATS_HIST_BINS, 0);
+  unsigned long long bitmap = 0;
+  for (int i = 0; i < num; i++) {
+    hist[statsBin(col[i], min, max)]++;
+    if ((long long) max - min < STATS_BITMAP_RANGE) bitmap |= 1ULL << (col[i] - min);
+  }
+  for (int b = 0; b < STATS_HIST_BINS; b++)
+    CHECK(stats.hist[b] == hist[b], "hist[%d] = %u, expected %u", b, stats.hist[b], hist[b]);
+  if ((long long) max - min < STATS_BITMAP_RANGE) {
+    CHECK(stats.flags & STATS_HAS_BITMAP, "no bitmap for range %d", max - min);
+    CHECK(stats.bitmap == bitmap, "bitmap %llx, expected %llx", stats.bitmap, bitmap);
+    CHECK(stats.distinct == __builtin_popcountll(bitmap), "distinct %d, expected %d", stats.distinct, __builtin_popcountll(bitmap));
+  }
+
+  //every bin range holds exactly the values statsBin maps to it
+  for (int b = 0; b < statsBins(min, max); b++) {
+    int lo, hi;
+    statsBinRange(b, min, max, lo, hi);
+    CHECK(statsBin(lo, min, max) == b && statsBin(hi, min, max) == b, "bin %d range %d %d of %d %d", b, lo, hi, min, max);
+    if (b + 1 < statsBins(min, max)) CHECK(statsBin(hi + 1, min, max) == b + 1, "bin %d ends at %d of %d %d", b, hi, min, max);
+  }
+}
+
+//predicates around min and max, inside, all match and no match
+static void checkPredicates(unsigned long long& state, const int* col, int num, const segmentStats& stats) {
+  int lo_val = stats.min - 3, hi_val = stats.max + 3;
+  for (int p = 0; p < 200; p++) {
+    int mode = (p % 2) ? 2 : 1;
+    int lo = checkRand(state, lo_val, hi_val), hi = checkRand(state, lo_val, hi_val);
+    if (mode == 1 && lo > hi) std::swap(lo, hi);
+    if (p == 0) { lo = stats.min; hi = stats.max; }
+    if (p == 1) { lo = stats.max + 1; hi = stats.max + 1; }
+    if (p == 2) { lo = stats.min - 10; hi = stats.min - 1; }
+
+    int match = 0;
+    for (int i = 0; i < num; i++) match += pass(mode, col[i], lo, hi);
+    bool may = segmentMayMatch(stats, mode, lo, hi);
+    CHECK(may || match == 0, "mode %d [%d, %d] skipped a segment with %d rows", mode, lo, hi, match);
+    //with a bitmap the skip is exact
+    if (stats.flags & STATS_HAS_BITMAP) CHECK(may == (match != 0), "mode %d [%d, %d] may match %d with %d rows", mode, lo, hi, may, match);
+
+    double sel = segmentSelectivity(stats, mode, lo, hi);
+    CHECK(sel >= 0 && sel <= 1, "selectivity %f", sel);
+    if (match == 0 && !may) CHECK(sel == 0, "selectivity %f of a skipped segment", sel);
+    //a histogram bin per value and a range predicate is exact
+    if (mode == 1 && (long long) stats.max - stats.min < STATS_HIST_BINS)
+      CHECK(fabs(sel - (double) match / num) < 1e-9, "range [%d, %d] selectivity %f, expected %f", lo, hi, sel, (double) match / num);
+  }
+}
+
+int main() {
+  unsigned long long state = 5;
+  char filename[] = "/tmp/segment_statsXXXXXX";
+  int fd = mkstemp(filename);
+  if (fd < 0) {
+    perror("mkstemp");
+    return 1;
+  }
+  close(fd);
+
+  //narrow domain (bitmap, one bin per value), a bitmap wider than the bins, a wide domain and a constant
+  //column, every one with a tail segment
+  int domain[][2] = {{1, 10}, {100, 150}, {-1000000, 1000000}, {7, 7}};
+  int seg_size = 1000;
+  int len = 3 * seg_size + 37;
+
+  for (int d = 0; d < 4; d++) {
+    std::vector<int> col(len);
+    for (int i = 0; i < len; i++) col[i] = checkRand(state, domain[d][0], domain[d][1]);
+
+    CHECK(writeSegmentStats(filename, col.data(), len, seg_size), "write %s", filename);
+    int total_segment = (len + seg_size - 1) / seg_size;
+    std::vector<segmentStats> stats(total_segment);
+    CHECK(readSegmentStats(filename, stats.data(), len, seg_size), "read %s", filename);
+    CHECK(!readSegmentStats(filename, stats.data(), len + 1, seg_size), "read %s with another length", filename);
+    CHECK(readSegmentStats(filename, stats.data(), len, seg_size), "read %s", filename);
+
+    for (int s = 0; s < total_segment; s++) {
+      int num = (s == total_segment - 1) ? (len - seg_size * s) : seg_size;
+      const int* seg_col = col.data() + s * seg_size;
+      segmentStats direct;
+      computeSegmentStats(seg_col, num, &direct);
+      CHECK(memcmp(&direct, &stats[s], sizeof(segmentStats)) == 0, "domain %d segment %d differs after the round trip", d, s);
+      checkSegment(seg_col, num, stats[s]);
+      checkPredicates(state, seg_col, num, stats[s]);
+    }
+  }
+
+  unlink(filename);
+  return checkDone("segment_stats");
+}
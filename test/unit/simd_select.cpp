@@ -0,0 +1,108 @@
+#include "check.h"
+#include "SIMDSelect.h"
+
+#include <vector>
+
+//selectDense, selectSparse and selectBitmap of every supported isa against a scalar loop
+
+static const char* isa_name[] = {"scalar", "avx2", "avx512"};
+
+static bool pass(SelectOp op, int x, int lo, int hi) {
+  if (op == SelectRange) return (x >= lo && x <= hi);
+  else if (op == SelectEQ) return (x == lo);
+  else return (x == lo || x == hi);
+}
+
+static void checkDense(SelectISA isa, SelectOp op, std::vector<int>& col, int offset, int num, int lo, int hi) {
+  std::vector<int> expect;
+  for (int i = offset; i < offset + num; i++)
+    if (pass(op, col[i], lo, hi)) expect.push_back(i);
+
+  //the vector stores write a full register past the last selected row
+  std::vector<int> sel(num + 16, -1);
+  int count = selectDense(op, col.data(), offset, num, lo, hi, sel.data());
+  CHECK(count == (int) expect.size(), "%s dense op %d offset %d num %d: %d rows, expected %d", isa_name[isa], op, offset, num, count, (int) expect.size());
+  for (int i = 0; i < count && i < (int) expect.size(); i++)
+    CHECK(sel[i] == expect[i], "%s dense op %d num %d: sel[%d] = %d, expected %d", isa_name[isa], op, num, i, sel[i], expect[i]);
+}
+
+static void checkSparse(SelectISA isa, SelectOp op, std::vector<int>& col, std::vector<int>& sel_in, int lo, int hi, bool in_place) {
+  int num = sel_in.size();
+  std::vector<int> expect;
+  for (int i = 0; i < num; i++)
+    if (pass(op, col[sel_in[i]], lo, hi)) expect.push_back(sel_in[i]);
+
+  std::vector<int> in(sel_in);
+  in.resize(num + 16, -1);
+  std::vector<int> out(num + 16, -1);
+  int* sel_out = in_place ? in.data() : out.data();
+  int count = selectSparse(op, col.data(), in.data(), num, lo, hi, sel_out);
+  CHECK(count == (int) expect.size(), "%s sparse op %d num %d: %d rows, expected %d", isa_name[isa], op, num, count, (int) expect.size());
+  for (int i = 0; i < count && i < (int) expect.size(); i++)
+    CHECK(sel_out[i] == expect[i], "%s sparse op %d num %d: sel[%d] = %d, expected %d", isa_name[isa], op, num, i, sel_out[i], expect[i]);
+}
+
+static void checkBitmap(unsigned long long& state, int num, int offset) {
+  std::vector<unsigned long long> bitmap((num + 63) / 64 + 1, 0);
+  std::vector<int> expect;
+  for (int i = 0; i < num; i++) {
+    if (checkRand(state, 0, 2) == 0) {
+      bitmap[i / 64] |= 1ULL << (i % 64);
+      expect.push_back(offset + i);
+    }
+  }
+
+  std::vector<int> sel(num + 1, -1);
+  int count = selectBitmap(bitmap.data(), num, offset, sel.data());
+  CHECK(count == (int) expect.size(), "bitmap num %d: %d rows, expected %d", num, count, (int) expect.size());
+  for (int i = 0; i < count && i < (int) expect.size(); i++)
+    CHECK(sel[i] == expect[i], "bitmap num %d: sel[%d] = %d, expected %d", num, i, sel[i], expect[i]);
+}
+
+int main() {
+  unsigned long long state = 1;
+  //around the 8 and 16 lane groups and a segment tail
+  int nums[] = {0, 1, 7, 8, 9, 15, 16, 17, 31, 33, 255, 1000, 4099};
+  int len = 4099 + 64;
+
+  std::vector<int> col(len);
+  for (int i = 0; i < len; i++) col[i] = checkRand(state, 0, 49);
+
+  SelectISA supported = getSelectISA();
+  for (int isa = SelectScalar; isa <= supported; isa++) {
+    setSelectISA((SelectISA) isa);
+
+    for (int n = 0; n < (int) (sizeof(nums) / sizeof(int)); n++) {
+      int num = nums[n];
+      for (int offset = 0; offset < 3; offset++) {
+        checkDense((SelectISA) isa, SelectRange, col, offset, num, 10, 30);
+        checkDense((SelectISA) isa, SelectEQ, col, offset, num, 7, 7);
+        checkDense((SelectISA) isa, SelectIN2, col, offset, num, 3, 41);
+        //all match and no match
+        checkDense((SelectISA) isa, SelectRange, col, offset, num, 0, 49);
+        checkDense((SelectISA) isa, SelectRange, col, offset, num, 50, 100);
+        checkDense((SelectISA) isa, SelectEQ, col, offset, num, -1, -1);
+        checkDense((SelectISA) isa, SelectIN2, col, offset, num, 60, 70);
+      }
+
+      std::vector<int> sel_in;
+      for (int i = 0; i < len && (int) sel_in.size() < num; i++)
+        if (checkRand(state, 0, 1) == 0) sel_in.push_back(i);
+      for (int in_place = 0; in_place < 2; in_place++) {
+        checkSparse((SelectISA) isa, SelectRange, col, sel_in, 10, 30, in_place);
+        checkSparse((SelectISA) isa, SelectEQ, col, sel_in, 7, 7, in_place);
+        checkSparse((SelectISA) isa, SelectIN2, col, sel_in, 3, 41, in_place);
+        checkSparse((SelectISA) isa, SelectRange, col, sel_in, 0, 49, in_place);
+        checkSparse((SelectISA) isa, SelectRange, col, sel_in, -5, -1, in_place);
+      }
+    }
+  }
+  setSelectISA(supported);
+
+  for (int n = 0; n < (int) (sizeof(nums) / sizeof(int)); n++) {
+    checkBitmap(state, nums[n], 0);
+    checkBitmap(state, nums[n], 1024);
+  }
+
+  return checkDone("simd_select");
+}
@@ -22,6 +22,15 @@ def gen_data(dataset, scale_factor):
         os.system('mv *.tbl ../data/s%d/' % scale_factor)
 
 def transform(dataset, scale_factor):
+    path = './' + dataset + '/loader/'
+    ip = '../data/s%d/' % scale_factor
+    op = '../data/s%d_columnar/' % scale_factor
+    with cd(path):
+        os.system('mkdir -p %s' % op)
+        # ploader applies the convert.py encodings itself and also writes LINEORDERSORT and the segment stats
+        os.system('./ploader --lineorder %s/lineorder.tbl --ddate %s/date.tbl --customer %s/customer.tbl --supplier %s/supplier.tbl --part %s/part.tbl --datadir %s --sf %d' % (ip, ip, ip, ip, ip, op, scale_factor))
+
+def transform_legacy(dataset, scale_factor):
     path = './' + dataset + '/loader/'
     ip = '../data/s%d/' % scale_factor
     op = '../data/s%d_columnar/' % scale_factor
@@ -30,15 +39,34 @@ def transform(dataset, scale_factor):
         os.system('python3 convert.py ../data/s%d/' % scale_factor)
         os.system('./loader --lineorder %s/lineorder.tbl --ddate %s/date.tbl --customer %s/customer.tbl.p --supplier %s/supplier.tbl.p --part %s/part.tbl.p --datadir %s' % (ip, ip, ip, ip, ip, op))
 
+def stream(dataset, scale_factor):
+    # dbgen writes each table into a fifo read by ploader, no .tbl files are kept.
+    # every table comes from its own dbgen -T run, which seeds differently from -T a
+    dbgen = os.path.abspath('./' + dataset + '/dbgen/')
+    fifo = os.path.abspath('./' + dataset + '/data/s%d_fifo/' % scale_factor)
+    op = os.path.abspath('./' + dataset + '/data/s%d_columnar/' % scale_factor)
+    os.system('mkdir -p %s %s' % (fifo, op))
+    tables = [('d', 'date', 'ddate'), ('c', 'customer', 'customer'), ('s', 'supplier', 'supplier'), ('p', 'part', 'part'), ('l', 'lineorder', 'lineorder')]
+    with cd(dbgen):
+        for flag, name, option in tables:
+            os.system('rm -f %s/%s.tbl && mkfifo %s/%s.tbl' % (fifo, name, fifo, name))
+            os.system('DSS_PATH=%s ./dbgen -s %d -T %s -f > /dev/null &' % (fifo, scale_factor, flag))
+            os.system('../loader/ploader --%s %s/%s.tbl --datadir %s --sf %d' % (option, fifo, name, op, scale_factor))
+    os.system('rm -rf %s' % fifo)
+
 if __name__ == "__main__":
     parser = argparse.ArgumentParser(description = 'data gen')
     parser.add_argument('dataset', type=str, choices=['ssb'])
     parser.add_argument('scale_factor', type=int)
-    parser.add_argument('action', type=str, choices=['gen', 'transform'])
+    parser.add_argument('action', type=str, choices=['gen', 'transform', 'transform_legacy', 'stream'])
     args = parser.parse_args()
 
     if args.action == 'gen':
         gen_data(args.dataset, args.scale_factor)
     elif args.action == 'transform':
         transform(args.dataset, args.scale_factor)
+    elif args.action == 'transform_legacy':
+        transform_legacy(args.dataset, args.scale_factor)
+    elif args.action == 'stream':
+        stream(args.dataset, args.scale_factor)
 